@@ -29,11 +29,47 @@ private:
 #define CONF_DERECHO_RDMC_PORT "DERECHO/rdmc_port"
 #define CONF_DERECHO_HEARTBEAT_MS "DERECHO/heartbeat_ms"
 #define CONF_DERECHO_SST_POLL_CQ_TIMEOUT_MS "DERECHO/sst_poll_cq_timeout_ms"
+#define CONF_DERECHO_SST_IDLE_BACKOFF "DERECHO/sst_idle_backoff"
+#define CONF_DERECHO_SST_IDLE_SPIN_ROUNDS "DERECHO/sst_idle_spin_rounds"
 #define CONF_DERECHO_DISABLE_PARTITIONING_SAFETY "DERECHO/disable_partitioning_safety"
 
 #define CONF_DERECHO_MAX_P2P_REQUEST_PAYLOAD_SIZE "DERECHO/max_p2p_request_payload_size"
 #define CONF_DERECHO_MAX_P2P_REPLY_PAYLOAD_SIZE "DERECHO/max_p2p_reply_payload_size"
 #define CONF_DERECHO_P2P_WINDOW_SIZE "DERECHO/p2p_window_size"
+#define CONF_DERECHO_P2P_SMALL_REQUEST_PAYLOAD_SIZE "DERECHO/p2p_small_request_payload_size"
+#define CONF_DERECHO_P2P_LARGE_WINDOW_SIZE "DERECHO/p2p_large_window_size"
+#define CONF_DERECHO_P2P_SPIN_WAIT_US "DERECHO/p2p_spin_wait_us"
+#define CONF_DERECHO_PIGGYBACK_REPLY_PAYLOAD_SIZE "DERECHO/piggyback_reply_payload_size"
+#define CONF_DERECHO_PIGGYBACK_REPLY_WINDOW_SIZE "DERECHO/piggyback_reply_window_size"
+#define CONF_DERECHO_QUERY_SNAPSHOT_SIZE "DERECHO/query_snapshot_size"
+#define CONF_DERECHO_STATE_TRANSFER_STRIPES "DERECHO/state_transfer_stripes"
+#define CONF_DERECHO_STATE_TRANSFER_PORT "DERECHO/state_transfer_port"
+#define CONF_DERECHO_STATE_TRANSFER_RDMA "DERECHO/state_transfer_rdma"
+#define CONF_DERECHO_STATE_TRANSFER_LOG_SUFFIX "DERECHO/state_transfer_log_suffix"
+#define CONF_DERECHO_LAZY_OBJECT_INIT "DERECHO/lazy_object_init"
+#define CONF_DERECHO_DELTA_VIEWS "DERECHO/delta_views"
+#define CONF_DERECHO_VIEW_DELTA_BUFFER_SIZE "DERECHO/view_delta_buffer_size"
+#define CONF_DERECHO_CONNECT_CONCURRENCY "DERECHO/connect_concurrency"
+#define CONF_DERECHO_USE_HUGEPAGES "DERECHO/use_hugepages"
+#define CONF_DERECHO_WARMUP_ON_STARTUP "DERECHO/warmup_on_startup"
+#define CONF_DERECHO_SST_NUMA_NODE "DERECHO/sst_numa_node"
+#define CONF_DERECHO_SST_DIRTY_TRACKING "DERECHO/sst_dirty_tracking"
+#define CONF_DERECHO_SST_PUSH_THREADS "DERECHO/sst_push_threads"
+#define CONF_DERECHO_PREDICATE_THREAD_CPU "DERECHO/predicate_thread_cpu"
+#define CONF_DERECHO_PREDICATE_SHARDS "DERECHO/predicate_shards"
+#define CONF_DERECHO_TRIGGER_OFFLOAD_THREADS "DERECHO/trigger_offload_threads"
+#define CONF_DERECHO_BACKGROUND_PREDICATE_INTERVAL "DERECHO/background_predicate_interval"
+#define CONF_DERECHO_SST_POLL_THREAD_CPU "DERECHO/sst_poll_thread_cpu"
+#define CONF_DERECHO_POLL_ENGINE_CPU "DERECHO/poll_engine_cpu"
+#define CONF_DERECHO_SENDER_THREAD_CPU "DERECHO/sender_thread_cpu"
+#define CONF_DERECHO_RPC_WORKER_THREADS "DERECHO/rpc_worker_threads"
+#define CONF_DERECHO_JOIN_HANDLER_THREADS "DERECHO/join_handler_threads"
+#define CONF_DERECHO_MAX_EXTERNAL_CONNECTIONS "DERECHO/max_external_connections"
+#define CONF_DERECHO_EXTERNAL_IDLE_TIMEOUT_MS "DERECHO/external_idle_timeout_ms"
+#define CONF_DERECHO_EXTERNAL_PORT "DERECHO/external_port"
+#define CONF_DERECHO_LEAVE_DRAIN_TIMEOUT_MS "DERECHO/leave_drain_timeout_ms"
+#define CONF_DERECHO_LAZY_MEMBER_P2P "DERECHO/lazy_member_p2p"
+#define CONF_DERECHO_PHASE_LOG_INTERVAL_MS "DERECHO/phase_log_interval_ms"
 
 #define CONF_SUBGROUP_DEFAULT_MAX_PAYLOAD_SIZE "SUBGROUP/DEFAULT/max_payload_size"
 #define CONF_SUBGROUP_DEFAULT_MAX_REPLY_PAYLOAD_SIZE "SUBGROUP/DEFAULT/max_reply_payload_size"
@@ -41,16 +77,37 @@ private:
 #define CONF_SUBGROUP_DEFAULT_BLOCK_SIZE "SUBGROUP/DEFAULT/block_size"
 #define CONF_SUBGROUP_DEFAULT_WINDOW_SIZE "SUBGROUP/DEFAULT/window_size"
 #define CONF_SUBGROUP_DEFAULT_RDMC_SEND_ALGORITHM "SUBGROUP/DEFAULT/rdmc_send_algorithm"
+#define CONF_SUBGROUP_DEFAULT_SMC_BATCH_SIZE "SUBGROUP/DEFAULT/smc_batch_size"
+#define CONF_SUBGROUP_DEFAULT_SMC_BATCH_TIMEOUT_US "SUBGROUP/DEFAULT/smc_batch_timeout_us"
+#define CONF_SUBGROUP_DEFAULT_NULL_SEND_SUPPRESSION "SUBGROUP/DEFAULT/null_send_suppression"
+#define CONF_SUBGROUP_DEFAULT_SENDER_PRIORITY "SUBGROUP/DEFAULT/sender_priority"
 
 #define CONF_RDMA_PROVIDER "RDMA/provider"
 #define CONF_RDMA_DOMAIN "RDMA/domain"
+#define CONF_RDMA_SECOND_DOMAIN "RDMA/second_domain"
 #define CONF_RDMA_TX_DEPTH "RDMA/tx_depth"
 #define CONF_RDMA_RX_DEPTH "RDMA/rx_depth"
+#define CONF_RDMA_MR_CACHE_SIZE "RDMA/mr_cache_size"
+#define CONF_RDMA_RDMC_SEND_QUEUE_DEPTH "RDMA/rdmc_send_queue_depth"
+#define CONF_RDMA_ENABLE_HMEM "RDMA/enable_hmem"
+#define CONF_RDMA_PINNED_MEMORY_BUDGET_MB "RDMA/pinned_memory_budget_mb"
+#define CONF_RDMA_UD_MCAST_ADDR "RDMA/ud_mcast_addr"
+#define CONF_RDMA_UD_MCAST_PORT "RDMA/ud_mcast_port"
 #define CONF_PERS_FILE_PATH "PERS/file_path"
 #define CONF_PERS_RAMDISK_PATH "PERS/ramdisk_path"
 #define CONF_PERS_RESET "PERS/reset"
 #define CONF_PERS_MAX_LOG_ENTRY "PERS/max_log_entry"
 #define CONF_PERS_MAX_DATA_SIZE "PERS/max_data_size"
+#define CONF_PERS_PARALLEL_PERSISTENCE "PERS/parallel_persistence"
+#define CONF_PERS_USE_IO_URING "PERS/use_io_uring"
+#define CONF_PERS_PMEM_PATH "PERS/pmem_path"
+#define CONF_PERS_VERIFY_ON_LOAD "PERS/verify_on_load"
+#define CONF_PERS_SNAPSHOT_INTERVAL "PERS/snapshot_interval"
+#define CONF_PERS_COMPRESSION "PERS/compression"
+#define CONF_PERS_COMPACTION_INTERVAL_MS "PERS/compaction_interval_ms"
+#define CONF_PERS_COMPACTION_THROTTLE_MS "PERS/compaction_throttle_ms"
+#define CONF_PERS_CHECKPOINT_INTERVAL_MS "PERS/checkpoint_interval_ms"
+#define CONF_PERS_SHARED_LOG "PERS/shared_log"
 #define CONF_LOGGER_DEFAULT_LOG_NAME "LOGGER/default_log_name"
 #define CONF_LOGGER_DEFAULT_LOG_LEVEL "LOGGER/default_log_level"
 
@@ -66,28 +123,85 @@ private:
             {CONF_DERECHO_RDMC_PORT, "31675"},
             {CONF_SUBGROUP_DEFAULT_RDMC_SEND_ALGORITHM, "binomial_send"},
             {CONF_DERECHO_SST_POLL_CQ_TIMEOUT_MS, "2000"},
+            {CONF_DERECHO_SST_IDLE_BACKOFF, "false"},
+            {CONF_DERECHO_SST_IDLE_SPIN_ROUNDS, "1000"},
             {CONF_DERECHO_DISABLE_PARTITIONING_SAFETY, "true"},
 	    {CONF_DERECHO_MAX_P2P_REQUEST_PAYLOAD_SIZE, "10240"},
 	    {CONF_DERECHO_MAX_P2P_REPLY_PAYLOAD_SIZE, "10240"},
 	    {CONF_DERECHO_P2P_WINDOW_SIZE, "16"},
+	    {CONF_DERECHO_P2P_SMALL_REQUEST_PAYLOAD_SIZE, "0"},
+	    {CONF_DERECHO_P2P_LARGE_WINDOW_SIZE, "2"},
+	    {CONF_DERECHO_P2P_SPIN_WAIT_US, "0"},  // 0 parks reply waiters on a futex immediately.
+	    {CONF_DERECHO_PIGGYBACK_REPLY_PAYLOAD_SIZE, "0"},
+	    {CONF_DERECHO_PIGGYBACK_REPLY_WINDOW_SIZE, "8"},
+	    {CONF_DERECHO_QUERY_SNAPSHOT_SIZE, "0"},
+	    {CONF_DERECHO_STATE_TRANSFER_STRIPES, "1"},
+	    {CONF_DERECHO_STATE_TRANSFER_PORT, "28367"},
+	    {CONF_DERECHO_STATE_TRANSFER_RDMA, "false"},
+	    {CONF_DERECHO_STATE_TRANSFER_LOG_SUFFIX, "false"},
+	    {CONF_DERECHO_LAZY_OBJECT_INIT, "false"},
+	    {CONF_DERECHO_DELTA_VIEWS, "false"},
+	    {CONF_DERECHO_VIEW_DELTA_BUFFER_SIZE, "16384"},
+	    {CONF_DERECHO_CONNECT_CONCURRENCY, "8"},
+	    {CONF_DERECHO_USE_HUGEPAGES, "false"},
+	    {CONF_DERECHO_WARMUP_ON_STARTUP, "false"},
+	    {CONF_DERECHO_SST_NUMA_NODE, "-1"},
+	    {CONF_DERECHO_SST_DIRTY_TRACKING, "false"},
+	    {CONF_DERECHO_SST_PUSH_THREADS, "0"},
+	    {CONF_DERECHO_PREDICATE_THREAD_CPU, "-1"},
+	    {CONF_DERECHO_PREDICATE_SHARDS, "1"},
+	    {CONF_DERECHO_TRIGGER_OFFLOAD_THREADS, "2"},
+	    {CONF_DERECHO_BACKGROUND_PREDICATE_INTERVAL, "16"},
+	    {CONF_DERECHO_SST_POLL_THREAD_CPU, "-1"},
+	    {CONF_DERECHO_POLL_ENGINE_CPU, "-1"},
+	    {CONF_DERECHO_SENDER_THREAD_CPU, "-1"},
+	    {CONF_DERECHO_RPC_WORKER_THREADS, "1"},
+	    {CONF_DERECHO_JOIN_HANDLER_THREADS, "4"},
+	    {CONF_DERECHO_MAX_EXTERNAL_CONNECTIONS, "64"}, // LRU cap on on-demand p2p connections; 0 removes the cap.
+	    {CONF_DERECHO_EXTERNAL_IDLE_TIMEOUT_MS, "30000"}, // idle teardown for on-demand p2p connections; 0 disables.
+	    {CONF_DERECHO_EXTERNAL_PORT, "0"}, // TCP port for external-client handshakes; 0 disables the listener.
+	    {CONF_DERECHO_LEAVE_DRAIN_TIMEOUT_MS, "5000"}, // bound on each phase of a graceful leave; 0 skips the drain.
+	    {CONF_DERECHO_LAZY_MEMBER_P2P, "false"}, // member p2p connections on first use instead of at view install.
+	    {CONF_DERECHO_PHASE_LOG_INTERVAL_MS, "0"}, // core-thread occupancy log period; 0 disables the log.
             // [SUBGROUP/<subgroupname>]
             {CONF_SUBGROUP_DEFAULT_MAX_PAYLOAD_SIZE, "10240"},
             {CONF_SUBGROUP_DEFAULT_MAX_REPLY_PAYLOAD_SIZE, "10240"},
             {CONF_SUBGROUP_DEFAULT_MAX_SMC_PAYLOAD_SIZE, "10240"},
             {CONF_SUBGROUP_DEFAULT_BLOCK_SIZE, "1048576"},
             {CONF_SUBGROUP_DEFAULT_WINDOW_SIZE, "16"},
+            {CONF_SUBGROUP_DEFAULT_SMC_BATCH_SIZE, "1"},
+            {CONF_SUBGROUP_DEFAULT_SMC_BATCH_TIMEOUT_US, "0"},
+            {CONF_SUBGROUP_DEFAULT_NULL_SEND_SUPPRESSION, "false"},
+            {CONF_SUBGROUP_DEFAULT_SENDER_PRIORITY, "1"},
             {CONF_DERECHO_HEARTBEAT_MS, "1"},
             // [RDMA]
             {CONF_RDMA_PROVIDER, "sockets"},
             {CONF_RDMA_DOMAIN, "eth0"},
+            {CONF_RDMA_SECOND_DOMAIN, ""},
             {CONF_RDMA_TX_DEPTH, "256"},
             {CONF_RDMA_RX_DEPTH, "256"},
+            {CONF_RDMA_MR_CACHE_SIZE, "0"},
+            {CONF_RDMA_RDMC_SEND_QUEUE_DEPTH, "0"},
+            {CONF_RDMA_ENABLE_HMEM, "false"}, // request FI_HMEM so device (GPU) buffers can be registered.
+            {CONF_RDMA_PINNED_MEMORY_BUDGET_MB, "0"}, // 0 disables pinned-memory budget enforcement.
+            {CONF_RDMA_UD_MCAST_ADDR, ""},
+            {CONF_RDMA_UD_MCAST_PORT, "45000"},
             // [PERS]
             {CONF_PERS_FILE_PATH, ".plog"},
             {CONF_PERS_RAMDISK_PATH, "/dev/shm/volatile_t"},
             {CONF_PERS_RESET, "false"},
             {CONF_PERS_MAX_LOG_ENTRY, "1048576"}, // 1M log entries.
             {CONF_PERS_MAX_DATA_SIZE, "549755813888"}, // 512G total data size.
+            {CONF_PERS_PARALLEL_PERSISTENCE, "false"},
+            {CONF_PERS_USE_IO_URING, "false"},
+            {CONF_PERS_PMEM_PATH, ""}, // empty disables the DAX/persistent-memory backend.
+            {CONF_PERS_VERIFY_ON_LOAD, "false"},
+            {CONF_PERS_SNAPSHOT_INTERVAL, "0"},
+            {CONF_PERS_COMPRESSION, "false"},
+            {CONF_PERS_COMPACTION_INTERVAL_MS, "0"}, // 0 disables background log compaction.
+            {CONF_PERS_COMPACTION_THROTTLE_MS, "100"},
+            {CONF_PERS_CHECKPOINT_INTERVAL_MS, "0"}, // 0 disables periodic object checkpoint files.
+            {CONF_PERS_SHARED_LOG, "false"}, // all fields of a replicated object share one sectioned log.
             // [LOGGER]
             {CONF_LOGGER_DEFAULT_LOG_NAME, "derecho_debug"},
             {CONF_LOGGER_DEFAULT_LOG_LEVEL, "info"}};
@@ -191,6 +305,41 @@ private:
     static std::atomic<uint32_t> singleton_initialized_flag;
 };
 
+/**
+ * A typed snapshot of the configuration entries consulted on runtime paths
+ * (polling loops, window checks, timer threads), materialized once from the
+ * Conf singleton. Reading a field is a struct member access instead of a
+ * string hash through the configuration map, and a misspelled entry is a
+ * compile error on the field name rather than a runtime map miss. Entries
+ * that are only read during setup (addresses, ports, file paths) stay on
+ * the string-keyed accessors.
+ */
+struct ConfSnapshot {
+    // [DERECHO] - failure detection and SST polling
+    uint32_t heartbeat_ms;
+    uint32_t sst_poll_cq_timeout_ms;
+    bool sst_idle_backoff;
+    uint32_t sst_idle_spin_rounds;
+    uint32_t background_predicate_interval;
+    bool disable_partitioning_safety;
+    // [DERECHO] - P2P/RPC window and payload geometry
+    uint64_t max_p2p_request_payload_size;
+    uint64_t max_p2p_reply_payload_size;
+    uint32_t p2p_window_size;
+    uint64_t p2p_small_request_payload_size;
+    uint32_t p2p_large_window_size;
+    uint32_t p2p_spin_wait_us;
+    uint64_t piggyback_reply_payload_size;
+    uint32_t piggyback_reply_window_size;
+};
+
+/**
+ * Returns the process-wide ConfSnapshot, building it from the Conf
+ * singleton on the first call. Like Conf::get(), calling this before
+ * Conf::initialize() freezes the default configuration.
+ */
+const ConfSnapshot& getConfSnapshot();
+
 // helpers
 const std::string& getConfString(const std::string& key);
 const int16_t getConfInt16(const std::string& key);
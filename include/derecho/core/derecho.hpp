@@ -5,6 +5,7 @@
 #include "derecho_type_definitions.hpp"
 #include "group.hpp"
 #include "register_rpc_functions.hpp"
+#include "static_subgroup_layout.hpp"
 #include "subgroup_functions.hpp"
 #include "subgroup_info.hpp"
 #include <derecho/mutils-serialization/SerializationSupport.hpp>
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <cassert>
+#include <functional>
 #include <map>
 #include <mutex>
 
@@ -15,8 +16,20 @@ class tcp_connections {
     node_id_t my_id;
     std::unique_ptr<connection_listener> conn_listener;
     std::map<node_id_t, socket> sockets;
+    /** Invoked with a node's ID when a read or write on its socket fails,
+     * which usually means the connection was reset because the node crashed. */
+    std::function<void(node_id_t)> failure_callback;
     bool add_connection(const node_id_t other_id,
                         const std::pair<ip_addr_t, uint16_t>& other_ip_and_port);
+    /**
+     * Opens a connection to a (lower-ID) node and exchanges node IDs with it,
+     * without touching the sockets map, so multiple connections can be opened
+     * concurrently during view setup.
+     * @return The connected socket, or an empty socket if the connection or
+     * ID exchange failed.
+     */
+    socket connect_to_node(const node_id_t other_id,
+                           const std::pair<ip_addr_t, uint16_t>& other_ip_and_port);
     void establish_node_connections(
             const std::map<node_id_t, std::pair<ip_addr_t, uint16_t>>& ip_addrs_and_ports);
 
@@ -89,13 +102,28 @@ public:
      * false if it does not.
      */
     bool contains_node(node_id_t node_id);
+    /**
+     * Registers a callback that will be invoked, with the node's ID, whenever
+     * a read, write, or exchange on an established connection fails. A failed
+     * operation on an established connection is hard evidence that the remote
+     * node crashed, so this gives the membership service an immediate failure
+     * signal instead of a heartbeat timeout. The callback runs on the thread
+     * that observed the failure, while sockets_mutex is held, so it must not
+     * block or call back into this connection manager.
+     * @param callback The function to call when a connection fails
+     */
+    void set_failure_callback(const std::function<void(node_id_t)>& callback);
 
     template <class T>
     bool exchange(node_id_t node_id, T local, T& remote) {
         std::lock_guard<std::mutex> lock(sockets_mutex);
         const auto it = sockets.find(node_id);
         assert(it != sockets.end());
-        return it->second.exchange(local, remote);
+        const bool success = it->second.exchange(local, remote);
+        if(!success && failure_callback) {
+            failure_callback(node_id);
+        }
+        return success;
     }
     /**
      * Checks all of the TCP connections managed by this object for new
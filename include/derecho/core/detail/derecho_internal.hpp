@@ -12,7 +12,9 @@
 #include <optional>
 #include <string>
 #include <sys/types.h>
+#include <type_traits>
 #include <utility>
+#include <vector>
 
 #include "../derecho_type_definitions.hpp"
 #include <derecho/persistent/HLC.hpp>
@@ -36,11 +38,64 @@ using message_id_t = int32_t;
  */
 using subgroup_type_id_t = uint32_t;
 
+/**
+ * The function that implements index_of_type, which is separate to hide the
+ * "counter" template parameter (an implementation detail only used to maintain
+ * state across recursive calls).
+ */
+template <uint32_t counter, typename TargetType, typename FirstType, typename... RestTypes>
+constexpr uint32_t index_of_type_impl() {
+    if constexpr(std::is_same<TargetType, FirstType>::value)
+        return counter;
+    else
+        return index_of_type_impl<counter + 1, TargetType, RestTypes...>();
+}
+
+/**
+ * A compile-time "function" that computes the index of a type within a template
+ * parameter pack of types. The value of this constant is equal to the index of
+ * TargetType within TypePack. (The compiler will spew template errors if
+ * TargetType is not actually in TypePack).
+ * @tparam TargetType The type to search for in the parameter pack
+ * @tparam TypePack The template parameter pack that should be searched
+ */
+template <typename TargetType, typename... TypePack>
+constexpr inline uint32_t index_of_type = index_of_type_impl<0, TargetType, TypePack...>();
+
+/**
+ * A type-trait-like template that provides a True member "value" if TargetType
+ * matches some type in TypePack (according to std::is_same), or provides a
+ * False member "value" if TargetType does not match anything in TypePack.
+ */
+template <typename TargetType, typename... TypePack>
+using contains = std::integral_constant<bool, (std::is_same<TargetType, TypePack>::value || ...)>;
+
 /** Alias for the type of std::function that is used for message delivery event callbacks. */
 // using message_callback_t = std::function<void(subgroup_id_t, node_id_t, message_id_t, char*, long long int, persistent::version_t)>;
 using message_callback_t = std::function<void(subgroup_id_t, node_id_t, message_id_t, std::optional<std::pair<char*, long long int>>, persistent::version_t)>;
+
+/**
+ * Describes one stable message in a batch handed to a batch delivery callback.
+ * The fields mirror the arguments of message_callback_t; data is empty for
+ * cooked sends and null messages, and the pointer is only valid for the
+ * duration of the callback.
+ */
+struct DeliveredMessage {
+    subgroup_id_t subgroup_id;
+    node_id_t sender_id;
+    message_id_t index;
+    std::optional<std::pair<char*, long long int>> data;
+    persistent::version_t version;
+};
+
+/** Alias for the type of std::function used for batched delivery callbacks,
+ * which receive all messages made stable by one predicate firing at once. */
+using batch_message_callback_t = std::function<void(const std::vector<DeliveredMessage>&)>;
 using persistence_callback_t = std::function<void(subgroup_id_t, persistent::version_t)>;
 using rpc_handler_t = std::function<void(subgroup_id_t, node_id_t, char*, uint32_t)>;
+/** The type of std::function MulticastGroup uses to ask the RPC layer whether
+ * a cooked message targets an order-insensitive function */
+using rpc_order_query_t = std::function<bool(subgroup_id_t, char*, uint32_t)>;
 
 /** The type of factory function the user must provide to the Group constructor,
  * to construct each Replicated Object that is assigned to a subgroup */
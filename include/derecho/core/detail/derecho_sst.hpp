@@ -9,6 +9,7 @@
 
 #include "../derecho_type_definitions.hpp"
 #include "derecho_internal.hpp"
+#include <derecho/conf/conf.hpp>
 #include <derecho/sst/sst.hpp>
 
 namespace derecho {
@@ -35,14 +36,57 @@ inline ChangeProposal make_change_proposal(uint16_t leader_id, uint16_t change_i
     return ChangeProposal{leader_id, change_id, false};
 }
 
+/**
+ * Indexes into the perf_counters field of DerechoSST. Each node maintains
+ * these cumulative counters in its own row and pushes them lazily (from the
+ * failure-checking thread), so any member can read cluster-wide totals with
+ * no extra messages.
+ */
+enum class PerfCounter : uint32_t {
+    /** Multicast messages this node has sent (RDMC or SST) */
+    MESSAGES_SENT = 0,
+    /** Multicast messages delivered at this node */
+    MESSAGES_DELIVERED,
+    /** Total payload bytes delivered at this node */
+    BYTES_DELIVERED,
+    /** Persistent versions this node has finished persisting to disk */
+    VERSIONS_PERSISTED,
+    /** View changes this node has installed */
+    VIEW_CHANGES,
+    /** Not a counter: the number of entries in the perf_counters field */
+    NUM_COUNTERS
+};
+
 /**
  * The GMS and derecho_group will share the same SST for efficiency. This class
  * defines all the fields in this SST.
  */
 class DerechoSST : public sst::SST<DerechoSST> {
     static_assert(std::is_trivially_copyable<ChangeProposal>::value, "ChangeProposal is not trivially copyable, but it should be because it's an SST field!");
+    /**
+     * Computes the size of the piggyback_reply_slots field from the piggyback
+     * configuration options: one ring of piggyback_reply_window_size slots per
+     * member, each sized for a maximum-size reply plus its (size, sequence
+     * number) trailer. Returns 1 (a placeholder byte) when piggybacked replies
+     * are disabled.
+     */
+    static size_t piggyback_slots_size(size_t num_members) {
+        const uint64_t payload_size = getConfUInt64(CONF_DERECHO_PIGGYBACK_REPLY_PAYLOAD_SIZE);
+        if(payload_size == 0) {
+            return 1;
+        }
+        return num_members * getConfUInt32(CONF_DERECHO_PIGGYBACK_REPLY_WINDOW_SIZE)
+               * (payload_size + 2 * sizeof(uint64_t));
+    }
+
 public:
-    // MulticastGroup members, related only to tracking message delivery
+    // MulticastGroup members, related only to tracking message delivery.
+    // These fields form the hot section of the row: they change at multicast
+    // rate and are scanned continuously by the predicate thread, so they come
+    // first and an SSTCacheLineBoundary keeps them on separate cache lines
+    // from the rarely-written view-change state further down. Moving a field
+    // across a boundary changes what a row push covers, so the range-based
+    // put() calls (see ViewManager's joiner-field push) must be kept in sync.
     /**
      * Sequence numbers are interpreted like a row-major pair:
      * (sender, index) becomes sender + num_members * index.
@@ -54,6 +98,9 @@ public:
      * This variable is the highest sequence number that has been received
      * in-order by this node; if a node updates seq_num, it has received all
      * messages up to seq_num in the global round-robin order.
+     *
+     * Stored column-major because the delivery predicate's min-over-rows
+     * scan of this field is one of the hottest loops in the predicate thread.
      */
     SSTFieldVector<message_id_t> seq_num;
     /**
@@ -68,6 +115,48 @@ public:
      * updated by the PersistenceManager.
      */
     SSTFieldVector<persistent::version_t> persisted_num;
+    /**
+     * Local count of number of received messages by sender.  For each
+     * sender k, nReceived[k] is the number received (a.k.a. "locally stable").
+     * Column-major for the same reason as seq_num.
+     */
+    SSTFieldVector<int32_t> num_received;
+    SSTFieldVector<int32_t> num_received_sst;
+    /**
+     * Packed (first, last) index interval of suppressed null messages, with
+     * one entry per sender slot (same indexing as num_received). A sender in
+     * a subgroup with null_send_suppression enabled advances the round-robin
+     * order by publishing this interval instead of multicasting real null
+     * messages; receivers count the interval as received once every earlier
+     * message from that sender has arrived. The empty interval is (0, -1).
+     */
+    SSTFieldVector<uint64_t> suppressed_nulls;
+    /** to check for failures - used by the thread running check_failures_loop in derecho_group **/
+    SSTFieldVector<uint64_t> local_stability_frontier;
+    /**
+     * Keeps the delivery counters above off the cache lines of the multicast
+     * slot buffers below, which are DMA-written on every SST multicast.
+     */
+    sst::SSTCacheLineBoundary delivery_state_end;
+    /** for SST multicast */
+    SSTFieldVector<char> slots;
+    /**
+     * Reserved region for piggybacked small RPC replies; a single placeholder
+     * byte unless DERECHO/piggyback_reply_payload_size is nonzero. Laid out as
+     * one ring of piggyback_reply_window_size slots per destination rank; each
+     * slot holds a complete reply message followed by a (size, sequence
+     * number) trailer, using the same sequencing scheme as the SST multicast
+     * slots.
+     */
+    SSTFieldVector<char> piggyback_reply_slots;
+    /**
+     * piggyback_reply_acks[i] is the number of piggybacked replies this node
+     * has consumed from member i's ring, used by senders for flow control.
+     */
+    SSTFieldVector<uint64_t> piggyback_reply_acks;
+    /** End of the hot section: everything below changes at view-change or
+     * monitoring rate and lives on its own cache lines. */
+    sst::SSTCacheLineBoundary hot_section_end;
 
     // Group management service members, related only to handling view changes
     /** View ID associated with this SST. VIDs monotonically increase as views change. */
@@ -117,15 +206,7 @@ public:
      * current view. Monotonically increases, lower bound on num_committed.
      */
     SSTField<int> num_installed;
-    /**
-     * Local count of number of received messages by sender.  For each
-     * sender k, nReceived[k] is the number received (a.k.a. "locally stable").
-     */
-    SSTFieldVector<int32_t> num_received;
-    /**
-     * Set after calling rdmc::wedged(), reports that this member is wedged.
-     * Must be after num_received!
-     */
+    /** Set after calling rdmc::wedged(), reports that this member is wedged. */
     SSTField<bool> wedged;
     /**
      * Array of how many messages to accept from each sender in the current
@@ -137,12 +218,57 @@ public:
      * has published a global_min for the current view change
      */
     SSTFieldVector<bool> global_min_ready;
-    /** for SST multicast */
-    SSTFieldVector<char> slots;
-    SSTFieldVector<int32_t> num_received_sst;
-
-    /** to check for failures - used by the thread running check_failures_loop in derecho_group **/
-    SSTFieldVector<uint64_t> local_stability_frontier;
+    /**
+     * Scratch buffer through which the leader disseminates the serialized
+     * ViewDelta (or full View) for the view change in progress, so standing
+     * members receive it over the same RDMA fabric as the rest of the GMS
+     * instead of one TCP round trip per member. Only the leader's row is
+     * meaningful; sized by DERECHO/view_delta_buffer_size.
+     */
+    SSTFieldVector<char> view_delta_buffer;
+    /**
+     * The number of valid bytes in view_delta_buffer, or 0 if the serialized
+     * view did not fit there and is being sent over the TCP fallback path.
+     */
+    SSTField<uint64_t> view_delta_size;
+    /**
+     * The VID of the view described by view_delta_buffer. The leader pushes
+     * the buffer before this header, and RDMA writes on a connection are
+     * applied in order, so a member that reads the next view's ID here can
+     * safely read view_delta_size and the buffer.
+     */
+    SSTField<int32_t> view_delta_vid;
+    /**
+     * Cumulative per-node performance counters, indexed by PerfCounter. Each
+     * node only writes its own row (via increment_perf_counter) and pushes
+     * the region lazily with push_perf_counters(); the counters are
+     * monitoring data, so remote rows may be slightly stale.
+     */
+    SSTFieldVector<uint64_t> perf_counters;
+    /**
+     * Counter for the application-facing SST barrier (see
+     * ViewManager::sst_barrier). Each participant increments and pushes its
+     * own entry on entering a barrier, then min-scans the column until every
+     * other participant's entry has caught up. The value survives view
+     * changes (init_local_row_from_previous carries it over), so barriers
+     * in progress are not lost when the membership changes.
+     */
+    SSTField<uint64_t> barrier_counter;
+    /**
+     * Application-published load metric for this node (e.g. request queue
+     * depth or CPU utilization; the units are up to the application, lower
+     * means less loaded). Written via publish_load_metric and read by the
+     * pick-least-loaded-replica p2p targeting mode, so read traffic can
+     * steer toward idle replicas within a shard with no extra messages.
+     */
+    SSTField<uint64_t> load_metric;
+    /**
+     * p2p_connect_request[i] is set when this node wants an on-demand p2p
+     * connection to the member at rank i (lazy member p2p mode); the target
+     * notices the bit in its copy of this row and builds its half of the
+     * connection. Bits are sticky for the lifetime of one View's SST.
+     */
+    SSTFieldVector<bool> p2p_connect_request;
 
     /** to signal a graceful exit */
     SSTField<bool> rip;
@@ -154,9 +280,16 @@ public:
      */
     DerechoSST(const sst::SSTParams& parameters, uint32_t num_subgroups, uint32_t num_received_size, uint64_t slot_size)
             : sst::SST<DerechoSST>(this, parameters),
-              seq_num(num_subgroups),
+              seq_num(num_subgroups, sst::FieldLayout::column_major),
               delivered_num(num_subgroups),
               persisted_num(num_subgroups),
+              num_received(num_received_size, sst::FieldLayout::column_major),
+              num_received_sst(num_received_size),
+              suppressed_nulls(num_received_size),
+              local_stability_frontier(num_subgroups),
+              slots(slot_size),
+              piggyback_reply_slots(piggyback_slots_size(parameters.members.size())),
+              piggyback_reply_acks(parameters.members.size()),
               suspected(parameters.members.size()),
               changes(100 + parameters.members.size()), //The extra 100 entries allows for more joins at startup, when the group is very small
               joiner_ips(100 + parameters.members.size()),
@@ -164,18 +297,27 @@ public:
               joiner_rpc_ports(100 + parameters.members.size()),
               joiner_sst_ports(100 + parameters.members.size()),
               joiner_rdmc_ports(100 + parameters.members.size()),
-              num_received(num_received_size),
               global_min(num_received_size),
               global_min_ready(num_subgroups),
-              slots(slot_size),
-              num_received_sst(num_received_size),
-              local_stability_frontier(num_subgroups) {
-        SSTInit(seq_num, delivered_num,
-                persisted_num, vid, suspected, changes, joiner_ips,
+              view_delta_buffer(getConfUInt64(CONF_DERECHO_VIEW_DELTA_BUFFER_SIZE)),
+              perf_counters(static_cast<uint32_t>(PerfCounter::NUM_COUNTERS)),
+              p2p_connect_request(parameters.members.size()) {
+        // Layout order: the hot delivery fields first, then the multicast
+        // slot buffers, then the cold view-change/monitoring fields, each
+        // section starting on its own cache line. The joiner_* fields must
+        // stay contiguous and directly before num_changes; ViewManager
+        // pushes them as the single range [joiner_ips, num_changes).
+        SSTInit(seq_num, delivered_num, persisted_num,
+                num_received, num_received_sst, suppressed_nulls,
+                local_stability_frontier, delivery_state_end,
+                slots, piggyback_reply_slots, piggyback_reply_acks,
+                hot_section_end,
+                vid, suspected, changes, joiner_ips,
                 joiner_gms_ports, joiner_rpc_ports, joiner_sst_ports, joiner_rdmc_ports,
                 num_changes, num_committed, num_acked, num_installed,
-                num_received, wedged, global_min, global_min_ready,
-                slots, num_received_sst, local_stability_frontier, rip);
+                wedged, global_min, global_min_ready,
+                view_delta_buffer, view_delta_size, view_delta_vid,
+                perf_counters, barrier_counter, load_metric, p2p_connect_request, rip);
         //Once superclass constructor has finished, table entries can be initialized
         for(unsigned int row = 0; row < get_num_rows(); ++row) {
             vid[row] = 0;
@@ -193,11 +335,21 @@ public:
             for(size_t i = 0; i < global_min.size(); ++i) {
                 global_min[row][i] = 0;
             }
+            for(size_t i = 0; i < suppressed_nulls.size(); ++i) {
+                // the empty interval: first = 0, last = -1
+                suppressed_nulls[row][i] = 0x00000000ffffffffull;
+            }
+            view_delta_size[row] = 0;
+            view_delta_vid[row] = -1;
             memset(const_cast<uint32_t*>(joiner_ips[row]), 0, joiner_ips.size());
             memset(const_cast<uint16_t*>(joiner_gms_ports[row]), 0, joiner_gms_ports.size());
             memset(const_cast<uint16_t*>(joiner_rpc_ports[row]), 0, joiner_rpc_ports.size());
             memset(const_cast<uint16_t*>(joiner_sst_ports[row]), 0, joiner_sst_ports.size());
             memset(const_cast<uint16_t*>(joiner_rdmc_ports[row]), 0, joiner_rdmc_ports.size());
+            memset(const_cast<char*>(piggyback_reply_slots[row]), 0, piggyback_reply_slots.size());
+            for(size_t i = 0; i < piggyback_reply_acks.size(); ++i) {
+                piggyback_reply_acks[row][i] = 0;
+            }
             num_changes[row] = 0;
             num_committed[row] = 0;
             num_installed[row] = 0;
@@ -210,6 +362,14 @@ public:
             for(size_t i = 0; i < local_stability_frontier.size(); ++i) {
                 local_stability_frontier[row][i] = current_time;
             }
+            for(size_t i = 0; i < perf_counters.size(); ++i) {
+                perf_counters[row][i] = 0;
+            }
+            barrier_counter[row] = 0;
+            load_metric[row] = 0;
+            for(size_t i = 0; i < p2p_connect_request.size(); ++i) {
+                p2p_connect_request[row][i] = false;
+            }
             rip[row] = false;
         }
     }
@@ -234,6 +394,71 @@ public:
      */
     void init_local_change_proposals(const int other_row);
 
+    /**
+     * Adds an amount (default 1) to one of this node's performance counters.
+     * This only writes the local row; the new value reaches other members the
+     * next time push_perf_counters() runs.
+     */
+    void increment_perf_counter(PerfCounter counter, uint64_t amount = 1) {
+        perf_counters[get_local_index()][static_cast<uint32_t>(counter)] += amount;
+        std::atomic_signal_fence(std::memory_order_acq_rel);
+    }
+
+    /**
+     * Pushes the local row's performance counters to all other members.
+     * Called at a low rate (from the failure-checking thread), so counter
+     * updates cost no network traffic of their own.
+     */
+    void push_perf_counters() {
+        put(perf_counters);
+    }
+
+    /** Reads one performance counter from one member's row. */
+    uint64_t read_perf_counter(uint32_t row, PerfCounter counter) const {
+        return perf_counters[row][static_cast<uint32_t>(counter)];
+    }
+
+    /**
+     * Publishes this node's load metric: writes the local row and
+     * immediately pushes the (single 8-byte) field to all other members.
+     */
+    void publish_load_metric(uint64_t value) {
+        load_metric[get_local_index()] = value;
+        std::atomic_signal_fence(std::memory_order_acq_rel);
+        put(load_metric);
+    }
+
+    /**
+     * Requests an on-demand p2p connection from the member at target_rank
+     * (lazy member p2p mode): sets the local row's request bit for that
+     * rank and pushes just that byte to the target, whose predicate thread
+     * then builds its half of the connection.
+     */
+    void request_p2p_connection(uint32_t target_rank) {
+        p2p_connect_request[get_local_index()][target_rank] = true;
+        std::atomic_signal_fence(std::memory_order_acq_rel);
+        put(std::vector<uint32_t>{target_rank},
+            (char*)std::addressof(p2p_connect_request[0][target_rank]) - getBaseAddress(),
+            sizeof(bool));
+    }
+
+    /** Reads the load metric most recently published by one member. */
+    uint64_t read_load_metric(uint32_t row) const {
+        return load_metric[row];
+    }
+
+    /**
+     * Reads the cluster-wide total of a performance counter by summing it
+     * over every row of the table.
+     */
+    uint64_t read_perf_counter_total(PerfCounter counter) const {
+        uint64_t total = 0;
+        for(unsigned int row = 0; row < get_num_rows(); ++row) {
+            total += perf_counters[row][static_cast<uint32_t>(counter)];
+        }
+        return total;
+    }
+
     /**
      * Creates a string representation of the local row (not the whole table).
      * This should be converted to an ostream operator<< to follow standards.
@@ -0,0 +1,221 @@
+/**
+ * @file external_client_impl.hpp
+ *
+ * Implementation of the templated ExternalGroupClient and
+ * ExternalClientCaller classes declared in external_client.hpp.
+ */
+
+#pragma once
+
+#include <cassert>
+#include <chrono>
+#include <ctime>
+#include <pthread.h>
+
+#include "../external_client.hpp"
+#include <derecho/utils/logger.hpp>
+#ifdef USE_VERBS_API
+#include <derecho/sst/detail/verbs.hpp>
+#else
+#include <derecho/sst/detail/lf.hpp>
+#endif
+
+namespace derecho {
+
+template <typename T, typename ExternalGroupType>
+ExternalClientCaller<T, ExternalGroupType>::ExternalClientCaller(
+        subgroup_type_id_t type_id, node_id_t nid, subgroup_id_t subgroup_id,
+        ExternalGroupType& group_client)
+        : node_id(nid),
+          subgroup_id(subgroup_id),
+          group_client(group_client),
+          wrapped_this(rpc::build_remote_invoker_from_tuple<T>(nid, type_id, subgroup_id,
+                                                               *group_client.receivers,
+                                                               T::register_functions())) {}
+
+template <typename T, typename ExternalGroupType>
+template <rpc::FunctionTag tag, typename... Args>
+auto ExternalClientCaller<T, ExternalGroupType>::p2p_send(Args&&... args) {
+    std::optional<sst::P2PConnection::SendSlot> send_slot;
+    auto return_pair = wrapped_this->template send<tag>(
+            [this, &send_slot](std::size_t size) -> char* {
+                if(size > group_client.max_request_size) {
+                    throw derecho_exception("The size of serialized args exceeds the maximum message size.");
+                }
+                //A full request window just means the server hasn't consumed
+                //our earlier requests yet, so wait for a slot to free up
+                do {
+                    send_slot = group_client.p2p_connections->reserve_slot(
+                            group_client.server_id, sst::REQUEST_TYPE::P2P_REQUEST, size);
+                } while(!send_slot);
+                return send_slot->buf;
+            },
+            std::forward<Args>(args)...);
+    group_client.p2p_connections->post(group_client.server_id, *send_slot);
+    return_pair.pending.fulfill_map({group_client.server_id});
+    return std::move(return_pair.results);
+}
+
+template <typename... ReplicatedTypes>
+ExternalGroupClient<ReplicatedTypes...>::ExternalGroupClient(
+        const std::string& server_ip, uint16_t server_port,
+        mutils::RemoteDeserializationContext* deserialization_context)
+        : my_id(getConfUInt32(CONF_DERECHO_LOCAL_ID)),
+          receivers(new rpc::receiver_map_t()) {
+    if(deserialization_context != nullptr) {
+        rdv.push_back(deserialization_context);
+    }
+    //Step 1 of the handshake: introduce ourselves to the server
+    tcp::socket handshake_socket(server_ip, server_port);
+    const std::string my_ip = getConfString(CONF_DERECHO_LOCAL_IP);
+    const uint16_t my_sst_port = getConfUInt16(CONF_DERECHO_SST_PORT);
+    const rpc::ExternalClientHello hello{my_id, my_sst_port};
+    if(!handshake_socket.write(hello)) {
+        throw derecho_exception("Failed to send the external-client hello to "
+                                + server_ip + ":" + std::to_string(server_port));
+    }
+    std::size_t ip_size = my_ip.size();
+    handshake_socket.write(ip_size);
+    handshake_socket.write(my_ip.c_str(), ip_size);
+    //Step 2: learn the server's identity, buffer layout, and subgroup layout
+    rpc::ExternalServerGreeting greeting;
+    if(!handshake_socket.read(greeting)) {
+        throw derecho_exception("Failed to read the external-client greeting from "
+                                + server_ip + ":" + std::to_string(server_port)
+                                + "; is its external_port enabled?");
+    }
+    server_id = greeting.server_id;
+    max_request_size = greeting.max_p2p_request_size;
+    std::size_t server_ip_size;
+    handshake_socket.read(server_ip_size);
+    std::string server_sst_ip(server_ip_size, '\0');
+    handshake_socket.read(&server_sst_ip[0], server_ip_size);
+    for(uint32_t type_num = 0; type_num < greeting.num_subgroup_types; ++type_num) {
+        subgroup_type_id_t type_id;
+        uint32_t num_subgroups;
+        handshake_socket.read(type_id);
+        handshake_socket.read(num_subgroups);
+        std::vector<subgroup_id_t> subgroup_ids(num_subgroups);
+        for(uint32_t subgroup_num = 0; subgroup_num < num_subgroups; ++subgroup_num) {
+            handshake_socket.read(subgroup_ids[subgroup_num]);
+        }
+        subgroup_ids_by_type_id.emplace(type_id, std::move(subgroup_ids));
+    }
+    //Step 3: bring up the RDMA transport and our SST-level TCP listener,
+    //then tell the server it is safe to connect to us
+    sst::lf_initialize({{my_id, {my_ip, my_sst_port}}}, my_id);
+    handshake_socket.write(my_id);
+    //Step 4: both sides add each other and exchange memory-region keys
+    //inside the P2PConnection constructor
+    sst::add_node(server_id, {server_sst_ip, greeting.sst_port});
+    p2p_connections = std::make_unique<sst::P2PConnectionManager>(sst::P2PParams{
+            my_id,
+            greeting.p2p_window_size,
+            greeting.rpc_window_size,
+            greeting.max_p2p_reply_size,
+            greeting.max_p2p_request_size,
+            greeting.max_rpc_reply_size,
+            greeting.small_p2p_request_size,
+            greeting.large_request_window_size,
+            greeting.query_snapshot_size});
+    //The server connection goes in the member map, not the on-demand map, so
+    //this side never tears it down; only the server applies an idle timeout
+    p2p_connections->add_connections({server_id});
+    reply_thread = std::thread(&ExternalGroupClient::reply_receive_loop, this);
+}
+
+template <typename... ReplicatedTypes>
+ExternalGroupClient<ReplicatedTypes...>::ExternalGroupClient(
+        mutils::RemoteDeserializationContext* deserialization_context)
+        : ExternalGroupClient(getConfString(CONF_DERECHO_LEADER_IP),
+                              getConfUInt16(CONF_DERECHO_EXTERNAL_PORT),
+                              deserialization_context) {}
+
+template <typename... ReplicatedTypes>
+ExternalGroupClient<ReplicatedTypes...>::~ExternalGroupClient() {
+    thread_shutdown = true;
+    if(reply_thread.joinable()) {
+        reply_thread.join();
+    }
+}
+
+template <typename... ReplicatedTypes>
+template <typename SubgroupType>
+ExternalClientCaller<SubgroupType, ExternalGroupClient<ReplicatedTypes...>>&
+ExternalGroupClient<ReplicatedTypes...>::get_subgroup_caller(uint32_t subgroup_index) {
+    using caller_t = ExternalClientCaller<SubgroupType, ExternalGroupClient<ReplicatedTypes...>>;
+    const subgroup_type_id_t type_id = index_of_type<SubgroupType, ReplicatedTypes...>;
+    const subgroup_id_t subgroup_id = subgroup_ids_by_type_id.at(type_id).at(subgroup_index);
+    auto caller_entry = subgroup_callers.find(subgroup_id);
+    if(caller_entry == subgroup_callers.end()) {
+        caller_entry = subgroup_callers
+                               .emplace(subgroup_id,
+                                        std::make_shared<caller_t>(type_id, my_id, subgroup_id, *this))
+                               .first;
+    }
+    return *std::static_pointer_cast<caller_t>(caller_entry->second);
+}
+
+template <typename... ReplicatedTypes>
+template <typename SubgroupType>
+std::size_t ExternalGroupClient<ReplicatedTypes...>::get_number_of_subgroups() const {
+    const subgroup_type_id_t type_id = index_of_type<SubgroupType, ReplicatedTypes...>;
+    const auto subgroups_entry = subgroup_ids_by_type_id.find(type_id);
+    return subgroups_entry == subgroup_ids_by_type_id.end() ? 0
+                                                            : subgroups_entry->second.size();
+}
+
+template <typename... ReplicatedTypes>
+void ExternalGroupClient<ReplicatedTypes...>::reply_receive_loop() {
+    pthread_setname_np(pthread_self(), "client_rpc_thrd");
+    using namespace rpc::remote_invocation_utilities;
+    const std::size_t header_size = header_space();
+
+    struct timespec last_time, cur_time;
+    clock_gettime(CLOCK_REALTIME, &last_time);
+
+    while(!thread_shutdown) {
+        auto optional_message_pair = p2p_connections->probe_all();
+        if(optional_message_pair) {
+            char* msg_buf = optional_message_pair->second;
+            std::size_t payload_size;
+            rpc::Opcode indx;
+            node_id_t received_from;
+            uint32_t flags;
+            retrieve_header(nullptr, msg_buf, payload_size, indx, received_from, flags);
+            if(indx.is_reply) {
+                const auto receiver_entry = receivers->find(indx);
+                if(receiver_entry != receivers->end()) {
+                    //Reply receivers only fulfill local promises; they never
+                    //allocate a response, so out_alloc is never called
+                    receiver_entry->second(&rdv, received_from, msg_buf + header_size,
+                                           [](std::size_t) -> char* {
+                                               assert(false);
+                                               return nullptr;
+                                           });
+                } else {
+                    dbg_default_error("External client received a reply with an invalid RPC opcode! Opcode was ({}, {}, {}, {}).",
+                                      indx.class_id, indx.subgroup_id, indx.function_id, indx.is_reply);
+                }
+            } else {
+                //Only group members can be p2p-called, so requests should
+                //never arrive here
+                dbg_default_warn("External client ignoring a non-reply p2p message from node {}",
+                                 optional_message_pair->first);
+            }
+            p2p_connections->update_incoming_seq_num();
+            clock_gettime(CLOCK_REALTIME, &last_time);
+        } else {
+            clock_gettime(CLOCK_REALTIME, &cur_time);
+            //check if the system has been inactive for enough time to induce sleep
+            double time_elapsed_in_ms = (cur_time.tv_sec - last_time.tv_sec) * 1e3
+                                        + (cur_time.tv_nsec - last_time.tv_nsec) / 1e6;
+            if(time_elapsed_in_ms > 1) {
+                using namespace std::chrono_literals;
+                std::this_thread::sleep_for(1ms);
+            }
+        }
+    }
+}
+
+}  // namespace derecho
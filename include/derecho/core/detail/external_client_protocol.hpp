@@ -0,0 +1,75 @@
+/**
+ * @file external_client_protocol.hpp
+ *
+ * The wire format of the TCP handshake between an ExternalGroupClient and a
+ * group member's external-client listener (RPCManager::external_client_loop).
+ * The handshake runs over a plain TCP connection to DERECHO/external_port and
+ * proceeds in four steps:
+ *
+ *  1. The client sends an ExternalClientHello, followed by its SST IP address
+ *     as a length-prefixed string.
+ *  2. The server replies with an ExternalServerGreeting, followed by its own
+ *     SST IP address as a length-prefixed string, then the subgroup metadata:
+ *     for each subgroup type, a uint32_t type ID, a uint32_t count, and that
+ *     many uint32_t subgroup IDs (the contents of the current View's
+ *     subgroup_ids_by_type_id map).
+ *  3. The client initializes its RDMA transport and its SST-level TCP
+ *     listener, then sends back its node ID as an acknowledgment. The server
+ *     must not try to open the SST-level connection before this arrives,
+ *     because sst::add_node on the lower-ID side connects immediately with no
+ *     retry.
+ *  4. Both sides call sst::add_node for each other and construct their ends
+ *     of the P2PConnection, whose constructor completes the (blocking)
+ *     memory-region key exchange over the SST-level connection.
+ *
+ * The greeting carries the exact P2PParams the server built its connection
+ * manager with, so the client lays out its ring buffers identically without
+ * needing a config file that matches the group's.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <type_traits>
+
+#include "../derecho_type_definitions.hpp"
+
+namespace derecho {
+namespace rpc {
+
+/** First handshake message, client to server. */
+struct ExternalClientHello {
+    /** The client's node ID, which must not collide with any group member's. */
+    node_id_t client_id;
+    /** The port of the client's SST-level TCP listener. */
+    uint16_t sst_port;
+};
+
+/** Second handshake message, server to client. */
+struct ExternalServerGreeting {
+    /** The node ID of the group member serving this client. */
+    node_id_t server_id;
+    /** The port of the server's SST-level TCP listener. */
+    uint16_t sst_port;
+    /* The p2p ring-buffer layout parameters the server's P2PConnectionManager
+     * was constructed with; field for field the same as sst::P2PParams minus
+     * my_node_id. The client must build its connection to the server with
+     * these same values or the two sides will disagree on buffer offsets. */
+    uint32_t p2p_window_size;
+    uint32_t rpc_window_size;
+    uint64_t max_p2p_reply_size;
+    uint64_t max_p2p_request_size;
+    uint64_t max_rpc_reply_size;
+    uint64_t small_p2p_request_size;
+    uint32_t large_request_window_size;
+    uint64_t query_snapshot_size;
+    /** The number of per-type subgroup ID lists that follow the IP string. */
+    uint32_t num_subgroup_types;
+};
+
+static_assert(std::is_trivially_copyable<ExternalClientHello>::value
+                      && std::is_trivially_copyable<ExternalServerGreeting>::value,
+              "Handshake messages are sent as raw bytes over tcp::socket");
+
+}  // namespace rpc
+}  // namespace derecho
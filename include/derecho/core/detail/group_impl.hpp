@@ -4,6 +4,8 @@
  * @date Apr 22, 2016
  */
 
+#include <thread>
+
 #include <derecho/mutils-serialization/SerializationSupport.hpp>
 #include <spdlog/async.h>
 #include <spdlog/sinks/rotating_file_sink.h>
@@ -15,6 +17,12 @@
 #include "make_kind_map.hpp"
 #include <derecho/utils/logger.hpp>
 
+#ifdef USE_VERBS_API
+#include <derecho/rdmc/detail/verbs_helper.hpp>
+#else
+#include <derecho/rdmc/detail/lf_helper.hpp>
+#endif
+
 namespace derecho {
 
 template <typename SubgroupType>
@@ -157,6 +165,9 @@ Group<ReplicatedTypes...>::Group(const CallbackSet& callbacks,
     //State transfer must complete before an initial view can commit, and must retry if the view is aborted
     bool initial_view_confirmed = false;
     while(!initial_view_confirmed) {
+        //If a previous iteration deferred object deserialization to background
+        //threads, they must finish before construct_objects can run again
+        wait_for_pending_object_inits();
         //This might be the shard leaders from the previous view,
         //or the nodes with the longest logs in their shard if we're doing total restart,
         //or empty if this is the first View of a new group
@@ -169,7 +180,7 @@ Group<ReplicatedTypes...>::Group(const CallbackSet& callbacks,
         //These functions are no-ops if we're not doing total restart
         view_manager.truncate_logs();
         view_manager.send_logs();
-        receive_objects(subgroups_and_leaders_to_receive);
+        receive_objects(subgroups_and_leaders_to_receive, false);
         if(is_starting_leader) {
             bool leader_has_quorum = true;
             initial_view_confirmed = view_manager.leader_prepare_initial_view(leader_has_quorum);
@@ -211,6 +222,8 @@ Group<ReplicatedTypes...>::~Group() {
     // TODO-discussion:
     // Will a node be able to come back once it leaves? if not, maybe we should
     // shut it down on leave().
+    //Make sure no background deserialization threads outlive the objects they initialize
+    wait_for_pending_object_inits();
     persistence_manager.shutdown(true);
     tcp_sockets->destroy();
 }
@@ -301,19 +314,36 @@ void Group<ReplicatedTypes...>::set_up_components() {
     persistence_manager.set_view_manager(view_manager);
     //Now that MulticastGroup is constructed, tell it about RPCManager's message handler
     SharedLockedReference<View> curr_view = view_manager.get_current_view();
-    curr_view.get().multicast_group->register_rpc_callback([this](subgroup_id_t subgroup, node_id_t sender, char* buf, uint32_t size) {
-        rpc_manager.rpc_message_handler(subgroup, sender, buf, size);
+    if(getConfBoolean(CONF_DERECHO_LAZY_OBJECT_INIT)) {
+        //Hold delivery for a subgroup until its object has finished deserializing
+        curr_view.get().multicast_group->register_rpc_callback([this](subgroup_id_t subgroup, node_id_t sender, char* buf, uint32_t size) {
+            wait_until_object_ready(subgroup);
+            rpc_manager.rpc_message_handler(subgroup, sender, buf, size);
+        });
+    } else {
+        curr_view.get().multicast_group->register_rpc_callback([this](subgroup_id_t subgroup, node_id_t sender, char* buf, uint32_t size) {
+            rpc_manager.rpc_message_handler(subgroup, sender, buf, size);
+        });
+    }
+    curr_view.get().multicast_group->register_rpc_order_insensitive_query([this](subgroup_id_t subgroup, char* buf, uint32_t size) {
+        return rpc_manager.is_order_insensitive_rpc(subgroup, buf, size);
     });
     view_manager.add_view_upcall([this](const View& new_view) {
         rpc_manager.new_view_callback(new_view);
     });
+    view_manager.register_p2p_connect_upcall([this](node_id_t requester_id) {
+        rpc_manager.p2p_connection_requested(requester_id);
+    });
     //ViewManager must call back to Group after a view change in order to call construct_objects,
     //since ViewManager doesn't know the template parameters
     view_manager.register_initialize_objects_upcall([this](node_id_t my_id, const View& view,
                                                            const vector_int64_2d& old_shard_leaders) {
+        //Background deserializations from a previous view change (or the
+        //constructor) must finish before construct_objects can delete objects
+        wait_for_pending_object_inits();
         std::set<std::pair<subgroup_id_t, node_id_t>> subgroups_and_leaders
                 = construct_objects<ReplicatedTypes...>(view, old_shard_leaders);
-        receive_objects(subgroups_and_leaders);
+        receive_objects(subgroups_and_leaders, true);
     });
 }
 
@@ -361,7 +391,15 @@ ShardIterator<SubgroupType> Group<ReplicatedTypes...>::get_shard_iterator(uint32
 }
 
 template <typename... ReplicatedTypes>
-void Group<ReplicatedTypes...>::receive_objects(const std::set<std::pair<subgroup_id_t, node_id_t>>& subgroups_and_leaders) {
+void Group<ReplicatedTypes...>::receive_objects(const std::set<std::pair<subgroup_id_t, node_id_t>>& subgroups_and_leaders,
+                                                bool fabric_ready) {
+    const bool use_rdma_transfer = getConfBoolean(CONF_DERECHO_STATE_TRANSFER_RDMA) && fabric_ready;
+    const uint32_t num_stripes = getConfUInt32(CONF_DERECHO_STATE_TRANSFER_STRIPES);
+    std::unique_ptr<tcp::connection_listener> stripe_listener;
+    if(!use_rdma_transfer && num_stripes > 1 && !subgroups_and_leaders.empty()) {
+        stripe_listener = std::make_unique<tcp::connection_listener>(
+                getConfUInt16(CONF_DERECHO_STATE_TRANSFER_PORT));
+    }
     //This will receive one object from each shard leader in ascending order of subgroup ID
     for(const auto& subgroup_and_leader : subgroups_and_leaders) {
         LockedReference<std::unique_lock<std::mutex>, tcp::socket> leader_socket
@@ -372,6 +410,66 @@ void Group<ReplicatedTypes...>::receive_objects(const std::set<std::pair<subgrou
             dbg_default_debug("Sending log tail length of {} for subgroup {} to node {}.",
                               log_tail_length, subgroup_and_leader.first, subgroup_and_leader.second);
             leader_socket.get().write(log_tail_length);
+            if(getConfBoolean(CONF_DERECHO_STATE_TRANSFER_LOG_SUFFIX)) {
+                //The leader replies whether it is sending just a log suffix or the full object
+                bool receiving_log_suffix;
+                bool success = leader_socket.get().read(receiving_log_suffix);
+                assert_always(success);
+                if(receiving_log_suffix) {
+                    std::size_t tail_size;
+                    success = leader_socket.get().read(tail_size);
+                    assert_always(success);
+                    char* tail_buffer = new char[tail_size];
+                    success = leader_socket.get().read(tail_buffer, tail_size);
+                    assert_always(success);
+                    finish_object_receive(subgroup_and_leader.first,
+                                          [tail_buffer, tail_size, subgroup_and_leader, &subgroup_object]() {
+                                              subgroup_object.apply_log_tail(tail_buffer);
+                                              delete[] tail_buffer;
+                                              dbg_default_debug("Merged log suffix of size {} for subgroup {} from node {}.",
+                                                                tail_size, subgroup_and_leader.first, subgroup_and_leader.second);
+                                          });
+                    continue;
+                }
+            }
+        }
+        if(use_rdma_transfer) {
+            /* RDMA transfer: expose a registered memory region with one extra
+             * word past the payload, and send its address and key to the
+             * leader, which writes the serialized object into it and then
+             * sets the flag word. Polling the flag is sufficient because RDMA
+             * writes on the same connection are placed in order. */
+            std::size_t buffer_size;
+            bool success = leader_socket.get().read(buffer_size);
+            assert_always(success);
+            rdma::memory_region transfer_mr(buffer_size + sizeof(uint64_t));
+            volatile uint64_t& transfer_done_flag
+                    = *reinterpret_cast<volatile uint64_t*>(transfer_mr.buffer + buffer_size);
+            transfer_done_flag = 0;
+            leader_socket.get().write(static_cast<uint64_t>(
+                    reinterpret_cast<uintptr_t>(transfer_mr.buffer)));
+#ifdef USE_VERBS_API
+            leader_socket.get().write(static_cast<uint64_t>(transfer_mr.get_rkey()));
+            rdma::queue_pair transfer_connection(subgroup_and_leader.second);
+#else
+            leader_socket.get().write(transfer_mr.get_key());
+            rdma::endpoint transfer_connection(subgroup_and_leader.second,
+                                               my_id < subgroup_and_leader.second);
+#endif
+            dbg_default_debug("Receiving Replicated Object state for subgroup {} from node {} over RDMA",
+                              subgroup_and_leader.first, subgroup_and_leader.second);
+            while(transfer_done_flag == 0) {
+            }
+            subgroup_object.receive_object(transfer_mr.buffer);
+            //Acknowledge receipt so the leader knows it can close the connection
+            leader_socket.get().write(true);
+            continue;
+        }
+        if(num_stripes > 1) {
+            //Tell the leader which port the stripe listener is on. Since this is
+            //only sent when this node is ready to accept, at most one leader is
+            //connecting stripe sockets to the listener at a time.
+            leader_socket.get().write(getConfUInt16(CONF_DERECHO_STATE_TRANSFER_PORT));
         }
         dbg_default_debug("Receiving Replicated Object state for subgroup {} from node {}",
                           subgroup_and_leader.first, subgroup_and_leader.second);
@@ -379,14 +477,91 @@ void Group<ReplicatedTypes...>::receive_objects(const std::set<std::pair<subgrou
         bool success = leader_socket.get().read(buffer_size);
         assert_always(success);
         char* buffer = new char[buffer_size];
-        success = leader_socket.get().read(buffer, buffer_size);
-        assert_always(success);
-        subgroup_object.receive_object(buffer);
-        delete[] buffer;
+        if(num_stripes > 1) {
+            //Each stripe socket starts with the subgroup ID and its stripe
+            //index, which determines the range of the buffer it fills
+            std::vector<tcp::socket> stripe_sockets;
+            for(uint32_t stripe = 0; stripe < num_stripes; ++stripe) {
+                stripe_sockets.emplace_back(stripe_listener->accept());
+            }
+            std::vector<std::thread> stripe_threads;
+            for(std::size_t socket_num = 0; socket_num < stripe_sockets.size(); ++socket_num) {
+                stripe_threads.emplace_back([&, socket_num]() {
+                    tcp::socket& stripe_socket = stripe_sockets[socket_num];
+                    subgroup_id_t sender_subgroup_id;
+                    uint32_t stripe_index;
+                    bool stripe_success = stripe_socket.read(sender_subgroup_id)
+                                          && stripe_socket.read(stripe_index);
+                    assert_always(stripe_success);
+                    assert_always(sender_subgroup_id == subgroup_and_leader.first);
+                    const auto range = ViewManager::stripe_range(buffer_size, num_stripes, stripe_index);
+                    stripe_success = stripe_socket.read(buffer + range.first, range.second);
+                    assert_always(stripe_success);
+                });
+            }
+            for(auto& stripe_thread : stripe_threads) {
+                stripe_thread.join();
+            }
+        } else {
+            success = leader_socket.get().read(buffer, buffer_size);
+            assert_always(success);
+        }
+        finish_object_receive(subgroup_and_leader.first,
+                              [buffer, &subgroup_object]() {
+                                  subgroup_object.receive_object(buffer);
+                                  delete[] buffer;
+                              });
     }
     dbg_default_debug("Done receiving all Replicated Objects from subgroup leaders");
 }
 
+template <typename... ReplicatedTypes>
+void Group<ReplicatedTypes...>::finish_object_receive(subgroup_id_t subgroup_id,
+                                                      const std::function<void()>& deserialize_action) {
+    if(!getConfBoolean(CONF_DERECHO_LAZY_OBJECT_INIT)) {
+        deserialize_action();
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(object_ready_mutex);
+        objects_not_yet_ready.emplace(subgroup_id);
+    }
+    dbg_default_debug("Deferring deserialization of Replicated Object state for subgroup {} to a background thread", subgroup_id);
+    object_init_threads.emplace_back([this, subgroup_id, deserialize_action]() {
+        deserialize_action();
+        {
+            std::lock_guard<std::mutex> lock(object_ready_mutex);
+            objects_not_yet_ready.erase(subgroup_id);
+        }
+        object_ready_cv.notify_all();
+        dbg_default_debug("Replicated Object for subgroup {} is ready", subgroup_id);
+    });
+}
+
+template <typename... ReplicatedTypes>
+void Group<ReplicatedTypes...>::wait_until_object_ready(subgroup_id_t subgroup_id) {
+    std::unique_lock<std::mutex> lock(object_ready_mutex);
+    object_ready_cv.wait(lock, [&]() { return objects_not_yet_ready.count(subgroup_id) == 0; });
+}
+
+template <typename... ReplicatedTypes>
+void Group<ReplicatedTypes...>::wait_for_pending_object_inits() {
+    for(std::thread& init_thread : object_init_threads) {
+        init_thread.join();
+    }
+    object_init_threads.clear();
+}
+
+template <typename... ReplicatedTypes>
+void Group<ReplicatedTypes...>::publish_query_snapshot(const char* data, std::size_t size) {
+    rpc_manager.publish_query_snapshot(data, size);
+}
+
+template <typename... ReplicatedTypes>
+bool Group<ReplicatedTypes...>::one_sided_query(node_id_t target_id, char* data_out, std::size_t& size_out) {
+    return rpc_manager.one_sided_query(target_id, data_out, size_out);
+}
+
 template <typename... ReplicatedTypes>
 void Group<ReplicatedTypes...>::report_failure(const node_id_t who) {
     view_manager.report_failure(who);
@@ -397,8 +572,10 @@ void Group<ReplicatedTypes...>::leave(bool group_shutdown) {
     if(group_shutdown) {
         view_manager.silence();
         view_manager.barrier_sync();
+        view_manager.leave();
+    } else {
+        view_manager.graceful_leave();
     }
-    view_manager.leave();
 }
 
 template <typename... ReplicatedTypes>
@@ -427,11 +604,42 @@ node_id_t Group<ReplicatedTypes...>::get_my_id() {
     return my_id;
 }
 
+template <typename... ReplicatedTypes>
+uint64_t Group<ReplicatedTypes...>::read_perf_counter(PerfCounter counter) {
+    return view_manager.read_perf_counter(counter);
+}
+
+template <typename... ReplicatedTypes>
+uint64_t Group<ReplicatedTypes...>::read_perf_counter_total(PerfCounter counter) {
+    return view_manager.read_perf_counter_total(counter);
+}
+
+template <typename... ReplicatedTypes>
+void Group<ReplicatedTypes...>::publish_load_metric(uint64_t value) {
+    view_manager.publish_load_metric(value);
+}
+
 template <typename... ReplicatedTypes>
 void Group<ReplicatedTypes...>::barrier_sync() {
     view_manager.barrier_sync();
 }
 
+template <typename... ReplicatedTypes>
+std::vector<ViewChangeTiming> Group<ReplicatedTypes...>::get_view_change_timings() {
+    return view_manager.get_view_change_timings();
+}
+
+template <typename... ReplicatedTypes>
+void Group<ReplicatedTypes...>::barrier() {
+    view_manager.sst_barrier();
+}
+
+template <typename... ReplicatedTypes>
+template <typename SubgroupType>
+void Group<ReplicatedTypes...>::barrier(uint32_t subgroup_index) {
+    view_manager.sst_barrier(index_of_type<SubgroupType, ReplicatedTypes...>, subgroup_index);
+}
+
 template <typename... ReplicatedTypes>
 void Group<ReplicatedTypes...>::debug_print_status() const {
     view_manager.debug_print_status();
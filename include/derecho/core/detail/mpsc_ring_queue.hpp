@@ -0,0 +1,113 @@
+#pragma once
+
+#include <atomic>
+#include <cassert>
+#include <cstdint>
+#include <memory>
+
+namespace derecho {
+
+/**
+ * A bounded lock-free multi-producer/single-consumer ring queue, used to hand
+ * pending sends from application threads to the sender thread without taking
+ * a mutex on the hot path. Producers claim slots with a fetch_add on the
+ * enqueue position; each slot carries a sequence number that tells the
+ * consumer when the value is fully written (the classic Vyukov bounded-queue
+ * scheme, restricted to one consumer). The single consumer may peek at the
+ * front element in place before deciding to pop it, which the sender thread
+ * relies on when evaluating send eligibility.
+ */
+template <typename T>
+class MPSCRingQueue {
+private:
+    struct Slot {
+        std::atomic<uint64_t> sequence;
+        T value;
+    };
+
+    /** Capacity, always a power of two so masking replaces modulo. */
+    const uint64_t capacity;
+    const std::unique_ptr<Slot[]> slots;
+    /** Next position producers will claim. */
+    alignas(64) std::atomic<uint64_t> enqueue_pos;
+    /** Next position the (single) consumer will read; no atomicity needed. */
+    alignas(64) uint64_t dequeue_pos;
+
+    static uint64_t round_up_power_of_two(uint64_t x) {
+        uint64_t result = 1;
+        while(result < x) {
+            result <<= 1;
+        }
+        return result;
+    }
+
+public:
+    explicit MPSCRingQueue(uint64_t requested_capacity = 1024)
+            : capacity(round_up_power_of_two(requested_capacity)),
+              slots(new Slot[capacity]),
+              enqueue_pos(0),
+              dequeue_pos(0) {
+        for(uint64_t i = 0; i < capacity; ++i) {
+            slots[i].sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    /**
+     * Attempts to enqueue a value; returns false if the ring is full.
+     * Safe to call from multiple threads concurrently.
+     */
+    bool try_enqueue(T&& value) {
+        uint64_t pos = enqueue_pos.load(std::memory_order_relaxed);
+        while(true) {
+            Slot& slot = slots[pos & (capacity - 1)];
+            const uint64_t seq = slot.sequence.load(std::memory_order_acquire);
+            const int64_t diff = static_cast<int64_t>(seq) - static_cast<int64_t>(pos);
+            if(diff == 0) {
+                if(enqueue_pos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    slot.value = std::move(value);
+                    slot.sequence.store(pos + 1, std::memory_order_release);
+                    return true;
+                }
+            } else if(diff < 0) {
+                // the slot is still occupied by an unconsumed value
+                return false;
+            } else {
+                pos = enqueue_pos.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    /**
+     * Returns a pointer to the front element without removing it, or nullptr
+     * if the queue is empty. The pointer stays valid until pop() is called.
+     * Must only be called from the consumer thread.
+     */
+    T* peek() {
+        Slot& slot = slots[dequeue_pos & (capacity - 1)];
+        const uint64_t seq = slot.sequence.load(std::memory_order_acquire);
+        if(static_cast<int64_t>(seq) - static_cast<int64_t>(dequeue_pos + 1) < 0) {
+            return nullptr;
+        }
+        return &slot.value;
+    }
+
+    /**
+     * Removes the front element, which must exist (i.e. peek() returned
+     * non-null). Must only be called from the consumer thread.
+     */
+    void pop() {
+        Slot& slot = slots[dequeue_pos & (capacity - 1)];
+        assert(static_cast<int64_t>(slot.sequence.load(std::memory_order_acquire))
+               - static_cast<int64_t>(dequeue_pos + 1) >= 0);
+        slot.value = T();
+        slot.sequence.store(dequeue_pos + capacity, std::memory_order_release);
+        ++dequeue_pos;
+    }
+
+    /** True if the queue currently has no consumable element. Consumer-only. */
+    bool empty() {
+        return peek() == nullptr;
+    }
+};
+
+}  // namespace derecho
@@ -19,12 +19,15 @@
 #include "connection_manager.hpp"
 #include "derecho_internal.hpp"
 #include "derecho_sst.hpp"
+#include "mpsc_ring_queue.hpp"
 #include <derecho/conf/conf.hpp>
 #include <derecho/mutils-serialization/SerializationMacros.hpp>
 #include <derecho/mutils-serialization/SerializationSupport.hpp>
 #include <derecho/rdmc/rdmc.hpp>
 #include <derecho/sst/multicast.hpp>
 #include <derecho/sst/sst.hpp>
+#include <derecho/utils/hugepage_alloc.hpp>
+#include <derecho/utils/numa_placement.hpp>
 #include <spdlog/spdlog.h>
 
 namespace derecho {
@@ -40,6 +43,52 @@ struct CallbackSet {
     message_callback_t global_stability_callback;
     persistence_callback_t local_persistence_callback = nullptr;
     persistence_callback_t global_persistence_callback = nullptr;
+    /**
+     * If set, takes precedence over global_stability_callback: all messages
+     * made stable by one predicate firing are delivered in a single call,
+     * amortizing the per-message invocation overhead.
+     */
+    batch_message_callback_t batch_stability_callback = nullptr;
+    /**
+     * If set, fired for each raw (non-cooked, unfragmented) message as soon
+     * as it is locally received, roughly one round trip before global
+     * stability. The version argument is INVALID_VERSION since no version
+     * has been assigned yet; match the later confirm or abort by (subgroup,
+     * sender, index). The payload pointer is only valid for the duration of
+     * the call. Intended for soft state that can tolerate acting on a
+     * message that is later aborted.
+     */
+    message_callback_t speculative_delivery_callback = nullptr;
+    /**
+     * Fired (with an empty payload and the assigned version) when a
+     * speculatively delivered message reaches global stability and is
+     * delivered in order, making the earlier speculation final.
+     */
+    message_callback_t speculative_confirm_callback = nullptr;
+    /**
+     * Fired (with an empty payload and INVALID_VERSION) when a speculatively
+     * delivered message is discarded by a view change before delivery: the
+     * application must roll back whatever the speculation changed. A message
+     * from this node that is re-sent in the next view arrives again under a
+     * new index. Messages still undelivered at group shutdown are not
+     * aborted individually.
+     */
+    message_callback_t speculative_abort_callback = nullptr;
+};
+
+/**
+ * Values for header::fragment_state. Payloads larger than the subgroup's
+ * maximum message size are split by the sender into a train of fragments,
+ * each an ordinary multicast message; receivers accumulate them and deliver
+ * the reassembled payload as one message when the last fragment arrives.
+ */
+enum class FragmentState : uint8_t {
+    /** An ordinary, self-contained message. */
+    COMPLETE = 0,
+    /** A piece of a fragmented message, with more pieces to follow. */
+    FRAGMENT = 1,
+    /** The final piece of a fragmented message. */
+    LAST_FRAGMENT = 2
 };
 
 /**
@@ -51,6 +100,8 @@ struct __attribute__((__packed__)) header {
     int32_t index;
     uint64_t timestamp;
     bool cooked_send;
+    /** One of the FragmentState values; COMPLETE for unfragmented messages. */
+    uint8_t fragment_state;
 };
 
 /**
@@ -68,6 +119,23 @@ struct DerechoParams : public mutils::ByteRepresentable {
     unsigned int heartbeat_ms;
     rdmc::send_algorithm rdmc_send_algorithm;
     uint32_t rpc_port;
+    /** Number of SMC messages to accumulate into one slots-region push; 1
+     * (the default) keeps the one-push-per-message path. */
+    uint32_t smc_batch_size;
+    /** Maximum time a batched SMC message may wait before being pushed even
+     * if the batch is not full. 0 flushes only when the batch fills. */
+    uint32_t smc_batch_timeout_us;
+    /** When true, quiet senders in ORDERED mode advance the round-robin
+     * order by publishing their suppressed null-message interval through a
+     * per-sender SST counter instead of multicasting real null messages.
+     * All members of a subgroup must agree on this setting. */
+    bool null_send_suppression;
+    /** Relative weight of this subgroup in the sender thread's deficit
+     * round robin scheduler: a subgroup with priority N earns N times the
+     * byte credit per scheduling round of a priority-1 subgroup. Higher
+     * values keep latency-critical traffic from queueing behind bulk
+     * transfers; 0 is treated as 1. */
+    uint32_t sender_priority;
 
     static uint64_t compute_max_msg_size(
             const uint64_t max_payload_size,
@@ -82,6 +150,45 @@ struct DerechoParams : public mutils::ByteRepresentable {
         return max_msg_size;
     }
 
+    /**
+     * Picks an RDMC block size for the given maximum payload size when the
+     * profile leaves block_size set to 0 ("auto"). The block size targets
+     * enough blocks per message to fill the binomial pipeline (so every
+     * member spends most of the transfer relaying) while staying large
+     * enough that per-block completion overhead stays negligible. The result
+     * only depends on the profile, so every member of a subgroup computes
+     * the same value.
+     */
+    static uint64_t compute_block_size(const uint64_t max_payload_size) {
+        constexpr uint64_t min_block_size = 4096;        //overhead-bound floor
+        constexpr uint64_t max_block_size = 1048576;     //bandwidth-bound ceiling
+        constexpr uint64_t target_blocks_per_msg = 16;   //keeps the pipeline full
+        uint64_t block_size = (max_payload_size + sizeof(header)) / target_blocks_per_msg;
+        //round up to the next power of two so blocks tile the message evenly
+        uint64_t rounded_size = min_block_size;
+        while(rounded_size < block_size && rounded_size < max_block_size) {
+            rounded_size <<= 1;
+        }
+        return rounded_size;
+    }
+
+    /**
+     * Picks an RDMC send algorithm for the given maximum payload size when
+     * the profile requests "auto". Messages too small to split into enough
+     * blocks for the binomial pipeline to get going are sent with chain_send,
+     * whose per-step cost is lower; everything else uses binomial_send. Like
+     * compute_block_size, this depends only on the profile so all members
+     * agree on it.
+     */
+    static rdmc::send_algorithm select_send_algorithm(const uint64_t max_payload_size,
+                                                      const uint64_t block_size) {
+        constexpr uint64_t min_blocks_for_binomial = 4;
+        if(max_payload_size + sizeof(header) < min_blocks_for_binomial * block_size) {
+            return rdmc::send_algorithm::CHAIN_SEND;
+        }
+        return rdmc::send_algorithm::BINOMIAL_SEND;
+    }
+
     static rdmc::send_algorithm send_algorithm_from_string(const std::string& rdmc_send_algorithm_string) {
         if(rdmc_send_algorithm_string == "binomial_send") {
             return rdmc::send_algorithm::BINOMIAL_SEND;
@@ -91,6 +198,8 @@ struct DerechoParams : public mutils::ByteRepresentable {
             return rdmc::send_algorithm::SEQUENTIAL_SEND;
         } else if(rdmc_send_algorithm_string == "tree_send") {
             return rdmc::send_algorithm::TREE_SEND;
+        } else if(rdmc_send_algorithm_string == "ud_multicast_send") {
+            return rdmc::send_algorithm::UD_MULTICAST_SEND;
         } else {
             throw "wrong value for RDMC send algorithm: " + rdmc_send_algorithm_string + ". Check your config file.";
         }
@@ -103,14 +212,22 @@ struct DerechoParams : public mutils::ByteRepresentable {
                   unsigned int window_size,
                   unsigned int heartbeat_ms,
                   rdmc::send_algorithm rdmc_send_algorithm,
-                  uint32_t rpc_port)
+                  uint32_t rpc_port,
+                  uint32_t smc_batch_size = 1,
+                  uint32_t smc_batch_timeout_us = 0,
+                  bool null_send_suppression = false,
+                  uint32_t sender_priority = 1)
             : max_reply_msg_size(max_reply_payload_size + sizeof(header)),
               sst_max_msg_size(max_smc_payload_size + sizeof(header)),
               block_size(block_size),
               window_size(window_size),
               heartbeat_ms(heartbeat_ms),
               rdmc_send_algorithm(rdmc_send_algorithm),
-              rpc_port(rpc_port) {
+              rpc_port(rpc_port),
+              smc_batch_size(smc_batch_size),
+              smc_batch_timeout_us(smc_batch_timeout_us),
+              null_send_suppression(null_send_suppression),
+              sender_priority(sender_priority) {
         //if this is initialized above, DerechoParams turns abstract. idk why.
         max_msg_size = compute_max_msg_size(max_payload_size, block_size,
                                             max_payload_size > max_smc_payload_size);
@@ -120,10 +237,22 @@ struct DerechoParams : public mutils::ByteRepresentable {
 
     /**
      * Constructs DerechoParams specifying subgroup metadata for specified profile.
+     * The parsed parameters are cached per profile name: the configuration is
+     * immutable after startup, so re-deriving them from strings at every view
+     * change would only repeat the same map lookups and string conversions.
      * @param profile Name of profile in the configuration file to use.
      * @return DerechoParams.
      */
     static DerechoParams from_profile(const std::string& profile) {
+        static std::mutex cache_mutex;
+        static std::map<std::string, DerechoParams> cache;
+        {
+            std::lock_guard<std::mutex> lock(cache_mutex);
+            auto cached = cache.find(profile);
+            if(cached != cache.end()) {
+                return cached->second;
+            }
+        }
         // Use the profile string to search the configuration file for the appropriate
         // settings. If they do not exist, then we should utilize the defaults
         std::string prefix = "SUBGROUP/" + profile + "/";
@@ -146,21 +275,53 @@ struct DerechoParams : public mutils::ByteRepresentable {
         const std::string& algorithm = getConfString(prefix + Conf::subgroupProfileFields[5]);
         uint32_t rpc_port = getConfUInt32(CONF_DERECHO_RPC_PORT);
 
-        return DerechoParams{
+        if(block_size == 0) {
+            block_size = compute_block_size(max_payload_size);
+        }
+        rdmc::send_algorithm send_algorithm = (algorithm == "auto")
+                ? select_send_algorithm(max_payload_size, block_size)
+                : DerechoParams::send_algorithm_from_string(algorithm);
+
+        // The batching keys are optional in custom profiles (unlike the
+        // fields above) so existing config files keep working; they fall
+        // back to the SUBGROUP/DEFAULT values, which disable batching.
+        uint32_t smc_batch_size = hasCustomizedConfKey(prefix + "smc_batch_size")
+                ? getConfUInt32(prefix + "smc_batch_size")
+                : getConfUInt32(CONF_SUBGROUP_DEFAULT_SMC_BATCH_SIZE);
+        uint32_t smc_batch_timeout_us = hasCustomizedConfKey(prefix + "smc_batch_timeout_us")
+                ? getConfUInt32(prefix + "smc_batch_timeout_us")
+                : getConfUInt32(CONF_SUBGROUP_DEFAULT_SMC_BATCH_TIMEOUT_US);
+        bool null_send_suppression = hasCustomizedConfKey(prefix + "null_send_suppression")
+                ? getConfBoolean(prefix + "null_send_suppression")
+                : getConfBoolean(CONF_SUBGROUP_DEFAULT_NULL_SEND_SUPPRESSION);
+        uint32_t sender_priority = hasCustomizedConfKey(prefix + "sender_priority")
+                ? getConfUInt32(prefix + "sender_priority")
+                : getConfUInt32(CONF_SUBGROUP_DEFAULT_SENDER_PRIORITY);
+
+        DerechoParams params{
                 max_payload_size,
 		max_reply_payload_size,
                 max_smc_payload_size,
                 block_size,
                 window_size,
                 timeout_ms,
-                DerechoParams::send_algorithm_from_string(algorithm),
+                send_algorithm,
                 rpc_port,
+                smc_batch_size,
+                smc_batch_timeout_us,
+                null_send_suppression,
+                sender_priority,
         };
+        std::lock_guard<std::mutex> lock(cache_mutex);
+        cache.emplace(profile, params);
+        return params;
     }
 
     DEFAULT_SERIALIZATION_SUPPORT(DerechoParams, max_msg_size, max_reply_msg_size,
                                   sst_max_msg_size, block_size, window_size,
-                                  heartbeat_ms, rdmc_send_algorithm, rpc_port);
+                                  heartbeat_ms, rdmc_send_algorithm, rpc_port,
+                                  smc_batch_size, smc_batch_timeout_us,
+                                  null_send_suppression, sender_priority);
 };
 
 /**
@@ -170,22 +331,96 @@ struct DerechoParams : public mutils::ByteRepresentable {
  * This is a move-only type, since memory regions can't be copied.
  */
 struct MessageBuffer {
-    std::unique_ptr<char[]> buffer;
+    /** The deleter depends on where the buffer came from: delete[] for
+     * regular allocations, hugepage_free for hugepage-backed ones (and a
+     * no-op for zero-copy buffers, which the user owns). */
+    std::unique_ptr<char[], std::function<void(char*)>> buffer;
     std::shared_ptr<rdma::memory_region> mr;
+    /** The allocated (and registered) size of the buffer, used to return it
+     * to the right size class in MessageBufferPool. Zero for zero-copy
+     * buffers, which are never pooled. */
+    size_t capacity = 0;
+    /** Set only for zero-copy sends staged directly from a user-owned
+     * registered buffer: invoked, instead of pooling the buffer, when the
+     * message is retired, returning ownership of the bytes to the user. */
+    std::function<void()> release_callback;
+    /** Offset of the message within mr's registered range; nonzero only for
+     * zero-copy sends from the middle of a user-owned arena. */
+    size_t mr_offset = 0;
 
     MessageBuffer() {}
-    MessageBuffer(size_t size) {
+    MessageBuffer(size_t size) : capacity(size) {
         if(size != 0) {
-            buffer = std::unique_ptr<char[]>(new char[size]);
+            char* raw_buffer = nullptr;
+            if(getConfBoolean(CONF_DERECHO_USE_HUGEPAGES)) {
+                raw_buffer = try_hugepage_alloc(size);
+            }
+            if(raw_buffer != nullptr) {
+                buffer = {raw_buffer, [size](char* buf) { hugepage_free(buf, size); }};
+            } else {
+                buffer = {new char[size], [](char* buf) { delete[] buf; }};
+            }
+            bind_to_numa_node(buffer.get(), size, getConfInt32(CONF_DERECHO_SST_NUMA_NODE));
             mr = std::make_shared<rdma::memory_region>(buffer.get(), size);
         }
     }
+    /**
+     * Wraps a user-owned, already-registered buffer for a zero-copy send,
+     * without allocating or copying anything: the message occupies
+     * user_mr->buffer + offset, and release_cb is invoked when the message
+     * is retired and the bytes belong to the user again.
+     */
+    MessageBuffer(std::shared_ptr<rdma::memory_region> user_mr, size_t offset,
+                  std::function<void()> release_cb)
+            : buffer(user_mr->buffer + offset, [](char*) {}),
+              mr(std::move(user_mr)),
+              release_callback(std::move(release_cb)),
+              mr_offset(offset) {}
     MessageBuffer(const MessageBuffer&) = delete;
     MessageBuffer(MessageBuffer&&) = default;
     MessageBuffer& operator=(const MessageBuffer&) = delete;
     MessageBuffer& operator=(MessageBuffer&&) = default;
 };
 
+/**
+ * A process-wide pool of MessageBuffers, bucketed into power-of-two size
+ * classes. MulticastGroups draw buffers from the pool on demand and return
+ * them when messages are delivered or when a group is torn down, so the
+ * buffers -- and, more importantly, their RDMA memory registrations -- are
+ * retained across view changes instead of being deregistered and recreated
+ * per subgroup. Subgroups with similar max_msg_size values share the same
+ * size class, so the pool's footprint tracks actual concurrent demand
+ * rather than window_size x num_members x max_msg_size per subgroup.
+ */
+class MessageBufferPool {
+    static std::mutex pool_mutex;
+    /** Free buffers, keyed by their size class (a power of two) */
+    static std::map<size_t, std::vector<MessageBuffer>> free_buffers;
+
+public:
+    /** Rounds a requested size up to its size class: the next power of two. */
+    static size_t size_class(size_t size);
+    /**
+     * Gets a buffer whose capacity is at least the requested size, reusing a
+     * pooled one when available and allocating (and RDMA-registering) a new
+     * one otherwise.
+     */
+    static MessageBuffer get(size_t size);
+    /** Returns a buffer to the pool. Empty (default-constructed) buffers are
+     * silently dropped. */
+    static void give_back(MessageBuffer&& buffer);
+    /**
+     * Ensures at least count free buffers exist in the given size's class,
+     * allocating, registering, and touching every page of any that are
+     * missing. Used by the startup warm-up (DERECHO/warmup_on_startup) so the
+     * first sends after a group is constructed pay neither registration nor
+     * page-fault costs.
+     */
+    static void prefault(size_t size, size_t count);
+    /** Prints the number of pooled buffers in each size class. */
+    static void debug_print();
+};
+
 /**
  * A structure containing an RDMC message (which consists of some bytes in a
  * registered memory region) and some associated metadata. Note that the
@@ -202,6 +437,11 @@ struct RDMCMessage {
     long long unsigned int size;
     /** The MessageBuffer that contains the message's body. */
     MessageBuffer message_buffer;
+    /** True if this is a cooked message for an order-insensitive RPC function
+     * whose handler was already invoked on local receipt; delivery still
+     * assigns a version and issues stability callbacks, but must not invoke
+     * the handler a second time. */
+    bool delivered_early = false;
 };
 
 struct SSTMessage {
@@ -213,6 +453,11 @@ struct SSTMessage {
     long long unsigned int size;
     /** Pointer to the message */
     volatile char* buf;
+    /** True if this is a cooked message for an order-insensitive RPC function
+     * whose handler was already invoked on local receipt; delivery still
+     * assigns a version and issues stability callbacks, but must not invoke
+     * the handler a second time. */
+    bool delivered_early = false;
 };
 
 /**
@@ -229,6 +474,9 @@ struct SubgroupSettings {
     std::vector<node_id_t> members;
     /** The "is_sender" flags for members of the subgroup */
     std::vector<int> senders;
+    /** The "is_standby" flags for members of the subgroup; standby members
+     * receive multicasts but do not count toward stability or persistence */
+    std::vector<int> standbys;
     /** This node's sender rank within the subgroup (as defined by SubView::sender_rank_of) */
     int sender_rank;
     /** The offset of this node's num_received counter within the subgroup's SST section */
@@ -264,30 +512,170 @@ private:
     const std::map<subgroup_id_t, SubgroupSettings> subgroup_settings_map;
     /** Used for synchronizing receives by RDMC and SST */
     std::vector<std::list<int32_t>> received_intervals;
+    /** Local cursor over each sender's SMC slot ring, indexed like
+     * num_received_sst: the ring sequence of the last slot drained into
+     * locally_stable_sst_messages. Delivery is in place (SSTMessage keeps a
+     * pointer into the slot), so the shared num_received_sst column -- which
+     * is what lets the sender recycle a slot -- deliberately lags this
+     * cursor and is only advanced when the drained message is delivered and
+     * its slot bytes are dead. */
+    std::vector<int32_t> num_received_sst_drained;
     /** Maps subgroup IDs for which this node is a sender to the RDMC group it should use to send.
      * Constructed incrementally in create_rdmc_sst_groups(), so it can't be const.  */
     std::map<subgroup_id_t, uint32_t> subgroup_to_rdmc_group;
     /** These two callbacks are internal, not exposed to clients, so they're not in CallbackSet */
     rpc_handler_t rpc_callback;
+    /** Asks the RPC layer whether a cooked message targets a function marked
+     * order-insensitive (with the ORDER_INSENSITIVE_TAGS macro), in which case
+     * its handler is invoked on local receipt instead of at the message's
+     * place in the global delivery order. */
+    rpc_order_query_t rpc_order_insensitive_query;
+
+    /** Maximum size of a complete reply message (header included) that can be
+     * piggybacked in the SST instead of consuming a P2P_REPLY slot; 0 disables
+     * the piggyback lane. From DERECHO/piggyback_reply_payload_size. */
+    const uint64_t piggyback_reply_max_size;
+    /** Number of piggybacked replies that may be in flight to each
+     * destination. From DERECHO/piggyback_reply_window_size. */
+    const uint32_t piggyback_reply_window;
+    /** Count of piggybacked replies written to each destination's slot ring,
+     * indexed by SST rank. */
+    std::vector<uint64_t> piggyback_replies_sent;
+    /** Count of piggybacked replies consumed from each sender's slot ring,
+     * indexed by SST rank. Only read by the predicate thread. */
+    std::vector<uint64_t> piggyback_replies_consumed;
+    /** Serializes writers into the local row's piggyback slot rings. */
+    std::mutex piggyback_mutex;
 
     /** Offset to add to member ranks to form RDMC group numbers. */
     uint16_t rdmc_group_num_offset;
     /** false if RDMC groups haven't been created successfully */
     bool rdmc_sst_groups_created = false;
-    /** Stores message buffers not currently in use. Protected by
-     * msg_state_mtx */
-    std::map<uint32_t, std::vector<MessageBuffer>> free_message_buffers;
+
+    /** Describes one RDMC group this MulticastGroup created or adopted, with
+     * enough of its creation parameters to decide whether the next view's
+     * MulticastGroup can migrate it instead of rebuilding it. */
+    struct RDMCGroupInfo {
+        uint16_t group_number;
+        std::vector<uint32_t> rotated_members;
+        size_t block_size;
+        rdmc::send_algorithm algorithm;
+    };
+    /** The RDMC groups live in this MulticastGroup, keyed by
+     * (subgroup number, sender ID). Built by create_rdmc_sst_groups(). */
+    std::map<std::pair<subgroup_id_t, node_id_t>, RDMCGroupInfo> rdmc_groups_created;
+    /** RDMC groups inherited from the previous view's MulticastGroup during a
+     * transition. create_rdmc_sst_groups() migrates any whose shard
+     * membership and profile are unchanged, re-keying them under this view's
+     * group numbers with fresh receive handlers; the rest are left for the
+     * old group's destructor to tear down. */
+    std::map<std::pair<subgroup_id_t, node_id_t>, RDMCGroupInfo> prior_rdmc_groups;
 
     /** Index to be used the next time get_sendbuffer_ptr is called.
      * When next_message is not none, then next_message.index = future_message_index-1 */
     std::vector<message_id_t> future_message_indices;
 
+    /**
+     * Runtime-adaptive send window state for one subgroup. The physical slot
+     * ring (and thus the wire format and all slot arithmetic) stays at the
+     * profile's window_size, which acts as a preallocated maximum; only the
+     * sender-side admission check in get_sendbuffer_ptr consults the
+     * effective window, so shrinking it simply makes this sender block
+     * earlier. The window doubles each time the admission check blocks a
+     * send, so a burst reaches the full pipeline depth within a handful of
+     * retries, and halves when an adjustment interval passes with the
+     * observed sent-vs-stable gap well below it. Guarded by msg_state_mtx,
+     * like the rest of the message state.
+     */
+    struct AdaptiveSendWindow {
+        /** Smallest depth the window will shrink to. */
+        static constexpr uint32_t min_window = 2;
+        /** Number of admitted sends between shrink decisions. */
+        static constexpr uint32_t adjust_interval = 64;
+        /** How many message indices this sender may currently run ahead of
+         * global stability; always <= the profile's window_size. */
+        uint32_t effective_window = 0;
+        /** Largest sent-vs-stable gap observed since the last adjustment. */
+        uint32_t peak_occupancy = 0;
+        /** Sends admitted since the last shrink decision. */
+        uint32_t sends_since_adjust = 0;
+    };
+    /** Adaptive send window state, indexed by subgroup number. Entries for
+     * subgroups this node does not send in stay at their default values. */
+    std::vector<AdaptiveSendWindow> adaptive_send_windows;
+
+    /**
+     * Runtime-tuned SMC/RDMC crossover for one subgroup. Both transports are
+     * kept warm per subgroup, so the choice of medium is per message; the
+     * only hard constraint is the SST slot width (a message larger than
+     * sst_max_msg_size can never go over SMC). Within that limit the cheaper
+     * medium depends on the workload, so the selector tracks the
+     * send-to-delivery latency this sender observes on each medium for
+     * messages near the current crossover and nudges the crossover toward
+     * whichever medium is winning there. The crossover is clamped to
+     * [sst_max_msg_size / crossover_floor_divisor, sst_max_msg_size]: the
+     * upper clamp is the slot width, and the lower clamp keeps genuinely
+     * small messages on the low-latency SMC path no matter what the
+     * borderline sizes measure. Delivery ordering is unaffected, since the
+     * sequence number, not the medium, orders delivery. Guarded by
+     * msg_state_mtx, like the rest of the message state.
+     */
+    struct AdaptiveMediumSelector {
+        /** Lower clamp for the crossover, as a divisor of sst_max_msg_size. */
+        static constexpr uint64_t crossover_floor_divisor = 8;
+        /** Latency samples between crossover adjustments. */
+        static constexpr uint32_t adjust_interval = 64;
+        /** Messages at or below this size go over SMC, larger ones over
+         * RDMC. Initialized to the profile's sst_max_msg_size (the static
+         * behavior); 0 means SMC is disabled and nothing is tuned. */
+        uint64_t crossover = 0;
+        /** EWMA (ns) of send-to-delivery latency per medium, over messages
+         * near the crossover; 0 until the first sample. */
+        uint64_t smc_latency_ewma = 0;
+        uint64_t rdmc_latency_ewma = 0;
+        /** Samples recorded since the last crossover adjustment. */
+        uint32_t samples_since_adjust = 0;
+    };
+    /** Adaptive medium selection state, indexed by subgroup number. */
+    std::vector<AdaptiveMediumSelector> adaptive_medium_selectors;
+
+    /** Applications' send-credit callbacks (see set_send_credits_callback),
+     * indexed by subgroup number. Guarded by msg_state_mtx. */
+    std::vector<std::function<void()>> send_credits_callbacks;
+
+    /** Partially reassembled fragmented messages, keyed by (subgroup number,
+     * sender ID). A sender's fragments arrive in delivery order and trains
+     * from the same sender never interleave, so appending suffices. Guarded
+     * by msg_state_mtx. */
+    std::map<std::pair<subgroup_id_t, node_id_t>, std::vector<char>> fragment_reassembly;
+    /** Reassembled payloads handed to the batch stability callback must
+     * outlive the batch they are part of; they are parked here and freed by
+     * flush_delivery_batch. Guarded by msg_state_mtx. */
+    std::vector<std::vector<char>> delivered_fragment_buffers;
+    /** Serializes this node's fragment trains: interleaved trains from the
+     * same sender would corrupt reassembly at the receivers. */
+    std::mutex fragmented_send_mtx;
+
+    /** For subgroups with null_send_suppression: the first index of the
+     * current run of suppressed null messages, or -1 when the last message
+     * that took an index was a real one. Indexed by subgroup number. */
+    std::vector<int32_t> first_suppressed_null_index;
+    /** For subgroups without null_send_suppression: the future-index target
+     * of an auto-null catch-up that stopped on a full SMC slot ring, or -1.
+     * Slots free up when their messages are delivered, so delivery_trigger
+     * retries these. Indexed by subgroup number; guarded by msg_state_mtx. */
+    std::vector<int32_t> deferred_auto_null_targets;
+
     /** next_message is the message that will be sent when send is called the next time.
      * It is std::nullopt when there is no message to send. */
     std::vector<std::optional<RDMCMessage>> next_sends;
     std::map<uint32_t, bool> pending_sst_sends;
-    /** Messages that are ready to be sent, but must wait until the current send finishes. */
-    std::vector<std::queue<RDMCMessage>> pending_sends;
+    /** Messages that are ready to be sent, but must wait until the current
+     * send finishes. Lock-free so producers in send() never contend with the
+     * sender thread on msg_state_mtx for the handoff itself; sender_cv is
+     * only used to wake the sender thread when it has gone idle. Occupancy
+     * is bounded by the subgroup's send window, well under the ring size. */
+    std::vector<MPSCRingQueue<RDMCMessage>> pending_sends;
     /** Vector of messages that are currently being sent out using RDMC, or boost::none otherwise. */
     /** one per subgroup */
     std::vector<std::optional<RDMCMessage>> current_sends;
@@ -316,8 +704,22 @@ private:
     /** The time, in milliseconds, that a sender can wait to send a message before it is considered failed. */
     unsigned int sender_timeout;
 
+    /** True if delivery triggers run on the SST's trigger offload executor
+     * (DERECHO/trigger_offload_threads > 0) instead of inline on the detect
+     * thread. Each subgroup's deliveries go to the lane keyed by its subgroup
+     * number, so per-subgroup delivery order is preserved while subgroups on
+     * different lanes deliver in parallel. */
+    bool delivery_offloaded;
+
     /** Indicates that the group is being destroyed. */
     std::atomic<bool> thread_shutdown{false};
+    /** Set by drain_sends() during a graceful leave: new sends are refused
+     * while already-queued messages are flushed and delivered. */
+    std::atomic<bool> draining{false};
+    /** Subgroups wedged early by wedge_subgroups_containing() because a
+     * suspected node is in their shard; new sends to them are refused while
+     * the other subgroups keep running. Guarded by msg_state_mtx. */
+    std::set<subgroup_id_t> wedged_subgroups;
     /** The background thread that sends messages with RDMC. */
     std::thread sender_thread;
 
@@ -352,12 +754,23 @@ private:
     uint64_t get_time();
 
     /** Checks for failures when a sender reaches its timeout. This function
-     * implements the timeout thread. */
+     * implements the timeout thread. Heartbeat probes are paced adaptively:
+     * the probe interval stretches with group size so cluster-wide probe
+     * traffic grows linearly rather than quadratically, and ticks where data
+     * pushes already exercised the connections skip the probe entirely. */
     void check_failures_loop();
 
     bool create_rdmc_sst_groups();
     void initialize_sst_row();
     void register_predicates();
+    /**
+     * Pre-stocks the MessageBufferPool with every RDMC-mode subgroup's
+     * steady-state buffer demand, so the first sends and receives after this
+     * group starts find warm, registered buffers instead of paying an
+     * allocation and registration on the critical path. Runs in both
+     * constructors when DERECHO/warmup_on_startup is set; a no-op otherwise.
+     */
+    void prefault_message_buffers();
 
     /**
      * Delivers a single message to the application layer, either by invoking
@@ -380,6 +793,21 @@ private:
     void deliver_message(SSTMessage& msg, const subgroup_id_t& subgroup_num,
         const persistent::version_t& version, const uint64_t& msg_timestamp);
 
+    /**
+     * Messages accumulated for the client's batch_stability_callback during
+     * one delivery event. Only accessed while holding msg_state_mtx, which
+     * also keeps the referenced message buffers from being recycled until
+     * the batch has been flushed.
+     */
+    std::vector<DeliveredMessage> current_delivery_batch;
+
+    /**
+     * Invokes the client's batch_stability_callback with all messages
+     * accumulated since the last flush, if there are any. Must be called
+     * with msg_state_mtx held, at the end of each delivery event.
+     */
+    void flush_delivery_batch();
+
     /**
      * Enqueues a single message for persistence with the persistence manager.
      * Note that this does not actually wait for the message to be persisted;
@@ -430,20 +858,109 @@ private:
                              uint32_t num_shard_senders, uint32_t sender_rank,
                              volatile char* data, uint64_t size);
 
+    /** Dedicated receive handler for UNORDERED (raw) subgroups, bound in
+     * place of sst_receive_handler at predicate registration time. In the
+     * common case (unfragmented message arriving in per-sender order with
+     * nothing stashed) it hands the slot bytes straight to the stability
+     * callback: no cooked-send or RPC-framing checks, no stash-map insert
+     * and erase. Out-of-order or fragmented arrivals fall back to the
+     * general handler. */
+    void raw_sst_receive_handler(subgroup_id_t subgroup_num, const SubgroupSettings& subgroup_settings,
+                                 const std::map<uint32_t, uint32_t>& shard_ranks_by_sender_rank,
+                                 uint32_t num_shard_senders, uint32_t sender_rank,
+                                 volatile char* data, uint64_t size);
+
     bool receiver_predicate(const SubgroupSettings& subgroup_settings,
                             const std::map<uint32_t, uint32_t>& shard_ranks_by_sender_rank,
                             uint32_t num_shard_senders, const DerechoSST& sst);
 
+    /** The receiver predicate's trigger: drains every ready SMC slot from
+     * every sender in one pass, then recomputes num_received, seq_num, and
+     * delivery eligibility once over the whole batch with a single coalesced
+     * SST push. */
     void receiver_function(subgroup_id_t subgroup_num, const SubgroupSettings& subgroup_settings,
                            const std::map<uint32_t, uint32_t>& shard_ranks_by_sender_rank,
-                           uint32_t num_shard_senders, DerechoSST& sst, unsigned int batch_size,
+                           uint32_t num_shard_senders,
+                           const std::vector<uint32_t>& shard_sst_indices, DerechoSST& sst,
                            const std::function<void(uint32_t, volatile char*, uint32_t)>& sst_receive_handler_lambda);
 
-    // Internally used to automatically send a NULL message
-    void get_buffer_and_send_auto_null(subgroup_id_t subgroup_num);
+    /** Internally used to automatically send a NULL message. Returns false
+     * if the null went over SMC and the slot ring was full (every slot still
+     * holds an undelivered message); the caller should stop and retry on the
+     * next receive event. */
+    bool get_buffer_and_send_auto_null(subgroup_id_t subgroup_num);
+    /** Advances this sender's message index past a run of null messages by
+     * publishing the suppressed interval in the SST instead of sending them.
+     * The caller must hold msg_state_mtx. */
+    void suppress_auto_null_sends(subgroup_id_t subgroup_num, const SubgroupSettings& subgroup_settings,
+                                  int32_t target_future_index);
+    /** True when some sender in the subgroup has published a suppressed-null
+     * interval this node has not yet counted as received. */
+    bool suppressed_nulls_predicate(const SubgroupSettings& subgroup_settings,
+                                    const std::map<uint32_t, uint32_t>& shard_ranks_by_sender_rank,
+                                    uint32_t num_shard_senders, const DerechoSST& sst);
+    /** Counts published suppressed-null intervals as received and advances
+     * seq_num, mirroring what the arrival of real null messages would do. */
+    void apply_suppressed_nulls(subgroup_id_t subgroup_num, const SubgroupSettings& subgroup_settings,
+                                const std::map<uint32_t, uint32_t>& shard_ranks_by_sender_rank,
+                                uint32_t num_shard_senders,
+                                const std::vector<uint32_t>& shard_sst_indices, DerechoSST& sst);
+    /** True when some member's piggyback slot ring contains a reply for this
+     * node that has not yet been consumed. */
+    bool piggyback_replies_predicate(const DerechoSST& sst);
+    /** Hands each newly arrived piggybacked reply to the RPC layer via
+     * rpc_callback, then acknowledges it to the sender so the slot can be
+     * reused. */
+    void deliver_piggybacked_replies(DerechoSST& sst);
     /* Get a pointer into the current buffer, to write data into it before sending
      * Now this is a private function, called by send internally */
-    char* get_sendbuffer_ptr(subgroup_id_t subgroup_num, long long unsigned int payload_size, bool cooked_send);
+    char* get_sendbuffer_ptr(subgroup_id_t subgroup_num, long long unsigned int payload_size, bool cooked_send,
+                             FragmentState fragment_state = FragmentState::COMPLETE);
+    /** The pre-fragmentation body of send: sends one message that fits in a
+     * window slot, blocking until the window has room. */
+    bool send_single(subgroup_id_t subgroup_num, long long unsigned int payload_size,
+                     const std::function<void(char* buf)>& msg_generator, bool cooked_send,
+                     FragmentState fragment_state);
+    /** Sends a payload larger than the subgroup's maximum message size as a
+     * train of fragments (see FragmentState). The message generator runs
+     * once, into a temporary contiguous buffer; each receiver reassembles
+     * the train and delivers it as a single message. Fragments cut off by a
+     * view change are discarded, so a fragmented message is delivered if and
+     * only if its last fragment is. */
+    bool send_fragmented(subgroup_id_t subgroup_num, long long unsigned int payload_size,
+                         const std::function<void(char* buf)>& msg_generator, bool cooked_send);
+    /** Non-blocking counterpart of send_fragmented: starts a train only when
+     * current send credits cover every fragment (a train cannot be aborted
+     * once started). Payloads needing more fragments than the window holds
+     * always fail; use the blocking send for those. */
+    bool try_send_fragmented(subgroup_id_t subgroup_num, long long unsigned int payload_size,
+                             const std::function<void(char* buf)>& msg_generator, bool cooked_send);
+    /** Computes the number of this node's messages in the given subgroup that
+     * have been sent (or had indices assigned) but are not yet stable on
+     * every shard member. Must be called with msg_state_mtx held; assumes
+     * this node is a sender in the subgroup. */
+    int32_t compute_send_occupancy(subgroup_id_t subgroup_num, const SubgroupSettings& subgroup_settings);
+    /** The adaptive-send-window admission check shared by get_sendbuffer_ptr
+     * and send_zero_copy: returns false (after growing the window if it can)
+     * when admitting another message would exceed the effective window, and
+     * updates the window statistics when it admits. Must be called with
+     * msg_state_mtx held. */
+    bool admit_to_send_window(subgroup_id_t subgroup_num, const SubgroupSettings& subgroup_settings);
+    /** Common tail of send and try_send: records the message prepared by
+     * get_sendbuffer_ptr and hands it to the sender thread or the SST
+     * multicast. Must be called with msg_state_mtx held. */
+    bool finish_send(subgroup_id_t subgroup_num);
+    /** The current SMC/RDMC crossover size for a subgroup: messages at or
+     * below it go over SMC, larger ones over RDMC. Equal to the profile's
+     * sst_max_msg_size until the adaptive selector has moved it. Must be
+     * called with msg_state_mtx held. */
+    uint64_t medium_crossover(subgroup_id_t subgroup_num, const DerechoParams& profile) const;
+    /** Feeds one send-to-delivery latency observation for a message this
+     * node sent into the subgroup's adaptive medium selector, and adjusts
+     * the crossover once enough samples have accumulated. Must be called
+     * with msg_state_mtx held. */
+    void record_medium_latency(subgroup_id_t subgroup_num, bool via_rdmc,
+                               uint64_t latency_ns, uint64_t msg_size);
 
 public:
     /**
@@ -494,18 +1011,109 @@ public:
      * @param handler A function that will handle RPC messages.
      */
     void register_rpc_callback(rpc_handler_t handler) { rpc_callback = std::move(handler); }
+    void register_rpc_order_insensitive_query(rpc_order_query_t query) { rpc_order_insensitive_query = std::move(query); }
+
+    /**
+     * Attempts to send a complete RPC reply message through the SST piggyback
+     * lane instead of a p2p send. Fails (returning false, with nothing
+     * written) if piggybacking is disabled, the message is too large, the
+     * destination is not in this group's SST, or the destination's slot ring
+     * is full; the caller should then fall back to a normal p2p reply.
+     * @param dest_id The node ID of the reply's destination
+     * @param reply_msg The complete reply message, including the RPC header
+     * @param size The size of the reply message in bytes
+     * @return true if the reply was written into the SST piggyback lane
+     */
+    bool try_piggyback_reply(node_id_t dest_id, char* reply_msg, uint32_t size);
 
     void deliver_messages_upto(const std::vector<int32_t>& max_indices_for_senders, subgroup_id_t subgroup_num, uint32_t num_shard_senders);
     /** Send now internally calls get_sendbuffer_ptr.
-	The user function that generates the message is supplied to send */
+	The user function that generates the message is supplied to send.
+	Payloads larger than the profile's maximum message size are
+	transparently split into a train of fragments and delivered to the
+	receivers' callbacks as a single reassembled message. */
     bool send(subgroup_id_t subgroup_num, long long unsigned int payload_size,
               const std::function<void(char* buf)>& msg_generator, bool cooked_send);
+    /**
+     * Non-blocking variant of send: makes a single attempt to claim a slot in
+     * the subgroup's send window, and returns false without calling
+     * msg_generator if the window is full (or a previous send is still in
+     * flight). Callers can use this with get_send_credits and
+     * set_send_credits_callback to apply backpressure upstream instead of
+     * blocking inside Derecho.
+     */
+    bool try_send(subgroup_id_t subgroup_num, long long unsigned int payload_size,
+                  const std::function<void(char* buf)>& msg_generator, bool cooked_send);
+    /**
+     * Sends a raw multicast directly from a user-owned, pre-registered memory
+     * region, skipping the staging copy into an internal buffer: the send
+     * queue references the user's bytes, RDMC transmits them in place, and
+     * release_callback is invoked once the message is retired (delivered, or
+     * discarded by a view change) and the buffer belongs to the caller again.
+     * The message occupies [offset, offset + sizeof(header) + payload_size)
+     * within the region: the first sizeof(header) bytes are overwritten with
+     * the multicast header, and the payload must already sit after them. The
+     * caller must not touch those bytes until release_callback runs; the
+     * callback is invoked from internal threads with locks held, so it must
+     * not call back into send paths. Only supported in UNORDERED (raw)
+     * subgroups, and always transmitted over RDMC regardless of size. Blocks
+     * until the send window admits the message; returns false if the
+     * subgroup wedges first (the callback is then never invoked and the
+     * buffer is immediately the caller's).
+     */
+    bool send_zero_copy(subgroup_id_t subgroup_num, std::shared_ptr<rdma::memory_region> user_mr,
+                        size_t offset, long long unsigned int payload_size,
+                        std::function<void()> release_callback);
+    /**
+     * Returns the number of messages this node can currently send in the
+     * given subgroup before the send window fills and sends would block,
+     * i.e. the effective send window minus the in-flight message count.
+     * Returns 0 if this node is not a sender in the subgroup. The value is a
+     * snapshot: concurrent receives can add credits at any time, and only
+     * this node's own sends consume them.
+     */
+    int32_t get_send_credits(subgroup_id_t subgroup_num);
+    /**
+     * Registers a function to be called when delivery progress in the given
+     * subgroup may have freed send-window credits. The callback is advisory
+     * (credits may still be 0 when it runs, and remote-only progress does not
+     * trigger it); it runs on the SST predicate thread with internal locks
+     * held, so it should do no more than signal the application's sender,
+     * though calling try_send from it is safe. Pass nullptr to deregister.
+     * Callbacks carry over to the next view's MulticastGroup on a view
+     * change, matching subgroups by ID.
+     */
+    void set_send_credits_callback(subgroup_id_t subgroup_num, std::function<void()> callback);
     bool check_pending_sst_sends(subgroup_id_t subgroup_num);
 
     const uint64_t compute_global_stability_frontier(subgroup_id_t subgroup_num);
 
     /** Stops all sending and receiving in this group, in preparation for shutting it down. */
     void wedge();
+    /**
+     * Drains this node's multicasts to a clean cut, for a graceful leave:
+     * refuses any further sends, flushes every already-queued message, and
+     * then waits until every voting shard member has delivered (or, in
+     * UNORDERED mode, received) the last message this node sent in each
+     * subgroup it sends in. After a successful drain, a view change that
+     * removes this node has nothing of this node's to trim. Does not wedge
+     * or tear anything down; the caller remains responsible for that.
+     * @param timeout_ms Bound on the total wait, in milliseconds.
+     * @return True if the clean cut was reached, false if the timeout
+     * expired first (e.g. because another shard member failed mid-drain).
+     */
+    bool drain_sends(uint64_t timeout_ms);
+    /**
+     * Wedges only the subgroups whose shard membership contains one of the
+     * listed failed nodes: new sends to those subgroups are refused, while
+     * sending and delivery in unaffected subgroups continue. Called when a
+     * failure is first suspected, so that a membership change in one shard
+     * does not stall every other subgroup for the whole reconfiguration;
+     * the full wedge() still happens once the view change commits.
+     */
+    void wedge_subgroups_containing(const std::vector<node_id_t>& failed_members);
+    /** Returns true if the given subgroup was wedged by wedge_subgroups_containing(). */
+    bool subgroup_is_wedged(subgroup_id_t subgroup_num);
     /** Debugging function; prints the current state of the SST to stdout. */
     void debug_print();
 
@@ -517,5 +1125,13 @@ public:
         return subgroup_settings_map;
     }
     std::vector<uint32_t> get_shard_sst_indices(subgroup_id_t subgroup_num);
+    /**
+     * Like get_shard_sst_indices, but excludes standby members of the shard,
+     * except for the local node's own row. This is the set of rows that
+     * stability and persistence decisions are computed over; a standby keeps
+     * its own row in the set so its local delivery never runs ahead of its
+     * own contiguous receipt.
+     */
+    std::vector<uint32_t> get_voting_sst_indices(subgroup_id_t subgroup_num);
 };
 }  // namespace derecho
@@ -4,6 +4,7 @@
 #include <iostream>
 #include <map>
 #include <memory>
+#include <mutex>
 #include <optional>
 #include <thread>
 #include <vector>
@@ -20,32 +21,69 @@ class P2PConnectionManager;
 enum REQUEST_TYPE {
     P2P_REPLY = 0,
     P2P_REQUEST,
-    RPC_REPLY
+    RPC_REPLY,
+    /** Overflow lane for p2p requests larger than the small-request slots.
+     * Only allocated when DERECHO/p2p_small_request_payload_size is set;
+     * senders are routed here automatically by reserve_slot. */
+    P2P_LARGE_REQUEST
 };
 static const REQUEST_TYPE p2p_request_types[] = {P2P_REPLY,
                                                  P2P_REQUEST,
-                                                 RPC_REPLY};
-static const uint8_t num_request_types = 3;
+                                                 RPC_REPLY,
+                                                 P2P_LARGE_REQUEST};
+static const uint8_t num_request_types = 4;
+
+/** Selects which lanes probe() scans: the shallow small-message rings
+ * (everything except P2P_LARGE_REQUEST), the deep bulk ring, or all of them.
+ * The receive loop uses this to drain small messages ahead of bulk traffic. */
+enum LANE_CLASS {
+    SMALL_LANES,
+    BULK_LANE,
+    ALL_LANES
+};
 
 struct RequestParams {
     uint32_t window_sizes[num_request_types];
     uint32_t max_msg_sizes[num_request_types];
     uint64_t offsets[num_request_types];
+    /** Offset of the one-sided query snapshot region, which sits between the
+     * request-type windows and the doorbell counter. */
+    uint64_t query_snapshot_offset;
+    /** Maximum snapshot payload size; 0 means no snapshot region exists. */
+    uint64_t query_snapshot_size;
 };
 
 class P2PConnection {
     const uint32_t my_node_id;
     const uint32_t remote_id;
     const RequestParams& request_params;
+    /** Offset of the doorbell counter, which sits between the request-type
+     * windows and the trailing heartbeat byte in both buffers. */
+    const uint64_t doorbell_offset;
     std::unique_ptr<volatile char[]> incoming_p2p_buffer;
     std::unique_ptr<volatile char[]> outgoing_p2p_buffer;
     std::unique_ptr<resources> res;
     std::map<REQUEST_TYPE, std::atomic<uint64_t>> incoming_seq_nums_map, outgoing_seq_nums_map;
-    REQUEST_TYPE prev_mode;
     REQUEST_TYPE last_type;
+    /** Number of requests reserved but not yet answered by a consumed reply;
+     * bounds slot reuse on the request lanes. Maintained with atomic
+     * increments at reservation and decrements when replies are consumed, so
+     * reservation needs no lock. */
+    std::atomic<int64_t> outstanding_request_count{0};
+    /** Number of messages this node has sent on this connection; its value is
+     * RDMA-written to the remote doorbell after each message's seq num. */
+    std::atomic<uint64_t> outgoing_doorbell{0};
+    /** Number of incoming messages consumed locally, compared against the
+     * remote sender's doorbell to decide whether probing can be skipped. */
+    uint64_t consumed_incoming = 0;
+    /** Version of the last snapshot published into this connection's buffer;
+     * written as both the head and tail word of the snapshot region. */
+    uint64_t snapshot_version = 0;
+    /** Serializes fetch_query_snapshot calls, which share one landing area. */
+    std::mutex snapshot_fetch_mutex;
     uint64_t getOffsetSeqNum(REQUEST_TYPE type, uint64_t seq_num);
     uint64_t getOffsetBuf(REQUEST_TYPE type, uint64_t seq_num);
-    
+
 protected:
     friend class P2PConnectionManager;
     resources* get_res();
@@ -53,11 +91,65 @@ protected:
 public:
     P2PConnection(uint32_t my_node_id, uint32_t remote_id, uint64_t p2p_buf_size, const RequestParams& request_params);
     ~P2PConnection();
-    
-    char* probe();
+
+    /** True if the sender's doorbell has advanced past the number of messages
+     * consumed here, i.e. a probe() might find something. A single-cache-line
+     * read, so the receive loop can sweep many idle connections cheaply. */
+    bool has_incoming_data();
+    /** Returns a pointer to the next unconsumed incoming message on one of
+     * the selected lanes, or nullptr if they are all empty. Lanes are scanned
+     * in REQUEST_TYPE order, so within a single probe a ready reply always
+     * wins over a ready request. */
+    char* probe(LANE_CLASS lanes = ALL_LANES);
     void update_incoming_seq_num();
-    char* get_sendbuffer_ptr(REQUEST_TYPE type);
-    void send();
-    
+    /**
+     * An outgoing ring slot reserved by reserve_slot(). The reserving caller
+     * owns buf exclusively and may serialize into it up to the lane's
+     * maximum message size (minus the trailing guard word), then must hand
+     * the slot to post(). The remote side consumes a lane's slots in
+     * sequence-number order, so a reserved-but-unposted slot delays the
+     * visibility of slots reserved after it on the same lane.
+     */
+    struct SendSlot {
+        REQUEST_TYPE type;
+        uint64_t seq_num;
+        char* buf;
+    };
+    /**
+     * Reserves the next outgoing slot of the given type, lock-free, so
+     * concurrent senders to the same node do not serialize on a mutex. For
+     * P2P_REQUEST, msg_size routes oversized messages to the large-request
+     * lane when one is configured; 0 (the default) always uses the type's
+     * own ring. Returns std::nullopt if the request window is full.
+     */
+    std::optional<SendSlot> reserve_slot(REQUEST_TYPE type, uint64_t msg_size = 0);
+    /**
+     * Reserves count consecutive slots of the given type for a burst, all at
+     * once. Returns an empty vector if the request window cannot fit the
+     * whole burst; it never partially succeeds.
+     */
+    std::vector<SendSlot> reserve_slots(REQUEST_TYPE type, std::size_t count, uint64_t msg_size = 0);
+    /**
+     * Publishes a reserved slot to the remote node: posts the slot's data,
+     * then its sequence guard word, then the doorbell, relying on in-order
+     * delivery within the connection. Safe to call concurrently for
+     * different slots.
+     */
+    void post(const SendSlot& slot);
+
+    /** Writes a new snapshot into the remotely-readable buffer's snapshot
+     * region, seqlock-style: the head version word is bumped first, then the
+     * size and payload are copied, then the tail version word is published.
+     * A remote read that overlaps the update sees head != tail and retries.
+     * May only be called when the snapshot region is configured, with size at
+     * most query_snapshot_size. */
+    void publish_query_snapshot(const char* data, uint64_t size);
+    /** Fetches the remote node's current snapshot with a one-sided RDMA read,
+     * without involving the remote CPU. Blocks (spinning) until a consistent
+     * snapshot lands or the SST poll timeout elapses. Returns false if the
+     * remote node has never published a snapshot or the read timed out;
+     * data_out must have room for query_snapshot_size bytes. */
+    bool fetch_query_snapshot(char* data_out, uint64_t& size_out);
+
 };
 }  // namespace sst
@@ -5,6 +5,7 @@
 #include <map>
 #include <memory>
 #include <optional>
+#include <set>
 #include <thread>
 #include <vector>
 #include <mutex>
@@ -25,36 +26,123 @@ struct P2PParams {
     uint64_t max_p2p_reply_size;
     uint64_t max_p2p_request_size;
     uint64_t max_rpc_reply_size;
+    /** Slot size for the common p2p request ring when tiering is enabled;
+     * 0 keeps the single-tier layout where every slot is max-sized. */
+    uint64_t small_p2p_request_size;
+    /** Number of slots in the large-request overflow lane (only used when
+     * small_p2p_request_size is nonzero). */
+    uint32_t large_request_window_size;
+    /** Size of the versioned query snapshot region in each p2p buffer, for
+     * serving read-only queries with one-sided RDMA reads; 0 disables it. */
+    uint64_t query_snapshot_size;
 };
 
 class P2PConnectionManager {
     const uint32_t my_node_id;
 
     RequestParams request_params;
-    // one element per member for P2P
+    // one element per member for P2P; only mutated at view changes, which
+    // the owner serializes against senders, so lookups need no lock
     std::map<uint32_t, std::unique_ptr<P2PConnection>> p2p_connections;
 
+    /**
+     * A connection created on first message rather than at view install,
+     * used for external clients: most clients only ever talk to a couple of
+     * nodes, so allocating every client's ring buffers up front wastes
+     * registered memory and setup time. These entries are guarded by
+     * connections_mutex and, unlike member connections, are torn down when
+     * idle for external_idle_timeout_ms and capped in number by
+     * max_external_connections (least recently used evicted first).
+     * Eviction drops any in-flight slots on the connection; external
+     * clients are expected to re-establish and retry.
+     */
+    struct OnDemandConnection {
+        std::unique_ptr<P2PConnection> connection;
+        /** Time of the last send, post, or received message, from get_time(). */
+        uint64_t last_used_ns;
+    };
+    std::map<uint32_t, OnDemandConnection> on_demand_connections;
+    /**
+     * Members of the current view whose connections are created lazily (see
+     * set_lazy_members). Their on-demand entries are exempt from the idle
+     * sweep and the LRU cap, since a member connection is expected to live
+     * for the rest of the view once it exists. Guarded by connections_mutex.
+     */
+    std::set<uint32_t> lazy_member_ids;
+    /** LRU cap on concurrent on-demand connections; 0 means no cap. */
+    uint32_t max_external_connections;
+    /** Idle teardown threshold for on-demand connections; 0 disables it. */
+    uint32_t external_idle_timeout_ms;
+
     uint64_t p2p_buf_size;
     std::atomic<bool> thread_shutdown{false};
     std::thread timeout_thread;
-    
+
     uint32_t last_node_id;
-    uint32_t num_rdma_writes = 0;
+    std::atomic<uint32_t> num_rdma_writes{0};
     void check_failures_loop();
+    /** Tears down on-demand connections idle longer than the timeout. */
+    void sweep_idle_connections();
+    /**
+     * Returns the on-demand entry for node_id, creating it (and evicting
+     * the least recently used entry if the cap is reached) when absent.
+     * Must be called with connections_mutex held.
+     */
+    OnDemandConnection& get_or_create_on_demand(uint32_t node_id);
 
     std::mutex connections_mutex;
 
+    /** The most recently published query snapshot, kept so it can be written
+     * into the buffers of connections created after it was published. */
+    std::vector<char> current_query_snapshot;
+
 public:
     P2PConnectionManager(const P2PParams params);
     ~P2PConnectionManager();
     void add_connections(const std::vector<uint32_t>& node_ids);
     void remove_connections(const std::vector<uint32_t>& node_ids);
+    /**
+     * Ensures an on-demand connection to node_id exists, allocating its
+     * buffers if this is the first contact. Called on the server side when
+     * an external client's handshake completes; the sender side creates its
+     * connection implicitly on the first reserve_slot. Member connections
+     * are unaffected.
+     */
+    void add_external_connection(uint32_t node_id);
+    /**
+     * Records the current view's members without creating connections to
+     * them (lazy member p2p mode): each member's connection is built
+     * on-demand by the first send to it, with the remote side triggered
+     * through its SST row. Replaces add_connections at view install.
+     */
+    void set_lazy_members(const std::vector<uint32_t>& node_ids);
+    /**
+     * Ensures a connection to node_id exists, building this side's buffers
+     * (and blocking in the memory-region exchange) if it does not. Called
+     * on the responding side of an on-demand handshake, for both external
+     * clients and lazy member connections.
+     */
+    void ensure_connection(uint32_t node_id);
+    /** True if a connection to node_id currently exists (either kind). */
+    bool contains_node(uint32_t node_id);
     void shutdown_failures_thread();
     uint64_t get_max_p2p_reply_size();
     void update_incoming_seq_num();
     std::optional<std::pair<uint32_t, char*>> probe_all();
-    char* get_sendbuffer_ptr(uint32_t node_id, REQUEST_TYPE type);
-    void send(uint32_t node_id);
+    /** Reserves an outgoing slot on the connection to node_id, lock-free; see
+     * P2PConnection::reserve_slot. Returns std::nullopt if the request window
+     * is full. */
+    std::optional<P2PConnection::SendSlot> reserve_slot(uint32_t node_id, REQUEST_TYPE type, uint64_t msg_size = 0);
+    /** Publishes a slot previously reserved on the connection to node_id; see
+     * P2PConnection::post. */
+    void post(uint32_t node_id, const P2PConnection::SendSlot& slot);
+    /** Publishes a new query snapshot into every connection's buffer, where
+     * remote nodes can fetch it with one-sided RDMA reads. May only be called
+     * when query_snapshot_size is configured, with size at most that value. */
+    void publish_query_snapshot(const char* data, uint64_t size);
+    /** Fetches the given node's current query snapshot with a one-sided RDMA
+     * read; see P2PConnection::fetch_query_snapshot. */
+    bool fetch_query_snapshot(uint32_t node_id, char* data_out, uint64_t& size_out);
     void debug_print();
 };
 }  // namespace sst
@@ -7,7 +7,11 @@
 
 #include <atomic>
 #include <chrono>
+#include <condition_variable>
 #include <errno.h>
+#include <map>
+#include <memory>
+#include <mutex>
 #include <queue>
 #include <semaphore.h>
 #include <thread>
@@ -38,6 +42,76 @@ private:
     /** lock for persistence request queue */
     std::atomic_flag prq_lock = ATOMIC_FLAG_INIT;
 
+    /**
+     * The callback-delivery thread. The persist thread(s) hand completed
+     * (subgroup, version) pairs to this thread instead of invoking
+     * persistence_callback inline, so a slow user callback never delays the
+     * next version's disk write. A single FIFO thread drains the queue, so
+     * callbacks for any one subgroup are delivered in version order.
+     */
+    std::thread callback_thread;
+    /** Signals the callback thread that a request has been queued. */
+    sem_t callback_request_sem;
+    /** Completed persistence results awaiting callback delivery. */
+    std::queue<persistence_request_t> callback_request_queue;
+    /** lock for the callback request queue */
+    std::atomic_flag cbq_lock = ATOMIC_FLAG_INIT;
+
+    /**
+     * The per-subgroup persistence worker used in parallel-persistence mode.
+     * Each persisted subgroup gets its own request queue, semaphore, and
+     * thread, so persist() calls for independent subgroups overlap their disk
+     * I/O instead of serializing on one fsync stream.
+     */
+    struct SubgroupWorker {
+        std::thread worker_thread;
+        sem_t request_sem;
+        std::queue<persistent::version_t> request_queue;
+        std::atomic_flag queue_lock = ATOMIC_FLAG_INIT;
+        SubgroupWorker() {
+            if(sem_init(&request_sem, 1, 0) != 0) {
+                throw derecho_exception("Cannot initialize request_sem:errno=" + std::to_string(errno));
+            }
+        }
+        ~SubgroupWorker() {
+            sem_destroy(&request_sem);
+        }
+    };
+    /** True if PERS/parallel_persistence is enabled in the configuration. */
+    const bool parallel_persistence;
+    /** Milliseconds between background log compaction passes
+     * (PERS/compaction_interval_ms); 0 disables compaction. */
+    const uint32_t compaction_interval_ms;
+    /** Milliseconds the compaction thread pauses between trimming two
+     * subgroups' logs (PERS/compaction_throttle_ms), so compaction I/O does
+     * not monopolize the disk against foreground persist() traffic. */
+    const uint32_t compaction_throttle_ms;
+    /** The background log compaction thread, running only when
+     * compaction_interval_ms is nonzero. */
+    std::thread compaction_thread;
+    /** Wakes the compaction thread from its inter-pass sleep on shutdown. */
+    std::mutex compaction_mutex;
+    std::condition_variable compaction_cv;
+    /** The log floor each subgroup was last compacted to, used to skip
+     * subgroups whose persistence frontier has not advanced since. Only
+     * touched by the compaction thread. */
+    std::map<subgroup_id_t, persistent::version_t> last_compacted_version;
+
+    /** One pass of the compaction thread: trims every persistent subgroup's
+     * logs to the safe point below its minimum latest persisted version. */
+    void run_compaction_pass();
+    /** Worker state per subgroup, created on the subgroup's first request. */
+    std::map<subgroup_id_t, std::unique_ptr<SubgroupWorker>> subgroup_workers;
+    /** Guards insertions into subgroup_workers. */
+    std::mutex workers_map_mutex;
+
+    /** Persists through the given version of a subgroup's object, updates
+     * persisted_num in the SST, and fires the persistence callback. This is
+     * the body of the persistence thread(s), shared by both modes. */
+    void handle_persist_request(const subgroup_id_t& subgroup_id, const persistent::version_t& version);
+    /** Launches the worker thread for one subgroup's SubgroupWorker. */
+    void start_worker(const subgroup_id_t& subgroup_id, SubgroupWorker& worker);
+
     /** persistence callback */
     persistence_callback_t persistence_callback;
     /** Replicated Objects handle: TODO:make it safer */
@@ -0,0 +1,73 @@
+#pragma once
+
+#include <cstddef>
+#include <new>
+
+namespace derecho {
+namespace rpc {
+
+/**
+ * A minimal pooling allocator for the small, fixed-size node allocations the
+ * RPC layer makes on every invocation (reply-map and promise-map tree nodes).
+ * Freed single-object blocks are pushed onto a thread-local free list keyed
+ * by the allocator's value type, so steady-state RPC traffic recycles the
+ * same few blocks instead of going back to malloc for every call. Blocks are
+ * intentionally never returned to the system: the working set is bounded by
+ * the peak number of in-flight invocations, which the RPC layer already caps
+ * (see MAX_CONCURRENT_RPCS_PER_INVOKER).
+ */
+template <typename T>
+class recycling_allocator {
+public:
+    using value_type = T;
+
+    recycling_allocator() = default;
+    template <typename U>
+    recycling_allocator(const recycling_allocator<U>&) {}
+
+    T* allocate(std::size_t n) {
+        if constexpr(sizeof(T) >= sizeof(void*)) {
+            if(n == 1) {
+                void*& head = free_list();
+                if(head != nullptr) {
+                    void* block = head;
+                    head = *static_cast<void**>(block);
+                    return static_cast<T*>(block);
+                }
+            }
+        }
+        return static_cast<T*>(::operator new(n * sizeof(T)));
+    }
+
+    void deallocate(T* p, std::size_t n) {
+        if constexpr(sizeof(T) >= sizeof(void*)) {
+            if(n == 1) {
+                void*& head = free_list();
+                *reinterpret_cast<void**>(p) = head;
+                head = p;
+                return;
+            }
+        }
+        ::operator delete(p);
+    }
+
+private:
+    /** The head of this thread's free list of size-sizeof(T) blocks. */
+    static void*& free_list() {
+        static thread_local void* head = nullptr;
+        return head;
+    }
+};
+
+template <typename T, typename U>
+bool operator==(const recycling_allocator<T>&, const recycling_allocator<U>&) {
+    return true;
+}
+
+template <typename T, typename U>
+bool operator!=(const recycling_allocator<T>&, const recycling_allocator<U>&) {
+    return false;
+}
+
+}  // namespace rpc
+}  // namespace derecho
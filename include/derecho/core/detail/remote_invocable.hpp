@@ -6,9 +6,12 @@
 
 #pragma once
 
+#include <cstring>
 #include <functional>
 #include <numeric>
 #include <type_traits>
+#include <utility>
+#include <vector>
 
 #include "rpc_utils.hpp"
 #include <derecho/mutils-serialization/SerializationSupport.hpp>
@@ -77,19 +80,24 @@ struct RemoteInvoker<Tag, std::function<Ret(Args...)>> {
         return *this;
     }
 
-    using barray = char*;
-    using cbarray = const char*;
+    /**
+     * True when every argument type is POD, so the marshalled size of an
+     * argument pack is a compile-time constant and the arguments can be
+     * copied into a message buffer with flat memcpys instead of the generic
+     * serialization machinery. Selected with if-constexpr in send().
+     */
+    static constexpr bool all_pod_args = (std::is_pod<std::decay_t<Args>>::value && ... && true);
+    /** The marshalled size of the argument pack when all_pod_args is true. */
+    static constexpr std::size_t flat_args_size = (std::size_t{0} + ... + sizeof(std::decay_t<Args>));
 
-    inline auto serialize_one(barray) { return 0; }
+    inline std::size_t serialize_one_growing(std::vector<char>&) { return 0; }
 
+    //Serializes arguments left-to-right into a growing buffer, in a single
+    //pass per argument (unlike bytes_size + to_bytes, which traverse twice)
     template <typename A, typename... Rest>
-    inline auto serialize_one(barray v, const A& a, const Rest&... rest) {
-        auto size = mutils::to_bytes(a, v);
-        return size + serialize_one(v + size, rest...);
-    }
-
-    inline auto serialize_all(barray v, const Args&... args) {
-        return serialize_one(v, args...);
+    inline std::size_t serialize_one_growing(std::vector<char>& buffer, const A& a, const Rest&... rest) {
+        auto size = mutils::to_bytes_growing(a, buffer);
+        return size + serialize_one_growing(buffer, rest...);
     }
 
     /**
@@ -116,14 +124,27 @@ struct RemoteInvoker<Tag, std::function<Ret(Args...)>> {
         // auto invocation_id = mutils::long_rand();
         std::size_t invocation_id = invocation_id_sequencer++;
         invocation_id %= MAX_CONCURRENT_RPCS_PER_INVOKER;
-        std::size_t size = mutils::bytes_size(invocation_id);
-        size += (mutils::bytes_size(remote_args) +...+ 0);
-
-        char* serialized_args = out_alloc(size);
-        {
-            auto v = serialized_args + mutils::to_bytes(invocation_id, serialized_args);
-            auto check_size = mutils::bytes_size(invocation_id) + serialize_all(v, remote_args...);
-            assert_always(check_size == size);
+        std::size_t size;
+        char* serialized_args;
+        if constexpr(all_pod_args) {
+            //Fixed-size fast path: the total size is a compile-time constant,
+            //so marshal straight into the message buffer with flat copies
+            size = mutils::bytes_size(invocation_id) + flat_args_size;
+            serialized_args = out_alloc(size);
+            char* v = serialized_args + mutils::to_bytes(invocation_id, serialized_args);
+            ((memcpy(v, &remote_args, sizeof(remote_args)), v += sizeof(remote_args)), ...);
+            (void)v;
+        } else {
+            //Serialize into a growing scratch buffer so the arguments are
+            //traversed only once; the copy into the message buffer is cheaper
+            //than a second bytes_size() traversal of nested arguments
+            thread_local std::vector<char> scratch_buffer;
+            scratch_buffer.clear();
+            size = mutils::to_bytes_growing(invocation_id, scratch_buffer);
+            size += serialize_one_growing(scratch_buffer, remote_args...);
+
+            serialized_args = out_alloc(size);
+            memcpy(serialized_args, scratch_buffer.data(), size);
         }
 
         // lock_t l{map_lock};
@@ -135,6 +156,50 @@ struct RemoteInvoker<Tag, std::function<Ret(Args...)>> {
                            pending_results};
     }
 
+    /**
+     * Fan-out variant of send: serializes the arguments once, then constructs
+     * one RPC message per destination by copying the serialized bytes, so the
+     * serialization cost no longer scales with the number of destinations.
+     * Each message still gets its own invocation ID (and thus its own
+     * PendingResults), since replies are correlated per invocation.
+     * @param num_dests The number of messages to construct
+     * @param out_alloc A function that allocates the buffer for one message,
+     * given the destination's index in [0, num_dests) and the message size
+     * @param remote_args The arguments to the remote-invocable function
+     */
+    std::vector<send_return> send_to_many(std::size_t num_dests,
+                                          const std::function<char*(std::size_t, std::size_t)>& out_alloc,
+                                          const std::decay_t<Args>&... remote_args) {
+        std::vector<char> serialized_args;
+        if constexpr(all_pod_args) {
+            //Fixed-size fast path, as in send()
+            serialized_args.resize(flat_args_size);
+            char* v = serialized_args.data();
+            ((memcpy(v, &remote_args, sizeof(remote_args)), v += sizeof(remote_args)), ...);
+            (void)v;
+        } else {
+            //Single-pass serialization into a growing buffer, as in send()
+            serialize_one_growing(serialized_args, remote_args...);
+        }
+        const std::size_t args_size = serialized_args.size();
+        std::vector<send_return> returns;
+        returns.reserve(num_dests);
+        for(std::size_t dest_index = 0; dest_index < num_dests; ++dest_index) {
+            std::size_t invocation_id = invocation_id_sequencer++;
+            invocation_id %= MAX_CONCURRENT_RPCS_PER_INVOKER;
+            const std::size_t size = mutils::bytes_size(invocation_id) + args_size;
+            char* buf = out_alloc(dest_index, size);
+            auto v = buf + mutils::to_bytes(invocation_id, buf);
+            memcpy(v, serialized_args.data(), args_size);
+            results_vector[invocation_id].reset();
+            PendingResults<Ret>& pending_results = results_vector[invocation_id];
+            dbg_default_trace("Ready to send an RPC call message with invocation ID {}", invocation_id);
+            returns.emplace_back(send_return{size, buf, pending_results.get_future(),
+                                             pending_results});
+        }
+        return returns;
+    }
+
     /**
      * Specialization of receive_response for non-void functions. Stores the
      * response in the results map, or stores the exception if there was an
@@ -181,7 +246,14 @@ struct RemoteInvoker<Tag, std::function<Ret(Args...)>> {
             results_vector[invocation_id].set_exception(nid, std::make_exception_ptr(remote_exception_occurred{nid}));
         } else {
             dbg_default_trace("Received an RPC response for invocation ID {} from node {}", invocation_id, nid);
-            results_vector[invocation_id].set_value(nid, *mutils::from_bytes<Ret>(dsm, response + 1 + sizeof(invocation_id)));
+            if constexpr(std::is_pod<Ret>::value) {
+                //Fixed-size replies deserialize as a view into the receive
+                //buffer instead of a fresh heap allocation; set_value copies
+                //the value into the promise before the buffer is reused
+                results_vector[invocation_id].set_value(nid, *mutils::from_bytes_noalloc<Ret>(dsm, response + 1 + sizeof(invocation_id)));
+            } else {
+                results_vector[invocation_id].set_value(nid, *mutils::from_bytes<Ret>(dsm, response + 1 + sizeof(invocation_id)));
+            }
         }
         return recv_ret{Opcode(), 0, nullptr, nullptr};
     }
@@ -241,7 +313,7 @@ struct RemoteInvoker<Tag, std::function<Ret(Args...)>> {
      * which this RemoteInvoker should add its functions to.
      */
     RemoteInvoker(uint32_t class_id, uint32_t instance_id,
-                  std::map<Opcode, receive_fun_t>& receivers)
+                  receiver_map_t& receivers)
             : invoke_opcode{class_id, instance_id, Tag, false},
               reply_opcode{class_id, instance_id, Tag, true},
               invocation_id_sequencer(0) {
@@ -277,6 +349,30 @@ struct RemoteInvocable<Tag, std::function<Ret(Args...)>> {
         return *this;
     }
 
+    /**
+     * True when every argument type is POD; the mirror of RemoteInvoker's
+     * fixed-size marshalling fast path. Arguments are then read from the
+     * receive buffer at compile-time offsets, skipping deserialize_and_run
+     * and the DeserializationManager entirely.
+     */
+    static constexpr bool all_pod_args = (std::is_pod<std::decay_t<Args>>::value && ... && true);
+
+    /** The offset of the index-th argument in a flat-marshalled argument pack. */
+    static constexpr std::size_t flat_arg_offset(std::size_t index) {
+        constexpr std::size_t arg_sizes[] = {0, sizeof(std::decay_t<Args>)...};
+        std::size_t offset = 0;
+        for(std::size_t i = 1; i <= index; ++i) {
+            offset += arg_sizes[i];
+        }
+        return offset;
+    }
+
+    template <std::size_t... Indices>
+    inline Ret invoke_with_flat_args(const char* recv_buf, std::index_sequence<Indices...>) {
+        return remote_invocable_function(
+                *reinterpret_cast<const std::decay_t<Args>*>(recv_buf + flat_arg_offset(Indices))...);
+    }
+
     /**
      * Specialization of receive_call for non-void functions. After calling the
      * function locally, it constructs a message containing the return value to
@@ -291,7 +387,13 @@ struct RemoteInvocable<Tag, std::function<Ret(Args...)>> {
         long int invocation_id = ((long int*)_recv_buf)[0];
         auto recv_buf = _recv_buf + sizeof(long int);
         try {
-            const auto result = mutils::deserialize_and_run(dsm, recv_buf, remote_invocable_function);
+            const auto result = [&]() {
+                if constexpr(all_pod_args) {
+                    return invoke_with_flat_args(recv_buf, std::index_sequence_for<Args...>{});
+                } else {
+                    return mutils::deserialize_and_run(dsm, recv_buf, remote_invocable_function);
+                }
+            }();
             const auto result_size = mutils::bytes_size(result) + sizeof(long int) + 1;
             auto out = out_alloc(result_size);
             out[0] = false;
@@ -318,7 +420,11 @@ struct RemoteInvocable<Tag, std::function<Ret(Args...)>> {
                                  const std::function<char*(int)>&) {
         //TODO: Need to catch exceptions here, and possibly send them back, since void functions can still throw exceptions!
         auto recv_buf = _recv_buf + sizeof(long int);
-        mutils::deserialize_and_run(dsm, recv_buf, remote_invocable_function);
+        if constexpr(all_pod_args) {
+            invoke_with_flat_args(recv_buf, std::index_sequence_for<Args...>{});
+        } else {
+            mutils::deserialize_and_run(dsm, recv_buf, remote_invocable_function);
+        }
         return recv_ret{reply_opcode, 0, nullptr};
     }
 
@@ -352,7 +458,7 @@ struct RemoteInvocable<Tag, std::function<Ret(Args...)>> {
      * arrives.
      */
     RemoteInvocable(uint32_t class_id, uint32_t instance_id,
-                    std::map<Opcode, receive_fun_t>& receivers,
+                    receiver_map_t& receivers,
                     std::function<Ret(Args...)> f)
             : remote_invocable_function(f),
               invoke_opcode{class_id, instance_id, Tag, false},
@@ -403,11 +509,29 @@ struct const_partial_wrapped {
     fun_t fun;
 };
 
+/**
+ * Maps a handler's declared return type to the reply type the RPC machinery
+ * uses for it. A coroutine handler returning rpc::Task detaches at its first
+ * suspension point and cannot produce a reply value, so it is treated exactly
+ * like a void function: the caller gets QueryResults<void>, and the empty
+ * acknowledgement is sent as soon as the handler suspends or completes. All
+ * other return types map to themselves.
+ */
+#ifdef DERECHO_HAS_COROUTINES
+template <typename Ret>
+using handler_reply_t = std::conditional_t<std::is_same<Ret, Task>::value, void, Ret>;
+#else
+template <typename Ret>
+using handler_reply_t = Ret;
+#endif
+
 /**
  * Converts a partial_wrapped<> containing a pointer-to-member-function to a
  * wrapped<> containing the same function as a std::function. It does this by
  * constructing a lambda that captures an instance of the function's class and
- * invokes the member function using that instance.
+ * invokes the member function using that instance. For an rpc::Task handler
+ * the lambda's return value is discarded by the void std::function, which
+ * detaches the eagerly-started coroutine.
  * @param _this A pointer-to-pointer to an instance of NewClass, the class that
  * contains the member function
  * @param partial The partial_wrapped to convert
@@ -415,10 +539,10 @@ struct const_partial_wrapped {
  * instance _this
  */
 template <typename NewClass, FunctionTag Tag, typename Ret, typename... Args>
-wrapped<Tag, std::function<Ret(Args...)>> bind_to_instance(std::unique_ptr<NewClass>* _this,
-                                                           const partial_wrapped<Tag, Ret, NewClass, Args...>& partial) {
+wrapped<Tag, std::function<handler_reply_t<Ret>(Args...)>> bind_to_instance(std::unique_ptr<NewClass>* _this,
+                                                                            const partial_wrapped<Tag, Ret, NewClass, Args...>& partial) {
     assert(_this);
-    return wrapped<Tag, std::function<Ret(Args...)>>{
+    return wrapped<Tag, std::function<handler_reply_t<Ret>(Args...)>>{
             [_this, fun = partial.fun](Args... arguments) {
                 assert(_this);
                 assert(_this->get());
@@ -431,10 +555,10 @@ wrapped<Tag, std::function<Ret(Args...)>> bind_to_instance(std::unique_ptr<NewCl
  * pointer-to-member-functions that are const.
  */
 template <typename NewClass, FunctionTag Tag, typename Ret, typename... Args>
-wrapped<Tag, std::function<Ret(Args...)>> bind_to_instance(std::unique_ptr<NewClass>* _this,
-                                                           const const_partial_wrapped<Tag, Ret, NewClass, Args...>& partial) {
+wrapped<Tag, std::function<handler_reply_t<Ret>(Args...)>> bind_to_instance(std::unique_ptr<NewClass>* _this,
+                                                                            const const_partial_wrapped<Tag, Ret, NewClass, Args...>& partial) {
     assert(_this);
-    return wrapped<Tag, std::function<Ret(Args...)>>{
+    return wrapped<Tag, std::function<handler_reply_t<Ret>(Args...)>>{
             [_this, fun = partial.fun](Args... arguments) {
                 return (_this->get()->*fun)(arguments...);
             }};
@@ -487,7 +611,7 @@ struct RemoteInvocablePairs<wrapped<id, FunType>>
         : public RemoteInvoker<id, FunType>, public RemoteInvocable<id, FunType> {
     RemoteInvocablePairs(uint32_t class_id,
                          uint32_t instance_id,
-                         std::map<Opcode, receive_fun_t>& receivers, FunType function_ptr)
+                         receiver_map_t& receivers, FunType function_ptr)
             : RemoteInvoker<id, FunType>(class_id, instance_id, receivers),
               RemoteInvocable<id, FunType>(class_id, instance_id, receivers, function_ptr) {}
 
@@ -513,7 +637,7 @@ struct RemoteInvocablePairs<wrapped<id, FunType>, rest...>
     template <typename... RestFunTypes>
     RemoteInvocablePairs(uint32_t class_id,
                          uint32_t instance_id,
-                         std::map<Opcode, receive_fun_t>& receivers,
+                         receiver_map_t& receivers,
                          FunType function_ptr,
                          RestFunTypes&&... function_ptrs)
             : RemoteInvoker<id, FunType>(class_id, instance_id, receivers),
@@ -542,7 +666,7 @@ template <FunctionTag Tag, typename FunType>
 struct RemoteInvokers<wrapped<Tag, FunType>> : public RemoteInvoker<Tag, FunType> {
     RemoteInvokers(uint32_t class_id,
                    uint32_t instance_id,
-                   std::map<Opcode, receive_fun_t>& receivers)
+                   receiver_map_t& receivers)
             : RemoteInvoker<Tag, FunType>(class_id, instance_id, receivers) {}
 
     using RemoteInvoker<Tag, FunType>::get_invoker;
@@ -563,7 +687,7 @@ struct RemoteInvokers<wrapped<Tag, FunType>, RestWrapped...>
         : public RemoteInvoker<Tag, FunType>, public RemoteInvokers<RestWrapped...> {
     RemoteInvokers(uint32_t class_id,
                    uint32_t instance_id,
-                   std::map<Opcode, receive_fun_t>& receivers)
+                   receiver_map_t& receivers)
             : RemoteInvoker<Tag, FunType>(class_id, instance_id, receivers),
               RemoteInvokers<RestWrapped...>(class_id, instance_id, receivers) {}
 
@@ -587,7 +711,7 @@ public:
     const node_id_t nid;
 
     RemoteInvocableClass(node_id_t nid, uint32_t type_id, uint32_t instance_id,
-                         std::map<Opcode, receive_fun_t>& rvrs, const WrappedFuns&... fs)
+                         receiver_map_t& rvrs, const WrappedFuns&... fs)
             : RemoteInvocablePairs<WrappedFuns...>(type_id, instance_id, rvrs, fs.fun...),
               nid(nid) {}
 
@@ -688,7 +812,7 @@ public:
     const node_id_t nid;
 
     RemoteInvocableClass(node_id_t nid, uint32_t type_id, uint32_t instance_id,
-                         std::map<Opcode, receive_fun_t>& rvrs)
+                         receiver_map_t& rvrs)
             : nid(nid) {}
 
     template <FunctionTag Tag, typename... Args>
@@ -732,7 +856,7 @@ public:
  */
 template <class IdentifyingClass, typename... WrappedFuns>
 auto build_remote_invocable_class(const node_id_t nid, const uint32_t type_id, const uint32_t instance_id,
-                                  std::map<Opcode, receive_fun_t>& rvrs,
+                                  receiver_map_t& rvrs,
                                   const WrappedFuns&... fs) {
     return std::make_unique<RemoteInvocableClass<IdentifyingClass, WrappedFuns...>>(nid, type_id, instance_id, rvrs, fs...);
 }
@@ -754,7 +878,7 @@ public:
     const node_id_t nid;
 
     RemoteInvokerForClass(node_id_t nid, uint32_t type_id, uint32_t instance_id,
-                          std::map<Opcode, receive_fun_t>& rvrs)
+                          receiver_map_t& rvrs)
             : RemoteInvokers<WrappedFuns...>(type_id, instance_id, rvrs),
               nid(nid) {}
 
@@ -792,6 +916,52 @@ public:
         return send_return{std::move(sent_return.results),
                            sent_return.pending};
     }
+
+    /**
+     * Fan-out variant of send, built on RemoteInvoker::send_to_many: the
+     * arguments are serialized once and one message is constructed per
+     * destination, each with its own header and invocation ID.
+     * @param num_dests The number of messages to construct
+     * @param out_alloc A function that allocates the buffer for one message,
+     * given the destination's index in [0, num_dests) and the message size
+     * @param args The arguments to the remote-invocable function
+     */
+    template <FunctionTag Tag, typename... Args>
+    auto send_to_many(std::size_t num_dests,
+                      const std::function<char*(std::size_t, std::size_t)>& out_alloc,
+                      Args&&... args) {
+        using namespace remote_invocation_utilities;
+
+        constexpr std::integral_constant<FunctionTag, Tag>* choice{nullptr};
+        auto& invoker = this->get_invoker(choice, args...);
+        const auto header_size = header_space();
+        auto sent_returns = invoker.send_to_many(
+                num_dests,
+                [&out_alloc, &header_size](std::size_t dest_index, std::size_t size) {
+                    return out_alloc(dest_index, size + header_size) + header_size;
+                },
+                std::forward<Args>(args)...);
+
+        uint32_t flags = 0;
+        if(in_rpc_handler()) {
+            RPC_HEADER_FLAG_SET(flags, CASCADE);
+            dbg_default_info("sending cascading RPC.");
+        }
+        using Ret = typename decltype(sent_returns.front().results)::type;
+        struct send_return {
+            QueryResults<Ret> results;
+            PendingResults<Ret>& pending;
+        };
+        std::vector<send_return> returns;
+        returns.reserve(sent_returns.size());
+        for(auto& sent_return : sent_returns) {
+            char* buf = sent_return.buf - header_size;
+            populate_header(buf, sent_return.size, invoker.invoke_opcode, nid, flags);
+            returns.emplace_back(send_return{std::move(sent_return.results),
+                                             sent_return.pending});
+        }
+        return returns;
+    }
 };
 
 /**
@@ -803,7 +973,7 @@ public:
     const node_id_t nid;
 
     RemoteInvokerForClass(node_id_t nid, uint32_t type_id, uint32_t instance_id,
-                          std::map<Opcode, receive_fun_t>& rvrs)
+                          receiver_map_t& rvrs)
             : nid(nid) {}
 };
 
@@ -824,8 +994,39 @@ public:
  */
 template <class IdentifyingClass, typename... WrappedFuns>
 auto build_remote_invoker_for_class(const node_id_t nid, const uint32_t type_id, const uint32_t instance_id,
-                                    std::map<Opcode, receive_fun_t>& rvrs) {
+                                    receiver_map_t& rvrs) {
     return std::make_unique<RemoteInvokerForClass<IdentifyingClass, WrappedFuns...>>(nid, type_id, instance_id, rvrs);
 }
+
+/**
+ * Constructs a RemoteInvokerForClass from the tuple of partially-wrapped
+ * method pointers returned by IdentifyingClass::register_functions(),
+ * supplying the template parameters of build_remote_invoker_for_class by
+ * asking bind_to_instance for the type of the wrapped<> that corresponds to
+ * each partial_wrapped<>. Shared by RPCManager::make_remote_invoker and
+ * ExternalGroupClient, which registers receive functions in its own map.
+ */
+template <class IdentifyingClass, typename FunctionTuple>
+auto build_remote_invoker_from_tuple(const node_id_t nid, const uint32_t type_id,
+                                     const uint32_t instance_id, receiver_map_t& rvrs,
+                                     FunctionTuple funs) {
+    return mutils::callFunc([&](const auto&... unpacked_functions) {
+        return build_remote_invoker_for_class<IdentifyingClass,
+                                              decltype(bind_to_instance(std::declval<std::unique_ptr<IdentifyingClass>*>(),
+                                                                        unpacked_functions))...>(nid, type_id,
+                                                                                                 instance_id, rvrs);
+    },
+                            funs);
+}
+
+/**
+ * The type of RemoteInvokerForClass that build_remote_invoker_from_tuple
+ * constructs for the class in the template parameter. Unlike RemoteInvokerFor
+ * (declared in rpc_manager.h), this alias does not depend on RPCManager, so
+ * it can be used by clients that are not group members.
+ */
+template <typename T>
+using RemoteInvokerForClassOf = std::decay_t<decltype(*build_remote_invoker_from_tuple<T>(
+        std::declval<node_id_t>(), 0, 0, std::declval<receiver_map_t&>(), T::register_functions()))>;
 }  // namespace rpc
 }  // namespace derecho
@@ -1,7 +1,9 @@
 #pragma once
 
+#include <chrono>
 #include <functional>
 #include <mutex>
+#include <optional>
 #include <utility>
 
 #include "../replicated.hpp"
@@ -59,6 +61,7 @@ Replicated<T>::Replicated(Replicated&& rhs) : persistent_registry_ptr(std::move(
                                               shard_num(rhs.shard_num),
                                               group_rpc_manager(rhs.group_rpc_manager),
                                               wrapped_this(std::move(rhs.wrapped_this)),
+                                              object_snapshot(std::atomic_load(&rhs.object_snapshot)),
                                               group(rhs.group) {
     persistent_registry_ptr->updateTemporalFrontierProvider(this);
 }
@@ -71,32 +74,145 @@ Replicated<T>::~Replicated() {
     }
 }
 
+template <typename T>
+void Replicated<T>::publish_snapshot() {
+    static_assert(std::is_copy_constructible_v<T>,
+                  "publish_snapshot() requires a copy-constructible replicated type");
+    if(!is_valid()) {
+        throw empty_reference_exception{"Attempted to use an empty Replicated<T>"};
+    }
+    //The copy runs on the publishing (mutation-serialized) thread; only the
+    //pointer swap is visible to concurrent readers
+    std::atomic_store(&object_snapshot,
+                      std::shared_ptr<const T>(std::make_shared<T>(**user_object_ptr)));
+}
+
+template <typename T>
+std::shared_ptr<const T> Replicated<T>::get_snapshot() const {
+    return std::atomic_load(&object_snapshot);
+}
+
 template <typename T>
 template <rpc::FunctionTag tag, typename... Args>
 auto Replicated<T>::p2p_send(node_id_t dest_node, Args&&... args) {
     if(is_valid()) {
-        if(group_rpc_manager.view_manager.get_current_view().get().rank_of(dest_node) == -1) {
-            throw invalid_node_exception("Cannot send a p2p request to node "
-                    + std::to_string(dest_node) + ": it is not a member of the Group.");
+        {
+            auto current_view = group_rpc_manager.view_manager.get_current_view();
+            const View& view = current_view.get();
+            if(!membership_check_cache.hit(view.vid, dest_node)) {
+                if(view.rank_of(dest_node) == -1) {
+                    throw invalid_node_exception("Cannot send a p2p request to node "
+                            + std::to_string(dest_node) + ": it is not a member of the Group.");
+                }
+                membership_check_cache.record(view.vid, dest_node);
+            }
         }
+        std::optional<sst::P2PConnection::SendSlot> send_slot;
         auto return_pair = wrapped_this->template send<tag>(
-                [this, &dest_node](size_t size) -> char* {
+                [this, &dest_node, &send_slot](size_t size) -> char* {
                     const std::size_t max_payload_size = group_rpc_manager.view_manager.get_max_payload_sizes().at(subgroup_id);
                     if(size <= max_payload_size) {
-                        return (char*)group_rpc_manager.get_sendbuffer_ptr(dest_node,
-                                                                           sst::REQUEST_TYPE::P2P_REQUEST);
+                        send_slot = group_rpc_manager.reserve_p2p_buffer(dest_node,
+                                                                         sst::REQUEST_TYPE::P2P_REQUEST,
+                                                                         size);
+                        return send_slot->buf;
                     } else {
                         throw derecho_exception("The size of serialized args exceeds the maximum message size.");
                     }
                 },
                 std::forward<Args>(args)...);
-        group_rpc_manager.finish_p2p_send(dest_node, subgroup_id, return_pair.pending);
+        group_rpc_manager.post_p2p_send(dest_node, *send_slot, subgroup_id, return_pair.pending);
         return std::move(return_pair.results);
     } else {
         throw empty_reference_exception{"Attempted to use an empty Replicated<T>"};
     }
 }
 
+template <typename T>
+template <rpc::FunctionTag tag, typename... Args>
+auto Replicated<T>::try_p2p_send(node_id_t dest_node, Args&&... args) {
+    using results_t = decltype(this->template p2p_send<tag>(dest_node, std::forward<Args>(args)...));
+    if(!is_valid()) {
+        throw empty_reference_exception{"Attempted to use an empty Replicated<T>"};
+    }
+    {
+        auto current_view = group_rpc_manager.view_manager.get_current_view();
+        const View& view = current_view.get();
+        if(!membership_check_cache.hit(view.vid, dest_node)) {
+            if(view.rank_of(dest_node) == -1) {
+                return TrySendResult<results_t>{SendStatus::INVALID_MEMBER, std::nullopt};
+            }
+            membership_check_cache.record(view.vid, dest_node);
+        }
+    }
+    std::optional<sst::P2PConnection::SendSlot> send_slot;
+    try {
+        auto return_pair = wrapped_this->template send<tag>(
+                [this, &dest_node, &send_slot](size_t size) -> char* {
+                    const std::size_t max_payload_size = group_rpc_manager.view_manager.get_max_payload_sizes().at(subgroup_id);
+                    if(size <= max_payload_size) {
+                        send_slot = group_rpc_manager.reserve_p2p_buffer(dest_node,
+                                                                         sst::REQUEST_TYPE::P2P_REQUEST,
+                                                                         size);
+                        return send_slot->buf;
+                    } else {
+                        throw derecho_exception("The size of serialized args exceeds the maximum message size.");
+                    }
+                },
+                std::forward<Args>(args)...);
+        group_rpc_manager.post_p2p_send(dest_node, *send_slot, subgroup_id, return_pair.pending);
+        return TrySendResult<results_t>{SendStatus::SUCCESS, std::move(return_pair.results)};
+    } catch(rpc::node_removed_from_group_exception&) {
+        // the destination passed the membership check but was removed before
+        // the buffer could be reserved or posted; still a benign failure
+        return TrySendResult<results_t>{SendStatus::INVALID_MEMBER, std::nullopt};
+    }
+}
+template <typename T>
+template <rpc::FunctionTag tag, typename... Args>
+auto Replicated<T>::p2p_send_with_timeout(node_id_t dest_node, std::chrono::milliseconds timeout, Args&&... args) {
+    if(is_valid()) {
+        {
+            auto current_view = group_rpc_manager.view_manager.get_current_view();
+            const View& view = current_view.get();
+            if(!membership_check_cache.hit(view.vid, dest_node)) {
+                if(view.rank_of(dest_node) == -1) {
+                    throw invalid_node_exception("Cannot send a p2p request to node "
+                            + std::to_string(dest_node) + ": it is not a member of the Group.");
+                }
+                membership_check_cache.record(view.vid, dest_node);
+            }
+        }
+        std::optional<sst::P2PConnection::SendSlot> send_slot;
+        auto return_pair = wrapped_this->template send<tag>(
+                [this, &dest_node, &send_slot](size_t size) -> char* {
+                    const std::size_t max_payload_size = group_rpc_manager.view_manager.get_max_payload_sizes().at(subgroup_id);
+                    if(size <= max_payload_size) {
+                        send_slot = group_rpc_manager.reserve_p2p_buffer(dest_node,
+                                                                         sst::REQUEST_TYPE::P2P_REQUEST,
+                                                                         size);
+                        return send_slot->buf;
+                    } else {
+                        throw derecho_exception("The size of serialized args exceeds the maximum message size.");
+                    }
+                },
+                std::forward<Args>(args)...);
+        group_rpc_manager.post_p2p_send(dest_node, *send_slot, subgroup_id, return_pair.pending);
+        group_rpc_manager.schedule_rpc_deadline(subgroup_id, return_pair.pending, timeout);
+        return std::move(return_pair.results);
+    } else {
+        throw empty_reference_exception{"Attempted to use an empty Replicated<T>"};
+    }
+}
+
+template <typename T>
+template <rpc::FunctionTag tag, typename... Args>
+auto Replicated<T>::p2p_send_to_least_loaded(uint32_t shard_num, Args&&... args) {
+    const node_id_t dest_node
+            = group_rpc_manager.view_manager.get_least_loaded_shard_member(subgroup_id, shard_num);
+    return p2p_send<tag>(dest_node, std::forward<Args>(args)...);
+}
+
 template <typename T>
 template <rpc::FunctionTag tag, typename... Args>
 auto Replicated<T>::ordered_send(Args&&... args) {
@@ -105,11 +221,19 @@ auto Replicated<T>::ordered_send(Args&&... args) {
 
         using Ret = typename std::remove_pointer<decltype(wrapped_this->template getReturnType<tag>(
                 std::forward<Args>(args)...))>::type;
-        rpc::QueryResults<Ret>* results_ptr;
+        // The serializer writes the argument bytes straight into the reserved
+        // multicast slot; only the result futures are moved out of it, onto
+        // the caller's stack, so the send itself makes no heap allocations.
+        std::optional<rpc::QueryResults<Ret>> results;
         rpc::PendingResults<Ret>* pending_ptr;
         auto serializer = [&](char* buffer) {
             //By the time this lambda runs, the current thread will be holding a read lock on view_mutex
-            const std::size_t max_payload_size = group_rpc_manager.view_manager.get_max_payload_sizes().at(subgroup_id);
+            //Payloads above the subgroup maximum are legal now that the
+            //multicast layer fragments them; the buffer is then sized to the
+            //full serialized payload rather than a window slot
+            const std::size_t max_payload_size = std::max<std::size_t>(
+                    group_rpc_manager.view_manager.get_max_payload_sizes().at(subgroup_id),
+                    payload_size_for_multicast_send);
             auto send_return_struct = wrapped_this->template send<tag>(
                     [&buffer, &max_payload_size](size_t size) -> char* {
                         if(size <= max_payload_size) {
@@ -119,28 +243,134 @@ auto Replicated<T>::ordered_send(Args&&... args) {
                         }
                     },
                     std::forward<Args>(args)...);
-            results_ptr = new rpc::QueryResults<Ret>(std::move(send_return_struct.results));
+            results.emplace(std::move(send_return_struct.results));
             pending_ptr = &send_return_struct.pending;
         };
 
-        std::shared_lock<std::shared_timed_mutex> view_read_lock(group_rpc_manager.view_manager.view_mutex);
+        std::shared_lock<EpochSharedMutex> view_read_lock(group_rpc_manager.view_manager.view_mutex);
         group_rpc_manager.view_manager.view_change_cv.wait(view_read_lock, [&]() {
             return group_rpc_manager.view_manager.curr_view
                     ->multicast_group->send(subgroup_id, payload_size_for_multicast_send, serializer, true);
         });
         group_rpc_manager.finish_rpc_send(subgroup_id, *pending_ptr);
-        return std::move(*results_ptr);
+        return std::move(*results);
+    } else {
+        throw empty_reference_exception{"Attempted to use an empty Replicated<T>"};
+    }
+}
+
+template <typename T>
+template <rpc::FunctionTag tag, typename... Args>
+auto Replicated<T>::ordered_send_with_timeout(std::chrono::milliseconds timeout, Args&&... args) {
+    if(is_valid()) {
+        size_t payload_size_for_multicast_send = wrapped_this->template get_size_for_ordered_send<tag>(std::forward<Args>(args)...);
+
+        using Ret = typename std::remove_pointer<decltype(wrapped_this->template getReturnType<tag>(
+                std::forward<Args>(args)...))>::type;
+        std::optional<rpc::QueryResults<Ret>> results;
+        rpc::PendingResults<Ret>* pending_ptr;
+        auto serializer = [&](char* buffer) {
+            //By the time this lambda runs, the current thread will be holding a read lock on view_mutex
+            //Payloads above the subgroup maximum are legal now that the
+            //multicast layer fragments them; the buffer is then sized to the
+            //full serialized payload rather than a window slot
+            const std::size_t max_payload_size = std::max<std::size_t>(
+                    group_rpc_manager.view_manager.get_max_payload_sizes().at(subgroup_id),
+                    payload_size_for_multicast_send);
+            auto send_return_struct = wrapped_this->template send<tag>(
+                    [&buffer, &max_payload_size](size_t size) -> char* {
+                        if(size <= max_payload_size) {
+                            return buffer;
+                        } else {
+                            throw derecho_exception("The size of serialized args exceeds the maximum message size.");
+                        }
+                    },
+                    std::forward<Args>(args)...);
+            results.emplace(std::move(send_return_struct.results));
+            pending_ptr = &send_return_struct.pending;
+        };
+
+        std::shared_lock<EpochSharedMutex> view_read_lock(group_rpc_manager.view_manager.view_mutex);
+        group_rpc_manager.view_manager.view_change_cv.wait(view_read_lock, [&]() {
+            return group_rpc_manager.view_manager.curr_view
+                    ->multicast_group->send(subgroup_id, payload_size_for_multicast_send, serializer, true);
+        });
+        group_rpc_manager.finish_rpc_send(subgroup_id, *pending_ptr);
+        //The deadline covers the whole call, from admission to last reply
+        group_rpc_manager.schedule_rpc_deadline(subgroup_id, *pending_ptr, timeout);
+        return std::move(*results);
+    } else {
+        throw empty_reference_exception{"Attempted to use an empty Replicated<T>"};
+    }
+}
+
+template <typename T>
+template <rpc::FunctionTag tag, typename... Args>
+auto Replicated<T>::try_ordered_send(Args&&... args) {
+    if(is_valid()) {
+        size_t payload_size_for_multicast_send = wrapped_this->template get_size_for_ordered_send<tag>(std::forward<Args>(args)...);
+
+        using Ret = typename std::remove_pointer<decltype(wrapped_this->template getReturnType<tag>(
+                std::forward<Args>(args)...))>::type;
+        std::optional<rpc::QueryResults<Ret>> results;
+        rpc::PendingResults<Ret>* pending_ptr;
+        auto serializer = [&](char* buffer) {
+            //By the time this lambda runs, the current thread will be holding a read lock on view_mutex
+            //Payloads above the subgroup maximum are legal now that the
+            //multicast layer fragments them; the buffer is then sized to the
+            //full serialized payload rather than a window slot
+            const std::size_t max_payload_size = std::max<std::size_t>(
+                    group_rpc_manager.view_manager.get_max_payload_sizes().at(subgroup_id),
+                    payload_size_for_multicast_send);
+            auto send_return_struct = wrapped_this->template send<tag>(
+                    [&buffer, &max_payload_size](size_t size) -> char* {
+                        if(size <= max_payload_size) {
+                            return buffer;
+                        } else {
+                            throw derecho_exception("The size of serialized args exceeds the maximum message size.");
+                        }
+                    },
+                    std::forward<Args>(args)...);
+            results.emplace(std::move(send_return_struct.results));
+            pending_ptr = &send_return_struct.pending;
+        };
+
+        // Single attempt, no waiting: if the send window is full the
+        // serializer never runs and no RPC state is created
+        if(group_rpc_manager.view_manager.try_send(subgroup_id, payload_size_for_multicast_send,
+                                                   serializer, true)) {
+            group_rpc_manager.finish_rpc_send(subgroup_id, *pending_ptr);
+        }
+        return results;
     } else {
         throw empty_reference_exception{"Attempted to use an empty Replicated<T>"};
     }
 }
 
+template <typename T>
+int32_t Replicated<T>::get_send_credits() {
+    return group_rpc_manager.view_manager.get_send_credits(subgroup_id);
+}
+
+template <typename T>
+void Replicated<T>::set_send_credits_callback(std::function<void()> callback) {
+    group_rpc_manager.view_manager.set_send_credits_callback(subgroup_id, std::move(callback));
+}
+
 template <typename T>
 void Replicated<T>::send(unsigned long long int payload_size,
                          const std::function<void(char* buf)>& msg_generator) {
     group_rpc_manager.view_manager.send(subgroup_id, payload_size, msg_generator);
 }
 
+template <typename T>
+void Replicated<T>::send_zero_copy(std::shared_ptr<rdma::memory_region> user_mr, size_t offset,
+                                   unsigned long long int payload_size,
+                                   std::function<void()> release_callback) {
+    group_rpc_manager.view_manager.send_zero_copy(subgroup_id, std::move(user_mr), offset,
+                                                  payload_size, std::move(release_callback));
+}
+
 template <typename T>
 std::size_t Replicated<T>::object_size() const {
     return mutils::bytes_size(**user_object_ptr);
@@ -157,10 +387,24 @@ void Replicated<T>::send_object(tcp::socket& receiver_socket) const {
 
 template <typename T>
 void Replicated<T>::send_object_raw(tcp::socket& receiver_socket) const {
-    auto bind_socket_write = [&receiver_socket](const char* bytes, std::size_t size) {
-        receiver_socket.write(bytes, size);
-    };
-    mutils::post_object(bind_socket_write, **user_object_ptr);
+    //Bounded-buffer streaming: serialized fragments are coalesced into
+    //fixed-size chunks and each chunk is written to the socket as it fills,
+    //so sending a large object never materializes a second copy of it (and
+    //doesn't make one write syscall per serialized field)
+    mutils::chunked_post_sink chunked_socket_write(
+            [&receiver_socket](const char* bytes, std::size_t size) {
+                receiver_socket.write(bytes, size);
+            });
+    mutils::post_object([&chunked_socket_write](char const* const bytes, std::size_t size) {
+        chunked_socket_write(bytes, size);
+    },
+                        **user_object_ptr);
+    chunked_socket_write.flush();
+}
+
+template <typename T>
+std::size_t Replicated<T>::serialize_object(char* buffer) const {
+    return mutils::to_bytes(**user_object_ptr, buffer);
 }
 
 template <typename T>
@@ -196,6 +440,47 @@ const persistent::version_t Replicated<T>::get_minimum_latest_persisted_version(
     return persistent_registry_ptr->getMinimumLatestPersistedVersion();
 }
 
+template <typename T>
+const persistent::version_t Replicated<T>::get_maximum_earliest_version() noexcept(false) {
+    return persistent_registry_ptr->getMaximumEarliestVersion();
+}
+
+template <typename T>
+std::size_t Replicated<T>::get_log_tail_size(const persistent::version_t& earliest_version) {
+    return persistent_registry_ptr->getLogTailSize(earliest_version);
+}
+
+template <typename T>
+void Replicated<T>::send_log_tail(tcp::socket& receiver_socket,
+                                  const persistent::version_t& earliest_version) {
+    //Chunked for the same reason as send_object_raw
+    mutils::chunked_post_sink chunked_socket_write(
+            [&receiver_socket](const char* bytes, std::size_t size) {
+                receiver_socket.write(bytes, size);
+            });
+    persistent_registry_ptr->postLogTails(
+            [&chunked_socket_write](char const* const bytes, std::size_t size) {
+                chunked_socket_write(bytes, size);
+            },
+            [&chunked_socket_write, &receiver_socket](int fd, uint64_t offset, std::size_t size) {
+                //Flush the buffered headers first so the payload lands at its
+                //place in the stream, then let the kernel copy it from the
+                //log's data file straight to the socket
+                chunked_socket_write.flush();
+                receiver_socket.write_from_file(fd, offset, size);
+            },
+            earliest_version);
+    chunked_socket_write.flush();
+}
+
+template <typename T>
+std::size_t Replicated<T>::apply_log_tail(char* buffer) {
+    mutils::RemoteDeserialization_v rdv{group_rpc_manager.rdv};
+    rdv.insert(rdv.begin(), persistent_registry_ptr.get());
+    mutils::DeserializationManager dsm{rdv};
+    return persistent_registry_ptr->mergeLogTails(&dsm, buffer);
+}
+
 template <typename T>
 const uint64_t Replicated<T>::compute_global_stability_frontier() {
     return group_rpc_manager.view_manager.compute_global_stability_frontier(subgroup_id);
@@ -217,39 +502,178 @@ template <rpc::FunctionTag tag, typename... Args>
 auto ExternalCaller<T>::p2p_send(node_id_t dest_node, Args&&... args) {
     if(is_valid()) {
         assert(dest_node != node_id);
-        if(group_rpc_manager.view_manager.get_current_view().get().rank_of(dest_node) == -1) {
-            throw invalid_node_exception("Cannot send a p2p request to node "
-                    + std::to_string(dest_node) + ": it is not a member of the Group.");
+        {
+            auto current_view = group_rpc_manager.view_manager.get_current_view();
+            const View& view = current_view.get();
+            if(!membership_check_cache.hit(view.vid, dest_node)) {
+                if(view.rank_of(dest_node) == -1) {
+                    throw invalid_node_exception("Cannot send a p2p request to node "
+                            + std::to_string(dest_node) + ": it is not a member of the Group.");
+                }
+                membership_check_cache.record(view.vid, dest_node);
+            }
         }
+        std::optional<sst::P2PConnection::SendSlot> send_slot;
         auto return_pair = wrapped_this->template send<tag>(
-                [this, &dest_node](size_t size) -> char* {
+                [this, &dest_node, &send_slot](size_t size) -> char* {
                     const std::size_t max_payload_size = group_rpc_manager.view_manager.get_max_payload_sizes().at(subgroup_id);
                     if(size <= max_payload_size) {
-                        return (char*)group_rpc_manager.get_sendbuffer_ptr(dest_node,
-                                                                           sst::REQUEST_TYPE::P2P_REQUEST);
+                        send_slot = group_rpc_manager.reserve_p2p_buffer(dest_node,
+                                                                         sst::REQUEST_TYPE::P2P_REQUEST,
+                                                                         size);
+                        return send_slot->buf;
                     } else {
                         throw derecho_exception("The size of serialized args exceeds the maximum message size.");
                     }
                 },
                 std::forward<Args>(args)...);
-        group_rpc_manager.finish_p2p_send(dest_node, subgroup_id, return_pair.pending);
+        group_rpc_manager.post_p2p_send(dest_node, *send_slot, subgroup_id, return_pair.pending);
         return std::move(return_pair.results);
     } else {
         throw empty_reference_exception{"Attempted to use an empty Replicated<T>"};
     }
 }
 
+template <typename T>
+template <rpc::FunctionTag tag, typename... Args>
+auto ExternalCaller<T>::try_p2p_send(node_id_t dest_node, Args&&... args) {
+    using results_t = decltype(this->template p2p_send<tag>(dest_node, std::forward<Args>(args)...));
+    if(!is_valid()) {
+        throw empty_reference_exception{"Attempted to use an empty Replicated<T>"};
+    }
+    assert(dest_node != node_id);
+    {
+        auto current_view = group_rpc_manager.view_manager.get_current_view();
+        const View& view = current_view.get();
+        if(!membership_check_cache.hit(view.vid, dest_node)) {
+            if(view.rank_of(dest_node) == -1) {
+                return TrySendResult<results_t>{SendStatus::INVALID_MEMBER, std::nullopt};
+            }
+            membership_check_cache.record(view.vid, dest_node);
+        }
+    }
+    std::optional<sst::P2PConnection::SendSlot> send_slot;
+    try {
+        auto return_pair = wrapped_this->template send<tag>(
+                [this, &dest_node, &send_slot](size_t size) -> char* {
+                    const std::size_t max_payload_size = group_rpc_manager.view_manager.get_max_payload_sizes().at(subgroup_id);
+                    if(size <= max_payload_size) {
+                        send_slot = group_rpc_manager.reserve_p2p_buffer(dest_node,
+                                                                         sst::REQUEST_TYPE::P2P_REQUEST,
+                                                                         size);
+                        return send_slot->buf;
+                    } else {
+                        throw derecho_exception("The size of serialized args exceeds the maximum message size.");
+                    }
+                },
+                std::forward<Args>(args)...);
+        group_rpc_manager.post_p2p_send(dest_node, *send_slot, subgroup_id, return_pair.pending);
+        return TrySendResult<results_t>{SendStatus::SUCCESS, std::move(return_pair.results)};
+    } catch(rpc::node_removed_from_group_exception&) {
+        // removed between the membership check and the buffer reservation
+        return TrySendResult<results_t>{SendStatus::INVALID_MEMBER, std::nullopt};
+    }
+}
+template <typename T>
+template <rpc::FunctionTag tag, typename... Args>
+auto ExternalCaller<T>::p2p_send_with_timeout(node_id_t dest_node, std::chrono::milliseconds timeout, Args&&... args) {
+    if(is_valid()) {
+        assert(dest_node != node_id);
+        {
+            auto current_view = group_rpc_manager.view_manager.get_current_view();
+            const View& view = current_view.get();
+            if(!membership_check_cache.hit(view.vid, dest_node)) {
+                if(view.rank_of(dest_node) == -1) {
+                    throw invalid_node_exception("Cannot send a p2p request to node "
+                            + std::to_string(dest_node) + ": it is not a member of the Group.");
+                }
+                membership_check_cache.record(view.vid, dest_node);
+            }
+        }
+        std::optional<sst::P2PConnection::SendSlot> send_slot;
+        auto return_pair = wrapped_this->template send<tag>(
+                [this, &dest_node, &send_slot](size_t size) -> char* {
+                    const std::size_t max_payload_size = group_rpc_manager.view_manager.get_max_payload_sizes().at(subgroup_id);
+                    if(size <= max_payload_size) {
+                        send_slot = group_rpc_manager.reserve_p2p_buffer(dest_node,
+                                                                         sst::REQUEST_TYPE::P2P_REQUEST,
+                                                                         size);
+                        return send_slot->buf;
+                    } else {
+                        throw derecho_exception("The size of serialized args exceeds the maximum message size.");
+                    }
+                },
+                std::forward<Args>(args)...);
+        group_rpc_manager.post_p2p_send(dest_node, *send_slot, subgroup_id, return_pair.pending);
+        group_rpc_manager.schedule_rpc_deadline(subgroup_id, return_pair.pending, timeout);
+        return std::move(return_pair.results);
+    } else {
+        throw empty_reference_exception{"Attempted to use an empty Replicated<T>"};
+    }
+}
+
+template <typename T>
+template <rpc::FunctionTag tag, typename... Args>
+auto ExternalCaller<T>::p2p_send_to_least_loaded(uint32_t shard_num, Args&&... args) {
+    const node_id_t dest_node
+            = group_rpc_manager.view_manager.get_least_loaded_shard_member(subgroup_id, shard_num);
+    return p2p_send<tag>(dest_node, std::forward<Args>(args)...);
+}
+
+template <typename T>
+template <rpc::FunctionTag tag, typename... Args>
+auto ExternalCaller<T>::p2p_send_to_many(const std::vector<node_id_t>& dest_nodes, Args&&... args) {
+    if(is_valid()) {
+        {
+            auto current_view = group_rpc_manager.view_manager.get_current_view();
+            const View& view = current_view.get();
+            for(const node_id_t dest_node : dest_nodes) {
+                assert(dest_node != node_id);
+                if(!membership_check_cache.hit(view.vid, dest_node)) {
+                    if(view.rank_of(dest_node) == -1) {
+                        throw invalid_node_exception("Cannot send a p2p request to node "
+                                + std::to_string(dest_node) + ": it is not a member of the Group.");
+                    }
+                    membership_check_cache.record(view.vid, dest_node);
+                }
+            }
+        }
+        std::vector<std::optional<sst::P2PConnection::SendSlot>> send_slots(dest_nodes.size());
+        auto return_vec = wrapped_this->template send_to_many<tag>(
+                dest_nodes.size(),
+                [this, &dest_nodes, &send_slots](std::size_t dest_index, std::size_t size) -> char* {
+                    const std::size_t max_payload_size = group_rpc_manager.view_manager.get_max_payload_sizes().at(subgroup_id);
+                    if(size <= max_payload_size) {
+                        send_slots[dest_index] = group_rpc_manager.reserve_p2p_buffer(dest_nodes[dest_index],
+                                                                                      sst::REQUEST_TYPE::P2P_REQUEST,
+                                                                                      size);
+                        return send_slots[dest_index]->buf;
+                    } else {
+                        throw derecho_exception("The size of serialized args exceeds the maximum message size.");
+                    }
+                },
+                std::forward<Args>(args)...);
+        using Ret = typename decltype(return_vec.front().results)::type;
+        std::vector<rpc::QueryResults<Ret>> results;
+        results.reserve(return_vec.size());
+        for(std::size_t dest_index = 0; dest_index < return_vec.size(); ++dest_index) {
+            group_rpc_manager.post_p2p_send(dest_nodes[dest_index], *send_slots[dest_index],
+                                            subgroup_id, return_vec[dest_index].pending);
+            results.emplace_back(std::move(return_vec[dest_index].results));
+        }
+        return results;
+    } else {
+        throw empty_reference_exception{"Attempted to use an empty Replicated<T>"};
+    }
+}
+
 template <typename T>
 template <rpc::FunctionTag tag, typename... Args>
 auto ShardIterator<T>::p2p_send(Args&&... args) {
     // shard_reps should have at least one member
-    auto send_result = EC.template p2p_send<tag>(shard_reps.at(0), std::forward<Args>(args)...);
-    std::vector<decltype(send_result)> send_result_vec;
-    send_result_vec.emplace_back(std::move(send_result));
-    for(uint i = 1; i < shard_reps.size(); ++i) {
-        send_result_vec.emplace_back(EC.template p2p_send<tag>(shard_reps[i], std::forward<Args>(args)...));
-    }
-    return send_result_vec;
+    auto per_shard_results = EC.template p2p_send_to_many<tag>(shard_reps, std::forward<Args>(args)...);
+    using Ret = typename decltype(per_shard_results)::value_type::type;
+    return ShardQueryResults<Ret>(std::move(per_shard_results));
 }
 
 }  // namespace derecho
@@ -17,11 +17,17 @@ public:
     virtual std::size_t object_size() const = 0;
     virtual void send_object(tcp::socket& receiver_socket) const = 0;
     virtual void send_object_raw(tcp::socket& receiver_socket) const = 0;
+    virtual std::size_t serialize_object(char* buffer) const = 0;
     virtual std::size_t receive_object(char* buffer) = 0;
     virtual bool is_persistent() const = 0;
     virtual void make_version(const persistent::version_t& ver, const HLC& hlc) noexcept(false) = 0;
     virtual const persistent::version_t get_minimum_latest_persisted_version() noexcept(false) = 0;
+    virtual const persistent::version_t get_maximum_earliest_version() noexcept(false) = 0;
+    virtual std::size_t get_log_tail_size(const persistent::version_t& earliest_version) = 0;
+    virtual void send_log_tail(tcp::socket& receiver_socket, const persistent::version_t& earliest_version) = 0;
+    virtual std::size_t apply_log_tail(char* buffer) = 0;
     virtual void persist(const persistent::version_t version) noexcept(false) = 0;
+    virtual const persistent::version_t trim_to_safe_point(const persistent::version_t& upper_bound) noexcept(false) = 0;
     virtual void truncate(const persistent::version_t& latest_version) = 0;
     virtual void post_next_version(const persistent::version_t& version, const uint64_t& msg_ts) = 0;
 };
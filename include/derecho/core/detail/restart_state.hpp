@@ -3,6 +3,7 @@
 #include <cstdint>
 #include <map>
 #include <memory>
+#include <mutex>
 #include <sstream>
 #include <string>
 #include <vector>
@@ -110,15 +111,38 @@ private:
     std::vector<std::vector<int64_t>> nodes_with_longest_log;
     const node_id_t my_id;
 
+    /**
+     * Guards the shared restart bookkeeping (curr_view, logged_ragged_trim,
+     * the longest-log maps, and the rejoined-node collections) while
+     * await_quorum's log-receiver threads run concurrently with the accept
+     * loop. After await_quorum returns all receiver threads have been joined,
+     * so the later phases of the restart protocol do not need the lock.
+     */
+    std::mutex joiner_data_mutex;
+
     /**
      * Helper method for await_quorum that processes the logged View and
      * RaggedTrims from a single rejoining node. This may update curr_view or
-     * logged_ragged_trim if the joiner has newer information.
+     * logged_ragged_trim if the joiner has newer information. The logs are
+     * read off the socket before joiner_data_mutex is acquired, so one
+     * joiner's merge overlaps with other joiners' network transfers.
      * @param joiner_id The ID of the rejoining node
      * @param client_socket The TCP socket connected to the rejoining node
      */
     void receive_joiner_logs(const node_id_t& joiner_id, tcp::socket& client_socket);
 
+    /**
+     * Runs on a separate thread for each rejoining node: receives the node's
+     * logs (via receive_joiner_logs) and its ports, then publishes the node
+     * into the rejoined-node collections under joiner_data_mutex, so that
+     * has_restart_quorum only ever sees fully-received joiners.
+     * @param joiner_id The ID of the rejoining node
+     * @param client_socket The TCP socket connected to the rejoining node,
+     * which this thread takes ownership of until it is stored in
+     * waiting_join_sockets
+     */
+    void receive_joiner_data(node_id_t joiner_id, tcp::socket client_socket);
+
     /**
      * Recomputes the restart view based on the current set of nodes that have
      * rejoined (in waiting_join_sockets and rejoined_node_ids). This just ties
@@ -144,7 +168,9 @@ public:
      * Waits for nodes to rejoin at this node, updating the last known View and
      * RaggedTrim (and corresponding longest-log information) as each node connects,
      * until there is a quorum of nodes from the last known View and a new View
-     * can be installed that is adequately provisioned.
+     * can be installed that is adequately provisioned. Each rejoining node's
+     * logs are received on a separate thread, so many nodes can send their
+     * logs concurrently; all of these threads finish before this returns.
      * @param server_socket The TCP socket to listen for rejoining nodes on
      */
     void await_quorum(tcp::connection_listener& server_socket);
@@ -6,11 +6,18 @@
 
 #pragma once
 
+#include <algorithm>
+#include <chrono>
 #include <exception>
 #include <functional>
+#include <list>
 #include <map>
 #include <memory>
 #include <mutex>
+#include <set>
+#include <tuple>
+#include <type_traits>
+#include <utility>
 #include <vector>
 
 #include "../derecho_type_definitions.hpp"
@@ -39,15 +46,124 @@ namespace rpc {
 
 using PendingBase_ref = std::reference_wrapper<PendingBase>;
 
+/**
+ * Detects whether a user-provided class declares the static method
+ * order_insensitive_tags(), which is generated by the ORDER_INSENSITIVE_TAGS
+ * macro. Classes that don't use the macro have no order-insensitive functions.
+ */
+template <typename T, typename = void>
+struct declares_order_insensitive_tags : std::false_type {};
+template <typename T>
+struct declares_order_insensitive_tags<T, std::void_t<decltype(T::order_insensitive_tags())>> : std::true_type {};
+
+/**
+ * Detects whether a user-provided class declares the static method
+ * reduced_reply_tags(), which is generated by the REDUCED_REPLY_TAGS macro.
+ * Classes that don't use the macro have no reducible replies.
+ */
+template <typename T, typename = void>
+struct declares_reduced_reply_tags : std::false_type {};
+template <typename T>
+struct declares_reduced_reply_tags<T, std::void_t<decltype(T::reduced_reply_tags())>> : std::true_type {};
+
 class RPCManager {
     static_assert(std::is_trivially_copyable<Opcode>::value, "Oh no! Opcode is not trivially copyable!");
     /** The ID of the node this RPCManager is running on. */
     const node_id_t nid;
+    /** Maximum size of a complete reply message that may be sent through the
+     * SST piggyback lane instead of a p2p send; 0 disables piggybacking.
+     * From DERECHO/piggyback_reply_payload_size. */
+    const uint64_t piggyback_reply_max_size;
+    /** True if member-to-member p2p connections are established lazily on
+     * first use instead of eagerly at view install.
+     * From DERECHO/lazy_member_p2p. */
+    const bool lazy_member_p2p;
     /** A map from FunctionIDs to RPC functions, either the "server" stubs that receive
      * remote calls to invoke functions, or the "client" stubs that receive responses
      * from the targets of an earlier remote call.
      * Note that a FunctionID is (class ID, subgroup ID, Function Tag). */
-    std::unique_ptr<std::map<Opcode, receive_fun_t>> receivers;
+    std::unique_ptr<receiver_map_t> receivers;
+    /**
+     * One subgroup's level of the receive dispatch table: a small
+     * open-addressed hash table over (function tag, is-reply), sized to a
+     * power of two with half its slots free at build time, so the common
+     * case is a single probe. Entries point at the receive functions owned
+     * by the receivers map, whose node-based storage keeps them stable until
+     * their class is deregistered.
+     */
+    struct SubgroupDispatchTable {
+        struct Entry {
+            FunctionTag function_id;
+            bool is_reply;
+            const receive_fun_t* receiver = nullptr;
+        };
+        std::vector<Entry> entries;
+
+        const receive_fun_t* lookup(FunctionTag function_id, bool is_reply) const {
+            if(entries.empty()) {
+                return nullptr;
+            }
+            const std::size_t mask = entries.size() - 1;
+            std::size_t slot = slot_hash(function_id, is_reply) & mask;
+            while(entries[slot].receiver != nullptr) {
+                if(entries[slot].function_id == function_id
+                   && entries[slot].is_reply == is_reply) {
+                    return entries[slot].receiver;
+                }
+                slot = (slot + 1) & mask;
+            }
+            return nullptr;
+        }
+
+        static std::size_t slot_hash(FunctionTag function_id, bool is_reply) {
+            //function tags are string hashes, so one 64-bit finalizer round
+            //is enough to spread them over the table
+            uint64_t hash_code = function_id ^ (static_cast<uint64_t>(is_reply) << 63);
+            hash_code ^= hash_code >> 33;
+            hash_code *= 0xff51afd7ed558ccdull;
+            hash_code ^= hash_code >> 33;
+            return hash_code;
+        }
+    };
+    /**
+     * First level of the receive dispatch table, indexed directly by subgroup
+     * ID, making receive-side dispatch one indexed load plus one small-table
+     * probe. The class ID in the Opcode is redundant for dispatch, since each
+     * subgroup hosts exactly one class. Rebuilt from the receivers map
+     * whenever a class is registered or deregistered, which only happens
+     * while the receiving threads are quiescent (setup and view changes).
+     */
+    std::vector<SubgroupDispatchTable> dispatch_by_subgroup;
+
+    /** Rebuilds dispatch_by_subgroup from the current contents of receivers. */
+    void rebuild_dispatch_table();
+    /** The (subgroup ID, function tag) pairs that were marked order-insensitive
+     * with the ORDER_INSENSITIVE_TAGS macro, collected when their classes'
+     * receive functions are registered. Consulted by MulticastGroup (through
+     * is_order_insensitive_rpc) to decide whether a cooked message can be
+     * delivered on local receipt instead of in the global order. */
+    std::set<std::pair<subgroup_id_t, FunctionTag>> order_insensitive_opcodes;
+    /** Type-erased functions that combine two serialized reply values for a
+     * function marked with the REDUCED_REPLY_TAGS macro, writing the combined
+     * value over the first operand. Keyed by the function's reply opcode;
+     * populated when the function's class is registered. A reply opcode with
+     * an entry here is routed up the shard's reply-reduction tree instead of
+     * straight back to the caller. */
+    std::map<Opcode, std::function<void(char*, const char*)>> reply_combiners;
+    /** A partially-combined reply making its way up a reply-reduction tree:
+     * the serialized reply payload so far, and the number of contributions
+     * (this node's own reply plus one per tree child) still outstanding. */
+    struct ReductionState {
+        std::size_t contributions_remaining;
+        std::vector<char> reply_payload;
+    };
+    /** In-progress reply reductions, keyed by (reply opcode, caller node,
+     * invocation ID). Cleared on a view change, like the pending results of
+     * the calls they belong to. */
+    std::map<std::tuple<Opcode, node_id_t, long int>, ReductionState> pending_reductions;
+    /** Guards pending_reductions, which is touched by both the P2P listening
+     * thread (child replies) and the predicate thread (local delivery). */
+    std::mutex reductions_mutex;
     /** An emtpy DeserializationManager, in case we need it later. */
     // mutils::DeserializationManager dsm{{}};
     // Weijia: I prefer the deserialization context vector.
@@ -81,9 +197,51 @@ class RPCManager {
     /** Notified when the P2P listening thread should start. */
     std::condition_variable thread_start_cv;
     std::atomic<bool> thread_shutdown{false};
+    /** Set by the P2P listening thread once the fifo worker pool exists, so
+     * drain_one_p2p_message() never routes a request to a worker queue that
+     * has not been created yet. */
+    std::atomic<bool> fifo_workers_started{false};
     std::thread rpc_thread;
-    /** p2p send and queries are queued in fifo worker */
-    std::thread fifo_worker_thread;
+    /** Accepts handshakes from ExternalGroupClients; only started when
+     * DERECHO/external_port is nonzero. */
+    std::thread external_client_thread;
+    /** Listens on DERECHO/external_port and, for each client that completes
+     * the handshake (see detail/external_client_protocol.hpp), opens the
+     * SST-level connection and an on-demand P2PConnection, after which the
+     * client's requests arrive through the normal p2p receive path. */
+    void external_client_loop();
+    /** A deadline scheduled against one invocation's PendingResults. The
+     * recorded epoch is checked at expiry, so a deadline left over from a
+     * finished invocation cannot affect the pooled object's next one. */
+    struct DeadlineEntry {
+        subgroup_id_t subgroup_id;
+        PendingBase* pending;
+        uint64_t epoch;
+        uint64_t deadline_tick;
+    };
+    /** Number of buckets in the deadline wheel; must be a power of two. */
+    static constexpr std::size_t deadline_wheel_buckets = 256;
+    /** Granularity of the deadline wheel. Deadlines are rounded up to the
+     * next tick, so this is also the expiry precision. */
+    static constexpr std::chrono::milliseconds deadline_tick_interval{10};
+    /** Hashed timer wheel over the pending RPC deadlines: bucket
+     * (deadline_tick % buckets) holds every entry due at that tick, plus the
+     * (rare, with second-scale timeouts) entries due whole revolutions later,
+     * which are skipped until their tick comes around. One wheel serves every
+     * call site that wants a watchdog, so expiry costs no thread or heap
+     * allocation per call. Guarded by deadline_wheel_mutex. */
+    std::vector<std::list<DeadlineEntry>> deadline_wheel;
+    /** The wheel tick most recently processed by the deadline thread. */
+    uint64_t deadline_current_tick = 0;
+    std::mutex deadline_wheel_mutex;
+    /** Started lazily by the first schedule_rpc_deadline call, so groups that
+     * never use deadlines get no extra thread. */
+    std::thread deadline_thread;
+
+    /** Advances the deadline wheel one tick at a time, expiring due entries. */
+    void deadline_thread_loop();
+    /** p2p sends and queries are queued to a pool of fifo workers */
+    std::vector<std::thread> fifo_worker_threads;
     struct fifo_req {
         node_id_t sender_id;
         char* msg_buf;
@@ -97,15 +255,27 @@ class RPCManager {
                                           msg_buf(_msg_buf),
                                           buffer_size(_buffer_size) {}
     };
-    std::queue<fifo_req> fifo_queue;
-    std::mutex fifo_queue_mutex;
-    std::condition_variable fifo_queue_cv;
+    /**
+     * One request queue per fifo worker. Requests are assigned to queues by
+     * sender ID: all of a sender's requests stay FIFO on one worker (the
+     * reply ring of its P2P connection requires replies in request order),
+     * while requests from different senders can be handled in parallel, so
+     * one sender's slow RPC handler no longer head-of-line blocks the whole
+     * group's p2p traffic. The queue objects are heap-allocated because
+     * mutexes and condition variables can't move.
+     */
+    struct fifo_worker_queue {
+        std::queue<fifo_req> requests;
+        std::mutex mutex;
+        std::condition_variable cv;
+    };
+    std::vector<std::unique_ptr<fifo_worker_queue>> fifo_queues;
 
     /** Listens for P2P RPC calls over the RDMA P2P connections and handles them. */
     void p2p_receive_loop();
 
     /** Handle Non-cascading P2P Send and P2P Queries in fifo*/
-    void fifo_worker();
+    void fifo_worker(uint32_t worker_index);
 
     /**
      * Handler to be called by rpc_process_loop each time it receives a
@@ -147,11 +317,85 @@ class RPCManager {
     std::exception_ptr parse_and_receive(char* buf, std::size_t size,
                                          const std::function<char*(int)>& out_alloc);
 
+    /**
+     * Generates and registers the reply combiner for one function of a class
+     * that used the REDUCED_REPLY_TAGS macro, if that function's tag appears
+     * in the class's reduced-tags list. The combiner deserializes two reply
+     * values, applies the chosen operator, and reserializes the result, so it
+     * can only be generated for arithmetic return types; other types are
+     * rejected here with a warning.
+     */
+    template <FunctionTag Tag, typename Ret>
+    void register_reply_combiner_for(uint32_t type_id, uint32_t instance_id,
+                                     const std::vector<std::pair<FunctionTag, ReplyReduction>>& reduced_tags) {
+        for(const auto& tag_and_reduction : reduced_tags) {
+            if(tag_and_reduction.first != Tag) {
+                continue;
+            }
+            if constexpr(std::is_arithmetic_v<Ret>) {
+                const ReplyReduction reduction = tag_and_reduction.second;
+                const Opcode reply_opcode{type_id, instance_id, Tag, true};
+                reply_combiners[reply_opcode] = [reduction](char* accumulated, const char* incoming) {
+                    Ret accumulated_value = *mutils::from_bytes<Ret>(nullptr, accumulated);
+                    Ret incoming_value = *mutils::from_bytes<Ret>(nullptr, incoming);
+                    switch(reduction) {
+                        case ReplyReduction::SUM:
+                            accumulated_value = accumulated_value + incoming_value;
+                            break;
+                        case ReplyReduction::MIN:
+                            accumulated_value = std::min(accumulated_value, incoming_value);
+                            break;
+                        case ReplyReduction::MAX:
+                            accumulated_value = std::max(accumulated_value, incoming_value);
+                            break;
+                    }
+                    mutils::to_bytes(accumulated_value, accumulated);
+                };
+            } else {
+                dbg_default_warn("Ignoring REDUCED_REPLY_TAGS entry for function tag {}: only arithmetic return types can be reduced", Tag);
+            }
+        }
+    }
+
+    /** Unpacks the tag and return type of one registered function so that its
+     * reply combiner can be generated by register_reply_combiner_for. */
+    template <typename UserProvidedClass, FunctionTag Tag, typename Ret, typename... Args>
+    void register_reply_combiner(uint32_t type_id, uint32_t instance_id,
+                                 const std::vector<std::pair<FunctionTag, ReplyReduction>>& reduced_tags,
+                                 const partial_wrapped<Tag, Ret, UserProvidedClass, Args...>&) {
+        register_reply_combiner_for<Tag, Ret>(type_id, instance_id, reduced_tags);
+    }
+    /** Exactly the same, but for const member functions. */
+    template <typename UserProvidedClass, FunctionTag Tag, typename Ret, typename... Args>
+    void register_reply_combiner(uint32_t type_id, uint32_t instance_id,
+                                 const std::vector<std::pair<FunctionTag, ReplyReduction>>& reduced_tags,
+                                 const const_partial_wrapped<Tag, Ret, UserProvidedClass, Args...>&) {
+        register_reply_combiner_for<Tag, Ret>(type_id, instance_id, reduced_tags);
+    }
+
+    /**
+     * Feeds one contribution (this node's own reply, or a child subtree's
+     * already-reduced reply) into the reply reduction for one invocation of a
+     * function with reducible replies. When the last expected contribution
+     * arrives, the combined reply is forwarded to this node's parent in the
+     * reduction tree, or delivered to the local PendingResults if this node
+     * is the caller (the root of the tree).
+     * @param reply_opcode The opcode of the reply being reduced
+     * @param caller_id The node that issued the ordered_send
+     * @param reply_payload The reply payload (exception flag, invocation ID,
+     * and serialized value), without the RPC message header
+     * @param payload_size The size of the payload in bytes
+     */
+    void add_reduction_contribution(const Opcode& reply_opcode, node_id_t caller_id,
+                                    const char* reply_payload, std::size_t payload_size);
+
 public:
     RPCManager(ViewManager& group_view_manager,
                IDeserializationContext* deserialization_context_ptr)
             // mutils::RemoteDeserializationContext_p deserialization_context_ptr = nullptr)
             : nid(getConfUInt32(CONF_DERECHO_LOCAL_ID)),
+              piggyback_reply_max_size(getConfUInt64(CONF_DERECHO_PIGGYBACK_REPLY_PAYLOAD_SIZE)),
+              lazy_member_p2p(getConfBoolean(CONF_DERECHO_LAZY_MEMBER_P2P)),
               receivers(new std::decay_t<decltype(*receivers)>()),
               view_manager(group_view_manager) {
         if(deserialization_context_ptr != nullptr) {
@@ -191,14 +435,32 @@ public:
      */
     template <typename UserProvidedClass, typename FunctionTuple>
     auto make_remote_invocable_class(std::unique_ptr<UserProvidedClass>* cls, uint32_t type_id, uint32_t instance_id, FunctionTuple funs) {
+        //If the class used the ORDER_INSENSITIVE_TAGS macro, remember which of
+        //its functions can be delivered out of order in this subgroup
+        if constexpr(declares_order_insensitive_tags<UserProvidedClass>::value) {
+            for(const FunctionTag& fun_tag : UserProvidedClass::order_insensitive_tags()) {
+                order_insensitive_opcodes.emplace(instance_id, fun_tag);
+            }
+        }
+        //If the class used the REDUCED_REPLY_TAGS macro, generate a reply
+        //combiner for each of its reducible functions
+        if constexpr(declares_reduced_reply_tags<UserProvidedClass>::value) {
+            const auto reduced_tags = UserProvidedClass::reduced_reply_tags();
+            mutils::callFunc([&](const auto&... unpacked_functions) {
+                (register_reply_combiner(type_id, instance_id, reduced_tags, unpacked_functions), ...);
+            },
+                             funs);
+        }
         //FunctionTuple is a std::tuple of partial_wrapped<Tag, Ret, UserProvidedClass, Args>,
         //which is the result of the user calling tag<Tag>(&UserProvidedClass::method) on each RPC method
         //Use callFunc to unpack the tuple into a variadic parameter pack for build_remoteinvocableclass
-        return mutils::callFunc([&](const auto&... unpacked_functions) {
+        auto invocable_class = mutils::callFunc([&](const auto&... unpacked_functions) {
             return build_remote_invocable_class<UserProvidedClass>(nid, type_id, instance_id, *receivers,
                                                                    bind_to_instance(cls, unpacked_functions)...);
         },
-                                funs);
+                                                funs);
+        rebuild_dispatch_table();
+        return invocable_class;
     }
 
     void destroy_remote_invocable_class(uint32_t instance_id);
@@ -223,15 +485,10 @@ public:
      */
     template <typename UserProvidedClass, typename FunctionTuple>
     auto make_remote_invoker(uint32_t type_id, uint32_t instance_id, FunctionTuple funs) {
-        return mutils::callFunc([&](const auto&... unpacked_functions) {
-            //Supply the template parameters for build_remote_invoker_for_class by
-            //asking bind_to_instance for the type of the wrapped<> that corresponds to each partial_wrapped<>
-            return build_remote_invoker_for_class<UserProvidedClass,
-                                                  decltype(bind_to_instance(std::declval<std::unique_ptr<UserProvidedClass>*>(),
-                                                                            unpacked_functions))...>(nid, type_id,
-                                                                                                     instance_id, *receivers);
-        },
-                                funs);
+        auto remote_invoker = build_remote_invoker_from_tuple<UserProvidedClass>(nid, type_id,
+                                                                                 instance_id, *receivers, funs);
+        rebuild_dispatch_table();
+        return remote_invoker;
     }
 
     /**
@@ -243,6 +500,17 @@ public:
      */
     void new_view_callback(const View& new_view);
 
+    /**
+     * Callback for another member's lazy p2p connection request (its
+     * p2p_connect_request bit in the SST, noticed by a ViewManager predicate):
+     * builds this side of the connection so the requester's blocking
+     * memory-region exchange can complete. The exchange happens on a detached
+     * thread, since it blocks on the remote node and must not stall the
+     * predicate thread. Only used when DERECHO/lazy_member_p2p is true.
+     * @param node_id The ID of the member requesting a connection
+     */
+    void p2p_connection_requested(node_id_t node_id);
+
     /**
      * Handler to be called by MulticastGroup when it receives a message that
      * appears to be a "cooked send" RPC message. Parses the message and
@@ -257,6 +525,20 @@ public:
     void rpc_message_handler(subgroup_id_t subgroup_id, node_id_t sender_id,
                              char* msg_buf, uint32_t buffer_size);
 
+    /**
+     * Tests whether a "cooked send" RPC message targets a function that was
+     * marked order-insensitive with the ORDER_INSENSITIVE_TAGS macro. Called
+     * by MulticastGroup when a cooked message first arrives, to decide whether
+     * it can be handed to rpc_message_handler immediately instead of at its
+     * place in the global delivery order.
+     * @param subgroup_id The internal subgroup number of the subgroup this
+     * message was received in
+     * @param msg_buf A buffer containing the message
+     * @param buffer_size The size of the message in the buffer, in bytes
+     * @return True if the message invokes an order-insensitive function
+     */
+    bool is_order_insensitive_rpc(subgroup_id_t subgroup_id, char* msg_buf, uint32_t buffer_size);
+
     /**
      * Sends the next message in the MulticastGroup's send buffer (which is
      * assumed to be an RPC message prepared by earlier functions) and registers
@@ -269,23 +551,85 @@ public:
     bool finish_rpc_send(subgroup_id_t subgroup_id, PendingBase& pending_results_handle);
 
     /**
-     * Retrieves a buffer for sending P2P messages from the RPCManager's pool of
-     * P2P RDMA connections. After filling it with data, the next call to
-     * finish_p2p_send will send it.
+     * Attaches a deadline to an in-flight RPC call: when the timeout elapses,
+     * any destination that has not yet responded is answered with an
+     * rpc_timeout_exception through the call's futures. Expiry is handled by
+     * one shared timer-wheel thread, so callers need no per-call watchdog
+     * thread. The deadline is best-effort (rounded up to the wheel's tick
+     * granularity) and is automatically invalidated if the call completes and
+     * its PendingResults is reused first.
+     * @param subgroup_id The subgroup the call was sent in
+     * @param pending_results_handle The call's "promise object", as passed to
+     * post_p2p_send or finish_rpc_send
+     * @param timeout How long to wait before expiring the call's replies
+     */
+    void schedule_rpc_deadline(subgroup_id_t subgroup_id, PendingBase& pending_results_handle,
+                               std::chrono::milliseconds timeout);
+
+    /**
+     * Reserves a send slot for a P2P message from the RPCManager's pool of
+     * P2P RDMA connections. The reservation is lock-free, so threads sending
+     * to different (or the same) node do not serialize on a mutex. The caller
+     * owns the slot's buffer exclusively, serializes the message directly into
+     * it, then publishes it with post_p2p_send. Blocks (spinning) while the
+     * destination's request window is full.
      * @param dest_id The ID of the node that the P2P message will be sent to
      * @param type The type of P2P message that will be sent
+     * @param msg_size The size of the message, used to route oversized
+     * requests to the large-request lane when one is configured
      */
-    volatile char* get_sendbuffer_ptr(uint32_t dest_id, sst::REQUEST_TYPE type);
+    sst::P2PConnection::SendSlot reserve_p2p_buffer(uint32_t dest_id, sst::REQUEST_TYPE type, uint64_t msg_size = 0);
 
     /**
-     * Sends the next P2P message buffer over an RDMA connection to the specified node,
-     * and registers the "promise object" in pending_results_handle to await its reply.
+     * Publishes a reserved-and-filled P2P send slot over the RDMA connection
+     * to the specified node, and registers the "promise object" in
+     * pending_results_handle to await its reply.
      * @param dest_node The node to send the message to
+     * @param slot The slot returned by reserve_p2p_buffer for this message
      * @param dest_subgroup_id The subgroup ID of the subgroup that node is in
      * @param pending_results_handle A reference to the "promise object" in the
      * send_return for this send.
      */
-    void finish_p2p_send(node_id_t dest_node, subgroup_id_t dest_subgroup_id, PendingBase& pending_results_handle);
+    void post_p2p_send(node_id_t dest_node, const sst::P2PConnection::SendSlot& slot,
+                       subgroup_id_t dest_subgroup_id, PendingBase& pending_results_handle);
+
+    /**
+     * Publishes a read-only snapshot of application state into the query
+     * snapshot region of every P2P connection, where other nodes can fetch it
+     * with one-sided RDMA reads. Requires DERECHO/query_snapshot_size to be
+     * configured; size must be at most that value.
+     * @param data A buffer containing the serialized snapshot
+     * @param size The size of the snapshot in bytes
+     */
+    void publish_query_snapshot(const char* data, std::size_t size);
+
+    /**
+     * Fetches the current query snapshot of the specified node with a direct
+     * RDMA read of its snapshot region, without involving its RPC thread.
+     * Blocks until a consistent (seqlock-validated) snapshot arrives or the
+     * read times out.
+     * @param target_id The ID of the node whose snapshot should be read
+     * @param data_out A buffer to copy the snapshot into; must have room for
+     * DERECHO/query_snapshot_size bytes
+     * @param size_out Set to the size of the fetched snapshot on success
+     * @return True if a consistent snapshot was fetched, false if the target
+     * has never published one or the read timed out
+     * @throws node_removed_from_group_exception If the target node is not a
+     * member of the current view
+     */
+    bool one_sided_query(node_id_t target_id, char* data_out, std::size_t& size_out);
+
+    /**
+     * Takes one polling step of the P2P listening loop on the calling thread,
+     * if the connections are not already being polled elsewhere: probes the
+     * p2p connections and handles at most one received message, exactly as
+     * the listening thread would. Called (through rpc::help_p2p_receive) by
+     * the busy-poll reply wait in rpc_utils.hpp, so a caller spinning on a
+     * latency-critical reply can drain its own connection's completions
+     * instead of waiting for the listening thread to wake it.
+     * @return True if a message was received and handled.
+     */
+    bool drain_one_p2p_message();
 };
 
 //Now that RPCManager is finished being declared, we can declare these convenience types
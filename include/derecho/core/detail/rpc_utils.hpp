@@ -6,24 +6,42 @@
 
 #pragma once
 
+#include <atomic>
+#include <cassert>
+#include <chrono>
+#include <condition_variable>
 #include <cstddef>
+#include <deque>
 #include <exception>
 #include <functional>
 #include <future>
+#include <limits>
 #include <map>
 #include <memory>
+#include <optional>
 #include <set>
 #include <sstream>
 #include <string>
 #include <tuple>
 #include <type_traits>
 #include <typeindex>
+#include <unordered_map>
 #include <utility>
 #include <vector>
 
+/* Coroutine integration (rpc::Task and co_await on QueryResults) is only
+ * compiled when the project is built with C++20 coroutine support; under the
+ * default C++17 build the rest of this header is unaffected. */
+#if defined(__cpp_impl_coroutine)
+#include <coroutine>
+#define DERECHO_HAS_COROUTINES
+#endif
+
 #include "../derecho_exception.hpp"
 #include "../derecho_type_definitions.hpp"
 #include "derecho_internal.hpp"
+#include "recycling_allocator.hpp"
+#include <derecho/conf/conf.hpp>
 #include <derecho/mutils-serialization/SerializationSupport.hpp>
 #include <derecho/utils/logger.hpp>
 #include <mutils/macro_utils.hpp>
@@ -74,6 +92,39 @@ inline bool operator==(const Opcode& lhs, const Opcode& rhs) {
            && lhs.function_id == rhs.function_id && lhs.is_reply == rhs.is_reply;
 }
 
+/**
+ * Hasher for Opcode, so the receive-side dispatch table can be a flat hash
+ * table probed once per message instead of a tree walked with four-field
+ * tuple comparisons. Folds all four fields into one word and runs a 64-bit
+ * finalizer over it, since function_id is already a string hash whose low
+ * bits alone would collide across subgroups.
+ */
+struct OpcodeHash {
+    std::size_t operator()(const Opcode& op) const noexcept {
+        uint64_t hash_code = op.function_id;
+        hash_code ^= (static_cast<uint64_t>(op.class_id) << 32) | op.subgroup_id;
+        hash_code ^= static_cast<uint64_t>(op.is_reply) << 63;
+        hash_code ^= hash_code >> 30;
+        hash_code *= 0xbf58476d1ce4e5b9ull;
+        hash_code ^= hash_code >> 27;
+        hash_code *= 0x94d049bb133111ebull;
+        hash_code ^= hash_code >> 31;
+        return hash_code;
+    }
+};
+
+/**
+ * The built-in operators available for combining the replies to an
+ * ordered_send up a reduction tree of shard members, selected per function
+ * with the REDUCED_REPLY_TAGS macro. Only functions with arithmetic return
+ * types can have their replies reduced.
+ */
+enum class ReplyReduction : uint8_t {
+    SUM,
+    MIN,
+    MAX
+};
+
 using node_list_t = std::vector<node_id_t>;
 
 /**
@@ -113,6 +164,48 @@ struct sender_removed_from_group_exception : public derecho_exception {
                                 "and can no longer send the RPC message.") {}
 };
 
+/**
+ * Indicates that an RPC call did not receive all of its replies before the
+ * deadline the caller attached to it expired.
+ */
+struct rpc_timeout_exception : public derecho_exception {
+    rpc_timeout_exception()
+            : derecho_exception("The RPC call's deadline expired before all "
+                                "replies were received.") {}
+};
+
+/**
+ * Indicates that a quorum future could not be fulfilled: every destination of
+ * the RPC call has responded, but fewer of them replied with a value than the
+ * quorum size requested (the rest responded with exceptions, e.g. because
+ * they were removed from the group).
+ */
+struct quorum_not_reached_exception : public derecho_exception {
+    quorum_not_reached_exception()
+            : derecho_exception("Fewer nodes replied to the RPC call than "
+                                "the requested quorum size.") {}
+};
+
+/**
+ * Machine-readable reason a destination of an RPC call will never reply with
+ * a value. Recorded by PendingResults as plain data alongside the exception
+ * it sets on the reply future, so callers on hot paths can branch on the
+ * failure (QueryResults::reply_failure() / try_get()) instead of paying for
+ * a throw/catch unwind per disconnected node.
+ */
+enum class ReplyFailure : uint8_t {
+    /** No failure recorded (a value reply arrived, or is still pending). */
+    NONE = 0,
+    /** The destination was removed from the group before replying. */
+    NODE_REMOVED,
+    /** The sending node was removed from its subgroup or shard. */
+    SENDER_REMOVED,
+    /** The caller's deadline expired before the reply arrived. */
+    TIMEOUT,
+    /** The remote RPC function itself raised an exception. */
+    REMOTE_EXCEPTION,
+};
+
 /**
  * Return type of all the RemoteInvocable::receive_* methods. If the method is
  * receive_call, this struct contains the message to send in reply, along with
@@ -136,12 +229,76 @@ using receive_fun_t = std::function<recv_ret(
         mutils::RemoteDeserialization_v* rdv, const node_id_t&, const char* recv_buf,
         const std::function<char*(int)>& out_alloc)>;
 
+/**
+ * The receive-side dispatch table mapping each Opcode to its handler. A flat
+ * hash table keyed by OpcodeHash, so dispatching an incoming message costs a
+ * single hashed probe on the receive path.
+ */
+using receiver_map_t = std::unordered_map<Opcode, receive_fun_t, OpcodeHash>;
+
 /**
  * The type of map contained in a QueryResults::ReplyMap. The template parameter
- * should be the return type of the query.
+ * should be the return type of the query. Since one of these maps is built and
+ * torn down on every RPC invocation, its tree nodes come from a
+ * recycling_allocator rather than plain malloc.
  */
 template <typename T>
-using reply_map = std::map<node_id_t, std::future<T>>;
+using reply_map = std::map<node_id_t, std::future<T>, std::less<node_id_t>,
+                           recycling_allocator<std::pair<const node_id_t, std::future<T>>>>;
+
+/**
+ * A set of node IDs with pooled node allocation, used for the per-invocation
+ * destination and responder bookkeeping in PendingResults.
+ */
+using node_id_set = std::set<node_id_t, std::less<node_id_t>, recycling_allocator<node_id_t>>;
+
+template <typename Ret>
+class PendingResults;
+
+/**
+ * Takes one polling step of the p2p receive path on the calling thread:
+ * probes the RDMA p2p connections and, if a message has arrived, handles it
+ * exactly as the RPC listening thread would (replies are delivered inline,
+ * requests are queued to the fifo workers). Returns false without blocking
+ * when nothing has arrived or another thread is already polling the
+ * connections. Defined in rpc_manager.cpp; used by the busy-poll wait paths
+ * below so a spinning caller can drain its own reply instead of waiting for
+ * the listening thread to wake it.
+ */
+bool help_p2p_receive();
+
+/**
+ * Busy-polls a future for up to DERECHO/p2p_spin_wait_us microseconds,
+ * helping the p2p receive path along while it spins, before parking the
+ * calling thread on a blocking wait. With a spin window configured, a reply
+ * that arrives while the caller is polling is observed without a futex wake
+ * from the receive thread, trading a core for the several microseconds of
+ * scheduler latency that wake costs on each p2p query. The default window of
+ * zero blocks immediately, preserving the original behavior. The blocking
+ * methods of QueryResults call this internally; it is also useful directly
+ * on the futures returned by get_first_reply() and get_quorum_reply(),
+ * which the caller otherwise waits on itself.
+ */
+template <typename FutureType>
+void busy_poll_then_wait(const FutureType& fut) {
+    const uint32_t spin_us = getConfSnapshot().p2p_spin_wait_us;
+    if(spin_us > 0 && fut.wait_for(std::chrono::seconds::zero()) != std::future_status::ready) {
+        const auto spin_deadline = std::chrono::steady_clock::now()
+                                   + std::chrono::microseconds(spin_us);
+        do {
+            if(help_p2p_receive()) {
+                //A message was drained, so re-check the future right away:
+                //it may have been this caller's reply
+                continue;
+            }
+#if defined(__x86_64__) || defined(__i386__)
+            asm volatile("pause");
+#endif
+        } while(fut.wait_for(std::chrono::seconds::zero()) != std::future_status::ready
+                && std::chrono::steady_clock::now() < spin_deadline);
+    }
+    fut.wait();
+}
 
 /**
  * Data structure that (indirectly) holds a set of futures for a single RPC
@@ -152,6 +309,11 @@ using reply_map = std::map<node_id_t, std::future<T>>;
  * it is "fulfilled" by the sender, which should happen when the RPC call
  * is delivered in the current View (and thus, the current View is the set
  * of nodes who should reply to the RPC).
+ *
+ * As an alternative to blocking on the futures, continuations can be attached
+ * with then() and on_all_replies(); these run on the RPC receive thread (or on
+ * an executor registered with set_callback_executor) as replies arrive, so a
+ * caller can drive many outstanding queries without parking a thread on each.
  * @tparam Ret The return type of the RPC function that this query invoked
  */
 template <typename Ret>
@@ -190,11 +352,13 @@ public:
         Ret get(const node_id_t& nid) {
             if(rmap.size() == 0) {
                 assert(parent.pending_rmap.valid());
+                busy_poll_then_wait(parent.pending_rmap);
                 rmap = std::move(*parent.pending_rmap.get());
             }
             assert(rmap.size() > 0);
             assert(rmap.count(nid));
             assert(rmap.at(nid).valid());
+            busy_poll_then_wait(rmap.at(nid));
             return rmap.at(nid).get();
         }
     };
@@ -203,12 +367,32 @@ public:
 
 private:
     ReplyMap replies{*this};
+    /** The PendingResults this QueryResults was created from, used to attach
+     * continuations. Stable for the lifetime of the invocation: it points
+     * into the invoker's preallocated results_vector. */
+    PendingResults<Ret>* pending_parent;
+
+    /** Shared between next_reply() and the continuations that feed it, since
+     * replies can keep arriving on the receive thread after this QueryResults
+     * is destroyed. Allocated lazily by the first call to next_reply(). */
+    struct CompletionQueue {
+        std::mutex queue_mutex;
+        std::condition_variable queue_nonempty;
+        /** Value replies that have arrived but not yet been returned. */
+        std::deque<std::pair<node_id_t, Ret>> ready_replies;
+        /** True once every destination has responded; no more pushes follow. */
+        bool all_responded = false;
+    };
+    std::shared_ptr<CompletionQueue> completion_queue;
 
 public:
-    QueryResults(map_fut pm) : pending_rmap(std::move(pm)) {}
+    QueryResults(map_fut pm, PendingResults<Ret>* pending_parent = nullptr)
+            : pending_rmap(std::move(pm)), pending_parent(pending_parent) {}
     QueryResults(QueryResults&& o)
             : pending_rmap{std::move(o.pending_rmap)},
-              replies{std::move(o.replies)} {}
+              replies{std::move(o.replies)},
+              pending_parent{o.pending_parent},
+              completion_queue{std::move(o.completion_queue)} {}
     QueryResults(const QueryResults&) = delete;
 
     /**
@@ -234,12 +418,127 @@ public:
      */
     ReplyMap& get() {
         using namespace std::chrono;
+        if(replies.rmap.size() == 0) {
+            busy_poll_then_wait(pending_rmap);
+        }
         while(true) {
             if(auto rmap = wait(5min)) {
                 return *rmap;
             }
         }
     }
+
+    /**
+     * Attaches a continuation that is invoked once per replying node with
+     * that node's reply value, as an alternative to retrieving values through
+     * the futures. Replies that arrived before the continuation was attached
+     * are delivered immediately from this thread; later ones run on the RPC
+     * receive thread or the registered executor. Do not mix then() with
+     * blocking get() on the same nodes' replies: each reply is consumed
+     * exactly once. Exceptions (e.g. for removed nodes) are not routed to the
+     * continuation and must still be observed through the futures or
+     * on_all_replies().
+     */
+    void then(std::function<void(const node_id_t&, const Ret&)> callback);
+
+    /**
+     * Attaches a continuation invoked once, when every destination node has
+     * responded (with a value or an exception). Fires immediately if all
+     * responses have already arrived.
+     */
+    void on_all_replies(std::function<void()> callback);
+
+    /**
+     * Returns a future fulfilled with the first reply value to arrive, for
+     * read-style queries where any single replica's answer suffices: the
+     * caller waits min-over-replicas instead of max-over-replicas, and the
+     * remaining replies are discarded as they arrive. Equivalent to
+     * get_quorum_reply(1). Consumes every node's reply, so do not mix with
+     * get() or then() on the same QueryResults.
+     */
+    std::future<Ret> get_first_reply();
+
+    /**
+     * Returns a future fulfilled with the quorum_size-th reply value to
+     * arrive, waiting for only that many of the destinations instead of all
+     * of them; replies beyond the quorum are discarded as they arrive. If
+     * every destination responds but fewer than quorum_size of them reply
+     * with a value, the future receives a quorum_not_reached_exception.
+     * Waiting for all replies remains the default, via get(). Consumes every
+     * node's reply, so do not mix with get() or then() on the same
+     * QueryResults.
+     */
+    std::future<Ret> get_quorum_reply(std::size_t quorum_size);
+
+    /**
+     * Returns the replies in the order they complete, rather than keyed by
+     * node: each call blocks until some destination that has not yet been
+     * returned replies with a value, then returns that (node ID, value) pair.
+     * Returns std::nullopt once every destination has responded and all value
+     * replies have been returned, so a caller can fold over the replies with
+     * a simple while loop, overlapping its aggregation work with the slower
+     * repliers. Destinations that respond with an exception (e.g. because
+     * they were removed from the group) are skipped, not thrown; detect an
+     * incomplete fold by counting the pairs returned. Consumes every node's
+     * reply, so do not mix with get() or then() on the same QueryResults.
+     */
+    std::optional<std::pair<node_id_t, Ret>> next_reply();
+
+    /**
+     * Routes all subsequently-fired continuations through the given executor
+     * (a callable that accepts a task and schedules it) instead of running
+     * them inline on the RPC receive thread. Must be called before then() or
+     * on_all_replies().
+     */
+    void set_callback_executor(std::function<void(std::function<void()>)> executor);
+
+    /**
+     * Non-throwing counterpart of ReplyMap::get(): blocks until the node
+     * responds, then returns its reply value, or std::nullopt if the node
+     * responded with a failure (removed from the group, timeout, or a remote
+     * exception) or was never a destination of this call. The reason for a
+     * nullopt is available from reply_failure(), so benign failures cost a
+     * branch instead of a throw/catch unwind.
+     */
+    std::optional<Ret> try_get(const node_id_t& nid) {
+        if(replies.rmap.size() == 0) {
+            busy_poll_then_wait(pending_rmap);
+            if(call_failure() != ReplyFailure::NONE) {
+                return std::nullopt;
+            }
+            replies.rmap = std::move(*pending_rmap.get());
+        }
+        if(replies.rmap.count(nid) == 0) {
+            return std::nullopt;
+        }
+        auto& reply_future = replies.rmap.at(nid);
+        busy_poll_then_wait(reply_future);
+        // the reason is recorded before the future is settled, so a ready
+        // future with no recorded failure is guaranteed to hold a value
+        if(reply_failure(nid) != ReplyFailure::NONE) {
+            return std::nullopt;
+        }
+        return reply_future.get();
+    }
+
+    /**
+     * The failure recorded for one destination's reply, or
+     * ReplyFailure::NONE if it replied (or may still reply) with a value.
+     */
+    ReplyFailure reply_failure(const node_id_t& nid) {
+        return (pending_parent != nullptr) ? pending_parent->get_failure_reason(nid)
+                                           : ReplyFailure::NONE;
+    }
+
+    /**
+     * The failure that settled the whole call before it was delivered
+     * (sender removed or timeout), or ReplyFailure::NONE. When this is set,
+     * get() would throw instead of returning a ReplyMap.
+     */
+    ReplyFailure call_failure() {
+        return (pending_parent != nullptr) ? pending_parent->get_call_failure()
+                                           : ReplyFailure::NONE;
+    }
 };
 
 /**
@@ -252,8 +551,8 @@ public:
 template <>
 class QueryResults<void> {
 public:
-    using map_fut = std::future<std::unique_ptr<std::set<node_id_t>>>;
-    using map = std::set<node_id_t>;
+    using map_fut = std::future<std::unique_ptr<node_id_set>>;
+    using map = node_id_set;
     using type = void;
 
     class ReplyMap {
@@ -287,12 +586,17 @@ public:
 
 private:
     ReplyMap replies{*this};
+    /** The PendingResults<void> this QueryResults was created from, used to
+     * attach the delivery continuation. */
+    PendingResults<void>* pending_parent;
 
 public:
-    QueryResults(map_fut pm) : pending_rmap(std::move(pm)) {}
+    QueryResults(map_fut pm, PendingResults<void>* pending_parent = nullptr)
+            : pending_rmap(std::move(pm)), pending_parent(pending_parent) {}
     QueryResults(QueryResults&& o)
             : pending_rmap{std::move(o.pending_rmap)},
-              replies{std::move(o.replies)} {}
+              replies{std::move(o.replies)},
+              pending_parent{o.pending_parent} {}
     QueryResults(const QueryResults&) = delete;
 
     /**
@@ -318,14 +622,89 @@ public:
      */
     ReplyMap& get() {
         using namespace std::chrono;
+        if(replies.rmap.size() == 0) {
+            busy_poll_then_wait(pending_rmap);
+        }
         while(true) {
             if(auto rmap = wait(5min)) {
                 return *rmap;
             }
         }
     }
+
+    /**
+     * Attaches a continuation invoked once the RPC message has been delivered
+     * and the set of receiving nodes is known (void RPCs generate no replies,
+     * so this is the only completion event). Fires immediately if delivery
+     * has already happened.
+     */
+    void on_delivery(std::function<void()> callback);
 };
 
+#ifdef DERECHO_HAS_COROUTINES
+/**
+ * Return type for detached coroutines that issue RPC calls and co_await their
+ * results. A Task coroutine starts running immediately and returns control to
+ * its caller at its first suspension point, so an RPC handler or application
+ * thread can launch thousands of concurrent operations without parking a
+ * thread on each; the coroutine is resumed by the RPC receive thread (or the
+ * executor registered with set_callback_executor) as awaited replies arrive.
+ * The handle is fire-and-forget: the coroutine frame cleans itself up when it
+ * finishes, and an exception escaping the coroutine is logged and dropped,
+ * like an exception from any other detached continuation.
+ */
+struct Task {
+    struct promise_type {
+        Task get_return_object() noexcept { return {}; }
+        std::suspend_never initial_suspend() noexcept { return {}; }
+        std::suspend_never final_suspend() noexcept { return {}; }
+        void return_void() noexcept {}
+        void unhandled_exception() {
+            dbg_default_error("Exception escaped a detached rpc::Task coroutine");
+        }
+    };
+};
+
+/**
+ * Makes QueryResults awaitable: co_await suspends the coroutine until every
+ * destination node has responded, then resumes it with the fulfilled ReplyMap.
+ * The suspension is registered through on_all_replies(), so the usual
+ * continuation rules apply: resumption happens on the RPC receive thread or
+ * the registered executor, and exceptions from removed nodes surface when the
+ * individual futures in the ReplyMap are read.
+ */
+template <typename Ret>
+auto operator co_await(QueryResults<Ret>& results) {
+    struct awaiter {
+        QueryResults<Ret>& results;
+        bool await_ready() const noexcept { return false; }
+        void await_suspend(std::coroutine_handle<> handle) {
+            //Fires (and thus resumes) immediately if all replies have arrived
+            results.on_all_replies([handle]() { handle.resume(); });
+        }
+        typename QueryResults<Ret>::ReplyMap& await_resume() { return results.get(); }
+    };
+    return awaiter{results};
+}
+
+/**
+ * The awaitable for void RPC calls, which generate no replies: co_await
+ * suspends until the message has been delivered and the set of receiving
+ * nodes is known.
+ */
+inline auto operator co_await(QueryResults<void>& results) {
+    struct awaiter {
+        QueryResults<void>& results;
+        bool await_ready() const noexcept { return false; }
+        void await_suspend(std::coroutine_handle<> handle) {
+            results.on_delivery([handle]() { handle.resume(); });
+        }
+        void await_resume() const noexcept {}
+    };
+    return awaiter{results};
+}
+#endif  // DERECHO_HAS_COROUTINES
+
 /**
  * Abstract base type for PendingResults. This allows us to store a pointer to
  * any template specialization of PendingResults without knowing the template
@@ -336,8 +715,17 @@ public:
     virtual void fulfill_map(const node_list_t&) = 0;
     virtual void set_exception_for_removed_node(const node_id_t&) = 0;
     virtual void set_exception_for_caller_removed() = 0;
+    /** Responds to every destination that has not yet replied with an
+     * rpc_timeout_exception; called by the RPCManager deadline wheel when a
+     * deadline attached to this call expires. */
+    virtual void set_exception_for_timeout() = 0;
     virtual bool all_responded() const = 0;
     virtual void reset() = 0;
+    /** Incremented by reset(). PendingResults objects are pooled and reused
+     * across invocations, so anything that holds a pointer to one beyond a
+     * single invocation (such as a scheduled deadline) records this value and
+     * checks it before acting, to avoid affecting a later call. */
+    std::atomic<uint64_t> invocation_epoch{0};
     virtual ~PendingBase() {}
 };
 
@@ -357,20 +745,77 @@ private:
      * when the RPC function call is actually sent and the set of repliers is known. */
     std::promise<std::unique_ptr<reply_map<Ret>>> promise_for_pending_map;
 
-    std::promise<std::map<node_id_t, std::promise<Ret>>> promise_for_reply_promises;
-    /** A future for a map containing one promise for each reply to the RPC function
-     * call. It will be fulfilled when fulfill_map is called, which means the RPC
-     * function call was actually sent and the set of destination nodes is known. */
-    std::future<std::map<node_id_t, std::promise<Ret>>> reply_promises_are_ready;
-    std::mutex reply_promises_are_ready_mutex;
-    std::map<node_id_t, std::promise<Ret>> reply_promises;
+    /** Fulfilled by fulfill_map once the flat reply storage below has been
+     * constructed. Reply threads wait on it before indexing into the storage;
+     * a shared_future because wait() must be safe from several threads. */
+    std::promise<void> promises_constructed;
+    std::shared_future<void> promises_ready;
+    /** The destination nodes, in the order they were contacted. A reply's
+     * storage slot is its node's index here; shards are small, so the linear
+     * scan in destination_index is cheaper than a map lookup. */
+    std::vector<node_id_t> dest_nodes;
+    /** Preconstructed promise for each destination's reply, indexed like
+     * dest_nodes. */
+    std::vector<std::promise<Ret>> reply_promises;
+    /** One completion bit per destination, claimed (exchanged to true) before
+     * its promise is touched so each slot is fulfilled at most once even when
+     * a reply races with a removed-node exception. */
+    std::unique_ptr<std::atomic<bool>[]> responded;
+    std::atomic<std::size_t> num_responded{0};
+    std::atomic<bool> map_fulfilled{false};
+    /** Claimed (exchanged to true) before promise_for_pending_map is touched,
+     * so a deadline expiry or caller-removed exception racing with fulfill_map
+     * settles the map promise exactly once. */
+    std::atomic<bool> map_promise_claimed{false};
+
+    /** Guards the completion bits' claiming and the continuation pointers
+     * below, so a reply is delivered exactly once: either from the
+     * already-responded snapshot taken at registration, or via the
+     * continuation. The critical sections are a few loads and stores; the
+     * promises themselves are fulfilled outside the lock. */
+    std::mutex callbacks_mutex;
+    /** Continuation fired once per reply value, registered via
+     * QueryResults::then(). */
+    std::function<void(const node_id_t&, const Ret&)> per_reply_callback;
+    /** Continuation fired when all destinations have responded, registered
+     * via QueryResults::on_all_replies(). */
+    std::function<void()> all_replies_callback;
+    /** Optional executor for running the continuations off the RPC receive
+     * thread; when empty, continuations run inline. */
+    std::function<void(std::function<void()>)> callback_executor;
+
+    /** Per-destination failure reasons, recorded (under callbacks_mutex, at
+     * the moment the response slot is claimed) whenever a reply promise is
+     * settled with an exception, so QueryResults can report the failure as a
+     * branch instead of a rethrow. */
+    std::map<node_id_t, ReplyFailure> failure_reasons;
+    /** The failure that settled the whole-call reply-map promise (sender
+     * removed or timeout before delivery), if any. */
+    std::atomic<ReplyFailure> call_failure{ReplyFailure::NONE};
+
+    /** Returns the index of the given node in dest_nodes, or -1 if it is not
+     * a destination of this call. */
+    int32_t destination_index(const node_id_t& nid) const {
+        for(std::size_t index = 0; index < dest_nodes.size(); ++index) {
+            if(dest_nodes[index] == nid) {
+                return index;
+            }
+        }
+        return -1;
+    }
 
-    bool map_fulfilled = false;
-    std::set<node_id_t> dest_nodes, responded_nodes;
+    /** Runs a continuation task inline or hands it to the executor. */
+    void run_callback(std::function<void()> task) {
+        if(callback_executor) {
+            callback_executor(std::move(task));
+        } else {
+            task();
+        }
+    }
 
 public:
     PendingResults()
-            : reply_promises_are_ready(promise_for_reply_promises.get_future()) {}
+            : promises_ready(promises_constructed.get_future().share()) {}
     virtual ~PendingResults() {}
 
     /**
@@ -379,7 +824,49 @@ public:
      * @return A new QueryResults holding a set of futures for this RPC function call
      */
     QueryResults<Ret> get_future() {
-        return QueryResults<Ret>{promise_for_pending_map.get_future()};
+        return QueryResults<Ret>{promise_for_pending_map.get_future(), this};
+    }
+
+    /**
+     * Registers the per-reply continuation and returns the set of nodes that
+     * had already responded when it was attached; the caller (QueryResults)
+     * delivers those replies itself from its futures, and every later reply
+     * is routed to the continuation from the receive path.
+     */
+    node_id_set register_reply_callback(std::function<void(const node_id_t&, const Ret&)> callback) {
+        std::lock_guard<std::mutex> lock(callbacks_mutex);
+        per_reply_callback = std::move(callback);
+        node_id_set already_responded;
+        for(std::size_t index = 0; index < dest_nodes.size(); ++index) {
+            if(responded[index]) {
+                already_responded.insert(dest_nodes[index]);
+            }
+        }
+        return already_responded;
+    }
+
+    /**
+     * Registers the all-responded continuation; fires it immediately if every
+     * destination has already responded.
+     */
+    void register_completion_callback(std::function<void()> callback) {
+        bool already_complete;
+        {
+            std::lock_guard<std::mutex> lock(callbacks_mutex);
+            already_complete = all_responded();
+            if(!already_complete) {
+                all_replies_callback = std::move(callback);
+            }
+        }
+        if(already_complete) {
+            run_callback(std::move(callback));
+        }
+    }
+
+    /** Sets the executor used for continuations; see QueryResults. */
+    void set_callback_executor(std::function<void(std::function<void()>)> executor) {
+        std::lock_guard<std::mutex> lock(callbacks_mutex);
+        callback_executor = std::move(executor);
     }
 
     /**
@@ -389,16 +876,24 @@ public:
      */
     void fulfill_map(const node_list_t& who) {
         dbg_default_trace("Got a call to fulfill_map for PendingResults<{}>", typeid(Ret).name());
+        dest_nodes.assign(who.begin(), who.end());
+        reply_promises = std::vector<std::promise<Ret>>(dest_nodes.size());
+        responded = std::make_unique<std::atomic<bool>[]>(dest_nodes.size());
+        for(std::size_t index = 0; index < dest_nodes.size(); ++index) {
+            responded[index] = false;
+        }
         std::unique_ptr<reply_map<Ret>> futures_map = std::make_unique<reply_map<Ret>>();
-        std::map<node_id_t, std::promise<Ret>> promises_map;
-        for(const auto& e : who) {
-            futures_map->emplace(e, promises_map[e].get_future());
-        }
-        dest_nodes.insert(who.begin(), who.end());
-        dbg_default_trace("Setting a value for reply_promises_are_ready");
-        promise_for_reply_promises.set_value(std::move(promises_map));
-        promise_for_pending_map.set_value(std::move(futures_map));
+        for(std::size_t index = 0; index < dest_nodes.size(); ++index) {
+            futures_map->emplace(dest_nodes[index], reply_promises[index].get_future());
+        }
         map_fulfilled = true;
+        //Publishes the flat storage to any reply thread already waiting
+        promises_constructed.set_value();
+        //A deadline expiry (or caller-removed exception) that fired before
+        //delivery may have already settled the map promise
+        if(!map_promise_claimed.exchange(true)) {
+            promise_for_pending_map.set_value(std::move(futures_map));
+        }
     }
 
     /**
@@ -407,30 +902,49 @@ public:
      */
     void set_exception_for_caller_removed() {
         if(!map_fulfilled) {
-            promise_for_pending_map.set_exception(
-                    std::make_exception_ptr(sender_removed_from_group_exception{}));
+            if(!map_promise_claimed.exchange(true)) {
+                call_failure.store(ReplyFailure::SENDER_REMOVED);
+                promise_for_pending_map.set_exception(
+                        std::make_exception_ptr(sender_removed_from_group_exception{}));
+            }
         } else {
-            if(reply_promises.size() == 0) {
-                reply_promises = std::move(reply_promises_are_ready.get());
+            //Set exceptions for any nodes that have not yet responded;
+            //set_exception skips slots whose completion bit is already claimed
+            for(const node_id_t& dest_node : dest_nodes) {
+                set_exception(dest_node,
+                              std::make_exception_ptr(sender_removed_from_group_exception{}),
+                              ReplyFailure::SENDER_REMOVED);
             }
-            //Set exceptions for any nodes that have not yet responded
-            for(auto& node_and_promise : reply_promises) {
-                if(responded_nodes.find(node_and_promise.first)
-                   == responded_nodes.end()) {
-                    node_and_promise.second.set_exception(
-                            std::make_exception_ptr(sender_removed_from_group_exception{}));
-                }
+        }
+    }
+
+    void set_exception_for_timeout() {
+        if(!map_fulfilled) {
+            //The call has not even been delivered yet; settle the map promise
+            //itself with the timeout so get() stops blocking. If delivery
+            //happens anyway, fulfill_map finds the promise claimed and the
+            //late replies are absorbed by the (unobservable) reply promises.
+            if(!map_promise_claimed.exchange(true)) {
+                call_failure.store(ReplyFailure::TIMEOUT);
+                promise_for_pending_map.set_exception(
+                        std::make_exception_ptr(rpc_timeout_exception{}));
+            }
+        } else {
+            for(const node_id_t& dest_node : dest_nodes) {
+                set_exception(dest_node,
+                              std::make_exception_ptr(rpc_timeout_exception{}),
+                              ReplyFailure::TIMEOUT);
             }
         }
     }
 
     void set_exception_for_removed_node(const node_id_t& removed_nid) {
         assert(map_fulfilled);
-        if(dest_nodes.find(removed_nid) != dest_nodes.end()
-           && responded_nodes.find(removed_nid) == responded_nodes.end()) {
+        if(destination_index(removed_nid) != -1) {
             set_exception(removed_nid,
                           std::make_exception_ptr(
-                                  node_removed_from_group_exception{removed_nid}));
+                                  node_removed_from_group_exception{removed_nid}),
+                          ReplyFailure::NODE_REMOVED);
         }
     }
 
@@ -441,14 +955,34 @@ public:
      * @param v The value that it returned as the result of the RPC function
      */
     void set_value(const node_id_t& nid, const Ret& v) {
-        std::lock_guard<std::mutex> lock(reply_promises_are_ready_mutex);
-        responded_nodes.insert(nid);
-        if(reply_promises.size() == 0) {
-            dbg_default_trace("PendingResults<{}>::set_value about to wait on reply_promises_are_ready", typeid(Ret).name());
-            dbg_default_flush();
-            reply_promises = std::move(reply_promises_are_ready.get());
+        promises_ready.wait();
+        const int32_t index = destination_index(nid);
+        assert(index != -1);
+        std::function<void(const node_id_t&, const Ret&)> reply_callback;
+        std::function<void()> completion_callback;
+        {
+            std::lock_guard<std::mutex> lock(callbacks_mutex);
+            if(responded[index].exchange(true)) {
+                //The slot was already fulfilled (e.g. by a removed-node
+                //exception that raced with this reply)
+                return;
+            }
+            reply_callback = per_reply_callback;
+            if(++num_responded == dest_nodes.size()) {
+                completion_callback = std::move(all_replies_callback);
+                all_replies_callback = nullptr;
+            }
+        }
+        //The promise is fulfilled outside the lock: the completion bit
+        //guarantees this thread owns the slot, and continuations can safely
+        //touch this object (or send follow-up RPCs) without deadlocking
+        reply_promises[index].set_value(v);
+        if(reply_callback) {
+            run_callback([reply_callback, nid, v]() { reply_callback(nid, v); });
+        }
+        if(completion_callback) {
+            run_callback(std::move(completion_callback));
         }
-        reply_promises.at(nid).set_value(v);
     }
 
     /**
@@ -457,12 +991,48 @@ public:
      * @param nid The node that responded to the RPC call with an exception
      * @param e The exception_ptr that the RPC function call returned
      */
-    void set_exception(const node_id_t& nid, const std::exception_ptr e) {
-        responded_nodes.insert(nid);
-        if(reply_promises.size() == 0) {
-            reply_promises = std::move(reply_promises_are_ready.get());
+    void set_exception(const node_id_t& nid, const std::exception_ptr e,
+                       ReplyFailure reason = ReplyFailure::REMOTE_EXCEPTION) {
+        promises_ready.wait();
+        const int32_t index = destination_index(nid);
+        assert(index != -1);
+        std::function<void()> completion_callback;
+        {
+            std::lock_guard<std::mutex> lock(callbacks_mutex);
+            if(responded[index].exchange(true)) {
+                return;
+            }
+            // record the reason at the same point the slot is claimed, so a
+            // recorded failure and a fulfilled value are mutually exclusive
+            failure_reasons.emplace(nid, reason);
+            // an exception counts as a response for completion purposes, but
+            // is only observable through the future
+            if(++num_responded == dest_nodes.size()) {
+                completion_callback = std::move(all_replies_callback);
+                all_replies_callback = nullptr;
+            }
         }
-        reply_promises.at(nid).set_exception(e);
+        reply_promises[index].set_exception(e);
+        if(completion_callback) {
+            run_callback(std::move(completion_callback));
+        }
+    }
+
+    /**
+     * The failure recorded for one destination's reply, or
+     * ReplyFailure::NONE if that destination replied (or may still reply)
+     * with a value. A branch-only alternative to catching the exception its
+     * reply future rethrows.
+     */
+    ReplyFailure get_failure_reason(const node_id_t& nid) {
+        std::lock_guard<std::mutex> lock(callbacks_mutex);
+        auto search = failure_reasons.find(nid);
+        return (search == failure_reasons.end()) ? ReplyFailure::NONE : search->second;
+    }
+
+    /** The failure that settled the whole call before delivery, if any. */
+    ReplyFailure get_call_failure() const {
+        return call_failure.load();
     }
 
     /**
@@ -470,21 +1040,27 @@ public:
      * responded, either by sending a reply or by being removed from the group
      */
     bool all_responded() const {
-        return map_fulfilled && (responded_nodes == dest_nodes);
+        return map_fulfilled && (num_responded == dest_nodes.size());
     }
 
     /**
      * reset this object.
      */
     void reset() {
+        //Invalidates any still-scheduled deadline for the finished invocation
+        invocation_epoch++;
         promise_for_pending_map = std::promise<std::unique_ptr<reply_map<Ret>>>();
-        promise_for_reply_promises = std::promise<std::map<node_id_t, std::promise<Ret>>>();
-        reply_promises_are_ready = promise_for_reply_promises.get_future();
-        // reply_promises_are_ready_mutex
+        promises_constructed = std::promise<void>();
+        promises_ready = promises_constructed.get_future().share();
+        dest_nodes.clear();
         reply_promises.clear();
+        responded.reset();
+        num_responded = 0;
         map_fulfilled = false;
-        dest_nodes.clear();
-        responded_nodes.clear();
+        map_promise_claimed = false;
+        per_reply_callback = nullptr;
+        all_replies_callback = nullptr;
+        callback_executor = nullptr;
     }
 };
 
@@ -497,42 +1073,257 @@ public:
 template <>
 class PendingResults<void> : public PendingBase {
 private:
-    std::promise<std::unique_ptr<std::set<node_id_t>>> promise_for_pending_map;
+    std::promise<std::unique_ptr<node_id_set>> promise_for_pending_map;
     bool map_fulfilled = false;
+    /** Claimed before promise_for_pending_map is touched, so a deadline
+     * expiry racing with delivery settles the promise exactly once. */
+    std::atomic<bool> map_promise_claimed{false};
+    /** Continuation fired at delivery, registered via
+     * QueryResults<void>::on_delivery(). Guarded by delivery_callback_mutex. */
+    std::function<void()> delivery_callback;
+    std::mutex delivery_callback_mutex;
 
 public:
     QueryResults<void> get_future() {
-        return QueryResults<void>(promise_for_pending_map.get_future());
+        return QueryResults<void>(promise_for_pending_map.get_future(), this);
     }
 
     void fulfill_map(const node_list_t& sent_nodes) {
-        auto nodes_sent_set = std::make_unique<std::set<node_id_t>>();
+        auto nodes_sent_set = std::make_unique<node_id_set>();
         for(const node_id_t& node : sent_nodes) {
             nodes_sent_set->emplace(node);
         }
-        promise_for_pending_map.set_value(std::move(nodes_sent_set));
-        map_fulfilled = true;
+        if(!map_promise_claimed.exchange(true)) {
+            promise_for_pending_map.set_value(std::move(nodes_sent_set));
+        }
+        std::function<void()> callback;
+        {
+            std::lock_guard<std::mutex> lock(delivery_callback_mutex);
+            map_fulfilled = true;
+            callback = std::move(delivery_callback);
+            delivery_callback = nullptr;
+        }
+        if(callback) {
+            callback();
+        }
+    }
+
+    /**
+     * Registers the delivery continuation; fires it immediately if the
+     * message has already been delivered.
+     */
+    void register_delivery_callback(std::function<void()> callback) {
+        bool already_delivered;
+        {
+            std::lock_guard<std::mutex> lock(delivery_callback_mutex);
+            already_delivered = map_fulfilled;
+            if(!already_delivered) {
+                delivery_callback = std::move(callback);
+            }
+        }
+        if(already_delivered) {
+            callback();
+        }
     }
 
     void set_exception_for_removed_node(const node_id_t&) {}
 
     void set_exception_for_caller_removed() {
-        if(!map_fulfilled) {
+        if(!map_fulfilled && !map_promise_claimed.exchange(true)) {
             promise_for_pending_map.set_exception(
                     std::make_exception_ptr(sender_removed_from_group_exception()));
         }
     }
 
+    void set_exception_for_timeout() {
+        //For void calls the only observable event is delivery, so a deadline
+        //only fires if the message was not delivered in time
+        if(!map_fulfilled && !map_promise_claimed.exchange(true)) {
+            promise_for_pending_map.set_exception(
+                    std::make_exception_ptr(rpc_timeout_exception()));
+        }
+    }
+
     bool all_responded() const {
         return map_fulfilled;
     }
 
     void reset() {
-        promise_for_pending_map = std::promise<std::unique_ptr<std::set<node_id_t>>>();
+        invocation_epoch++;
+        promise_for_pending_map = std::promise<std::unique_ptr<node_id_set>>();
         map_fulfilled = false;
+        map_promise_claimed = false;
+        delivery_callback = nullptr;
     }
 };
 
+//Out-of-line definitions of the QueryResults continuation methods, which
+//need the full definition of PendingResults
+
+template <typename Ret>
+void QueryResults<Ret>::then(std::function<void(const node_id_t&, const Ret&)> callback) {
+    assert(pending_parent);
+    //Replies that raced ahead of the registration are delivered here, from
+    //this QueryResults' own futures; everything later comes via the callback
+    node_id_set already_responded = pending_parent->register_reply_callback(callback);
+    for(const node_id_t& nid : already_responded) {
+        //A reply settled with an exception (e.g. a removed node) is in the
+        //responded set too; skip it rather than let the rethrow escape and
+        //drop the remaining already-arrived values. Only the fetch is
+        //guarded, so the continuation's own exceptions still propagate.
+        std::optional<Ret> value;
+        try {
+            value = replies.get(nid);
+        } catch(...) {
+            continue;
+        }
+        callback(nid, *value);
+    }
+}
+
+template <typename Ret>
+std::future<Ret> QueryResults<Ret>::get_first_reply() {
+    return get_quorum_reply(1);
+}
+
+template <typename Ret>
+std::future<Ret> QueryResults<Ret>::get_quorum_reply(std::size_t quorum_size) {
+    assert(pending_parent);
+    assert(quorum_size > 0);
+    //Shared between the two continuations and the returned future, since the
+    //replies may outlive this QueryResults' caller's interest in them
+    struct QuorumState {
+        std::promise<Ret> value_promise;
+        std::atomic<std::size_t> num_values{0};
+        /** Claimed (exchanged to true) before value_promise is touched, so a
+         * quorum-completing value racing with the all-responded continuation
+         * settles the promise exactly once. */
+        std::atomic<bool> settled{false};
+        std::size_t threshold;
+    };
+    auto state = std::make_shared<QuorumState>();
+    state->threshold = quorum_size;
+    std::future<Ret> result = state->value_promise.get_future();
+    //Count (and beyond the threshold, discard) each value reply as it arrives
+    node_id_set already_responded = pending_parent->register_reply_callback(
+            [state](const node_id_t&, const Ret& value) {
+                if(++state->num_values == state->threshold
+                   && !state->settled.exchange(true)) {
+                    state->value_promise.set_value(value);
+                }
+            });
+    //Replies that raced ahead of the registration are counted here, from
+    //this QueryResults' own futures
+    for(const node_id_t& nid : already_responded) {
+        try {
+            const Ret value = replies.get(nid);
+            if(++state->num_values == state->threshold
+               && !state->settled.exchange(true)) {
+                state->value_promise.set_value(value);
+            }
+        } catch(...) {
+            //An exception reply cannot count toward the quorum
+        }
+    }
+    //If every destination responds but too few of them with values, fail the
+    //future rather than leaving the caller blocked forever. Value replies
+    //are counted before this continuation fires, so the check is accurate.
+    pending_parent->register_completion_callback([state]() {
+        if(state->num_values < state->threshold && !state->settled.exchange(true)) {
+            state->value_promise.set_exception(
+                    std::make_exception_ptr(quorum_not_reached_exception{}));
+        }
+    });
+    return result;
+}
+
+template <typename Ret>
+std::optional<std::pair<node_id_t, Ret>> QueryResults<Ret>::next_reply() {
+    assert(pending_parent);
+    if(!completion_queue) {
+        //First call: attach the continuations that feed the queue
+        auto queue = std::make_shared<CompletionQueue>();
+        completion_queue = queue;
+        node_id_set already_responded = pending_parent->register_reply_callback(
+                [queue](const node_id_t& nid, const Ret& value) {
+                    {
+                        std::lock_guard<std::mutex> lock(queue->queue_mutex);
+                        queue->ready_replies.emplace_back(nid, value);
+                    }
+                    queue->queue_nonempty.notify_one();
+                });
+        //Replies that raced ahead of the registration are enqueued here, from
+        //this QueryResults' own futures
+        {
+            std::lock_guard<std::mutex> lock(queue->queue_mutex);
+            for(const node_id_t& nid : already_responded) {
+                try {
+                    queue->ready_replies.emplace_back(nid, replies.get(nid));
+                } catch(...) {
+                    //Exception replies are not part of the value stream
+                }
+            }
+        }
+        //Unblocks the final call(s) once no more replies can arrive. Value
+        //replies are enqueued before this continuation fires, so nothing is
+        //left behind.
+        pending_parent->register_completion_callback([queue]() {
+            {
+                std::lock_guard<std::mutex> lock(queue->queue_mutex);
+                queue->all_responded = true;
+            }
+            queue->queue_nonempty.notify_all();
+        });
+    }
+    //Busy-poll the queue for the configured spin window before blocking on
+    //the condition variable, helping the receive path along in the meantime
+    const uint32_t spin_us = getConfSnapshot().p2p_spin_wait_us;
+    if(spin_us > 0) {
+        const auto spin_deadline = std::chrono::steady_clock::now()
+                                   + std::chrono::microseconds(spin_us);
+        bool queue_ready = false;
+        do {
+            {
+                std::lock_guard<std::mutex> lock(completion_queue->queue_mutex);
+                queue_ready = !completion_queue->ready_replies.empty()
+                              || completion_queue->all_responded;
+            }
+            if(!queue_ready && !help_p2p_receive()) {
+#if defined(__x86_64__) || defined(__i386__)
+                asm volatile("pause");
+#endif
+            }
+        } while(!queue_ready && std::chrono::steady_clock::now() < spin_deadline);
+    }
+    std::unique_lock<std::mutex> lock(completion_queue->queue_mutex);
+    completion_queue->queue_nonempty.wait(lock, [this]() {
+        return !completion_queue->ready_replies.empty() || completion_queue->all_responded;
+    });
+    if(completion_queue->ready_replies.empty()) {
+        return std::nullopt;
+    }
+    std::pair<node_id_t, Ret> next_value = std::move(completion_queue->ready_replies.front());
+    completion_queue->ready_replies.pop_front();
+    return next_value;
+}
+
+template <typename Ret>
+void QueryResults<Ret>::on_all_replies(std::function<void()> callback) {
+    assert(pending_parent);
+    pending_parent->register_completion_callback(std::move(callback));
+}
+
+template <typename Ret>
+void QueryResults<Ret>::set_callback_executor(std::function<void(std::function<void()>)> executor) {
+    assert(pending_parent);
+    pending_parent->set_callback_executor(std::move(executor));
+}
+
+inline void QueryResults<void>::on_delivery(std::function<void()> callback) {
+    assert(pending_parent);
+    pending_parent->register_delivery_callback(std::move(callback));
+}
+
 /**
  * Utility functions for manipulating the headers of RPC messages
  */
@@ -547,10 +1338,28 @@ namespace remote_invocation_utilities {
 // add new rpc header flags here.
 #define _RPC_HEADER_FLAG_CASCADE (0)
 #define _RPC_HEADER_FLAG_RESERVED (1)
-
+// marks a reply that carries a subtree's reduced value up a reply-reduction
+// tree; the "from" field of such a reply is the original caller, not the
+// node that forwarded it
+#define _RPC_HEADER_FLAG_REDUCED (2)
+
+/* Compact wire layout of the RPC message header. The in-memory Opcode struct
+ * used to travel on the wire whole, which together with a size_t length and
+ * 32-bit flags cost 40 bytes per message - a large share of the bytes sent
+ * for small-argument RPCs. The fields are instead packed into 20 bytes:
+ * lengths are bounded by the configured maximum payload sizes (well under
+ * 4GB), subgroup and class IDs are small indexes, only the low few flag bits
+ * are defined, and the opcode's is-reply bit rides in the top bit of the
+ * flags byte. The function tag keeps its full 64 bits, since it is a string
+ * hash. Every member of a view runs an identical binary (the join handshake
+ * compares version hashcodes), so no format negotiation is needed. */
 inline std::size_t header_space() {
-    return sizeof(std::size_t) + sizeof(Opcode) + sizeof(node_id_t) + sizeof(uint32_t);
-    //            size                  operation        from                flags
+    return sizeof(uint32_t)    // size
+           + sizeof(uint32_t)  // from
+           + sizeof(uint64_t)  // function tag
+           + sizeof(uint16_t)  // subgroup ID
+           + sizeof(uint8_t)   // class ID
+           + sizeof(uint8_t);  // flags, with is-reply in the top bit
 }
 
 inline char* extra_alloc(int i) {
@@ -562,15 +1371,23 @@ inline void populate_header(char* reply_buf,
                             const std::size_t& payload_size,
                             const Opcode& op, const node_id_t& from,
                             const uint32_t& flags) {
+    assert(payload_size <= std::numeric_limits<uint32_t>::max());
+    assert(op.subgroup_id <= std::numeric_limits<uint16_t>::max());
+    assert(op.class_id <= std::numeric_limits<uint8_t>::max());
+    assert(flags < 0x80u);
     std::size_t offset = 0;
-    static_assert(sizeof(op) == sizeof(Opcode), "Opcode& is not the same size as Opcode!");
-    reinterpret_cast<std::size_t*>(reply_buf + offset)[0] = payload_size;  // size
-    offset += sizeof(payload_size);
-    reinterpret_cast<Opcode*>(reply_buf + offset)[0] = op;  // what
-    offset += sizeof(op);
-    reinterpret_cast<node_id_t*>(reply_buf + offset)[0] = from;  // from
-    offset += sizeof(from);
-    reinterpret_cast<uint32_t*>(reply_buf + offset)[0] = flags;  // flags
+    reinterpret_cast<uint32_t*>(reply_buf + offset)[0] = static_cast<uint32_t>(payload_size);
+    offset += sizeof(uint32_t);
+    reinterpret_cast<uint32_t*>(reply_buf + offset)[0] = from;
+    offset += sizeof(uint32_t);
+    reinterpret_cast<uint64_t*>(reply_buf + offset)[0] = op.function_id;
+    offset += sizeof(uint64_t);
+    reinterpret_cast<uint16_t*>(reply_buf + offset)[0] = static_cast<uint16_t>(op.subgroup_id);
+    offset += sizeof(uint16_t);
+    reinterpret_cast<uint8_t*>(reply_buf + offset)[0] = static_cast<uint8_t>(op.class_id);
+    offset += sizeof(uint8_t);
+    reinterpret_cast<uint8_t*>(reply_buf + offset)[0]
+            = static_cast<uint8_t>(flags) | (op.is_reply ? 0x80u : 0u);
 }
 
 //inline void retrieve_header(mutils::DeserializationManager* dsm,
@@ -579,13 +1396,19 @@ inline void retrieve_header(mutils::RemoteDeserialization_v* rdv,
                             std::size_t& payload_size, Opcode& op,
                             node_id_t& from, uint32_t& flags) {
     std::size_t offset = 0;
-    payload_size = reinterpret_cast<const std::size_t*>(reply_buf + offset)[0];
-    offset += sizeof(payload_size);
-    op = reinterpret_cast<const Opcode*>(reply_buf + offset)[0];
-    offset += sizeof(op);
-    from = reinterpret_cast<const node_id_t*>(reply_buf + offset)[0];
-    offset += sizeof(from);
-    flags = reinterpret_cast<const uint32_t*>(reply_buf + offset)[0];
+    payload_size = reinterpret_cast<const uint32_t*>(reply_buf + offset)[0];
+    offset += sizeof(uint32_t);
+    from = reinterpret_cast<const uint32_t*>(reply_buf + offset)[0];
+    offset += sizeof(uint32_t);
+    op.function_id = reinterpret_cast<const uint64_t*>(reply_buf + offset)[0];
+    offset += sizeof(uint64_t);
+    op.subgroup_id = reinterpret_cast<const uint16_t*>(reply_buf + offset)[0];
+    offset += sizeof(uint16_t);
+    op.class_id = reinterpret_cast<const uint8_t*>(reply_buf + offset)[0];
+    offset += sizeof(uint8_t);
+    const uint8_t flags_byte = reinterpret_cast<const uint8_t*>(reply_buf + offset)[0];
+    op.is_reply = (flags_byte & 0x80u) != 0;
+    flags = flags_byte & 0x7fu;
 }
 }  // namespace remote_invocation_utilities
 
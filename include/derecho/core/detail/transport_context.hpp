@@ -0,0 +1,101 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <string>
+#include <utility>
+
+#include "../derecho_type_definitions.hpp"
+
+namespace derecho {
+
+/**
+ * Process-wide owner of the RDMA transport singletons: the libfabric (or
+ * verbs) NIC domain and memory-registration state used by SST, the RDMC
+ * helper's equivalents, and their registrations with the shared completion
+ * polling engine. Each ViewManager attaches on startup; the first attach
+ * performs the one-time sst/rdmc initialization, and later attaches from
+ * additional Group instances hosted in the same process only establish
+ * connections to members the context has not seen yet. This lets several
+ * independent Derecho groups share one NIC domain, one registration cache,
+ * and one polling engine instead of each requiring its own process.
+ *
+ * Per-node connections are reference-counted across the attached groups, so
+ * a node leaving one group's view does not tear down the connections of
+ * another group that still lists it as a member.
+ *
+ * Known limitations: all co-hosted groups share the process-wide Conf, so
+ * they run under the same local node id and RDMA device settings, and the
+ * RDMC group-number space is shared, so co-hosted groups whose memberships
+ * overlap must not create RDMC groups with colliding numbers.
+ */
+class TransportContext {
+public:
+    /** Returns the singleton instance, constructing it on first use. */
+    static TransportContext& get();
+
+    /**
+     * Attaches a group to the shared transports. The first call initializes
+     * RDMC and SST with the provided address maps; subsequent calls only add
+     * connections for nodes the context does not already know. The address
+     * maps must have identical key sets (the group's current members).
+     * Returns false if the one-time transport initialization failed, or if
+     * my_id does not match the id the context was initialized with.
+     */
+    bool attach(const std::map<node_id_t, std::pair<ip_addr_t, uint16_t>>& rdmc_addrs_and_ports,
+                const std::map<node_id_t, std::pair<ip_addr_t, uint16_t>>& sst_addrs_and_ports,
+                node_id_t my_id);
+
+    /**
+     * Records that an attached group's view now includes new_id, and
+     * establishes RDMC and SST connections to it unless another attached
+     * group already did.
+     */
+    void add_node(node_id_t new_id,
+                  const std::pair<ip_addr_t, uint16_t>& rdmc_addr_and_port,
+                  const std::pair<ip_addr_t, uint16_t>& sst_addr_and_port);
+
+    /**
+     * Records that an attached group's view no longer includes node_id, and
+     * tears down the RDMC and SST connections to it once no attached group
+     * lists it.
+     */
+    void remove_node(node_id_t node_id);
+
+    /**
+     * Registers a handler to be invoked when the transport layer observes
+     * hard evidence that a node has failed (an RDMA error completion or a
+     * TCP reset on an established connection). Every attached group's handler
+     * is invoked for every failure event, since the transports are shared and
+     * the event does not identify a group. Handlers may run on the completion
+     * engine's polling thread, so they must only record the evidence for
+     * another thread to act on.
+     * @return A handle that can be passed to deregister_failure_handler.
+     */
+    uint32_t register_failure_handler(const std::function<void(node_id_t)>& handler);
+
+    /** Removes a handler previously registered with register_failure_handler. */
+    void deregister_failure_handler(uint32_t handler_id);
+
+private:
+    TransportContext() = default;
+    /** Serializes attach/add/remove against each other. */
+    std::mutex mtx;
+    /** True once the first attach has initialized RDMC and SST. */
+    bool initialized = false;
+    /** The local node id the transports were initialized with. */
+    node_id_t local_id;
+    /** For each connected node, how many attached groups list it as a member. */
+    std::map<node_id_t, unsigned int> node_use_counts;
+    /** Guards the failure-handler map separately from mtx, since handlers are
+     * invoked from the transport's polling thread. */
+    std::mutex failure_handlers_mutex;
+    /** The registered failure handlers, indexed by their handles. */
+    std::map<uint32_t, std::function<void(node_id_t)>> failure_handlers;
+    /** The next handle to assign in register_failure_handler. */
+    uint32_t next_handler_id = 0;
+};
+
+}  // namespace derecho
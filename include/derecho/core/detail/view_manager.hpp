@@ -5,9 +5,13 @@
  */
 #pragma once
 
+#include <atomic>
+#include <condition_variable>
+#include <list>
 #include <map>
 #include <memory>
 #include <mutex>
+#include <optional>
 #include <shared_mutex>
 #include <string>
 #include <thread>
@@ -20,6 +24,7 @@
 #include "multicast_group.hpp"
 #include "restart_state.hpp"
 #include <derecho/conf/conf.hpp>
+#include <derecho/utils/epoch_shared_mutex.hpp>
 
 #include <derecho/mutils-serialization/SerializationSupport.hpp>
 #include <spdlog/spdlog.h>
@@ -82,8 +87,51 @@ struct JoinResponse {
     node_id_t leader_id;
 };
 
+/**
+ * A joining client's request after its TCP handshake has been completed by a
+ * join-handler thread. The SST predicate thread only needs to record these in
+ * the SST, so many joins can handshake in parallel and then be coalesced into
+ * a single view change.
+ */
+struct PendingJoinRequest {
+    node_id_t joiner_id;
+    /** The joiner's IP address, in packed (in_addr) form. */
+    uint32_t joiner_ip_packed;
+    uint16_t gms_port;
+    uint16_t rpc_port;
+    uint16_t sst_port;
+    uint16_t rdmc_port;
+    /** The connection to the joiner, which stays open until its join commits. */
+    tcp::socket socket;
+};
+
+/**
+ * Wall-clock milestones of one view change as observed on this node, all in
+ * nanoseconds from get_time(). Recorded by the GMS triggers as a change
+ * advances, so benchmarks can break a view change's cost into its phases
+ * (suspicion/join -> wedge -> ragged trim -> install). A zero milestone was
+ * not observed locally (e.g. only failure-driven changes start at a
+ * suspicion).
+ */
+struct ViewChangeTiming {
+    /** ID of the view that was replaced. */
+    int32_t old_vid;
+    /** ID of the view that was installed. */
+    int32_t new_vid;
+    /** When this node first saw the change that ended the view (a new
+     * suspicion or a join proposal). */
+    uint64_t change_start_time;
+    /** When this node began wedging the old view. */
+    uint64_t wedge_time;
+    /** When the ragged trim was agreed and persisted, i.e. when the final
+     * phase of the view change began. */
+    uint64_t ragged_trim_time;
+    /** When the new view finished installing (view upcalls delivered). */
+    uint64_t install_time;
+};
+
 template <typename T>
-using SharedLockedReference = LockedReference<std::shared_lock<std::shared_timed_mutex>, T>;
+using SharedLockedReference = LockedReference<std::shared_lock<EpochSharedMutex>, T>;
 
 using view_upcall_t = std::function<void(const View&)>;
 
@@ -111,8 +159,9 @@ private:
      * Mutex to protect the curr_view pointer. Non-SST-predicate threads that
      * access the current View through the pointer should acquire a shared_lock;
      * the view change predicates will acquire a unique_lock before swapping the
-     * pointer. */
-    std::shared_timed_mutex view_mutex;
+     * pointer. Shared acquisitions mark per-thread epoch slots instead of
+     * contending on one lock word, since this sits on every RPC send path. */
+    EpochSharedMutex view_mutex;
     /** Notified when curr_view changes (i.e. we are finished with a pending view change).*/
     std::condition_variable_any view_change_cv;
 
@@ -123,8 +172,26 @@ private:
      *  in the process of transitioning to a new view. */
     std::unique_ptr<View> next_view;
 
-    /** On the leader node, contains client sockets for pending joins that have not yet been handled.*/
-    LockedQueue<tcp::socket> pending_join_sockets;
+    /** Client sockets accepted by the listener thread but not yet handshaken,
+     * awaiting pickup by a join-handler thread. */
+    std::list<tcp::socket> unhandshaken_join_sockets;
+    std::mutex unhandshaken_joins_mutex;
+    std::condition_variable unhandshaken_joins_cv;
+    /** On the leader node, contains join requests whose handshakes have
+     * completed but that have not yet been proposed as membership changes. */
+    LockedQueue<PendingJoinRequest> pending_join_requests;
+
+    /** Node IDs the transport layer reported hard failure evidence for (RDMA
+     * error completions or TCP resets), awaiting pickup by the SST predicate
+     * thread. The transport's handler only enqueues here, because reporting a
+     * failure performs an SST put and so cannot run on the completion engine's
+     * own polling thread. */
+    LockedQueue<node_id_t> transport_suspicions;
+    /** The handle for this ViewManager's handler in the TransportContext's
+     * failure-handler set, so the destructor can deregister it. */
+    uint32_t transport_failure_handler_id;
+    /** True once transport_failure_handler_id is valid. */
+    bool transport_failure_handler_registered = false;
 
     /** Contains old Views that need to be cleaned up. */
     std::queue<std::unique_ptr<View>> old_views;
@@ -137,6 +204,14 @@ private:
      * Helps the SST predicate detect when there's been a change to suspected[].*/
     std::vector<bool> last_suspected;
 
+    /** Milestones of the view change currently in progress, filled in by the
+     * GMS triggers as the change advances (all on the predicate thread). */
+    ViewChangeTiming current_view_change_timing{};
+    /** Timing records of completed view changes, oldest first. Guarded by
+     * view_change_timing_mutex, since benchmarks read it from app threads. */
+    std::vector<ViewChangeTiming> view_change_timings;
+    std::mutex view_change_timing_mutex;
+
     /** The TCP socket the leader uses to listen for joining clients */
     tcp::connection_listener server_socket;
     /** A flag to signal background threads to shut down; set to true when the group is destroyed. */
@@ -144,6 +219,10 @@ private:
     /** The background thread that listens for clients connecting on our server socket. */
     std::thread client_listener_thread;
     std::thread old_view_cleanup_thread;
+    /** Background threads that perform the JoinResponse handshake (or leader
+     * redirect) with joining clients, so that a slow joiner's TCP exchange
+     * never blocks the listener or the SST predicate thread. */
+    std::vector<std::thread> join_handler_threads;
 
     /**
      * A user-configurable option that disables the checks for partitioning events.
@@ -156,14 +235,24 @@ private:
     pred_handle leader_suspicion_handle;
     pred_handle follower_suspicion_handle;
     pred_handle start_join_handle;
-    pred_handle reject_join_handle;
     pred_handle change_commit_ready_handle;
     pred_handle leader_proposed_handle;
     pred_handle leader_committed_handle;
+    pred_handle transport_suspicion_handle;
+    pred_handle p2p_connect_handle;
 
     /** Functions to be called whenever the view changes, to report the
      * new view to some other component. */
     std::vector<view_upcall_t> view_upcalls;
+    /** Called when another member raises its p2p_connect_request bit for this
+     * node, asking it to build its side of a lazily-established p2p
+     * connection; registered by Group (it calls into RPCManager). Only used
+     * when DERECHO/lazy_member_p2p is true. */
+    std::function<void(node_id_t)> p2p_connect_upcall;
+    /** Which members' p2p_connect_request bits have already been acted on in
+     * the current view, so the recurrent predicate fires once per requester.
+     * Reset (to the new view's size) by register_predicates. */
+    std::vector<bool> p2p_connect_handled;
     /** The subgroup membership function, which will be called whenever the view changes. */
     const SubgroupInfo subgroup_info;
     /** Indicates the order that the subgroups should be provisioned;
@@ -210,9 +299,10 @@ private:
 
     /**
      * True if this node is the current leader and is fully active (i.e. has
-     * finished "waking up"), false otherwise.
+     * finished "waking up"), false otherwise. Atomic because the join-handler
+     * threads read it to decide between accepting and redirecting a joiner.
      */
-    bool active_leader;
+    std::atomic<bool> active_leader;
 
     /** The persistence request func is from persistence manager*/
     persistence_manager_callbacks_t persistence_manager_callbacks;
@@ -234,7 +324,7 @@ private:
      */
     std::atomic<bool> bSilent = false;
 
-    bool has_pending_join() { return pending_join_sockets.locked().access.size() > 0; }
+    bool has_pending_join() { return pending_join_requests.locked().access.size() > 0; }
 
     /* ---------------------------- View-management triggers ---------------------------- */
     /**
@@ -242,6 +332,9 @@ private:
      * suspected[] and failed[] arrays but does not propose any changes.
      */
     void new_suspicion(DerechoSST& gmsSST);
+    /** Called when the transport layer has queued failure evidence; reports
+     * each suspected node that is a live member of the current view. */
+    void process_transport_suspicions();
     /**
      * Runs only on the group leader; called whenever there is either a new
      * suspicion or a new join attempt, and proposes a batch of changes to
@@ -249,8 +342,6 @@ private:
      */
     void propose_changes(DerechoSST& gmsSST);
 
-    /** Runs on non-leaders to redirect confused new members to the current leader. */
-    void redirect_join_attempt(DerechoSST& gmsSST);
     /**
      * Runs once on a node that becomes a leader due to a failure. Searches for
      * and re-proposes changes proposed by prior leaders, as well as suspicions
@@ -308,12 +399,26 @@ private:
     /* ------------------- Helper methods for view-management triggers ------------------ */
 
     /**
-     * Assuming this node is the leader, handles a join request from a client.
-     * @param client_socket A TCP socket connected to the joining client
-     * @return True if the join succeeded, false if it failed because the
-     *         client's ID was already in use.
+     * Assuming this node is the leader, proposes a membership change for a
+     * join request whose handshake has already completed.
+     * @param join_request The handshaken join request
+     * @return True if the join was proposed, false if it failed because the
+     *         client's ID is (now) already in use.
+     */
+    bool receive_join(DerechoSST& gmsSST, PendingJoinRequest& join_request);
+    /**
+     * The main loop of a join-handler thread: picks up accepted client
+     * sockets from the listener thread and performs the join handshake with
+     * each one.
      */
-    bool receive_join(DerechoSST& gmsSST, tcp::socket& client_socket);
+    void join_handshake_worker();
+    /**
+     * Performs the TCP handshake with one joining client: exchanges version
+     * codes, and either completes the JoinResponse exchange and queues the
+     * join for the predicate thread (on the leader) or redirects the client
+     * to the current leader (on other nodes).
+     */
+    void perform_join_handshake(tcp::socket client_socket);
 
     /**
      * Assuming the suspected[] array in the SST has changed, searches through
@@ -336,12 +441,22 @@ private:
      * sends the state if necessary. */
     void send_objects_to_new_members(const View& new_view, const vector_int64_2d& old_shard_leaders);
 
-    /** Sends a single subgroup's replicated object to a new member after a view change. */
-    void send_subgroup_object(subgroup_id_t subgroup_id, node_id_t new_node_id);
+    /** Sends a single subgroup's replicated object to a new member after a view
+     * change. Uses RDMA writes when state_transfer_rdma is enabled and the
+     * receiver is a standing member (receiver_has_fabric); otherwise uses the
+     * new member's TCP socket, split over parallel stripe sockets if
+     * state_transfer_stripes is greater than 1. */
+    void send_subgroup_object(subgroup_id_t subgroup_id, node_id_t new_node_id,
+                              bool receiver_has_fabric);
 
     /** Sends a joining node the new view that has been constructed to include it.*/
     void send_view(const View& new_view, tcp::socket& client_socket);
 
+    /** Sends a standing member only the membership changes in the new view,
+     * as a ViewDelta, instead of the whole serialized View. Used in place of
+     * send_view when delta_views is enabled. */
+    void send_view_delta(const View& new_view, tcp::socket& client_socket);
+
     /**
      * Reads the global_min values for the specified subgroup (and the shard
      * that this node belongs to) from the SST, creates a ragged trim vector
@@ -462,6 +577,23 @@ private:
 
     /** Performs one-time global initialization of RDMC and SST, using the current view's membership. */
     void initialize_rdmc_sst();
+
+    /**
+     * Helper for the public sst_barrier functions: increments and pushes this
+     * node's barrier_counter entry, and returns the value the other
+     * participants' entries must reach for the barrier to complete.
+     */
+    uint64_t enter_sst_barrier();
+    /**
+     * Helper for the public sst_barrier functions: waits until the
+     * barrier_counter entry of every live participant has reached the target
+     * value. When subgroup_type is empty the participants are all members of
+     * the current view; otherwise they are the members of this node's shard
+     * of the identified subgroup, re-resolved against the current view on
+     * every scan so the barrier tracks membership across view changes.
+     */
+    void await_sst_barrier(uint64_t target, std::optional<subgroup_type_id_t> subgroup_type,
+                           uint32_t subgroup_index);
     /**
      * Helper for joining an existing group; receives the View and parameters from the leader.
      */
@@ -721,12 +853,58 @@ public:
      */
     const vector_int64_2d& get_old_shard_leaders() const { return prior_view_shard_leaders; }
 
+    /**
+     * Computes the byte range of a serialized Replicated Object that one
+     * stripe socket carries during striped state transfer. The sender and the
+     * receiver each call this to agree on the split, so it is a pure function
+     * of the object's serialized size, the configured stripe count, and the
+     * stripe's index.
+     * @return A pair of (offset, length) within the serialized object.
+     */
+    static std::pair<std::size_t, std::size_t> stripe_range(std::size_t total_size,
+                                                            uint32_t num_stripes,
+                                                            uint32_t stripe_index);
+
     /** Causes this node to cleanly leave the group by setting itself to "failed." */
     void leave();
+    /**
+     * A proactive version of leave() for planned maintenance: drains this
+     * node's in-flight multicasts to a clean cut, announces the departure
+     * over the SST (rip first, then the suspicion bit, so every member sees
+     * a planned departure and the view change starts immediately with no
+     * heartbeat timeout involved), then waits until the remaining members
+     * have wedged before tearing anything down, so this node's RDMC groups
+     * stay available for as long as the rest of the shard needs them.
+     */
+    void graceful_leave();
     /** Returns a vector listing the nodes that are currently members of the group. */
     std::vector<node_id_t> get_members();
     /** Returns the order of this node in the sequence of members of the group */
     int32_t get_my_rank();
+    /** Reads one of this node's performance counters from the current View's SST. */
+    uint64_t read_perf_counter(PerfCounter counter);
+    /**
+     * Reads the cluster-wide total of a performance counter by summing it over
+     * every member's row of the current View's SST. Remote rows are pushed
+     * lazily, so the total may lag slightly behind the true value.
+     */
+    uint64_t read_perf_counter_total(PerfCounter counter);
+    /**
+     * Publishes this node's load metric into its SST row, where the
+     * pick-least-loaded p2p targeting mode reads it. The units are up to the
+     * application (e.g. queue depth or CPU utilization); lower means less
+     * loaded.
+     */
+    void publish_load_metric(uint64_t value);
+    /**
+     * Returns the member of the given shard with the lowest published load
+     * metric (ties broken by rank), skipping failed members. Used by the
+     * pick-least-loaded p2p targeting mode.
+     * @param subgroup_id The internal subgroup ID of the subgroup to query
+     * @param shard_num The shard of that subgroup to pick a member from
+     * @throws derecho_exception if the shard has no live members
+     */
+    node_id_t get_least_loaded_shard_member(subgroup_id_t subgroup_id, uint32_t shard_num);
     /** Returns a vector of vectors listing the members of a single subgroup
      * (identified by type and index), organized by shard number. */
     std::vector<std::vector<node_id_t>> get_subgroup_members(subgroup_type_id_t subgroup_type, uint32_t subgroup_index);
@@ -743,6 +921,28 @@ public:
     void send(subgroup_id_t subgroup_num, long long unsigned int payload_size,
               const std::function<void(char* buf)>& msg_generator, bool cooked_send = false);
 
+    /** Non-blocking variant of send: returns false without sending (and
+     * without calling msg_generator) if the subgroup's send window is full,
+     * so callers can shed or defer load instead of blocking. */
+    bool try_send(subgroup_id_t subgroup_num, long long unsigned int payload_size,
+                  const std::function<void(char* buf)>& msg_generator, bool cooked_send = false);
+
+    /** Sends a raw multicast directly from a user-owned, pre-registered
+     * memory region, without staging it through an internal buffer; blocks
+     * until the message is admitted to the send window. See
+     * MulticastGroup::send_zero_copy for the buffer layout and callback
+     * contract. */
+    void send_zero_copy(subgroup_id_t subgroup_num, std::shared_ptr<rdma::memory_region> user_mr,
+                        size_t offset, long long unsigned int payload_size,
+                        std::function<void()> release_callback);
+
+    /** Forwards to MulticastGroup::get_send_credits for the current view. */
+    int32_t get_send_credits(subgroup_id_t subgroup_num);
+
+    /** Forwards to MulticastGroup::set_send_credits_callback for the current
+     * view; the registration survives view changes. */
+    void set_send_credits_callback(subgroup_id_t subgroup_num, std::function<void()> callback);
+
     const uint64_t compute_global_stability_frontier(subgroup_id_t subgroup_num);
 
     /**
@@ -770,11 +970,44 @@ public:
      * when the view changes to notify another component of the new view. */
     void add_view_upcall(const view_upcall_t& upcall);
 
+    /** Returns the timing milestones of every view change this node has
+     * participated in since it started; see ViewChangeTiming. */
+    std::vector<ViewChangeTiming> get_view_change_timings();
+
+    /** Registers the function to call when another member requests a lazily-
+     * established p2p connection through its SST row; see p2p_connect_upcall.
+     * Must be called before the group starts (Group's constructor does). */
+    void register_p2p_connect_upcall(const std::function<void(node_id_t)>& upcall);
+
     /** Reports to the GMS that the given node has failed. */
     void report_failure(const node_id_t who);
     /** Waits until all members of the group have called this function. */
     void barrier_sync();
 
+    /**
+     * A fast, message-free barrier across all live members of the group,
+     * implemented on the barrier_counter column of the SST: entering the
+     * barrier is one RDMA push of this node's counter and waiting is a
+     * min-scan over the column, so a barrier in which all members have
+     * already arrived completes in microseconds. Returns once every live
+     * member has entered the barrier; members that fail while the barrier
+     * is in progress are excluded from the wait.
+     */
+    void sst_barrier();
+    /**
+     * The same SST barrier restricted to the members of this node's shard of
+     * the given subgroup, identified the same way as in the public Group API.
+     * All live members of that shard must call this for it to complete.
+     *
+     * @param subgroup_type The index of the subgroup's type in the Group's
+     * template parameter list
+     * @param subgroup_index The index of the subgroup among subgroups of
+     * the same type
+     * @throws derecho_exception if this node is not a member of any shard of
+     * the identified subgroup
+     */
+    void sst_barrier(subgroup_type_id_t subgroup_type, uint32_t subgroup_index);
+
     /**
      * Registers a function that will initialize all the RPC objects at this node,
      * given a new view and a list of the shard leaders in the previous view (needed
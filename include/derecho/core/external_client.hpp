@@ -0,0 +1,170 @@
+/**
+ * @file external_client.hpp
+ *
+ * A lightweight client for a Derecho group that is not itself a member: it
+ * runs no SST, joins no RDMC groups, and starts no predicate thread, so it
+ * can come up in milliseconds and consume almost no resources while idle.
+ * An ExternalGroupClient connects to one group member over TCP (the member's
+ * DERECHO/external_port), learns the subgroup layout and p2p buffer
+ * parameters in the handshake, and then establishes a single RDMA
+ * P2PConnection to that member, over which it can invoke p2p RPC functions
+ * on any subgroup the member can reach.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <optional>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "derecho_exception.hpp"
+#include "detail/derecho_internal.hpp"
+#include "detail/external_client_protocol.hpp"
+#include "detail/p2p_connection_manager.hpp"
+#include "detail/remote_invocable.hpp"
+#include "detail/rpc_utils.hpp"
+#include <derecho/conf/conf.hpp>
+#include <derecho/tcp/tcp.hpp>
+
+namespace derecho {
+
+template <typename... ReplicatedTypes>
+class ExternalGroupClient;
+
+/**
+ * The external-client counterpart of ExternalCaller<T>: provides p2p_send for
+ * one subgroup of type T, routed over the client's single connection to the
+ * group member it attached to. Instances are owned by an ExternalGroupClient
+ * and obtained with get_subgroup_caller.
+ */
+template <typename T, typename ExternalGroupType>
+class ExternalClientCaller {
+private:
+    /** The ID of the client node this caller runs on. */
+    const node_id_t node_id;
+    /** The internally-generated subgroup ID of the subgroup this caller contacts. */
+    const subgroup_id_t subgroup_id;
+    /** Reference to the ExternalGroupClient that owns this caller. */
+    ExternalGroupType& group_client;
+    /** The RPC-invoker for T, registered in the client's own receiver map. */
+    std::unique_ptr<rpc::RemoteInvokerForClassOf<T>> wrapped_this;
+
+public:
+    ExternalClientCaller(subgroup_type_id_t type_id, node_id_t nid, subgroup_id_t subgroup_id,
+                         ExternalGroupType& group_client);
+
+    ExternalClientCaller(ExternalClientCaller&&) = default;
+    ExternalClientCaller(const ExternalClientCaller&) = delete;
+
+    /**
+     * Sends a peer-to-peer message to the group member this client is
+     * attached to, invoking the RPC function identified by the FunctionTag
+     * template parameter on this caller's subgroup.
+     * @param args The arguments to the RPC function being invoked
+     * @return An instance of rpc::QueryResults<Ret>, where Ret is the return
+     * type of the RPC function being invoked
+     */
+    template <rpc::FunctionTag tag, typename... Args>
+    auto p2p_send(Args&&... args);
+};
+
+/**
+ * The container a non-member client uses to issue p2p RPC calls into a
+ * running Derecho group, templated on the same list of replicated types as
+ * the group's servers so that type IDs and RPC opcodes agree. Construction
+ * performs the TCP handshake with one group member (see
+ * external_client_protocol.hpp) and builds the RDMA connection; thereafter
+ * the only thread the client runs is a single reply-polling loop.
+ *
+ * Limitations, by design: all calls go through the one member connected at
+ * construction, so a client that wants to survive that member's failure must
+ * construct a new ExternalGroupClient against another member. The server
+ * also tears down connections to clients that stay idle longer than its
+ * DERECHO/external_idle_timeout_ms; a torn-down client must reconnect the
+ * same way.
+ */
+template <typename... ReplicatedTypes>
+class ExternalGroupClient {
+private:
+    template <typename T, typename ExternalGroupType>
+    friend class ExternalClientCaller;
+
+    /** The ID of this client node, from DERECHO/local_id. It must not
+     * collide with the ID of any group member or other external client. */
+    const node_id_t my_id;
+    /** The ID of the group member this client attached to. */
+    node_id_t server_id;
+    /** The server's p2p request slot size; an upper bound on the size of a
+     * serialized request (header included). */
+    uint64_t max_request_size;
+    /** This client's own map from RPC opcodes to receive functions; only
+     * reply handlers are ever looked up in it. */
+    std::unique_ptr<rpc::receiver_map_t> receivers;
+    /** The deserialization context vector handed to reply receivers. */
+    mutils::RemoteDeserialization_v rdv;
+    /** The subgroup IDs hosted by the group for each replicated type,
+     * learned in the handshake. */
+    std::map<subgroup_type_id_t, std::vector<subgroup_id_t>> subgroup_ids_by_type_id;
+    /** Holds the single RDMA connection to the server. */
+    std::unique_ptr<sst::P2PConnectionManager> p2p_connections;
+    /** The ExternalClientCallers created so far, type-erased and keyed by
+     * subgroup ID (each subgroup hosts exactly one type). */
+    std::map<subgroup_id_t, std::shared_ptr<void>> subgroup_callers;
+
+    std::atomic<bool> thread_shutdown{false};
+    /** Polls the connection for RPC replies and dispatches them. */
+    std::thread reply_thread;
+
+    void reply_receive_loop();
+
+public:
+    /**
+     * Connects to the group member at the given address, which must be
+     * running with a nonzero DERECHO/external_port.
+     * @param server_ip The IP address of the group member to attach to
+     * @param server_port The member's DERECHO/external_port
+     * @param deserialization_context An optional context to supply to the
+     * deserializers of RPC reply values
+     */
+    ExternalGroupClient(const std::string& server_ip, uint16_t server_port,
+                        mutils::RemoteDeserializationContext* deserialization_context = nullptr);
+    /**
+     * Convenience constructor that attaches to the group leader, using
+     * DERECHO/leader_ip and DERECHO/external_port from this client's config.
+     */
+    ExternalGroupClient(mutils::RemoteDeserializationContext* deserialization_context = nullptr);
+    ~ExternalGroupClient();
+
+    ExternalGroupClient(const ExternalGroupClient&) = delete;
+
+    /**
+     * Returns the ExternalClientCaller for the given subgroup of the given
+     * type, creating it on first use.
+     * @param subgroup_index The index of the subgroup within the subgroups
+     * of type SubgroupType, as on the servers
+     */
+    template <typename SubgroupType>
+    ExternalClientCaller<SubgroupType, ExternalGroupClient<ReplicatedTypes...>>&
+    get_subgroup_caller(uint32_t subgroup_index = 0);
+
+    /**
+     * Returns the number of subgroups of the given type the group is
+     * running, as reported by the server in the handshake.
+     */
+    template <typename SubgroupType>
+    std::size_t get_number_of_subgroups() const;
+
+    /** Returns the node ID of this client. */
+    node_id_t get_my_id() const { return my_id; }
+    /** Returns the node ID of the group member this client is attached to. */
+    node_id_t get_server_id() const { return server_id; }
+};
+
+}  // namespace derecho
+
+#include "detail/external_client_impl.hpp"
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <chrono>
+#include <condition_variable>
 #include <cstdint>
 #include <ctime>
 #include <exception>
@@ -9,7 +10,9 @@
 #include <map>
 #include <mutex>
 #include <queue>
+#include <set>
 #include <string>
+#include <thread>
 #include <type_traits>
 #include <typeindex>
 #include <utility>
@@ -30,37 +33,9 @@
 #include <mutils-containers/TypeMap2.hpp>
 
 namespace derecho {
-/**
- * The function that implements index_of_type, which is separate to hide the
- * "counter" template parameter (an implementation detail only used to maintain
- * state across recursive calls).
- */
-template <uint32_t counter, typename TargetType, typename FirstType, typename... RestTypes>
-constexpr uint32_t index_of_type_impl() {
-    if constexpr(std::is_same<TargetType, FirstType>::value)
-        return counter;
-    else
-        return index_of_type_impl<counter + 1, TargetType, RestTypes...>();
-}
-
-/**
- * A compile-time "function" that computes the index of a type within a template
- * parameter pack of types. The value of this constant is equal to the index of
- * TargetType within TypePack. (The compiler will spew template errors if
- * TargetType is not actually in TypePack).
- * @tparam TargetType The type to search for in the parameter pack
- * @tparam TypePack The template parameter pack that should be searched
- */
-template <typename TargetType, typename... TypePack>
-constexpr inline uint32_t index_of_type = index_of_type_impl<0, TargetType, TypePack...>();
-
-/**
- * A type-trait-like template that provides a True member "value" if TargetType
- * matches some type in TypePack (according to std::is_same), or provides a
- * False member "value" if TargetType does not match anything in TypePack.
- */
-template <typename TargetType, typename... TypePack>
-using contains = std::integral_constant<bool, (std::is_same<TargetType, TypePack>::value || ...)>;
+//index_of_type and contains, which compute type IDs from the template
+//parameter pack, live in detail/derecho_internal.hpp so that
+//ExternalGroupClient can share them without depending on this header
 
 //Type alias for a sparse-vector of Replicated, otherwise KindMap can't understand it's a template
 template <typename T>
@@ -194,14 +169,59 @@ private:
      */
     std::map<subgroup_id_t, std::reference_wrapper<ReplicatedObject>> objects_by_subgroup_id;
 
+    /** Guards objects_not_yet_ready, for the lazy_object_init option. */
+    std::mutex object_ready_mutex;
+    /** Notified whenever a subgroup ID is removed from objects_not_yet_ready. */
+    std::condition_variable object_ready_cv;
+    /**
+     * When lazy_object_init is enabled, contains the IDs of subgroups whose
+     * Replicated Objects are still being deserialized on background threads.
+     * Ordered-multicast delivery for a subgroup is held until its ID leaves
+     * this set.
+     */
+    std::set<subgroup_id_t> objects_not_yet_ready;
+    /** The background deserialization threads started by finish_object_receive,
+     * one for each Replicated Object still being initialized. */
+    std::list<std::thread> object_init_threads;
+
+    /**
+     * Runs the final local step of receiving a Replicated Object's state (its
+     * deserialization or log merge). When lazy_object_init is disabled this
+     * just runs the action inline; when it is enabled, the action runs on a
+     * background thread and the subgroup is marked not-ready until it
+     * completes, so group startup can continue immediately.
+     * @param subgroup_id The subgroup whose object state is being received
+     * @param deserialize_action A self-contained action that installs the
+     * received state in the Replicated Object and frees any receive buffers.
+     */
+    void finish_object_receive(subgroup_id_t subgroup_id,
+                               const std::function<void()>& deserialize_action);
+
+    /** Blocks until the Replicated Object for the given subgroup has finished
+     * any background deserialization; returns immediately if it has none. */
+    void wait_until_object_ready(subgroup_id_t subgroup_id);
+
+    /**
+     * Joins all outstanding background deserialization threads, ensuring that
+     * every Replicated Object is fully constructed. This must be called before
+     * any code path that can delete or replace a Replicated Object (i.e.
+     * construct_objects or the Group destructor).
+     */
+    void wait_for_pending_object_inits();
+
     /**
      * Updates the state of the replicated objects that correspond to subgroups
      * identified in the provided map, by receiving serialized state from the
      * shard leader whose ID is paired with that subgroup ID.
      * @param subgroups_and_leaders Pairs of (subgroup ID, leader's node ID) for
      * subgroups that need to have their state initialized from the leader.
+     * @param fabric_ready True if this node's RDMA connections are already set
+     * up, which is the case during a view change but not during the initial
+     * state transfer in the constructor; determines whether state can be
+     * received over RDMA when state_transfer_rdma is enabled.
      */
-    void receive_objects(const std::set<std::pair<subgroup_id_t, node_id_t>>& subgroups_and_leaders);
+    void receive_objects(const std::set<std::pair<subgroup_id_t, node_id_t>>& subgroups_and_leaders,
+                         bool fabric_ready);
 
     /** Constructor helper that wires together the component objects of Group. */
     void set_up_components();
@@ -321,6 +341,11 @@ public:
     ShardIterator<SubgroupType> get_shard_iterator(uint32_t subgroup_index = 0);
 
     /** Causes this node to cleanly leave the group by setting itself to "failed."
+     * When only this node is leaving (group_shutdown = false), the departure
+     * is a graceful one: in-flight multicasts drain to a clean cut before the
+     * departure is announced, the view change starts immediately from the
+     * announcement with no failure-detection timeout involved, and this
+     * node's RDMC groups stay up until the remaining members have wedged.
      * @param group_shutdown True if all nodes in the group are going to leave.
      */
     void leave(bool group_shutdown = true);
@@ -339,15 +364,83 @@ public:
     std::int32_t get_my_rank();
     /** Returns the id of local node */
     node_id_t get_my_id();
+    /** Reads one of this node's performance counters (see PerfCounter). */
+    uint64_t read_perf_counter(PerfCounter counter);
+    /**
+     * Reads the cluster-wide total of a performance counter, summed over all
+     * current members. The counters are shared through the SST, so this costs
+     * no messages, but remote contributions may be slightly stale.
+     */
+    uint64_t read_perf_counter_total(PerfCounter counter);
+    /**
+     * Publishes this node's load metric into the SST, where the
+     * pick-least-loaded p2p targeting mode (p2p_send_to_least_loaded) on
+     * other nodes reads it. The units are up to the application — e.g.
+     * request queue depth or CPU utilization — as long as all members of a
+     * shard publish comparable values and lower means less loaded. Costs one
+     * 8-byte RDMA push; publish as often as the metric meaningfully changes.
+     */
+    void publish_load_metric(uint64_t value);
     /** Returns the shard number that this node is a member of in the specified
      * subgroup (by subgroup type and index), or -1 if this node is not a member
      * of any shard in the specified subgroup. */
     template <typename SubgroupType>
     std::int32_t get_my_shard(uint32_t subgroup_index = 0);
+    /**
+     * Publishes a read-only snapshot of application state that other nodes
+     * can fetch with one_sided_query(). The snapshot is copied into a
+     * reserved, versioned region of every P2P RDMA buffer, so remote readers
+     * never involve this node's CPU. Requires DERECHO/query_snapshot_size to
+     * be configured (nonzero); size must be at most that value.
+     * @param data A buffer containing the serialized snapshot
+     * @param size The size of the snapshot in bytes
+     */
+    void publish_query_snapshot(const char* data, std::size_t size);
+    /**
+     * Fetches the query snapshot most recently published by the specified
+     * node, using a direct RDMA read instead of an RPC round trip through the
+     * remote node's RPC thread. The fetched snapshot is always internally
+     * consistent: a read that races an update on the remote node is detected
+     * by its version words and retried.
+     * @param target_id The ID of the node whose snapshot should be read
+     * @param data_out A buffer to copy the snapshot into; must have room for
+     * DERECHO/query_snapshot_size bytes
+     * @param size_out Set to the size of the fetched snapshot on success
+     * @return True if a snapshot was fetched, false if the target node has
+     * never published one or the read timed out
+     */
+    bool one_sided_query(node_id_t target_id, char* data_out, std::size_t& size_out);
     /** Reports to the GMS that the given node has failed. */
     void report_failure(const node_id_t who);
     /** Waits until all members of the group have called this function. */
     void barrier_sync();
+    /** Returns the timing milestones of every view change this node has
+     * participated in; see ViewChangeTiming. Used by churn benchmarks to
+     * break view-change cost into its phases. */
+    std::vector<ViewChangeTiming> get_view_change_timings();
+    /**
+     * A fast barrier across all live members of the group, built on an SST
+     * counter column instead of message traffic: entering costs one RDMA
+     * push, and waiting is a min-scan of the column, so a barrier whose
+     * participants have all arrived completes in microseconds. Returns once
+     * every live member has called barrier(); members that fail while the
+     * barrier is in progress are excluded. Useful for separating application
+     * phases (e.g. bulk load, then index build, then serve) without
+     * ordered_send round trips.
+     */
+    void barrier();
+    /**
+     * The same barrier restricted to the members of this node's shard of the
+     * specified subgroup (identified by type and index, like get_subgroup).
+     * Returns once every live member of that shard has entered the barrier.
+     * Since all participants share one barrier counter, a node must not run
+     * shard-scoped and group-wide barriers concurrently from different
+     * threads.
+     * @throws derecho_exception if this node is not a member of any shard of
+     * the specified subgroup
+     */
+    template <typename SubgroupType>
+    void barrier(uint32_t subgroup_index = 0);
     void debug_print_status() const;
 };
 
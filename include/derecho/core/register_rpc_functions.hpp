@@ -2,6 +2,8 @@
 #include "detail/rpc_utils.hpp"
 #include <mutils/macro_utils.hpp>
 #include <tuple>
+#include <utility>
+#include <vector>
 
 /**
  * This is an automatically-generated file that makes it easier for user-created
@@ -177,8 +179,101 @@
                                derecho::rpc::tag<CT_STRING(o)::hash()>(&classname::o));  \
     }
 
+#define ORDER_INSENSITIVE_TAGS1(a)                                          \
+    static std::vector<derecho::rpc::FunctionTag> order_insensitive_tags() { \
+        return {CT_STRING(a)::hash()};                                       \
+    }
+#define ORDER_INSENSITIVE_TAGS2(a, b)                                       \
+    static std::vector<derecho::rpc::FunctionTag> order_insensitive_tags() { \
+        return {CT_STRING(a)::hash(), CT_STRING(b)::hash()};                 \
+    }
+#define ORDER_INSENSITIVE_TAGS3(a, b, c)                                                 \
+    static std::vector<derecho::rpc::FunctionTag> order_insensitive_tags() {             \
+        return {CT_STRING(a)::hash(), CT_STRING(b)::hash(), CT_STRING(c)::hash()};       \
+    }
+#define ORDER_INSENSITIVE_TAGS4(a, b, c, d)                                              \
+    static std::vector<derecho::rpc::FunctionTag> order_insensitive_tags() {             \
+        return {CT_STRING(a)::hash(), CT_STRING(b)::hash(), CT_STRING(c)::hash(),        \
+                CT_STRING(d)::hash()};                                                   \
+    }
+#define ORDER_INSENSITIVE_TAGS5(a, b, c, d, e)                                           \
+    static std::vector<derecho::rpc::FunctionTag> order_insensitive_tags() {             \
+        return {CT_STRING(a)::hash(), CT_STRING(b)::hash(), CT_STRING(c)::hash(),        \
+                CT_STRING(d)::hash(), CT_STRING(e)::hash()};                             \
+    }
+#define ORDER_INSENSITIVE_TAGS6(a, b, c, d, e, f)                                        \
+    static std::vector<derecho::rpc::FunctionTag> order_insensitive_tags() {             \
+        return {CT_STRING(a)::hash(), CT_STRING(b)::hash(), CT_STRING(c)::hash(),        \
+                CT_STRING(d)::hash(), CT_STRING(e)::hash(), CT_STRING(f)::hash()};       \
+    }
+#define ORDER_INSENSITIVE_TAGS7(a, b, c, d, e, f, g)                                     \
+    static std::vector<derecho::rpc::FunctionTag> order_insensitive_tags() {             \
+        return {CT_STRING(a)::hash(), CT_STRING(b)::hash(), CT_STRING(c)::hash(),        \
+                CT_STRING(d)::hash(), CT_STRING(e)::hash(), CT_STRING(f)::hash(),        \
+                CT_STRING(g)::hash()};                                                   \
+    }
+#define ORDER_INSENSITIVE_TAGS8(a, b, c, d, e, f, g, h)                                  \
+    static std::vector<derecho::rpc::FunctionTag> order_insensitive_tags() {             \
+        return {CT_STRING(a)::hash(), CT_STRING(b)::hash(), CT_STRING(c)::hash(),        \
+                CT_STRING(d)::hash(), CT_STRING(e)::hash(), CT_STRING(f)::hash(),        \
+                CT_STRING(g)::hash(), CT_STRING(h)::hash()};                             \
+    }
+#define ORDER_INSENSITIVE_TAGS9(a, b, c, d, e, f, g, h, i)                               \
+    static std::vector<derecho::rpc::FunctionTag> order_insensitive_tags() {             \
+        return {CT_STRING(a)::hash(), CT_STRING(b)::hash(), CT_STRING(c)::hash(),        \
+                CT_STRING(d)::hash(), CT_STRING(e)::hash(), CT_STRING(f)::hash(),        \
+                CT_STRING(g)::hash(), CT_STRING(h)::hash(), CT_STRING(i)::hash()};       \
+    }
+#define ORDER_INSENSITIVE_TAGS10(a, b, c, d, e, f, g, h, i, j)                           \
+    static std::vector<derecho::rpc::FunctionTag> order_insensitive_tags() {             \
+        return {CT_STRING(a)::hash(), CT_STRING(b)::hash(), CT_STRING(c)::hash(),        \
+                CT_STRING(d)::hash(), CT_STRING(e)::hash(), CT_STRING(f)::hash(),        \
+                CT_STRING(g)::hash(), CT_STRING(h)::hash(), CT_STRING(i)::hash(),        \
+                CT_STRING(j)::hash()};                                                   \
+    }
+#define ORDER_INSENSITIVE_TAGS11(a, b, c, d, e, f, g, h, i, j, k)                        \
+    static std::vector<derecho::rpc::FunctionTag> order_insensitive_tags() {             \
+        return {CT_STRING(a)::hash(), CT_STRING(b)::hash(), CT_STRING(c)::hash(),        \
+                CT_STRING(d)::hash(), CT_STRING(e)::hash(), CT_STRING(f)::hash(),        \
+                CT_STRING(g)::hash(), CT_STRING(h)::hash(), CT_STRING(i)::hash(),        \
+                CT_STRING(j)::hash(), CT_STRING(k)::hash()};                             \
+    }
+#define ORDER_INSENSITIVE_TAGS12(a, b, c, d, e, f, g, h, i, j, k, l)                     \
+    static std::vector<derecho::rpc::FunctionTag> order_insensitive_tags() {             \
+        return {CT_STRING(a)::hash(), CT_STRING(b)::hash(), CT_STRING(c)::hash(),        \
+                CT_STRING(d)::hash(), CT_STRING(e)::hash(), CT_STRING(f)::hash(),        \
+                CT_STRING(g)::hash(), CT_STRING(h)::hash(), CT_STRING(i)::hash(),        \
+                CT_STRING(j)::hash(), CT_STRING(k)::hash(), CT_STRING(l)::hash()};       \
+    }
+#define ORDER_INSENSITIVE_TAGS13(a, b, c, d, e, f, g, h, i, j, k, l, m)                  \
+    static std::vector<derecho::rpc::FunctionTag> order_insensitive_tags() {             \
+        return {CT_STRING(a)::hash(), CT_STRING(b)::hash(), CT_STRING(c)::hash(),        \
+                CT_STRING(d)::hash(), CT_STRING(e)::hash(), CT_STRING(f)::hash(),        \
+                CT_STRING(g)::hash(), CT_STRING(h)::hash(), CT_STRING(i)::hash(),        \
+                CT_STRING(j)::hash(), CT_STRING(k)::hash(), CT_STRING(l)::hash(),        \
+                CT_STRING(m)::hash()};                                                   \
+    }
+#define ORDER_INSENSITIVE_TAGS14(a, b, c, d, e, f, g, h, i, j, k, l, m, n)               \
+    static std::vector<derecho::rpc::FunctionTag> order_insensitive_tags() {             \
+        return {CT_STRING(a)::hash(), CT_STRING(b)::hash(), CT_STRING(c)::hash(),        \
+                CT_STRING(d)::hash(), CT_STRING(e)::hash(), CT_STRING(f)::hash(),        \
+                CT_STRING(g)::hash(), CT_STRING(h)::hash(), CT_STRING(i)::hash(),        \
+                CT_STRING(j)::hash(), CT_STRING(k)::hash(), CT_STRING(l)::hash(),        \
+                CT_STRING(m)::hash(), CT_STRING(n)::hash()};                             \
+    }
+#define ORDER_INSENSITIVE_TAGS15(a, b, c, d, e, f, g, h, i, j, k, l, m, n, o)            \
+    static std::vector<derecho::rpc::FunctionTag> order_insensitive_tags() {             \
+        return {CT_STRING(a)::hash(), CT_STRING(b)::hash(), CT_STRING(c)::hash(),        \
+                CT_STRING(d)::hash(), CT_STRING(e)::hash(), CT_STRING(f)::hash(),        \
+                CT_STRING(g)::hash(), CT_STRING(h)::hash(), CT_STRING(i)::hash(),        \
+                CT_STRING(j)::hash(), CT_STRING(k)::hash(), CT_STRING(l)::hash(),        \
+                CT_STRING(m)::hash(), CT_STRING(n)::hash(), CT_STRING(o)::hash()};       \
+    }
+
 #define REGISTER_RPC_FUNCTIONS_IMPL2(count, ...) REGISTER_RPC_FUNCTIONS##count(__VA_ARGS__)
 #define REGISTER_RPC_FUNCTIONS_IMPL(count, ...) REGISTER_RPC_FUNCTIONS_IMPL2(count, __VA_ARGS__)
+#define ORDER_INSENSITIVE_TAGS_IMPL2(count, ...) ORDER_INSENSITIVE_TAGS##count(__VA_ARGS__)
+#define ORDER_INSENSITIVE_TAGS_IMPL(count, ...) ORDER_INSENSITIVE_TAGS_IMPL2(count, __VA_ARGS__)
 
 /**
  * This macro automatically generates a register_functions() method for a Derecho
@@ -191,6 +286,51 @@
  */
 #define REGISTER_RPC_FUNCTIONS(...) REGISTER_RPC_FUNCTIONS_IMPL(VA_NARGS(__VA_ARGS__), __VA_ARGS__)
 
+/**
+ * This macro marks some of a Replicated Object's RPC methods as
+ * order-insensitive, given the names of the methods (which must also appear in
+ * REGISTER_RPC_FUNCTIONS). An ordered_send that targets an order-insensitive
+ * method is executed as soon as the message arrives at each node, instead of
+ * waiting for the message to reach its place in the global round-robin order;
+ * version assignment, stability callbacks, and persistence still happen in the
+ * global order. This is safe only for methods whose effects commute (counter
+ * increments, CRDT-style merges): different nodes may execute concurrent calls
+ * in different orders, and a method may run for a message that a view change
+ * subsequently discards. For example, to mark Thing's method foo() but not
+ * bar():
+ *
+ * REGISTER_RPC_FUNCTIONS(Thing, foo, bar);
+ * ORDER_INSENSITIVE_TAGS(foo);
+ */
+#define ORDER_INSENSITIVE_TAGS(...) ORDER_INSENSITIVE_TAGS_IMPL(VA_NARGS(__VA_ARGS__), __VA_ARGS__)
+
+/**
+ * This macro marks some of a Replicated Object's RPC methods as having
+ * reducible replies. Instead of every shard member sending its reply directly
+ * to the caller of an ordered_send, replies are combined pairwise up a binary
+ * tree of shard members with the chosen operator, and the caller receives a
+ * single reduced value (under its own node ID in the QueryResults map). This
+ * cuts reply traffic and caller-side wakeups from one per shard member to one
+ * per tree child, which matters for large shards. Only methods with arithmetic
+ * return types can be reduced. Each argument names a method (which must also
+ * appear in REGISTER_RPC_FUNCTIONS) wrapped in one of the operator macros
+ * SUM_REDUCED, MIN_REDUCED, or MAX_REDUCED. For example:
+ *
+ * REGISTER_RPC_FUNCTIONS(Thing, local_count, bar);
+ * REDUCED_REPLY_TAGS(SUM_REDUCED(local_count));
+ */
+#define REDUCED_REPLY_TAGS(...)                                                                        \
+    static std::vector<std::pair<derecho::rpc::FunctionTag, derecho::rpc::ReplyReduction>>             \
+    reduced_reply_tags() {                                                                             \
+        return {__VA_ARGS__};                                                                          \
+    }
+#define SUM_REDUCED(fn) \
+    std::make_pair(derecho::rpc::FunctionTag(CT_STRING(fn)::hash()), derecho::rpc::ReplyReduction::SUM)
+#define MIN_REDUCED(fn) \
+    std::make_pair(derecho::rpc::FunctionTag(CT_STRING(fn)::hash()), derecho::rpc::ReplyReduction::MIN)
+#define MAX_REDUCED(fn) \
+    std::make_pair(derecho::rpc::FunctionTag(CT_STRING(fn)::hash()), derecho::rpc::ReplyReduction::MAX)
+
 /**
  * This macro generates the Derecho-registered name of an RPC function, for use
  * in the template parameter of ordered_send (and other RPC callers), given the
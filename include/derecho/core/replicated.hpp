@@ -6,10 +6,13 @@
 
 #pragma once
 
+#include <atomic>
+#include <chrono>
 #include <functional>
 #include <memory>
 #include <tuple>
 #include <type_traits>
+#include <vector>
 
 #include "derecho_exception.hpp"
 #include "detail/derecho_internal.hpp"
@@ -60,6 +63,64 @@ inline std::unique_ptr<RawObject> raw_object_factory(persistent::PersistentRegis
     return std::make_unique<RawObject>();
 }
 
+/**
+ * A single-entry cache of the last (view ID, node ID) pair for which a p2p
+ * membership check succeeded. Since p2p sends usually target the same node
+ * repeatedly within one view, this lets the steady-state send path skip the
+ * rank_of lookup entirely; the cache self-invalidates on a view change
+ * because the view ID is part of the key. The key is a single atomic so
+ * concurrent senders on the same handle stay safe without a lock.
+ */
+class CachedMembershipCheck {
+    std::atomic<uint64_t> key{0};
+
+public:
+    CachedMembershipCheck() = default;
+    //Moving a handle just resets its cache; std::atomic itself is not movable
+    CachedMembershipCheck(CachedMembershipCheck&&) : key(0) {}
+    /** Returns true if the last successful check was for this exact (view, node) pair. */
+    bool hit(int32_t vid, node_id_t who) const {
+        return key.load(std::memory_order_relaxed) == make_key(vid, who);
+    }
+    /** Records a successful membership check for this (view, node) pair. */
+    void record(int32_t vid, node_id_t who) {
+        key.store(make_key(vid, who), std::memory_order_relaxed);
+    }
+
+private:
+    static uint64_t make_key(int32_t vid, node_id_t who) {
+        //vid + 1 so that (view 0, node 0) does not collide with the empty cache
+        return (static_cast<uint64_t>(static_cast<uint32_t>(vid + 1)) << 32) | who;
+    }
+};
+
+/**
+ * Status outcome of a try_p2p_send, reporting expected send-time failures as
+ * a value instead of an exception.
+ */
+enum class SendStatus : uint8_t {
+    /** The message was posted; the results object is engaged. */
+    SUCCESS = 0,
+    /** The destination is not a member of the current view. */
+    INVALID_MEMBER,
+};
+
+/**
+ * Return type of try_p2p_send: a send status plus, on success, the
+ * QueryResults for the call. Contextually converts to bool as "was sent",
+ * so the hot-path caller can branch on a benign failure (e.g. a client that
+ * disconnected mid-query) without a throw/catch unwind.
+ * @tparam ResultsType The rpc::QueryResults<Ret> type the send produces
+ */
+template <typename ResultsType>
+struct TrySendResult {
+    SendStatus status;
+    std::optional<ResultsType> results;
+    explicit operator bool() const {
+        return status == SendStatus::SUCCESS;
+    }
+};
+
 template <typename T>
 class Replicated : public ReplicatedObject, public persistent::ITemporalQueryFrontierProvider {
 private:
@@ -93,6 +154,13 @@ private:
     rpc::RPCManager& group_rpc_manager;
     /** The actual implementation of Replicated<T>, hiding its ugly template parameters. */
     std::unique_ptr<rpc::RemoteInvocableOf<T>> wrapped_this;
+    /** Caches the destination of the last successful p2p membership check. */
+    mutable CachedMembershipCheck membership_check_cache;
+    /** The most recently published immutable snapshot of the user object, or
+     * null if publish_snapshot() has never been called. Accessed only through
+     * std::atomic_load/atomic_store, so readers see either the old snapshot
+     * or the new one, never a partially-copied object. */
+    std::shared_ptr<const T> object_snapshot;
     _Group* group;
     /** The version number being processed and corresponding timestamp */
     persistent::version_t next_version = persistent::INVALID_VERSION;
@@ -183,6 +251,52 @@ public:
     template <rpc::FunctionTag tag, typename... Args>
     auto p2p_send(node_id_t dest_node, Args&&... args);
 
+    /**
+     * Variant of p2p_send that reports expected failures as a status instead
+     * of throwing: if the destination is not (or is no longer) a member of
+     * the current view, returns TrySendResult{INVALID_MEMBER} rather than
+     * raising invalid_node_exception, so callers that race against client
+     * disconnections pay a branch per failure instead of an unwind.
+     * Programming errors (an empty Replicated<T>, arguments exceeding the
+     * maximum payload size) still throw.
+     * @param dest_node The ID of the node that the P2P message should be sent to
+     * @param args The arguments to the RPC function being invoked
+     * @return A TrySendResult holding the send status and, on success, the
+     * rpc::QueryResults<Ret> for the call
+     */
+    template <rpc::FunctionTag tag, typename... Args>
+    auto try_p2p_send(node_id_t dest_node, Args&&... args);
+
+    /**
+     * Variant of p2p_send with a deadline: if the destination has not replied
+     * when the timeout elapses, its future in the returned QueryResults is
+     * fulfilled with an rpc::rpc_timeout_exception, so get() never blocks
+     * past the deadline even if the destination dies mid-view-change. Expiry
+     * is handled by the RPCManager's shared timer wheel, not a per-call
+     * watchdog thread.
+     * @param dest_node The ID of the node that the P2P message should be sent to
+     * @param timeout How long to wait for the reply before expiring it
+     * @param args The arguments to the RPC function being invoked
+     * @return An instance of rpc::QueryResults<Ret>, where Ret is the return type
+     * of the RPC function being invoked
+     */
+    template <rpc::FunctionTag tag, typename... Args>
+    auto p2p_send_with_timeout(node_id_t dest_node, std::chrono::milliseconds timeout, Args&&... args);
+
+    /**
+     * Variant of p2p_send that picks its destination automatically: the
+     * message goes to the live member of the given shard with the lowest
+     * load metric published via Group::publish_load_metric (ties broken by
+     * rank). This spreads read traffic across the replicas of a shard
+     * instead of hot-spotting one of them.
+     * @param shard_num The shard of this Replicated<T>'s subgroup to target
+     * @param args The arguments to the RPC function being invoked
+     * @return An instance of rpc::QueryResults<Ret>, where Ret is the return type
+     * of the RPC function being invoked
+     */
+    template <rpc::FunctionTag tag, typename... Args>
+    auto p2p_send_to_least_loaded(uint32_t shard_num, Args&&... args);
+
     /**
      * Sends a multicast to the entire subgroup that replicates this Replicated<T>,
      * invoking the RPC function identified by the FunctionTag template parameter.
@@ -195,6 +309,50 @@ public:
     template <rpc::FunctionTag tag, typename... Args>
     auto ordered_send(Args&&... args);
 
+    /**
+     * Variant of ordered_send with a deadline: any shard member that has not
+     * replied when the timeout elapses has its future fulfilled with an
+     * rpc::rpc_timeout_exception, so a caller blocked in get() is released
+     * even if a callee dies and the view change that would mark it failed is
+     * slow. Expiry is handled by the RPCManager's shared timer wheel.
+     * @param timeout How long to wait for the replies before expiring them
+     * @param args The arguments to the RPC function
+     * @return An instance of rpc::QueryResults<Ret>, where Ret is the return type
+     * of the RPC function being invoked.
+     */
+    template <rpc::FunctionTag tag, typename... Args>
+    auto ordered_send_with_timeout(std::chrono::milliseconds timeout, Args&&... args);
+
+    /**
+     * Non-blocking variant of ordered_send: attempts the multicast once and
+     * returns an empty optional, without serializing the arguments, if the
+     * subgroup's send window is currently full. Combined with
+     * get_send_credits and set_send_credits_callback this lets applications
+     * throttle producers upstream instead of blocking threads inside Derecho.
+     * @param args The arguments to the RPC function
+     * @return An std::optional containing an rpc::QueryResults<Ret> if the
+     * send was admitted, or empty if it would have blocked
+     */
+    template <rpc::FunctionTag tag, typename... Args>
+    auto try_ordered_send(Args&&... args);
+
+    /**
+     * @return The number of multicasts this node can currently send to this
+     * subgroup before the send window fills and ordered_send would block.
+     * The value is advisory: deliveries add credits concurrently, but only
+     * this node's own sends consume them.
+     */
+    int32_t get_send_credits();
+
+    /**
+     * Registers a function to be called when delivery progress may have freed
+     * send-window credits for this subgroup. The callback runs on a Derecho
+     * internal thread and should do no more than signal the application's
+     * sender, though calling try_ordered_send from it is safe. Pass nullptr
+     * to deregister. The registration survives view changes.
+     */
+    void set_send_credits_callback(std::function<void()> callback);
+
     /**
      * Submits a call to send a "raw" (byte array) message in a multicast to
      * this object's subgroup; the message will be generated by invoking msg_generator
@@ -202,6 +360,50 @@ public:
      */
     void send(unsigned long long int payload_size, const std::function<void(char* buf)>& msg_generator);
 
+    /**
+     * Sends a "raw" multicast directly from a user-owned memory region that
+     * was pre-registered with the RDMA device (rdma::memory_region), skipping
+     * the copy into an internal send buffer: the send queue references the
+     * caller's bytes and RDMC transmits them in place. The message occupies
+     * the region starting at the given offset; its first sizeof(header)
+     * bytes are overwritten with the multicast header, and the payload must
+     * already sit immediately after them. The caller must leave the message
+     * bytes untouched until release_callback is invoked (from a Derecho
+     * internal thread) to return ownership of the buffer. Only available in
+     * UNORDERED (raw) subgroups; blocks until the send window admits the
+     * message.
+     */
+    void send_zero_copy(std::shared_ptr<rdma::memory_region> user_mr, size_t offset,
+                        unsigned long long int payload_size, std::function<void()> release_callback);
+
+    /**
+     * Publishes an immutable snapshot of the current user object: copies it
+     * and atomically swaps the copy into this Replicated<T>'s snapshot
+     * pointer, retiring the previous snapshot once its last reader drops it.
+     * Must be called from a context serialized with ordered mutations --
+     * typically at the end of a mutating RPC handler, or at a coarser cadence
+     * from a delivery or persistence callback -- so the copy observes a
+     * consistent state. The cost is one copy of T per publish; long-running
+     * read-only p2p handlers (e.g. analytics scans) can then execute against
+     * the snapshot via get_snapshot() instead of the live object, so ordered
+     * delivery proceeds concurrently with the scan. Requires T to be
+     * copy-constructible, which in practice means objects without Persistent
+     * fields (a version-indexed read against a Persistent log already avoids
+     * the live value).
+     */
+    void publish_snapshot();
+
+    /**
+     * Returns the most recently published snapshot of the user object, or an
+     * empty pointer if publish_snapshot() has never been called. The returned
+     * pointer keeps the snapshot alive for as long as the caller holds it,
+     * so a scan over it is safe against concurrent deliveries, which only
+     * swap the pointer to a newer copy. A user object that inherits
+     * GroupReference can reach this from inside one of its own read-only
+     * handlers via group->get_subgroup<T>(subgroup_index).
+     */
+    std::shared_ptr<const T> get_snapshot() const;
+
     /**
      * @return The serialized size of the object, of type T, that holds the
      * state of this Replicated<T>.
@@ -227,6 +429,16 @@ public:
      */
     void send_object_raw(tcp::socket& receiver_socket) const;
 
+    /**
+     * Serializes the state of the "wrapped" object (of type T) into the given
+     * buffer, which must be at least object_size() bytes long. Used instead of
+     * send_object when the serialized state needs to be split across several
+     * sockets (striped state transfer) rather than streamed to one.
+     * @param buffer A buffer in which to put the serialized T
+     * @return The number of bytes written to the buffer.
+     */
+    std::size_t serialize_object(char* buffer) const;
+
     /**
      * Updates the state of the "wrapped" object by replacing it with the object
      * serialized in a buffer. Returns the number of bytes read from the buffer,
@@ -252,6 +464,40 @@ public:
      */
     const persistent::version_t get_minimum_latest_persisted_version() noexcept(false);
 
+    /**
+     * Returns the maximum among the "earliest version still in the log"
+     * numbers of all Persistent fields of this object. A log tail serialized
+     * after a version at or beyond this value has no gap when merged into
+     * another replica's log that already contains that version.
+     * @return A version number
+     */
+    const persistent::version_t get_maximum_earliest_version() noexcept(false);
+
+    /**
+     * Returns the total serialized size of all Persistent fields' log tails
+     * after the given version, as sent by send_log_tail().
+     */
+    std::size_t get_log_tail_size(const persistent::version_t& earliest_version);
+
+    /**
+     * Serializes and sends the log tails of all Persistent fields of this
+     * object, starting after the given version, over the given socket. Used
+     * for log-suffix catch-up of a rejoining node whose logs are only
+     * slightly stale, instead of sending the whole object state.
+     * @param receiver_socket
+     * @param earliest_version The version the receiver already has
+     */
+    void send_log_tail(tcp::socket& receiver_socket, const persistent::version_t& earliest_version);
+
+    /**
+     * Merges serialized log tails (as produced by send_log_tail on another
+     * replica) into this object's Persistent fields' logs, and reloads their
+     * current values from the updated logs.
+     * @param buffer A buffer containing the serialized log tails
+     * @return The number of bytes read from the buffer.
+     */
+    std::size_t apply_log_tail(char* buffer);
+
     /**
      * make a version for all the persistent<T> members.
      * @param ver - the version number to be made
@@ -274,6 +520,19 @@ public:
         persistent_registry_ptr->trim(earliest_version);
     };
 
+    /**
+     * Compact the logs of all Persistent<T> members down to their latest
+     * safe replay point at or below the given version. Unlike trim(), this
+     * never removes an entry that reconstructing a newer version still
+     * depends on, so the background compaction thread can call it with the
+     * minimum latest persisted version.
+     * @param upper_bound - the version to compact towards
+     * @return the minimum earliest version retained across all members
+     */
+    virtual const persistent::version_t trim_to_safe_point(const persistent::version_t& upper_bound) noexcept(false) {
+        return persistent_registry_ptr->trimToSafePoint(upper_bound);
+    };
+
     /**
      * Truncate the logs of all Persistent<T> members back to the version
      * specified. This deletes recently-used data, so it should only be called
@@ -310,8 +569,14 @@ public:
                                             const persistent::PersistFunc& pf,
                                             const persistent::TrimFunc& tf,
                                             const persistent::LatestPersistedGetterFunc& gf,
-                                            persistent::TruncateFunc tcf) noexcept(false) {
-        this->persistent_registry_ptr->registerPersist(object_name, vf, pf, tf, gf, tcf);
+                                            persistent::TruncateFunc tcf,
+                                            const persistent::EarliestVersionGetterFunc& evgf,
+                                            const persistent::LogTailSizeFunc& ltsf,
+                                            const persistent::LogTailSerializeFunc& ltserf,
+                                            const persistent::LogTailApplyFunc& ltaf,
+                                            const persistent::SafeTrimFunc& stf) noexcept(false) {
+        this->persistent_registry_ptr->registerPersist(object_name, vf, pf, tf, gf, tcf,
+                                                       evgf, ltsf, ltserf, ltaf, stf);
     }
 };
 
@@ -326,6 +591,8 @@ private:
     rpc::RPCManager& group_rpc_manager;
     /** The actual implementation of ExternalCaller, which has lots of ugly template parameters */
     std::unique_ptr<rpc::RemoteInvokerFor<T>> wrapped_this;
+    /** Caches the destination of the last successful p2p membership check. */
+    mutable CachedMembershipCheck membership_check_cache;
 
 public:
     ExternalCaller(uint32_t type_id, node_id_t nid, subgroup_id_t subgroup_id, rpc::RPCManager& group_rpc_manager);
@@ -345,9 +612,111 @@ public:
     template <rpc::FunctionTag tag, typename... Args>
     auto p2p_send(node_id_t dest_node, Args&&... args);
 
+    /**
+     * Variant of p2p_send that reports a non-member destination as a
+     * TrySendResult status instead of throwing; see
+     * Replicated<T>::try_p2p_send.
+     */
+    template <rpc::FunctionTag tag, typename... Args>
+    auto try_p2p_send(node_id_t dest_node, Args&&... args);
+
+    /**
+     * Variant of p2p_send with a deadline; see
+     * Replicated<T>::p2p_send_with_timeout.
+     */
+    template <rpc::FunctionTag tag, typename... Args>
+    auto p2p_send_with_timeout(node_id_t dest_node, std::chrono::milliseconds timeout, Args&&... args);
+
+    /**
+     * Variant of p2p_send that picks its destination automatically: the
+     * message goes to the live member of the given shard with the lowest
+     * load metric published via Group::publish_load_metric; see
+     * Replicated<T>::p2p_send_to_least_loaded.
+     */
+    template <rpc::FunctionTag tag, typename... Args>
+    auto p2p_send_to_least_loaded(uint32_t shard_num, Args&&... args);
+
+    /**
+     * Fan-out version of p2p_send: sends the same RPC invocation to each node
+     * in dest_nodes, serializing the arguments only once and posting all the
+     * sends back-to-back before any replies are awaited.
+     * @param dest_nodes The IDs of the nodes the P2P messages should be sent to
+     * @param args The arguments to the RPC function being invoked
+     * @return A std::vector of rpc::QueryResults<Ret>, in the same order as
+     * dest_nodes
+     */
+    template <rpc::FunctionTag tag, typename... Args>
+    auto p2p_send_to_many(const std::vector<node_id_t>& dest_nodes, Args&&... args);
+
     bool is_valid() const { return true; }
 };
 
+/**
+ * Holds the per-shard QueryResults produced by a ShardIterator fan-out query,
+ * and provides combined completion events over them. Iterating over this
+ * object yields the per-shard QueryResults in shard order, so it can be used
+ * anywhere a std::vector of QueryResults could be.
+ * @tparam Ret The return type of the RPC function that was invoked
+ */
+template <typename Ret>
+class ShardQueryResults {
+private:
+    std::vector<rpc::QueryResults<Ret>> shard_results;
+
+public:
+    ShardQueryResults(std::vector<rpc::QueryResults<Ret>>&& shard_results)
+            : shard_results(std::move(shard_results)) {}
+    ShardQueryResults(ShardQueryResults&&) = default;
+    ShardQueryResults(const ShardQueryResults&) = delete;
+
+    std::size_t num_shards() const { return shard_results.size(); }
+    rpc::QueryResults<Ret>& operator[](std::size_t shard_index) { return shard_results[shard_index]; }
+    auto begin() { return shard_results.begin(); }
+    auto end() { return shard_results.end(); }
+
+    /**
+     * Attaches a continuation invoked once, as soon as quorum shards have
+     * completed (for non-void RPCs, a shard is complete when its contacted
+     * member has replied; for void RPCs, when the message has been delivered
+     * to it). Like QueryResults::on_all_replies, the continuation runs on the
+     * RPC receive thread, or immediately if the quorum has already been
+     * reached. Exceptions do not count towards the quorum and must still be
+     * observed through the per-shard futures.
+     */
+    void on_quorum_of_shards(std::size_t quorum, std::function<void()> callback) {
+        struct quorum_state {
+            std::atomic<std::size_t> shards_completed{0};
+            std::size_t quorum;
+            std::function<void()> callback;
+        };
+        auto state = std::make_shared<quorum_state>();
+        state->quorum = quorum;
+        state->callback = std::move(callback);
+        for(auto& one_shard_results : shard_results) {
+            auto count_completion = [state]() {
+                if(++state->shards_completed == state->quorum) {
+                    state->callback();
+                }
+            };
+            if constexpr(std::is_void_v<Ret>) {
+                one_shard_results.on_delivery(count_completion);
+            } else {
+                one_shard_results.on_all_replies(count_completion);
+            }
+        }
+    }
+
+    /** Attaches a continuation invoked once every shard has completed. */
+    void on_all_shards(std::function<void()> callback) {
+        on_quorum_of_shards(shard_results.size(), std::move(callback));
+    }
+
+    /** Attaches a continuation invoked as soon as any shard completes. */
+    void on_any_shard(std::function<void()> callback) {
+        on_quorum_of_shards(1, std::move(callback));
+    }
+};
+
 template <typename T>
 class ShardIterator {
 private:
@@ -358,6 +727,12 @@ public:
     ShardIterator(ExternalCaller<T>& EC, std::vector<node_id_t> shard_reps)
             : EC(EC),
               shard_reps(shard_reps) {}
+    /**
+     * Sends the same RPC invocation to one representative of every shard,
+     * serializing the arguments once and posting all the sends back-to-back.
+     * @return A ShardQueryResults holding one QueryResults per shard, with
+     * combined all/any/quorum completion events.
+     */
     template <rpc::FunctionTag tag, typename... Args>
     auto p2p_send(Args&&... args);
 };
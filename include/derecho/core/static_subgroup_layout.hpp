@@ -0,0 +1,159 @@
+/**
+ * @file static_subgroup_layout.hpp
+ *
+ * A compile-time subgroup layout facility for fixed deployments. When the
+ * types, subgroup counts, and shard sizes of a deployment are known at build
+ * time, the layout can be described as template parameters instead of runtime
+ * SubgroupAllocationPolicy structures: every placement quantity becomes a
+ * constant the compiler folds, and the membership function reduces to a
+ * deterministic scan with no policy maps to traverse.
+ */
+
+#pragma once
+
+#include <string>
+#include <typeindex>
+#include <vector>
+
+#include "derecho_modes.hpp"
+#include "subgroup_info.hpp"
+#include "view.hpp"
+
+namespace derecho {
+
+/**
+ * Describes the layout of one subgroup type entirely at compile time: the
+ * number of subgroups of the type, the number of shards per subgroup, and the
+ * number of node slots per shard. Placement is by node ID: the layout's slots
+ * are occupied by consecutive node IDs (starting from the base ID the
+ * allocator assigns to this type), so a node's subgroup and shard follow from
+ * its ID alone. All the lookup helpers are constexpr, letting application
+ * send-target resolution (which shard holds this key, which nodes serve that
+ * shard) compile down to constants instead of consulting the View's maps.
+ */
+template <typename SubgroupType, uint32_t NumSubgroups, uint32_t NumShards,
+          uint32_t NodesPerShard, Mode ShardsMode = Mode::ORDERED>
+struct StaticSubgroupLayout {
+    using subgroup_type = SubgroupType;
+    static constexpr uint32_t num_subgroups = NumSubgroups;
+    static constexpr uint32_t num_shards = NumShards;
+    static constexpr uint32_t nodes_per_shard = NodesPerShard;
+    static constexpr Mode shards_mode = ShardsMode;
+    /** The total number of node slots this type's layout occupies. */
+    static constexpr uint32_t num_slots = NumSubgroups * NumShards * NodesPerShard;
+
+    static_assert(NumSubgroups > 0 && NumShards > 0 && NodesPerShard > 0,
+                  "A static layout must have at least one subgroup, shard, and node slot");
+
+    /** The subgroup index that the given slot belongs to. */
+    static constexpr uint32_t subgroup_of_slot(uint32_t slot) {
+        return slot / (NumShards * NodesPerShard);
+    }
+    /** The shard number (within its subgroup) that the given slot belongs to. */
+    static constexpr uint32_t shard_of_slot(uint32_t slot) {
+        return (slot / NodesPerShard) % NumShards;
+    }
+    /** The first slot of the given shard; the shard's slots are the
+     * NodesPerShard consecutive slots starting here. */
+    static constexpr uint32_t first_slot_of_shard(uint32_t subgroup_index, uint32_t shard_num) {
+        return (subgroup_index * NumShards + shard_num) * NodesPerShard;
+    }
+    /** The shard that a key maps to under modular placement, the usual
+     * send-target computation for sharded key-value subgroups. */
+    static constexpr uint32_t shard_of_key(uint64_t key) {
+        return key % NumShards;
+    }
+};
+
+/**
+ * A shard-view generator for deployments whose topology is fixed at build
+ * time, described by a list of StaticSubgroupLayout template parameters in
+ * the same order as the Group's subgroup types. Node slots are assigned to
+ * consecutive node IDs starting at first_node_id, type by type, so every
+ * node's placement is a pure function of its ID: a view member whose ID maps
+ * to no slot stays unassigned, and a slot whose node is absent from the view
+ * is simply left empty. Shards therefore shrink in place when a node fails --
+ * surviving members keep their shards, and a restarted node rejoins exactly
+ * the slot its ID names -- rather than being reshuffled by a rank-based
+ * allocation pass. A shard with no live members at all makes the view
+ * inadequate, exactly as when a runtime allocator throws
+ * subgroup_provisioning_exception.
+ *
+ * Use it like any other membership function:
+ *   SubgroupInfo info(StaticSubgroupAllocator<
+ *           StaticSubgroupLayout<CacheStore, 1, 4, 3>,
+ *           StaticSubgroupLayout<LoadBalancer, 1, 1, 2>>{});
+ */
+template <typename... Layouts>
+class StaticSubgroupAllocator {
+    /** The node ID occupying the first slot of the first layout. */
+    const node_id_t first_node_id;
+    /** The configuration profile assigned to every shard. */
+    const std::string profile;
+
+public:
+    /** The total number of node slots across every layout; a fully-populated
+     * deployment has exactly this many members (plus any unassigned spares). */
+    static constexpr uint32_t total_slots = (Layouts::num_slots + ... + 0u);
+
+    StaticSubgroupAllocator(node_id_t first_node_id = 0, const std::string& profile = "default")
+            : first_node_id(first_node_id), profile(profile) {}
+
+    subgroup_allocation_map_t operator()(const std::vector<std::type_index>& subgroup_type_order,
+                                         const std::unique_ptr<View>& prev_view,
+                                         View& curr_view) const {
+        if(subgroup_type_order.size() != sizeof...(Layouts)) {
+            throw subgroup_provisioning_exception(
+                    "StaticSubgroupAllocator describes a different number of types than the Group");
+        }
+        subgroup_allocation_map_t subgroup_layouts;
+        node_id_t slot_base = first_node_id;
+        uint32_t type_position = 0;
+        (allocate_one_type<Layouts>(subgroup_type_order, curr_view, subgroup_layouts,
+                                    slot_base, type_position),
+         ...);
+        // Placement is by node ID, not by rank, so the rank-based assignment
+        // cursor is irrelevant; mark every member consumed as the
+        // entire-view allocators do
+        curr_view.next_unassigned_rank = curr_view.members.size();
+        return subgroup_layouts;
+    }
+
+private:
+    template <typename Layout>
+    void allocate_one_type(const std::vector<std::type_index>& subgroup_type_order,
+                           View& curr_view,
+                           subgroup_allocation_map_t& subgroup_layouts,
+                           node_id_t& slot_base, uint32_t& type_position) const {
+        if(subgroup_type_order[type_position]
+           != std::type_index(typeid(typename Layout::subgroup_type))) {
+            throw subgroup_provisioning_exception(
+                    "StaticSubgroupAllocator layout order does not match the Group's subgroup types");
+        }
+        subgroup_shard_layout_t shard_layout(Layout::num_subgroups);
+        for(uint32_t subgroup_index = 0; subgroup_index < Layout::num_subgroups; ++subgroup_index) {
+            for(uint32_t shard_num = 0; shard_num < Layout::num_shards; ++shard_num) {
+                std::vector<node_id_t> shard_members;
+                shard_members.reserve(Layout::nodes_per_shard);
+                const uint32_t first_slot = Layout::first_slot_of_shard(subgroup_index, shard_num);
+                for(uint32_t slot = first_slot; slot < first_slot + Layout::nodes_per_shard; ++slot) {
+                    const node_id_t slot_node = slot_base + slot;
+                    if(curr_view.rank_of(slot_node) != -1) {
+                        shard_members.push_back(slot_node);
+                    }
+                }
+                if(shard_members.empty()) {
+                    throw subgroup_provisioning_exception(
+                            "No live node for any slot of a statically-laid-out shard");
+                }
+                shard_layout[subgroup_index].push_back(
+                        curr_view.make_subview(shard_members, Layout::shards_mode, {}, profile));
+            }
+        }
+        subgroup_layouts.emplace(subgroup_type_order[type_position], std::move(shard_layout));
+        slot_base += Layout::num_slots;
+        ++type_position;
+    }
+};
+
+}  // namespace derecho
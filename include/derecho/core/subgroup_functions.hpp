@@ -93,6 +93,11 @@ struct ShardAllocationPolicy {
      * indicating which profile it should use. (Ignored if even_shards is
      * true). */
     std::vector<std::string> profiles_by_shard;
+    /** The number of hot-standby replicas each shard should have in addition
+     * to its voting members. Standbys are assigned best-effort from nodes left
+     * over after every shard's voting members are allocated, so a shard may
+     * get fewer than this many (including zero). */
+    int num_standby_replicas = 0;
 };
 
 /**
@@ -297,6 +302,10 @@ protected:
     /**
      * Creates and returns a new membership allocation for a single subgroup
      * type, based on its previous allocation and its newly-assigned sizes.
+     * If the membership change does not touch this type at all (no shard lost
+     * a member or changed size), the previous allocation is copied wholesale
+     * instead of being recomputed shard-by-shard, so unchanged types cost
+     * only the comparison.
      * @param subgroup_type The subgroup type to allocate members for
      * @param subgroup_type_id The numeric "type ID" for this subgroup type
      * (its position in the subgroup_type_order list)
@@ -327,6 +336,22 @@ protected:
                                       View& curr_view,
                                       subgroup_allocation_map_t& subgroup_layouts) const;
 
+    /**
+     * Helper function that assigns hot-standby replicas to the shards of the
+     * "standard" subgroups, for shard policies that request them. It must run
+     * after every standard type's voting members have been allocated, so that
+     * standbys only consume nodes no shard needs for its voting membership.
+     * Assignment is best-effort: if the View runs out of unassigned nodes,
+     * shards are simply left with fewer standbys than requested.
+     * @param subgroup_type_order The same subgroup type order passed in to the operator() function
+     * @param curr_view The current View, whose next_unassigned_rank will be updated
+     * @param subgroup_layouts The layout map already populated by the standard
+     * allocation functions; standby members are appended to its SubViews.
+     */
+    void assign_standby_replicas(const std::vector<std::type_index>& subgroup_type_order,
+                                 View& curr_view,
+                                 subgroup_allocation_map_t& subgroup_layouts) const;
+
     /**
      * Helper function that implements the subgroup allocation algorithm for all
      * cross-product subgroups. It must be run second so that it can refer to the allocations
@@ -8,6 +8,7 @@
 #include <cstdint>
 #include <iostream>
 #include <memory>
+#include <unordered_map>
 #include <vector>
 
 #include "detail/derecho_internal.hpp"
@@ -37,6 +38,12 @@ public:
     /** vector selecting the senders, 0 for non-sender, non-0 for sender*/
     /** integers instead of booleans due to the serialization issue :-/ */
     std::vector<int> is_sender;
+    /** vector marking hot-standby members, 0 for voting member, non-0 for
+     * standby. Standbys receive and deliver the shard's multicasts so their
+     * replicated state stays warm, but they do not count toward stability or
+     * persistence and never send RPC replies; integers for the same
+     * serialization reason as is_sender. */
+    std::vector<int> is_standby;
     /** IP addresses and ports of members in this subgroup/shard, with the same indices as members. */
     std::vector<std::tuple<ip_addr_t, uint16_t, uint16_t, uint16_t, uint16_t>> member_ips_and_ports;
     /** List of IDs of nodes that joined since the previous view, if any. */
@@ -49,6 +56,14 @@ public:
     int32_t my_rank;
     /** Settings for the subview */
     const std::string profile;
+    /** Reverse hash index of members[]; empty until build_rank_index() is
+     * called, since subgroup allocation functions may still be appending
+     * members (e.g. standby assignment). Built by ViewManager once the
+     * membership is final, and by View's deserialization constructor. */
+    std::unordered_map<node_id_t, uint32_t> node_id_to_rank;
+    /** (Re)builds node_id_to_rank from the current contents of members.
+     * Must be called again if members changes afterward. */
+    void build_rank_index();
     /** Looks up the sub-view rank of a node ID. Returns -1 if
      * that node ID is not a member of this subgroup/shard. */
     int rank_of(const node_id_t& who) const;
@@ -56,14 +71,17 @@ public:
     int sender_rank_of(uint32_t rank) const;
     /** returns the number of senders in the subview */
     uint32_t num_senders() const;
+    /** returns the number of voting (non-standby) members in the subview */
+    uint32_t num_voting_members() const;
     /** Creates an empty new SubView with num_members members.
      * The vectors will have room for num_members elements. */
     SubView(int32_t num_members);
 
-    DEFAULT_SERIALIZATION_SUPPORT(SubView, mode, members, is_sender,
+    DEFAULT_SERIALIZATION_SUPPORT(SubView, mode, members, is_sender, is_standby,
                                   member_ips_and_ports, joined, departed, profile);
     SubView(Mode mode, const std::vector<node_id_t>& members,
             std::vector<int> is_sender,
+            std::vector<int> is_standby,
             const std::vector<std::tuple<ip_addr_t, uint16_t, uint16_t, uint16_t, uint16_t>>& member_ips_and_ports,
             const std::vector<node_id_t>& joined,
             const std::vector<node_id_t>& departed,
@@ -71,6 +89,7 @@ public:
             : mode(mode),
               members(members),
               is_sender(is_sender),
+              is_standby(is_standby),
               member_ips_and_ports(member_ips_and_ports),
               joined(joined),
               departed(departed),
@@ -143,8 +162,10 @@ public:
     std::vector<std::vector<SubView>> subgroup_shard_views;
     /** Lists the (subgroup ID, shard num) pairs that this node is a member of */
     std::map<subgroup_id_t, uint32_t> my_subgroups;
-    /** Reverse index of members[]; maps node ID -> SST rank */
-    std::map<node_id_t, uint32_t> node_id_to_rank;
+    /** Reverse hash index of members[]; maps node ID -> SST rank, so the
+     * per-message rank_of lookups in the send and delivery paths cost one
+     * hashed probe instead of a member-list scan. */
+    std::unordered_map<node_id_t, uint32_t> node_id_to_rank;
 
     /**
      * Constructs a SubView containing the provided subset of this View's
@@ -155,7 +176,7 @@ public:
      * @throws subgroup_provisioning_exception if any of the requested members
      * are not actually in this View's members vector.
      */
-    SubView make_subview(const std::vector<node_id_t>& with_members, const Mode mode = Mode::ORDERED, const std::vector<int>& is_sender = {}, std::string profile = "default") const;
+    SubView make_subview(const std::vector<node_id_t>& with_members, const Mode mode = Mode::ORDERED, const std::vector<int>& is_sender = {}, std::string profile = "default", const std::vector<int>& is_standby = {}) const;
 
     /** Looks up the SST rank of an IP address. Returns -1 if that IP is not a member of this view. */
     int rank_of(const std::tuple<ip_addr_t, uint16_t, uint16_t, uint16_t, uint16_t>& who) const;
@@ -209,4 +230,65 @@ public:
          const std::vector<std::type_index>& subgroup_type_order);
 };
 
+/**
+ * A compact representation of a View change relative to the previous View,
+ * containing only the membership changes instead of the full member and
+ * subgroup lists. The leader sends this in place of a whole serialized View
+ * when delta_views is enabled, and the receiver reconstructs the next View
+ * from its copy of the current View plus this delta, re-running the subgroup
+ * membership functions locally. Only standing members can apply a delta;
+ * joining nodes always receive a complete View.
+ */
+class ViewDelta : public mutils::ByteRepresentable {
+public:
+    /** Sequential ID of the View that this delta produces */
+    const int32_t vid;
+    /** List of IDs of nodes that joined since the previous view, if any. */
+    std::vector<node_id_t> joined;
+    /** IP addresses and ports of the joining nodes, with the same indices as joined. */
+    std::vector<std::tuple<ip_addr_t, uint16_t, uint16_t, uint16_t, uint16_t>> joiner_ips_and_ports;
+    /** List of IDs of nodes that left since the previous view, if any. */
+    std::vector<node_id_t> departed;
+    /** The next view's failed statuses, indexed by its member ranks. */
+    std::vector<char> failed;
+    /** The next view's next_unassigned_rank. */
+    int32_t next_unassigned_rank;
+
+    /** Extracts a delta from a fully-constructed next View. */
+    ViewDelta(const View& next_view);
+
+    /**
+     * Reconstructs the next View from the previous View and this delta,
+     * placing surviving members before joiners in rank order exactly as
+     * ViewManager::make_next_view does. The result's subgroup membership
+     * fields are left uninitialized; the caller must run
+     * ViewManager::make_subgroup_maps on it, which reproduces the leader's
+     * subgroup layouts as long as the membership functions are deterministic.
+     * The result's my_rank is also uninitialized, since only the receiving
+     * node knows its own ID.
+     * @param old_view The View that this delta is relative to
+     * @param subgroup_type_order The subgroup type order known to the
+     * receiving ViewManager, which is not part of the delta
+     * @return The next View, without subgroup membership information
+     */
+    std::unique_ptr<View> make_next_view(const View& old_view,
+                                         const std::vector<std::type_index>& subgroup_type_order) const;
+
+    DEFAULT_SERIALIZATION_SUPPORT(ViewDelta, vid, joined, joiner_ips_and_ports,
+                                  departed, failed, next_unassigned_rank);
+
+    /** Constructor used by deserialization: constructs a ViewDelta given the values of its serialized fields. */
+    ViewDelta(const int32_t vid, const std::vector<node_id_t>& joined,
+              const std::vector<std::tuple<ip_addr_t, uint16_t, uint16_t, uint16_t, uint16_t>>& joiner_ips_and_ports,
+              const std::vector<node_id_t>& departed,
+              const std::vector<char>& failed,
+              const int32_t next_unassigned_rank)
+            : vid(vid),
+              joined(joined),
+              joiner_ips_and_ports(joiner_ips_and_ports),
+              departed(departed),
+              failed(failed),
+              next_unassigned_rank(next_unassigned_rank) {}
+};
+
 }  // namespace derecho
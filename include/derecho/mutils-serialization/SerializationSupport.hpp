@@ -2,10 +2,14 @@
 #include "SerializationMacros.hpp"
 #include "context_ptr.hpp"
 #include <cstring>
+#include <future>
+#include <mutex>
 #include <mutils/macro_utils.hpp>
 #include <mutils/mutils.hpp>
 #include <mutils/tuple_extras.hpp>
 #include <mutils/type_utils.hpp>
+#include <string_view>
+#include <thread>
 #include <tuple>
 #include <vector>
 
@@ -264,28 +268,47 @@ std::size_t bytes_size(const std::list<T>& list) {
 
 /**
  * All the elements of the set, plus one int for the number of elements.
+ * Trivially-copyable elements are encoded as one contiguous block, so the
+ * size is computable without traversing the set.
  */
 template <typename T>
 std::size_t bytes_size(const std::set<T>& s) {
-    int size = sizeof(int);
-    for(auto& a : s) {
-        size += bytes_size(a);
+    if constexpr(std::is_trivially_copyable<T>::value) {
+        return sizeof(int) + s.size() * sizeof(T);
+    } else {
+        int size = sizeof(int);
+        for(auto& a : s) {
+            size += bytes_size(a);
+        }
+        return size;
     }
-    return size;
 }
 
 /**
  * Sums the size of each key and value in the map, plus one int for the
- * number of entries
+ * number of entries. When the keys (and possibly the values) are
+ * trivially copyable they are encoded as contiguous column blocks rather
+ * than interleaved with the entries, which does not change the total size
+ * but lets this sum skip the corresponding per-element traversal.
  */
 template <typename K, typename V>
 std::size_t bytes_size(const std::map<K, V>& m) {
-    int size = sizeof(int);
-    for(const auto& p : m) {
-        size += bytes_size(p.first);
-        size += bytes_size(p.second);
+    if constexpr(std::is_trivially_copyable<K>::value && std::is_trivially_copyable<V>::value) {
+        return sizeof(int) + m.size() * (sizeof(K) + sizeof(V));
+    } else if constexpr(std::is_trivially_copyable<K>::value) {
+        std::size_t size = sizeof(int) + m.size() * sizeof(K);
+        for(const auto& p : m) {
+            size += bytes_size(p.second);
+        }
+        return size;
+    } else {
+        int size = sizeof(int);
+        for(const auto& p : m) {
+            size += bytes_size(p.first);
+            size += bytes_size(p.second);
+        }
+        return size;
     }
-    return size;
 }
 
 /**
@@ -537,8 +560,17 @@ void post_object(const std::function<void(char const* const, std::size_t)>& f,
                  const std::set<T>& s) {
     int size = s.size();
     f((char*)&size, sizeof(size));
-    for(const auto& a : s) {
-        post_object(f, a);
+    if constexpr(std::is_trivially_copyable<T>::value) {
+        // gather the (non-contiguous) tree nodes into one block so the sink
+        // sees a single large fragment instead of one tiny post per element
+        if(!s.empty()) {
+            std::vector<T> block(s.begin(), s.end());
+            f((char*)block.data(), block.size() * sizeof(T));
+        }
+    } else {
+        for(const auto& a : s) {
+            post_object(f, a);
+        }
     }
 }
 
@@ -547,14 +579,108 @@ void post_object(const std::function<void(char const* const, std::size_t)>& f,
                  const std::map<K, V>& map) {
     int size = map.size();
     f((char*)&size, sizeof(size));
-    for(const auto& pair : map) {
-        post_object(f, pair.first);
-        post_object(f, pair.second);
+    if constexpr(std::is_trivially_copyable<K>::value) {
+        // columnar encoding: all keys as one contiguous block, then the
+        // values (as a second block if they are trivially copyable too)
+        if(!map.empty()) {
+            std::vector<K> keys;
+            keys.reserve(map.size());
+            for(const auto& pair : map) {
+                keys.push_back(pair.first);
+            }
+            f((char*)keys.data(), keys.size() * sizeof(K));
+        }
+        if constexpr(std::is_trivially_copyable<V>::value) {
+            if(!map.empty()) {
+                std::vector<V> values;
+                values.reserve(map.size());
+                for(const auto& pair : map) {
+                    values.push_back(pair.second);
+                }
+                f((char*)values.data(), values.size() * sizeof(V));
+            }
+        } else {
+            for(const auto& pair : map) {
+                post_object(f, pair.second);
+            }
+        }
+    } else {
+        for(const auto& pair : map) {
+            post_object(f, pair.first);
+            post_object(f, pair.second);
+        }
     }
 }
 
 // end post_object section
 
+/**
+ * Serializes an object by appending its bytes to the end of a growing
+ * buffer, in a single pass: the size is discovered during the write (via
+ * post_object) rather than by a separate bytes_size() traversal, which
+ * halves the serialization cost for deeply nested structures. Returns the
+ * number of bytes appended, which is the same as bytes_size(t).
+ */
+template <typename T>
+std::size_t to_bytes_growing(const T& t, std::vector<char>& buffer) {
+    const std::size_t initial_size = buffer.size();
+    const std::function<void(char const* const, std::size_t)> append_bytes
+            = [&buffer](char const* const bytes, std::size_t size) {
+                  buffer.insert(buffer.end(), bytes, bytes + size);
+              };
+    post_object(append_bytes, t);
+    return buffer.size() - initial_size;
+}
+
+/**
+ * A serialization sink with bounded buffering: fragments posted to it are
+ * coalesced into a fixed-size chunk, and the downstream consumer is invoked
+ * once per full chunk instead of once per fragment. This lets post_object
+ * stream an arbitrarily large object through a socket writer while never
+ * holding more than chunk_size serialized bytes in memory (and without one
+ * write syscall per tiny fragment), as opposed to serializing the whole
+ * object into one buffer first. Fragments at least as large as the chunk
+ * size bypass the buffer and are forwarded directly. flush() delivers the
+ * final partial chunk; the destructor calls it as a backstop.
+ */
+class chunked_post_sink {
+    const std::function<void(char const* const, std::size_t)> consumer;
+    std::vector<char> chunk;
+    std::size_t chunk_used;
+
+public:
+    chunked_post_sink(const std::function<void(char const* const, std::size_t)>& consumer,
+                      std::size_t chunk_size = 1 << 20)
+            : consumer(consumer), chunk(chunk_size), chunk_used(0) {}
+    chunked_post_sink(const chunked_post_sink&) = delete;
+    chunked_post_sink& operator=(const chunked_post_sink&) = delete;
+
+    void operator()(char const* const bytes, std::size_t size) {
+        if(size >= chunk.size()) {
+            flush();
+            consumer(bytes, size);
+            return;
+        }
+        if(chunk_used + size > chunk.size()) {
+            flush();
+        }
+        std::memcpy(chunk.data() + chunk_used, bytes, size);
+        chunk_used += size;
+    }
+
+    /** Delivers any buffered bytes to the consumer. */
+    void flush() {
+        if(chunk_used > 0) {
+            consumer(chunk.data(), chunk_used);
+            chunk_used = 0;
+        }
+    }
+
+    ~chunked_post_sink() {
+        flush();
+    }
+};
+
 // to_bytes definitions -- these must come after bytes_size and post_object
 // definitions To reduce code duplication, these are all implemented in terms of
 // post_object
@@ -678,6 +804,148 @@ from_string(DeserializationManager*, char const* v, std::size_t length) {
     return std::make_unique<T>(std::string{v, length});
 }
 
+// buffer_view and string_view definitions -- zero-copy deserialization for
+// contiguous containers of trivially-copyable elements
+
+/**
+ * A non-owning view of a serialized array of trivially-copyable elements.
+ * Wire-compatible with std::vector<T>: an RPC method can declare a
+ * buffer_view<T> parameter where callers send a std::vector<T> (or another
+ * buffer_view), and deserializing it yields a view directly into the receive
+ * buffer instead of allocating a vector and copying the elements into it.
+ * The view is only valid while the receive buffer is: for ordered sends,
+ * until the RPC handler or delivery callback returns (the multicast slot is
+ * then recycled), and for P2P sends, until the handler returns (the P2P
+ * window slot is then recycled). Handlers that need the data for longer must
+ * copy it out, e.g. with to_vector(). Note that the view aliases the
+ * serialized bytes in place, so element types whose alignment requirement
+ * exceeds sizeof(int) may be misaligned; it is primarily intended for byte
+ * blobs (buffer_view<uint8_t> and the like).
+ */
+template <typename T>
+struct buffer_view {
+    static_assert(std::is_trivially_copyable<T>::value,
+                  "buffer_view only supports trivially-copyable element types");
+    using value_type = T;
+
+    buffer_view() : view_data(nullptr), view_size(0) {}
+    buffer_view(const T* data, std::size_t size) : view_data(data), view_size(size) {}
+
+    const T* data() const { return view_data; }
+    std::size_t size() const { return view_size; }
+    bool empty() const { return view_size == 0; }
+    const T* begin() const { return view_data; }
+    const T* end() const { return view_data + view_size; }
+    const T& operator[](std::size_t index) const { return view_data[index]; }
+
+    /** Copies the viewed elements out into an owning vector. */
+    std::vector<T> to_vector() const {
+        return std::vector<T>(view_data, view_data + view_size);
+    }
+
+private:
+    const T* view_data;
+    std::size_t view_size;
+};
+
+template <typename>
+struct is_buffer_view : std::false_type {};
+
+template <typename T>
+struct is_buffer_view<buffer_view<T>> : std::true_type {};
+
+template <typename T>
+struct is_buffer_view<const buffer_view<T>> : std::true_type {};
+
+/** Same size as the std::vector<T> wire format: an int count plus the elements. */
+template <typename T>
+std::size_t bytes_size(const buffer_view<T>& view) {
+    return sizeof(int) + view.size() * sizeof(T);
+}
+
+template <typename T>
+void post_object(const std::function<void(char const* const, std::size_t)>& f,
+                 const buffer_view<T>& view) {
+    int size = view.size();
+    f((char*)&size, sizeof(size));
+    f((const char*)view.data(), view.size() * sizeof(T));
+}
+
+template <typename T>
+std::size_t to_bytes(const buffer_view<T>& view, char* v) {
+    std::size_t index = 0;
+    post_object(post_to_buffer(index, v), view);
+    return bytes_size(view);
+}
+
+/**
+ * Deserializing a buffer_view does not copy: the returned view aliases the
+ * serialized elements inside the buffer, so it has the lifetime documented
+ * on buffer_view rather than that of the returned unique_ptr.
+ */
+template <typename T>
+std::unique_ptr<type_check<is_buffer_view, T>>
+from_bytes(DeserializationManager*, char const* v) {
+    assert(v);
+    const int size = ((int*)v)[0];
+    return std::make_unique<T>((const typename T::value_type*)(v + sizeof(int)), size);
+}
+
+template <typename T>
+context_ptr<type_check<is_buffer_view, T>>
+from_bytes_noalloc(DeserializationManager* ctx, char const* v,
+                   context_ptr<T> = context_ptr<T>{}) {
+    return context_ptr<T>{from_bytes<T>(ctx, v).release()};
+}
+
+template <typename>
+struct is_string_view : std::false_type {};
+
+template <>
+struct is_string_view<std::string_view> : std::true_type {};
+
+template <>
+struct is_string_view<const std::string_view> : std::true_type {};
+
+/**
+ * std::string_view is wire-compatible with std::string, and deserializes
+ * to a view of the string inside the receive buffer (with the same lifetime
+ * caveats as buffer_view) instead of a heap-allocated copy.
+ */
+inline std::size_t bytes_size(const std::string_view& view) {
+    return view.size() + 1;
+}
+
+inline void post_object(const std::function<void(char const* const, std::size_t)>& f,
+                        const std::string_view& view) {
+    f(view.data(), view.size());
+    static const char null_terminator = '\0';
+    f(&null_terminator, 1);
+}
+
+inline std::size_t to_bytes(const std::string_view& view, char* v) {
+    std::memcpy(v, view.data(), view.size());
+    v[view.size()] = '\0';
+    return view.size() + 1;
+}
+
+template <typename T>
+std::unique_ptr<type_check<is_string_view, T>>
+from_bytes(DeserializationManager*, char const* v) {
+    assert(v);
+    return std::make_unique<T>(v);
+}
+
+template <typename T>
+context_ptr<type_check<is_string_view, T>>
+from_bytes_noalloc(DeserializationManager*, char const* v,
+                   context_ptr<T> = context_ptr<T>{}) {
+    assert(v);
+    return context_ptr<T>{new std::string_view{v}};
+}
+
+// end buffer_view and string_view section
+
 // from_bytes definitions
 template <typename T>
 std::enable_if_t<std::is_pod<T>::value, std::unique_ptr<std::decay_t<T>>>
@@ -753,15 +1021,25 @@ from_bytes_noalloc(DeserializationManager*, char const* v,
 template <typename T>
 std::unique_ptr<type_check<is_set, T>> from_bytes(DeserializationManager* ctx,
                                                   const char* _v) {
+    using key_t = typename T::key_type;
     int size = ((int*)_v)[0];
     const char* v = _v + sizeof(int);
-    auto r = std::make_unique<std::set<typename T::key_type>>();
-    for(int i = 0; i < size; ++i) {
-        auto e = from_bytes<typename T::key_type>(ctx, v);
-        v += bytes_size(*e);
-        r->insert(*e);
+    if constexpr(std::is_trivially_copyable<key_t>::value) {
+        // the block was written in iteration (comparator) order, so this
+        // range constructor builds the tree in linear time
+        key_t const* const start = (key_t const*)v;
+        return std::make_unique<T>(start, start + size);
+    } else {
+        auto r = std::make_unique<std::set<key_t>>();
+        for(int i = 0; i < size; ++i) {
+            auto e = from_bytes<key_t>(ctx, v);
+            v += bytes_size(*e);
+            // elements arrive in comparator order: the end() hint keeps
+            // every insert O(1)
+            r->emplace_hint(r->end(), std::move(*e));
+        }
+        return std::move(r);
     }
-    return std::move(r);
 }
 
 template <typename T>
@@ -878,12 +1156,32 @@ from_bytes(DeserializationManager* ctx, char const* buffer) {
     const char* buf_ptr = buffer + sizeof(int);
 
     auto new_map = std::make_unique<T>();
-    for(int i = 0; i < size; ++i) {
-        auto key = from_bytes_noalloc<key_t>(ctx, buf_ptr, context_ptr<key_t>{});
-        buf_ptr += bytes_size(*key);
-        auto value = from_bytes_noalloc<value_t>(ctx, buf_ptr, context_ptr<value_t>{});
-        buf_ptr += bytes_size(*value);
-        new_map->emplace(*key, *value);
+    if constexpr(std::is_trivially_copyable<key_t>::value) {
+        // columnar encoding: the key block comes first, then the values.
+        // Keys arrive in comparator order, so the end() hint makes every
+        // insert O(1) and the whole rebuild linear in the entry count.
+        key_t const* const keys = (key_t const*)buf_ptr;
+        buf_ptr += size * sizeof(key_t);
+        if constexpr(std::is_trivially_copyable<value_t>::value) {
+            value_t const* const values = (value_t const*)buf_ptr;
+            for(int i = 0; i < size; ++i) {
+                new_map->emplace_hint(new_map->end(), keys[i], values[i]);
+            }
+        } else {
+            for(int i = 0; i < size; ++i) {
+                auto value = from_bytes_noalloc<value_t>(ctx, buf_ptr, context_ptr<value_t>{});
+                buf_ptr += bytes_size(*value);
+                new_map->emplace_hint(new_map->end(), keys[i], std::move(*value));
+            }
+        }
+    } else {
+        for(int i = 0; i < size; ++i) {
+            auto key = from_bytes_noalloc<key_t>(ctx, buf_ptr, context_ptr<key_t>{});
+            buf_ptr += bytes_size(*key);
+            auto value = from_bytes_noalloc<value_t>(ctx, buf_ptr, context_ptr<value_t>{});
+            buf_ptr += bytes_size(*value);
+            new_map->emplace_hint(new_map->end(), *key, *value);
+        }
     }
     return std::move(new_map);
 }
@@ -895,6 +1193,164 @@ from_bytes_noalloc(DeserializationManager* ctx, char const* v,
     return context_ptr<T>{from_bytes<T>(ctx, v).release()};
 }
 
+// Parallel chunked codec. This comes after both the post_object and the
+// from_bytes definitions because it builds on both sides of the machinery.
+
+/**
+ * Wire header preceding each chunk produced by parallel_post_vector. Chunks
+ * may arrive in any order (workers post them as they finish), so each one
+ * carries its index; elem_count and num_bytes let the receiver consume the
+ * chunk without deserializing it first.
+ */
+struct parallel_chunk_header {
+    int chunk_index;
+    int elem_count;
+    std::size_t num_bytes;
+};
+
+/**
+ * Serializes a large vector as a sequence of independently-encoded chunks,
+ * using one worker thread per chunk, and posts each chunk to the consumer as
+ * soon as it is ready. Element ranges are serialized concurrently but each
+ * frame (header + payload) is delivered to the consumer atomically, so the
+ * consumer may write straight to a socket. The encoding is NOT the standard
+ * vector encoding: it must be decoded with parallel_receive_vector. Intended
+ * for the state-transfer path, where a single-threaded to_bytes of a large
+ * replicated object otherwise bounds node-replacement time; a custom
+ * send_object_raw implementation can call this for its bulk container and
+ * use the ordinary post_object path for everything else.
+ *
+ * Vectors too small to split (fewer than 2 * min_chunk_elements elements)
+ * are serialized inline on the calling thread, still in the framed format.
+ * num_workers == 0 means one worker per hardware thread.
+ */
+template <typename T>
+void parallel_post_vector(const std::function<void(char const* const, std::size_t)>& consumer,
+                          const std::vector<T>& vec,
+                          std::size_t min_chunk_elements = 1 << 14,
+                          std::size_t num_workers = 0) {
+    if(num_workers == 0) {
+        num_workers = std::max(1u, std::thread::hardware_concurrency());
+    }
+    if(min_chunk_elements == 0) {
+        min_chunk_elements = 1;
+    }
+    const std::size_t num_elements = vec.size();
+    const int num_chunks = (int)std::min(num_workers,
+                                         std::max<std::size_t>(1, num_elements / min_chunk_elements));
+    consumer((char*)&num_elements, sizeof(num_elements));
+    consumer((char*)&num_chunks, sizeof(num_chunks));
+    const std::size_t elements_per_chunk = (num_elements + num_chunks - 1) / num_chunks;
+    const auto encode_chunk = [&vec](std::size_t begin, std::size_t end) {
+        std::vector<char> buffer;
+        if constexpr(std::is_pod<T>::value) {
+            buffer.resize((end - begin) * sizeof(T));
+            std::memcpy(buffer.data(), vec.data() + begin, buffer.size());
+        } else {
+            for(std::size_t i = begin; i < end; ++i) {
+                to_bytes_growing(vec[i], buffer);
+            }
+        }
+        return buffer;
+    };
+    if(num_chunks == 1) {
+        std::vector<char> buffer = encode_chunk(0, num_elements);
+        parallel_chunk_header header{0, (int)num_elements, buffer.size()};
+        consumer((char*)&header, sizeof(header));
+        if(!buffer.empty()) {
+            consumer(buffer.data(), buffer.size());
+        }
+        return;
+    }
+    std::mutex consumer_mutex;
+    std::vector<std::future<void>> workers;
+    for(int chunk_index = 0; chunk_index < num_chunks; ++chunk_index) {
+        workers.emplace_back(std::async(
+                std::launch::async,
+                [&consumer, &consumer_mutex, &encode_chunk, elements_per_chunk,
+                 num_elements, chunk_index]() {
+                    // with ceil division the later chunks can start past the
+                    // end (e.g. 5 elements over 4 workers with a small
+                    // min_chunk_elements); clamp so a trailing chunk becomes
+                    // a valid empty frame instead of underflowing end - begin
+                    const std::size_t begin = std::min(num_elements,
+                                                       chunk_index * elements_per_chunk);
+                    const std::size_t end = std::min(num_elements, begin + elements_per_chunk);
+                    std::vector<char> buffer = encode_chunk(begin, end);
+                    parallel_chunk_header header{chunk_index, (int)(end - begin), buffer.size()};
+                    std::lock_guard<std::mutex> lock(consumer_mutex);
+                    consumer((char*)&header, sizeof(header));
+                    if(!buffer.empty()) {
+                        consumer(buffer.data(), buffer.size());
+                    }
+                }));
+    }
+    for(auto& worker : workers) {
+        worker.get();
+    }
+}
+
+/**
+ * Decodes a vector encoded by parallel_post_vector. The source function must
+ * perform a blocking read of exactly the requested number of bytes (e.g. a
+ * wrapper around Socket::read). The calling thread only reads frames off the
+ * source; each chunk's payload is handed to a worker thread for element
+ * deserialization as soon as it arrives, so decode overlaps with the
+ * remaining network transfer. The DeserializationManager is shared by the
+ * workers, so any registered contexts must tolerate concurrent read-only use
+ * (the usual state-transfer contexts do).
+ */
+template <typename T>
+std::unique_ptr<std::vector<T>> parallel_receive_vector(
+        DeserializationManager* ctx,
+        const std::function<void(char*, std::size_t)>& source) {
+    std::size_t num_elements;
+    source((char*)&num_elements, sizeof(num_elements));
+    int num_chunks;
+    source((char*)&num_chunks, sizeof(num_chunks));
+    // Per-chunk buffers live here, not in the read loop, so they stay valid
+    // until the worker that decodes them has finished
+    std::vector<std::vector<char>> chunk_buffers(num_chunks);
+    std::vector<std::vector<T>> chunk_elements(num_chunks);
+    std::vector<std::future<void>> workers;
+    for(int frames_read = 0; frames_read < num_chunks; ++frames_read) {
+        parallel_chunk_header header;
+        source((char*)&header, sizeof(header));
+        assert(header.chunk_index >= 0 && header.chunk_index < num_chunks);
+        std::vector<char>& buffer = chunk_buffers[header.chunk_index];
+        buffer.resize(header.num_bytes);
+        source(buffer.data(), buffer.size());
+        workers.emplace_back(std::async(
+                std::launch::async,
+                [ctx, &buffer, header, &elements = chunk_elements[header.chunk_index]]() {
+                    if constexpr(std::is_pod<T>::value) {
+                        T const* const start = (T const*)buffer.data();
+                        elements.assign(start, start + header.elem_count);
+                    } else {
+                        elements.reserve(header.elem_count);
+                        std::size_t offset = 0;
+                        for(int i = 0; i < header.elem_count; ++i) {
+                            context_ptr<T> item = from_bytes_noalloc<T>(
+                                    ctx, buffer.data() + offset, context_ptr<T>{});
+                            offset += bytes_size(*item);
+                            elements.push_back(std::move(*item));
+                        }
+                    }
+                }));
+    }
+    for(auto& worker : workers) {
+        worker.get();
+    }
+    auto result = std::make_unique<std::vector<T>>();
+    result->reserve(num_elements);
+    for(auto& chunk : chunk_elements) {
+        for(auto& element : chunk) {
+            result->push_back(std::move(element));
+        }
+    }
+    return result;
+}
+
 /**
    For Serializing and Deserializing many objects at once.
    The deserialization expects unique_ptr references; this
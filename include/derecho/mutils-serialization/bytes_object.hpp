@@ -0,0 +1,136 @@
+#pragma once
+
+#include "SerializationSupport.hpp"
+
+#include <cstring>
+#include <memory>
+
+namespace derecho {
+
+/**
+ * A blob type for RPC arguments, replies, and replicated-object fields that
+ * avoids deep copies unless one is explicitly requested. A Bytes either
+ * borrows memory owned by someone else (a caller's buffer on the send path,
+ * or the receive buffer on the noalloc deserialization path) or owns a heap
+ * copy made by copy_of()/clone()/from_bytes. It is move-only: accidentally
+ * copying megabytes requires writing clone(), not just passing by value.
+ *
+ * Wire format (a size followed by the raw bytes) is identical to the
+ * bytes_object.hpp used by the benchmark applications, so the two are
+ * interchangeable on the wire.
+ */
+class Bytes : public mutils::ByteRepresentable {
+    const char* data_ptr;
+    std::size_t data_size;
+    bool is_owner;
+
+    Bytes(const char* data, std::size_t size, bool owned)
+            : data_ptr(data), data_size(size), is_owner(owned) {}
+
+public:
+    /** Constructs an empty Bytes that owns nothing. */
+    Bytes() : data_ptr(nullptr), data_size(0), is_owner(false) {}
+
+    //Bytes is move-only; a deep copy must be requested explicitly with clone()
+    Bytes(const Bytes&) = delete;
+    Bytes& operator=(const Bytes&) = delete;
+
+    Bytes(Bytes&& other)
+            : data_ptr(other.data_ptr), data_size(other.data_size), is_owner(other.is_owner) {
+        other.data_ptr = nullptr;
+        other.data_size = 0;
+        other.is_owner = false;
+    }
+
+    Bytes& operator=(Bytes&& other) {
+        std::swap(data_ptr, other.data_ptr);
+        std::swap(data_size, other.data_size);
+        std::swap(is_owner, other.is_owner);
+        return *this;
+    }
+
+    virtual ~Bytes() {
+        if(is_owner) {
+            delete[] data_ptr;
+        }
+    }
+
+    /**
+     * Wraps caller-owned memory without copying it. The caller must keep the
+     * memory alive and unchanged until the Bytes (and any send it was
+     * serialized into) is finished; serialization reads the bytes directly
+     * from the caller's buffer.
+     */
+    static Bytes borrow(const char* data, std::size_t size) {
+        return Bytes(data, size, false);
+    }
+
+    /** Makes an owning deep copy of the given memory. */
+    static Bytes copy_of(const char* data, std::size_t size) {
+        char* copy = nullptr;
+        if(size > 0) {
+            copy = new char[size];
+            memcpy(copy, data, size);
+        }
+        return Bytes(copy, size, true);
+    }
+
+    const char* data() const { return data_ptr; }
+    std::size_t size() const { return data_size; }
+    bool empty() const { return data_size == 0; }
+    /** True if this Bytes owns (and will free) the memory it points to. */
+    bool owns_data() const { return is_owner; }
+
+    /** Returns an owning deep copy of this Bytes. */
+    Bytes clone() const {
+        return copy_of(data_ptr, data_size);
+    }
+
+    std::size_t to_bytes(char* v) const {
+        ((std::size_t*)v)[0] = data_size;
+        if(data_size > 0) {
+            memcpy(v + sizeof(data_size), data_ptr, data_size);
+        }
+        return sizeof(data_size) + data_size;
+    }
+
+    std::size_t bytes_size() const {
+        return sizeof(data_size) + data_size;
+    }
+
+    void post_object(const std::function<void(char const* const, std::size_t)>& f) const {
+        f((char*)&data_size, sizeof(data_size));
+        f(data_ptr, data_size);
+    }
+
+    void ensure_registered(mutils::DeserializationManager&) {}
+
+    /**
+     * Owning deserialization: copies the bytes out of the buffer, for use
+     * when the result outlives the receive buffer (e.g. an RPC reply stored
+     * in a QueryResults future).
+     */
+    static std::unique_ptr<Bytes> from_bytes(mutils::DeserializationManager*, const char* const v) {
+        const std::size_t size = ((const std::size_t*)v)[0];
+        return std::unique_ptr<Bytes>(new Bytes(copy_of(v + sizeof(std::size_t), size)));
+    }
+
+    /**
+     * Borrowing deserialization: the returned Bytes views the serialized
+     * bytes in place, so an RPC handler taking a Bytes argument reads the
+     * receive buffer directly with no copy. The view is valid only until the
+     * handler or delivery callback returns, when the multicast slot or P2P
+     * window slot it points into is recycled; call clone() to keep the data.
+     */
+    static mutils::context_ptr<Bytes> from_bytes_noalloc(mutils::DeserializationManager*, const char* const v) {
+        return mutils::context_ptr<Bytes>{
+                new Bytes(v + sizeof(std::size_t), ((const std::size_t*)v)[0], false)};
+    }
+
+    static mutils::context_ptr<const Bytes> from_bytes_noalloc_const(mutils::DeserializationManager*, const char* const v) {
+        return mutils::context_ptr<const Bytes>{
+                new Bytes(v + sizeof(std::size_t), ((const std::size_t*)v)[0], false)};
+    }
+};
+
+}  // namespace derecho
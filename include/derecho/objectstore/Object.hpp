@@ -23,6 +23,12 @@ using namespace std::chrono_literals;
 
 namespace objectstore {
 
+// A blob's payload is parsed off the wire exactly once: the backing array is
+// refcounted, and copying a Blob (into the object table, out of a get, into
+// a serialized reply) shares it instead of duplicating it. This relies on
+// blobs being treated as immutable once constructed - a put replaces the
+// whole object - so do not write through 'bytes' on a Blob that has been
+// copied.
 class Blob : public mutils::ByteRepresentable {
 public:
     char* bytes;
@@ -31,7 +37,16 @@ public:
     // constructor - copy to own the data
     Blob(const char* const b, const decltype(size) s);
 
-    // copy constructor - copy to own the data
+    // constructor - adopt an existing buffer without copying; the blob takes
+    // ownership and frees it with its last reference
+    Blob(std::unique_ptr<char[]> b, const decltype(size) s);
+
+    // constructor - share caller-provided refcounted storage without copying.
+    // 'b' must point into the block 'st' manages; used by storage backends
+    // that keep object payloads in their own region (e.g. a mapped arena).
+    Blob(std::shared_ptr<char> st, char* b, const decltype(size) s);
+
+    // copy constructor - share the refcounted data
     Blob(const Blob& other);
 
     // move constructor - accept the memory from another object
@@ -63,8 +78,12 @@ public:
     // from_bytes_noalloc() implementation borrowed from mutils-serialization.
     mutils::context_ptr<Blob> from_bytes_noalloc(
         mutils::DeserializationManager* ctx,
-        const char* const v, 
+        const char* const v,
         mutils::context_ptr<Blob> = mutils::context_ptr<Blob>{});
+
+private:
+    // the refcounted backing array that 'bytes' points into
+    std::shared_ptr<char> storage;
 };
 
 using OID = uint64_t;
@@ -83,17 +102,24 @@ public:
     // constructor 0 : copy constructor
     Object(const OID& _oid, const Blob& _blob);
 
+    // constructor 0.1 : move the blob in instead of copying it
+    Object(const OID& _oid, Blob&& _blob);
+
     // constructor 0.5 : copy constructor
     Object(const std::tuple<persistent::version_t,uint64_t> _ver, const OID& _oid, const Blob& _blob);
 
+    // constructor 0.6 : move the blob in instead of copying it
+    Object(const std::tuple<persistent::version_t,uint64_t> _ver, const OID& _oid, Blob&& _blob);
+
     // constructor 1 : copy consotructor
     Object(const uint64_t _oid, const char* const _b, const std::size_t _s);
 
+    // constructor 1.1 : adopt the buffer without copying
+    Object(const uint64_t _oid, std::unique_ptr<char[]> _b, const std::size_t _s);
+
     // constructor 1.5 : copy constructor
     Object(const std::tuple<persistent::version_t,uint64_t> _ver, const uint64_t _oid, const char* const _b, const std::size_t _s);
 
-    // TODO: we need a move version for the deserializer.
-
     // constructor 2 : move constructor
     Object(Object&& other);
 
@@ -103,6 +129,12 @@ public:
     // constructor 4 : default invalid constructor
     Object();
 
+    // move evaluator:
+    Object& operator=(Object&& other);
+
+    // copy evaluator:
+    Object& operator=(const Object& other);
+
     DEFAULT_SERIALIZATION_SUPPORT(Object, ver, oid, blob);
 };
 
@@ -8,7 +8,15 @@
 namespace objectstore {
 // if object is valid, this is a PUT operation; otherwise, a REMOVE operation.
 using ObjectWatcher = std::function<void(const OID&, const Object&)>;
+// batch variant of ObjectWatcher: receives every change applied since the
+// previous notification, in delivery order (an invalid Object is a REMOVE).
+// When registered it takes the place of per-change callbacks, so a watcher
+// that can index in bulk pays its fixed cost once per delivery batch.
+using ObjectBatchWatcher = std::function<void(const std::vector<std::pair<OID, Object>>&)>;
 using version_t = persistent::version_t;
+// completion callback for windowed puts: receives the object id and the
+// version assigned to that put.
+using put_completion_t = std::function<void(const OID&, const std::tuple<version_t,uint64_t>&)>;
 // The core API. See `test.cpp` for how to use it.
 class IObjectStoreService : public derecho::IDeserializationContext {
 private:
@@ -16,6 +24,14 @@ private:
 
 public:
     virtual const bool isReplica() = 0;
+    // The object space is partitioned into shards ('shards' in the
+    // [OBJECTSTORE] section, default 1). Each shard is replicated by a
+    // disjoint subset of the replica nodes and runs its own ordered-send
+    // pipeline, so put/remove/get throughput scales with the shard count.
+    // Every operation is routed to the shard owning its key; the mapping is
+    // a fixed hash of the object id, identical on every node.
+    virtual uint32_t getNumShards() = 0;
+    virtual uint32_t shardOfKey(const OID& oid) = 0;
     // blocking operations: all operations are guaranteed to be finished before
     // return. Note: the internal implementation of objectstore has two
     // versions, the client version and replica version. Only the nodes in the
@@ -49,12 +65,79 @@ public:
     // @PARAM ver - the version of the object. default to INVALID_VERSION for the current version.
     // @PARAM force_client - see above
     // @RETURN the object of oid, invalid object if corresponding object does not exists.
+    // NOTE: when 'read_cache' is enabled in the [OBJECTSTORE] section,
+    // current-version gets that would go over p2p are served from a local
+    // cache after a version-only validation probe, trading ordered-read
+    // semantics for blob-free round trips on repeated keys.
     virtual Object bio_get(const OID& oid, const version_t& ver = INVALID_VERSION, const bool& force_client = false) = 0;
     // 3.1 - temporal get
     // @PARAM oid - const reference of the object id.
     // @PARAM ts_us - timestamp.
     // @RETURN the object of oid, invalid object if corresponding object does not exists.
     virtual Object bio_get(const OID& oid, const uint64_t& ts_us) = 0;
+    // 4 - blocking multi-put
+    // Writes a batch of objects, each routed to the shard owning its key.
+    // The underlying sends to different shards are posted before any reply
+    // is awaited, so the batch proceeds in parallel across shards.
+    // @PARAM objects - the objects to be inserted or replaced.
+    // @PARAM force_client - see above
+    // @RETURN the new versions, in the same order as 'objects'
+    virtual std::vector<std::tuple<version_t,uint64_t>> bio_multi_put(const std::vector<Object>& objects, const bool& force_client = false) = 0;
+    // 4.1 - blocking transactional multi-put
+    // Writes a batch of objects spanning multiple shards with all-or-nothing
+    // semantics: each involved shard first stages its portion of the batch
+    // with one ordered message, and only after every shard has acknowledged
+    // staging is the commit sent to each shard, so either every shard
+    // installs its updates or (if any shard cannot stage) none do.
+    // Coordination costs one prepare and one commit round per involved
+    // shard regardless of batch size. NOTE: commits are applied through
+    // each shard's own ordered-send pipeline, so a concurrent reader may
+    // observe one shard's updates before another's - the guarantee is
+    // all-or-nothing installation of the batch, not cross-shard isolation.
+    // @PARAM objects - the objects to be inserted or replaced.
+    // @PARAM force_client - see above
+    // @RETURN the new versions, in the same order as 'objects'; every entry
+    //         is INVALID_VERSION if the transaction aborted.
+    virtual std::vector<std::tuple<version_t,uint64_t>> bio_txn_put(const std::vector<Object>& objects, const bool& force_client = false) = 0;
+    // 5 - blocking multi-get
+    // Reads a batch of keys with one batched request per owning shard per
+    // reply-sized chunk (respecting max_p2p_reply_payload_size), instead of
+    // one round trip per key. NOTE: batch reads are served from the
+    // contacted replica's current state, not by an ordered read.
+    // @PARAM oids - the object ids to read.
+    // @PARAM force_client - see above
+    // @RETURN a map from object id to object; an invalid object means the
+    //         corresponding id does not exist.
+    virtual std::map<OID, Object> bio_multi_get(const std::vector<OID>& oids, const bool& force_client = false) = 0;
+    // 5.1 - blocking ordered range scan
+    // Reads every stored object with begin_oid <= oid <= end_oid, streaming
+    // each shard's matches back in reply-sized chunks in ascending id order.
+    // The same replica-local read semantics as bio_multi_get apply, and a
+    // scan chunk costs the contacted replica a sweep of its object table,
+    // so prefer bio_multi_get when the wanted ids are known.
+    // @PARAM begin_oid - the first object id of interest (inclusive)
+    // @PARAM end_oid - the last object id of interest (inclusive)
+    // @PARAM force_client - see above
+    // @RETURN a map from object id to object holding every object in the
+    //         range; ids in the range with no object are simply absent.
+    virtual std::map<OID, Object> bio_scan(const OID& begin_oid, const OID& end_oid, const bool& force_client = false) = 0;
+    // 6 - windowed put
+    // Queues a put into the put pipeline instead of awaiting it. Queued puts
+    // for the same shard are coalesced and shipped as one ordered send once
+    // 'put_batch_size' of them accumulate, and up to 'put_window_size'
+    // batches may be outstanding before the oldest is awaited, so a bulk
+    // load streams at multicast bandwidth instead of paying one round trip
+    // per object. wio_put only blocks when the window is full. Completion
+    // callbacks fire, in put order within each shard, from whichever
+    // wio_put/wio_flush call drains the batch.
+    // @PARAM object - the object to be inserted or replaced.
+    // @PARAM completion - invoked with the object id and its new version
+    //        once the put's ordered send completes. May be empty.
+    virtual void wio_put(const Object& object, const put_completion_t& completion = {}) = 0;
+    // 7 - put pipeline flush
+    // Dispatches any partially filled batches and blocks until every
+    // outstanding windowed put has completed (and its callback has fired).
+    virtual void wio_flush() = 0;
 
     // non blocking operations: the operations will return a future.
     // The arguments align to the blocking apis.
@@ -70,7 +153,12 @@ public:
     virtual const ObjectWatcher& getObjectWatcher() = 0;
 
     // get singleton
-    static IObjectStoreService& getObjectStoreService(int argc, char** argv, const ObjectWatcher& ow = {});
+    // @PARAM ow - per-change watcher, invoked on a dedicated dispatch thread
+    //        (not the delivery path) in delivery order.
+    // @PARAM bow - batch watcher; when set it is invoked instead of 'ow',
+    //        once per drained batch of changes.
+    static IObjectStoreService& getObjectStoreService(int argc, char** argv, const ObjectWatcher& ow = {},
+                                                      const ObjectBatchWatcher& bow = {});
 };
 
 }  // namespace objectstore
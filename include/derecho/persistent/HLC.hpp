@@ -9,8 +9,11 @@ private:
     pthread_spinlock_t m_oLck;  // spinlock
 
 public:
-    uint64_t m_rtc_us;  // real-time clock in microseconds
-    uint64_t m_logic;   // logic clock
+    // The (rtc, logic) pair is published as a single 16-byte word by the
+    // lock-free tick() fast path (cmpxchg16b), so it must stay adjacent and
+    // 16-byte aligned.
+    alignas(16) uint64_t m_rtc_us;  // real-time clock in microseconds
+    uint64_t m_logic;               // logic clock
 
     // constructors
     HLC()
@@ -3,12 +3,16 @@
 #define PERSISTENT_HPP
 
 #include "detail/FilePersistLog.hpp"
+#include "detail/IoUringPersistLog.hpp"
+#include "detail/PmemPersistLog.hpp"
 #include "HLC.hpp"
 #include "PersistException.hpp"
 #include "detail/PersistLog.hpp"
 #include "PersistNoLog.hpp"
 #include "PersistentTypenames.hpp"
 #include <derecho/mutils-serialization/SerializationSupport.hpp>
+#include <algorithm>
+#include <chrono>
 #include <functional>
 #include <inttypes.h>
 #include <iostream>
@@ -99,9 +103,34 @@ public:
     /** Trims the log of all versions earlier than the argument. */
     void trim(const int64_t& earliest_version) noexcept(false);
 
+    /**
+     * Trims each registered field's log down to its latest safe replay point
+     * at or below the given version: the latest full-state entry for
+     * non-delta fields, or the latest full snapshot entry for delta fields
+     * (a delta log without snapshot entries is left untouched, since replay
+     * needs it from the beginning). Unlike trim(), this never removes an
+     * entry that a later version still depends on, so it can be driven
+     * blindly from the background compaction thread.
+     * @param upper_bound The version to compact towards, usually the minimum
+     *        latest persisted version.
+     * @return The minimum, over all fields, of the earliest version retained;
+     *         INVALID_VERSION if some field could not be compacted at all.
+     */
+    const version_t trimToSafePoint(const version_t& upper_bound) noexcept(false);
+
     /** Returns the minimum of the latest persisted versions among all Persistent fields. */
     const int64_t getMinimumLatestPersistedVersion() noexcept(false);
 
+    /**
+     * The shared log group consolidating this registry's file-backed fields
+     * into one pair of sectioned files (enabled by PERS/shared_log), or
+     * nullptr when each field keeps private files. Persistent<T> joins it in
+     * initialize_log(); persist() ends each batch with the group's single
+     * sync, so the fsync count per version batch stays constant instead of
+     * growing with the field count.
+     */
+    std::shared_ptr<SharedLogGroup> getSharedLogGroup() noexcept(true);
+
     /**
      * Set the earliest version for serialization, exclusive. This version will
      * be stored in a thread-local variable. When to_bytes() is next called on
@@ -124,6 +153,34 @@ public:
      */
     void truncate(const int64_t& last_version);
 
+    /** Returns the total serialized size of every registered field's log tail
+     * after the given version, as produced by postLogTails(). */
+    std::size_t getLogTailSize(const version_t& earliest_version) noexcept(false);
+
+    /** Serializes every registered field's log tail after the given version,
+     * in registration order. Small header and entry bytes go through the
+     * post function 'f'; each entry's payload is handed to 'file_f' as a
+     * range of the field's on-disk data file, so a sendfile-backed consumer
+     * never copies the payload bytes through userspace. */
+    void postLogTails(const std::function<void(char const* const, std::size_t)>& f,
+                      const FileRangePostFunc& file_f,
+                      const version_t& earliest_version) noexcept(false);
+
+    /**
+     * Applies serialized log tails (as produced by postLogTails on another
+     * replica) to every registered field, in the same order, and reloads each
+     * field's current object from its updated log. Used for log-suffix
+     * catch-up of a node that rejoins with a slightly-stale log.
+     * @return The number of bytes consumed from the buffer.
+     */
+    std::size_t mergeLogTails(mutils::DeserializationManager* dsm, char const* buf);
+
+    /** Returns the maximum, over all registered fields, of the earliest
+     * version still in the log. A log tail serialized after a version at or
+     * beyond this value is guaranteed to have no gap when merged into a log
+     * that already contains that version. */
+    const version_t getMaximumEarliestVersion() noexcept(false);
+
     /**
      * set the latest version for serialization
      * register a Persistent<T> along with its lambda
@@ -133,7 +190,12 @@ public:
                          const PersistFunc& pf,
                          const TrimFunc& tf,
                          const LatestPersistedGetterFunc& lpgf,
-                         const TruncateFunc& tcf) noexcept(false);
+                         const TruncateFunc& tcf,
+                         const EarliestVersionGetterFunc& evgf,
+                         const LogTailSizeFunc& ltsf,
+                         const LogTailSerializeFunc& ltserf,
+                         const LogTailApplyFunc& ltaf,
+                         const SafeTrimFunc& stf) noexcept(false);
 
     /**
      * deregister
@@ -214,7 +276,16 @@ protected:
     /**
      * Callback registry.
      */
-    std::map<std::size_t, std::tuple<VersionFunc, PersistFunc, TrimFunc, LatestPersistedGetterFunc, TruncateFunc>> _registry;
+    std::map<std::size_t, std::tuple<VersionFunc, PersistFunc, TrimFunc, LatestPersistedGetterFunc, TruncateFunc,
+                                     EarliestVersionGetterFunc, LogTailSizeFunc, LogTailSerializeFunc, LogTailApplyFunc,
+                                     SafeTrimFunc>>
+            _registry;
+
+    /**
+     * The shared log group for this registry's file-backed fields, created
+     * in the constructor when PERS/shared_log is set; see getSharedLogGroup().
+     */
+    std::shared_ptr<SharedLogGroup> _shared_log_group;
 
     /**
      * Helper function I
@@ -244,7 +315,9 @@ protected:
 // of a byte array - the DELTA, as long as the update should be persisted. Each
 // time Persistent<T> trying to make a version, it collects the DELTA and write
 // it to the log. On reloading data from persistent storage, the DELTAs in the
-// log entries are applied in order. TODO: use checkpointing to accelerate it!
+// log entries are applied in order. Setting PERS/snapshot_interval makes
+// Persistent<T> write a full-state snapshot entry every N deltas, so replay
+// starts from the most recent snapshot instead of the beginning of the log.
 //
 // There are three method included in this interface:
 // - 'finalizeCurrentDelta'     This method is called when Persistent<T> trying to
@@ -462,6 +535,19 @@ public:
     template <typename TKey>
     void trim(const TKey& k) noexcept(false);
 
+    /**
+     * trim the log down to the latest safe replay point at or below
+     * 'upper_bound': the latest entry for a plain object (every entry is a
+     * full state), or the latest full snapshot entry for a delta-supported
+     * object. A delta log without snapshot entries (PERS/snapshot_interval
+     * unset when it was written) is left untouched because replay needs it
+     * from the beginning.
+     * @param upper_bound: compact towards this version.
+     * @return the earliest version retained in the log, or INVALID_VERSION
+     *         if the log could not be compacted.
+     */
+    const version_t trimToSafePoint(const version_t& upper_bound) noexcept(false);
+
     /** 
      * truncate the log
      * @param ver: all versions strictly newer than 'ver' will be truncated.
@@ -487,6 +573,105 @@ public:
             const HLC& hlc,
             mutils::DeserializationManager* dm = nullptr) noexcept(false);
 
+    /**
+     * Batched temporal query: stream every version recorded in the HLC range
+     * [hlc_begin, hlc_end] to the user lambda, in log order, as
+     * fun(version, const ObjectType&). The HLC index is descended once for
+     * the whole range, and for a delta-supported type the state is
+     * materialized once at the start of the range and rolled forward delta
+     * by delta, so reading many adjacent timestamps costs far less than a
+     * point-in-time get() per timestamp.
+     * zerocopy: the object fed to the lambda will not live once it returns.
+     * @param hlc_begin: the beginning of the timestamp range, inclusive.
+     * @param hlc_end: the end of the timestamp range, inclusive.
+     * @return the number of versions streamed to the lambda.
+     */
+    template <typename Func>
+    std::size_t get_range(
+            const HLC& hlc_begin,
+            const HLC& hlc_end,
+            const Func& fun,
+            mutils::DeserializationManager* dm = nullptr) noexcept(false);
+
+    /**
+     * Zero-copy access to the serialized bytes of the latest log entry with
+     * version at or below 'ver', straight from the memory-mapped log (no
+     * deserialization or allocation). For a delta-supported type the bytes
+     * are the delta recorded at that version (prefixed with a one-byte
+     * snapshot/delta tag when PERS/snapshot_interval is enabled); for a
+     * plain type they are a full serialized object. The span borrows from
+     * the log: after reading through it, call isSpanValid() and redo the
+     * read if that fails, since a concurrent trim may have reused the bytes.
+     * @param ver: the version to look up.
+     * @return a span over the entry bytes; empty if no entry qualifies.
+     */
+    EntrySpan getEntrySpan(const version_t& ver) noexcept(false);
+
+    /**
+     * Zero-copy access to the serialized bytes of the log entry at the given
+     * index (negative counts back from the tail). See getEntrySpan(ver) for
+     * the payload layout and validity rules.
+     */
+    EntrySpan getEntrySpanByIndex(const int64_t& idx) noexcept(false);
+
+    /**
+     * check that a span still views live log bytes, i.e. that no trim or
+     * truncate has run on this object's log since the span was taken.
+     */
+    bool isSpanValid(const EntrySpan& span) noexcept(true);
+
+    /**
+     * A streaming iterator over a closed version range, produced by
+     * open_version_range(). Entries are visited in log order. next_span()
+     * yields each entry's serialized bytes zero-copy from the mapped log
+     * (for a delta-supported type these are the recorded deltas, in the
+     * same layout getEntrySpan() documents); next_object() instead
+     * deserializes into a caller-provided scratch object, reusing its
+     * storage across entries, and for a delta-supported type materializes
+     * the state once at the start of the range and rolls it forward delta
+     * by delta. When the range is opened the log advises the OS that the
+     * covered pages will be scanned sequentially, so a long scan gets
+     * readahead instead of one demand fault per page.
+     *
+     * The iterator borrows from the log: if a concurrent trim or truncate
+     * invalidates the range mid-scan, next_object() throws
+     * PERSIST_EXP_INV_VERSION (next_span() consumers detect it through the
+     * usual isSpanValid() check).
+     */
+    class VersionRangeIterator {
+        Persistent<ObjectType, storageType>* m_pParent;
+        int64_t m_nCurrentIndex;
+        int64_t m_nLastIndex;
+        uint64_t m_nGeneration;
+        /** whether next_object() has materialized the delta-supported
+         * state at the start of the range yet. */
+        bool m_bStateMaterialized;
+        friend class Persistent<ObjectType, storageType>;
+        VersionRangeIterator(Persistent<ObjectType, storageType>* parent,
+                             const int64_t& first_idx, const int64_t& last_idx);
+
+    public:
+        /** true while entries remain in the range. */
+        bool has_next() const {
+            return m_nCurrentIndex <= m_nLastIndex;
+        }
+        /** the next entry's bytes, zero-copy; advances the iterator. */
+        EntrySpan next_span() noexcept(false);
+        /** deserializes the next entry into 'scratch' and advances the
+         * iterator; returns the entry's version. */
+        version_t next_object(ObjectType& scratch,
+                              mutils::DeserializationManager* dm = nullptr) noexcept(false);
+    };
+
+    /**
+     * Open a streaming scan over every version in [ver_begin, ver_end]
+     * still in the log. Far cheaper than a get()/getByIndex() per version
+     * for long ranges: the version index is searched once for the whole
+     * range and the log pages are advised for sequential readahead.
+     */
+    VersionRangeIterator open_version_range(const version_t& ver_begin,
+                                            const version_t& ver_end) noexcept(false);
+
     /**
      * syntax sugar: get a specified version of T without DSM
      */
@@ -561,6 +746,53 @@ protected:
     std::unique_ptr<PersistLog> m_pLog;
     // Persistence Registry
     PersistentRegistry* m_pRegistry;
+    // Entry-kind tags prepended to the log payloads of delta-supported
+    // objects when PERS/snapshot_interval is nonzero, so replay can tell a
+    // full snapshot from a delta.
+    static constexpr uint8_t DELTA_ENTRY_TAG = 0;
+    static constexpr uint8_t SNAPSHOT_ENTRY_TAG = 1;
+    // Number of delta entries between full snapshots of a delta-supported
+    // object (from PERS/snapshot_interval). Snapshots bound the number of
+    // deltas a getByIndex()/recovery has to replay. 0 disables snapshots and
+    // keeps the untagged legacy log format; the setting must not change over
+    // the lifetime of an existing log.
+    uint32_t m_nSnapshotInterval;
+    // Delta entries appended since the last full snapshot.
+    uint32_t m_nDeltasSinceSnapshot;
+    // A private copy of the deserialization contexts this Persistent<T> was
+    // constructed with, so the checkpoint path can deserialize object state
+    // outside the construction/restart call chain. The contexts themselves
+    // are owned elsewhere (typically by the Group) and outlive this object.
+    std::unique_ptr<mutils::DeserializationManager> m_pDSM;
+    // Rolling copy of the object state at version m_nCheckpointVersion, for
+    // delta-supported objects when PERS/checkpoint_interval_ms is nonzero.
+    // Built lazily and advanced by checkpoint_if_due() on the persistence
+    // thread, by folding in log entries up to the persisted frontier; its
+    // serialized form is what writeCheckpoint() puts on disk. Kept separate
+    // from m_pWrappedObject, which the delivery thread mutates concurrently.
+    std::unique_ptr<ObjectType> m_pCheckpointState;
+    // Version m_pCheckpointState corresponds to; INVALID_VERSION if the
+    // rolling state has not been built (or was invalidated by a truncate).
+    version_t m_nCheckpointVersion;
+    // Virtual log index of the last entry folded into m_pCheckpointState,
+    // so each roll-forward resumes where the previous one stopped.
+    int64_t m_nCheckpointIndex;
+    // Minimum milliseconds between checkpoint files (from
+    // PERS/checkpoint_interval_ms); 0 disables checkpointing.
+    uint32_t m_nCheckpointIntervalMs;
+    // When the last checkpoint file was written.
+    std::chrono::steady_clock::time_point m_tLastCheckpoint;
+    /**
+     * Write a periodic checkpoint of a delta-supported object if one is due:
+     * rate-limited by PERS/checkpoint_interval_ms, never ahead of the
+     * persisted log frontier. Called from persist() on the persistence
+     * thread, off the delivery critical path. Restart then rebuilds the
+     * object from the checkpoint plus the log suffix after it, instead of
+     * replaying the whole log. A no-op for non-delta objects, whose log
+     * entries already hold full states.
+     * @param last_persisted the version just made durable by the log
+     */
+    void checkpoint_if_due(const version_t& last_persisted) noexcept(false);
     // get the static name maker.
     static _NameMaker<ObjectType,storageType>& getNameMaker(const std::string& prefix = std::string(""));
 
@@ -588,6 +820,18 @@ public:
     // @v - bytes representation of the log tail)
     void applyLogTail(mutils::DeserializationManager* dsm, char const* v);
 
+    // get the serialized size of the log tail after version 'ver'
+    virtual std::size_t getLogTailSize(const version_t& ver) noexcept(false);
+    // serialize the log tail after version 'ver': header and entry bytes go
+    // through the post function 'f', payload bytes to 'file_f' as ranges of
+    // the backing data file
+    virtual void postLogTail(const std::function<void(char const* const, std::size_t)>& f,
+                             const FileRangePostFunc& file_f,
+                             const version_t& ver) noexcept(false);
+    // merge a serialized log tail into the existing log and reload the
+    // current object from it; returns the number of bytes consumed from 'v'
+    virtual std::size_t mergeLogTail(mutils::DeserializationManager* dsm, char const* v);
+
 #if defined(_PERFORMANCE_DEBUG)
     uint64_t ns_in_persist = 0ul;
     uint64_t ns_in_set = 0ul;
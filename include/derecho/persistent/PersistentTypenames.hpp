@@ -10,6 +10,10 @@
 #include <cstdint>
 #include <functional>
 
+namespace mutils {
+struct DeserializationManager;
+}
+
 namespace persistent {
 
 using version_t = int64_t;
@@ -21,6 +25,21 @@ using PersistFunc = std::function<const version_t(void)>;
 using TrimFunc = std::function<void(const version_t &)>;
 using LatestPersistedGetterFunc = std::function<const version_t(void)>;
 using TruncateFunc = std::function<void(const int64_t &)>;
+// function types to be registered for log-suffix catch-up: get the earliest
+// version still in the log, measure/serialize the log tail after a version,
+// and merge a serialized log tail into the log
+using EarliestVersionGetterFunc = std::function<const version_t(void)>;
+using LogTailSizeFunc = std::function<std::size_t(const version_t &)>;
+// sink for a contiguous byte range of an on-disk file, so log-tail
+// serialization can hand whole payload ranges to a kernel copy path
+// (sendfile) instead of pushing the bytes through userspace
+using FileRangePostFunc = std::function<void(int fd, uint64_t offset, std::size_t size)>;
+using LogTailSerializeFunc = std::function<void(const std::function<void(char const *const, std::size_t)> &, const FileRangePostFunc &, const version_t &)>;
+using LogTailApplyFunc = std::function<std::size_t(mutils::DeserializationManager *, char const *)>;
+// function type to be registered for log compaction: trim the log prefix that
+// is no longer needed to reconstruct any version at or below the given bound,
+// returning the earliest version retained
+using SafeTrimFunc = std::function<const version_t(const version_t &)>;
 // this function is obsolete, now we use a shared pointer to persistence registry
 // using PersistentCallbackRegisterFunc = std::function<void(const char*,VersionFunc,PersistFunc,TrimFunc)>;
 }
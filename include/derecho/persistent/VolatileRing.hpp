@@ -0,0 +1,375 @@
+#ifndef VOLATILE_RING_HPP
+#define VOLATILE_RING_HPP
+
+#include "HLC.hpp"
+#include "PersistException.hpp"
+#include "PersistentTypenames.hpp"
+#include "detail/PersistLog.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <memory>
+#include <type_traits>
+#include <vector>
+
+namespace persistent {
+
+/**
+ * VolatileRing<T> is a purpose-built in-memory versioned store for soft
+ * state, offered alongside Persistent<T, ST_MEM>. The ST_MEM backend still
+ * runs the full FilePersistLog machinery (serialization, the log's locking,
+ * and a ramdisk file) even though nothing needs to survive a crash; this
+ * class instead keeps the last K versions of the object in a fixed ring of
+ * slots, with no serialization at all and no locks on the fast path.
+ *
+ * Concurrency model: one writer (the thread that creates versions) and any
+ * number of readers. When T is trivially copyable each slot is guarded by a
+ * per-slot sequence counter, the same seqlock idiom the SST uses for its
+ * multi-word fields: the writer bumps the counter to odd, stores the value,
+ * and bumps it back to even; a reader copies the slot and retries if the
+ * counter changed or was odd. Reads are wait-free unless they race with the
+ * overwrite of the very slot they are copying. For other types the slot
+ * holds a shared_ptr to an immutable copy and a per-slot spinlock protects
+ * the pointer; reads copy the pointer (still no serialization), so the lock
+ * is held for a few instructions only.
+ *
+ * Lookup cost: the latest version and lookup by ring index are O(1).
+ * Lookup by exact version or by time is a binary search over the window
+ * (O(log K)), because Derecho versions carry the view number in their high
+ * bits and are therefore too sparse to index directly.
+ *
+ * Versions older than the newest K are overwritten in place; reading one
+ * throws PERSIST_EXP_INV_VERSION, the same error Persistent<T> raises for a
+ * trimmed version.
+ */
+template <typename ObjectType>
+class VolatileRing {
+    constexpr static bool trivially_copyable = std::is_trivially_copyable<ObjectType>::value;
+
+    struct Slot {
+        /** Seqlock counter: odd while the writer is filling the slot. */
+        std::atomic<uint64_t> seq{0};
+        /** Spinlock for the shared_ptr payload (non-trivially-copyable T). */
+        mutable std::atomic_flag lock = ATOMIC_FLAG_INIT;
+        /** The monotone position of this entry, used by readers to detect
+         * that the slot was recycled for a newer version mid-read. */
+        int64_t position = -1;
+        version_t ver = INVALID_VERSION;
+        /** The version's HLC timestamp, flattened to its two words because
+         * HLC itself is not trivially copyable. */
+        uint64_t hlc_rtc_us = 0;
+        uint64_t hlc_logic = 0;
+        /** The stored value: in place for trivially copyable types, an
+         * immutable heap copy otherwise. */
+        typename std::conditional<trivially_copyable,
+                                  ObjectType,
+                                  std::shared_ptr<const ObjectType>>::type object;
+    };
+
+    /** Ring capacity, rounded up to a power of two so slot selection is a
+     * mask instead of a division. */
+    std::size_t capacity_mask;
+    std::vector<Slot> slots;
+    /** Position of the newest entry; -1 while the ring is empty. */
+    std::atomic<int64_t> latest_position{-1};
+
+    Slot& slot_at(int64_t position) {
+        return slots[position & capacity_mask];
+    }
+    const Slot& slot_at(int64_t position) const {
+        return slots[position & capacity_mask];
+    }
+
+    /**
+     * Copies the entry at the given position into out-parameters. Returns
+     * false if the slot was recycled for a newer entry (the position fell
+     * out of the window mid-read); retries internally on seqlock collisions.
+     */
+    bool read_slot(int64_t position, version_t& ver, uint64_t& rtc_us,
+                   uint64_t& logic, ObjectType& value) const {
+        const Slot& slot = slot_at(position);
+        if constexpr(trivially_copyable) {
+            while(true) {
+                const uint64_t seq_before = slot.seq.load(std::memory_order_acquire);
+                if(seq_before & 1) {
+                    continue;  // writer is mid-store; spin
+                }
+                const int64_t slot_position = slot.position;
+                const version_t slot_ver = slot.ver;
+                const uint64_t slot_rtc = slot.hlc_rtc_us;
+                const uint64_t slot_logic = slot.hlc_logic;
+                ObjectType slot_object = slot.object;
+                std::atomic_thread_fence(std::memory_order_acquire);
+                if(slot.seq.load(std::memory_order_relaxed) != seq_before) {
+                    continue;  // overwritten mid-copy; retry
+                }
+                if(slot_position != position) {
+                    return false;  // slot recycled before we got here
+                }
+                ver = slot_ver;
+                rtc_us = slot_rtc;
+                logic = slot_logic;
+                value = slot_object;
+                return true;
+            }
+        } else {
+            while(slot.lock.test_and_set(std::memory_order_acquire))  // acquire lock
+                ;                                                     // spin
+            if(slot.position != position) {
+                slot.lock.clear(std::memory_order_release);  // release lock
+                return false;
+            }
+            ver = slot.ver;
+            rtc_us = slot.hlc_rtc_us;
+            logic = slot.hlc_logic;
+            std::shared_ptr<const ObjectType> object = slot.object;
+            slot.lock.clear(std::memory_order_release);  // release lock
+            value = *object;
+            return true;
+        }
+    }
+
+    /** Reads only the version of the entry at a position (for the binary
+     * searches); returns INVALID_VERSION if the slot was recycled. */
+    version_t version_at(int64_t position) const {
+        const Slot& slot = slot_at(position);
+        if constexpr(trivially_copyable) {
+            while(true) {
+                const uint64_t seq_before = slot.seq.load(std::memory_order_acquire);
+                if(seq_before & 1) {
+                    continue;
+                }
+                const int64_t slot_position = slot.position;
+                const version_t slot_ver = slot.ver;
+                std::atomic_thread_fence(std::memory_order_acquire);
+                if(slot.seq.load(std::memory_order_relaxed) != seq_before) {
+                    continue;
+                }
+                return (slot_position == position) ? slot_ver : INVALID_VERSION;
+            }
+        } else {
+            while(slot.lock.test_and_set(std::memory_order_acquire))
+                ;
+            const version_t result = (slot.position == position) ? slot.ver : INVALID_VERSION;
+            slot.lock.clear(std::memory_order_release);
+            return result;
+        }
+    }
+
+    /** Like version_at, but returns the HLC timestamp word. */
+    uint64_t rtc_at(int64_t position) const {
+        const Slot& slot = slot_at(position);
+        if constexpr(trivially_copyable) {
+            while(true) {
+                const uint64_t seq_before = slot.seq.load(std::memory_order_acquire);
+                if(seq_before & 1) {
+                    continue;
+                }
+                const int64_t slot_position = slot.position;
+                const uint64_t slot_rtc = slot.hlc_rtc_us;
+                std::atomic_thread_fence(std::memory_order_acquire);
+                if(slot.seq.load(std::memory_order_relaxed) != seq_before) {
+                    continue;
+                }
+                return (slot_position == position) ? slot_rtc : UINT64_MAX;
+            }
+        } else {
+            while(slot.lock.test_and_set(std::memory_order_acquire))
+                ;
+            const uint64_t result = (slot.position == position) ? slot.hlc_rtc_us : UINT64_MAX;
+            slot.lock.clear(std::memory_order_release);
+            return result;
+        }
+    }
+
+public:
+    /**
+     * @param window_size how many of the most recent versions to retain;
+     *        rounded up to the next power of two.
+     */
+    VolatileRing(std::size_t window_size = 1024) noexcept(false) {
+        std::size_t capacity = 1;
+        while(capacity < window_size) {
+            capacity <<= 1;
+        }
+        capacity_mask = capacity - 1;
+        slots = std::vector<Slot>(capacity);
+    }
+
+    /**
+     * Records a new version of the object. Must be called from a single
+     * writer thread, with strictly increasing versions (the same contract
+     * Persistent<T>::version has). Overwrites the entry K versions back.
+     */
+    void put(version_t ver, const HLC& hlc, const ObjectType& value) {
+        const int64_t position = latest_position.load(std::memory_order_relaxed) + 1;
+        Slot& slot = slot_at(position);
+        if constexpr(trivially_copyable) {
+            slot.seq.fetch_add(1, std::memory_order_acq_rel);  // odd: in progress
+            slot.position = position;
+            slot.ver = ver;
+            slot.hlc_rtc_us = hlc.m_rtc_us;
+            slot.hlc_logic = hlc.m_logic;
+            slot.object = value;
+            slot.seq.fetch_add(1, std::memory_order_release);  // even: stable
+        } else {
+            // build the copy outside the critical section
+            std::shared_ptr<const ObjectType> object = std::make_shared<const ObjectType>(value);
+            while(slot.lock.test_and_set(std::memory_order_acquire))
+                ;
+            slot.position = position;
+            slot.ver = ver;
+            slot.hlc_rtc_us = hlc.m_rtc_us;
+            slot.hlc_logic = hlc.m_logic;
+            slot.object = std::move(object);
+            slot.lock.clear(std::memory_order_release);
+        }
+        latest_position.store(position, std::memory_order_release);
+    }
+
+    /** The number of versions currently readable (at most K). */
+    int64_t getNumOfVersions() const {
+        const int64_t latest = latest_position.load(std::memory_order_acquire);
+        return std::min<int64_t>(latest + 1, capacity_mask + 1);
+    }
+
+    /** The newest recorded version, or INVALID_VERSION if empty. */
+    version_t getLatestVersion() const {
+        const int64_t latest = latest_position.load(std::memory_order_acquire);
+        return (latest < 0) ? INVALID_VERSION : version_at(latest);
+    }
+
+    /** The oldest version still inside the window, or INVALID_VERSION. */
+    version_t getEarliestVersion() const {
+        while(true) {
+            const int64_t latest = latest_position.load(std::memory_order_acquire);
+            if(latest < 0) {
+                return INVALID_VERSION;
+            }
+            // walk forward past any entries the writer recycles underneath us
+            for(int64_t position = std::max<int64_t>(0, latest - (int64_t)capacity_mask);
+                position <= latest; position++) {
+                const version_t ver = version_at(position);
+                if(ver != INVALID_VERSION) {
+                    return ver;
+                }
+            }
+        }
+    }
+
+    /** O(1) copy of the newest value. Throws PERSIST_EXP_INV_VERSION if the
+     * ring is empty. */
+    std::unique_ptr<ObjectType> getLatest() const {
+        version_t ver;
+        uint64_t rtc_us, logic;
+        auto result = std::make_unique<ObjectType>();
+        while(true) {
+            const int64_t latest = latest_position.load(std::memory_order_acquire);
+            if(latest < 0) {
+                throw PERSIST_EXP_INV_VERSION;
+            }
+            if(read_slot(latest, ver, rtc_us, logic, *result)) {
+                return result;
+            }
+        }
+    }
+
+    /**
+     * Copy of the value at an exact version (binary search over the window,
+     * then an O(1) slot copy). Throws PERSIST_EXP_INV_VERSION if the version
+     * was never recorded or has been overwritten.
+     */
+    std::unique_ptr<ObjectType> get(version_t ver) const {
+        while(true) {
+            const int64_t latest = latest_position.load(std::memory_order_acquire);
+            if(latest < 0) {
+                throw PERSIST_EXP_INV_VERSION;
+            }
+            int64_t low = std::max<int64_t>(0, latest - (int64_t)capacity_mask);
+            int64_t high = latest;
+            bool recycled = false;
+            // versions are recorded in increasing order, so positions whose
+            // entries are still intact are sorted by version
+            while(low < high) {
+                const int64_t mid = low + (high - low) / 2;
+                const version_t mid_ver = version_at(mid);
+                if(mid_ver == INVALID_VERSION) {
+                    // recycled mid-search: the window moved, start over
+                    recycled = true;
+                    break;
+                }
+                if(mid_ver < ver) {
+                    low = mid + 1;
+                } else {
+                    high = mid;
+                }
+            }
+            if(recycled) {
+                continue;
+            }
+            version_t found_ver;
+            uint64_t rtc_us, logic;
+            auto result = std::make_unique<ObjectType>();
+            if(!read_slot(low, found_ver, rtc_us, logic, *result)) {
+                continue;
+            }
+            if(found_ver != ver) {
+                throw PERSIST_EXP_INV_VERSION;
+            }
+            return result;
+        }
+    }
+
+    /**
+     * Copy of the newest value whose timestamp is not after the given HLC's
+     * real-time component (binary search, matching Persistent<T>'s get by
+     * HLC semantics for soft state). Throws PERSIST_EXP_INV_HLC if every
+     * retained version is newer than the requested time.
+     */
+    std::unique_ptr<ObjectType> get(const HLC& hlc) const {
+        const uint64_t rtc_us_wanted = hlc.m_rtc_us;
+        while(true) {
+            const int64_t latest = latest_position.load(std::memory_order_acquire);
+            if(latest < 0) {
+                throw PERSIST_EXP_INV_HLC;
+            }
+            const int64_t earliest = std::max<int64_t>(0, latest - (int64_t)capacity_mask);
+            int64_t low = earliest;
+            int64_t high = latest + 1;
+            bool recycled = false;
+            // find the first position with timestamp > wanted
+            while(low < high) {
+                const int64_t mid = low + (high - low) / 2;
+                const uint64_t mid_rtc = rtc_at(mid);
+                if(mid_rtc == UINT64_MAX) {
+                    recycled = true;
+                    break;
+                }
+                if(mid_rtc <= rtc_us_wanted) {
+                    low = mid + 1;
+                } else {
+                    high = mid;
+                }
+            }
+            if(recycled) {
+                continue;
+            }
+            if(low == earliest) {
+                // every retained version is newer than the requested time
+                throw PERSIST_EXP_INV_HLC;
+            }
+            version_t ver;
+            uint64_t rtc_us, logic;
+            auto result = std::make_unique<ObjectType>();
+            if(!read_slot(low - 1, ver, rtc_us, logic, *result)) {
+                continue;
+            }
+            return result;
+        }
+    }
+};
+
+}  // namespace persistent
+
+#endif  // VOLATILE_RING_HPP
@@ -0,0 +1,28 @@
+#ifndef CRC32C_HPP
+#define CRC32C_HPP
+
+#include <cstddef>
+#include <cstdint>
+
+namespace persistent {
+
+/**
+ * CRC32C (Castagnoli) over arbitrary byte ranges, used to checksum log
+ * entries. On x86 with SSE4.2 the SSE crc32 instruction is used, which makes
+ * the per-append cost negligible; elsewhere a slice-by-one table fallback is
+ * compiled in. The function is incremental: pass 0 for the first range and
+ * the previous return value to fold in further ranges.
+ */
+namespace checksum {
+
+/**
+ * Fold 'size' bytes at 'data' into a running CRC32C value.
+ * @PARAM crc the running value: 0 to start, or a previous return value.
+ * @RETURN the updated CRC32C value.
+ */
+uint32_t crc32c(const uint32_t crc, const void* data, const size_t size) noexcept(true);
+
+}  // namespace checksum
+}  // namespace persistent
+
+#endif  //CRC32C_HPP
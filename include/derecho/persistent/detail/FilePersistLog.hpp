@@ -4,14 +4,22 @@
 #include "PersistLog.hpp"
 #include "util.hpp"
 #include <derecho/utils/logger.hpp>
+#include <atomic>
+#include <memory>
 #include <pthread.h>
 #include <string>
+#include <thread>
+#include <utility>
+#include <vector>
 
 namespace persistent {
 
+class SharedLogGroup;
+
 #define META_FILE_SUFFIX "meta"
 #define LOG_FILE_SUFFIX "log"
 #define DATA_FILE_SUFFIX "data"
+#define CKPT_FILE_SUFFIX "ckpt"
 #define SWAP_FILE_SUFFIX "swp"
 
 // meta header format
@@ -20,23 +28,39 @@ typedef union meta_header {
         int64_t head;  // the head index
         int64_t tail;  // the tail index
         int64_t ver;   // the latest version number.
+        int64_t ckpt;  // version of the latest on-disk checkpoint snapshot
+                       // of the object, or INVALID_VERSION if none. Headers
+                       // written before this field existed hold arbitrary
+                       // padding bytes here, so the value is only honored
+                       // when the checkpoint file exists and records the
+                       // same version (see loadCheckpoint()).
                        // uint64_t d_head;  // the data head offset
                        // uint64_t d_tail;  // the data tail offset
     } fields;
     uint8_t bytes[256];
     bool operator==(const union meta_header& other) {
-        return (this->fields.head == other.fields.head) && (this->fields.tail == other.fields.tail) && (this->fields.ver == other.fields.ver);
+        return (this->fields.head == other.fields.head) && (this->fields.tail == other.fields.tail) && (this->fields.ver == other.fields.ver) && (this->fields.ckpt == other.fields.ckpt);
     };
 } MetaHeader;
 
 // log entry format
 typedef union log_entry {
     struct {
-        int64_t ver;     // version of the data
-        uint64_t dlen;   // length of the data
-        uint64_t ofst;   // offset of the data in the memory buffer
-        uint64_t hlc_r;  // realtime component of hlc
-        uint64_t hlc_l;  // logic component of hlc
+        int64_t ver;      // version of the data
+        uint64_t dlen;    // length of the data as stored (compressed size
+                          // when the entry is compressed)
+        uint64_t ofst;    // offset of the data in the memory buffer
+        uint64_t hlc_r;   // realtime component of hlc
+        uint64_t hlc_l;   // logic component of hlc
+        uint64_t rawlen;  // uncompressed length of the data; 0 means the
+                          // data is stored raw (also the value found in
+                          // entries written before compression existed,
+                          // since unused union bytes start zeroed)
+        uint32_t crc32;   // CRC32C over the entry fields (excluding ofst,
+                          // which is rewritten when an entry is merged from
+                          // a peer) and the stored data bytes; 0 means no
+                          // checksum was recorded (entries written before
+                          // checksumming existed)
     } fields;
     uint8_t bytes[64];
 } LogEntry;
@@ -99,10 +123,27 @@ protected:
     const std::string m_sLogFile;
     // full data file name
     const std::string m_sDataFile;
+    // full checkpoint file name
+    const std::string m_sCkptFile;
     // max number of log entry
     const uint64_t m_iMaxLogEntry;
     // max data size
     const uint64_t m_iMaxDataSize;
+    // true if PERS/compression is enabled: entry payloads that shrink under
+    // the LZ codec are stored compressed (see LogCompression.hpp). Reading
+    // is driven by each entry's rawlen field, not by this flag, so logs
+    // written with either setting stay readable.
+    const bool m_bCompression;
+    // The shared log group this log belongs to, or null when the log owns
+    // private files (the default). In grouped mode the log and data rings
+    // live in sections of the group's shared files and persist() stages its
+    // meta commit with the group instead of msync-ing its own ranges; see
+    // SharedLogGroup.hpp.
+    const std::shared_ptr<SharedLogGroup> m_pGroup;
+    // byte offsets of this log's sections within the group's files; 0 for a
+    // log with private files
+    uint64_t m_iLogSectionOffset;
+    uint64_t m_iDataSectionOffset;
 
     // the log file descriptor
     int m_iLogFileDesc;
@@ -113,10 +154,20 @@ protected:
     void* m_pLog;
     // memory mapped Data RingBuffer
     void* m_pData;
+    // Trim generation: incremented by every trim/truncate under FPL_WRLOCK.
+    // Readers holding an EntrySpan compare it against getTrimGeneration() to
+    // detect that the viewed entry may have been removed (and its ring bytes
+    // reused) since the span was taken.
+    std::atomic<uint64_t> m_trimGeneration;
     // read/write lock
     pthread_rwlock_t m_rwlock;
     // persistent lock
     pthread_mutex_t m_perslock;
+    // In-memory version index: (version, virtual log index) pairs in append
+    // order, so version lookups search a compact cached vector instead of
+    // binary-searching the mmap-ed LogEntry array. Maintained under
+    // FPL_WRLOCK; stale entries are dropped by pruneVersionIndex().
+    std::vector<std::pair<int64_t, int64_t>> vidx;
 
 // lock macro
 #define FPL_WRLOCK                                        \
@@ -169,9 +220,19 @@ public:
     //Constructor
     FilePersistLog(const std::string& name, const std::string& dataPath) noexcept(false);
     FilePersistLog(const std::string& name) noexcept(false) : FilePersistLog(name, getPersFilePath()){};
+    /** Grouped-mode constructor: this log's rings live in sections of the
+     * group's shared files and its durability barrier is deferred to the
+     * group's one sync per persist batch. */
+    FilePersistLog(const std::string& name, const std::string& dataPath,
+                   const std::shared_ptr<SharedLogGroup>& group) noexcept(false);
     //Destructor
     virtual ~FilePersistLog() noexcept(true);
 
+    /** Commit a meta header staged with the shared log group, after the
+     * group's fdatasync has made the pages it describes durable. Called
+     * only from SharedLogGroup::sync(). */
+    void commitMetaHeader(const MetaHeader& shadow_header) noexcept(false);
+
     //Derived from PersistLog
     virtual void append(const void* pdata,
                         const uint64_t& size, const int64_t& ver,
@@ -182,12 +243,19 @@ public:
     virtual int64_t getLatestIndex() noexcept(false);
     virtual int64_t getVersionIndex(const version_t& ver) noexcept(false);
     virtual int64_t getHLCIndex(const HLC& hlc) noexcept(false);
+    virtual bool getHLCIndexRange(const HLC& hlc_begin, const HLC& hlc_end,
+                                  int64_t& first_idx, int64_t& last_idx) noexcept(false);
     virtual version_t getEarliestVersion() noexcept(false);
     virtual version_t getLatestVersion() noexcept(false);
     virtual const version_t getLastPersisted() noexcept(false);
+    virtual version_t getVersionByIndex(const int64_t& eno) noexcept(false);
     virtual const void* getEntryByIndex(const int64_t& eno) noexcept(false);
     virtual const void* getEntry(const version_t& ver) noexcept(false);
     virtual const void* getEntry(const HLC& hlc) noexcept(false);
+    virtual EntrySpan getEntrySpan(const version_t& ver) noexcept(false);
+    virtual EntrySpan getEntrySpanByIndex(const int64_t& eno) noexcept(false);
+    virtual uint64_t getTrimGeneration() noexcept(true);
+    virtual void adviseSequentialRange(const int64_t& first_idx, const int64_t& last_idx) noexcept(false);
     virtual const version_t persist(const bool preLocked = false) noexcept(false);
     virtual void trimByIndex(const int64_t& eno) noexcept(false);
     virtual void trim(const version_t& ver) noexcept(false);
@@ -195,9 +263,16 @@ public:
     virtual void truncate(const version_t& ver) noexcept(false);
     virtual size_t bytes_size(const version_t& ver) noexcept(false);
     virtual size_t to_bytes(char* buf, const version_t& ver) noexcept(false);
+    virtual void postLogTail(const std::function<void(char const* const, std::size_t)>& f,
+                             const FileRangePostFunc& file_f,
+                             const version_t& ver) noexcept(false);
     virtual void post_object(const std::function<void(char const* const, std::size_t)>& f,
                              const version_t& ver) noexcept(false);
-    virtual void applyLogTail(char const* v) noexcept(false);
+    virtual size_t applyLogTail(char const* v) noexcept(false);
+    virtual version_t getCheckpointVersion() noexcept(false);
+    virtual void writeCheckpoint(const version_t& ver, const void* data,
+                                 const uint64_t& size) noexcept(false);
+    virtual std::unique_ptr<char[]> loadCheckpoint(version_t& ver) noexcept(false);
 
     template <typename TKey, typename KeyGetter>
     void trim(const TKey& key, const KeyGetter& keyGetter) noexcept(false) {
@@ -218,6 +293,8 @@ public:
         idx = binarySearch<TKey>(keyGetter, key, META_HEADER->fields.head, META_HEADER->fields.tail);
         if(idx != -1) {
             META_HEADER->fields.head = (idx + 1);
+            this->m_trimGeneration++;
+            pruneVersionIndex();
             FPL_PERS_LOCK;
             try {
                 persist(true);
@@ -262,6 +339,60 @@ private:
      *         that no log entry is available for the requested version.
      */
     int64_t getMinimumIndexBeyondVersion(const int64_t& ver) noexcept(false);
+    /**
+     * Look up the index of the latest entry with version <= ver through the
+     * in-memory version index, with a constant-time fast path for latest and
+     * near-latest versions. Falls back to binary-searching the mmap-ed log
+     * if the cache is empty. Note: no lock protected, use FPL_RDLOCK.
+     * @PARAM ver the requested version
+     * @RETURN the index found, or -1 if no entry has version <= ver.
+     */
+    int64_t lookupVersionIndex(const int64_t& ver) noexcept(false);
+    /**
+     * Drop cached version-index entries outside [head, tail). Called after
+     * trim/truncate move the log boundaries. Use FPL_WRLOCK.
+     */
+    void pruneVersionIndex() noexcept(true);
+    /**
+     * Get a log entry's payload in its uncompressed form: the ring-buffer
+     * data itself for a raw entry, or a decompressed copy in a thread-local
+     * scratch buffer (rawlen != 0). A returned scratch pointer is only valid
+     * until the calling thread's next read of a compressed entry.
+     * Note: no lock protected, use FPL_RDLOCK
+     * @PARAM ple - pointer to the log entry
+     * @RETURN pointer to the uncompressed payload
+     */
+    const void* entryData(const LogEntry* ple) noexcept(false);
+    /**
+     * Compute the CRC32C recorded in a log entry: the entry fields except
+     * ofst and crc32 itself, folded with the stored (possibly compressed)
+     * data bytes. A computed value of zero is mapped to an arbitrary nonzero
+     * constant so that zero can keep meaning "no checksum recorded".
+     * @PARAM ple - pointer to the log entry, with all fields except crc32 set
+     * @PARAM pdat - pointer to the stored data bytes (dlen of them)
+     * @RETURN the checksum value to store in or compare against ple->fields.crc32
+     */
+    static uint32_t checksumLogEntry(const LogEntry* ple, const void* pdat) noexcept(true);
+    /**
+     * Verify the checksums of all entries in [head, tail) with a pool of
+     * threads, each scanning a contiguous slice of the log, and truncate the
+     * log at the first entry that fails (a torn write from a crash corrupts
+     * a suffix of the log, so everything from the first bad entry on is
+     * suspect). Entries with no recorded checksum are skipped. Called from
+     * load() under FPL_WRLOCK and FPL_PERS_LOCK when "PERS/verify_on_load"
+     * is set, before the in-memory indices are built.
+     */
+    void verifyLogOnLoad() noexcept(false);
+    /**
+     * Start a pool of threads that fault in the used slice of the log and
+     * data rings (madvise(MADV_WILLNEED) plus touching one byte per page),
+     * so page-in overlaps with checksum verification and metadata indexing
+     * on the calling thread instead of being paid as major faults on the
+     * first read of every version. The double mapping makes each used slice
+     * contiguous even when it wraps. Called from load() under FPL_WRLOCK;
+     * the caller joins the returned threads.
+     */
+    std::vector<std::thread> prefaultUsedRanges() noexcept(true);
     /**
      * get the byte size of log entry
      * Note: no lock protected, use FPL_RDLOCK
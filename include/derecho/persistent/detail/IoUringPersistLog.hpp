@@ -0,0 +1,78 @@
+#ifndef IO_URING_PERSIST_LOG_HPP
+#define IO_URING_PERSIST_LOG_HPP
+
+#include "FilePersistLog.hpp"
+
+namespace persistent {
+
+/**
+ * IoUringPersistLog is a FilePersistLog variant that flushes the log tail
+ * through an io_uring instead of sequential msync() calls. One persist()
+ * submits the data-range writeback, the log-range writeback, and the durable
+ * fsyncs as a single batch, so the kernel overlaps the device I/O for the
+ * data and log files instead of the persist thread stalling on each range in
+ * turn. It is selected by setting PERS/use_io_uring in the configuration; if
+ * the ring cannot be created (e.g. an older kernel), it silently falls back
+ * to the inherited msync() path.
+ */
+class IoUringPersistLog : public FilePersistLog {
+public:
+    //Constructor
+    IoUringPersistLog(const std::string& name, const std::string& dataPath) noexcept(false);
+    IoUringPersistLog(const std::string& name) noexcept(false) : IoUringPersistLog(name, getPersFilePath()){};
+    //Destructor
+    virtual ~IoUringPersistLog() noexcept(true);
+
+    virtual const version_t persist(const bool preLocked = false) noexcept(false);
+
+private:
+    // the io_uring file descriptor, or -1 if ring setup failed
+    int m_iRingFd;
+    // number of submission/completion queue entries
+    uint32_t m_nSqEntries;
+    uint32_t m_nCqEntries;
+    // mmap-ed ring regions and their sizes (for munmap)
+    void* m_pSqRing;
+    size_t m_szSqRing;
+    void* m_pCqRing;
+    size_t m_szCqRing;
+    void* m_pSqes;
+    size_t m_szSqes;
+    // pointers into the submission queue ring
+    uint32_t* m_pSqHead;
+    uint32_t* m_pSqTail;
+    uint32_t* m_pSqMask;
+    uint32_t* m_pSqArray;
+    // pointers into the completion queue ring
+    uint32_t* m_pCqHead;
+    uint32_t* m_pCqTail;
+    uint32_t* m_pCqMask;
+    void* m_pCqes;
+
+    /** create and map the io_uring; returns false if unsupported. */
+    bool setupRing() noexcept(true);
+    /** unmap and close the io_uring, if one was created. */
+    void teardownRing() noexcept(true);
+    /**
+     * queue writeback of a flushed byte range of one of the ring-buffer
+     * files. The range is given as an offset into the doubly-mapped region,
+     * so it may wrap around the end of the file, in which case it is split
+     * into two submissions.
+     * @PARAM fd - the file descriptor of the log or data file
+     * @PARAM fileOffset - starting offset, already reduced modulo fileSize
+     * @PARAM length - number of bytes to flush
+     * @PARAM fileSize - the (fixed) size of the file
+     * @RETURN the number of submission entries queued.
+     */
+    uint32_t queueRangeWriteback(int fd, uint64_t fileOffset, uint64_t length,
+                                 uint64_t fileSize) noexcept(false);
+    /** queue a durable fdatasync of the given file. @RETURN entries queued. */
+    uint32_t queueDataSync(int fd) noexcept(false);
+    /** claim and zero the next submission queue entry (an io_uring_sqe). */
+    void* nextSqe() noexcept(true);
+    /** submit the queued entries and wait for all of them to complete. */
+    void submitAndWait(uint32_t numEntries) noexcept(false);
+};
+}  // namespace persistent
+
+#endif  //IO_URING_PERSIST_LOG_HPP
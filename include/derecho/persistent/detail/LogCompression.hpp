@@ -0,0 +1,41 @@
+#ifndef LOG_COMPRESSION_HPP
+#define LOG_COMPRESSION_HPP
+
+#include <cstddef>
+#include <cstdint>
+
+namespace persistent {
+
+/**
+ * A small self-contained LZ77 byte codec for log entry payloads, enabled by
+ * "PERS/compression". The format is a stream of sequences, each a token byte
+ * (high nibble: literal count, low nibble: match length - 4, 15 meaning
+ * "extended with 255-run bytes"), the literals, a 2-byte little-endian match
+ * offset, and any match extension bytes; the final sequence carries literals
+ * only. Serialized versions are typically repetitive enough (field names,
+ * zero padding, unchanged columns) that this trades a little CPU for a large
+ * cut in log-disk bandwidth; incompressible payloads are detected by the
+ * caller (compressed size not smaller than the input) and stored raw.
+ */
+namespace compression {
+
+/** The worst-case compressed size for an input of 'size' bytes. */
+size_t maxCompressedSize(const size_t size) noexcept(true);
+
+/**
+ * Compress 'size' bytes at 'src' into 'dst', which must have room for
+ * maxCompressedSize(size) bytes.
+ * @return the number of bytes written to 'dst'.
+ */
+size_t compress(const void* src, const size_t size, void* dst) noexcept(true);
+
+/**
+ * Decompress a buffer produced by compress() into exactly 'raw_size' bytes
+ * at 'dst'.
+ */
+void decompress(const void* src, const size_t size, void* dst, const size_t raw_size) noexcept(true);
+
+}  // namespace compression
+}  // namespace persistent
+
+#endif  //LOG_COMPRESSION_HPP
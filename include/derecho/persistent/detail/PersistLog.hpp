@@ -11,6 +11,7 @@
 #include <functional>
 #include <inttypes.h>
 #include <map>
+#include <memory>
 #include <set>
 #include <stdio.h>
 #include <string>
@@ -52,6 +53,25 @@ struct hlc_index_entry_comp {
     }
 };
 
+/**
+ * A borrowed, zero-copy view of one log entry's payload. 'data' points into
+ * the log's memory-mapped ring (or, for a compressed entry, into the calling
+ * thread's decompression scratch), so no allocation or copy is made. The
+ * pointer stays valid only while the entry remains in the log: compare
+ * 'generation' against getTrimGeneration() after reading through the span to
+ * detect a concurrent trim/truncate, and retry the read if they differ. An
+ * empty span (data == nullptr) means no entry matched the request.
+ */
+struct EntrySpan {
+    const void* data = nullptr;
+    uint64_t size = 0;
+    version_t ver = INVALID_VERSION;
+    uint64_t generation = 0;
+    explicit operator bool() const {
+        return data != nullptr;
+    }
+};
+
 // Persistent log interfaces
 class PersistLog {
 public:
@@ -106,6 +126,20 @@ public:
     // Get the Index corresponding to an HLC timestamp
     virtual int64_t getHLCIndex(const HLC& hlc) noexcept(false) = 0;
 
+    /**
+     * Find the virtual log index range covering all entries whose HLC
+     * timestamp falls in [hlc_begin, hlc_end]: one descent of the HLC index
+     * serves the whole range, instead of one per point-in-time lookup.
+     * @param hlc_begin - the beginning of the timestamp range, inclusive
+     * @param hlc_end - the end of the timestamp range, inclusive
+     * @param first_idx - receives the index of the earliest entry in range
+     * @param last_idx - receives the index of the latest entry in range
+     * @return true if at least one entry falls in the range; false otherwise,
+     *         in which case first_idx and last_idx are INVALID_INDEX.
+     */
+    virtual bool getHLCIndexRange(const HLC& hlc_begin, const HLC& hlc_end,
+                                  int64_t& first_idx, int64_t& last_idx) noexcept(false) = 0;
+
     // Get the Earlist version
     virtual version_t getEarliestVersion() noexcept(false) = 0;
 
@@ -115,6 +149,9 @@ public:
     // return the last persisted value
     virtual const version_t getLastPersisted() noexcept(false) = 0;
 
+    // Get the version of the log entry at an index
+    virtual version_t getVersionByIndex(const int64_t& eno) noexcept(false) = 0;
+
     // Get a version by entry number return both length and buffer
     virtual const void* getEntryByIndex(const int64_t& eno) noexcept(false) = 0;
 
@@ -126,6 +163,25 @@ public:
     // Get a version specified by hlc
     virtual const void* getEntry(const HLC& hlc) noexcept(false) = 0;
 
+    // Get a zero-copy view of the latest entry with version equal or earlier
+    // than ver; empty span if there is none.
+    virtual EntrySpan getEntrySpan(const version_t& ver) noexcept(false) = 0;
+
+    // Get a zero-copy view of the entry at an index (negative counts back
+    // from the tail, as in getEntryByIndex).
+    virtual EntrySpan getEntrySpanByIndex(const int64_t& eno) noexcept(false) = 0;
+
+    // Get the trim generation: a counter bumped by every trim/truncate. An
+    // EntrySpan is safe to dereference as long as this still matches its
+    // 'generation' field.
+    virtual uint64_t getTrimGeneration() noexcept(true) = 0;
+
+    // Advise the OS that the entries in [first_idx, last_idx] are about to
+    // be read once, in order, so it can read ahead aggressively and drop
+    // the pages behind the scan. Purely a hint: the default does nothing,
+    // for backends whose storage is not demand-paged.
+    virtual void adviseSequentialRange(const int64_t& first_idx, const int64_t& last_idx) noexcept(false) {}
+
     /**
      * Persist the log till specified version
      * @return - the version till which has been persisted.
@@ -178,12 +234,62 @@ public:
                              const version_t& ver)
             = 0;
 
+    /**
+     * Post the serialized log tail like post_object, but hand each entry's
+     * payload to file_f as a range of the log's backing data file instead of
+     * posting the bytes through f. The produced stream is identical to
+     * post_object's; only the small fixed-size headers and entry structs go
+     * through f, so a consumer backed by sendfile never copies the payload
+     * bytes through userspace.
+     * @PARAM f - the function to handle serialized header/entry bytes
+     * @PARAM file_f - the function to handle payload ranges of the data file
+     * @PARAM ver - from which version the detal begins(tail log)
+     *   INVALID_VERSION means to include all of the tail logs
+     */
+    virtual void postLogTail(const std::function<void(char const* const, std::size_t)>& f,
+                             const FileRangePostFunc& file_f,
+                             const version_t& ver)
+            = 0;
+
     /**
      * Check/Merge the LogTail to the existing log.
      * @PARAM dsm - deserialization manager
      * @PARAM v - serialized log bytes to be apllied
+     * @RETURN the number of bytes consumed from v
+     */
+    virtual size_t applyLogTail(char const* v) = 0;
+
+    /**
+     * Get the version of the latest on-disk checkpoint snapshot recorded
+     * for this log, or INVALID_VERSION if none is recorded.
+     */
+    virtual version_t getCheckpointVersion() noexcept(false) = 0;
+
+    /**
+     * Durably write a checkpoint snapshot of the object state at version
+     * 'ver' next to the log files, and record 'ver' as the checkpoint
+     * version. Recovery can then rebuild the object from the snapshot plus
+     * the log entries newer than 'ver' instead of replaying the whole log.
+     * @PARAM ver - the version the serialized state corresponds to; must
+     *   not exceed the last persisted version
+     * @PARAM data - the serialized object state
+     * @PARAM size - length of the serialized state in bytes
+     */
+    virtual void writeCheckpoint(const version_t& ver, const void* data,
+                                 const uint64_t& size) noexcept(false) = 0;
+
+    /**
+     * Load the latest checkpoint snapshot, if a valid one exists: the
+     * checkpoint file must be present, record the same version as the
+     * metadata, and not be newer than the latest version in the log (a
+     * truncate invalidates any checkpoint beyond it). A missing, stale or
+     * damaged checkpoint returns nullptr rather than throwing, so recovery
+     * merely loses the shortcut and falls back to full log replay.
+     * @PARAM ver - receives the checkpoint version on success
+     * @RETURN the serialized object state, or nullptr if no valid
+     *   checkpoint is available
      */
-    virtual void applyLogTail(char const* v) = 0;
+    virtual std::unique_ptr<char[]> loadCheckpoint(version_t& ver) noexcept(false) = 0;
 
     /**
      * Truncate the log strictly newer than 'ver'.
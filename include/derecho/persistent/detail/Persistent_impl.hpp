@@ -81,12 +81,32 @@ std::unique_ptr<std::string> _NameMaker<ObjectType, storageType>::make(const cha
 template <typename ObjectType,
           StorageType storageType>
 inline void Persistent<ObjectType, storageType>::initialize_log(const char* object_name) noexcept(false) {
+    this->m_nSnapshotInterval = derecho::getConfUInt32(CONF_PERS_SNAPSHOT_INTERVAL);
+    this->m_nDeltasSinceSnapshot = 0;
+    this->m_nCheckpointIntervalMs = derecho::getConfUInt32(CONF_PERS_CHECKPOINT_INTERVAL_MS);
+    this->m_nCheckpointVersion = INVALID_VERSION;
+    this->m_nCheckpointIndex = -1;
+    this->m_tLastCheckpoint = std::chrono::steady_clock::now();
     // STEP 1: initialize log
     this->m_pLog = nullptr;
     switch(storageType) {
         // file system
         case ST_FILE:
-            this->m_pLog = std::make_unique<FilePersistLog>(object_name);
+            if(!derecho::getConfString(CONF_PERS_PMEM_PATH).empty()) {
+                // a DAX mount takes precedence: persistence by cache-line
+                // writeback beats any flavor of syscall-driven writeback
+                this->m_pLog = std::make_unique<PmemPersistLog>(object_name);
+            } else if(derecho::getConfBoolean(CONF_PERS_USE_IO_URING)) {
+                this->m_pLog = std::make_unique<IoUringPersistLog>(object_name);
+            } else if(this->m_pRegistry != nullptr && this->m_pRegistry->getSharedLogGroup() != nullptr) {
+                // shared-log mode: this field's rings live in sections of
+                // the registry-wide files, and its durability barrier is
+                // deferred to the registry's one group sync per batch
+                this->m_pLog = std::make_unique<FilePersistLog>(object_name, getPersFilePath(),
+                                                                this->m_pRegistry->getSharedLogGroup());
+            } else {
+                this->m_pLog = std::make_unique<FilePersistLog>(object_name);
+            }
             if(this->m_pLog == nullptr) {
                 throw PERSIST_EXP_NEW_FAILED_UNKNOWN;
             }
@@ -110,6 +130,35 @@ template <typename ObjectType,
           StorageType storageType>
 inline void Persistent<ObjectType, storageType>::initialize_object_from_log(const std::function<std::unique_ptr<ObjectType>(void)>& object_factory,
                                                                             mutils::DeserializationManager* dm) {
+    if constexpr(std::is_base_of<IDeltaSupport<ObjectType>, ObjectType>::value) {
+        // restart shortcut: rebuild a delta-supported object from the latest
+        // on-disk checkpoint plus the log suffix after it, instead of
+        // replaying the whole log
+        version_t ckpt_ver;
+        std::unique_ptr<char[]> ckpt = this->m_pLog->loadCheckpoint(ckpt_ver);
+        if(ckpt != nullptr) {
+            dbg_default_debug("{0} restarts from checkpoint at version {1}.",
+                              this->m_pLog->m_sName, ckpt_ver);
+            std::unique_ptr<ObjectType> p = mutils::from_bytes<ObjectType>(dm, ckpt.get());
+            for(int64_t i = this->m_pLog->getEarliestIndex(); i <= this->m_pLog->getLatestIndex(); i++) {
+                if(this->m_pLog->getVersionByIndex(i) <= ckpt_ver) {
+                    continue;
+                }
+                const char* entry_data = (const char*)this->m_pLog->getEntryByIndex(i);
+                if(this->m_nSnapshotInterval > 0) {
+                    if(*(const uint8_t*)entry_data == SNAPSHOT_ENTRY_TAG) {
+                        p = mutils::from_bytes<ObjectType>(dm, entry_data + 1);
+                    } else {
+                        p->applyDelta(entry_data + 1);
+                    }
+                } else {
+                    p->applyDelta(entry_data);
+                }
+            }
+            this->m_pWrappedObject = std::move(p);
+            return;
+        }
+    }
     if(this->getNumOfVersions() > 0) {
         // load the object from log.
         this->m_pWrappedObject = this->getByIndex(this->getLatestIndex(), dm);
@@ -128,7 +177,12 @@ inline void Persistent<ObjectType, storageType>::register_callbacks() noexcept(f
                 std::bind(&Persistent<ObjectType, storageType>::persist, this),
                 std::bind(&Persistent<ObjectType, storageType>::trim<const int64_t>, this, std::placeholders::_1),  //trim by version:(const int64_t)
                 std::bind(&Persistent<ObjectType, storageType>::getLatestVersion, this),                            //get the latest persisted versions
-                std::bind(&Persistent<ObjectType, storageType>::truncate, this, std::placeholders::_1)              // truncate persistent versions.
+                std::bind(&Persistent<ObjectType, storageType>::truncate, this, std::placeholders::_1),             // truncate persistent versions.
+                std::bind(&Persistent<ObjectType, storageType>::getEarliestVersion, this),                          //get the earliest version in the log
+                std::bind(&Persistent<ObjectType, storageType>::getLogTailSize, this, std::placeholders::_1),       //measure a log tail
+                std::bind(&Persistent<ObjectType, storageType>::postLogTail, this, std::placeholders::_1, std::placeholders::_2, std::placeholders::_3),   //serialize a log tail
+                std::bind(&Persistent<ObjectType, storageType>::mergeLogTail, this, std::placeholders::_1, std::placeholders::_2),  //merge a log tail
+                std::bind(&Persistent<ObjectType, storageType>::trimToSafePoint, this, std::placeholders::_1)                       //compact the log to a safe replay point
                 );
     }
 }
@@ -151,6 +205,8 @@ Persistent<ObjectType, storageType>::Persistent(
         : m_pRegistry(persistent_registry) {
     // Initialize log
     initialize_log((object_name == nullptr) ? (*Persistent::getNameMaker().make(persistent_registry ? persistent_registry->get_subgroup_prefix() : nullptr)).c_str() : object_name);
+    // Keep a copy of the deserialization contexts for the checkpoint path
+    this->m_pDSM = std::make_unique<mutils::DeserializationManager>(dm.registered_v);
     // Initialize object
     initialize_object_from_log(object_factory, &dm);
     // Register Callbacks
@@ -163,6 +219,14 @@ Persistent<ObjectType, storageType>::Persistent(Persistent&& other) noexcept(fal
     this->m_pWrappedObject = std::move(other.m_pWrappedObject);
     this->m_pLog = std::move(other.m_pLog);
     this->m_pRegistry = other.m_pRegistry;
+    this->m_nSnapshotInterval = other.m_nSnapshotInterval;
+    this->m_nDeltasSinceSnapshot = other.m_nDeltasSinceSnapshot;
+    this->m_pDSM = std::move(other.m_pDSM);
+    this->m_pCheckpointState = std::move(other.m_pCheckpointState);
+    this->m_nCheckpointVersion = other.m_nCheckpointVersion;
+    this->m_nCheckpointIndex = other.m_nCheckpointIndex;
+    this->m_nCheckpointIntervalMs = other.m_nCheckpointIntervalMs;
+    this->m_tLastCheckpoint = other.m_tLastCheckpoint;
     register_callbacks();  // this callback will override the previous registry entry.
 }
 
@@ -173,10 +237,12 @@ Persistent<ObjectType, storageType>::Persistent(
         std::unique_ptr<ObjectType>& wrapped_obj_ptr,
         const char* log_tail,
         PersistentRegistry* persistent_registry,
-        mutils::DeserializationManager) noexcept(false)
+        mutils::DeserializationManager dm) noexcept(false)
         : m_pRegistry(persistent_registry) {
     // Initialize log
     initialize_log(object_name);
+    // Keep a copy of the deserialization contexts for the checkpoint path
+    this->m_pDSM = std::make_unique<mutils::DeserializationManager>(dm.registered_v);
     // patch it
     if(log_tail != nullptr) {
         this->m_pLog->applyLogTail(log_tail);
@@ -265,9 +331,36 @@ std::unique_ptr<ObjectType> Persistent<ObjectType, storageType>::getByIndex(
         mutils::DeserializationManager* dm) noexcept(false) {
     if
         constexpr(std::is_base_of<IDeltaSupport<ObjectType>, ObjectType>::value) {
+            if(this->m_nSnapshotInterval > 0) {
+                // find the most recent full snapshot at or before idx, then
+                // replay only the deltas after it, instead of the whole log
+                int64_t start = this->m_pLog->getEarliestIndex();
+                for(int64_t i = idx; i > start; i--) {
+                    if(*(const uint8_t*)this->m_pLog->getEntryByIndex(i) == SNAPSHOT_ENTRY_TAG) {
+                        start = i;
+                        break;
+                    }
+                }
+                std::unique_ptr<ObjectType> p = nullptr;
+                for(int64_t i = start; i <= idx; i++) {
+                    const char* entry_data = (const char*)this->m_pLog->getEntryByIndex(i);
+                    if((uint8_t)entry_data[0] == SNAPSHOT_ENTRY_TAG) {
+                        p = mutils::from_bytes<ObjectType>(dm, entry_data + 1);
+                    } else {
+                        if(p == nullptr) {
+                            p = ObjectType::create(dm);
+                        }
+                        p->applyDelta(entry_data + 1);
+                    }
+                }
+                if(p == nullptr) {
+                    p = ObjectType::create(dm);
+                }
+                return p;
+            }
+            // legacy untagged format: every entry is a bare delta
             // ObjectType* ot = new ObjectType{};
             std::unique_ptr<ObjectType> p = ObjectType::create(dm);
-            // TODO: accelerate this by checkpointing
             for(int64_t i = this->m_pLog->getEarliestIndex(); i <= idx; i++) {
                 const char* entry_data = (const char*)this->m_pLog->getEntryByIndex(i);
                 p->applyDelta(entry_data);
@@ -320,6 +413,24 @@ std::unique_ptr<ObjectType> Persistent<ObjectType, storageType>::get(
     }
 }
 
+template <typename ObjectType,
+          StorageType storageType>
+EntrySpan Persistent<ObjectType, storageType>::getEntrySpan(const version_t& ver) noexcept(false) {
+    return this->m_pLog->getEntrySpan(ver);
+}
+
+template <typename ObjectType,
+          StorageType storageType>
+EntrySpan Persistent<ObjectType, storageType>::getEntrySpanByIndex(const int64_t& idx) noexcept(false) {
+    return this->m_pLog->getEntrySpanByIndex(idx);
+}
+
+template <typename ObjectType,
+          StorageType storageType>
+bool Persistent<ObjectType, storageType>::isSpanValid(const EntrySpan& span) noexcept(true) {
+    return (span.data != nullptr) && (span.generation == this->m_pLog->getTrimGeneration());
+}
+
 template <typename ObjectType,
           StorageType storageType>
 template <typename TKey>
@@ -329,11 +440,60 @@ void Persistent<ObjectType, storageType>::trim(const TKey& k) noexcept(false) {
     dbg_default_trace("trim...done");
 }
 
+template <typename ObjectType,
+          StorageType storageType>
+const version_t Persistent<ObjectType, storageType>::trimToSafePoint(const version_t& upper_bound) noexcept(false) {
+    if(upper_bound == INVALID_VERSION || this->getNumOfVersions() <= 0) {
+        return INVALID_VERSION;
+    }
+    const int64_t bound_idx = this->m_pLog->getVersionIndex(upper_bound);
+    if(bound_idx == (int64_t)-1L || bound_idx == INVALID_INDEX) {
+        return INVALID_VERSION;
+    }
+    int64_t floor_idx = INVALID_INDEX;
+    if constexpr(std::is_base_of<IDeltaSupport<ObjectType>, ObjectType>::value) {
+        if(this->m_nSnapshotInterval <= 0) {
+            // a legacy delta log replays from its earliest entry, so no
+            // prefix of it can be dropped
+            return INVALID_VERSION;
+        }
+        // replay of any version after a full snapshot starts at that
+        // snapshot, so the latest snapshot entry at or below the bound is
+        // the new safe floor. The scan is bounded by the snapshot interval.
+        for(int64_t i = bound_idx; i >= this->m_pLog->getEarliestIndex(); i--) {
+            if(*(const uint8_t*)this->m_pLog->getEntryByIndex(i) == SNAPSHOT_ENTRY_TAG) {
+                floor_idx = i;
+                break;
+            }
+        }
+        if(floor_idx == INVALID_INDEX) {
+            return INVALID_VERSION;
+        }
+    } else {
+        // every entry holds a full state, so the latest entry at or below
+        // the bound can serve as the earliest retained version on its own
+        floor_idx = bound_idx;
+    }
+    const version_t floor_ver = this->m_pLog->getVersionByIndex(floor_idx);
+    if(floor_idx > this->m_pLog->getEarliestIndex()) {
+        dbg_default_trace("compact {0} to version {1}.", this->m_pLog->m_sName, floor_ver);
+        this->m_pLog->trimByIndex(floor_idx - 1);
+    }
+    return floor_ver;
+}
+
 template <typename ObjectType,
           StorageType storageType>
 void Persistent<ObjectType, storageType>::truncate(const int64_t& ver) {
     dbg_default_trace("truncate.");
     this->m_pLog->truncate(ver);
+    // the rolling checkpoint state now contains rolled-back versions; drop
+    // it so the next checkpoint rebuilds from a still-valid starting point
+    if(this->m_nCheckpointVersion != INVALID_VERSION && this->m_nCheckpointVersion > ver) {
+        this->m_pCheckpointState.reset();
+        this->m_nCheckpointVersion = INVALID_VERSION;
+        this->m_nCheckpointIndex = -1;
+    }
     dbg_default_trace("truncate...done");
 }
 
@@ -392,6 +552,166 @@ std::unique_ptr<ObjectType> Persistent<ObjectType, storageType>::get(
     }
 }
 
+template <typename ObjectType,
+          StorageType storageType>
+template <typename Func>
+std::size_t Persistent<ObjectType, storageType>::get_range(
+        const HLC& hlc_begin,
+        const HLC& hlc_end,
+        const Func& fun,
+        mutils::DeserializationManager* dm) noexcept(false) {
+    // global stability frontier test
+    if(m_pRegistry != nullptr && m_pRegistry->getFrontier() <= hlc_end) {
+        throw PERSIST_EXP_BEYOND_GSF;
+    }
+    int64_t first_idx, last_idx;
+    if(!this->m_pLog->getHLCIndexRange(hlc_begin, hlc_end, first_idx, last_idx)) {
+        return 0;
+    }
+    std::size_t num_versions = 0;
+    if
+        constexpr(std::is_base_of<IDeltaSupport<ObjectType>, ObjectType>::value) {
+            // materialize the state once at the start of the range (replaying
+            // from the nearest snapshot), then roll it forward entry by entry
+            // instead of replaying the log once per version
+            std::unique_ptr<ObjectType> state = this->getByIndex(first_idx, dm);
+            fun(this->m_pLog->getVersionByIndex(first_idx), *state);
+            num_versions++;
+            for(int64_t idx = first_idx + 1; idx <= last_idx; idx++) {
+                const char* entry_data = (const char*)this->m_pLog->getEntryByIndex(idx);
+                if(this->m_nSnapshotInterval > 0) {
+                    // tagged format: a full snapshot entry replaces the
+                    // state, a delta entry advances it
+                    if(*(const uint8_t*)entry_data == SNAPSHOT_ENTRY_TAG) {
+                        state = mutils::from_bytes<ObjectType>(dm, entry_data + 1);
+                    } else {
+                        state->applyDelta(entry_data + 1);
+                    }
+                } else {
+                    state->applyDelta(entry_data);
+                }
+                fun(this->m_pLog->getVersionByIndex(idx), *state);
+                num_versions++;
+            }
+        }
+    else {
+        for(int64_t idx = first_idx; idx <= last_idx; idx++) {
+            mutils::deserialize_and_run<ObjectType>(
+                    dm, (char*)this->m_pLog->getEntryByIndex(idx),
+                    [&](const ObjectType& obj) {
+                        fun(this->m_pLog->getVersionByIndex(idx), obj);
+                    });
+            num_versions++;
+        }
+    }
+    return num_versions;
+}
+
+template <typename ObjectType,
+          StorageType storageType>
+Persistent<ObjectType, storageType>::VersionRangeIterator::VersionRangeIterator(
+        Persistent<ObjectType, storageType>* parent,
+        const int64_t& first_idx,
+        const int64_t& last_idx)
+        : m_pParent(parent),
+          m_nCurrentIndex(first_idx),
+          m_nLastIndex(last_idx),
+          m_nGeneration(parent->m_pLog->getTrimGeneration()),
+          m_bStateMaterialized(false) {
+    if(first_idx <= last_idx) {
+        parent->m_pLog->adviseSequentialRange(first_idx, last_idx);
+    }
+}
+
+template <typename ObjectType,
+          StorageType storageType>
+EntrySpan Persistent<ObjectType, storageType>::VersionRangeIterator::next_span() noexcept(false) {
+    if(!has_next()) {
+        throw PERSIST_EXP_INV_VERSION;
+    }
+    EntrySpan span = m_pParent->m_pLog->getEntrySpanByIndex(m_nCurrentIndex);
+    m_nCurrentIndex++;
+    return span;
+}
+
+template <typename ObjectType,
+          StorageType storageType>
+version_t Persistent<ObjectType, storageType>::VersionRangeIterator::next_object(
+        ObjectType& scratch,
+        mutils::DeserializationManager* dm) noexcept(false) {
+    if(!has_next()) {
+        throw PERSIST_EXP_INV_VERSION;
+    }
+    version_t ver;
+    if constexpr(std::is_base_of<IDeltaSupport<ObjectType>, ObjectType>::value) {
+        if(!m_bStateMaterialized) {
+            // materialize the state once at the start of the range
+            // (replaying from the nearest snapshot); later entries only
+            // roll it forward
+            scratch = std::move(*m_pParent->getByIndex(m_nCurrentIndex, dm));
+            ver = m_pParent->m_pLog->getVersionByIndex(m_nCurrentIndex);
+            m_bStateMaterialized = true;
+        } else {
+            EntrySpan span = m_pParent->m_pLog->getEntrySpanByIndex(m_nCurrentIndex);
+            const char* entry_data = (const char*)span.data;
+            if(m_pParent->m_nSnapshotInterval > 0) {
+                // tagged format: a full snapshot entry replaces the state,
+                // a delta entry advances it
+                if(*(const uint8_t*)entry_data == SNAPSHOT_ENTRY_TAG) {
+                    scratch = *mutils::from_bytes_noalloc<ObjectType>(dm, entry_data + 1,
+                                                                      mutils::context_ptr<ObjectType>{});
+                } else {
+                    scratch.applyDelta(entry_data + 1);
+                }
+            } else {
+                scratch.applyDelta(entry_data);
+            }
+            // the rolled-forward state is garbage if the entry's bytes were
+            // reused by a concurrent trim while we read them
+            if(!m_pParent->isSpanValid(span)) {
+                throw PERSIST_EXP_INV_VERSION;
+            }
+            ver = span.ver;
+        }
+    } else {
+        EntrySpan span = m_pParent->m_pLog->getEntrySpanByIndex(m_nCurrentIndex);
+        // a borrowed view, copy-assigned into the scratch object so its
+        // storage (e.g. a vector's capacity) is reused across entries
+        scratch = *mutils::from_bytes_noalloc<ObjectType>(dm, (const char*)span.data,
+                                                          mutils::context_ptr<ObjectType>{});
+        if(!m_pParent->isSpanValid(span)) {
+            throw PERSIST_EXP_INV_VERSION;
+        }
+        ver = span.ver;
+    }
+    m_nCurrentIndex++;
+    return ver;
+}
+
+template <typename ObjectType,
+          StorageType storageType>
+typename Persistent<ObjectType, storageType>::VersionRangeIterator
+Persistent<ObjectType, storageType>::open_version_range(
+        const version_t& ver_begin,
+        const version_t& ver_end) noexcept(false) {
+    // latest entry at or below the end of the range
+    const int64_t last_idx = this->m_pLog->getVersionIndex(ver_end);
+    if(last_idx == INVALID_INDEX) {
+        return VersionRangeIterator(this, 0, -1);  // nothing at or below ver_end
+    }
+    // first entry at or above the start of the range
+    int64_t first_idx = this->m_pLog->getVersionIndex(ver_begin);
+    if(first_idx == INVALID_INDEX) {
+        first_idx = this->m_pLog->getEarliestIndex();
+    } else if(this->m_pLog->getVersionByIndex(first_idx) < ver_begin) {
+        first_idx++;
+    }
+    if(first_idx > last_idx) {
+        return VersionRangeIterator(this, 0, -1);
+    }
+    return VersionRangeIterator(this, first_idx, last_idx);
+}
+
 template <typename ObjectType,
           StorageType storageType>
 int64_t Persistent<ObjectType, storageType>::getNumOfVersions() noexcept(false) {
@@ -434,9 +754,34 @@ void Persistent<ObjectType, storageType>::set(ObjectType& v, const version_t& ve
     dbg_default_trace("append to log with ver({}),hlc({},{})", ver, mhlc.m_rtc_us, mhlc.m_logic);
     if
         constexpr(std::is_base_of<IDeltaSupport<ObjectType>, ObjectType>::value) {
-            v.finalizeCurrentDelta([&](char const* const buf, size_t len) {
-                this->m_pLog->append((const void* const)buf, len, ver, mhlc);
-            });
+            if(this->m_nSnapshotInterval > 0) {
+                // snapshot mode: every payload carries an entry-kind tag
+                if(this->m_nDeltasSinceSnapshot >= this->m_nSnapshotInterval) {
+                    // the snapshot captures the pending delta's effect, so
+                    // collect and discard it before serializing the state
+                    v.finalizeCurrentDelta([](char const* const, std::size_t) {});
+                    auto size = mutils::bytes_size(v);
+                    char* buf = new char[size + 1];
+                    buf[0] = SNAPSHOT_ENTRY_TAG;
+                    mutils::to_bytes(v, buf + 1);
+                    this->m_pLog->append((void*)buf, size + 1, ver, mhlc);
+                    delete[] buf;
+                    this->m_nDeltasSinceSnapshot = 0;
+                } else {
+                    v.finalizeCurrentDelta([&](char const* const delta, std::size_t len) {
+                        char* buf = new char[len + 1];
+                        buf[0] = DELTA_ENTRY_TAG;
+                        memcpy(buf + 1, delta, len);
+                        this->m_pLog->append((const void* const)buf, len + 1, ver, mhlc);
+                        delete[] buf;
+                    });
+                    this->m_nDeltasSinceSnapshot++;
+                }
+            } else {
+                v.finalizeCurrentDelta([&](char const* const buf, size_t len) {
+                    this->m_pLog->append((const void* const)buf, len, ver, mhlc);
+                });
+            }
         }
     else {
         // ObjectType does not support Delta, logging the whole current state.
@@ -483,10 +828,78 @@ const int64_t Persistent<ObjectType, storageType>::persist() noexcept(false) {
     clock_gettime(CLOCK_REALTIME, &t2);
     cnt_in_persist++;
     ns_in_persist += ((t2.tv_sec - t1.tv_sec) * 1000000000ul + t2.tv_nsec - t1.tv_nsec);
-    return ret;
 #else
-    return this->m_pLog->persist();
+    const int64_t ret = this->m_pLog->persist();
 #endif  //_PERFORMANCE_DEBUG
+    this->checkpoint_if_due(ret);
+    return ret;
+}
+
+template <typename ObjectType,
+          StorageType storageType>
+void Persistent<ObjectType, storageType>::checkpoint_if_due(const version_t& last_persisted) noexcept(false) {
+    if constexpr(std::is_base_of<IDeltaSupport<ObjectType>, ObjectType>::value) {
+        if(this->m_nCheckpointIntervalMs == 0 || last_persisted == INVALID_VERSION
+           || last_persisted <= this->m_nCheckpointVersion) {
+            return;
+        }
+        const auto now = std::chrono::steady_clock::now();
+        if(now - this->m_tLastCheckpoint < std::chrono::milliseconds(this->m_nCheckpointIntervalMs)) {
+            return;
+        }
+        if(this->m_pCheckpointState == nullptr) {
+            // seed the rolling state from the last on-disk checkpoint if one
+            // validates, otherwise from a fresh object at the log origin
+            version_t ckpt_ver;
+            std::unique_ptr<char[]> ckpt = this->m_pLog->loadCheckpoint(ckpt_ver);
+            if(ckpt != nullptr) {
+                this->m_pCheckpointState = mutils::from_bytes<ObjectType>(this->m_pDSM.get(), ckpt.get());
+                this->m_nCheckpointVersion = ckpt_ver;
+            } else {
+                this->m_pCheckpointState = ObjectType::create(this->m_pDSM.get());
+                this->m_nCheckpointVersion = INVALID_VERSION;
+            }
+            this->m_nCheckpointIndex = this->m_pLog->getEarliestIndex() - 1;
+        }
+        // roll the state forward to the persisted frontier. Only persisted
+        // versions go into a checkpoint, so a checkpoint is never ahead of
+        // what survives a crash.
+        const int64_t latest_idx = this->m_pLog->getLatestIndex();
+        for(int64_t idx = std::max(this->m_nCheckpointIndex + 1, this->m_pLog->getEarliestIndex());
+            idx <= latest_idx; idx++) {
+            const version_t entry_ver = this->m_pLog->getVersionByIndex(idx);
+            if(entry_ver > last_persisted) {
+                break;
+            }
+            if(entry_ver > this->m_nCheckpointVersion) {
+                const char* entry_data = (const char*)this->m_pLog->getEntryByIndex(idx);
+                if(this->m_nSnapshotInterval > 0) {
+                    if(*(const uint8_t*)entry_data == SNAPSHOT_ENTRY_TAG) {
+                        this->m_pCheckpointState = mutils::from_bytes<ObjectType>(this->m_pDSM.get(), entry_data + 1);
+                    } else {
+                        this->m_pCheckpointState->applyDelta(entry_data + 1);
+                    }
+                } else {
+                    this->m_pCheckpointState->applyDelta(entry_data);
+                }
+                this->m_nCheckpointVersion = entry_ver;
+            }
+            this->m_nCheckpointIndex = idx;
+        }
+        if(this->m_nCheckpointVersion == INVALID_VERSION
+           || this->m_nCheckpointVersion == this->m_pLog->getCheckpointVersion()) {
+            // nothing new to capture (e.g. the persisted frontier advanced
+            // only through version gaps)
+            this->m_tLastCheckpoint = now;
+            return;
+        }
+        const std::size_t size = mutils::bytes_size(*this->m_pCheckpointState);
+        char* buf = new char[size];
+        mutils::to_bytes(*this->m_pCheckpointState, buf);
+        this->m_pLog->writeCheckpoint(this->m_nCheckpointVersion, buf, size);
+        delete[] buf;
+        this->m_tLastCheckpoint = now;
+    }
 }
 
 template <typename ObjectType,
@@ -547,6 +960,32 @@ void Persistent<ObjectType, storageType>::applyLogTail(mutils::DeserializationMa
     this->m_pLog->applyLogTail(v);
 }
 
+template <typename ObjectType,
+          StorageType storageType>
+std::size_t Persistent<ObjectType, storageType>::getLogTailSize(const version_t& ver) noexcept(false) {
+    return this->m_pLog->bytes_size(ver);
+}
+
+template <typename ObjectType,
+          StorageType storageType>
+void Persistent<ObjectType, storageType>::postLogTail(const std::function<void(char const* const, std::size_t)>& f,
+                                                      const FileRangePostFunc& file_f,
+                                                      const version_t& ver) noexcept(false) {
+    this->m_pLog->postLogTail(f, file_f, ver);
+}
+
+template <typename ObjectType,
+          StorageType storageType>
+std::size_t Persistent<ObjectType, storageType>::mergeLogTail(mutils::DeserializationManager* dsm, char const* v) {
+    const std::size_t consumed = this->m_pLog->applyLogTail(v);
+    // the log now extends past the in-memory object, so reload it, the same
+    // way initialize_object_from_log does on restart
+    if(this->getNumOfVersions() > 0) {
+        this->m_pWrappedObject = this->getByIndex(this->getLatestIndex(), dsm);
+    }
+    return consumed;
+}
+
 #if defined(_PERFORMANCE_DEBUG)
 template <typename ObjectType,
           StorageType storageType>
@@ -0,0 +1,72 @@
+#ifndef PMEM_PERSIST_LOG_HPP
+#define PMEM_PERSIST_LOG_HPP
+
+#include "FilePersistLog.hpp"
+
+namespace persistent {
+
+/**
+ * PmemPersistLog is a FilePersistLog variant for logs living on a DAX
+ * filesystem backed by persistent memory. It remaps the log and data ring
+ * buffers with MAP_SYNC, so a store followed by a cache-line writeback
+ * (clwb/clflushopt) and a store fence is durable without any syscall, and
+ * persist() becomes a walk over the dirty cache lines instead of msync().
+ * The meta header is double-buffered in a DAX-mapped side file
+ * ("<name>.pmeta"): a persist writes the inactive slot, fences, then flips
+ * an 8-byte selector, which replaces the swap-file rename of the base
+ * class on the hot path. The regular meta file is still rewritten on clean
+ * shutdown, and on startup the newer of the two wins, so a log can move
+ * between this backend and FilePersistLog freely.
+ *
+ * It is selected by pointing PERS/pmem_path at a DAX mount. If MAP_SYNC is
+ * refused there (not actually DAX, or an older kernel) the instance
+ * silently falls back to the inherited msync() path.
+ */
+class PmemPersistLog : public FilePersistLog {
+public:
+    //Constructor
+    PmemPersistLog(const std::string& name, const std::string& dataPath) noexcept(false);
+    PmemPersistLog(const std::string& name) noexcept(false) : PmemPersistLog(name, getPersPmemPath()){};
+    //Destructor
+    virtual ~PmemPersistLog() noexcept(true);
+
+    virtual const version_t persist(const bool preLocked = false) noexcept(false);
+
+protected:
+    // the double-buffered meta header page, mapped from the pmeta file
+    struct PmetaSlab {
+        MetaHeader slots[2];
+        // monotonically increasing; the active slot is (selector & 1).
+        // 0 means no slot has been written yet.
+        uint64_t selector;
+    };
+
+    // true if all three files were successfully mapped with MAP_SYNC and
+    // cache-line writeback instructions are available on this build
+    bool m_bDax;
+    // the pmeta file descriptor, or -1
+    int m_iPmetaFileDesc;
+    // the mapped pmeta page, or MAP_FAILED
+    void* m_pPmeta;
+
+    /**
+     * Publish a new persisted meta header through the pmeta slab: write the
+     * inactive slot, fence, flip the selector, fence. Assumes the data and
+     * log flushes it covers have already been fenced.
+     */
+    void persistMetaHeaderFast(MetaHeader* pShadowHeader) noexcept(false);
+
+private:
+    /** map the pmeta file and remap the rings with MAP_SYNC; sets m_bDax. */
+    void setupDax() noexcept(false);
+    /**
+     * Adopt the pmeta slab's header if it is newer than what the base class
+     * loaded from the meta file (i.e. the previous run crashed after a fast
+     * meta publish), extending the in-memory indices to the adopted tail;
+     * otherwise refresh the slab from the loaded header.
+     */
+    void reconcileMetaHeaders() noexcept(false);
+};
+}  // namespace persistent
+
+#endif  //PMEM_PERSIST_LOG_HPP
@@ -0,0 +1,102 @@
+#ifndef SHARED_LOG_GROUP_HPP
+#define SHARED_LOG_GROUP_HPP
+
+#include "FilePersistLog.hpp"
+#include <memory>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace persistent {
+
+/**
+ * SharedLogGroup consolidates the storage of every file-backed Persistent<T>
+ * field registered with one PersistentRegistry into a single pair of shared
+ * files, selected by setting PERS/shared_log in the configuration. Each
+ * member FilePersistLog is assigned a page-aligned section of the shared log
+ * file and of the shared data file and maps its ring buffers from there, so
+ * its logical indexes, version lookups, and log-tail serialization work
+ * exactly as they do over private files. The payoff is in persist(): instead
+ * of msync-ing its own ranges, a member stages its meta-header commit here,
+ * and the registry calls sync() once per persist batch -- one fdatasync of
+ * the log file and one of the data file cover every field's writes, after
+ * which the staged meta headers commit. The number of durability barriers
+ * per version batch is therefore constant instead of proportional to the
+ * field count.
+ *
+ * Sections are assigned in member construction order, which C++ fixes as the
+ * declaration order of the replicated object's fields, so a restart maps
+ * every field back onto its former section. Like PERS/snapshot_interval, the
+ * PERS/shared_log setting must not change over the lifetime of an existing
+ * store.
+ */
+class SharedLogGroup {
+public:
+    /**
+     * Open (or create) the shared files for one registry.
+     * @param name The group name; built from the subgroup prefix so that
+     *        different shards keep separate files.
+     * @param dataPath The directory holding the persistent files.
+     */
+    SharedLogGroup(const std::string& name, const std::string& dataPath) noexcept(false);
+    ~SharedLogGroup() noexcept(true);
+
+    /**
+     * Allocate the next page-aligned section in each shared file, growing
+     * the files as needed, and return the (log, data) byte offsets. Called
+     * from a joining member's load().
+     */
+    std::pair<uint64_t, uint64_t> addSection(const uint64_t& logBytes, const uint64_t& dataBytes) noexcept(false);
+
+    int getLogFileDesc() const noexcept(true) {
+        return m_iLogFileDesc;
+    }
+    int getDataFileDesc() const noexcept(true) {
+        return m_iDataFileDesc;
+    }
+    const std::string& getLogFilePath() const noexcept(true) {
+        return m_sLogFile;
+    }
+    const std::string& getDataFilePath() const noexcept(true) {
+        return m_sDataFile;
+    }
+
+    /**
+     * Stage a member's meta-header commit until the next sync(), replacing
+     * any commit the member has already staged.
+     */
+    void stageCommit(FilePersistLog* member, const MetaHeader& shadow_header) noexcept(false);
+
+    /** Drop a member's staged commit; called from its destructor. */
+    void forgetMember(FilePersistLog* member) noexcept(true);
+
+    /**
+     * One durability barrier for all members' writes since the last sync
+     * (fdatasync of the log and data files), followed by the staged meta
+     * commits. A no-op when nothing is staged.
+     */
+    void sync() noexcept(false);
+
+private:
+    // full log file name
+    const std::string m_sLogFile;
+    // full data file name
+    const std::string m_sDataFile;
+    // the shared log file descriptor
+    int m_iLogFileDesc;
+    // the shared data file descriptor
+    int m_iDataFileDesc;
+    // Section allocation cursors: running byte sizes, deliberately derived
+    // from the join sequence rather than the on-disk file sizes so that the
+    // same construction order yields the same offsets on every restart.
+    uint64_t m_iLogBytesAllocated;
+    uint64_t m_iDataBytesAllocated;
+    // guards section allocation and the staged commits
+    std::mutex m_groupMutex;
+    // meta-header commits deferred until the next sync()
+    std::vector<std::pair<FilePersistLog*, MetaHeader>> m_stagedCommits;
+};
+}  // namespace persistent
+
+#endif  //SHARED_LOG_GROUP_HPP
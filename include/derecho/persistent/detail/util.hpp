@@ -37,6 +37,11 @@ inline std::string getPersFilePath() {
     return std::string(derecho::getConfString(CONF_PERS_FILE_PATH));
 }
 
+// the DAX/persistent-memory mount for PmemPersistLog; empty if unset
+inline std::string getPersPmemPath() {
+    return std::string(derecho::getConfString(CONF_PERS_PMEM_PATH));
+}
+
 // verify the existence of a folder
 // Check if directory exists or not. Create it on absence.
 // return error if creating failed
@@ -50,6 +50,21 @@ class unsupported_feature : public exception {};
 //  void operator() (fi_struct_type* fi_struct) const {fi_close(fi_struct->fid);}
 //};
 
+/**
+ * Describes the kind of memory a buffer to be registered lives in, so that
+ * a memory_region can wrap device memory (GPUDirect RDMA) as well as
+ * ordinary host memory.
+ */
+struct memory_attribute {
+    enum class memory_type { host,
+                             cuda };
+    memory_type type;
+    /** CUDA device ordinal that owns the buffer; only meaningful for cuda. */
+    int device_id;
+    static memory_attribute host() { return {memory_type::host, 0}; }
+    static memory_attribute cuda(int device_id) { return {memory_type::cuda, device_id}; }
+};
+
 /**
  * A C++ wrapper for the libfabric fid_mr struct. Registers a memory region for 
  * the provided buffer on construction, and deregisters it on destruction.
@@ -57,6 +72,9 @@ class unsupported_feature : public exception {};
 class memory_region {
     /** Smart pointer for managing the registered memory region */
     std::unique_ptr<fid_mr, std::function<void(fid_mr*)>> mr;
+    /** Registration of the same buffer on the second rail's domain; null
+     * unless RDMA/second_domain is configured. */
+    std::unique_ptr<fid_mr, std::function<void(fid_mr*)>> second_mr;
     /** Smart pointer for managing the buffer the mr uses */
     std::unique_ptr<char[]> allocated_buffer;
 
@@ -82,12 +100,31 @@ public:
      *      the memory region.
      */
     memory_region(char* buffer, size_t size);
+    /**
+     * Constructor
+     * Registers a memory region over a buffer that may live in device
+     * memory: a cuda attribute registers the CUDA device pointer through
+     * the provider's FI_HMEM support (GPUDirect RDMA), so RDMC block
+     * transfers move device-to-device without staging through host memory.
+     * Requires RDMA/enable_hmem and a libfabric build and provider with
+     * FI_HMEM support; throws unsupported_feature otherwise.
+     *
+     * @param buffer The memory that will be registered; a CUDA device
+     *     pointer when attr is cuda.
+     * @param size The size in bytes of the buffer to be associated with
+     *      the memory region.
+     * @param attr Where the buffer lives (host or a CUDA device).
+     */
+    memory_region(char* buffer, size_t size, const memory_attribute& attr);
     /**
      * get_key
      * Returns the key associated with the registered memory region, which
      * is used to access the region.
+     *
+     * @param rail The rail whose registration key to return (0 for the
+     *     primary domain, 1 for the second domain when one is configured).
      */
-    uint64_t get_key() const;
+    uint64_t get_key(unsigned int rail = 0) const;
 
     char* const buffer;
     const size_t size;
@@ -103,14 +140,18 @@ public:
      * @param length The size of the remote buffer in bytes.
      * @param remote_key The key used to refer to the buffer
      *     for remote accesses.
+     * @param second_remote_key The key for the remote node's registration of
+     *     the same buffer on its second rail, or 0 if it has no second rail.
      */
     remote_memory_region(uint64_t remote_address, size_t length,
-                         uint64_t remote_key)
-            : buffer(remote_address), size(length), rkey(remote_key) {}
+                         uint64_t remote_key, uint64_t second_remote_key = 0)
+            : buffer(remote_address), size(length), rkey(remote_key),
+              second_rkey(second_remote_key) {}
 
     const uint64_t buffer;
     const size_t size;
     const uint64_t rkey;
+    const uint64_t second_rkey;
 };
 
 /**
@@ -163,6 +204,10 @@ protected:
     /** Smart pointer for managing the endpoint */
     std::unique_ptr<fid_eq, std::function<void(fid_eq*)>> eq;
     std::unique_ptr<fid_ep, std::function<void(fid_ep*)>> ep;
+    /** A second connection to the same remote node over the second rail's
+     * domain; only established when RDMA/second_domain is configured. */
+    std::unique_ptr<fid_eq, std::function<void(fid_eq*)>> second_eq;
+    std::unique_ptr<fid_ep, std::function<void(fid_ep*)>> second_ep;
 
     explicit endpoint() {}
 
@@ -201,10 +246,12 @@ public:
      * init
      * Creates an endpoint, and then initializes/enables it
      *
-     * @param fi A struct containing information about the current 
+     * @param fi A struct containing information about the current
      *     fabric services.
+     * @param rail The rail (0 = primary domain, 1 = second domain) on which
+     *     to create the endpoint.
      */
-    int init(struct fi_info* fi);
+    int init(struct fi_info* fi, unsigned int rail = 0);
     /**
      * connect
      * Uses the initialized endpoint to connect to a remote node
@@ -229,11 +276,13 @@ public:
      * @param size The size (in bytes) of the buffer being sent.
      * @param wr_id A parameter used to differentiate types of messages.
      * @param immediate A parameter used only for send operations.
-     * @param message_type 
+     * @param message_type
+     * @param rail The rail to send on; both sides of a transfer must agree
+     *     on the rail so the send matches the receive posted for it.
      */
     bool post_send(const memory_region& mr, size_t offset,
                    size_t size, uint64_t wr_id, uint32_t immediate,
-                   const message_type& type);
+                   const message_type& type, unsigned int rail = 0);
     /**
      * post_recv
      * Uses the libfabrics API to post a buffer to the recv queue of an endpoint.
@@ -242,11 +291,12 @@ public:
      * @param offset The offset into the buffer managed by mr.
      * @param size The size (in bytes) of the buffer.
      * @param wr_id A parameter used to differentiate types of messages.
-     * @param message_type  
+     * @param message_type
+     * @param rail The rail on which the matching send will arrive.
      */
     bool post_recv(const memory_region& mr, size_t offset,
                    size_t size, uint64_t wr_id,
-                   const message_type& type);
+                   const message_type& type, unsigned int rail = 0);
 
     bool post_empty_send(uint64_t wr_id, uint32_t immediate,
                          const message_type& type);
@@ -255,7 +305,8 @@ public:
     bool post_write(const memory_region& mr, size_t offset, size_t size,
                     uint64_t wr_id, remote_memory_region remote_mr,
                     size_t remote_offset, const message_type& type,
-                    bool signaled = false, bool send_inline = false);
+                    bool signaled = false, bool send_inline = false,
+                    unsigned int rail = 0);
 
     fi_addr_t remote_fi_addr;
 };
@@ -305,8 +356,33 @@ std::map<uint32_t, remote_memory_region> lf_exchange_memory_regions(
         const std::vector<uint32_t>& members, uint32_t node_rank,
         const memory_region& mr);
 
+/**
+ * Fixed-size wrapper for exchanging raw fabric endpoint addresses (as
+ * returned by fi_getname) over the RDMC TCP connections, whose exchange
+ * primitive requires a trivially-copyable type.
+ */
+struct exchanged_ep_addr {
+    uint32_t addr_len;
+    uint8_t addr[124];
+};
+
+/** Sends this node's endpoint address to every other member and collects
+ * theirs, keyed by node ID. */
+std::map<uint32_t, exchanged_ep_addr> lf_exchange_endpoint_addrs(
+        const std::vector<uint32_t>& members, uint32_t node_rank,
+        const exchanged_ep_addr& local_addr);
+
 bool set_interrupt_mode(bool enabled);
 
+/**
+ * The number of RDMA rails (NICs) RDMC block transfers are striped across:
+ * 2 when RDMA/second_domain is configured, 1 otherwise. Senders and
+ * receivers must assign each block to the same rail (block number modulo
+ * the rail count), because two-sided sends match the receives posted on
+ * the same connection in order.
+ */
+unsigned int lf_num_rails();
+
 /**
  * Internal-only enum describing what action error-handling functions should
  * take if a LibFabric function fails.
@@ -0,0 +1,152 @@
+#ifndef UD_MULTICAST_HPP
+#define UD_MULTICAST_HPP
+
+#ifndef USE_VERBS_API
+
+#include <derecho/rdmc/group_send.hpp>
+#include "lf_helper.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include <rdma/fabric.h>
+
+/**
+ * An RDMC group backend that disseminates messages with hardware
+ * (unreliable-datagram) multicast instead of a schedule of point-to-point
+ * block transfers: the root fragments a message into MTU-sized datagrams and
+ * posts each one once to a switch-managed multicast address, so the NIC sends
+ * each fragment once regardless of the receiver count.
+ *
+ * Reliability is restored in software. Every fragment carries the message
+ * sequence number, its index, and the total message size; receivers reassemble
+ * into the buffer provided by the incoming-message upcall and track received
+ * fragments in a bitmap. A receiver that stalls on an incomplete message sends
+ * NACKs for the missing fragments over a unicast datagram to the root, which
+ * retransmits them (duplicates are dropped by the bitmap). The root also
+ * multicasts a periodic announcement of its latest sequence number so a
+ * receiver that lost every fragment of a message still learns it exists.
+ * Global stability is still established by the SST sequence/stability
+ * machinery above RDMC, exactly as with the scheduled algorithms: num_received
+ * only advances when the completion callback fires for a fully reassembled
+ * message.
+ *
+ * Requires a provider with FI_EP_DGRAM + FI_MULTICAST support and a configured
+ * multicast address (RDMA/ud_mcast_addr); supported() reports availability so
+ * create_group can fall back to a scheduled algorithm.
+ */
+class ud_multicast_group : public group {
+    /** On-the-wire header prepended to every datagram. */
+    struct __attribute__((__packed__)) frag_header {
+        uint16_t group_number;
+        uint16_t flags;  // FRAG_DATA, FRAG_NACK, or FRAG_ANNOUNCE
+        uint32_t frag_index;
+        uint32_t frag_count;
+        uint32_t sender_rank;
+        uint64_t message_seq;
+        uint64_t message_size;
+    };
+    static constexpr uint16_t FRAG_DATA = 0;
+    static constexpr uint16_t FRAG_NACK = 1;
+    static constexpr uint16_t FRAG_ANNOUNCE = 2;
+
+    /** A message the root keeps around for NACK-driven retransmission. */
+    struct outgoing_message {
+        std::shared_ptr<rdma::memory_region> mr;
+        size_t offset;
+        size_t size;
+    };
+
+    /** Reassembly state for the message currently being received. */
+    struct incoming_message {
+        rdmc::receive_destination dest;
+        uint64_t seq;
+        uint64_t size;
+        uint32_t frag_count;
+        uint32_t frags_received;
+        std::vector<bool> received;
+        std::chrono::steady_clock::time_point last_progress;
+    };
+
+    // payload bytes per datagram, set from the provider's datagram MTU
+    size_t frag_payload_size;
+
+    // libfabric datagram fabric objects, separate from the connected-endpoint
+    // context the scheduled algorithms use
+    struct fi_info* dgram_fi = nullptr;
+    struct fid_fabric* fabric = nullptr;
+    struct fid_domain* domain = nullptr;
+    struct fid_ep* dgram_ep = nullptr;
+    struct fid_av* av = nullptr;
+    struct fid_cq* cq = nullptr;
+    struct fid_eq* eq = nullptr;
+    struct fid_mc* mc = nullptr;
+    fi_addr_t mc_addr = FI_ADDR_UNSPEC;
+    // unicast datagram addresses of all members, for NACKs to the root
+    std::vector<fi_addr_t> member_addrs;
+
+    // registered staging ring for sends and ring of posted receive buffers
+    std::unique_ptr<char[]> send_buffer;
+    std::unique_ptr<char[]> recv_buffer;
+    struct fid_mr* send_mr = nullptr;
+    struct fid_mr* recv_mr = nullptr;
+    size_t num_recv_buffers;
+    size_t next_send_slot = 0;
+
+    // sender: recent messages kept for retransmission, keyed by sequence
+    // number. The upper layer's send window bounds how far back a NACK can
+    // reasonably reach, so only a few are retained.
+    std::map<uint64_t, outgoing_message> retransmit_window;
+    uint64_t next_send_seq = 0;
+    std::chrono::steady_clock::time_point last_announce_time;
+
+    // receiver: the message being reassembled, the highest completed and
+    // highest announced sequence numbers, and a NACK rate limiter
+    std::unique_ptr<incoming_message> current_incoming;
+    uint64_t last_completed_seq = 0;
+    uint64_t highest_announced_seq = 0;
+    std::chrono::steady_clock::time_point last_nack_time;
+
+    std::atomic<bool> shutdown_poll_thread{false};
+    std::thread poll_thread;
+
+    void post_initial_recvs();
+    void repost_recv(size_t buffer_index);
+    void send_fragment(uint64_t seq, uint32_t frag_index, const outgoing_message& msg);
+    void send_announce();
+    void send_nacks();
+    // completed messages are collected and upcalled after the monitor is
+    // released, so the completion callback can take the caller's locks
+    void handle_datagram(char* data, size_t len, size_t buffer_index,
+                         std::vector<std::pair<char*, size_t>>& completed);
+    void poll_loop();
+
+public:
+    /** Whether the provider and configuration support UD multicast. */
+    static bool supported();
+
+    ud_multicast_group(uint16_t group_number, size_t block_size,
+                       std::vector<uint32_t> members, uint32_t member_index,
+                       rdmc::incoming_message_callback_t upcall,
+                       rdmc::completion_callback_t callback);
+    virtual ~ud_multicast_group();
+
+    // The scheduled-transfer entry points are never invoked for this backend;
+    // all traffic flows through the datagram endpoint's completion queue.
+    virtual void receive_block(uint32_t, size_t) {}
+    virtual void receive_ready_for_block(uint32_t, uint32_t) {}
+    virtual void complete_block_send() {}
+
+    virtual void send_message(std::shared_ptr<rdma::memory_region> message_mr,
+                              size_t offset, size_t length);
+};
+
+#endif /* !USE_VERBS_API */
+#endif /* UD_MULTICAST_HPP */
@@ -31,6 +31,21 @@ class qp_creation_failure : public creation_failure {};
 class message_types_exhausted : public exception {};
 class unsupported_feature : public exception {};
 
+/**
+ * Describes the kind of memory a buffer to be registered lives in, so that
+ * a memory_region can wrap device memory (GPUDirect RDMA) as well as
+ * ordinary host memory.
+ */
+struct memory_attribute {
+    enum class memory_type { host,
+                             cuda };
+    memory_type type;
+    /** CUDA device ordinal that owns the buffer; only meaningful for cuda. */
+    int device_id;
+    static memory_attribute host() { return {memory_type::host, 0}; }
+    static memory_attribute cuda(int device_id) { return {memory_type::cuda, device_id}; }
+};
+
 /**
  * A C++ wrapper for the IB Verbs ibv_mr struct. Registers a memory region for
  * the provided buffer on construction, and deregisters it on destruction.
@@ -48,6 +63,15 @@ class memory_region {
 public:
     memory_region(size_t size);
     memory_region(char* buffer, size_t size);
+    /**
+     * Registers a memory region over a buffer that may live in device
+     * memory. With Verbs, a CUDA device pointer registers directly through
+     * ibv_reg_mr when the GPUDirect RDMA kernel module (nvidia-peermem) is
+     * loaded, so RDMC block transfers move device-to-device without staging
+     * through host memory; registration fails with mr_creation_failure when
+     * it is not.
+     */
+    memory_region(char* buffer, size_t size, const memory_attribute& attr);
     uint32_t get_rkey() const;
 
     char* const buffer;
@@ -10,6 +10,7 @@
     #include "detail/lf_helper.hpp"
 #endif
 
+#include <deque>
 #include <optional>
 #include <map>
 #include <memory>
@@ -19,6 +20,7 @@
 
 using rdmc::completion_callback_t;
 using rdmc::incoming_message_callback_t;
+using rdmc::progress_callback_t;
 using std::map;
 using std::unique_ptr;
 using std::vector;
@@ -27,12 +29,15 @@ using std::optional;
 class group {
 protected:
     const vector<uint32_t> members;  // first element is the sender
-    const uint16_t group_number;
+    /** Non-const so an idle group can be re-keyed by migrate(). */
+    uint16_t group_number;
     const size_t block_size;
     const uint32_t num_members;
     const uint32_t member_index;  // our index in the members list
 
-    const unique_ptr<schedule> transfer_schedule;
+    /** Immutable and potentially shared between groups with the same
+     * (algorithm, size, rank) shape; see the schedule cache in rdmc.cpp. */
+    const std::shared_ptr<const schedule> transfer_schedule;
 
     std::mutex monitor;
 
@@ -48,11 +53,27 @@ protected:
           vector<uint32_t> members, uint32_t member_index,
           incoming_message_callback_t upcall,
           completion_callback_t callback,
-          unique_ptr<schedule> transfer_schedule);
+          std::shared_ptr<const schedule> transfer_schedule);
 
 public:
     virtual ~group();
 
+    /**
+     * Re-keys this group under a new group number and replaces its upcalls,
+     * so an established group (with its endpoints and posted receives) can
+     * survive a view change whose membership leaves it untouched. Returns
+     * false if the requested membership or block size differ from this
+     * group's, or if a message is in flight; the caller then falls back to
+     * destroying the group and creating a fresh one. The base implementation
+     * always refuses; only polling_group supports migration.
+     */
+    virtual bool migrate(uint16_t new_group_number,
+                         const vector<uint32_t>& new_members, size_t new_block_size,
+                         incoming_message_callback_t upcall,
+                         completion_callback_t callback) {
+        return false;
+    }
+
     virtual void receive_block(uint32_t send_imm, size_t size) = 0;
     virtual void receive_ready_for_block(uint32_t step, uint32_t sender) = 0;
     virtual void complete_block_send() = 0;
@@ -83,6 +104,28 @@ private:
     size_t receive_step = 0;
     vector<bool> received_blocks;
 
+    /** Streaming delivery: invoked (under the monitor) whenever the
+     * contiguous received prefix of the incoming message grows. Null when
+     * the group was created without one. */
+    const progress_callback_t progress_callback;
+    /** Number of leading blocks of the current incoming message that have
+     * all arrived; only maintained when progress_callback is set. */
+    size_t contiguous_blocks = 0;
+
+    /** A send accepted while a previous message is still in flight */
+    struct queued_message {
+        std::shared_ptr<rdma::memory_region> mr;
+        size_t offset;
+        size_t length;
+    };
+    /** Messages the root has queued behind the in-flight one. When the
+     * current message completes, the next queued one starts immediately
+     * (from the completion handler), so the wire never idles between
+     * message boundaries. Bounded by RDMA/rdmc_send_queue_depth; a depth
+     * of 0 restores the strict group_busy behavior. */
+    std::deque<queued_message> queued_sends;
+    const size_t max_queued_sends;
+
     // maps from member_indices to the queue pairs
 #ifdef USE_VERBS_API
     map<size_t, rdma::queue_pair> queue_pairs;
@@ -99,11 +142,17 @@ private:
 public:
     static void initialize_message_types();
 
+    virtual bool migrate(uint16_t new_group_number,
+                         const vector<uint32_t>& new_members, size_t new_block_size,
+                         incoming_message_callback_t upcall,
+                         completion_callback_t callback);
+
     polling_group(uint16_t group_number, size_t block_size,
                   vector<uint32_t> members, uint32_t member_index,
                   incoming_message_callback_t upcall,
                   completion_callback_t callback,
-                  unique_ptr<schedule> transfer_schedule);
+                  std::shared_ptr<const schedule> transfer_schedule,
+                  progress_callback_t progress_callback = nullptr);
 
     virtual void receive_block(uint32_t send_imm, size_t size);
     virtual void receive_ready_for_block(uint32_t step, uint32_t sender);
@@ -114,7 +163,10 @@ public:
 
 private:
     void post_recv(schedule::block_transfer transfer);
+    void begin_send(std::shared_ptr<rdma::memory_region> message_mr,
+                    size_t offset, size_t length);
     void send_next_block();
+    void update_streaming_prefix();
     void complete_message();
     void prepare_for_next_message();
     void send_ready_for_block(uint32_t neighbor);
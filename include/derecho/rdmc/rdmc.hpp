@@ -29,7 +29,11 @@ enum send_algorithm {
     BINOMIAL_SEND = 1,
     CHAIN_SEND = 2,
     SEQUENTIAL_SEND = 3,
-    TREE_SEND = 4
+    TREE_SEND = 4,
+    /** Hardware (unreliable-datagram) multicast dissemination with
+     * NACK-driven retransmission; falls back to BINOMIAL_SEND when the
+     * provider or configuration does not support it. */
+    UD_MULTICAST_SEND = 5
 };
 
 struct receive_destination {
@@ -40,6 +44,17 @@ struct receive_destination {
 typedef std::function<receive_destination(size_t size)>
         incoming_message_callback_t;
 typedef std::function<void(char* buffer, size_t size)> completion_callback_t;
+/**
+ * Optional streaming-receive callback. When one is supplied to create_group,
+ * receivers invoke it each time the contiguous prefix of the incoming
+ * message grows, with the message's base address and the number of prefix
+ * bytes now complete, so huge messages can be checksummed/applied/
+ * decompressed in a pipeline with the network instead of only after the
+ * completion callback. It is called with the group's monitor held, so it
+ * must be short and must not call back into RDMC. The final prefix (the
+ * whole message) is reported by the completion callback, not this one.
+ */
+typedef std::function<void(char* buffer, size_t bytes_received)> progress_callback_t;
 typedef std::function<void(std::optional<uint32_t> suspected_victim)>
         failure_callback_t;
 
@@ -63,16 +78,37 @@ void shutdown();
  * message in this group
  * @param failure_callback The function to call when RDMC detects a failure in
  * this group. It will be called with the suspected failed node's ID.
+ * @param progress_callback Optional; when non-null, receivers call it as the
+ * contiguous prefix of an incoming message grows (see progress_callback_t).
+ * Only supported by the schedule-driven algorithms, not UD_MULTICAST_SEND.
  * @return True if group creation succeeds, false if it fails.
  */
 bool create_group(uint16_t group_number, std::vector<uint32_t> members,
                   size_t block_size, send_algorithm algorithm,
                   incoming_message_callback_t incoming_receive,
                   completion_callback_t send_callback,
-                  failure_callback_t failure_callback)
+                  failure_callback_t failure_callback,
+                  progress_callback_t progress_callback = nullptr)
         __attribute__((warn_unused_result));
 void destroy_group(uint16_t group_number);
 
+/**
+ * Attempts to re-key an existing, idle group under a new group number with
+ * new upcalls, keeping its established connections and receive state. This
+ * lets a view change preserve the groups of shards whose membership did not
+ * change, instead of tearing them down and rebuilding them. All members of
+ * the group must migrate it to the same new number. Fails (returning false,
+ * with the old group left usable under its old number) if no group with
+ * old_group_number exists, new_group_number is already taken, the given
+ * members or block size differ from the existing group's, or a message is in
+ * flight; the caller should then fall back to create_group.
+ */
+bool migrate_group(uint16_t old_group_number, uint16_t new_group_number,
+                   const std::vector<uint32_t>& members, size_t block_size,
+                   incoming_message_callback_t incoming_receive,
+                   completion_callback_t send_callback)
+        __attribute__((warn_unused_result));
+
 bool send(uint16_t group_number, std::shared_ptr<rdma::memory_region> mr,
           size_t offset, size_t length) __attribute__((warn_unused_result));
 
@@ -7,14 +7,18 @@
  * including the Resources class and global setup functions.
  */
 
+#include <atomic>
+#include <functional>
 #include <iostream>
 #include <map>
 #include <rdma/fabric.h>
 #include <rdma/fi_errno.h>
+#include <string>
 #include <thread>
 
 #include <derecho/core/derecho_type_definitions.hpp>
 #include <derecho/utils/logger.hpp>
+#include <derecho/utils/pinned_memory_budget.hpp>
 
 #ifndef LF_VERSION
 #define LF_VERSION FI_VERSION(1, 5)
@@ -25,6 +29,10 @@ namespace sst {
 struct lf_sender_ctxt {
     uint32_t ce_idx;     // index into the comepletion entry vector. - 0xFFFFFFFF for invalid
     uint32_t remote_id;  // thread id of the sender
+    // node id of the remote peer, so error completions can be attributed to
+    // a node even when nothing in poll_utils is waiting for them. 0xFFFFFFFF
+    // when unknown.
+    uint32_t remote_node_id = 0xFFFFFFFFu;
 };
 
 /**
@@ -33,6 +41,24 @@ struct lf_sender_ctxt {
  */
 class _resources {
 private:
+    /**
+     * Number of writes posted without a completion since the last signaled
+     * one. The endpoint is bound with FI_SELECTIVE_COMPLETION, so unsignaled
+     * writes generate no CQ entries; every Nth one still requests a flush
+     * completion (with a sentinel context the polling loop discards) so
+     * providers that only reclaim send-queue slots at signaled completions
+     * cannot run out of them.
+     */
+    std::atomic<uint32_t> unsignaled_sends{0};
+
+    /**
+     * Context attached to unsignaled writes (including the periodic flush
+     * completions). Its invalid ce_idx makes the polling loop discard the
+     * successful completions, but its remote_node_id lets error completions
+     * be attributed to this connection's peer.
+     */
+    lf_sender_ctxt unsignaled_sender_ctxt;
+
     /** Connect the queue pair
      * 
      * @param is_lf_server This parameter decide local role in connection.
@@ -56,10 +82,31 @@ protected:
      * @param offset - The offset within the remote buffer to read/write
      * @param size - The number of bytes to read/write
      * @param op - 0 for read and 1 for write
+     * @param completion - whether to request a completion entry for this post
+     * @param nonblocking - if true, a full transmit queue makes the post
+     *     return -FI_EAGAIN immediately instead of retrying until space opens
      * @param return the return code for operation.
      */
     int post_remote_send(struct lf_sender_ctxt* ctxt, const long long int offset, const long long int size,
-                         const int op, const bool completion);
+                         const int op, const bool completion, const bool nonblocking = false);
+
+    /**
+     * post a gather write of several discontiguous buffer segments as a
+     * single RDMA operation. Each segment is copied from the local buffer at
+     * its offset to the same offset in the remote buffer. Falls back to one
+     * write per segment if the provider's iov limits are too small.
+     *
+     * @param ctxt - pointer to the sender context, caller should maintain the
+     *     ownership of this context until completion.
+     * @param offsets - array of segment offsets into the local/remote buffer
+     * @param sizes - array of segment lengths, parallel to offsets
+     * @param seg_count - The number of segments
+     * @param completion - whether to generate a local completion entry
+     * @return the return code for the operation.
+     */
+    int post_remote_send_gather(struct lf_sender_ctxt* ctxt, const long long int* offsets,
+                                const long long int* sizes, const int seg_count,
+                                const bool completion);
 
 public:
     /** ID of the remote node. */
@@ -86,6 +133,10 @@ public:
     fi_addr_t remote_fi_addr;
     /** the event queue */
     struct fid_eq* eq;
+    /** pinned-memory account the registered buffers are charged to */
+    std::string memory_account;
+    /** total bytes registered by this connection, released in the destructor */
+    size_t registered_bytes;
 
     /**
      * Constructor
@@ -101,12 +152,15 @@ public:
      * @param size_w The size of the write buffer (in bytes).
      * @param size_r The size of the read buffer (in bytes).
      * @param is_lf_server Is local node a libfabric server or client. A libfabric
-     *         client initiates connection to the passive endpoint of the remote 
+     *         client initiates connection to the passive endpoint of the remote
      *         node, while a libfabric server waiting for the conneciton using its
      *         local passive endpoint.
+     * @param memory_account Name of the pinned-memory account the registered
+     *         buffers are charged to (see derecho/utils/pinned_memory_budget.hpp).
      */
     _resources(int r_id, char* write_addr, char* read_addr, int size_w,
-               int size_r, int is_lf_server);
+               int size_r, int is_lf_server,
+               const std::string& memory_account = derecho::pinned_memory::sst_account);
     /** Destroys the resources. */
     virtual ~_resources();
 };
@@ -119,7 +173,9 @@ class resources : public _resources {
 public:
     /** Constructor: simply forwards to _resources::_resources */
     resources(int r_id, char* write_addr, char* read_addr, int size_w,
-              int size_r, int is_lf_server) : _resources(r_id, write_addr, read_addr, size_w, size_r, is_lf_server) {
+              int size_r, int is_lf_server,
+              const std::string& memory_account = derecho::pinned_memory::sst_account)
+            : _resources(r_id, write_addr, read_addr, size_w, size_r, is_lf_server, memory_account) {
     }
 
     /*
@@ -131,10 +187,22 @@ public:
     void post_remote_read(const long long int size);
     /** Post an RDMA read at an offset into remote memory. */
     void post_remote_read(const long long int offset, const long long int size);
+    /** Post an RDMA read at an offset into remote memory, generating a
+     * completion entry when the data has fully landed in the read buffer. */
+    void post_remote_read_with_completion(struct lf_sender_ctxt* ctxt, const long long int offset, const long long int size);
     /** Post an RDMA write at the beginning address of remote memory. */
     void post_remote_write(const long long int size);
     /** Post an RDMA write at an offset into remote memory. */
     void post_remote_write(const long long int offset, long long int size);
+    /** Post an RDMA write at an offset into remote memory without blocking:
+     * if the transmit queue is full, returns false instead of spinning until
+     * space opens up, so the caller can apply backpressure. Other posting
+     * failures are reported and swallowed, exactly like post_remote_write. */
+    bool try_post_remote_write(const long long int offset, const long long int size);
+    /** Post a single gather RDMA write covering several discontiguous
+     * (offset, size) segments of the write buffer. */
+    void post_remote_write_gather(const long long int* offsets, const long long int* sizes,
+                                  const int seg_count);
     void post_remote_write_with_completion(struct lf_sender_ctxt* ctxt, const long long int size);
     /** Post an RDMA write at an offset into remote memory. */
     void post_remote_write_with_completion(struct lf_sender_ctxt* ctxt, const long long int offset, const long long int size);
@@ -150,7 +218,9 @@ class resources_two_sided : public _resources {
 public:
     /** constructor: simply forwards to _resources::_resources */
     resources_two_sided(int r_id, char* write_addr, char* read_addr, int size_w,
-                        int size_r, int is_lf_server) : _resources(r_id, write_addr, read_addr, size_w, size_r, is_lf_server) {
+                        int size_r, int is_lf_server,
+                        const std::string& memory_account = derecho::pinned_memory::sst_account)
+            : _resources(r_id, write_addr, read_addr, size_w, size_r, is_lf_server, memory_account) {
     }
 
     void post_two_sided_send(const long long int size);
@@ -163,6 +233,16 @@ public:
     void post_two_sided_receive(struct lf_sender_ctxt* ctxt, const long long int offset, const long long int size);
 };
 
+/**
+ * Registers a callback that is invoked whenever the transport observes hard
+ * evidence that a remote node has failed: an error completion on an RDMA
+ * operation to it, or a reset on the TCP connection to it. This turns hard
+ * crashes into immediate failure suspicions instead of waiting out the
+ * heartbeat timeout. The callback may run on the completion engine's polling
+ * thread, so it must not block or post RDMA operations; it should only
+ * record the evidence for another thread to act on.
+ */
+void set_node_failure_callback(const std::function<void(uint32_t node_id)>& callback);
 /**
  * Adds a new node to the SST TPC connections set.
  */
@@ -186,9 +266,7 @@ bool sync(uint32_t r_id);
  */
 void lf_initialize(const std::map<uint32_t, std::pair<ip_addr_t, uint16_t>>& ip_addrs_and_ports,
                    uint32_t node_id);
-/** Polls for completion of a single posted remote write. */
-std::pair<uint32_t, std::pair<int32_t, int32_t>> lf_poll_completion();
-/** Shutdown the polling thread. */
+/** Deregisters the SST completion queue from the shared completion engine. */
 void shutdown_polling_thread();
 /** Destroys the global libfabric resources. */
 void lf_destroy();
@@ -240,6 +318,32 @@ inline int64_t fail_if_nonzero_retry_on_eagain(const std::string& description, c
     return return_code;
 }
 
+/**
+ * Like fail_if_nonzero_retry_on_eagain, but surfaces -FI_EAGAIN to the
+ * caller instead of spinning: used by the non-blocking post paths so that a
+ * full transmit queue becomes backpressure rather than a stall. EAGAIN is
+ * returned silently; any other nonzero return is reported (and crashes the
+ * program if failure_mode is CRASH_ON_FAILURE), just like the retrying
+ * version.
+ */
+template<typename FuncType, typename... ArgTypes>
+inline int64_t fail_if_nonzero_return_on_eagain(const std::string& description, const NextOnFailure& failure_mode,
+                                                FuncType lf_function, ArgTypes&&... lf_args) {
+    int64_t return_code = (*lf_function)(std::forward<ArgTypes>(lf_args)...);
+    if(return_code == -FI_EAGAIN) {
+        return return_code;
+    }
+    if(return_code != 0) {
+        dbg_default_error("LibFabric error! Return code = {}. Operation description: {}", return_code, description);
+        std::cerr << "LibFabric error! Ret=" << return_code << ", desc=" << description << std::endl;
+        if(failure_mode == CRASH_ON_FAILURE) {
+            dbg_default_flush();
+            exit(-1);
+        }
+    }
+    return return_code;
+}
+
 /**
  * Calls a C function that may return either a pointer or NULL, forwarding
  * all of its arguments by copy (because C functions don't understand
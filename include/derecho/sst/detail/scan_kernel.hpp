@@ -0,0 +1,72 @@
+/**
+ * @file scan_kernel.hpp
+ *
+ * Cache-tuning primitives for the receive-side slot scans. The receiver
+ * predicates walk one sequence word per sender row every poll cycle; at
+ * large window-size x member-count products each probe is a cache miss on
+ * a line that an RDMA write may have just invalidated. The helpers here
+ * let the scan loops (a) issue a software prefetch for the next row's
+ * sequence word while the current row's compare is in flight, and (b)
+ * copy payloads out of the slot region with non-temporal loads, so an
+ * 8KB copy-out does not evict the predicate thread's working set.
+ */
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+
+#if defined(__SSE4_1__)
+#include <smmintrin.h>
+#endif
+
+namespace sst {
+
+/**
+ * Hints the CPU to pull the cache line containing addr into the cache
+ * for a read. Used by the slot-scan loops to overlap the next probe's
+ * memory latency with the current probe's compare; a wrong or useless
+ * prefetch costs nothing but the issue slot.
+ */
+inline void prefetch_for_read(const volatile void* addr) {
+#if defined(__GNUC__) || defined(__clang__)
+    __builtin_prefetch(const_cast<const void*>(addr), 0 /*read*/, 3 /*high locality*/);
+#else
+    (void)addr;
+#endif
+}
+
+/**
+ * Copies size bytes from a slot region into a local buffer, using
+ * non-temporal (streaming) loads when the platform supports them. Slot
+ * payloads are read exactly once on their way into a reassembly or
+ * delivery buffer, so letting them flow through the cache hierarchy only
+ * evicts the sequence words and counters the scan loops keep hot. On
+ * platforms without SSE4.1, or when the source is not 16-byte aligned,
+ * this is a plain memcpy.
+ */
+inline void stream_copy(char* dst, const volatile char* src, std::size_t size) {
+#if defined(__SSE4_1__)
+    const char* src_flat = const_cast<const char*>(src);
+    if(reinterpret_cast<uintptr_t>(src_flat) % 16 == 0) {
+        std::size_t offset = 0;
+        for(; offset + 16 <= size; offset += 16) {
+            // stream loads are an architectural no-op on write-back memory
+            // on some parts, but honor the non-temporal hint on others and
+            // on write-combining (RDMA-registered) mappings; either way the
+            // copy is never slower than the memcpy fallback
+            const __m128i chunk = _mm_stream_load_si128(
+                    reinterpret_cast<__m128i*>(const_cast<char*>(src_flat + offset)));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + offset), chunk);
+        }
+        if(offset < size) {
+            memcpy(dst + offset, src_flat + offset, size - offset);
+        }
+        return;
+    }
+    memcpy(dst, src_flat, size);
+#else
+    memcpy(dst, const_cast<const char*>(src), size);
+#endif
+}
+
+}  // namespace sst
@@ -6,8 +6,10 @@
 
 #pragma once
 
+#include <algorithm>
 #include <chrono>
 #include <condition_variable>
+#include <cstring>
 #include <memory>
 #include <mutex>
 #include <pthread.h>
@@ -19,6 +21,8 @@
 #include "poll_utils.hpp"
 #include "../predicates.hpp"
 #include "../sst.hpp"
+#include <derecho/utils/perf_events.hpp>
+#include <derecho/utils/phase_occupancy.hpp>
 
 namespace sst {
 
@@ -28,14 +32,28 @@ namespace sst {
  */
 template <typename DerivedSST>
 SST<DerivedSST>::~SST() {
+    // drain the trigger offload executor first, while queued triggers can
+    // still run safely against this SST
+    predicates.stop_trigger_executor();
     thread_shutdown = true;
+    for(auto& push_thread : push_threads) {
+        push_thread->queue_cv.notify_all();
+    }
+    for(auto& push_thread : push_threads) {
+        if(push_thread->thread.joinable()) push_thread->thread.join();
+    }
     for(auto& thread : background_threads) {
         if(thread.joinable()) thread.join();
     }
 
     if(rows != nullptr) {
-        delete[](const_cast<char*>(rows));
+        if(rows_hugepage_backed) {
+            derecho::hugepage_free(const_cast<char*>(rows), tableLen);
+        } else {
+            ::operator delete[](const_cast<char*>(rows), std::align_val_t(CACHE_LINE_SIZE));
+        }
     }
+    delete[] last_pushed;
 }
 
 /**
@@ -58,72 +76,207 @@ void SST<DerivedSST>::start_predicate_evaluation() {
  * row's observed values of those functions.
  */
 template <typename DerivedSST>
-void SST<DerivedSST>::detect() {
+void SST<DerivedSST>::detect(uint32_t shard_index) {
     pthread_setname_np(pthread_self(), "sst_detect");
+    // with multiple shards, spread the threads over consecutive CPUs
+    const int32_t pin_cpu = derecho::getConfInt32(CONF_DERECHO_PREDICATE_THREAD_CPU);
+    derecho::pin_to_cpu(pin_cpu < 0 ? pin_cpu : pin_cpu + shard_index);
+    typename Predicates<DerivedSST>::shard_t& pred_shard = *predicates.shards[shard_index];
     if(!thread_start) {
         std::unique_lock<std::mutex> lock(thread_start_mutex);
         thread_start_cv.wait(lock, [this]() { return thread_start; });
     }
     struct timespec last_time, cur_time;
     clock_gettime(CLOCK_REALTIME, &last_time);
+    // Occupancy accounting: evaluation rounds are EVALUATING, trigger bodies
+    // WORKING, and the backoff/sleep paths IDLE
+    PhaseOccupancy::ThreadSlot& occupancy = PhaseOccupancy::registerThread(
+            "sst_detect" + std::to_string(shard_index));
+    // Number of consecutive evaluation rounds in which no predicate fired,
+    // used to drive the adaptive backoff ladder when sst_idle_backoff is set
+    uint64_t empty_rounds = 0;
+    // BACKGROUND predicates only get evaluated once every this many rounds
+    uint32_t background_interval = derecho::getConfSnapshot().background_predicate_interval;
+    if(background_interval == 0) {
+        background_interval = 1;
+    }
+    uint64_t round_number = 0;
 
     while(!thread_shutdown) {
         bool predicate_fired = false;
+        const bool evaluate_background = (round_number % background_interval == 0);
+        // Sampled once per round; stats updates happen under the predicate
+        // lock, so they never race with get_statistics()
+        const bool collect_stats = predicates.statistics_enabled();
+        auto record_evaluation = [collect_stats](typename Predicates<DerivedSST>::pred_entry& entry,
+                                                 uint64_t eval_start, bool fired) {
+            if(!collect_stats) return;
+            const uint64_t eval_ticks = predicate_clock() - eval_start;
+            entry.stats.evaluations++;
+            entry.stats.total_evaluation_ticks += eval_ticks;
+            if(eval_ticks > entry.stats.max_evaluation_ticks) {
+                entry.stats.max_evaluation_ticks = eval_ticks;
+            }
+            if(fired) {
+                entry.stats.fires++;
+            }
+        };
+        auto record_trigger = [collect_stats](typename Predicates<DerivedSST>::pred_entry& entry,
+                                              uint64_t trigger_start) {
+            if(!collect_stats) return;
+            const uint64_t trigger_ticks = predicate_clock() - trigger_start;
+            entry.stats.total_trigger_ticks += trigger_ticks;
+            if(trigger_ticks > entry.stats.max_trigger_ticks) {
+                entry.stats.max_trigger_ticks = trigger_ticks;
+            }
+        };
+        ++round_number;
+        occupancy.enter(PhaseOccupancy::EVALUATING);
+        // Hardware-counter attribution for one evaluation round (a branch
+        // when collection is disabled; a counter read when it's on)
+        PerfEventCounters::begin(PerfEventCounters::PREDICATE_ITERATION);
         // Take the predicate lock before reading the predicate lists
-        std::unique_lock<std::mutex> predicates_lock(predicates.predicate_mutex);
-
-        // one time predicates need to be evaluated only until they become true
-        for(auto& pred : predicates.one_time_predicates) {
-            if(pred != nullptr && (pred->first(*derived_this) == true)) {
-                predicate_fired = true;
-                // Copy the trigger pointer locally, so it can continue running without
-                // segfaulting even if this predicate gets deleted when we unlock predicates_lock
-                std::shared_ptr<typename Predicates<DerivedSST>::trig> trigger(pred->second);
-                predicates_lock.unlock();
-                (*trigger)(*derived_this);
-                predicates_lock.lock();
-                // erase the predicate as it was just found to be true
-                pred.reset();
+        std::unique_lock<std::mutex> predicates_lock(pred_shard.predicate_mutex);
+
+        // Evaluate in priority order: latency-critical predicates first, then
+        // normal ones, and background ones only on every Nth round, so a burst
+        // of housekeeping work can't delay delivery or stability detection.
+        const PredicatePriority pass_priorities[] = {PredicatePriority::LATENCY_CRITICAL,
+                                                     PredicatePriority::NORMAL,
+                                                     PredicatePriority::BACKGROUND};
+        for(const PredicatePriority pass_priority : pass_priorities) {
+            if(pass_priority == PredicatePriority::BACKGROUND && !evaluate_background) {
+                continue;
             }
-        }
 
-        // recurrent predicates are evaluated each time they are found to be true
-        for(auto& pred : predicates.recurrent_predicates) {
-            if(pred != nullptr && (pred->first(*derived_this) == true)) {
-                predicate_fired = true;
-                std::shared_ptr<typename Predicates<DerivedSST>::trig> trigger(pred->second);
-                predicates_lock.unlock();
-                (*trigger)(*derived_this);
-                predicates_lock.lock();
+            // one time predicates need to be evaluated only until they become true
+            for(auto& pred : pred_shard.one_time_predicates) {
+                if(pred != nullptr && pred->priority == pass_priority) {
+                    const uint64_t eval_start = collect_stats ? predicate_clock() : 0;
+                    const bool fired = pred->predicate(*derived_this);
+                    record_evaluation(*pred, eval_start, fired);
+                    if(fired) {
+                        predicate_fired = true;
+                        // Copy the trigger pointer locally, so it can continue running without
+                        // segfaulting even if this predicate gets deleted when we unlock predicates_lock
+                        std::shared_ptr<typename Predicates<DerivedSST>::trig> trigger(pred->trigger);
+                        if(pred->offload_key >= 0 && predicates.offload_enabled()) {
+                            // hand the trigger to its offload lane and keep
+                            // evaluating; same-key triggers stay ordered
+                            predicates.offload_trigger(pred->offload_key, std::move(trigger), derived_this);
+                        } else {
+                            const uint64_t trigger_start = collect_stats ? predicate_clock() : 0;
+                            predicates_lock.unlock();
+                            occupancy.enter(PhaseOccupancy::WORKING);
+                            (*trigger)(*derived_this);
+                            occupancy.enter(PhaseOccupancy::EVALUATING);
+                            predicates_lock.lock();
+                            if(pred != nullptr) {
+                                record_trigger(*pred, trigger_start);
+                            }
+                        }
+                        // erase the predicate as it was just found to be true
+                        pred.reset();
+                    }
+                }
             }
-        }
 
-        // transition predicates are only evaluated when they change from false to true
-        // We need to use iterators here because we need to iterate over two lists in parallel
-        auto pred_it = predicates.transition_predicates.begin();
-        auto pred_state_it = predicates.transition_predicate_states.begin();
-        while(pred_it != predicates.transition_predicates.end()) {
-            if(*pred_it != nullptr) {
-                //*pred_state_it is the previous state of the predicate at *pred_it
-                bool curr_pred_state = (*pred_it)->first(*derived_this);
-                if(curr_pred_state == true && *pred_state_it == false) {
-                    predicate_fired = true;
-                    std::shared_ptr<typename Predicates<DerivedSST>::trig> trigger(
-                            (*pred_it)->second);
-                    predicates_lock.unlock();
-                    (*trigger)(*derived_this);
-                    predicates_lock.lock();
+            // recurrent predicates are evaluated each time they are found to be true
+            for(auto& pred : pred_shard.recurrent_predicates) {
+                if(pred != nullptr && pred->priority == pass_priority) {
+                    const uint64_t eval_start = collect_stats ? predicate_clock() : 0;
+                    const bool fired = pred->predicate(*derived_this);
+                    record_evaluation(*pred, eval_start, fired);
+                    if(fired) {
+                        predicate_fired = true;
+                        std::shared_ptr<typename Predicates<DerivedSST>::trig> trigger(pred->trigger);
+                        if(pred->offload_key >= 0 && predicates.offload_enabled()) {
+                            predicates.offload_trigger(pred->offload_key, std::move(trigger), derived_this);
+                        } else {
+                            const uint64_t trigger_start = collect_stats ? predicate_clock() : 0;
+                            predicates_lock.unlock();
+                            occupancy.enter(PhaseOccupancy::WORKING);
+                            (*trigger)(*derived_this);
+                            occupancy.enter(PhaseOccupancy::EVALUATING);
+                            predicates_lock.lock();
+                            // the predicate may have been removed while unlocked
+                            if(pred != nullptr) {
+                                record_trigger(*pred, trigger_start);
+                            }
+                        }
+                    }
                 }
-                *pred_state_it = curr_pred_state;
+            }
+
+            // transition predicates are only evaluated when they change from false to true
+            // We need to use iterators here because we need to iterate over two lists in parallel
+            auto pred_it = pred_shard.transition_predicates.begin();
+            auto pred_state_it = pred_shard.transition_predicate_states.begin();
+            while(pred_it != pred_shard.transition_predicates.end()) {
+                if(*pred_it != nullptr) {
+                    if((*pred_it)->priority != pass_priority) {
+                        ++pred_it;
+                        ++pred_state_it;
+                        continue;
+                    }
+                    //*pred_state_it is the previous state of the predicate at *pred_it
+                    const uint64_t eval_start = collect_stats ? predicate_clock() : 0;
+                    bool curr_pred_state = (*pred_it)->predicate(*derived_this);
+                    record_evaluation(**pred_it, eval_start,
+                                      curr_pred_state == true && *pred_state_it == false);
+                    if(curr_pred_state == true && *pred_state_it == false) {
+                        predicate_fired = true;
+                        std::shared_ptr<typename Predicates<DerivedSST>::trig> trigger(
+                                (*pred_it)->trigger);
+                        if((*pred_it)->offload_key >= 0 && predicates.offload_enabled()) {
+                            predicates.offload_trigger((*pred_it)->offload_key, std::move(trigger), derived_this);
+                        } else {
+                            const uint64_t trigger_start = collect_stats ? predicate_clock() : 0;
+                            predicates_lock.unlock();
+                            occupancy.enter(PhaseOccupancy::WORKING);
+                            (*trigger)(*derived_this);
+                            occupancy.enter(PhaseOccupancy::EVALUATING);
+                            predicates_lock.lock();
+                            if(*pred_it != nullptr) {
+                                record_trigger(**pred_it, trigger_start);
+                            }
+                        }
+                    }
+                    *pred_state_it = curr_pred_state;
 
-                ++pred_it;
-                ++pred_state_it;
+                    ++pred_it;
+                    ++pred_state_it;
+                }
             }
         }
+        PerfEventCounters::end(PerfEventCounters::PREDICATE_ITERATION);
 
         if(predicate_fired) {
             // update last time
             clock_gettime(CLOCK_REALTIME, &last_time);
+            empty_rounds = 0;
+        } else if(idle_backoff_enabled) {
+            ++empty_rounds;
+            // spin hot for the first idle_spin_rounds rounds, then descend a
+            // pause -> yield -> timed-sleep ladder; any predicate firing
+            // resets the ladder so bursts still get full-speed polling
+            if(empty_rounds > idle_spin_rounds) {
+                predicates_lock.unlock();
+                occupancy.enter(PhaseOccupancy::IDLE);
+                if(empty_rounds <= idle_spin_rounds * 2) {
+                    for(int i = 0; i < 64; ++i) {
+#if defined(__x86_64__) || defined(__i386__)
+                        asm volatile("pause");
+#endif
+                    }
+                } else if(empty_rounds <= idle_spin_rounds * 4) {
+                    std::this_thread::yield();
+                } else {
+                    using namespace std::chrono_literals;
+                    std::this_thread::sleep_for(1ms);
+                }
+                predicates_lock.lock();
+            }
         } else {
             clock_gettime(CLOCK_REALTIME, &cur_time);
             // check if the system has been inactive for enough time to induce sleep
@@ -131,6 +284,7 @@ void SST<DerivedSST>::detect() {
                                         + (cur_time.tv_nsec - last_time.tv_nsec) / 1e6;
             if(time_elapsed_in_ms > 1) {
                 predicates_lock.unlock();
+                occupancy.enter(PhaseOccupancy::IDLE);
                 using namespace std::chrono_literals;
                 std::this_thread::sleep_for(1ms);
                 predicates_lock.lock();
@@ -142,21 +296,293 @@ void SST<DerivedSST>::detect() {
 
 template <typename DerivedSST>
 void SST<DerivedSST>::put(const std::vector<uint32_t> receiver_ranks, size_t offset, size_t size) {
-    assert(offset + size <= rowLen);
+    if(offset + size <= rowLen) {
+        // row-relative offset into the row-major block; select the local row.
+        // Larger offsets are table-absolute addresses of column-major entries,
+        // which the caller has already resolved to the local node's slot.
+        offset += my_index * rowLen;
+    }
+    assert(offset + size <= tableLen);
+    if(put_batch.owner == this) {
+        // write combining is on: record the (already row-adjusted) range
+        // under its receiver set instead of posting it
+        for(auto& group : put_batch.groups) {
+            if(group.first == receiver_ranks) {
+                group.second.emplace_back(offset, size);
+                return;
+            }
+        }
+        put_batch.groups.emplace_back(receiver_ranks,
+                                      std::vector<std::pair<size_t, size_t>>{{offset, size}});
+        return;
+    }
+    if(dirty_tracking_enabled && receiver_ranks.size() == num_members) {
+        // This push covers every row, so the shadow copy fully represents
+        // what all receivers have already been sent: skip the push entirely
+        // if the bytes haven't changed since then, and otherwise shrink it to
+        // the window between the first and last dirty byte (so a full-row
+        // heartbeat push sends just the heartbeat counter). Pushes to a
+        // subset of rows are never skipped and never update the shadow,
+        // which keeps the check conservative.
+        const char* current = const_cast<const char*>(rows) + offset;
+        char* shadow = last_pushed + offset;
+        // the skip/shrink is only sound over shadow bytes that a push has
+        // filled: a fresh shadow may coincidentally equal the table, and
+        // skipping on that match would leave the remote copy unwritten
+        bool shadow_filled = true;
+        const size_t last_block = (offset + size - 1) / SHADOW_BLOCK_SIZE;
+        for(size_t block = offset / SHADOW_BLOCK_SIZE; block <= last_block; ++block) {
+            if(!((shadow_valid[block / 64] >> (block % 64)) & 1)) {
+                shadow_filled = false;
+                break;
+            }
+        }
+        if(shadow_filled) {
+            size_t first_dirty = 0;
+            while(first_dirty < size && current[first_dirty] == shadow[first_dirty]) {
+                ++first_dirty;
+            }
+            if(first_dirty == size) {
+                return;
+            }
+            size_t last_dirty = size - 1;
+            while(current[last_dirty] == shadow[last_dirty]) {
+                --last_dirty;
+            }
+            memcpy(shadow + first_dirty, current + first_dirty, last_dirty - first_dirty + 1);
+            offset += first_dirty;
+            size = last_dirty - first_dirty + 1;
+        } else {
+            // first push through this range: send it whole, fill its shadow,
+            // and mark the blocks it fully covers. Edge blocks it only
+            // partially covers stay unmarked until some push fills them, so
+            // their other bytes are never trusted.
+            memcpy(shadow, current, size);
+            const size_t first_full = (offset + SHADOW_BLOCK_SIZE - 1) / SHADOW_BLOCK_SIZE;
+            const size_t end_full = (offset + size) / SHADOW_BLOCK_SIZE;
+            for(size_t block = first_full; block < end_full; ++block) {
+                shadow_valid[block / 64] |= uint64_t(1) << (block % 64);
+            }
+        }
+    }
+    puts_posted.fetch_add(1, std::memory_order_relaxed);
     for(auto index : receiver_ranks) {
         // don't write to yourself or a frozen row
         if(index == my_index || row_is_frozen[index]) {
             continue;
         }
+        if(num_push_threads > 0) {
+            // fan the posting out across the push engine's workers
+            enqueue_push(index, offset, size);
+            continue;
+        }
         // perform a remote RDMA write on the owner of the row
         res_vec[index]->post_remote_write(offset, size);
     }
     return;
 }
 
+template <typename DerivedSST>
+bool SST<DerivedSST>::try_put(const std::vector<uint32_t> receiver_ranks, size_t offset, size_t size) {
+    if(offset + size <= rowLen) {
+        // same offset adjustment as put()
+        offset += my_index * rowLen;
+    }
+    assert(offset + size <= tableLen);
+    bool posted_to_all = true;
+    for(auto index : receiver_ranks) {
+        if(index == my_index || row_is_frozen[index]) {
+            continue;
+        }
+        if(num_push_threads > 0) {
+            // the workers own the queue pairs; queue the post and let them
+            // absorb any transmit-queue backpressure
+            enqueue_push(index, offset, size);
+            continue;
+        }
+        // keep trying the remaining receivers even after one reports a full
+        // queue, so backpressure from one slow connection doesn't delay the
+        // updates the others could have accepted
+        if(!res_vec[index]->try_post_remote_write(offset, size)) {
+            posted_to_all = false;
+        }
+    }
+    puts_posted.fetch_add(1, std::memory_order_relaxed);
+    return posted_to_all;
+}
+
+template <typename DerivedSST>
+void SST<DerivedSST>::enqueue_push(uint32_t receiver, size_t offset, size_t size,
+                                   std::shared_ptr<const std::vector<std::pair<size_t, size_t>>> segments) {
+    PushThread& worker = *push_threads[receiver % num_push_threads];
+    {
+        std::lock_guard<std::mutex> lock(worker.queue_mutex);
+        worker.queue.push_back({receiver, offset, size, std::move(segments)});
+    }
+    worker.queue_cv.notify_one();
+}
+
+template <typename DerivedSST>
+void SST<DerivedSST>::push_worker(uint32_t worker_index) {
+    pthread_setname_np(pthread_self(), ("sst_push" + std::to_string(worker_index)).c_str());
+    PushThread& worker = *push_threads[worker_index];
+    while(true) {
+        typename PushThread::PushTask task;
+        {
+            std::unique_lock<std::mutex> lock(worker.queue_mutex);
+            worker.queue_cv.wait(lock, [&]() { return thread_shutdown || !worker.queue.empty(); });
+            if(worker.queue.empty()) {
+                // shutdown, and everything queued has been posted
+                return;
+            }
+            task = worker.queue.front();
+            worker.queue.pop_front();
+            worker.in_flight++;
+        }
+        // a row freeze can race ahead of the queue; skip rather than post to
+        // a dead connection
+        if(!row_is_frozen[task.receiver]) {
+            if(task.segments) {
+                std::vector<long long int> offsets(task.segments->size());
+                std::vector<long long int> sizes(task.segments->size());
+                for(size_t seg = 0; seg < task.segments->size(); ++seg) {
+                    offsets[seg] = (*task.segments)[seg].first;
+                    sizes[seg] = (*task.segments)[seg].second;
+                }
+#ifdef USE_VERBS_API
+                for(size_t seg = 0; seg < offsets.size(); ++seg) {
+                    res_vec[task.receiver]->post_remote_write(offsets[seg], sizes[seg]);
+                }
+#else
+                res_vec[task.receiver]->post_remote_write_gather(offsets.data(), sizes.data(), offsets.size());
+#endif
+            } else {
+                res_vec[task.receiver]->post_remote_write(task.offset, task.size);
+            }
+        }
+        {
+            std::lock_guard<std::mutex> lock(worker.queue_mutex);
+            worker.in_flight--;
+            if(worker.queue.empty() && worker.in_flight == 0) {
+                worker.drained_cv.notify_all();
+            }
+        }
+    }
+}
+
+template <typename DerivedSST>
+void SST<DerivedSST>::flush_pushes() {
+    for(auto& worker_ptr : push_threads) {
+        PushThread& worker = *worker_ptr;
+        std::unique_lock<std::mutex> lock(worker.queue_mutex);
+        worker.drained_cv.wait(lock, [&]() { return worker.queue.empty() && worker.in_flight == 0; });
+    }
+}
+
+template <typename DerivedSST>
+void SST<DerivedSST>::begin_coalescing_puts() {
+    // if a different SST instance is already coalescing on this thread, leave
+    // its batch alone; this instance's puts will just go out immediately
+    if(put_batch.owner != nullptr) {
+        return;
+    }
+    put_batch.owner = this;
+    put_batch.groups.clear();
+}
+
+template <typename DerivedSST>
+void SST<DerivedSST>::flush_coalesced_puts() {
+    if(put_batch.owner != this) {
+        return;
+    }
+    // deactivate first, so the puts issued below post immediately
+    put_batch.owner = nullptr;
+    for(auto& group : put_batch.groups) {
+        auto& ranges = group.second;
+        std::sort(ranges.begin(), ranges.end());
+        // merge adjacent and overlapping ranges
+        std::vector<std::pair<size_t, size_t>> merged;
+        for(const auto& range : ranges) {
+            if(!merged.empty() && range.first <= merged.back().first + merged.back().second) {
+                merged.back().second = std::max(merged.back().first + merged.back().second,
+                                                range.first + range.second)
+                                       - merged.back().first;
+            } else {
+                merged.push_back(range);
+            }
+        }
+        // ranges that stayed discontiguous still share one gather write
+        if(merged.size() == 1) {
+            put(group.first, merged[0].first, merged[0].second);
+        } else {
+            put_segments(group.first, merged);
+        }
+    }
+    put_batch.groups.clear();
+}
+
+template <typename DerivedSST>
+void SST<DerivedSST>::put_segments(const std::vector<uint32_t> receiver_ranks,
+                                   const std::vector<std::pair<size_t, size_t>>& segments) {
+    std::vector<long long int> offsets(segments.size());
+    std::vector<long long int> sizes(segments.size());
+    for(size_t seg = 0; seg < segments.size(); ++seg) {
+        size_t offset = segments[seg].first;
+        const size_t size = segments[seg].second;
+        if(offset + size <= rowLen) {
+            // see put(): row-relative offsets select the local row, larger
+            // offsets are table-absolute column-major addresses
+            offset += my_index * rowLen;
+        }
+        assert(offset + size <= tableLen);
+        offsets[seg] = offset;
+        sizes[seg] = size;
+    }
+    puts_posted.fetch_add(1, std::memory_order_relaxed);
+    if(num_push_threads > 0) {
+        // one shared copy of the segment list serves every worker
+        auto shared_segments = std::make_shared<std::vector<std::pair<size_t, size_t>>>();
+        shared_segments->reserve(segments.size());
+        for(size_t seg = 0; seg < segments.size(); ++seg) {
+            shared_segments->emplace_back(offsets[seg], sizes[seg]);
+        }
+        for(auto index : receiver_ranks) {
+            if(index == my_index || row_is_frozen[index]) {
+                continue;
+            }
+            enqueue_push(index, 0, 0, shared_segments);
+        }
+        return;
+    }
+    for(auto index : receiver_ranks) {
+        // don't write to yourself or a frozen row
+        if(index == my_index || row_is_frozen[index]) {
+            continue;
+        }
+#ifdef USE_VERBS_API
+        // the verbs resources class has no gather primitive; post the
+        // segments as individual ordered writes instead
+        for(size_t seg = 0; seg < segments.size(); ++seg) {
+            res_vec[index]->post_remote_write(offsets[seg], sizes[seg]);
+        }
+#else
+        res_vec[index]->post_remote_write_gather(offsets.data(), sizes.data(), offsets.size());
+#endif
+    }
+    return;
+}
+
 template <typename DerivedSST>
 void SST<DerivedSST>::put_with_completion(const std::vector<uint32_t> receiver_ranks, size_t offset, size_t size) {
-    assert(offset + size <= rowLen);
+    // drain the push engine first, so the completion below also confirms the
+    // calling thread's earlier put() calls, as it does with inline posting
+    flush_pushes();
+    if(offset + size <= rowLen) {
+        // see put(): row-relative offsets select the local row, larger
+        // offsets are table-absolute column-major addresses
+        offset += my_index * rowLen;
+    }
+    assert(offset + size <= tableLen);
     unsigned int num_writes_posted = 0;
     std::vector<bool> posted_write_to(num_members, false);
 
@@ -178,6 +604,9 @@ void SST<DerivedSST>::put_with_completion(const std::vector<uint32_t> receiver_r
         // perform a remote RDMA write on the owner of the row
         sctxt[index].remote_id = index;
         sctxt[index].ce_idx = ce_idx;
+#ifndef USE_VERBS_API
+        sctxt[index].remote_node_id = members[index];
+#endif
         res_vec[index]->post_remote_write_with_completion(&sctxt[index], offset, size);
         posted_write_to[index] = true;
         num_writes_posted++;
@@ -243,6 +672,77 @@ void SST<DerivedSST>::put_with_completion(const std::vector<uint32_t> receiver_r
     }
 }
 
+template <typename DerivedSST>
+void SST<DerivedSST>::add_pull_mode_range(size_t offset, size_t size) {
+    assert(offset + size <= rowLen);
+    pull_mode_ranges.emplace_back(offset, size);
+    std::sort(pull_mode_ranges.begin(), pull_mode_ranges.end());
+    // recompute the complement of the pull ranges within [0, rowLen)
+    push_row_segments.clear();
+    size_t cursor = 0;
+    for(const auto& range : pull_mode_ranges) {
+        if(range.first > cursor) {
+            push_row_segments.emplace_back(cursor, range.first - cursor);
+        }
+        cursor = std::max(cursor, range.first + range.second);
+    }
+    if(cursor < rowLen) {
+        push_row_segments.emplace_back(cursor, rowLen - cursor);
+    }
+}
+
+template <typename DerivedSST>
+bool SST<DerivedSST>::pull_bytes(size_t offset, size_t size, const std::vector<uint32_t>& row_indices) {
+    assert(offset + size <= rowLen);
+    const auto tid = std::this_thread::get_id();
+    const uint32_t ce_idx = util::polling_data.get_index(tid);
+    util::polling_data.set_waiting(tid);
+#ifdef USE_VERBS_API
+    struct verbs_sender_ctxt sctxt[row_indices.size()];
+#else
+    struct lf_sender_ctxt sctxt[row_indices.size()];
+#endif
+    unsigned int num_reads_posted = 0;
+    for(size_t request = 0; request < row_indices.size(); ++request) {
+        const uint32_t index = row_indices[request];
+        // the local row is already current, and frozen rows can't be read
+        if(index == my_index || row_is_frozen[index]) {
+            continue;
+        }
+        sctxt[request].remote_id = index;
+        sctxt[request].ce_idx = ce_idx;
+#ifndef USE_VERBS_API
+        sctxt[request].remote_node_id = members[index];
+#endif
+        // every node's own row lives at the same table offset in every
+        // table, so the local and remote addresses of the read coincide
+        res_vec[index]->post_remote_read_with_completion(&sctxt[request],
+                                                         index * rowLen + offset, size);
+        num_reads_posted++;
+    }
+
+    unsigned int num_reads_completed = 0;
+    struct timeval cur_time;
+    gettimeofday(&cur_time, NULL);
+    const unsigned long start_time_msec = (cur_time.tv_sec * 1000) + (cur_time.tv_usec / 1000);
+    while(num_reads_completed < num_reads_posted) {
+        std::optional<std::pair<int32_t, int32_t>> ce = util::polling_data.get_completion_entry(tid);
+        if(ce) {
+            if(ce.value().second == 1) {
+                num_reads_completed++;
+            }
+            continue;
+        }
+        gettimeofday(&cur_time, NULL);
+        const unsigned long cur_time_msec = (cur_time.tv_sec * 1000) + (cur_time.tv_usec / 1000);
+        if((cur_time_msec - start_time_msec) >= poll_cq_timeout_ms) {
+            break;
+        }
+    }
+    util::polling_data.reset_waiting(tid);
+    return num_reads_completed == num_reads_posted;
+}
+
 template <typename DerivedSST>
 void SST<DerivedSST>::freeze(int row_index) {
     {
@@ -261,22 +761,122 @@ void SST<DerivedSST>::freeze(int row_index) {
     }
 }
 
+template <typename DerivedSST>
+bool SST<DerivedSST>::rdma_sync(uint32_t peer_index) {
+    // Bump this node's counter for the peer and push just that 8-byte entry
+    // into the peer's copy of this node's row
+    const uint64_t target = rdma_sync_slots[my_index][peer_index] + 1;
+    rdma_sync_slots[my_index][peer_index] = target;
+    const size_t offset = (rdma_sync_slots.get_base() - getBaseAddress())
+                          + my_index * rowLen + peer_index * sizeof(uint64_t);
+    if(num_push_threads > 0) {
+        // the push workers own the queue pairs; route the write through them
+        enqueue_push(peer_index, offset, sizeof(uint64_t));
+    } else {
+        res_vec[peer_index]->post_remote_write(offset, sizeof(uint64_t));
+    }
+    // Wait for the peer's mirror counter to catch up; the counters advance
+    // in lockstep, one increment per completed pairwise sync
+    while(rdma_sync_slots[peer_index][my_index] < target) {
+        if(row_is_frozen[peer_index] || thread_shutdown) {
+            return false;
+        }
+#if defined(__x86_64__) || defined(__i386__)
+        asm volatile("pause");
+#endif
+    }
+    return true;
+}
+
+template <typename DerivedSST>
+void SST<DerivedSST>::member_sync(uint32_t peer_index) const {
+    if(res_vec[peer_index]) {
+        /* The barrier communicates through the (volatile) table and doesn't
+         * logically modify the SST, but the push machinery is non-const. */
+        const_cast<SST<DerivedSST>*>(this)->rdma_sync(peer_index);
+    } else {
+        // before the queue pair exists, the TCP connection is all there is
+        sync(members[peer_index]);
+    }
+}
+
 /**
- * Exchanges a single byte of data with each member of the SST group over the
- * TCP (not RDMA) connection, in descending order of the members' node ranks.
- * This creates a synchronization barrier, since the TCP reads are blocking,
- * and should be called after SST initialization to ensure all nodes have
+ * Exchanges a pairwise sync with each member of the SST group, over the
+ * just-established RDMA resources when they exist (see rdma_sync) and the
+ * TCP connection otherwise. This creates a synchronization barrier, and
+ * should be called after SST initialization to ensure all nodes have
  * finished initializing their local SST code.
  */
 template <typename DerivedSST>
 void SST<DerivedSST>::sync_with_members() const {
-    unsigned int node_id, sst_index;
-    for(auto const& id_index : members_by_id) {
-        std::tie(node_id, sst_index) = id_index;
-        if(sst_index != my_index && !row_is_frozen[sst_index]) {
-            sync(node_id);
+    // Collect the live rows once; frozen rows are skipped exactly as the
+    // pairwise loop did.
+    std::vector<uint32_t> live_indices;
+    for(unsigned int sst_index = 0; sst_index < num_members; ++sst_index) {
+        if(!row_is_frozen[sst_index]) {
+            live_indices.push_back(sst_index);
         }
     }
+    // Below this size the flat all-pairs sync is cheap and has the longest
+    // track record; the hierarchical barrier only pays off when the O(n)
+    // exchange count starts to dominate.
+    constexpr size_t hierarchical_sync_threshold = 16;
+    const auto my_position_it = std::find(live_indices.begin(), live_indices.end(), my_index);
+    if(live_indices.size() < hierarchical_sync_threshold || my_position_it == live_indices.end()) {
+        unsigned int node_id, sst_index;
+        for(auto const& id_index : members_by_id) {
+            std::tie(node_id, sst_index) = id_index;
+            if(sst_index != my_index && !row_is_frozen[sst_index]) {
+                member_sync(sst_index);
+            }
+        }
+        return;
+    }
+    // Two-level tree barrier: the live rows are partitioned into
+    // ceil(sqrt(n)) groups; each group's first rank is its leader and the
+    // first leader is the root. The arrive phase runs leaves-to-root (a
+    // leader exchanges with every group member, then with the root) and the
+    // release phase mirrors it root-to-leaves, so every node completes only
+    // after every other node has arrived. Each sync() is a symmetric
+    // blocking TCP exchange, so one call serves as both the arrive
+    // rendezvous and the ordering edge. Per-node exchange count drops from
+    // n-1 to about 2*sqrt(n).
+    const size_t num_live = live_indices.size();
+    size_t group_size = 1;
+    while(group_size * group_size < num_live) {
+        ++group_size;
+    }
+    const size_t my_position = my_position_it - live_indices.begin();
+    const size_t my_group_start = my_position - (my_position % group_size);
+    const size_t my_group_end = std::min(my_group_start + group_size, num_live);
+    const bool is_leader = (my_position == my_group_start);
+    const bool is_root = (my_position == 0);
+    if(!is_leader) {
+        // arrive at the leader, then wait for its release
+        member_sync(live_indices[my_group_start]);
+        member_sync(live_indices[my_group_start]);
+        return;
+    }
+    // arrive phase: collect the group, then report to the root
+    for(size_t position = my_group_start + 1; position < my_group_end; ++position) {
+        member_sync(live_indices[position]);
+    }
+    if(!is_root) {
+        member_sync(live_indices[0]);
+        // release phase: wait for the root, then release the group
+        member_sync(live_indices[0]);
+    } else {
+        // the root collects every other leader, then releases them
+        for(size_t position = group_size; position < num_live; position += group_size) {
+            member_sync(live_indices[position]);
+        }
+        for(size_t position = group_size; position < num_live; position += group_size) {
+            member_sync(live_indices[position]);
+        }
+    }
+    for(size_t position = my_group_start + 1; position < my_group_end; ++position) {
+        member_sync(live_indices[position]);
+    }
 }
 
 /**
@@ -289,7 +889,7 @@ void SST<DerivedSST>::sync_with_members(std::vector<uint32_t> row_indices) const
             continue;
         }
         if(!row_is_frozen[row_index]) {
-            sync(members[row_index]);
+            member_sync(row_index);
         }
     }
 }
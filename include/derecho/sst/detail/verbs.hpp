@@ -8,9 +8,12 @@
  */
 
 #include <map>
+#include <string>
 
 #include <infiniband/verbs.h>
 
+#include <derecho/utils/pinned_memory_budget.hpp>
+
 namespace sst {
 
 /** Structure to exchange the data needed to connect the Queue Pairs */
@@ -67,11 +70,16 @@ public:
     /** Pointer to the memory buffer used for the results of RDMA remote reads.
      */
     char *read_buf;
+    /** Pinned-memory account the registered buffers are charged to. */
+    std::string memory_account;
+    /** Total bytes registered by this connection, released in the destructor. */
+    size_t registered_bytes;
 
     /** Constructor; initializes Queue Pair, Memory Regions, and `remote_props`.
      */
     _resources(int r_index, char *write_addr, char *read_addr, int size_w,
-               int size_r);
+               int size_r,
+               const std::string &memory_account = derecho::pinned_memory::sst_account);
     /** Destroys the resources. */
     virtual ~_resources();
 };
@@ -79,7 +87,8 @@ public:
 class resources : public _resources {
 public:
     resources(int r_index, char *write_addr, char *read_addr, int size_w,
-              int size_r);
+              int size_r,
+              const std::string &memory_account = derecho::pinned_memory::sst_account);
     /*
       wrapper functions that make up the user interface
       all call post_remote_send with different parameters
@@ -88,6 +97,9 @@ public:
     void post_remote_read(const uint32_t id, const long long int size);
     /** Post an RDMA read at an offset into remote memory. */
     void post_remote_read(const uint32_t id, const long long int offset, const long long int size);
+    /** Post an RDMA read at an offset into remote memory, generating a
+     * completion entry when the data has fully landed in the read buffer. */
+    void post_remote_read_with_completion(const uint32_t id, const long long int offset, const long long int size);
     /** Post an RDMA write at the beginning address of remote memory. */
     void post_remote_write(const uint32_t id, const long long int size);
     /** Post an RDMA write at an offset into remote memory. */
@@ -102,7 +114,8 @@ class resources_two_sided : public _resources {
 
 public:
     resources_two_sided(int r_index, char *write_addr, char *read_addr, int size_w,
-                        int size_r);
+                        int size_r,
+                        const std::string &memory_account = derecho::pinned_memory::sst_account);
     void post_two_sided_send(const uint32_t id, const long long int size);
     /** Post an RDMA write at an offset into remote memory. */
     void post_two_sided_send(const uint32_t id, const long long int offset, long long int size);
@@ -1,7 +1,11 @@
+#include <algorithm>
+#include <atomic>
 #include <cassert>
 #include <chrono>
 #include <cstdlib>
 #include <ctime>
+#include <deque>
+#include <limits>
 #include <functional>
 #include <iostream>
 #include <map>
@@ -9,17 +13,51 @@
 #include <thread>
 #include <vector>
 
+#include "detail/scan_kernel.hpp"
 #include "sst.hpp"
 
 namespace sst {
+
+/**
+ * A multicast engine layered over SST slots. Two slot layouts are supported:
+ *
+ * Fixed slots (the default): the region is a window of window_size slots of
+ * max_msg_size bytes each, with a size word and a sequence word at the end of
+ * each slot. Receivers locate slots by index.
+ *
+ * Packed slots (opt-in via the constructor): the region is a byte ring of
+ * variable-length records, so a mix of small and large messages only
+ * occupies -- and only pushes -- the bytes actually written. Each record is
+ * [u64 seq][u64 size][payload]; a record with size == packed_wrap_marker is
+ * a wrap marker that sends the reader back to the start of the ring. The
+ * sequence word is written with a separate, second RDMA write (same-QP
+ * ordering makes the rest of the record visible first) and holds a
+ * monotonically increasing record count, so arrival is detected by an exact
+ * 64-bit match against the next expected value. Receivers must consume
+ * records with poll_packed(), which parses the ring and acknowledges into
+ * the local num_received_sst column; every member (including the sender)
+ * must poll and push its acknowledgements, since the sender reclaims ring
+ * space from the minimum acknowledged record index across all rows.
+ *
+ * Fixed-slot groups can additionally be split into num_channels logical send
+ * channels: each channel owns a contiguous sub-window of window_size /
+ * num_channels slots and an independent sequence and acknowledgement space,
+ * so a message that is slow to stabilize on one channel only blocks that
+ * channel's sub-window, not the sender's unrelated traffic. Messages are
+ * FIFO within a channel; there is no ordering between channels. A group with
+ * K channels uses K acknowledgement columns per sender (column sender * K +
+ * channel starting at num_received_offset), so the SST must be sized for
+ * num_senders * num_channels num_received_sst columns. The default of one
+ * channel preserves the original layout and behavior exactly.
+ */
 template <typename sstType>
 class multicast_group {
-    // number of messages for which get_buffer has been called
-    long long int queued_num = -1;
-    // number of messages for which RDMA write is complete
-    uint64_t num_sent = 0;
-    // the number of messages acknowledged by all the nodes
-    long long int finished_multicasts_num = -1;
+    // per channel, the number of messages for which get_buffer has been called
+    std::vector<long long int> queued_nums;
+    // per channel, the number of messages for which RDMA write is complete
+    std::vector<uint64_t> nums_sent;
+    // per channel, the number of messages acknowledged by all the nodes
+    std::vector<long long int> finished_multicasts_nums;
     // row of the node in the sst
     const uint32_t my_row;
     // rank of the node in the members list
@@ -47,19 +85,119 @@ class multicast_group {
     uint32_t num_senders;
     // window size
     const uint32_t window_size;
+    // number of logical send channels the window is split into
+    const uint32_t num_channels;
+    // slots per channel (window_size / num_channels)
+    const uint32_t channel_window_size;
+    // receiver-side next expected message index per (sender rank, channel)
+    std::vector<uint64_t> channel_receive_indices;
     // maximum size that the SST can send
     const uint64_t max_msg_size;
+    // actual size of the message queued in each window slot, so that send()
+    // can push just the bytes in use rather than the whole slot
+    std::vector<uint64_t> slot_msg_sizes;
+
+    /* ---- packed-slot mode state ---- */
+    // whether the slots region is a packed byte ring of variable-length
+    // records instead of fixed-size slots
+    const bool packed_slots;
+    // total bytes in the ring (window_size * max_msg_size)
+    const uint64_t ring_bytes;
+    // next byte offset to write in the local ring
+    uint64_t write_offset = 0;
+    // ring bytes occupied by records not yet acknowledged by every row
+    uint64_t bytes_in_flight = 0;
+    // 0-based index of the next record to queue
+    uint64_t next_record_index = 0;
+    // a record queued by get_buffer but not yet pushed by send()
+    struct packed_record {
+        uint64_t offset;
+        uint64_t payload_size;
+        uint64_t index;
+        bool is_wrap_marker;
+    };
+    std::deque<packed_record> pending_records;
+    // (record index, ring bytes consumed) of every unacknowledged record
+    std::deque<std::pair<uint64_t, uint64_t>> in_flight_records;
+    // receiver-side cursors, one per sender rank
+    std::vector<uint64_t> read_offsets;
+    std::vector<uint64_t> expected_indices;
+    // member row of each sender rank
+    std::vector<uint32_t> sender_member_rows;
+
+    /* ---- fixed-slot batching state ---- */
+    // number of messages to accumulate into one slots-region push; 1
+    // disables batching and keeps the one-push-per-message path
+    const uint32_t batch_size;
+    // flush a partial batch after this long; 0 means only flush when full
+    const uint64_t batch_timeout_us;
+    // slots whose sequence numbers have been advanced locally but whose
+    // pushes are deferred until the batch flushes
+    std::vector<uint32_t> batched_slots;
+    // when the oldest message in the current batch was queued
+    std::chrono::steady_clock::time_point oldest_batched;
+    std::atomic<bool> batch_thread_shutdown{false};
+    std::thread batch_flush_thread;
+
+    // pushes every batched slot with two gather writes: one carrying all the
+    // payloads and size words, then one carrying all the sequence numbers.
+    // Writes on the same connection are ordered, so a receiver that sees any
+    // of the new sequence numbers sees all of the batch's data. The caller
+    // must hold msg_send_mutex.
+    void flush_batched_slots() {
+        std::vector<std::pair<size_t, size_t>> data_segments;
+        std::vector<std::pair<size_t, size_t>> seq_segments;
+        for(const uint32_t slot : batched_slots) {
+            const size_t slot_base = (char*)std::addressof(sst->slots[0][slots_offset + max_msg_size * slot]) - sst->getBaseAddress();
+            if(slot_msg_sizes[slot] > 0) {
+                data_segments.emplace_back(slot_base, slot_msg_sizes[slot]);
+            }
+            data_segments.emplace_back(slot_base + max_msg_size - 2 * sizeof(uint64_t), sizeof(uint64_t));
+            seq_segments.emplace_back(slot_base + max_msg_size - sizeof(uint64_t), sizeof(uint64_t));
+        }
+        sst->put_segments(data_segments);
+        sst->put_segments(seq_segments);
+        batched_slots.clear();
+    }
+
+    // reclaims ring space from records acknowledged by every row
+    void reclaim_packed_acks() {
+        int64_t min_acked = sst->num_received_sst[my_row][num_received_offset + my_sender_index];
+        for(auto i : row_indices) {
+            int64_t acked = sst->num_received_sst[i][num_received_offset + my_sender_index];
+            min_acked = std::min(min_acked, acked);
+        }
+        while(!in_flight_records.empty()
+              && static_cast<int64_t>(in_flight_records.front().first) <= min_acked) {
+            bytes_in_flight -= in_flight_records.front().second;
+            in_flight_records.pop_front();
+        }
+    }
 
     std::thread timeout_thread;
 
+public:
+    /** In-band size value marking a wrap-to-ring-start record. */
+    static constexpr uint64_t packed_wrap_marker = std::numeric_limits<uint64_t>::max();
+
+private:
+
     void initialize() {
         for(auto i : row_indices) {
-            for(uint j = num_received_offset; j < num_received_offset + num_senders; ++j) {
+            for(uint j = num_received_offset; j < num_received_offset + num_senders * num_channels; ++j) {
                 sst->num_received_sst[i][j] = -1;
             }
-            for(uint j = 0; j < window_size; ++j) {
-                sst->slots[i][slots_offset + max_msg_size * j] = 0;
-                (uint64_t&)sst->slots[i][slots_offset + (max_msg_size * (j + 1)) - sizeof(uint64_t)] = 0;
+            if(packed_slots) {
+                // the ring parser trusts sequence words, so the whole region
+                // must start zeroed
+                for(uint64_t byte = 0; byte < ring_bytes; ++byte) {
+                    sst->slots[i][slots_offset + byte] = 0;
+                }
+            } else {
+                for(uint j = 0; j < window_size; ++j) {
+                    sst->slots[i][slots_offset + max_msg_size * j] = 0;
+                    (uint64_t&)sst->slots[i][slots_offset + (max_msg_size * (j + 1)) - sizeof(uint64_t)] = 0;
+                }
             }
         }
         sst->sync_with_members(row_indices);
@@ -72,7 +210,11 @@ public:
                     uint64_t max_msg_size,
                     std::vector<int> is_sender = {},
                     uint32_t num_received_offset = 0,
-                    uint32_t slots_offset = 0)
+                    uint32_t slots_offset = 0,
+                    bool packed_slots = false,
+                    uint32_t batch_size = 1,
+                    uint64_t batch_timeout_us = 0,
+                    uint32_t num_channels = 1)
             : my_row(sst->get_local_index()),
               sst(sst),
               row_indices(row_indices),
@@ -87,7 +229,16 @@ public:
               slots_offset(slots_offset),
               num_members(row_indices.size()),
               window_size(window_size),
-              max_msg_size(max_msg_size + 2 * sizeof(uint64_t)) {
+              num_channels(num_channels),
+              channel_window_size(window_size / num_channels),
+              max_msg_size(max_msg_size + 2 * sizeof(uint64_t)),
+              slot_msg_sizes(window_size, 0),
+              packed_slots(packed_slots),
+              ring_bytes(window_size * (max_msg_size + 2 * sizeof(uint64_t))),
+              // a batch larger than the window would deadlock get_buffer
+              // waiting for acks of messages the batch is still holding back
+              batch_size(std::min(batch_size, window_size)),
+              batch_timeout_us(batch_timeout_us) {
         // find my_member_index
         for(uint i = 0; i < num_members; ++i) {
             if(row_indices[i] == my_row) {
@@ -108,45 +259,263 @@ public:
         if(!this->is_sender[my_member_index]) {
             my_sender_index = -1;
         }
+        // channels partition the window evenly; the packed byte ring has no
+        // slot sub-windows to partition, so it only supports one channel
+        assert(num_channels >= 1 && window_size % num_channels == 0);
+        assert(!packed_slots || num_channels == 1);
+        queued_nums.assign(num_channels, -1);
+        nums_sent.assign(num_channels, 0);
+        finished_multicasts_nums.assign(num_channels, -1);
+        channel_receive_indices.assign(num_senders * num_channels, 0);
+        for(uint i = 0; i < num_members; ++i) {
+            if(this->is_sender[i]) {
+                sender_member_rows.push_back(row_indices[i]);
+            }
+        }
+        if(packed_slots) {
+            // the smallest record (header + marker room) must fit in the ring
+            assert(this->max_msg_size + 2 * sizeof(uint64_t) <= ring_bytes);
+            read_offsets.assign(num_senders, 0);
+            expected_indices.assign(num_senders, 0);
+        }
         initialize();
+        if(!packed_slots && this->batch_size > 1 && batch_timeout_us > 0
+           && my_sender_index >= 0) {
+            batch_flush_thread = std::thread([this]() {
+                pthread_setname_np(pthread_self(), "smc_batch");
+                while(!batch_thread_shutdown) {
+                    std::this_thread::sleep_for(std::chrono::microseconds(this->batch_timeout_us));
+                    std::lock_guard<std::mutex> lock(msg_send_mutex);
+                    if(!batched_slots.empty()
+                       && std::chrono::steady_clock::now() - oldest_batched
+                                  >= std::chrono::microseconds(this->batch_timeout_us)) {
+                        flush_batched_slots();
+                    }
+                }
+            });
+        }
+    }
+
+    ~multicast_group() {
+        if(batch_flush_thread.joinable()) {
+            batch_thread_shutdown = true;
+            batch_flush_thread.join();
+        }
     }
 
-    volatile char* get_buffer(uint64_t msg_size) {
+    /**
+     * Reserves the next slot on one logical channel, or nullptr if that
+     * channel's sub-window is full (other channels may still have room).
+     */
+    volatile char* get_buffer(uint64_t msg_size, uint32_t channel = 0) {
         assert(my_sender_index >= 0);
+        assert(channel < num_channels);
         std::lock_guard<std::mutex> lock(msg_send_mutex);
         assert(msg_size <= max_msg_size);
+        if(packed_slots) {
+            const uint64_t header_bytes = 2 * sizeof(uint64_t);
+            const uint64_t record_len = header_bytes + msg_size;
+            reclaim_packed_acks();
+            // wrap when the record (plus room for a future wrap marker)
+            // would run off the end of the ring; the skipped tail counts as
+            // bytes consumed by the marker record
+            uint64_t wrap_waste = 0;
+            const bool need_wrap = (write_offset + record_len + header_bytes > ring_bytes);
+            if(need_wrap) {
+                wrap_waste = ring_bytes - write_offset;
+            }
+            if(bytes_in_flight + wrap_waste + record_len > ring_bytes) {
+                return nullptr;
+            }
+            if(need_wrap) {
+                (uint64_t&)sst->slots[my_row][slots_offset + write_offset + sizeof(uint64_t)]
+                        = packed_wrap_marker;
+                pending_records.push_back({write_offset, 0, next_record_index, true});
+                in_flight_records.push_back({next_record_index, wrap_waste});
+                ++next_record_index;
+                bytes_in_flight += wrap_waste;
+                write_offset = 0;
+            }
+            (uint64_t&)sst->slots[my_row][slots_offset + write_offset + sizeof(uint64_t)] = msg_size;
+            pending_records.push_back({write_offset, msg_size, next_record_index, false});
+            in_flight_records.push_back({next_record_index, record_len});
+            ++next_record_index;
+            bytes_in_flight += record_len;
+            volatile char* buf = &sst->slots[my_row][slots_offset + write_offset + header_bytes];
+            write_offset += record_len;
+            return buf;
+        }
         while(true) {
-            if(queued_num - finished_multicasts_num < window_size) {
-                queued_num++;
-                uint32_t slot = queued_num % window_size;
+            if(queued_nums[channel] - finished_multicasts_nums[channel] < channel_window_size) {
+                queued_nums[channel]++;
+                uint32_t slot = channel * channel_window_size + queued_nums[channel] % channel_window_size;
                 // set size appropriately
                 (uint64_t&)sst->slots[my_row][slots_offset + (max_msg_size * (slot + 1)) - 2 * sizeof(uint64_t)] = msg_size;
+                slot_msg_sizes[slot] = msg_size;
                 return &sst->slots[my_row][slots_offset + (max_msg_size * slot)];
             } else {
-                long long int min_multicast_num = sst->num_received_sst[my_row][num_received_offset + my_sender_index];
+                const uint32_t ack_column = num_received_offset + my_sender_index * num_channels + channel;
+                long long int min_multicast_num = sst->num_received_sst[my_row][ack_column];
                 for(auto i : row_indices) {
-                    long long int num_received_sst_copy = sst->num_received_sst[i][num_received_offset + my_sender_index];
+                    long long int num_received_sst_copy = sst->num_received_sst[i][ack_column];
                     min_multicast_num = std::min(min_multicast_num, num_received_sst_copy);
                 }
-                if(finished_multicasts_num == min_multicast_num) {
+                if(finished_multicasts_nums[channel] == min_multicast_num) {
                     return nullptr;
                 } else {
-                    finished_multicasts_num = min_multicast_num;
+                    finished_multicasts_nums[channel] = min_multicast_num;
                 }
             }
         }
     }
 
-    void send() {
-        uint32_t slot = num_sent % window_size;
-        num_sent++;
+    /** Publishes the slot most recently reserved on the given channel. */
+    void send(uint32_t channel = 0) {
+        assert(channel < num_channels);
+        if(packed_slots) {
+            // push any wrap marker queued ahead of the record, then one
+            // data record; each record is a data write (size word + payload)
+            // followed by its sequence word in a separate write, so the
+            // same-QP ordering guarantee makes the record visible before
+            // its arrival flag
+            while(!pending_records.empty()) {
+                const packed_record record = pending_records.front();
+                pending_records.pop_front();
+                (uint64_t&)sst->slots[my_row][slots_offset + record.offset] = record.index + 1;
+                const size_t region_base
+                        = (char*)std::addressof(sst->slots[0][slots_offset]) - sst->getBaseAddress();
+                const uint64_t data_len = record.is_wrap_marker
+                                                  ? sizeof(uint64_t)
+                                                  : sizeof(uint64_t) + record.payload_size;
+                sst->put(region_base + record.offset + sizeof(uint64_t), data_len);
+                sst->put(region_base + record.offset, sizeof(uint64_t));
+                if(!record.is_wrap_marker) {
+                    break;
+                }
+            }
+            return;
+        }
+        uint32_t slot = channel * channel_window_size + nums_sent[channel] % channel_window_size;
+        nums_sent[channel]++;
         ((uint64_t&)sst->slots[my_row][slots_offset + max_msg_size * (slot + 1) - sizeof(uint64_t)])++;
-        sst->put(
-                (char*)std::addressof(sst->slots[0][slots_offset + max_msg_size * slot]) - sst->getBaseAddress(),
-                max_msg_size - sizeof(uint64_t));
-        sst->put(
-                (char*)std::addressof(sst->slots[0][slots_offset + slot * max_msg_size]) - sst->getBaseAddress() + max_msg_size - sizeof(uint64_t),
-                sizeof(uint64_t));
+        if(batch_size > 1) {
+            // defer the push: accumulate this slot and flush the whole batch
+            // with one gather write when it fills (or when the flush thread
+            // times out a partial batch). The lock is against that thread.
+            std::lock_guard<std::mutex> lock(msg_send_mutex);
+            if(batched_slots.empty()) {
+                oldest_batched = std::chrono::steady_clock::now();
+            }
+            batched_slots.push_back(slot);
+            if(batched_slots.size() >= batch_size) {
+                flush_batched_slots();
+            }
+            return;
+        }
+        const size_t slot_offset = (char*)std::addressof(sst->slots[0][slots_offset + max_msg_size * slot]) - sst->getBaseAddress();
+        // Gather just the bytes that carry this message -- the payload at the
+        // start of the slot and the size word at its end -- in one write,
+        // instead of pushing the entire max-sized slot. The sequence number
+        // still goes in a separate second write: placement within a single
+        // RDMA write is unordered, but writes on the same connection are
+        // ordered, so a receiver that sees the new sequence number is
+        // guaranteed to see the data as well.
+        std::vector<std::pair<size_t, size_t>> segments;
+        if(slot_msg_sizes[slot] > 0) {
+            segments.emplace_back(slot_offset, slot_msg_sizes[slot]);
+        }
+        segments.emplace_back(slot_offset + max_msg_size - 2 * sizeof(uint64_t), sizeof(uint64_t));
+        sst->put_segments(segments);
+        sst->put(slot_offset + max_msg_size - sizeof(uint64_t), sizeof(uint64_t));
+    }
+
+    /**
+     * Parses and consumes any newly arrived records from one sender's packed
+     * ring, invoking handler(payload, size, index) for each message. A record
+     * has arrived when its sequence word exactly matches the next expected
+     * record index + 1; wrap markers are consumed silently. Consumed records
+     * are acknowledged into the local num_received_sst column -- the caller
+     * is responsible for pushing that column to the other members so the
+     * sender can reclaim ring space. Only valid when the group was
+     * constructed with packed_slots = true.
+     *
+     * @return the number of messages delivered to the handler
+     */
+    template <typename Handler>
+    uint32_t poll_packed(uint32_t sender_rank, Handler&& handler) {
+        assert(packed_slots);
+        const uint32_t row = sender_member_rows[sender_rank];
+        uint32_t num_delivered = 0;
+        bool consumed_any = false;
+        while(true) {
+            const uint64_t off = read_offsets[sender_rank];
+            const uint64_t seq_word = (uint64_t&)sst->slots[row][slots_offset + off];
+            if(seq_word != expected_indices[sender_rank] + 1) {
+                break;
+            }
+            const uint64_t size_word
+                    = (uint64_t&)sst->slots[row][slots_offset + off + sizeof(uint64_t)];
+            if(size_word == packed_wrap_marker) {
+                read_offsets[sender_rank] = 0;
+            } else {
+                // the size word tells us where the next record's sequence
+                // word will be, so start it on its way before the handler
+                // chews through the payload
+                prefetch_for_read(&sst->slots[row][slots_offset + off + 2 * sizeof(uint64_t) + size_word]);
+                handler(&sst->slots[row][slots_offset + off + 2 * sizeof(uint64_t)],
+                        size_word, expected_indices[sender_rank]);
+                read_offsets[sender_rank] += 2 * sizeof(uint64_t) + size_word;
+                ++num_delivered;
+            }
+            ++expected_indices[sender_rank];
+            consumed_any = true;
+        }
+        if(consumed_any) {
+            sst->num_received_sst[my_row][num_received_offset + sender_rank]
+                    = expected_indices[sender_rank] - 1;
+        }
+        return num_delivered;
+    }
+
+    /**
+     * Parses and consumes any newly arrived messages on one logical channel
+     * of one sender's window, invoking handler(payload, size, index) for each
+     * message, where index counts messages on that channel. A slot has
+     * arrived when its sequence word matches the number of times the
+     * channel's sub-window has wrapped plus one. Consumed messages are
+     * acknowledged into the channel's local num_received_sst column -- the
+     * caller is responsible for pushing that column to the other members so
+     * the sender's sub-window can advance. Channels are independent: a stall
+     * on one channel never blocks delivery on another. Only valid for
+     * fixed-slot groups.
+     *
+     * @return the number of messages delivered to the handler
+     */
+    template <typename Handler>
+    uint32_t poll_channel(uint32_t sender_rank, uint32_t channel, Handler&& handler) {
+        assert(!packed_slots);
+        assert(channel < num_channels);
+        const uint32_t row = sender_member_rows[sender_rank];
+        uint64_t& next_index = channel_receive_indices[sender_rank * num_channels + channel];
+        uint32_t num_delivered = 0;
+        while(true) {
+            const uint32_t slot = channel * channel_window_size + next_index % channel_window_size;
+            const uint64_t seq_word
+                    = (uint64_t&)sst->slots[row][slots_offset + (max_msg_size * (slot + 1)) - sizeof(uint64_t)];
+            if(seq_word != next_index / channel_window_size + 1) {
+                break;
+            }
+            const uint64_t size_word
+                    = (uint64_t&)sst->slots[row][slots_offset + (max_msg_size * (slot + 1)) - 2 * sizeof(uint64_t)];
+            handler(&sst->slots[row][slots_offset + max_msg_size * slot], size_word, next_index);
+            ++next_index;
+            ++num_delivered;
+        }
+        if(num_delivered > 0) {
+            sst->num_received_sst[my_row][num_received_offset + sender_rank * num_channels + channel]
+                    = next_index - 1;
+        }
+        return num_delivered;
     }
 
     void debug_print() {
@@ -161,7 +530,7 @@ public:
         }
         cout << "Printing num_received_sst" << endl;
         for(auto i : row_indices) {
-            for(uint j = num_received_offset; j < num_received_offset + num_senders; ++j) {
+            for(uint j = num_received_offset; j < num_received_offset + num_senders * num_channels; ++j) {
                 cout << sst->num_received_sst[i][j] << " ";
             }
             cout << endl;
@@ -1,17 +1,54 @@
 #pragma once
 
 #include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <ctime>
+#include <deque>
 #include <functional>
 #include <list>
+#include <memory>
 #include <mutex>
+#include <pthread.h>
+#include <string>
+#include <thread>
 #include <utility>
+#include <vector>
 
+#include <derecho/conf/conf.hpp>
 
 namespace sst {
 
 template <class DerivedSST>
 class SST;
 
+/**
+ * Priority classes for predicates. Within each evaluation round the detect
+ * thread evaluates LATENCY_CRITICAL predicates first, then NORMAL ones;
+ * BACKGROUND predicates are only evaluated every
+ * DERECHO/background_predicate_interval rounds, so bursts of housekeeping
+ * work (e.g. ragged-trim or cleanup) don't add tail latency to delivery.
+ */
+enum class PredicatePriority {
+    /** Evaluated first in every round: delivery and stability predicates. */
+    LATENCY_CRITICAL,
+    /** Evaluated in every round, after the latency-critical class. */
+    NORMAL,
+    /** Rate-limited housekeeping predicates. */
+    BACKGROUND
+};
+
+/** Reads the CPU timestamp counter; used for cheap predicate timing. */
+inline uint64_t predicate_clock() {
+#if defined(__x86_64__) || defined(__i386__)
+    return __builtin_ia32_rdtsc();
+#else
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return now.tv_sec * 1000000000ull + now.tv_nsec;
+#endif
+}
+
 /** Enumeration defining the kinds of predicates an SST can handle. */
 enum class PredicateType {
     /** One-time predicates only fire once; they are deleted once they become true. */
@@ -24,44 +61,200 @@ enum class PredicateType {
     TRANSITION
 };
 
+/**
+ * Holds the predicates registered against an SST instance, partitioned into
+ * one or more evaluation shards. Each shard has its own predicate lists and
+ * lock, and is evaluated by its own detect thread, so a busy shard (e.g. a
+ * subgroup with a heavy delivery load) does not add latency to the others.
+ *
+ * Ordering guarantees: triggers registered on the same shard run sequentially
+ * on that shard's thread, in registration order within each evaluation round.
+ * There is no ordering between triggers on different shards; they run
+ * concurrently. The number of shards comes from DERECHO/predicate_shards,
+ * which defaults to 1, preserving the old single-thread global ordering.
+ */
 template <class DerivedSST>
 class Predicates {
     using pred = std::function<bool(const DerivedSST&)>;
     using trig = std::function<void(DerivedSST&)>;
-    using pred_list = std::list<std::unique_ptr<std::pair<pred, std::shared_ptr<trig>>>>;
-    /** Predicate list for one-time predicates. */
-    pred_list one_time_predicates;
-    /** Predicate list for recurrent predicates */
-    pred_list recurrent_predicates;
-    /** Predicate list for transition predicates */
-    pred_list transition_predicates;
-    /** Contains one entry for every predicate in `transition_predicates`, in parallel. */
-    std::list<bool> transition_predicate_states;
+    /** Per-predicate execution counters, updated by the detect thread under
+     * the shard's predicate lock when statistics collection is enabled. All
+     * times are in TSC ticks. */
+    struct pred_stats {
+        uint64_t evaluations = 0;
+        uint64_t fires = 0;
+        uint64_t total_evaluation_ticks = 0;
+        uint64_t max_evaluation_ticks = 0;
+        uint64_t total_trigger_ticks = 0;
+        uint64_t max_trigger_ticks = 0;
+    };
+    /** A registered predicate, its trigger, its priority class, and its
+     * (possibly empty) diagnostic name. */
+    struct pred_entry {
+        pred predicate;
+        std::shared_ptr<trig> trigger;
+        PredicatePriority priority;
+        std::string name;
+        /** Non-negative if the trigger runs on the offload executor; see
+         * insert(). */
+        int64_t offload_key;
+        pred_stats stats;
+    };
+    using pred_list = std::list<std::unique_ptr<pred_entry>>;
+
+    /** A single evaluation partition, with its own lists and lock. */
+    struct shard_t {
+        /** Predicate list for one-time predicates. */
+        pred_list one_time_predicates;
+        /** Predicate list for recurrent predicates */
+        pred_list recurrent_predicates;
+        /** Predicate list for transition predicates */
+        pred_list transition_predicates;
+        /** Contains one entry for every predicate in `transition_predicates`, in parallel. */
+        std::list<bool> transition_predicate_states;
+        std::mutex predicate_mutex;
+    };
+    /** The evaluation shards; sized once at construction and never resized,
+     * so detect threads can hold references into it without locking. */
+    std::vector<std::unique_ptr<shard_t>> shards;
+    /** Whether the detect threads collect per-predicate statistics. */
+    std::atomic<bool> statistics_collection{false};
+    /** One serial lane of the trigger offload executor: triggers queued to
+     * the same lane run one at a time, in enqueue order. */
+    struct offload_lane {
+        std::thread thread;
+        std::mutex queue_mutex;
+        std::condition_variable queue_cv;
+        std::deque<std::function<void()>> queue;
+    };
+    /** Size of the offload executor (DERECHO/trigger_offload_threads); 0
+     * disables it and offload-keyed triggers run inline. */
+    const uint32_t offload_thread_count;
+    /** The executor's lanes, started on the first offload-keyed insert(). */
+    std::vector<std::unique_ptr<offload_lane>> offload_lanes;
+    std::mutex offload_start_mutex;
+    std::atomic<bool> offload_started{false};
+    std::atomic<bool> offload_shutdown{false};
+
+    /** Starts the offload lanes if they are not running yet. */
+    void start_offload_lanes() {
+        if(offload_started.load(std::memory_order_acquire) || offload_thread_count == 0) {
+            return;
+        }
+        std::lock_guard<std::mutex> lock(offload_start_mutex);
+        if(offload_started.load(std::memory_order_relaxed)) {
+            return;
+        }
+        for(uint32_t lane = 0; lane < offload_thread_count; ++lane) {
+            offload_lanes.emplace_back(std::make_unique<offload_lane>());
+        }
+        for(uint32_t lane = 0; lane < offload_thread_count; ++lane) {
+            offload_lanes[lane]->thread = std::thread(&Predicates::offload_lane_main, this, lane);
+        }
+        offload_started.store(true, std::memory_order_release);
+    }
+
+    /** Body of one offload lane: drains its queue serially, and exits once
+     * shutdown is requested and the queue is empty. */
+    void offload_lane_main(uint32_t lane_index) {
+        pthread_setname_np(pthread_self(), ("sst_trig" + std::to_string(lane_index)).c_str());
+        offload_lane& lane = *offload_lanes[lane_index];
+        while(true) {
+            std::function<void()> task;
+            {
+                std::unique_lock<std::mutex> lock(lane.queue_mutex);
+                lane.queue_cv.wait(lock, [&]() {
+                    return offload_shutdown.load(std::memory_order_relaxed) || !lane.queue.empty();
+                });
+                if(lane.queue.empty()) {
+                    return;
+                }
+                task = std::move(lane.queue.front());
+                lane.queue.pop_front();
+            }
+            task();
+        }
+    }
+
     // SST needs to read these predicate lists directly
     friend class SST<DerivedSST>;
 
-    std::mutex predicate_mutex;
-
 public:
+    Predicates()
+            : offload_thread_count(derecho::getConfUInt32(CONF_DERECHO_TRIGGER_OFFLOAD_THREADS)) {
+        uint32_t num_shards = derecho::getConfUInt32(CONF_DERECHO_PREDICATE_SHARDS);
+        if(num_shards == 0) {
+            num_shards = 1;
+        }
+        for(uint32_t i = 0; i < num_shards; ++i) {
+            shards.emplace_back(std::make_unique<shard_t>());
+        }
+    }
+
+    ~Predicates() {
+        stop_trigger_executor();
+    }
+
+    /** True if the trigger offload executor is configured; when false,
+     * offload-keyed triggers run inline on the detect thread. */
+    bool offload_enabled() const {
+        return offload_thread_count > 0;
+    }
+
+    /** Hands a fired trigger to its offload lane (offload_key mod the lane
+     * count); same-key triggers run serially in enqueue order. Called by the
+     * detect loop for predicates registered with a non-negative offload key. */
+    void offload_trigger(int64_t offload_key, std::shared_ptr<trig> trigger, DerivedSST* sst_instance) {
+        offload_lane& lane = *offload_lanes[offload_key % offload_lanes.size()];
+        {
+            std::lock_guard<std::mutex> lock(lane.queue_mutex);
+            lane.queue.emplace_back([trigger, sst_instance]() { (*trigger)(*sst_instance); });
+        }
+        lane.queue_cv.notify_one();
+    }
+
+    /** Drains the offload lanes and joins their threads. Idempotent; called
+     * by ~SST before the detect threads stop, while triggers can still run
+     * safely against the SST. */
+    void stop_trigger_executor() {
+        offload_shutdown.store(true, std::memory_order_release);
+        for(auto& lane : offload_lanes) {
+            lane->queue_cv.notify_all();
+        }
+        for(auto& lane : offload_lanes) {
+            if(lane->thread.joinable()) {
+                lane->thread.join();
+            }
+        }
+    }
+
+    /** The number of evaluation shards (and thus detect threads). */
+    uint32_t num_shards() const {
+        return shards.size();
+    }
+
     class pred_handle {
         bool valid;
         typename pred_list::iterator iter;
         PredicateType type;
+        /** Which evaluation shard the predicate lives in. */
+        uint32_t shard_index;
         friend class Predicates;
 
     public:
-        pred_handle() : valid(false), type(PredicateType::ONE_TIME) {}
-        pred_handle(typename pred_list::iterator iter, PredicateType type)
-                : valid{true}, iter{iter}, type{type} {}
+        pred_handle() : valid(false), type(PredicateType::ONE_TIME), shard_index(0) {}
+        pred_handle(typename pred_list::iterator iter, PredicateType type, uint32_t shard_index)
+                : valid{true}, iter{iter}, type{type}, shard_index{shard_index} {}
         pred_handle(pred_handle&) = delete;
         pred_handle(pred_handle&& other)
-                : pred_handle(std::move(other.iter), other.type) {
+                : pred_handle(std::move(other.iter), other.type, other.shard_index) {
             other.valid = false;
         }
         pred_handle& operator=(pred_handle&) = delete;
         pred_handle& operator=(pred_handle&& other) {
             iter = std::move(other.iter);
             type = other.type;
+            shard_index = other.shard_index;
             valid = true;
             other.valid = false;
             return *this;
@@ -71,19 +264,42 @@ public:
         }
     };
 
-    /** Inserts a single (predicate, trigger) pair to the appropriate predicate list. */
+    /** Inserts a single (predicate, trigger) pair to the appropriate predicate
+     * list. A non-negative shard_key (e.g. a subgroup number) assigns the
+     * predicate to shard (shard_key % num_shards()); the default of -1 puts it
+     * in shard 0, which keeps existing callers' relative trigger ordering.
+     * The priority class controls how often the detect loop evaluates the
+     * predicate; see PredicatePriority. The optional name identifies the
+     * predicate in the statistics reported by get_statistics().
+     * A non-negative offload_key moves the trigger off the detect thread:
+     * when the predicate fires, the trigger is queued to the offload
+     * executor's lane (offload_key mod DERECHO/trigger_offload_threads) and
+     * evaluation continues immediately, so an expensive trigger cannot delay
+     * the other predicates in its shard. Triggers with the same offload key
+     * run serially in fire order; triggers with different keys (and inline
+     * triggers) run concurrently with them. Offloaded triggers do not
+     * accumulate trigger-time statistics, since the entry may be removed
+     * while the trigger is still queued. */
     pred_handle insert(pred predicate, trig trigger,
-                       PredicateType type = PredicateType::ONE_TIME);
+                       PredicateType type = PredicateType::ONE_TIME,
+                       int32_t shard_key = -1,
+                       PredicatePriority priority = PredicatePriority::NORMAL,
+                       const std::string& name = "",
+                       int64_t offload_key = -1);
 
     /** Inserts a predicate with a list of triggers (which will be run in
      * sequence) to the appropriate predicate list. */
     pred_handle insert(pred predicate, const std::list<trig>& triggers,
-                       PredicateType type = PredicateType::ONE_TIME) {
+                       PredicateType type = PredicateType::ONE_TIME,
+                       int32_t shard_key = -1,
+                       PredicatePriority priority = PredicatePriority::NORMAL,
+                       const std::string& name = "",
+                       int64_t offload_key = -1) {
         return insert(predicate, [triggers](DerivedSST& t) {
             for(const auto& trigger : triggers)
                 trigger(t);
         },
-                      type);
+                      type, shard_key, priority, name, offload_key);
     }
 
     /** Removes a (predicate, trigger) pair previously registered with insert(). */
@@ -91,6 +307,36 @@ public:
 
     /** Deletes all predicates, including evolvers and their triggers. */
     void clear();
+
+    /** A snapshot of one predicate's execution statistics, as returned by
+     * get_statistics(). Times are in TSC ticks. */
+    struct PredicateStats {
+        std::string name;
+        PredicateType type;
+        uint64_t evaluations;
+        uint64_t fires;
+        uint64_t total_evaluation_ticks;
+        uint64_t max_evaluation_ticks;
+        uint64_t total_trigger_ticks;
+        uint64_t max_trigger_ticks;
+    };
+
+    /** Turns per-predicate statistics collection on or off; collection
+     * starts disabled, in which case the detect loop's only extra cost is
+     * one branch per predicate. */
+    void set_statistics_enabled(bool enable) {
+        statistics_collection.store(enable, std::memory_order_release);
+    }
+
+    /** True if the detect threads are collecting per-predicate statistics. */
+    bool statistics_enabled() const {
+        return statistics_collection.load(std::memory_order_relaxed);
+    }
+
+    /** Returns a snapshot of the execution statistics for every currently
+     * registered predicate, across all shards. Predicates registered without
+     * a name appear with an empty name. */
+    std::vector<PredicateStats> get_statistics();
 };
 
 /**
@@ -104,27 +350,35 @@ public:
  * PredicateType::ONE_TIME
  */
 template <class DerivedSST>
-auto Predicates<DerivedSST>::insert(pred predicate, trig trigger, PredicateType type) -> pred_handle {
-    std::lock_guard<std::mutex> lock(predicate_mutex);
+auto Predicates<DerivedSST>::insert(pred predicate, trig trigger, PredicateType type,
+                                    int32_t shard_key, PredicatePriority priority,
+                                    const std::string& name, int64_t offload_key) -> pred_handle {
+    if(offload_key >= 0) {
+        // make sure the executor is running before the predicate can fire
+        start_offload_lanes();
+    }
+    const uint32_t shard_index = (shard_key < 0) ? 0 : (shard_key % shards.size());
+    shard_t& shard = *shards[shard_index];
+    std::lock_guard<std::mutex> lock(shard.predicate_mutex);
     if(type == PredicateType::ONE_TIME) {
-        one_time_predicates.push_back(std::make_unique<std::pair<pred, std::shared_ptr<trig>>>(
-                predicate, std::make_shared<trig>(trigger)));
-        return pred_handle(--one_time_predicates.end(), type);
+        shard.one_time_predicates.push_back(std::make_unique<pred_entry>(
+                pred_entry{predicate, std::make_shared<trig>(trigger), priority, name, offload_key, {}}));
+        return pred_handle(--shard.one_time_predicates.end(), type, shard_index);
     } else if(type == PredicateType::RECURRENT) {
-        recurrent_predicates.push_back(std::make_unique<std::pair<pred, std::shared_ptr<trig>>>(
-                predicate, std::make_shared<trig>(trigger)));
-        return pred_handle(--recurrent_predicates.end(), type);
+        shard.recurrent_predicates.push_back(std::make_unique<pred_entry>(
+                pred_entry{predicate, std::make_shared<trig>(trigger), priority, name, offload_key, {}}));
+        return pred_handle(--shard.recurrent_predicates.end(), type, shard_index);
     } else {
-        transition_predicates.push_back(std::make_unique<std::pair<pred, std::shared_ptr<trig>>>(
-                predicate, std::make_shared<trig>(trigger)));
-        transition_predicate_states.push_back(false);
-        return pred_handle(--transition_predicates.end(), type);
+        shard.transition_predicates.push_back(std::make_unique<pred_entry>(
+                pred_entry{predicate, std::make_shared<trig>(trigger), priority, name, offload_key, {}}));
+        shard.transition_predicate_states.push_back(false);
+        return pred_handle(--shard.transition_predicates.end(), type, shard_index);
     }
 }
 
 template <class DerivedSST>
 void Predicates<DerivedSST>::remove(pred_handle& handle) {
-    std::lock_guard<std::mutex> lock(predicate_mutex);
+    std::lock_guard<std::mutex> lock(shards[handle.shard_index]->predicate_mutex);
     if(!handle.is_valid()) {
         return;
     }
@@ -134,14 +388,40 @@ void Predicates<DerivedSST>::remove(pred_handle& handle) {
 
 template <class DerivedSST>
 void Predicates<DerivedSST>::clear() {
-    std::lock_guard<std::mutex> lock(predicate_mutex);
-    using ptr_to_pred = std::unique_ptr<std::pair<pred, std::shared_ptr<trig>>>;
-    std::for_each(one_time_predicates.begin(), one_time_predicates.end(),
-                  [](ptr_to_pred& ptr) { ptr.reset(); });
-    std::for_each(recurrent_predicates.begin(), recurrent_predicates.end(),
-                  [](ptr_to_pred& ptr) { ptr.reset(); });
-    std::for_each(transition_predicates.begin(), transition_predicates.end(),
-                  [](ptr_to_pred& ptr) { ptr.reset(); });
+    using ptr_to_pred = std::unique_ptr<pred_entry>;
+    for(auto& shard : shards) {
+        std::lock_guard<std::mutex> lock(shard->predicate_mutex);
+        std::for_each(shard->one_time_predicates.begin(), shard->one_time_predicates.end(),
+                      [](ptr_to_pred& ptr) { ptr.reset(); });
+        std::for_each(shard->recurrent_predicates.begin(), shard->recurrent_predicates.end(),
+                      [](ptr_to_pred& ptr) { ptr.reset(); });
+        std::for_each(shard->transition_predicates.begin(), shard->transition_predicates.end(),
+                      [](ptr_to_pred& ptr) { ptr.reset(); });
+    }
+}
+
+template <class DerivedSST>
+auto Predicates<DerivedSST>::get_statistics() -> std::vector<PredicateStats> {
+    std::vector<PredicateStats> results;
+    for(auto& shard : shards) {
+        std::lock_guard<std::mutex> lock(shard->predicate_mutex);
+        auto append_list = [&results](const pred_list& list, PredicateType type) {
+            for(const auto& entry : list) {
+                if(entry != nullptr) {
+                    results.push_back({entry->name, type,
+                                       entry->stats.evaluations, entry->stats.fires,
+                                       entry->stats.total_evaluation_ticks,
+                                       entry->stats.max_evaluation_ticks,
+                                       entry->stats.total_trigger_ticks,
+                                       entry->stats.max_trigger_ticks});
+                }
+            }
+        };
+        append_list(shard->one_time_predicates, PredicateType::ONE_TIME);
+        append_list(shard->recurrent_predicates, PredicateType::RECURRENT);
+        append_list(shard->transition_predicates, PredicateType::TRANSITION);
+    }
+    return results;
 }
 
 } /* namespace sst */
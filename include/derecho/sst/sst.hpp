@@ -4,11 +4,13 @@
 #include <bitset>
 #include <cassert>
 #include <condition_variable>
+#include <deque>
 #include <functional>
 #include <iostream>
 #include <list>
 #include <memory>
 #include <mutex>
+#include <new>
 #include <numeric>
 #include <stdexcept>
 #include <string.h>
@@ -18,6 +20,14 @@
 
 #include "predicates.hpp"
 #include <derecho/conf/conf.hpp>
+#include <derecho/utils/hugepage_alloc.hpp>
+#include <derecho/utils/numa_placement.hpp>
+
+#ifdef __AVX2__
+#include <immintrin.h>
+#endif
+#include <limits>
+#include <type_traits>
 
 #ifdef USE_VERBS_API
 #include "detail/verbs.hpp"
@@ -37,14 +47,136 @@ constexpr size_t padded_len(const size_t& len) {
     return (len <= alignTo) ? alignTo : (len + alignTo) & ~(alignTo - 1);
 }
 
+// granularity at which unrelated SST data is kept apart: a remote write
+// landing in one section of a row must not invalidate the cache lines a
+// local predicate scan is polling in another section
+const size_t CACHE_LINE_SIZE = 64;
+
+constexpr size_t cacheline_padded_len(const size_t& len) {
+    return (len + CACHE_LINE_SIZE - 1) & ~(CACHE_LINE_SIZE - 1);
+}
+
+namespace detail {
+
+/**
+ * Strided scan computing the minimum of one field element across a set of
+ * rows. elem_base points at the element in row 0; consecutive rows are
+ * rowLen bytes apart (row-major layout). For signed 32/64-bit integer
+ * element types the scan is vectorized with AVX2 gathers when available;
+ * all other types fall back to the scalar loop. The reads deliberately
+ * bypass the fields' volatile qualifier, which is safe for the same reason
+ * the scalar predicate scans are: each element is read at most once.
+ */
+template <typename T>
+T min_over_rows_scan(const char* elem_base, const size_t rowLen,
+                     const std::vector<uint32_t>& row_indices) {
+    T min_val = std::numeric_limits<T>::max();
+    size_t i = 0;
+#ifdef __AVX2__
+    if constexpr(std::is_integral<T>::value && std::is_signed<T>::value && sizeof(T) == 4) {
+        __m256i vmin = _mm256_set1_epi32(std::numeric_limits<int32_t>::max());
+        const __m256i vrow_len = _mm256_set1_epi32(static_cast<int32_t>(rowLen));
+        for(; i + 8 <= row_indices.size(); i += 8) {
+            __m256i vrows = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(&row_indices[i]));
+            __m256i voffsets = _mm256_mullo_epi32(vrows, vrow_len);
+            __m256i vals = _mm256_i32gather_epi32(reinterpret_cast<const int*>(elem_base), voffsets, 1);
+            vmin = _mm256_min_epi32(vmin, vals);
+        }
+        alignas(32) int32_t lanes[8];
+        _mm256_store_si256(reinterpret_cast<__m256i*>(lanes), vmin);
+        for(int lane = 0; lane < 8; ++lane) {
+            min_val = std::min(min_val, static_cast<T>(lanes[lane]));
+        }
+    } else if constexpr(std::is_integral<T>::value && std::is_signed<T>::value && sizeof(T) == 8) {
+        __m256i vmin = _mm256_set1_epi64x(std::numeric_limits<int64_t>::max());
+        const __m128i vrow_len = _mm_set1_epi32(static_cast<int32_t>(rowLen));
+        for(; i + 4 <= row_indices.size(); i += 4) {
+            __m128i vrows = _mm_loadu_si128(reinterpret_cast<const __m128i*>(&row_indices[i]));
+            __m128i voffsets = _mm_mullo_epi32(vrows, vrow_len);
+            __m256i vals = _mm256_i32gather_epi64(reinterpret_cast<const long long*>(elem_base), voffsets, 1);
+            // AVX2 has no 64-bit min, so synthesize one with compare+blend
+            __m256i vgt = _mm256_cmpgt_epi64(vmin, vals);
+            vmin = _mm256_blendv_epi8(vmin, vals, vgt);
+        }
+        alignas(32) int64_t lanes[4];
+        _mm256_store_si256(reinterpret_cast<__m256i*>(lanes), vmin);
+        for(int lane = 0; lane < 4; ++lane) {
+            min_val = std::min(min_val, static_cast<T>(lanes[lane]));
+        }
+    }
+#endif
+    for(; i < row_indices.size(); ++i) {
+        const T val = *reinterpret_cast<const volatile T*>(elem_base + row_indices[i] * rowLen);
+        min_val = std::min(min_val, val);
+    }
+    return min_val;
+}
+
+/**
+ * Strided scan counting how many of the given rows have a field element
+ * greater than or equal to threshold. Same layout and vectorization rules
+ * as min_over_rows_scan().
+ */
+template <typename T>
+size_t count_geq_scan(const char* elem_base, const size_t rowLen,
+                      const std::vector<uint32_t>& row_indices, const T& threshold) {
+    size_t count = 0;
+    size_t i = 0;
+#ifdef __AVX2__
+    if constexpr(std::is_integral<T>::value && std::is_signed<T>::value && sizeof(T) == 4) {
+        const __m256i vthr = _mm256_set1_epi32(static_cast<int32_t>(threshold));
+        const __m256i vrow_len = _mm256_set1_epi32(static_cast<int32_t>(rowLen));
+        for(; i + 8 <= row_indices.size(); i += 8) {
+            __m256i vrows = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(&row_indices[i]));
+            __m256i voffsets = _mm256_mullo_epi32(vrows, vrow_len);
+            __m256i vals = _mm256_i32gather_epi32(reinterpret_cast<const int*>(elem_base), voffsets, 1);
+            // val >= threshold is the complement of threshold > val
+            int lt_mask = _mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpgt_epi32(vthr, vals)));
+            count += 8 - __builtin_popcount(lt_mask);
+        }
+    } else if constexpr(std::is_integral<T>::value && std::is_signed<T>::value && sizeof(T) == 8) {
+        const __m256i vthr = _mm256_set1_epi64x(static_cast<int64_t>(threshold));
+        const __m128i vrow_len = _mm_set1_epi32(static_cast<int32_t>(rowLen));
+        for(; i + 4 <= row_indices.size(); i += 4) {
+            __m128i vrows = _mm_loadu_si128(reinterpret_cast<const __m128i*>(&row_indices[i]));
+            __m128i voffsets = _mm_mullo_epi32(vrows, vrow_len);
+            __m256i vals = _mm256_i32gather_epi64(reinterpret_cast<const long long*>(elem_base), voffsets, 1);
+            int lt_mask = _mm256_movemask_pd(_mm256_castsi256_pd(_mm256_cmpgt_epi64(vthr, vals)));
+            count += 4 - __builtin_popcount(lt_mask);
+        }
+    }
+#endif
+    for(; i < row_indices.size(); ++i) {
+        const T val = *reinterpret_cast<const volatile T*>(elem_base + row_indices[i] * rowLen);
+        if(val >= threshold) {
+            ++count;
+        }
+    }
+    return count;
+}
+
+}  // namespace detail
+
+/**
+ * Layout options for SST fields. Row-major fields are stored inline in each
+ * node's row, which makes pushing a whole row one contiguous RDMA write.
+ * Column-major fields store all nodes' entries for the field contiguously
+ * (struct-of-arrays), so cross-row aggregation scans like min_over_rows()
+ * read sequential memory instead of one cache line per row.
+ */
+enum class FieldLayout { row_major, column_major };
+
 /** Internal helper class, never exposed to the client. */
 class _SSTField {
 public:
     volatile char* base;
     size_t rowLen;
     size_t field_len;
+    /** True if this field uses the column-major (struct-of-arrays) layout. */
+    bool column_major;
 
-    _SSTField(const size_t field_len) : base(nullptr), rowLen(0), field_len(field_len) {}
+    _SSTField(const size_t field_len, const bool column_major = false)
+            : base(nullptr), rowLen(0), field_len(field_len), column_major(column_major) {}
 
     size_t set_base(volatile char* const base) {
         this->base = base;
@@ -70,7 +202,8 @@ public:
     using _SSTField::field_len;
     using _SSTField::rowLen;
 
-    SSTField() : _SSTField(sizeof(T)) {
+    SSTField(FieldLayout layout = FieldLayout::row_major)
+            : _SSTField(sizeof(T), layout == FieldLayout::column_major) {
     }
 
     // Tracks down the appropriate row
@@ -83,6 +216,17 @@ public:
 
     // Setter
     void operator()(const size_t row_idx, T const v) { *(T*)(base + row_idx * rowLen) = v; }
+
+    /** Computes the minimum value of this field across the given rows,
+     * using a vectorized strided scan when the element type supports it. */
+    T min_over_rows(const std::vector<uint32_t>& row_indices) const {
+        return detail::min_over_rows_scan<T>(const_cast<const char*>(base), rowLen, row_indices);
+    }
+
+    /** Counts how many of the given rows have a value of this field >= threshold. */
+    size_t count_geq(const std::vector<uint32_t>& row_indices, const T& threshold) const {
+        return detail::count_geq_scan<T>(const_cast<const char*>(base), rowLen, row_indices, threshold);
+    }
 };
 
 /**
@@ -102,7 +246,9 @@ public:
     using _SSTField::rowLen;
     using value_type = T;
 
-    SSTFieldVector(size_t num_elements) : _SSTField(num_elements * sizeof(T)), length(num_elements) {
+    SSTFieldVector(size_t num_elements, FieldLayout layout = FieldLayout::row_major)
+            : _SSTField(num_elements * sizeof(T), layout == FieldLayout::column_major),
+              length(num_elements) {
     }
 
     // Tracks down the appropriate row
@@ -111,6 +257,21 @@ public:
     /** Just like std::vector::size(), returns the number of elements in this vector. */
     size_t size() const { return length; }
 
+    /** Computes the minimum of element elem_index of this field across the
+     * given rows, using a vectorized strided scan when the element type
+     * supports it. */
+    T min_over_rows(const std::vector<uint32_t>& row_indices, const size_t elem_index) const {
+        return detail::min_over_rows_scan<T>(const_cast<const char*>(base) + elem_index * sizeof(T),
+                                             rowLen, row_indices);
+    }
+
+    /** Counts how many of the given rows have element elem_index >= threshold. */
+    size_t count_geq(const std::vector<uint32_t>& row_indices, const size_t elem_index,
+                     const T& threshold) const {
+        return detail::count_geq_scan<T>(const_cast<const char*>(base) + elem_index * sizeof(T),
+                                         rowLen, row_indices, threshold);
+    }
+
     void __attribute__((noinline)) debug_print(size_t row_num) {
         volatile T* arr = (*this)[row_num];
         for(size_t j = 0; j < length; ++j) {
@@ -120,6 +281,97 @@ public:
     }
 };
 
+/**
+ * A seqlock-protected SST field: a trivially-copyable payload bracketed by
+ * two sequence counters that live in the row and travel with it on every
+ * push, so readers can take torn-read-free snapshots of several coupled
+ * values without per-field volatile discipline or ad-hoc write ordering.
+ *
+ * The writer (only ever the owner of the local row) bumps the leading
+ * counter, updates the payload, then bumps the trailing counter. On the
+ * local node x86 store ordering plus the compiler fences keep those stores
+ * in program order; on remote nodes an RDMA write places bytes in ascending
+ * address order, which is the same ordering assumption the multicast slots
+ * already rely on (payload before the higher-addressed seq_num). A reader
+ * therefore reads the trailing counter, copies the payload, and re-checks
+ * the leading counter: if both counters match, no write was in flight
+ * anywhere in between and the copy is a consistent snapshot.
+ *
+ * The whole field - leading counter through trailing counter, field_len
+ * bytes - must be pushed in a single put() so the ordering holds remotely.
+ */
+template <typename T>
+class SSTSeqlockField : public _SSTField {
+    static_assert(std::is_trivially_copyable<T>::value,
+                  "SSTSeqlockField payload must be trivially copyable");
+
+public:
+    using _SSTField::base;
+    using _SSTField::field_len;
+    using _SSTField::rowLen;
+    using value_type = T;
+
+    SSTSeqlockField()
+            : _SSTField(2 * sizeof(uint64_t) + padded_len(sizeof(T))) {
+    }
+
+    /** Direct access to the payload, outside the seqlock protocol (e.g. for
+     * initialization before the SST is shared). */
+    volatile T& payload(const size_t row_idx) const {
+        return *(T*)(base + row_idx * rowLen + sizeof(uint64_t));
+    }
+
+    /**
+     * Publish a new payload value in the local row. Must be called by a
+     * single writer at a time, like every other local-row update.
+     */
+    void write(const size_t row_idx, const T& value) {
+        volatile uint64_t* lead = (uint64_t*)(base + row_idx * rowLen);
+        volatile uint64_t* trail = (uint64_t*)(base + row_idx * rowLen + sizeof(uint64_t) + padded_len(sizeof(T)));
+        const uint64_t seq = *lead + 1;
+        *lead = seq;
+        std::atomic_signal_fence(std::memory_order_seq_cst);
+        memcpy(const_cast<char*>(base + row_idx * rowLen + sizeof(uint64_t)), &value, sizeof(T));
+        std::atomic_signal_fence(std::memory_order_seq_cst);
+        *trail = seq;
+    }
+
+    /**
+     * One snapshot attempt: copy the payload of the given row into 'out' and
+     * report whether the copy is consistent. A false return means a write
+     * was being applied (locally or by an in-flight RDMA push) and the
+     * caller should retry or come back later.
+     */
+    bool try_read(const size_t row_idx, T& out) const {
+        const volatile uint64_t* lead = (const uint64_t*)(base + row_idx * rowLen);
+        const volatile uint64_t* trail = (const uint64_t*)(base + row_idx * rowLen + sizeof(uint64_t) + padded_len(sizeof(T)));
+        const uint64_t seen = *trail;
+        std::atomic_signal_fence(std::memory_order_seq_cst);
+        memcpy(&out, const_cast<const char*>(base + row_idx * rowLen + sizeof(uint64_t)), sizeof(T));
+        std::atomic_signal_fence(std::memory_order_seq_cst);
+        return seen == *lead;
+    }
+
+    /** Spin until a consistent snapshot of the given row is taken. */
+    T read(const size_t row_idx) const {
+        T out;
+        while(!try_read(row_idx, out)) {
+        }
+        return out;
+    }
+};
+
+/**
+ * A zero-length pseudo-field that rounds the row layout up to the next
+ * cache-line boundary. Placing one in the SSTInit argument list splits the
+ * row into cache-line-aligned sections, so that fields written at very
+ * different rates (per-message delivery state vs. view-change state, say)
+ * never share a line: a remote update to one section cannot evict the lines
+ * a predicate scan of the other section is polling. It contributes nothing
+ * to the row beyond the alignment padding and is never read or pushed.
+ */
+class SSTCacheLineBoundary {};
+
 typedef std::function<void(uint32_t)> failure_upcall_t;
 
 /** Constructor parameter pack for SST. */
@@ -164,11 +416,41 @@ private:
     template <typename... Fields>
     void init_SSTFields(Fields&... fields) {
         rowLen = 0;
-        compute_rowLen(rowLen, fields...);
-        rows = new char[rowLen * num_members];
+        columnLen = 0;
+        compute_lens(rowLen, columnLen, fields...);
+        // round the row length up to a whole number of cache lines, so every
+        // row (and the column-major blocks after them) starts on a line
+        // boundary and the in-row alignment established by any
+        // SSTCacheLineBoundary markers holds in every row
+        rowLen = cacheline_padded_len(rowLen);
+        tableLen = (rowLen + columnLen) * num_members;
+        rows = nullptr;
+        if(derecho::getConfBoolean(CONF_DERECHO_USE_HUGEPAGES)) {
+            rows = derecho::try_hugepage_alloc(tableLen);
+            rows_hugepage_backed = (rows != nullptr);
+        }
+        if(rows == nullptr) {
+            // cache-line-align the table itself; the hugepage path is
+            // page-aligned already
+            rows = static_cast<char*>(::operator new[](tableLen, std::align_val_t(CACHE_LINE_SIZE)));
+        }
+        // keep the table on the NIC-local socket if the user asked for it
+        derecho::bind_to_numa_node(const_cast<char*>(rows), tableLen,
+                                   derecho::getConfInt32(CONF_DERECHO_SST_NUMA_NODE));
+        dirty_tracking_enabled = derecho::getConfBoolean(CONF_DERECHO_SST_DIRTY_TRACKING);
+        if(dirty_tracking_enabled) {
+            // the shadow starts uninitialized; shadow_valid records which of
+            // its blocks a push has actually filled, so the skip check in
+            // put() never compares against unpushed garbage
+            last_pushed = new char[tableLen];
+            const size_t num_blocks = (tableLen + SHADOW_BLOCK_SIZE - 1) / SHADOW_BLOCK_SIZE;
+            shadow_valid.assign((num_blocks + 63) / 64, 0);
+        }
         // snapshot = new char[rowLen * num_members];
         volatile char* base = rows;
-        set_bases_and_rowLens(base, rowLen, fields...);
+        // column-major blocks live after all the row-major rows
+        volatile char* column_base = rows + rowLen * num_members;
+        set_bases_and_rowLens(base, column_base, rowLen, fields...);
     }
 
     DerivedSST* derived_this;
@@ -176,7 +458,24 @@ private:
     std::vector<std::thread> background_threads;
     std::atomic<bool> thread_shutdown;
 
-    void detect();
+    /** Body of one predicate evaluation thread; evaluates the predicates in
+     * the given shard of the Predicates object. */
+    void detect(uint32_t shard_index);
+
+    /**
+     * One pairwise sync barrier with a peer over the SST's own RDMA
+     * resources: increments this node's sync counter for the peer, pushes
+     * the 8-byte counter with a remote write, and polls the peer's mirror
+     * counter until it catches up. Returns false if the peer's row froze or
+     * the SST began shutting down before the peer arrived.
+     */
+    bool rdma_sync(uint32_t peer_index);
+    /**
+     * Syncs with one member: over RDMA when the peer's queue pair exists,
+     * otherwise over the TCP connection (which is all that exists before
+     * SSTInit has built the resources).
+     */
+    void member_sync(uint32_t peer_index) const;
 
 public:
     Predicates<DerivedSST> predicates;
@@ -185,11 +484,95 @@ public:
 private:
     /** timeout settings for poll completion queue */
     const uint32_t poll_cq_timeout_ms;
+    /** Whether the predicate thread should back off when no predicate fires. */
+    const bool idle_backoff_enabled;
+    /** Number of consecutive empty evaluation rounds to spin at full speed
+     * before the predicate thread starts descending the backoff ladder. */
+    const uint32_t idle_spin_rounds;
+    /**
+     * One worker of the push engine (DERECHO/sst_push_threads). When the
+     * pool is enabled, put() hands its per-receiver RDMA posts to these
+     * workers instead of posting them all from the calling thread, so a wide
+     * fan-out is posted from several cores. Receivers are sharded statically
+     * across the workers (receiver index mod pool size): every post to a
+     * given peer flows through one worker's FIFO queue, so the per-queue-pair
+     * ordering that same-thread put() calls rely on is preserved.
+     */
+    struct PushThread {
+        std::thread thread;
+        std::mutex queue_mutex;
+        std::condition_variable queue_cv;
+        /** A pending post: one (offset, size) range, or a shared list of
+         * gather segments from put_segments() when segments is non-null. */
+        struct PushTask {
+            uint32_t receiver;
+            size_t offset;
+            size_t size;
+            std::shared_ptr<const std::vector<std::pair<size_t, size_t>>> segments;
+        };
+        std::deque<PushTask> queue;
+        /** Nonzero while a dequeued task is still being posted, so
+         * flush_pushes() waits for posts in flight, not just an empty queue. */
+        size_t in_flight = 0;
+        std::condition_variable drained_cv;
+    };
+    /** Size of the push pool; 0 posts inline from the calling thread. */
+    const uint32_t num_push_threads;
+    std::vector<std::unique_ptr<PushThread>> push_threads;
+
+    /** Body of one push-engine worker. */
+    void push_worker(uint32_t worker_index);
+    /** Hands one per-receiver post to the worker that owns the receiver. */
+    void enqueue_push(uint32_t receiver, size_t offset, size_t size,
+                      std::shared_ptr<const std::vector<std::pair<size_t, size_t>>> segments = nullptr);
     /** Pointer to memory where the SST rows are stored. */
     volatile char* rows;
+    /** True if rows came from try_hugepage_alloc rather than aligned new. */
+    bool rows_hugepage_backed = false;
+    /** Whether puts should skip ranges whose bytes haven't changed since the
+     * last push to all rows (DERECHO/sst_dirty_tracking). */
+    bool dirty_tracking_enabled = false;
+    /** Shadow copy of the bytes most recently pushed to all rows, used to
+     * detect and skip redundant pushes. Only the local row's (and local
+     * column entries') offsets are ever touched, so despite being tableLen
+     * bytes long its physical footprint is one row. */
+    char* last_pushed = nullptr;
+    /** Granularity of shadow-validity tracking, one bit per block. */
+    static constexpr size_t SHADOW_BLOCK_SIZE = 64;
+    /** One bit per SHADOW_BLOCK_SIZE-byte block of the table, set once a
+     * push has filled that block's shadow bytes. A range is only eligible
+     * for the redundant-push skip when all its blocks are set; until then
+     * the shadow holds uninitialized memory that may coincidentally equal
+     * the table (fresh allocations are commonly zero pages), and skipping
+     * on such a match would leave the remote copy unwritten. */
+    std::vector<uint64_t> shadow_valid;
     // char* snapshot;
-    /** Length of each row in this SST, in bytes. */
+    /** Length of each row in this SST, in bytes (row-major fields only). */
     size_t rowLen;
+    /** Per-node bytes occupied by column-major fields, in bytes. */
+    size_t columnLen;
+    /** Total size of the table (row-major rows plus column-major blocks). */
+    size_t tableLen;
+    /** Table-absolute (offset, size) of the local node's entry in each
+     * column-major field, so full-row puts can push them too. */
+    std::vector<std::pair<size_t, size_t>> local_column_segments;
+    /** Row-relative (offset, size) ranges of the fields designated pull-mode
+     * with set_pull_mode, sorted by offset. Empty unless pull mode is used. */
+    std::vector<std::pair<size_t, size_t>> pull_mode_ranges;
+    /** The complement of pull_mode_ranges within [0, rowLen): the segments a
+     * full-row put pushes when at least one field is pull-mode. */
+    std::vector<std::pair<size_t, size_t>> push_row_segments;
+    /** Records a pull-mode byte range and recomputes push_row_segments. */
+    void add_pull_mode_range(size_t offset, size_t size);
+    /** Per-thread write-combining state for CoalescedPutsGuard: the collected
+     * put ranges, grouped by receiver set. Thread-local so the detect threads
+     * and the sender thread can each coalesce independently. */
+    struct PutBatchState {
+        /** The SST instance currently coalescing on this thread, or nullptr. */
+        const void* owner = nullptr;
+        std::vector<std::pair<std::vector<uint32_t>, std::vector<std::pair<size_t, size_t>>>> groups;
+    };
+    static thread_local PutBatchState put_batch;
     /** List of nodes in the SST; indexes are row numbers, values are node IDs. */
     const std::vector<uint32_t>& members;
     /** Equal to members.size() */
@@ -209,6 +592,17 @@ private:
     std::vector<bool> row_is_frozen;
     /** The number of rows that have been frozen. */
     int num_frozen{0};
+    /** Internal per-peer sync counters, appended to the row by SSTInit.
+     * Entry p of this node's row counts the pairwise syncs completed with
+     * member p; a sync barrier is an increment pushed to the peer with a
+     * tiny RDMA write, then a poll of the peer's mirror entry. Replaces the
+     * TCP exchange in sync_with_members once queue pairs exist. */
+    SSTFieldVector<uint64_t> rdma_sync_slots;
+    /** Counts put() calls that actually posted remote writes. The failure-
+     * checking thread samples this to tell whether data traffic already
+     * served as liveness evidence since its last tick, in which case a
+     * heartbeat-only push would be redundant. */
+    std::atomic<uint64_t> puts_posted{0};
     /** The function to call when a remote node appears to have failed. */
     failure_upcall_t failure_upcall;
     /** Mutex for failure detection and row freezing. */
@@ -229,12 +623,16 @@ public:
     SST(DerivedSST* derived_class_pointer, const SSTParams& params)
             : derived_this(derived_class_pointer),
               thread_shutdown(false),
-              poll_cq_timeout_ms(derecho::getConfUInt32(CONF_DERECHO_SST_POLL_CQ_TIMEOUT_MS)),
+              poll_cq_timeout_ms(derecho::getConfSnapshot().sst_poll_cq_timeout_ms),
+              idle_backoff_enabled(derecho::getConfSnapshot().sst_idle_backoff),
+              idle_spin_rounds(derecho::getConfSnapshot().sst_idle_spin_rounds),
+              num_push_threads(derecho::getConfUInt32(CONF_DERECHO_SST_PUSH_THREADS)),
               members(params.members),
               num_members(members.size()),
               all_indices(num_members),
               my_node_id(params.my_node_id),
               row_is_frozen(num_members),
+              rdma_sync_slots(params.members.size()),
               failure_upcall(params.failure_upcall),
               res_vec(num_members),
               thread_start(params.start_predicate_thread) {
@@ -268,34 +666,52 @@ public:
 
     template <typename... Fields>
     void SSTInit(Fields&... fields) {
-        //Initialize rows and set the "base" field of each SSTField
-        init_SSTFields(fields...);
+        //Initialize rows and set the "base" field of each SSTField; the
+        //internal sync slots ride at the end of the row
+        init_SSTFields(fields..., rdma_sync_slots);
+        //The table starts uninitialized, and the sync counters must begin
+        //at zero on both sides of every pair. Zeroing happens before the
+        //memory is registered below, so no remote write can race with it.
+        for(unsigned int row = 0; row < num_members; ++row) {
+            for(unsigned int peer = 0; peer < num_members; ++peer) {
+                rdma_sync_slots[row][peer] = 0;
+            }
+        }
 
-        //Initialize res_vec with the correct offsets for each row
+        //Initialize res_vec; each pair registers the whole table, and writers
+        //address their own row (and column-major entries) by table offset
         unsigned int node_rank, sst_index;
         for(auto const& rank_index : members_by_id) {
             std::tie(node_rank, sst_index) = rank_index;
-            char *write_addr, *read_addr;
-            write_addr = const_cast<char*>(rows) + rowLen * sst_index;
-            read_addr = const_cast<char*>(rows) + rowLen * my_index;
+            char* table_addr = const_cast<char*>(rows);
             if(sst_index != my_index) {
                 if(row_is_frozen[sst_index]) {
                     continue;
                 }
 #ifdef USE_VERBS_API
                 res_vec[sst_index] = std::make_unique<resources>(
-                        node_rank, write_addr, read_addr, rowLen, rowLen);
+                        node_rank, table_addr, table_addr, tableLen, tableLen);
 #else  // use libfabric api by default
                 res_vec[sst_index] = std::make_unique<resources>(
-                        node_rank, write_addr, read_addr, rowLen, rowLen, (my_node_id < node_rank));
+                        node_rank, table_addr, table_addr, tableLen, tableLen, (my_node_id < node_rank));
 #endif
                 // update qp_num_to_index
                 // qp_num_to_index[res_vec[sst_index].get()->qp->qp_num] = sst_index;
             }
         }
 
-        std::thread detector(&SST::detect, this);
-        background_threads.push_back(std::move(detector));
+        // one evaluation thread per predicate shard (usually just one)
+        for(uint32_t shard_index = 0; shard_index < predicates.num_shards(); ++shard_index) {
+            background_threads.emplace_back(&SST::detect, this, shard_index);
+        }
+
+        // the push engine's workers, started only after res_vec is populated
+        for(uint32_t worker = 0; worker < num_push_threads; ++worker) {
+            push_threads.emplace_back(std::make_unique<PushThread>());
+        }
+        for(uint32_t worker = 0; worker < num_push_threads; ++worker) {
+            push_threads[worker]->thread = std::thread(&SST::push_worker, this, worker);
+        }
     }
 
     ~SST();
@@ -303,7 +719,14 @@ public:
     /** Starts the predicate evaluation loop. */
     void start_predicate_evaluation();
 
-    /** Does a TCP sync with each member of the SST. */
+    /** Acts as a barrier across all live members of the SST, built on
+     * pairwise syncs. Each pairwise sync runs over the SST's own RDMA
+     * resources (a tiny counter write plus polling) once queue pairs exist,
+     * falling back to the TCP connection otherwise, so the barrier adds no
+     * TCP round trips to the view-change critical path. Small groups sync
+     * all-to-all; large groups use a two-level tree of sqrt(n)-sized leader
+     * groups, which cuts the per-node exchange count from n-1 to about
+     * 2*sqrt(n). */
     void sync_with_members() const;
 
     /** Syncs with a subset of the members */
@@ -316,6 +739,9 @@ public:
     /** Returns the total number of rows in the table. */
     unsigned int get_num_rows() const { return num_members; }
 
+    /** Returns the number of put() calls that have posted remote writes. */
+    uint64_t get_puts_posted() const { return puts_posted.load(std::memory_order_relaxed); }
+
     /** Gets the index of the local row in the table. */
     unsigned int get_local_index() const { return my_index; }
 
@@ -325,19 +751,34 @@ public:
 
     /** Writes the entire local row to all remote nodes. */
     void put() {
-        put(all_indices, 0, rowLen);
+        put(all_indices);
     }
 
     void put_with_completion() {
-        put_with_completion(all_indices, 0, rowLen);
+        put_with_completion(all_indices);
     }
 
     /** Writes the entire local row to some of the remote nodes. */
     void put(const std::vector<uint32_t> receiver_ranks) {
-        put(receiver_ranks, 0, rowLen);
+        if(pull_mode_ranges.empty()) {
+            put(receiver_ranks, 0, rowLen);
+        } else if(!push_row_segments.empty()) {
+            // pull-mode fields are excluded from the steady-state fan-out;
+            // their readers fetch them on demand with pull()
+            put_segments(receiver_ranks, push_row_segments);
+        }
+        for(const auto& segment : local_column_segments) {
+            put(receiver_ranks, segment.first, segment.second);
+        }
     }
 
     void put_with_completion(const std::vector<uint32_t> receiver_ranks) {
+        // column segments are pushed unsignaled first; RDMA writes on the
+        // same queue pair are ordered, so the signaled row write that
+        // follows also confirms their delivery
+        for(const auto& segment : local_column_segments) {
+            put(receiver_ranks, segment.first, segment.second);
+        }
         put_with_completion(receiver_ranks, 0, rowLen);
     }
 
@@ -349,22 +790,20 @@ public:
     /** Writes a specific local field to all remote nodes */
     template <typename T>
     void put(SSTField<T>& field) {
-        put(all_indices, field.get_base() - getBaseAddress(), sizeof(field[0]));
+        put(all_indices, field_offset(field, 0), sizeof(field[0]));
     }
 
     /** Writes a specific local vector field to all remote nodes. */
     template <typename T>
     void put(SSTFieldVector<T>& vec_field) {
-        put(all_indices, vec_field.get_base() - getBaseAddress(),
+        put(all_indices, field_offset(vec_field, 0),
             sizeof(vec_field[0][0]) * vec_field.size());
     }
 
     /** Writes only a single element of a vector field to all remote nodes */
     template <typename T>
     void put(SSTFieldVector<T>& vec_field, std::size_t index) {
-        put(all_indices,
-            const_cast<char*>(reinterpret_cast<volatile char*>(std::addressof(vec_field[0][index])))
-                    - getBaseAddress(),
+        put(all_indices, field_offset(vec_field, index * sizeof(T)),
             sizeof(vec_field[0][index]));
     }
 
@@ -372,12 +811,24 @@ public:
     template <typename T>
     void put(const std::vector<uint32_t> receiver_ranks,
              SSTFieldVector<T>& vec_field, std::size_t index) {
-        put(receiver_ranks,
-            const_cast<char*>(reinterpret_cast<volatile char*>(std::addressof(vec_field[0][index])))
-                    - getBaseAddress(),
+        put(receiver_ranks, field_offset(vec_field, index * sizeof(T)),
             sizeof(vec_field[0][index]));
     }
 
+    /** Writes a contiguous range of elements of a vector field to all remote nodes. */
+    template <typename T>
+    void put(SSTFieldVector<T>& vec_field, std::size_t start_index, std::size_t num_elements) {
+        put(all_indices, vec_field, start_index, num_elements);
+    }
+
+    /** Writes a contiguous range of elements of a vector field to only some of the remote nodes. */
+    template <typename T>
+    void put(const std::vector<uint32_t> receiver_ranks, SSTFieldVector<T>& vec_field,
+             std::size_t start_index, std::size_t num_elements) {
+        put(receiver_ranks, field_offset(vec_field, start_index * sizeof(T)),
+            num_elements * sizeof(T));
+    }
+
     void put_with_completion(size_t offset, size_t size) {
         put_with_completion(all_indices, offset, size);
     }
@@ -385,39 +836,227 @@ public:
     /** Writes a specific local field to all remote nodes */
     template <typename T>
     void put_with_completion(SSTField<T>& field) {
-        put_with_completion(all_indices, field.get_base() - getBaseAddress(), sizeof(field[0]));
+        put_with_completion(all_indices, field_offset(field, 0), sizeof(field[0]));
     }
 
     /** Writes a specific local vector field to all remote nodes. */
     template <typename T>
     void put_with_completion(SSTFieldVector<T>& vec_field) {
-        put_with_completion(all_indices, vec_field.get_base() - getBaseAddress(),
+        put_with_completion(all_indices, field_offset(vec_field, 0),
             sizeof(vec_field[0][0]) * vec_field.size());
     }
 
+    /**
+     * Designates a row-major field as pull-mode: full-row put() calls skip
+     * its bytes, so its updates cost no steady-state push fan-out, and
+     * interested readers fetch it on demand with pull(). Call after SSTInit
+     * and before the table is in active use; every node must designate the
+     * same fields, since the skipped byte ranges must agree across the
+     * group. An explicit put(field) of a pull-mode field still pushes it,
+     * and the periodic full-row put_with_completion heartbeat still covers
+     * the whole row, so pull-mode fields are never more stale than the last
+     * heartbeat even with no reader pulling.
+     */
+    template <typename T>
+    void set_pull_mode(SSTField<T>& field) {
+        assert(!field.column_major);
+        add_pull_mode_range(field_offset(field, 0), sizeof(field[0]));
+    }
+
+    /** Designates a row-major vector field as pull-mode; see the
+     * SSTField overload. */
+    template <typename T>
+    void set_pull_mode(SSTFieldVector<T>& vec_field) {
+        assert(!vec_field.column_major);
+        add_pull_mode_range(field_offset(vec_field, 0),
+                            sizeof(vec_field[0][0]) * vec_field.size());
+    }
+
+    /**
+     * Fetches the given field's entry in one remote row with a one-sided
+     * RDMA read, blocking until the data has landed in the local table (or
+     * the CQ poll timeout expires). Works for any row-major field but is
+     * intended for pull-mode ones, whose rows are not pushed by their
+     * owners.
+     * @return true if the read completed, false on timeout
+     */
+    template <typename T>
+    bool pull(SSTField<T>& field, uint32_t row_index) {
+        return pull_bytes(field_offset(field, 0), sizeof(field[0]),
+                          std::vector<uint32_t>{row_index});
+    }
+
+    /** Batched variant of pull(): posts one RDMA read per requested row
+     * back-to-back, then waits for all of them. */
+    template <typename T>
+    bool pull(SSTField<T>& field, const std::vector<uint32_t>& row_indices) {
+        return pull_bytes(field_offset(field, 0), sizeof(field[0]), row_indices);
+    }
+
+    /** Fetches a vector field's entry in one remote row; see the SSTField
+     * overload of pull(). */
+    template <typename T>
+    bool pull(SSTFieldVector<T>& vec_field, uint32_t row_index) {
+        return pull_bytes(field_offset(vec_field, 0),
+                          sizeof(vec_field[0][0]) * vec_field.size(),
+                          std::vector<uint32_t>{row_index});
+    }
+
+    /** Batched variant of pull() for vector fields. */
+    template <typename T>
+    bool pull(SSTFieldVector<T>& vec_field, const std::vector<uint32_t>& row_indices) {
+        return pull_bytes(field_offset(vec_field, 0),
+                          sizeof(vec_field[0][0]) * vec_field.size(), row_indices);
+    }
+
+    /**
+     * Underlying implementation of pull(): issues a one-sided RDMA read of
+     * the given row-relative byte range from each requested row's owner (a
+     * row lives at the same table offset on every node, so local and remote
+     * addresses coincide), then waits for all the completions. The local row
+     * and frozen rows are skipped.
+     * @return true if every posted read completed, false if any timed out
+     */
+    bool pull_bytes(size_t offset, size_t size, const std::vector<uint32_t>& row_indices);
+
+    /**
+     * RAII guard that turns on write combining for the calling thread. While
+     * it is alive, put() calls made by this thread on this SST are collected
+     * instead of posted; the destructor merges adjacent and overlapping byte
+     * ranges and flushes each distinct receiver set with a single (gather)
+     * RDMA write. Use it around trigger code that updates several fields in
+     * one epoch, e.g. num_received, seq_num, and delivered_num.
+     */
+    class CoalescedPutsGuard {
+        SST& sst;
+
+    public:
+        explicit CoalescedPutsGuard(SST& sst) : sst(sst) {
+            sst.begin_coalescing_puts();
+        }
+        ~CoalescedPutsGuard() {
+            sst.flush_coalesced_puts();
+        }
+        CoalescedPutsGuard(const CoalescedPutsGuard&) = delete;
+        CoalescedPutsGuard& operator=(const CoalescedPutsGuard&) = delete;
+    };
+
+    /** Starts collecting this thread's put() calls; see CoalescedPutsGuard. */
+    void begin_coalescing_puts();
+
+    /** Merges and posts the put() calls collected since
+     * begin_coalescing_puts(), and ends the collection. */
+    void flush_coalesced_puts();
+
+    /** Writes several discontiguous (offset, size) segments of the local row
+     * to all remote nodes, using a single gather write per receiver. */
+    void put_segments(const std::vector<std::pair<size_t, size_t>>& segments) {
+        put_segments(all_indices, segments);
+    }
+
+    /** Writes several discontiguous (offset, size) segments of the local row
+     * to some of the remote nodes, using a single gather write per receiver. */
+    void put_segments(const std::vector<uint32_t> receiver_ranks,
+                      const std::vector<std::pair<size_t, size_t>>& segments);
+
     /** Writes a contiguous subset of the local row to some of the remote nodes. */
     void put(const std::vector<uint32_t> receiver_ranks, size_t offset, size_t size);
 
+    /**
+     * Non-blocking variant of put(): attempts to post the write to every
+     * receiver, but where put() would spin waiting for space in a full NIC
+     * transmit queue, this returns false so the caller can back off and
+     * retry (or coalesce) instead of stalling. Receivers whose queues had
+     * room have already been posted to when this returns false; since a put
+     * pushes current table state, simply retrying the whole call is correct.
+     * When the push engine is enabled the write is queued to the push
+     * workers, which absorb the backpressure instead, and this returns true.
+     * @return true if the write was posted (or queued) to every receiver
+     */
+    bool try_put(const std::vector<uint32_t> receiver_ranks, size_t offset, size_t size);
+
+    /**
+     * Blocks until every post queued to the push engine has been handed to
+     * the NIC. A no-op when the push engine is disabled. put_with_completion
+     * calls this before posting, so its completion still confirms all of the
+     * calling thread's earlier put() calls.
+     */
+    void flush_pushes();
+
+    /** Non-blocking put of a contiguous subset of the local row to all rows. */
+    bool try_put(size_t offset, size_t size) {
+        return try_put(all_indices, offset, size);
+    }
+
     void put_with_completion(const std::vector<uint32_t> receiver_ranks, size_t offset, size_t size);
 
 private:
     using char_p = volatile char*;
 
-    void compute_rowLen(size_t&) {}
+    void compute_lens(size_t&, size_t&) {}
 
     template <typename Field, typename... Fields>
-    void compute_rowLen(size_t& rowLen, Field& f, Fields&... rest) {
-        rowLen += padded_len(f.field_len);
-        compute_rowLen(rowLen, rest...);
+    void compute_lens(size_t& rowLen, size_t& columnLen, Field& f, Fields&... rest) {
+        if(f.column_major) {
+            // column-major entries get a full cache line per member, so two
+            // members' entries in these (by definition hot) fields never
+            // false-share a line
+            columnLen += cacheline_padded_len(f.field_len);
+        } else {
+            rowLen += padded_len(f.field_len);
+        }
+        compute_lens(rowLen, columnLen, rest...);
     }
 
-    void set_bases_and_rowLens(char_p&, const size_t) {}
+    template <typename... Fields>
+    void compute_lens(size_t& rowLen, size_t& columnLen, SSTCacheLineBoundary&, Fields&... rest) {
+        rowLen = cacheline_padded_len(rowLen);
+        compute_lens(rowLen, columnLen, rest...);
+    }
+
+    void set_bases_and_rowLens(char_p&, char_p&, const size_t) {}
 
     template <typename Field, typename... Fields>
-    void set_bases_and_rowLens(char_p& base, const size_t rlen, Field& f, Fields&... rest) {
-        base += f.set_base(base);
-        f.set_rowLen(rlen);
-        set_bases_and_rowLens(base, rlen, rest...);
+    void set_bases_and_rowLens(char_p& base, char_p& column_base, const size_t rlen,
+                               Field& f, Fields&... rest) {
+        if(f.column_major) {
+            // the row "stride" of a column-major field is its own length
+            // rounded up to a whole cache line, so consecutive rows' entries
+            // are adjacent but never share a line (must match compute_lens)
+            const size_t stride = cacheline_padded_len(f.field_len);
+            f.set_base(column_base);
+            f.set_rowLen(stride);
+            local_column_segments.emplace_back(
+                    (column_base - rows) + my_index * stride, f.field_len);
+            column_base += stride * num_members;
+        } else {
+            base += f.set_base(base);
+            f.set_rowLen(rlen);
+        }
+        set_bases_and_rowLens(base, column_base, rlen, rest...);
+    }
+
+    template <typename... Fields>
+    void set_bases_and_rowLens(char_p& base, char_p& column_base, const size_t rlen,
+                               SSTCacheLineBoundary&, Fields&... rest) {
+        // skip forward to the next cache-line boundary within the row
+        // (must match the rounding compute_lens applied to rowLen)
+        base = rows + cacheline_padded_len(base - rows);
+        set_bases_and_rowLens(base, column_base, rlen, rest...);
+    }
+
+    /**
+     * Computes the offset to pass to put() for a byte range within the local
+     * node's entry of a field, accounting for the field's layout: row-major
+     * offsets are row-relative, column-major offsets are table-absolute.
+     */
+    template <typename Field>
+    size_t field_offset(Field& f, const size_t offset_within_entry) const {
+        size_t offset = f.get_base() - const_cast<const char*>(rows) + offset_within_entry;
+        if(f.column_major) {
+            offset += my_index * f.rowLen;
+        }
+        return offset;
     }
 
     // void take_snapshot() {
@@ -434,6 +1073,9 @@ private:
     // }
 };
 
+template <class DerivedSST>
+thread_local typename SST<DerivedSST>::PutBatchState SST<DerivedSST>::put_batch;
+
 } /* namespace sst */
 
 #include "detail/sst_impl.hpp"
@@ -4,6 +4,8 @@
 #include <memory>
 #include <string>
 #include <optional>
+#include <tuple>
+#include <sys/uio.h>
 
 namespace tcp {
 
@@ -71,6 +73,19 @@ public:
      */
     bool read(char* buffer, size_t size);
 
+    /**
+     * Reads bytes from the socket into a sequence of scatter buffers, with
+     * the same effect as calling read() on each buffer in order but using as
+     * few readv() system calls as possible (usually one).
+     * @param buffers A pointer to an array of iovec structs describing the
+     * destination buffers. The array is modified while tracking progress, so
+     * it should not be reused after the call.
+     * @param buffer_count The number of entries in the iovec array.
+     * @return True if every buffer was filled, false if there was an error
+     * before all of the bytes could be read.
+     */
+    bool read_scatter(struct iovec* buffers, std::size_t buffer_count);
+
     /**
      * Attempts to read up to max_size bytes from socket and write them to the
      * given buffer, but returns immediately even if fewer than max_size bytes
@@ -96,6 +111,34 @@ public:
      */
     bool write(const char* buffer, size_t size);
 
+    /**
+     * Writes a sequence of gather buffers to the socket, with the same effect
+     * as calling write() on each buffer in order but using as few writev()
+     * system calls as possible (usually one). This avoids both per-buffer
+     * syscall overhead and Nagle-related delays between the buffers, so a
+     * size-prefixed message can be sent as a single segment.
+     * @param buffers A pointer to an array of iovec structs describing the
+     * source buffers. The array is modified while tracking progress, so it
+     * should not be reused after the call.
+     * @param buffer_count The number of entries in the iovec array.
+     * @return True if every buffer was sent, false if there was an error
+     * before all of the bytes could be written.
+     */
+    bool write_gather(struct iovec* buffers, std::size_t buffer_count);
+
+    /**
+     * Writes size bytes from an open file directly to the socket with the
+     * sendfile() system call, so the bytes are copied in the kernel and
+     * never pass through a userspace buffer. The file's own offset is not
+     * used or changed.
+     * @param fd A descriptor for the file to send from.
+     * @param offset The byte offset in the file at which to start reading.
+     * @param size The number of bytes to send.
+     * @return True if the write was successful, false if there was an error
+     * before size bytes could be sent.
+     */
+    bool write_from_file(int fd, uint64_t offset, size_t size);
+
     /**
      * Convenience method for sending a single POD object (e.g. an int) over
      * the socket.
@@ -116,6 +159,34 @@ public:
         return read(reinterpret_cast<char*>(&obj), sizeof(obj));
     }
 
+    /**
+     * Convenience method for sending several POD objects over the socket in
+     * a single gather write. Equivalent to calling write(obj) on each
+     * argument in order, but with one system call instead of one per object.
+     */
+    template <typename... T>
+    bool write_all(const T&... objs) {
+        static_assert((std::is_pod<T>::value && ...),
+                      "Can't send non-pod type over TCP");
+        struct iovec buffers[sizeof...(T)]
+                = {{const_cast<void*>(static_cast<const void*>(&objs)), sizeof(objs)}...};
+        return write_gather(buffers, sizeof...(T));
+    }
+
+    /**
+     * Convenience method for reading several POD objects from the socket in
+     * a single scatter read. Equivalent to calling read(obj) on each argument
+     * in order, but with one system call instead of one per object.
+     */
+    template <typename... T>
+    bool read_all(T&... objs) {
+        static_assert((std::is_pod<T>::value && ...),
+                      "Can't receive non-pod type over TCP");
+        struct iovec buffers[sizeof...(T)]
+                = {{static_cast<void*>(&objs), sizeof(objs)}...};
+        return read_scatter(buffers, sizeof...(T));
+    }
+
     template <class T>
     bool exchange(T local, T& remote) {
         static_assert(std::is_pod<T>::value,
@@ -128,6 +199,23 @@ public:
 
         return write((char*)&local, sizeof(T)) && read((char*)&remote, sizeof(T));
     }
+
+    /**
+     * Batch version of exchange() for several POD values at once: writes all
+     * of the local values with a single gather write, then reads all of the
+     * remote values with a single scatter read, so an entire protocol round
+     * costs one system call in each direction.
+     */
+    template <typename... T>
+    bool exchange(const std::tuple<T...>& local, std::tuple<T...>& remote) {
+        if(sock < 0) {
+            fprintf(stderr, "WARNING: Attempted to write to closed socket\n");
+            return false;
+        }
+
+        return std::apply([this](const T&... values) { return write_all(values...); }, local)
+               && std::apply([this](T&... values) { return read_all(values...); }, remote);
+    }
 };
 
 class connection_listener {
@@ -0,0 +1,85 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+
+namespace derecho {
+
+/**
+ * A single shared polling thread that drains every registered RDMA
+ * completion queue in one loop, instead of each subsystem (the SST
+ * connections, each RDMC rail) burning a core on a busy-poll thread of its
+ * own. Subsystems register a drain callback that consumes any ready
+ * completions and dispatches them to the subsystem's own handlers; the
+ * engine supplies the thread and an adaptive backoff ladder. While
+ * completions are flowing the loop spins at full speed; after a short idle
+ * period it yields the CPU between rounds, and once every source has been
+ * idle for much longer it blocks on the sources' completion-channel file
+ * descriptors (or sleeps in 1ms steps if any source cannot provide one).
+ * Any completion resets the ladder to spinning.
+ *
+ * The polling thread is pinned to DERECHO/poll_engine_cpu if that is set,
+ * falling back to DERECHO/sst_poll_thread_cpu so configurations written for
+ * the old dedicated SST polling thread keep working.
+ */
+class CompletionEngine {
+public:
+    /** Handle identifying a registered source, for deregistration. */
+    using source_id_t = uint64_t;
+
+    /**
+     * Registers a completion source with the engine, starting the polling
+     * thread if it is not already running.
+     * @param name A short name for the source, used only in debug logging
+     * @param drain Called repeatedly from the polling thread. It must
+     * consume any ready completions without blocking, hand them to the
+     * owning subsystem, and return the number it consumed (0 when the
+     * queue was empty).
+     * @param wait_fd A file descriptor that becomes readable when the
+     * source has new completions (e.g. the FI_WAIT_FD wait object of a
+     * libfabric completion queue), or -1 if the source cannot provide one.
+     * @return An id to pass to deregister_source()
+     */
+    source_id_t register_source(const std::string& name, std::function<int()> drain,
+                                int wait_fd = -1);
+
+    /**
+     * Removes a source from the engine; its drain callback will not be
+     * called again once this returns. Stops the polling thread if this was
+     * the last source (it restarts if another source registers later).
+     */
+    void deregister_source(source_id_t id);
+
+    /** The process-wide engine instance. */
+    static CompletionEngine& get();
+
+    ~CompletionEngine();
+
+private:
+    CompletionEngine() = default;
+
+    struct Source {
+        std::string name;
+        std::function<int()> drain;
+        int wait_fd;
+    };
+
+    /** Body of the polling thread. */
+    void polling_loop();
+
+    /** Guards sources and the polling thread handle. The polling thread
+     * holds it across each round of drain calls, so deregister_source can
+     * guarantee a removed callback is no longer running. */
+    std::mutex sources_mutex;
+    std::map<source_id_t, Source> sources;
+    source_id_t next_source_id = 0;
+    std::thread polling_thread;
+    std::atomic<bool> thread_shutdown{false};
+};
+
+}  // namespace derecho
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <cstddef>
+#include <sys/mman.h>
+
+#include "logger.hpp"
+
+namespace derecho {
+
+/** Size of the hugepages requested by try_hugepage_alloc (x86-64 default). */
+constexpr size_t hugepage_size = 2 * 1024 * 1024;
+
+/**
+ * Attempts to allocate a zeroed buffer of at least the given size backed by
+ * 2MB hugepages, which cuts TLB pressure for large, hot buffers like SST
+ * tables and multicast message slots. Returns nullptr if the kernel has no
+ * hugepages available (or MAP_HUGETLB is unsupported), in which case the
+ * caller should fall back to its regular allocation path. Buffers obtained
+ * here must be released with hugepage_free, not delete[].
+ *
+ * @param size The minimum number of bytes to allocate; the actual mapping is
+ *        rounded up to a multiple of the hugepage size.
+ * @return A pointer to the mapped buffer, or nullptr on failure.
+ */
+inline char* try_hugepage_alloc(const size_t size) {
+    const size_t rounded_size = ((size + hugepage_size - 1) / hugepage_size) * hugepage_size;
+    void* buffer = mmap(nullptr, rounded_size, PROT_READ | PROT_WRITE,
+                        MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+    if(buffer == MAP_FAILED) {
+        dbg_default_warn("Hugepage allocation of {} bytes failed; falling back to regular pages. "
+                         "Check /proc/sys/vm/nr_hugepages.",
+                         rounded_size);
+        return nullptr;
+    }
+    return static_cast<char*>(buffer);
+}
+
+/**
+ * Releases a buffer allocated by try_hugepage_alloc.
+ *
+ * @param buffer The pointer returned by try_hugepage_alloc.
+ * @param size The size originally requested from try_hugepage_alloc.
+ */
+inline void hugepage_free(char* buffer, const size_t size) {
+    const size_t rounded_size = ((size + hugepage_size - 1) / hugepage_size) * hugepage_size;
+    munmap(buffer, rounded_size);
+}
+
+}  // namespace derecho
@@ -0,0 +1,76 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <pthread.h>
+#include <sched.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include "logger.hpp"
+
+namespace derecho {
+
+/**
+ * Pins the calling thread to a single CPU, so that latency-critical loops
+ * (predicate evaluation, completion polling, the multicast sender) stay on
+ * the socket close to the NIC instead of migrating across NUMA nodes. A
+ * negative CPU number means "no pinning requested" and is a no-op, so
+ * callers can pass a config value through unconditionally.
+ *
+ * @param cpu The CPU number to pin to, or a negative value to do nothing.
+ */
+inline void pin_to_cpu(const int cpu) {
+    if(cpu < 0) {
+        return;
+    }
+    cpu_set_t cpuset;
+    CPU_ZERO(&cpuset);
+    CPU_SET(cpu, &cpuset);
+    int return_code = pthread_setaffinity_np(pthread_self(), sizeof(cpuset), &cpuset);
+    if(return_code != 0) {
+        dbg_default_warn("Failed to pin thread to CPU {} (error {}); thread remains unpinned.",
+                         cpu, return_code);
+    }
+}
+
+/**
+ * Binds the pages of a buffer to a single NUMA node using the mbind system
+ * call, moving any pages that were already faulted in on another node. Used
+ * to keep the SST table and message buffers on the NIC-local socket. A
+ * negative node number means "no binding requested" and is a no-op. Failure
+ * is not fatal: the buffer simply keeps the kernel's default (first-touch)
+ * placement, and a warning is logged.
+ *
+ * @param buffer The start of the buffer; rounded down to a page boundary
+ *        internally, since mbind requires page-aligned addresses.
+ * @param size The length of the buffer in bytes.
+ * @param numa_node The NUMA node to bind to, or a negative value to do nothing.
+ */
+inline void bind_to_numa_node(void* buffer, const size_t size, const int numa_node) {
+    if(numa_node < 0) {
+        return;
+    }
+#ifdef SYS_mbind
+    // Values from <numaif.h>, redeclared here to avoid requiring libnuma
+    constexpr int mpol_bind = 2;
+    constexpr unsigned mpol_mf_move = 1 << 1;
+    const long page_size = sysconf(_SC_PAGESIZE);
+    const uintptr_t aligned_start = reinterpret_cast<uintptr_t>(buffer) & ~(page_size - 1);
+    const size_t aligned_size = (reinterpret_cast<uintptr_t>(buffer) + size) - aligned_start;
+    const unsigned long nodemask = 1ul << numa_node;
+    long return_code = syscall(SYS_mbind, aligned_start, aligned_size, mpol_bind,
+                               &nodemask, sizeof(nodemask) * 8, mpol_mf_move);
+    if(return_code != 0) {
+        dbg_default_warn("Failed to bind buffer of {} bytes to NUMA node {}; "
+                         "keeping default page placement.",
+                         size, numa_node);
+    }
+#else
+    dbg_default_warn("NUMA binding requested for node {}, but mbind is not available "
+                     "on this platform; keeping default page placement.",
+                     numa_node);
+#endif
+}
+
+}  // namespace derecho
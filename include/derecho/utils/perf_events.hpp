@@ -0,0 +1,104 @@
+#ifndef PERF_EVENTS_HPP
+#define PERF_EVENTS_HPP
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+
+/**
+ * An opt-in wrapper around Linux perf_event hardware counters that attributes
+ * cycles, retired instructions, and last-level-cache misses to delimited
+ * regions of the hot paths (one predicate-loop iteration, deliver_message,
+ * persist). It complements MessageTimeline: the timeline says where a message
+ * spent its wall-clock time, while these counters say what the CPU was doing
+ * there. Counters are opened lazily per thread the first time that thread
+ * enters a region, so each core thread measures only its own work; totals are
+ * accumulated in process-wide atomics. Collection is off by default, and when
+ * disabled each region boundary costs a single branch. If the kernel refuses
+ * perf_event_open (no PMU, or perf_event_paranoid too strict), collection
+ * silently degrades to counting invocations only and isAvailable() reports
+ * false.
+ */
+class PerfEventCounters {
+public:
+    enum Region : uint8_t {
+        /** One full round of the SST predicate thread's evaluation loop */
+        PREDICATE_ITERATION = 0,
+        /** One MulticastGroup::deliver_message call, including the upcall */
+        DELIVERY,
+        /** One persist() call in the PersistenceManager */
+        PERSIST,
+        NUM_REGIONS
+    };
+
+    /** Accumulated hardware-counter totals for one region. */
+    struct RegionCounts {
+        /** Number of begin/end pairs folded into the totals */
+        uint64_t invocations = 0;
+        uint64_t cycles = 0;
+        uint64_t instructions = 0;
+        uint64_t llc_misses = 0;
+    };
+
+    /** Turns counter collection on or off; collection starts disabled. */
+    static void setEnabled(bool enable);
+
+    /** True if counter collection is currently enabled. */
+    static bool isEnabled() {
+        return counting_enabled.load(std::memory_order_relaxed);
+    }
+
+    /**
+     * True if this thread's counters opened successfully (or have not been
+     * tried yet); false once perf_event_open has failed on this thread.
+     */
+    static bool isAvailable();
+
+    /**
+     * Marks the start of a region on the calling thread. Does nothing unless
+     * collection is enabled. Regions do not nest; a second begin() for the
+     * same region before its end() just restarts the region.
+     */
+    static void begin(Region region);
+
+    /**
+     * Marks the end of a region on the calling thread: the counter deltas
+     * since the matching begin() are added to the region's process-wide
+     * totals. Does nothing unless collection is enabled and the region was
+     * begun on this thread.
+     */
+    static void end(Region region);
+
+    /** Returns a copy of the per-region totals across all threads. */
+    static std::array<RegionCounts, NUM_REGIONS> getCounts();
+
+    /** Discards all accumulated totals. */
+    static void clear();
+
+    /** A human-readable name for a region, for report printing. */
+    static const char* regionName(Region region);
+
+    /** RAII helper that begins a region on construction and ends it on
+     * destruction, for instrumented functions with early returns. */
+    class Scope {
+    public:
+        explicit Scope(Region region) : region(region) {
+            begin(region);
+        }
+        ~Scope() {
+            end(region);
+        }
+        Scope(const Scope&) = delete;
+        Scope& operator=(const Scope&) = delete;
+
+    private:
+        const Region region;
+    };
+
+private:
+    static std::atomic<bool> counting_enabled;
+    /** invocations, cycles, instructions, llc_misses per region */
+    static std::array<std::atomic<uint64_t>, NUM_REGIONS * 4> totals;
+};
+
+#endif//PERF_EVENTS_HPP
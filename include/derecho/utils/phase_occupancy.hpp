@@ -0,0 +1,120 @@
+#ifndef PHASE_OCCUPANCY_HPP
+#define PHASE_OCCUPANCY_HPP
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <time.h>
+#include <vector>
+
+/**
+ * Always-on occupancy accounting for the core threads (the SST predicate
+ * threads, the multicast sender thread, the RPC listening thread, and the
+ * persist threads). Each instrumented thread owns a slot with one TSC
+ * accumulator per phase; a phase transition reads the TSC once and charges
+ * the elapsed ticks to the phase being left - an rdtsc, an add, and a
+ * relaxed store, with no branches - so the accounting is cheap enough to
+ * leave on in production. The totals answer "what fraction of its time does
+ * this thread spend waiting, deciding, and working", which is what tells
+ * you whether to scale thread counts (predicate shards, RPC workers,
+ * parallel persistence) without attaching perf. It complements
+ * MessageTimeline (where one message spent its time) and PerfEventCounters
+ * (what the CPU did inside a region) with a per-thread utilization view.
+ *
+ * The accumulators are exposed through snapshot() and, when
+ * DERECHO/phase_log_interval_ms is nonzero, through a background reporter
+ * that logs each thread's occupancy over the last interval.
+ */
+class PhaseOccupancy {
+public:
+    enum Phase : uint8_t {
+        /** waiting for work: blocked on a condition variable or semaphore,
+         * or sleeping/yielding in an idle backoff ladder */
+        IDLE = 0,
+        /** deciding whether there is work: evaluating predicates, probing
+         * receive rings, checking send eligibility */
+        EVALUATING,
+        /** doing the work: running triggers, handling messages, issuing
+         * sends, persisting versions */
+        WORKING,
+        NUM_PHASES
+    };
+
+    /** The number of thread slots; registrations beyond this share one
+     * overflow slot (whose numbers are then unreliable) rather than fail. */
+    static constexpr std::size_t MAX_THREADS = 64;
+
+    /** The raw cycle counter (a nanosecond clock on non-x86 targets). */
+    static inline uint64_t read_tsc() {
+#if defined(__x86_64__)
+        return __builtin_ia32_rdtsc();
+#else
+        struct timespec ts;
+        clock_gettime(CLOCK_MONOTONIC, &ts);
+        return static_cast<uint64_t>(ts.tv_sec) * 1000000000ull + ts.tv_nsec;
+#endif
+    }
+
+    /**
+     * One thread's accumulators. The owning thread is the only writer; the
+     * reporter and snapshot() read the atomics relaxed, so a reading may be
+     * a few transitions stale but is never torn.
+     */
+    class ThreadSlot {
+        friend class PhaseOccupancy;
+        std::string name;
+        std::array<std::atomic<uint64_t>, NUM_PHASES> phase_ticks{};
+        std::atomic<bool> in_use{false};
+        /** TSC at the last transition; touched only by the owning thread */
+        uint64_t last_tsc = 0;
+        Phase current_phase = IDLE;
+
+    public:
+        /** Charges the ticks since the last transition to the phase being
+         * left and makes 'next' the current phase. Entering the current
+         * phase again is harmless and just advances the clock. */
+        inline void enter(Phase next) {
+            const uint64_t now = read_tsc();
+            phase_ticks[current_phase].fetch_add(now - last_tsc, std::memory_order_relaxed);
+            last_tsc = now;
+            current_phase = next;
+        }
+    };
+
+    /** One thread's accumulated ticks per phase, as of a snapshot. Time
+     * spent in the phase a thread currently occupies is only charged at its
+     * next transition, so a thread parked on a semaphore shows no growth
+     * until it wakes. */
+    struct ThreadPhases {
+        std::string thread_name;
+        std::array<uint64_t, NUM_PHASES> phase_ticks;
+    };
+
+    /**
+     * Claims a slot for the calling thread under the given name and starts
+     * its clock in IDLE. Also starts the periodic occupancy log the first
+     * time any thread registers, if DERECHO/phase_log_interval_ms is set.
+     * Registration is a cold-path operation; keep the returned reference
+     * and call enter() on it at phase transitions.
+     */
+    static ThreadSlot& registerThread(const std::string& name);
+
+    /** The accumulated per-phase ticks of every registered thread. */
+    static std::vector<ThreadPhases> snapshot();
+
+    /** A human-readable phase name, for report printing. */
+    static const char* phaseName(Phase phase);
+
+private:
+    static void maybe_start_reporter();
+    static void reporter_loop(uint32_t interval_ms);
+
+    /** slot MAX_THREADS is the shared overflow slot */
+    static std::array<ThreadSlot, MAX_THREADS + 1> slots;
+    static std::atomic<std::size_t> num_slots;
+    static std::atomic<bool> reporter_started;
+};
+
+#endif  //PHASE_OCCUPANCY_HPP
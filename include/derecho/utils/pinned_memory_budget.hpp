@@ -0,0 +1,68 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <stdexcept>
+#include <string>
+
+namespace derecho {
+
+/**
+ * Accounting for RDMA-registered (pinned) memory. Every registration path
+ * charges a named account before pinning and releases it on deregistration,
+ * so the total pinned footprint of a node is visible at runtime instead of
+ * being discovered the hard way when a registration fails mid-view-change.
+ * When RDMA/pinned_memory_budget_mb is nonzero, a charge that would push the
+ * total over the budget fails immediately with a per-account breakdown.
+ */
+namespace pinned_memory {
+
+/** Account charged by SST row registrations. */
+constexpr const char* sst_account = "sst";
+/** Account charged by RDMC memory_region registrations (message buffers). */
+constexpr const char* rdmc_account = "rdmc";
+/** Account charged by the P2P connection ring buffers. */
+constexpr const char* p2p_account = "p2p";
+
+/**
+ * Thrown by charge() when the requested registration would exceed the
+ * configured budget. The message names the account that asked, the amount,
+ * and the current usage of every account, so the operator can tell which
+ * window/payload/table sizes to shrink (or how much to raise the budget).
+ */
+struct budget_exceeded : public std::runtime_error {
+    budget_exceeded(const std::string& message) : std::runtime_error(message) {}
+};
+
+/**
+ * Records that the named account is about to register the given number of
+ * bytes. Throws budget_exceeded (and logs the breakdown) if the configured
+ * budget would be exceeded; in that case nothing is charged and the caller
+ * must not register the memory.
+ *
+ * @param account The account to charge, usually one of the constants above.
+ * @param bytes The number of bytes about to be registered.
+ */
+void charge(const std::string& account, size_t bytes);
+
+/**
+ * Records that the named account has deregistered the given number of bytes,
+ * returning them to the budget. Must be paired with a successful charge().
+ *
+ * @param account The account to credit.
+ * @param bytes The number of bytes deregistered.
+ */
+void release(const std::string& account, size_t bytes);
+
+/** The configured budget in bytes, or 0 if no budget is configured. */
+uint64_t budget();
+
+/** The total number of currently-registered bytes across all accounts. */
+uint64_t total_usage();
+
+/** A snapshot of the currently-registered bytes of each account. */
+std::map<std::string, uint64_t> usage_by_account();
+
+}  // namespace pinned_memory
+}  // namespace derecho
@@ -9,11 +9,97 @@
 #ifdef __cplusplus
 extern "C" {
 #endif//__cplusplus
+
+#if defined(__x86_64__)
+// Calibrated TSC clock. Reading the TSC costs a few cycles while
+// clock_gettime is syscall-adjacent; at millions of timestamps per second
+// the difference is real. Each thread keeps its own calibration (a base
+// reading of the reference clock, the TSC value at that moment, and the
+// tick period) and refreshes it periodically against the reference clock.
+// The refresh also applies NTP drift correction: the kernel disciplines the
+// reference clock's frequency, and the long-baseline refinement folds that
+// into ns_per_tick. Returned values are clamped monotonic per thread;
+// cross-thread skew is bounded by the calibration error, well under a
+// microsecond.
+struct tsc_clock_state {
+    uint64_t base_ns;    // reference clock reading at the last calibration
+    uint64_t base_tsc;   // TSC reading at the last calibration
+    double ns_per_tick;  // calibrated TSC tick period; 0 means uncalibrated
+    uint64_t recal_tsc;  // TSC value at which to recalibrate
+    uint64_t last_ns;    // last value returned, for the monotonic clamp
+};
+
+// Scale the TSC into nanoseconds of 'clock_id', recalibrating every
+// 'recal_interval_ns'. Not for direct use: call get_time() or
+// get_realtime_us() below, which supply per-thread state.
+inline uint64_t tsc_clock_read(clockid_t clock_id, struct tsc_clock_state* state, uint64_t recal_interval_ns) {
+    uint64_t tsc = __builtin_ia32_rdtsc();
+    if(tsc >= state->recal_tsc) {
+        struct timespec now_ts;
+        clock_gettime(clock_id, &now_ts);
+        uint64_t now = (uint64_t)now_ts.tv_sec * 1000000000L + now_ts.tv_nsec;
+        if(state->ns_per_tick <= 0.0) {
+            // first use on this thread: measure the tick rate over a short
+            // busy interval of the monotonic clock
+            struct timespec t0_ts, t1_ts;
+            clock_gettime(CLOCK_MONOTONIC, &t0_ts);
+            uint64_t c0 = __builtin_ia32_rdtsc();
+            uint64_t elapsed;
+            do {
+                clock_gettime(CLOCK_MONOTONIC, &t1_ts);
+                elapsed = (uint64_t)(t1_ts.tv_sec - t0_ts.tv_sec) * 1000000000L
+                          + (uint64_t)(t1_ts.tv_nsec - t0_ts.tv_nsec);
+            } while(elapsed < 100000);
+            state->ns_per_tick = (double)elapsed / (double)(__builtin_ia32_rdtsc() - c0);
+        } else if(now > state->base_ns && tsc > state->base_tsc) {
+            // refine the tick period over the whole interval since the last
+            // calibration. A clock step (CLOCK_REALTIME under settimeofday)
+            // shows up as a wild ratio and keeps the old estimate, so steps
+            // move base_ns without corrupting the frequency.
+            double refined = (double)(now - state->base_ns) / (double)(tsc - state->base_tsc);
+            if(refined > state->ns_per_tick * 0.9 && refined < state->ns_per_tick * 1.1) {
+                state->ns_per_tick = refined;
+            }
+        }
+        tsc = __builtin_ia32_rdtsc();
+        clock_gettime(clock_id, &now_ts);
+        state->base_ns = (uint64_t)now_ts.tv_sec * 1000000000L + now_ts.tv_nsec;
+        state->base_tsc = tsc;
+        state->recal_tsc = tsc + (uint64_t)(recal_interval_ns / state->ns_per_tick);
+    }
+    uint64_t ns = state->base_ns + (uint64_t)((double)(tsc - state->base_tsc) * state->ns_per_tick);
+    if(ns < state->last_ns) {
+        ns = state->last_ns;
+    } else {
+        state->last_ns = ns;
+    }
+    return ns;
+}
+#endif//__x86_64__
+
 // Returns the number of nanoseconds since some fixed time in the past.
 inline uint64_t get_time() {
+#if defined(__x86_64__)
+    static __thread struct tsc_clock_state state;
+    return tsc_clock_read(CLOCK_MONOTONIC, &state, 500000000ull);
+#else
     struct timespec now;
     clock_gettime(CLOCK_MONOTONIC, &now);
     return now.tv_sec * 1000000000L + now.tv_nsec;
+#endif
+}
+
+// Returns the wall-clock time in microseconds. The TSC path recalibrates
+// more often than get_time() so that wall-clock steps are picked up quickly.
+inline uint64_t get_realtime_us() {
+#if defined(__x86_64__)
+    static __thread struct tsc_clock_state state;
+    return tsc_clock_read(CLOCK_REALTIME, &state, 100000000ull) / 1000;
+#else
+    struct timespec now;
+    clock_gettime(CLOCK_REALTIME, &now);
+    return (uint64_t)now.tv_sec * 1000000 + now.tv_nsec / 1000;
+#endif
 }
 
 // Returns the number of nanoseconds of CPU time that have been used by this
@@ -0,0 +1,100 @@
+#ifndef TIMELINE_HPP
+#define TIMELINE_HPP
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <ctime>
+#include <mutex>
+
+/**
+ * An opt-in timing pipeline that answers "where did this multicast spend its
+ * time?" for cooked sends. The stages correspond to code points that already
+ * exist in the multicast and persistence paths; each one records a TSC
+ * timestamp keyed by (subgroup, message sequence number), and the interval
+ * from the previous stage recorded on this node is folded into a per-stage
+ * log-scale histogram. In-flight stamps live in a fixed-size direct-mapped
+ * table, so memory stays bounded without any cleanup pass. Recording is off
+ * by default; when disabled each trace point costs a single branch.
+ */
+class MessageTimeline {
+public:
+    enum Stage : uint8_t {
+        /** MulticastGroup::send accepted the message from the caller */
+        SEND = 0,
+        /** RDMC completed delivery of the message buffer to this node */
+        RDMC_RECEIVE,
+        /** deliver_message ran the upcall or stability callback */
+        DELIVERY,
+        /** PersistenceManager::post_persist_request queued the version */
+        PERSIST_REQUEST,
+        /** The persist() call covering this version returned */
+        PERSIST_COMPLETE,
+        NUM_STAGES
+    };
+
+    /** A log-scale latency histogram for one stage, in TSC ticks. */
+    struct StageHistogram {
+        /** log2_buckets[i] counts intervals with floor(log2(ticks)) == i */
+        std::array<uint64_t, 64> log2_buckets{};
+        uint64_t count = 0;
+        uint64_t total_ticks = 0;
+        uint64_t max_ticks = 0;
+    };
+
+    /** Turns stage recording on or off; recording starts disabled. */
+    static void setEnabled(bool enable);
+
+    /** True if stage recording is currently enabled. Lets callers skip
+     * computing a message's sequence number when recording is off. */
+    static bool isEnabled() {
+        return timing_enabled.load(std::memory_order_relaxed);
+    }
+
+    /**
+     * Records that a message reached a stage. The interval since the most
+     * recent earlier stage recorded for the same message on this node is
+     * added to the stage's histogram; a stage with no earlier stamp (e.g.
+     * DELIVERY on a node that wasn't the sender) just establishes the base
+     * timestamp for later stages. Does nothing unless recording is enabled.
+     * @param subgroup_num The subgroup the message belongs to
+     * @param message_seq The message's sequence number within the subgroup
+     * @param stage The stage the message just reached
+     */
+    static void record(uint32_t subgroup_num, int64_t message_seq, Stage stage);
+
+    /**
+     * Returns a copy of the per-stage histograms. The SEND entry is always
+     * empty, since SEND has no earlier stage to measure from.
+     */
+    static std::array<StageHistogram, NUM_STAGES> getHistograms();
+
+    /** Discards all histograms and in-flight stamps. */
+    static void clear();
+
+private:
+    struct Entry {
+        uint32_t subgroup_num;
+        int64_t message_seq;
+        bool valid = false;
+        std::array<uint64_t, NUM_STAGES> stamps{};
+    };
+    /** Number of in-flight messages tracked; a new message evicts whatever
+     * message hashed to the same slot. */
+    static constexpr std::size_t table_size = 4096;
+    static std::atomic<bool> timing_enabled;
+    static std::mutex table_mutex;
+    static std::array<Entry, table_size> entries;
+    static std::array<StageHistogram, NUM_STAGES> histograms;
+    static uint64_t read_tsc() {
+#if defined(__x86_64__) || defined(__i386__)
+        return __builtin_ia32_rdtsc();
+#else
+        struct timespec now;
+        clock_gettime(CLOCK_MONOTONIC, &now);
+        return now.tv_sec * 1000000000ull + now.tv_nsec;
+#endif
+    }
+};
+
+#endif//TIMELINE_HPP
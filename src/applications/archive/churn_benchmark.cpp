@@ -0,0 +1,209 @@
+/*
+ * A failure-injection harness that measures Derecho's behavior under
+ * membership churn. All nodes join one raw subgroup and send fixed-size
+ * messages continuously; each node records a 100ms-bucket timeline of
+ * delivery throughput and (for its own messages) delivery latency, so the
+ * latency/throughput dip around each membership event is visible. Nodes can
+ * be scripted to fail partway through the run: a kill time of K seconds makes
+ * this node either crash (exit without cleanup, exercising failure detection)
+ * or leave gracefully at T+K. Rejoins are driven externally by restarting the
+ * killed node's process; a restarted process joins as a fresh member.
+ *
+ * On completion each surviving node writes churn_timeline_<id>.dat with its
+ * delivery timeline, the view events it observed, and the per-phase breakdown
+ * (change start -> wedge -> ragged trim -> install) of every view change,
+ * taken from Group::get_view_change_timings().
+ */
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <optional>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+#include <derecho/core/derecho.hpp>
+#include <derecho/utils/time.h>
+
+using std::cout;
+using std::endl;
+using namespace derecho;
+
+/** Width of one timeline bucket, in nanoseconds. */
+constexpr uint64_t bucket_ns = 100000000ull;
+
+struct TimelineBucket {
+    uint64_t messages_delivered = 0;
+    uint64_t bytes_delivered = 0;
+    /** Latency statistics cover only this node's own messages, since only
+     * those have a send timestamp from the local clock. */
+    uint64_t own_latency_total_ns = 0;
+    uint64_t own_latency_max_ns = 0;
+    uint64_t own_messages = 0;
+};
+
+struct ViewEvent {
+    uint64_t time_ns;
+    int32_t vid;
+    uint32_t num_members;
+};
+
+int main(int argc, char* argv[]) {
+    if(argc < 5 || (argc > 5 && strcmp("--", argv[argc - 5]))) {
+        cout << "Invalid command line arguments." << endl;
+        cout << "USAGE: " << argv[0] << " [ derecho-config-list -- ] num_nodes duration_s msg_size kill_schedule" << endl;
+        cout << "kill_schedule: 0 to run the full duration, K to crash after K seconds, -K to leave gracefully after K seconds" << endl;
+        return -1;
+    }
+    pthread_setname_np(pthread_self(), "churn_bench");
+
+    const uint32_t num_nodes = std::stoi(argv[argc - 4]);
+    const uint32_t duration_s = std::stoi(argv[argc - 3]);
+    const uint64_t msg_size = std::max(std::stoul(argv[argc - 2]), sizeof(uint64_t));
+    const int kill_schedule = std::stoi(argv[argc - 1]);
+
+    Conf::initialize(argc, argv);
+
+    const uint64_t start_time = get_time();
+    std::vector<TimelineBucket> timeline((duration_s + 30) * 10);
+    std::vector<ViewEvent> view_events;
+    std::mutex view_events_mutex;
+    const node_id_t my_id = getConfUInt32(CONF_DERECHO_LOCAL_ID);
+    std::atomic<bool> stop_sending{false};
+
+    // Delivery upcall: fold each message into the current timeline bucket.
+    // Own messages carry their send time in the first 8 bytes of the payload
+    auto stability_callback = [&](uint32_t subgroup, uint32_t sender_id, long long int index,
+                                  std::optional<std::pair<char*, long long int>> data,
+                                  persistent::version_t ver) {
+        const uint64_t now = get_time();
+        const std::size_t bucket = std::min<std::size_t>((now - start_time) / bucket_ns,
+                                                         timeline.size() - 1);
+        TimelineBucket& entry = timeline[bucket];
+        entry.messages_delivered++;
+        if(data) {
+            entry.bytes_delivered += data->second;
+            if(sender_id == my_id && data->second >= (long long int)sizeof(uint64_t)) {
+                uint64_t send_time;
+                memcpy(&send_time, data->first, sizeof(send_time));
+                const uint64_t latency = now - send_time;
+                entry.own_latency_total_ns += latency;
+                entry.own_latency_max_ns = std::max(entry.own_latency_max_ns, latency);
+                entry.own_messages++;
+            }
+        }
+    };
+
+    // One raw subgroup spanning every current member, so the group keeps
+    // running (with a smaller membership) after each kill
+    auto membership_function = [](const std::vector<std::type_index>& subgroup_type_order,
+                                  const std::unique_ptr<View>& prev_view, View& curr_view) {
+        subgroup_shard_layout_t subgroup_vector(1);
+        subgroup_vector[0].emplace_back(curr_view.make_subview(curr_view.members));
+        curr_view.next_unassigned_rank = curr_view.members.size();
+        subgroup_allocation_map_t subgroup_allocation;
+        subgroup_allocation.emplace(std::type_index(typeid(RawObject)), std::move(subgroup_vector));
+        return subgroup_allocation;
+    };
+    SubgroupInfo one_raw_group(membership_function);
+
+    auto view_event_upcall = [&](const View& new_view) {
+        std::lock_guard<std::mutex> lock(view_events_mutex);
+        view_events.push_back(ViewEvent{get_time(), new_view.vid,
+                                        (uint32_t)new_view.members.size()});
+    };
+
+    Group<RawObject> group(CallbackSet{stability_callback}, one_raw_group, nullptr,
+                           std::vector<view_upcall_t>{view_event_upcall},
+                           &raw_object_factory);
+    cout << "Finished constructing/joining Group" << endl;
+
+    // Wait for the full membership before starting the measured run, so every
+    // node's timeline starts from a quiescent fully-provisioned view
+    while(group.get_members().size() < num_nodes) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+
+    // The failure injector: crash (no cleanup at all, so the others must
+    // detect the failure) or leave gracefully at the scheduled time
+    std::thread killer;
+    if(kill_schedule != 0) {
+        killer = std::thread([&]() {
+            std::this_thread::sleep_for(std::chrono::seconds(std::abs(kill_schedule)));
+            if(kill_schedule > 0) {
+                cout << "Crashing as scheduled" << endl;
+                _exit(1);
+            }
+            cout << "Leaving gracefully as scheduled" << endl;
+            stop_sending = true;
+            group.leave(false);
+            // results up to the leave are still worth keeping
+            std::exit(0);
+        });
+        killer.detach();
+    }
+
+    // The sender loop: send continuously for the full duration. Sends fail
+    // transiently while a view change is in progress; back off and retry
+    Replicated<RawObject>& raw_subgroup = group.get_subgroup<RawObject>();
+    const uint64_t send_deadline = start_time + uint64_t(duration_s) * 1000000000ull;
+    uint64_t messages_sent = 0;
+    while(get_time() < send_deadline && !stop_sending) {
+        try {
+            raw_subgroup.send(msg_size, [](char* buf) {
+                const uint64_t send_time = get_time();
+                memcpy(buf, &send_time, sizeof(send_time));
+            });
+            messages_sent++;
+        } catch(derecho_exception&) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+    }
+    // Grace period so in-flight messages drain into the timeline
+    std::this_thread::sleep_for(std::chrono::seconds(2));
+
+    std::ofstream fout("churn_timeline_" + std::to_string(my_id) + ".dat");
+    fout << "# " << num_nodes << " nodes, " << msg_size << "-byte messages, "
+         << messages_sent << " sent by this node" << endl;
+    fout << "# time_ms messages_delivered bytes_delivered own_avg_latency_us own_max_latency_us" << endl;
+    for(std::size_t bucket = 0; bucket < timeline.size(); ++bucket) {
+        const TimelineBucket& entry = timeline[bucket];
+        if(entry.messages_delivered == 0) {
+            continue;
+        }
+        const double avg_latency_us = entry.own_messages == 0
+                                              ? 0.0
+                                              : (entry.own_latency_total_ns / 1000.0) / entry.own_messages;
+        fout << bucket * (bucket_ns / 1000000) << " " << entry.messages_delivered << " "
+             << entry.bytes_delivered << " " << avg_latency_us << " "
+             << entry.own_latency_max_ns / 1000.0 << endl;
+    }
+    fout << "# view events: time_ms vid num_members" << endl;
+    {
+        std::lock_guard<std::mutex> lock(view_events_mutex);
+        for(const ViewEvent& event : view_events) {
+            fout << "# view " << (event.time_ns - start_time) / 1000000 << " "
+                 << event.vid << " " << event.num_members << endl;
+        }
+    }
+    fout << "# view changes: old_vid->new_vid start_to_wedge_us wedge_to_trim_us trim_to_install_us total_us" << endl;
+    for(const ViewChangeTiming& timing : group.get_view_change_timings()) {
+        // a zero milestone was not observed locally; print -1 for intervals
+        // that can't be computed from this node's record
+        auto interval_us = [](uint64_t from, uint64_t to) {
+            return (from == 0 || to == 0) ? -1.0 : (to - from) / 1000.0;
+        };
+        fout << "# change " << timing.old_vid << "->" << timing.new_vid << " "
+             << interval_us(timing.change_start_time, timing.wedge_time) << " "
+             << interval_us(timing.wedge_time, timing.ragged_trim_time) << " "
+             << interval_us(timing.ragged_trim_time, timing.install_time) << " "
+             << interval_us(timing.change_start_time, timing.install_time) << endl;
+    }
+    fout.close();
+    cout << "Timeline written; leaving group" << endl;
+
+    group.barrier_sync();
+    group.leave();
+}
@@ -0,0 +1,189 @@
+/**
+ * @file config_autotuner.cpp
+ *
+ * Benchmarks a grid of (max_payload_size, block_size, window_size)
+ * combinations with short raw-multicast runs and writes the best-performing
+ * settings out as ready-to-paste SUBGROUP profile sections, so choosing
+ * these values after a hardware change no longer requires days of manual
+ * multicast_throughput runs.
+ *
+ * Run the same command on every node, like any other benchmark here:
+ *
+ *     config_autotuner <num_nodes> [bytes_per_sender_per_trial] [config options...]
+ *
+ * Every node derives the identical trial grid and stages it as one SUBGROUP
+ * profile per trial in a generated config file (autotune-trials.cfg, layered
+ * on top of the node's normal configuration), then the group creates one raw
+ * subgroup per trial and measures them in sequence: all nodes send, and
+ * delivery of every sender's last message doubles as the end-of-trial
+ * barrier. Node 0 writes the recommended profile for each payload size to
+ * autotuned-profiles.cfg, annotated with the measured aggregate throughput.
+ */
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <optional>
+#include <string>
+#include <thread>
+#include <typeindex>
+#include <vector>
+
+#include <derecho/conf/conf.hpp>
+#include <derecho/core/derecho.hpp>
+
+using derecho::RawObject;
+using std::cout;
+using std::endl;
+
+struct TrialParams {
+    uint64_t max_payload_size;
+    uint64_t block_size;
+    uint32_t window_size;
+};
+
+int main(int argc, char* argv[]) {
+    if(argc < 2) {
+        cout << "Usage: " << argv[0]
+             << " <num_nodes> [bytes_per_sender_per_trial] [configuration options...]" << endl;
+        return -1;
+    }
+    const int num_nodes = std::stoi(argv[1]);
+    const uint64_t bytes_per_trial = (argc >= 3 && argv[2][0] != '-')
+                                             ? std::stoull(argv[2])
+                                             : (16ull << 20);
+
+    // The swept parameter grid. Payload sizes cover the common small/medium/
+    // large profiles; blocks and windows bracket the usual hand-tuned values.
+    const std::vector<uint64_t> payload_sizes{10240, 102400, 1048576};
+    const std::vector<uint64_t> block_sizes{65536, 262144, 1048576};
+    const std::vector<uint32_t> window_sizes{4, 16, 32};
+
+    std::vector<TrialParams> trials;
+    for(const uint64_t payload : payload_sizes) {
+        for(const uint64_t block : block_sizes) {
+            for(const uint32_t window : window_sizes) {
+                trials.push_back({payload, block, window});
+            }
+        }
+    }
+    const uint32_t num_trials = trials.size();
+
+    // Stage a config file that layers one SUBGROUP profile per trial on top
+    // of the node's normal configuration. Every node generates the identical
+    // file from the same grid, so the members agree on all the profiles.
+    const char* base_conf_env = std::getenv("DERECHO_CONF_FILE");
+    const std::string trial_conf_name = "autotune-trials.cfg";
+    {
+        std::ofstream trial_conf(trial_conf_name);
+        std::ifstream base_conf(base_conf_env ? base_conf_env : "derecho.cfg");
+        trial_conf << base_conf.rdbuf();
+        for(uint32_t i = 0; i < num_trials; ++i) {
+            trial_conf << "\n[SUBGROUP/AUTOTUNE_" << i << "]\n"
+                       << "max_payload_size = " << trials[i].max_payload_size << "\n"
+                       << "max_reply_payload_size = 10240\n"
+                       // keep every trial on RDMC: block and window are RDMC's knobs
+                       << "max_smc_payload_size = 1024\n"
+                       << "block_size = " << trials[i].block_size << "\n"
+                       << "window_size = " << trials[i].window_size << "\n"
+                       << "rdmc_send_algorithm = binomial_send\n";
+        }
+    }
+    derecho::Conf::initialize(argc, argv, trial_conf_name.c_str());
+
+    // One raw subgroup per trial, all spanning the same num_nodes members
+    derecho::SubgroupInfo subgroup_info{[num_nodes, num_trials](
+            const std::vector<std::type_index>& subgroup_type_order,
+            const std::unique_ptr<derecho::View>& prev_view, derecho::View& curr_view) {
+        if(curr_view.num_members < num_nodes) {
+            throw derecho::subgroup_provisioning_exception();
+        }
+        std::vector<node_id_t> members(curr_view.members.begin(),
+                                       curr_view.members.begin() + num_nodes);
+        derecho::subgroup_shard_layout_t subgroup_layout(num_trials);
+        for(uint32_t i = 0; i < num_trials; ++i) {
+            subgroup_layout[i].emplace_back(curr_view.make_subview(
+                    members, derecho::Mode::UNORDERED, {}, "AUTOTUNE_" + std::to_string(i)));
+        }
+        curr_view.next_unassigned_rank = std::max(curr_view.next_unassigned_rank, num_nodes);
+        derecho::subgroup_allocation_map_t subgroup_allocation;
+        subgroup_allocation.emplace(std::type_index(typeid(RawObject)), std::move(subgroup_layout));
+        return subgroup_allocation;
+    }};
+
+    std::vector<std::atomic<uint64_t>> delivered_count(num_trials);
+    auto stability_callback = [&delivered_count](uint32_t subgroup, uint32_t sender_id,
+                                                 derecho::message_id_t index,
+                                                 std::optional<std::pair<char*, long long int>> data,
+                                                 persistent::version_t ver) {
+        // null messages carry no payload and don't count toward the trial
+        if(data) {
+            delivered_count[subgroup]++;
+        }
+    };
+
+    derecho::Group<RawObject> group(derecho::CallbackSet{stability_callback}, subgroup_info, nullptr,
+                                    std::vector<derecho::view_upcall_t>{},
+                                    &derecho::raw_object_factory);
+    cout << "Finished constructing/joining Group" << endl;
+    const uint32_t node_rank = group.get_my_rank();
+
+    std::vector<double> aggregate_mbps(num_trials, 0.0);
+    for(uint32_t trial = 0; trial < num_trials; ++trial) {
+        const TrialParams& params = trials[trial];
+        const uint64_t num_messages = std::max<uint64_t>(16, bytes_per_trial / params.max_payload_size);
+        const uint64_t expected = num_messages * num_nodes;
+        derecho::Replicated<RawObject>& subgroup_handle = group.get_subgroup<RawObject>(trial);
+
+        const auto start_time = std::chrono::steady_clock::now();
+        for(uint64_t i = 0; i < num_messages; ++i) {
+            subgroup_handle.send(params.max_payload_size, [](char* buf) {});
+        }
+        // Delivery of every sender's last message is the end-of-trial barrier
+        while(delivered_count[trial] < expected) {
+        }
+        const double seconds = std::chrono::duration<double>(
+                                       std::chrono::steady_clock::now() - start_time)
+                                       .count();
+        aggregate_mbps[trial] = static_cast<double>(expected * params.max_payload_size) / seconds / 1e6;
+        cout << "trial " << trial << ": payload " << params.max_payload_size
+             << " block " << params.block_size << " window " << params.window_size
+             << " -> " << aggregate_mbps[trial] << " MB/s aggregate" << endl;
+        // let stragglers drain before the next trial contends for the NIC
+        std::this_thread::sleep_for(std::chrono::milliseconds(200));
+    }
+
+    if(node_rank == 0) {
+        const std::string out_name = "autotuned-profiles.cfg";
+        std::ofstream fout(out_name);
+        fout << "# Generated by config_autotuner with " << num_nodes << " nodes.\n"
+             << "# Rename the section for your message size to your profile's name and\n"
+             << "# merge it into derecho.cfg (or use it as the SUBGROUP/DEFAULT values).\n";
+        for(const uint64_t payload : payload_sizes) {
+            uint32_t best_trial = 0;
+            double best_mbps = -1.0;
+            for(uint32_t trial = 0; trial < num_trials; ++trial) {
+                if(trials[trial].max_payload_size == payload && aggregate_mbps[trial] > best_mbps) {
+                    best_mbps = aggregate_mbps[trial];
+                    best_trial = trial;
+                }
+            }
+            fout << "\n# " << best_mbps << " MB/s aggregate at payload " << payload << "\n"
+                 << "[SUBGROUP/AUTOTUNE_" << payload << "B]\n"
+                 << "max_payload_size = " << payload << "\n"
+                 << "max_reply_payload_size = 10240\n"
+                 << "max_smc_payload_size = 10240\n"
+                 << "block_size = " << trials[best_trial].block_size << "\n"
+                 << "window_size = " << trials[best_trial].window_size << "\n"
+                 << "rdmc_send_algorithm = binomial_send\n";
+        }
+        cout << "Wrote recommended profiles to " << out_name << endl;
+    }
+
+    cout << "Done. Press Ctrl-C to exit." << endl;
+    while(true) {
+    }
+}
@@ -0,0 +1,142 @@
+#pragma once
+
+/*
+ * Helpers for derecho_bench: latency percentile computation, JSON-lines
+ * result records, and parsing/comparison of result files so two runs can be
+ * diffed for regressions. Records are written one JSON object per line, e.g.
+ * {"benchmark":"multicast","parameters":{"num_nodes":4,...},"metrics":{...}}
+ * and the parser only needs to understand this flat two-level shape.
+ */
+
+#include <algorithm>
+#include <cstdint>
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+
+struct LatencyStats {
+    uint64_t samples;
+    double min_us;
+    double mean_us;
+    double p50_us;
+    double p90_us;
+    double p99_us;
+    double max_us;
+};
+
+/** Computes percentile statistics over a set of latency samples in
+ * nanoseconds; sorts the sample vector in place. */
+inline LatencyStats compute_latency_stats(std::vector<uint64_t>& samples_ns) {
+    LatencyStats stats{};
+    if(samples_ns.empty()) {
+        return stats;
+    }
+    std::sort(samples_ns.begin(), samples_ns.end());
+    auto percentile = [&samples_ns](double fraction) {
+        std::size_t index = static_cast<std::size_t>(fraction * (samples_ns.size() - 1));
+        return samples_ns[index] / 1000.0;
+    };
+    uint64_t total_ns = 0;
+    for(const uint64_t sample : samples_ns) {
+        total_ns += sample;
+    }
+    stats.samples = samples_ns.size();
+    stats.min_us = samples_ns.front() / 1000.0;
+    stats.mean_us = total_ns / 1000.0 / samples_ns.size();
+    stats.p50_us = percentile(0.5);
+    stats.p90_us = percentile(0.9);
+    stats.p99_us = percentile(0.99);
+    stats.max_us = samples_ns.back() / 1000.0;
+    return stats;
+}
+
+/** One benchmark result: the benchmark name, the parameter point it was
+ * measured at, and the metrics measured there. */
+struct BenchmarkRecord {
+    std::string benchmark;
+    std::map<std::string, uint64_t> parameters;
+    std::map<std::string, double> metrics;
+
+    std::string to_json() const {
+        std::ostringstream json;
+        json << "{\"benchmark\":\"" << benchmark << "\",\"parameters\":{";
+        bool first = true;
+        for(const auto& parameter : parameters) {
+            json << (first ? "" : ",") << "\"" << parameter.first << "\":" << parameter.second;
+            first = false;
+        }
+        json << "},\"metrics\":{";
+        first = true;
+        for(const auto& metric : metrics) {
+            json << (first ? "" : ",") << "\"" << metric.first << "\":" << metric.second;
+            first = false;
+        }
+        json << "}}";
+        return json.str();
+    }
+
+    /** The record's identity for matching across runs: the benchmark name
+     * plus all of its parameters. */
+    std::string identity() const {
+        std::ostringstream id;
+        id << benchmark;
+        for(const auto& parameter : parameters) {
+            id << " " << parameter.first << "=" << parameter.second;
+        }
+        return id.str();
+    }
+
+    /** Parses one JSON line previously written by to_json(). Returns false
+     * if the line isn't a well-formed record. */
+    static bool from_json(const std::string& line, BenchmarkRecord& record) {
+        auto extract_object = [&line](const std::string& key, std::string& body) {
+            const std::string marker = "\"" + key + "\":{";
+            const std::size_t start = line.find(marker);
+            if(start == std::string::npos) return false;
+            const std::size_t body_start = start + marker.size();
+            const std::size_t body_end = line.find('}', body_start);
+            if(body_end == std::string::npos) return false;
+            body = line.substr(body_start, body_end - body_start);
+            return true;
+        };
+        const std::string name_marker = "\"benchmark\":\"";
+        const std::size_t name_start = line.find(name_marker);
+        if(name_start == std::string::npos) return false;
+        const std::size_t name_end = line.find('"', name_start + name_marker.size());
+        if(name_end == std::string::npos) return false;
+        record.benchmark = line.substr(name_start + name_marker.size(),
+                                       name_end - name_start - name_marker.size());
+        std::string parameters_body, metrics_body;
+        if(!extract_object("parameters", parameters_body)
+           || !extract_object("metrics", metrics_body)) {
+            return false;
+        }
+        auto parse_pairs = [](const std::string& body, auto& destination) {
+            std::istringstream body_stream(body);
+            std::string pair;
+            while(std::getline(body_stream, pair, ',')) {
+                const std::size_t colon = pair.find("\":");
+                if(colon == std::string::npos || pair.empty() || pair[0] != '"') continue;
+                const std::string key = pair.substr(1, colon - 1);
+                destination[key] = std::stod(pair.substr(colon + 2));
+            }
+        };
+        record.parameters.clear();
+        record.metrics.clear();
+        std::map<std::string, double> parameter_values;
+        parse_pairs(parameters_body, parameter_values);
+        for(const auto& parameter : parameter_values) {
+            record.parameters[parameter.first] = static_cast<uint64_t>(parameter.second);
+        }
+        parse_pairs(metrics_body, record.metrics);
+        return true;
+    }
+};
+
+/** True if a higher value of the named metric is better (throughputs and
+ * rates), false if lower is better (latencies and times). */
+inline bool metric_higher_is_better(const std::string& metric_name) {
+    return metric_name.find("throughput") != std::string::npos
+           || metric_name.find("rate") != std::string::npos;
+}
@@ -0,0 +1,251 @@
+/*
+ * derecho_bench: a unified benchmark driver with machine-readable output.
+ *
+ * The "multicast" mode joins a single raw subgroup containing all nodes
+ * (like bandwidth_test) and sweeps over a list of payload sizes; for each
+ * size it sends warmup messages, then measures multicast throughput and the
+ * delivery latency of this node's own messages, and appends one JSON record
+ * per parameter point to derecho_bench.<rank>.json. The "compare" mode reads
+ * two such result files, matches records by benchmark name and parameters,
+ * and flags any metric that regressed beyond a tolerance; it exits nonzero
+ * if a regression was found, so it can gate an upgrade in CI.
+ *
+ * USAGE:
+ *   derecho_bench [ derecho-config-list -- ] multicast <num_nodes> <num_messages> <warmup_messages> [payload_sizes_csv]
+ *   derecho_bench compare <baseline.json> <candidate.json> [tolerance_pct]
+ */
+#include <atomic>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <optional>
+#include <sstream>
+#include <string>
+#include <time.h>
+#include <vector>
+
+#include <derecho/core/derecho.hpp>
+
+#include "benchmark_results.hpp"
+
+using std::cout;
+using std::endl;
+using namespace derecho;
+
+namespace {
+
+uint64_t wallclock_ns() {
+    struct timespec now;
+    clock_gettime(CLOCK_REALTIME, &now);
+    return (uint64_t)now.tv_sec * 1000000000ull + now.tv_nsec;
+}
+
+std::vector<std::size_t> parse_size_list(const std::string& csv) {
+    std::vector<std::size_t> sizes;
+    std::istringstream csv_stream(csv);
+    std::string token;
+    while(std::getline(csv_stream, token, ',')) {
+        sizes.push_back(std::stoull(token));
+    }
+    return sizes;
+}
+
+int run_compare(const std::string& baseline_file, const std::string& candidate_file,
+                double tolerance_pct) {
+    auto load_records = [](const std::string& file_name) {
+        std::map<std::string, BenchmarkRecord> records;
+        std::ifstream file(file_name);
+        std::string line;
+        while(std::getline(file, line)) {
+            BenchmarkRecord record;
+            if(BenchmarkRecord::from_json(line, record)) {
+                records[record.identity()] = record;
+            }
+        }
+        return records;
+    };
+    const auto baseline_records = load_records(baseline_file);
+    const auto candidate_records = load_records(candidate_file);
+    if(baseline_records.empty() || candidate_records.empty()) {
+        cout << "No records parsed from "
+             << (baseline_records.empty() ? baseline_file : candidate_file) << endl;
+        return 2;
+    }
+    int num_regressions = 0;
+    for(const auto& candidate_entry : candidate_records) {
+        const auto baseline_entry = baseline_records.find(candidate_entry.first);
+        if(baseline_entry == baseline_records.end()) {
+            cout << "NEW " << candidate_entry.first << " (no baseline)" << endl;
+            continue;
+        }
+        for(const auto& metric : candidate_entry.second.metrics) {
+            const auto baseline_metric = baseline_entry->second.metrics.find(metric.first);
+            if(baseline_metric == baseline_entry->second.metrics.end()
+               || baseline_metric->second == 0) {
+                continue;
+            }
+            const double change_pct = (metric.second - baseline_metric->second)
+                                      / baseline_metric->second * 100.0;
+            const bool regressed = metric_higher_is_better(metric.first)
+                                           ? change_pct < -tolerance_pct
+                                           : change_pct > tolerance_pct;
+            cout << (regressed ? "REGRESSION " : "ok         ")
+                 << candidate_entry.first << " " << metric.first << ": "
+                 << baseline_metric->second << " -> " << metric.second
+                 << " (" << (change_pct >= 0 ? "+" : "") << change_pct << "%)" << endl;
+            if(regressed) {
+                ++num_regressions;
+            }
+        }
+    }
+    for(const auto& baseline_entry : baseline_records) {
+        if(candidate_records.find(baseline_entry.first) == candidate_records.end()) {
+            cout << "MISSING " << baseline_entry.first << " (not in candidate run)" << endl;
+        }
+    }
+    cout << num_regressions << " regression(s) beyond " << tolerance_pct << "%" << endl;
+    return num_regressions > 0 ? 1 : 0;
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+    if(argc >= 4 && strcmp(argv[1], "compare") == 0) {
+        const double tolerance_pct = (argc > 4) ? std::stod(argv[4]) : 5.0;
+        return run_compare(argv[2], argv[3], tolerance_pct);
+    }
+    pthread_setname_np(pthread_self(), "derecho_bench");
+
+    // the benchmark name and its positional arguments follow the optional
+    // config list, as in bandwidth_test
+    int bench_index = -1;
+    for(int i = 1; i < argc; ++i) {
+        if(strcmp(argv[i], "multicast") == 0) {
+            bench_index = i;
+            break;
+        }
+    }
+    if(bench_index < 0 || argc - bench_index < 4) {
+        cout << "USAGE: " << argv[0]
+             << " [ derecho-config-list -- ] multicast <num_nodes> <num_messages> <warmup_messages> [payload_sizes_csv]" << endl;
+        cout << "       " << argv[0] << " compare <baseline.json> <candidate.json> [tolerance_pct]" << endl;
+        return -1;
+    }
+    const uint32_t num_nodes = std::stoi(argv[bench_index + 1]);
+    const uint32_t num_messages = std::stoi(argv[bench_index + 2]);
+    const uint32_t warmup_messages = std::stoi(argv[bench_index + 3]);
+    std::vector<std::size_t> payload_sizes{10000, 100000, 1000000};
+    if(argc - bench_index >= 5) {
+        payload_sizes = parse_size_list(argv[bench_index + 4]);
+    }
+
+    Conf::initialize(argc, argv);
+    const uint64_t max_payload_size = getConfUInt64(CONF_SUBGROUP_DEFAULT_MAX_PAYLOAD_SIZE);
+    for(const std::size_t payload_size : payload_sizes) {
+        if(payload_size > max_payload_size) {
+            cout << "Payload size " << payload_size << " exceeds max_payload_size "
+                 << max_payload_size << "; raise it in the config" << endl;
+            return -1;
+        }
+    }
+
+    const uint32_t messages_per_phase = warmup_messages + num_messages;
+    // send timestamps for this node's own messages, indexed by message index
+    std::vector<std::atomic<uint64_t>> send_times(payload_sizes.size() * messages_per_phase);
+    // delivery latencies of this node's own measured (non-warmup) messages, per phase
+    std::vector<std::vector<uint64_t>> latency_samples(payload_sizes.size());
+    std::atomic<uint64_t> delivered_count(0);
+    uint32_t my_node_id = (uint32_t)-1;
+
+    auto stability_callback = [&](uint32_t subgroup, uint32_t sender_id, long long int index,
+                                  std::optional<std::pair<char*, long long int>> data,
+                                  persistent::version_t ver) {
+        if(sender_id == my_node_id) {
+            const uint32_t phase = index / messages_per_phase;
+            const uint32_t index_in_phase = index % messages_per_phase;
+            if(index_in_phase >= warmup_messages && phase < latency_samples.size()) {
+                const uint64_t sent_at = send_times[index].load(std::memory_order_relaxed);
+                latency_samples[phase].push_back(wallclock_ns() - sent_at);
+            }
+        }
+        delivered_count.fetch_add(1, std::memory_order_release);
+    };
+
+    auto membership_function = [num_nodes](const std::vector<std::type_index>& subgroup_type_order,
+                                           const std::unique_ptr<View>& prev_view, View& curr_view) {
+        if(curr_view.members.size() < num_nodes) {
+            throw subgroup_provisioning_exception();
+        }
+        subgroup_shard_layout_t subgroup_vector(1);
+        subgroup_vector[0].emplace_back(curr_view.make_subview(curr_view.members, Mode::ORDERED));
+        curr_view.next_unassigned_rank = curr_view.members.size();
+        subgroup_allocation_map_t subgroup_allocation;
+        subgroup_allocation.emplace(std::type_index(typeid(RawObject)), std::move(subgroup_vector));
+        return subgroup_allocation;
+    };
+    SubgroupInfo one_raw_group(membership_function);
+
+    Group<RawObject> group(CallbackSet{stability_callback},
+                           one_raw_group, nullptr, std::vector<view_upcall_t>{},
+                           &raw_object_factory);
+    const uint32_t node_rank = group.get_my_rank();
+    my_node_id = group.get_members()[node_rank];
+    cout << "Finished constructing/joining Group" << endl;
+
+    Replicated<RawObject>& raw_subgroup = group.get_subgroup<RawObject>();
+    std::ofstream results_file("derecho_bench." + std::to_string(node_rank) + ".json",
+                               std::ofstream::app);
+    uint64_t next_send_index = 0;
+
+    for(std::size_t phase = 0; phase < payload_sizes.size(); ++phase) {
+        const std::size_t payload_size = payload_sizes[phase];
+        group.barrier_sync();
+
+        auto send_one = [&raw_subgroup, &send_times, payload_size](uint64_t message_index) {
+            raw_subgroup.send(payload_size, [&send_times, message_index](char* buf) {
+                send_times[message_index].store(wallclock_ns(), std::memory_order_relaxed);
+            });
+        };
+        // warmup: fills windows and steadies the pipeline before measuring
+        for(uint32_t count = 0; count < warmup_messages; ++count) {
+            send_one(next_send_index++);
+        }
+        const uint64_t warmup_target = (uint64_t)(phase * messages_per_phase + warmup_messages) * num_nodes;
+        while(delivered_count.load(std::memory_order_acquire) < warmup_target) {
+        }
+
+        const uint64_t phase_start_ns = wallclock_ns();
+        for(uint32_t count = 0; count < num_messages; ++count) {
+            send_one(next_send_index++);
+        }
+        const uint64_t phase_target = (uint64_t)(phase + 1) * messages_per_phase * num_nodes;
+        while(delivered_count.load(std::memory_order_acquire) < phase_target) {
+        }
+        const uint64_t elapsed_ns = wallclock_ns() - phase_start_ns;
+
+        BenchmarkRecord record;
+        record.benchmark = "multicast";
+        record.parameters["num_nodes"] = num_nodes;
+        record.parameters["shard_size"] = num_nodes;
+        record.parameters["payload_size"] = payload_size;
+        record.parameters["window_size"] = getConfUInt32(CONF_SUBGROUP_DEFAULT_WINDOW_SIZE);
+        record.parameters["messages"] = num_messages;
+        record.parameters["warmup_messages"] = warmup_messages;
+        record.parameters["node_rank"] = node_rank;
+        const double total_bytes = (double)payload_size * num_messages * num_nodes;
+        record.metrics["throughput_MBps"] = total_bytes / (elapsed_ns / 1000.0);
+        const LatencyStats latency = compute_latency_stats(latency_samples[phase]);
+        record.metrics["latency_p50_us"] = latency.p50_us;
+        record.metrics["latency_p90_us"] = latency.p90_us;
+        record.metrics["latency_p99_us"] = latency.p99_us;
+        record.metrics["latency_max_us"] = latency.max_us;
+        record.metrics["latency_mean_us"] = latency.mean_us;
+        results_file << record.to_json() << endl;
+        cout << record.to_json() << endl;
+    }
+
+    group.barrier_sync();
+    group.leave();
+}
@@ -40,10 +40,39 @@ struct option Conf::long_options[] = {
         MAKE_LONG_OPT_ENTRY(CONF_DERECHO_RDMC_PORT),
         MAKE_LONG_OPT_ENTRY(CONF_DERECHO_HEARTBEAT_MS),
         MAKE_LONG_OPT_ENTRY(CONF_DERECHO_SST_POLL_CQ_TIMEOUT_MS),
+        MAKE_LONG_OPT_ENTRY(CONF_DERECHO_SST_IDLE_BACKOFF),
+        MAKE_LONG_OPT_ENTRY(CONF_DERECHO_SST_IDLE_SPIN_ROUNDS),
         MAKE_LONG_OPT_ENTRY(CONF_DERECHO_DISABLE_PARTITIONING_SAFETY),
 	MAKE_LONG_OPT_ENTRY(CONF_DERECHO_MAX_P2P_REQUEST_PAYLOAD_SIZE),
 	MAKE_LONG_OPT_ENTRY(CONF_DERECHO_MAX_P2P_REPLY_PAYLOAD_SIZE),
 	MAKE_LONG_OPT_ENTRY(CONF_DERECHO_P2P_WINDOW_SIZE),
+	MAKE_LONG_OPT_ENTRY(CONF_DERECHO_P2P_SMALL_REQUEST_PAYLOAD_SIZE),
+	MAKE_LONG_OPT_ENTRY(CONF_DERECHO_P2P_LARGE_WINDOW_SIZE),
+	MAKE_LONG_OPT_ENTRY(CONF_DERECHO_P2P_SPIN_WAIT_US),
+	MAKE_LONG_OPT_ENTRY(CONF_DERECHO_PIGGYBACK_REPLY_PAYLOAD_SIZE),
+	MAKE_LONG_OPT_ENTRY(CONF_DERECHO_PIGGYBACK_REPLY_WINDOW_SIZE),
+	MAKE_LONG_OPT_ENTRY(CONF_DERECHO_QUERY_SNAPSHOT_SIZE),
+	MAKE_LONG_OPT_ENTRY(CONF_DERECHO_STATE_TRANSFER_STRIPES),
+	MAKE_LONG_OPT_ENTRY(CONF_DERECHO_STATE_TRANSFER_PORT),
+	MAKE_LONG_OPT_ENTRY(CONF_DERECHO_STATE_TRANSFER_RDMA),
+	MAKE_LONG_OPT_ENTRY(CONF_DERECHO_STATE_TRANSFER_LOG_SUFFIX),
+	MAKE_LONG_OPT_ENTRY(CONF_DERECHO_LAZY_OBJECT_INIT),
+	MAKE_LONG_OPT_ENTRY(CONF_DERECHO_DELTA_VIEWS),
+	MAKE_LONG_OPT_ENTRY(CONF_DERECHO_CONNECT_CONCURRENCY),
+	MAKE_LONG_OPT_ENTRY(CONF_DERECHO_USE_HUGEPAGES),
+	MAKE_LONG_OPT_ENTRY(CONF_DERECHO_SST_NUMA_NODE),
+	MAKE_LONG_OPT_ENTRY(CONF_DERECHO_SST_DIRTY_TRACKING),
+	MAKE_LONG_OPT_ENTRY(CONF_DERECHO_PREDICATE_THREAD_CPU),
+	MAKE_LONG_OPT_ENTRY(CONF_DERECHO_PREDICATE_SHARDS),
+	MAKE_LONG_OPT_ENTRY(CONF_DERECHO_BACKGROUND_PREDICATE_INTERVAL),
+	MAKE_LONG_OPT_ENTRY(CONF_DERECHO_SST_POLL_THREAD_CPU),
+	MAKE_LONG_OPT_ENTRY(CONF_DERECHO_POLL_ENGINE_CPU),
+	MAKE_LONG_OPT_ENTRY(CONF_DERECHO_SENDER_THREAD_CPU),
+	MAKE_LONG_OPT_ENTRY(CONF_DERECHO_RPC_WORKER_THREADS),
+	MAKE_LONG_OPT_ENTRY(CONF_DERECHO_JOIN_HANDLER_THREADS),
+	MAKE_LONG_OPT_ENTRY(CONF_DERECHO_MAX_EXTERNAL_CONNECTIONS),
+	MAKE_LONG_OPT_ENTRY(CONF_DERECHO_EXTERNAL_IDLE_TIMEOUT_MS),
+	MAKE_LONG_OPT_ENTRY(CONF_DERECHO_EXTERNAL_PORT),
         // [SUBGROUP/<subgroup name>]
         MAKE_LONG_OPT_ENTRY(CONF_SUBGROUP_DEFAULT_RDMC_SEND_ALGORITHM),
         MAKE_LONG_OPT_ENTRY(CONF_SUBGROUP_DEFAULT_MAX_PAYLOAD_SIZE),
@@ -51,17 +80,37 @@ struct option Conf::long_options[] = {
         MAKE_LONG_OPT_ENTRY(CONF_SUBGROUP_DEFAULT_MAX_SMC_PAYLOAD_SIZE),
         MAKE_LONG_OPT_ENTRY(CONF_SUBGROUP_DEFAULT_BLOCK_SIZE),
         MAKE_LONG_OPT_ENTRY(CONF_SUBGROUP_DEFAULT_WINDOW_SIZE),
+        MAKE_LONG_OPT_ENTRY(CONF_SUBGROUP_DEFAULT_SMC_BATCH_SIZE),
+        MAKE_LONG_OPT_ENTRY(CONF_SUBGROUP_DEFAULT_SMC_BATCH_TIMEOUT_US),
+        MAKE_LONG_OPT_ENTRY(CONF_SUBGROUP_DEFAULT_NULL_SEND_SUPPRESSION),
+        MAKE_LONG_OPT_ENTRY(CONF_SUBGROUP_DEFAULT_SENDER_PRIORITY),
         // [RDMA]
         MAKE_LONG_OPT_ENTRY(CONF_RDMA_PROVIDER),
         MAKE_LONG_OPT_ENTRY(CONF_RDMA_DOMAIN),
+        MAKE_LONG_OPT_ENTRY(CONF_RDMA_SECOND_DOMAIN),
         MAKE_LONG_OPT_ENTRY(CONF_RDMA_TX_DEPTH),
         MAKE_LONG_OPT_ENTRY(CONF_RDMA_RX_DEPTH),
+        MAKE_LONG_OPT_ENTRY(CONF_RDMA_MR_CACHE_SIZE),
+        MAKE_LONG_OPT_ENTRY(CONF_RDMA_RDMC_SEND_QUEUE_DEPTH),
+        MAKE_LONG_OPT_ENTRY(CONF_RDMA_ENABLE_HMEM),
+        MAKE_LONG_OPT_ENTRY(CONF_RDMA_PINNED_MEMORY_BUDGET_MB),
+        MAKE_LONG_OPT_ENTRY(CONF_RDMA_UD_MCAST_ADDR),
+        MAKE_LONG_OPT_ENTRY(CONF_RDMA_UD_MCAST_PORT),
         // [PERS]
         MAKE_LONG_OPT_ENTRY(CONF_PERS_FILE_PATH),
         MAKE_LONG_OPT_ENTRY(CONF_PERS_RAMDISK_PATH),
         MAKE_LONG_OPT_ENTRY(CONF_PERS_RESET),
         MAKE_LONG_OPT_ENTRY(CONF_PERS_MAX_LOG_ENTRY),
         MAKE_LONG_OPT_ENTRY(CONF_PERS_MAX_DATA_SIZE),
+        MAKE_LONG_OPT_ENTRY(CONF_PERS_PARALLEL_PERSISTENCE),
+        MAKE_LONG_OPT_ENTRY(CONF_PERS_USE_IO_URING),
+        MAKE_LONG_OPT_ENTRY(CONF_PERS_PMEM_PATH),
+        MAKE_LONG_OPT_ENTRY(CONF_PERS_VERIFY_ON_LOAD),
+        MAKE_LONG_OPT_ENTRY(CONF_PERS_SNAPSHOT_INTERVAL),
+        MAKE_LONG_OPT_ENTRY(CONF_PERS_COMPRESSION),
+        MAKE_LONG_OPT_ENTRY(CONF_PERS_COMPACTION_INTERVAL_MS),
+        MAKE_LONG_OPT_ENTRY(CONF_PERS_COMPACTION_THROTTLE_MS),
+        MAKE_LONG_OPT_ENTRY(CONF_PERS_CHECKPOINT_INTERVAL_MS),
         {0, 0, 0, 0}};
 
 void Conf::initialize(int argc, char* argv[], const char* conf_file) {
@@ -107,6 +156,31 @@ const Conf* Conf::get() noexcept {
     return Conf::singleton.get();
 }
 
+const ConfSnapshot& getConfSnapshot() {
+    // materialized once, on first use after the Conf singleton exists; the
+    // configuration is immutable after initialize(), so a plain static is safe
+    static const ConfSnapshot snapshot = [] {
+        const Conf* conf = Conf::get();
+        ConfSnapshot s;
+        s.heartbeat_ms = conf->getUInt32(CONF_DERECHO_HEARTBEAT_MS);
+        s.sst_poll_cq_timeout_ms = conf->getUInt32(CONF_DERECHO_SST_POLL_CQ_TIMEOUT_MS);
+        s.sst_idle_backoff = conf->getBoolean(CONF_DERECHO_SST_IDLE_BACKOFF);
+        s.sst_idle_spin_rounds = conf->getUInt32(CONF_DERECHO_SST_IDLE_SPIN_ROUNDS);
+        s.background_predicate_interval = conf->getUInt32(CONF_DERECHO_BACKGROUND_PREDICATE_INTERVAL);
+        s.disable_partitioning_safety = conf->getBoolean(CONF_DERECHO_DISABLE_PARTITIONING_SAFETY);
+        s.max_p2p_request_payload_size = conf->getUInt64(CONF_DERECHO_MAX_P2P_REQUEST_PAYLOAD_SIZE);
+        s.max_p2p_reply_payload_size = conf->getUInt64(CONF_DERECHO_MAX_P2P_REPLY_PAYLOAD_SIZE);
+        s.p2p_window_size = conf->getUInt32(CONF_DERECHO_P2P_WINDOW_SIZE);
+        s.p2p_small_request_payload_size = conf->getUInt64(CONF_DERECHO_P2P_SMALL_REQUEST_PAYLOAD_SIZE);
+        s.p2p_large_window_size = conf->getUInt32(CONF_DERECHO_P2P_LARGE_WINDOW_SIZE);
+        s.p2p_spin_wait_us = conf->getUInt32(CONF_DERECHO_P2P_SPIN_WAIT_US);
+        s.piggyback_reply_payload_size = conf->getUInt64(CONF_DERECHO_PIGGYBACK_REPLY_PAYLOAD_SIZE);
+        s.piggyback_reply_window_size = conf->getUInt32(CONF_DERECHO_PIGGYBACK_REPLY_WINDOW_SIZE);
+        return s;
+    }();
+    return snapshot;
+}
+
 const std::string& getConfString(const std::string& key) {
     return Conf::get()->getString(key);
 }
@@ -1,36 +1,50 @@
 #include <derecho/core/detail/connection_manager.hpp>
 
+#include <derecho/conf/conf.hpp>
+
+#include <algorithm>
+#include <atomic>
 #include <cassert>
 #include <iostream>
+#include <list>
 #include <set>
+#include <thread>
 
 namespace tcp {
+socket tcp_connections::connect_to_node(const node_id_t other_id,
+                                        const std::pair<ip_addr_t, uint16_t>& other_ip_and_port) {
+    socket connected_socket;
+    try {
+        connected_socket = socket(other_ip_and_port.first, other_ip_and_port.second);
+    } catch(exception) {
+        std::cerr << "WARNING: failed to connect to node " << other_id << " at "
+                  << other_ip_and_port.first << ":" << other_ip_and_port.second << std::endl;
+        return socket();
+    }
+
+    node_id_t remote_id = 0;
+    if(!connected_socket.exchange(my_id, remote_id)) {
+        std::cerr << "WARNING: failed to exchange rank with node "
+                  << other_id << " at " << other_ip_and_port.first << ":" << other_ip_and_port.second
+                  << std::endl;
+        return socket();
+    } else if(remote_id != other_id) {
+        std::cerr << "WARNING: node at " << other_ip_and_port.first << ":" << other_ip_and_port.second
+                  << " replied with wrong id (expected " << other_id
+                  << " but got " << remote_id << ")" << std::endl;
+        return socket();
+    }
+    return connected_socket;
+}
+
 bool tcp_connections::add_connection(const node_id_t other_id,
                                      const std::pair<ip_addr_t, uint16_t>& other_ip_and_port) {
     if(other_id < my_id) {
-        try {
-            sockets[other_id] = socket(other_ip_and_port.first, other_ip_and_port.second);
-        } catch(exception) {
-            std::cerr << "WARNING: failed to connect to node " << other_id << " at "
-                      << other_ip_and_port.first << ":" << other_ip_and_port.second << std::endl;
-            return false;
-        }
-
-        node_id_t remote_id = 0;
-        if(!sockets[other_id].exchange(my_id, remote_id)) {
-            std::cerr << "WARNING: failed to exchange rank with node "
-                      << other_id << " at " << other_ip_and_port.first << ":" << other_ip_and_port.second
-                      << std::endl;
-            sockets.erase(other_id);
-            return false;
-        } else if(remote_id != other_id) {
-            std::cerr << "WARNING: node at " << other_ip_and_port.first << ":" << other_ip_and_port.second
-                      << " replied with wrong id (expected " << other_id
-                      << " but got " << remote_id << ")" << std::endl;
-
-            sockets.erase(other_id);
+        socket connected_socket = connect_to_node(other_id, other_ip_and_port);
+        if(connected_socket.is_empty()) {
             return false;
         }
+        sockets[other_id] = std::move(connected_socket);
         return true;
     } else if(other_id > my_id) {
         while(true) {
@@ -64,10 +78,45 @@ bool tcp_connections::add_connection(const node_id_t other_id,
 void tcp_connections::establish_node_connections(const std::map<node_id_t, std::pair<ip_addr_t, uint16_t>>& ip_addrs_and_ports) {
     conn_listener = std::make_unique<connection_listener>(ip_addrs_and_ports.at(my_id).second);
 
+    //The connections this node initiates (to lower-ID members) are independent
+    //of each other, so open them concurrently with a bounded number of worker
+    //threads instead of paying one serial connect handshake per peer
+    std::vector<std::pair<node_id_t, std::pair<ip_addr_t, uint16_t>>> outgoing_peers;
+    for(const auto& id_addr_pair : ip_addrs_and_ports) {
+        if(id_addr_pair.first < my_id) {
+            outgoing_peers.emplace_back(id_addr_pair);
+        }
+    }
+    const std::size_t num_connect_threads = std::min(
+            static_cast<std::size_t>(std::max(1u, derecho::getConfUInt32(CONF_DERECHO_CONNECT_CONCURRENCY))),
+            outgoing_peers.size());
+    std::atomic<std::size_t> next_peer_index(0);
+    std::list<std::thread> connect_threads;
+    for(std::size_t thread_num = 0; thread_num < num_connect_threads; ++thread_num) {
+        connect_threads.emplace_back([this, &outgoing_peers, &next_peer_index]() {
+            for(std::size_t peer_index = next_peer_index.fetch_add(1);
+                peer_index < outgoing_peers.size();
+                peer_index = next_peer_index.fetch_add(1)) {
+                socket connected_socket = connect_to_node(outgoing_peers[peer_index].first,
+                                                          outgoing_peers[peer_index].second);
+                if(!connected_socket.is_empty()) {
+                    std::lock_guard<std::mutex> lock(sockets_mutex);
+                    sockets[outgoing_peers[peer_index].first] = std::move(connected_socket);
+                }
+            }
+        });
+    }
+    for(std::thread& connect_thread : connect_threads) {
+        connect_thread.join();
+    }
+
+    //Connections from higher-ID members all arrive on the shared listener, so
+    //accept them one at a time; the per-connection work here is only a quick
+    //ID exchange, since the remote nodes connect to us in parallel
     for(auto it = ip_addrs_and_ports.begin(); it != ip_addrs_and_ports.end(); it++) {
         //Check that there isn't already a connection to this ID,
         //since an earlier add_connection could have connected to it by "mistake"
-        if(it->first != my_id && sockets.count(it->first) == 0) {
+        if(it->first > my_id && sockets.count(it->first) == 0) {
             if(!add_connection(it->first, it->second)) {
                 std::cerr << "WARNING: failed to connect to node " << it->first
                           << " at " << it->second.first
@@ -94,7 +143,11 @@ bool tcp_connections::write(node_id_t node_id, char const* buffer,
     std::lock_guard<std::mutex> lock(sockets_mutex);
     const auto it = sockets.find(node_id);
     assert(it != sockets.end());
-    return it->second.write(buffer, size);
+    const bool success = it->second.write(buffer, size);
+    if(!success && failure_callback) {
+        failure_callback(node_id);
+    }
+    return success;
 }
 
 bool tcp_connections::write_all(char const* buffer, size_t size) {
@@ -104,7 +157,11 @@ bool tcp_connections::write_all(char const* buffer, size_t size) {
         if(p.first == my_id) {
             continue;
         }
-        success = success && p.second.write(buffer, size);
+        const bool write_success = p.second.write(buffer, size);
+        if(!write_success && failure_callback) {
+            failure_callback(p.first);
+        }
+        success = success && write_success;
     }
     return success;
 }
@@ -114,7 +171,11 @@ bool tcp_connections::read(node_id_t node_id, char* buffer,
     std::lock_guard<std::mutex> lock(sockets_mutex);
     const auto it = sockets.find(node_id);
     assert(it != sockets.end());
-    return it->second.read(buffer, size);
+    const bool success = it->second.read(buffer, size);
+    if(!success && failure_callback) {
+        failure_callback(node_id);
+    }
+    return success;
 }
 
 bool tcp_connections::add_node(node_id_t new_id, const std::pair<ip_addr_t, uint16_t>& new_ip_addr_and_port) {
@@ -131,6 +192,11 @@ bool tcp_connections::delete_node(node_id_t remove_id) {
     return (sockets.erase(remove_id) > 0);
 }
 
+void tcp_connections::set_failure_callback(const std::function<void(node_id_t)>& callback) {
+    std::lock_guard<std::mutex> lock(sockets_mutex);
+    failure_callback = callback;
+}
+
 bool tcp_connections::contains_node(node_id_t node_id) {
     std::lock_guard<std::mutex> lock(sockets_mutex);
     return (sockets.find(node_id) != sockets.end());
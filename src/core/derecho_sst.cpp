@@ -28,6 +28,14 @@ void DerechoSST::init_local_row_from_previous(const DerechoSST& old_sst, const i
     memcpy(const_cast<uint16_t*>(joiner_rdmc_ports[local_row]),
            const_cast<const uint16_t*>(old_sst.joiner_rdmc_ports[row] + num_changes_installed),
            (old_sst.joiner_rdmc_ports.size() - num_changes_installed) * sizeof(uint16_t));
+    //Carry this node's performance counters over from the previous View's SST
+    memcpy(const_cast<uint64_t*>(perf_counters[local_row]),
+           const_cast<const uint64_t*>(old_sst.perf_counters[row]),
+           perf_counters.size() * sizeof(uint64_t));
+    //Carry the barrier counter and load metric over too, so barriers in
+    //progress and published load survive view changes
+    barrier_counter[local_row] = old_sst.barrier_counter[row];
+    load_metric[local_row] = old_sst.load_metric[row];
     for(size_t i = 0; i < suspected.size(); ++i) {
         suspected[local_row][i] = false;
     }
@@ -1,6 +1,7 @@
 #include <algorithm>
 #include <cassert>
 #include <chrono>
+#include <cstring>
 #include <limits>
 #include <thread>
 
@@ -8,7 +9,12 @@
 #include <derecho/core/detail/multicast_group.hpp>
 #include <derecho/persistent/Persistent.hpp>
 #include <derecho/rdmc/detail/util.hpp>
+#include <derecho/sst/detail/scan_kernel.hpp>
 #include <derecho/utils/logger.hpp>
+#include <derecho/utils/timeline.hpp>
+#include <derecho/utils/perf_events.hpp>
+#include <derecho/utils/phase_occupancy.hpp>
+#include <derecho/utils/numa_placement.hpp>
 
 namespace derecho {
 
@@ -25,6 +31,83 @@ size_t index_of(T container, U elem) {
     return container.size();
 }
 
+std::mutex MessageBufferPool::pool_mutex;
+std::map<size_t, std::vector<MessageBuffer>> MessageBufferPool::free_buffers;
+
+size_t MessageBufferPool::size_class(size_t size) {
+    size_t rounded = 1;
+    while(rounded < size) {
+        rounded <<= 1;
+    }
+    return rounded;
+}
+
+MessageBuffer MessageBufferPool::get(size_t size) {
+    const size_t rounded_size = size_class(size);
+    {
+        std::lock_guard<std::mutex> lock(pool_mutex);
+        auto bucket = free_buffers.find(rounded_size);
+        if(bucket != free_buffers.end() && !bucket->second.empty()) {
+            MessageBuffer buffer = std::move(bucket->second.back());
+            bucket->second.pop_back();
+            return buffer;
+        }
+    }
+    // Allocate (and RDMA-register) outside the lock; registration is slow
+    return MessageBuffer(rounded_size);
+}
+
+void MessageBufferPool::give_back(MessageBuffer&& buffer) {
+    if(!buffer.buffer) {
+        return;
+    }
+    if(buffer.release_callback) {
+        // A zero-copy send: the bytes belong to the user, so hand them back
+        // instead of pooling them
+        buffer.release_callback();
+        return;
+    }
+    std::lock_guard<std::mutex> lock(pool_mutex);
+    free_buffers[buffer.capacity].push_back(std::move(buffer));
+}
+
+void MessageBufferPool::prefault(size_t size, size_t count) {
+    const size_t rounded_size = size_class(size);
+    size_t existing;
+    {
+        std::lock_guard<std::mutex> lock(pool_mutex);
+        existing = free_buffers[rounded_size].size();
+    }
+    if(existing >= count) {
+        return;
+    }
+    // Like get(), allocate and register outside the lock. Registration pins
+    // the pages; the memset additionally touches every page, so nothing is
+    // left for a first-transfer fault even on NICs that register lazily
+    // (on-demand paging).
+    std::vector<MessageBuffer> fresh;
+    fresh.reserve(count - existing);
+    for(size_t i = existing; i < count; ++i) {
+        MessageBuffer new_buffer(rounded_size);
+        std::memset(new_buffer.buffer.get(), 0, rounded_size);
+        fresh.push_back(std::move(new_buffer));
+    }
+    std::lock_guard<std::mutex> lock(pool_mutex);
+    auto& bucket = free_buffers[rounded_size];
+    for(MessageBuffer& new_buffer : fresh) {
+        bucket.push_back(std::move(new_buffer));
+    }
+}
+
+void MessageBufferPool::debug_print() {
+    std::lock_guard<std::mutex> lock(pool_mutex);
+    std::cout << "Printing memory usage of the message buffer pool" << std::endl;
+    for(const auto& p : free_buffers) {
+        std::cout << "Size class " << p.first << ", Number of free buffers "
+                  << p.second.size() << std::endl;
+    }
+}
+
 MulticastGroup::MulticastGroup(
         std::vector<node_id_t> _members, node_id_t my_node_id,
         std::shared_ptr<DerechoSST> sst,
@@ -42,13 +125,24 @@ MulticastGroup::MulticastGroup(
           total_num_subgroups(total_num_subgroups),
           subgroup_settings_map(subgroup_settings_by_id),
           received_intervals(sst->num_received.size(), {-1, -1}),
+          num_received_sst_drained(sst->num_received.size(), -1),
+          piggyback_reply_max_size(getConfSnapshot().piggyback_reply_payload_size),
+          piggyback_reply_window(getConfSnapshot().piggyback_reply_window_size),
+          piggyback_replies_sent(members.size(), 0),
+          piggyback_replies_consumed(members.size(), 0),
           rdmc_group_num_offset(0),
           future_message_indices(total_num_subgroups, 0),
+          adaptive_send_windows(total_num_subgroups),
+          adaptive_medium_selectors(total_num_subgroups),
+          send_credits_callbacks(total_num_subgroups),
+          first_suppressed_null_index(total_num_subgroups, -1),
+          deferred_auto_null_targets(total_num_subgroups, -1),
           next_sends(total_num_subgroups),
           pending_sends(total_num_subgroups),
           current_sends(total_num_subgroups),
           next_message_to_deliver(total_num_subgroups),
           sender_timeout(sender_timeout),
+          delivery_offloaded(getConfUInt32(CONF_DERECHO_TRIGGER_OFFLOAD_THREADS) > 0),
           sst(sst),
           sst_multicast_group_ptrs(total_num_subgroups),
           last_transfer_medium(total_num_subgroups),
@@ -57,17 +151,14 @@ MulticastGroup::MulticastGroup(
     for(uint i = 0; i < num_members; ++i) {
         node_id_to_sst_index[members[i]] = i;
     }
-
-    // for(const auto p : subgroup_settings_by_id) {
-    //     subgroup_id_t id = p.first;
-    //     const SubgroupSettings& settings = p.second;
-    //     auto num_shard_members = settings.members.size();
-    //     while(free_message_buffers[id].size() < settings.profile.window_size * num_shard_members) {
-    //         free_message_buffers[id].emplace_back(settings.profile.max_msg_size);
-    //     }
-    // }
+    for(const auto& p : subgroup_settings_map) {
+        adaptive_send_windows[p.first].effective_window = p.second.profile.window_size;
+        adaptive_medium_selectors[p.first].crossover = p.second.profile.sst_max_msg_size;
+    }
 
     initialize_sst_row();
+    // warm the buffer pool before RDMC groups start accepting receives
+    prefault_message_buffers();
     bool no_member_failed = true;
     if(already_failed.size()) {
         for(uint i = 0; i < num_members; ++i) {
@@ -102,14 +193,27 @@ MulticastGroup::MulticastGroup(
           total_num_subgroups(total_num_subgroups),
           subgroup_settings_map(subgroup_settings_by_id),
           received_intervals(sst->num_received.size(), {-1, -1}),
+          num_received_sst_drained(sst->num_received.size(), -1),
           rpc_callback(old_group.rpc_callback),
+          rpc_order_insensitive_query(old_group.rpc_order_insensitive_query),
+          piggyback_reply_max_size(old_group.piggyback_reply_max_size),
+          piggyback_reply_window(old_group.piggyback_reply_window),
+          piggyback_replies_sent(members.size(), 0),
+          piggyback_replies_consumed(members.size(), 0),
           rdmc_group_num_offset(old_group.rdmc_group_num_offset + old_group.num_members),
+          prior_rdmc_groups(std::move(old_group.rdmc_groups_created)),
           future_message_indices(total_num_subgroups, 0),
+          adaptive_send_windows(total_num_subgroups),
+          adaptive_medium_selectors(total_num_subgroups),
+          send_credits_callbacks(total_num_subgroups),
+          first_suppressed_null_index(total_num_subgroups, -1),
+          deferred_auto_null_targets(total_num_subgroups, -1),
           next_sends(total_num_subgroups),
           pending_sends(total_num_subgroups),
           current_sends(total_num_subgroups),
           next_message_to_deliver(total_num_subgroups),
           sender_timeout(old_group.sender_timeout),
+          delivery_offloaded(old_group.delivery_offloaded),
           sst(sst),
           sst_multicast_group_ptrs(total_num_subgroups),
           last_transfer_medium(total_num_subgroups),
@@ -124,6 +228,17 @@ MulticastGroup::MulticastGroup(
     for(uint i = 0; i < num_members; ++i) {
         node_id_to_sst_index[members[i]] = i;
     }
+    for(const auto& p : subgroup_settings_map) {
+        adaptive_send_windows[p.first].effective_window = p.second.profile.window_size;
+        adaptive_medium_selectors[p.first].crossover = p.second.profile.sst_max_msg_size;
+    }
+    // Carry applications' send-credit callbacks over to the new view,
+    // matching subgroups by ID
+    for(uint32_t subgroup_num = 0;
+        subgroup_num < std::min(total_num_subgroups, static_cast<uint32_t>(old_group.send_credits_callbacks.size()));
+        ++subgroup_num) {
+        send_credits_callbacks[subgroup_num] = std::move(old_group.send_credits_callbacks[subgroup_num]);
+    }
 
     // Convience function that takes a msg from the old group and
     // produces one suitable for this group.
@@ -141,20 +256,28 @@ MulticastGroup::MulticastGroup(
         return std::move(msg);
     };
 
-    // Reclaim RDMCMessageBuffers from the old group, and supplement them with
-    // additional if the group has grown.
+    // Reclaim RDMCMessageBuffers from the old group into the process-wide
+    // pool, where the new group's subgroups will find them (already
+    // registered) on demand.
     std::lock_guard<std::recursive_mutex> lock(old_group.msg_state_mtx);
-    for(const auto p : subgroup_settings_by_id) {
-        const subgroup_id_t subgroup_num = p.first;
-        // for later: don't move extra message buffers
-        free_message_buffers[subgroup_num].swap(old_group.free_message_buffers[subgroup_num]);
-    }
-
     for(auto& msg : old_group.current_receives) {
-        free_message_buffers[msg.first.first].push_back(std::move(msg.second.message_buffer));
+        MessageBufferPool::give_back(std::move(msg.second.message_buffer));
     }
     old_group.current_receives.clear();
 
+    // Notifies the application that a message it may have acted on
+    // speculatively was dropped by this view change and will not be
+    // delivered (a re-sent message arrives under a new index).
+    auto abort_speculation = [this](subgroup_id_t subgroup_num, node_id_t sender_id,
+                                    message_id_t index, const header* h, uint64_t size) {
+        if(callbacks.speculative_abort_callback && !h->cooked_send
+           && h->fragment_state == static_cast<uint8_t>(FragmentState::COMPLETE)
+           && size > h->header_size) {
+            callbacks.speculative_abort_callback(subgroup_num, sender_id, index, {},
+                                                 persistent::INVALID_VERSION);
+        }
+    };
+
     // Assume that any locally stable messages failed. If we were the sender
     // than re-attempt, otherwise discard. TODO: Presumably the ragged edge
     // cleanup will want the chance to deliver some of these.
@@ -164,36 +287,35 @@ MulticastGroup::MulticastGroup(
         }
 
         for(auto& q : p.second) {
+            abort_speculation(p.first, q.second.sender_id, q.second.index,
+                              (const header*)q.second.message_buffer.buffer.get(), q.second.size);
             if(q.second.sender_id == members[member_index]) {
-                pending_sends[p.first].push(convert_msg(q.second, p.first));
+                pending_sends[p.first].try_enqueue(convert_msg(q.second, p.first));
             } else {
-                free_message_buffers[p.first].push_back(std::move(q.second.message_buffer));
+                MessageBufferPool::give_back(std::move(q.second.message_buffer));
             }
         }
     }
     old_group.locally_stable_rdmc_messages.clear();
 
-    // for(const auto p : subgroup_settings_by_id) {
-    //     subgroup_id_t id = p.first;
-    //     const SubgroupSettings& settings = p.second;
-    //     auto num_shard_members = settings.members.size();
-    //     while(free_message_buffers[id].size() < settings.profile.window_size * num_shard_members) {
-    //         free_message_buffers[id].emplace_back(settings.profile.max_msg_size);
-    //     }
-    // }
-
+    for(auto& p : old_group.locally_stable_sst_messages) {
+        for(auto& q : p.second) {
+            abort_speculation(p.first, q.second.sender_id, q.second.index,
+                              (const header*)q.second.buf, q.second.size);
+        }
+    }
     old_group.locally_stable_sst_messages.clear();
 
     // Any messages that were being sent should be re-attempted.
     for(const auto& p : subgroup_settings_by_id) {
         auto subgroup_num = p.first;
         if(old_group.current_sends.size() > subgroup_num && old_group.current_sends[subgroup_num]) {
-            pending_sends[subgroup_num].push(convert_msg(*old_group.current_sends[subgroup_num], subgroup_num));
+            pending_sends[subgroup_num].try_enqueue(convert_msg(*old_group.current_sends[subgroup_num], subgroup_num));
         }
 
         if(old_group.pending_sends.size() > subgroup_num) {
-            while(!old_group.pending_sends[subgroup_num].empty()) {
-                pending_sends[subgroup_num].push(convert_msg(old_group.pending_sends[subgroup_num].front(), subgroup_num));
+            while(RDMCMessage* old_pending = old_group.pending_sends[subgroup_num].peek()) {
+                pending_sends[subgroup_num].try_enqueue(convert_msg(*old_pending, subgroup_num));
                 old_group.pending_sends[subgroup_num].pop();
             }
         }
@@ -215,6 +337,8 @@ MulticastGroup::MulticastGroup(
     }
 
     initialize_sst_row();
+    // warm the buffer pool before RDMC groups start accepting receives
+    prefault_message_buffers();
     bool no_member_failed = true;
     if(already_failed.size()) {
         for(uint i = 0; i < num_members; ++i) {
@@ -233,6 +357,35 @@ MulticastGroup::MulticastGroup(
     timeout_thread = std::thread(&MulticastGroup::check_failures_loop, this);
 }
 
+void MulticastGroup::prefault_message_buffers() {
+    if(!getConfBoolean(CONF_DERECHO_WARMUP_ON_STARTUP)) {
+        return;
+    }
+    /* Steady-state pool demand per RDMC-mode subgroup: one in-flight receive
+     * buffer per sender, plus a window's worth of send buffers if this node
+     * sends. Small-message subgroups ride in SST slots, whose pages were
+     * pinned when the SST's memory was registered, so they draw nothing from
+     * the pool. Demand is summed by size class because the pool is shared
+     * across subgroups. */
+    std::map<size_t, size_t> demand_by_class;
+    for(const auto& p : subgroup_settings_map) {
+        const SubgroupSettings& subgroup_settings = p.second;
+        const DerechoParams& profile = subgroup_settings.profile;
+        if(profile.max_msg_size <= profile.sst_max_msg_size) {
+            continue;
+        }
+        size_t demand = std::count(subgroup_settings.senders.begin(),
+                                   subgroup_settings.senders.end(), 1);
+        if(subgroup_settings.sender_rank >= 0) {
+            demand += profile.window_size;
+        }
+        demand_by_class[MessageBufferPool::size_class(profile.max_msg_size)] += demand;
+    }
+    for(const auto& [buffer_size, count] : demand_by_class) {
+        MessageBufferPool::prefault(buffer_size, count);
+    }
+}
+
 bool MulticastGroup::create_rdmc_sst_groups() {
     for(const auto& p : subgroup_settings_map) {
         uint32_t subgroup_num = p.first;
@@ -245,7 +398,8 @@ bool MulticastGroup::create_rdmc_sst_groups() {
 
         sst_multicast_group_ptrs[subgroup_num] = std::make_unique<sst::multicast_group<DerechoSST>>(
                 sst, shard_sst_indices, subgroup_settings.profile.window_size, subgroup_settings.profile.sst_max_msg_size, subgroup_settings.senders,
-                subgroup_settings.num_received_offset, subgroup_settings.slot_offset);
+                subgroup_settings.num_received_offset, subgroup_settings.slot_offset, false,
+                subgroup_settings.profile.smc_batch_size, subgroup_settings.profile.smc_batch_timeout_us);
 
         for(uint shard_rank = 0, sender_rank = -1; shard_rank < num_shard_members; ++shard_rank) {
             // don't create RDMC group if the shard member is never going to send
@@ -267,8 +421,8 @@ bool MulticastGroup::create_rdmc_sst_groups() {
                 const int32_t index = h->index;
                 message_id_t sequence_number = index * num_shard_senders + sender_rank;
 
-                dbg_default_trace("Locally received message in subgroup {}, sender rank {}, index {}",
-                                  subgroup_num, shard_rank, index);
+                trc_default_event("rdmc_local_receive", subgroup_num, sequence_number);
+                MessageTimeline::record(subgroup_num, sequence_number, MessageTimeline::RDMC_RECEIVE);
                 // Move message from current_receives to locally_stable_rdmc_messages.
                 if(node_id == members[member_index]) {
                     assert(current_sends[subgroup_num]);
@@ -285,22 +439,61 @@ bool MulticastGroup::create_rdmc_sst_groups() {
                     current_receives.erase(it);
                 }
 
+                /* Order-insensitive delivery: a cooked message whose target
+                 * function was tagged commutative is handed to the RPC layer as
+                 * soon as it arrives; it stays in the delivery queue so version
+                 * assignment and stability callbacks still happen in order. */
+                if(subgroup_settings.mode != Mode::UNORDERED && h->cooked_send
+                   && h->fragment_state == static_cast<uint8_t>(FragmentState::COMPLETE)
+                   && rpc_order_insensitive_query) {
+                    RDMCMessage& stashed_msg = locally_stable_rdmc_messages[subgroup_num][sequence_number];
+                    char* payload = stashed_msg.message_buffer.buffer.get() + h->header_size;
+                    const uint32_t payload_size = stashed_msg.size - h->header_size;
+                    if(stashed_msg.size > h->header_size
+                       && rpc_order_insensitive_query(subgroup_num, payload, payload_size)) {
+                        rpc_callback(subgroup_num, node_id, payload, payload_size);
+                        stashed_msg.delivered_early = true;
+                    }
+                }
+
+                /* Speculative delivery: hand raw payloads to the application
+                 * on local receipt; delivery in order later confirms the
+                 * speculation, a view change that drops the message aborts
+                 * it. */
+                if(callbacks.speculative_delivery_callback && !h->cooked_send
+                   && h->fragment_state == static_cast<uint8_t>(FragmentState::COMPLETE)
+                   && size > h->header_size) {
+                    callbacks.speculative_delivery_callback(
+                            subgroup_num, node_id, index,
+                            {{data + h->header_size, static_cast<long long int>(size - h->header_size)}},
+                            persistent::INVALID_VERSION);
+                }
+
                 auto new_num_received = resolve_num_received(index, subgroup_settings.num_received_offset + sender_rank);
                 /* NULL Send Scheme */
                 // only if I am a sender in the subgroup and the subgroup is not in UNORDERED mode
-                if(subgroup_settings.sender_rank >= 0 && subgroup_settings.mode != Mode::UNORDERED) {
-                    if(subgroup_settings.sender_rank < (int)sender_rank) {
-                        while(future_message_indices[subgroup_num] <= new_num_received) {
-                            get_buffer_and_send_auto_null(subgroup_num);
-                        }
-                    } else if(subgroup_settings.sender_rank > (int)sender_rank) {
-                        while(future_message_indices[subgroup_num] < new_num_received) {
-                            get_buffer_and_send_auto_null(subgroup_num);
+                if(subgroup_settings.sender_rank >= 0 && subgroup_settings.mode != Mode::UNORDERED
+                   && subgroup_settings.sender_rank != (int)sender_rank) {
+                    // lower-ranked senders must catch up to this sender's index;
+                    // higher-ranked ones stay one index behind it
+                    const int32_t target_index = (subgroup_settings.sender_rank < (int)sender_rank)
+                                                         ? new_num_received + 1
+                                                         : new_num_received;
+                    if(subgroup_settings.profile.null_send_suppression) {
+                        suppress_auto_null_sends(subgroup_num, subgroup_settings, target_index);
+                    } else {
+                        while(future_message_indices[subgroup_num] < target_index) {
+                            if(!get_buffer_and_send_auto_null(subgroup_num)) {
+                                // ring full; delivery_trigger retries once slots free up
+                                deferred_auto_null_targets[subgroup_num] = target_index;
+                                break;
+                            }
                         }
                     }
                 }
 
                 // deliver immediately if in UNORDERED mode
+                bool sst_slots_released = false;
                 if(subgroup_settings.mode == Mode::UNORDERED) {
                     // issue stability upcalls for the recently sequenced messages
                     for(int i = sst->num_received[member_index][subgroup_settings.num_received_offset + sender_rank] + 1;
@@ -322,6 +515,9 @@ bool MulticastGroup::create_rdmc_sst_groups() {
                                 pending_message_timestamps[subgroup_num].erase(h->timestamp);
                             }
                             locally_stable_sst_messages[subgroup_num].erase(locally_stable_sst_messages[subgroup_num].begin());
+                            // the slot bytes are dead now, so release the slot to its sender
+                            sst->num_received_sst[member_index][subgroup_settings.num_received_offset + sender_rank]++;
+                            sst_slots_released = true;
                         } else {
                             assert(!locally_stable_rdmc_messages[subgroup_num].empty());
                             auto it2 = locally_stable_rdmc_messages[subgroup_num].begin();
@@ -336,7 +532,7 @@ bool MulticastGroup::create_rdmc_sst_groups() {
                                                                     {{buf + h->header_size, msg.size - h->header_size}},
                                                                     persistent::INVALID_VERSION);
                             }
-                            free_message_buffers[subgroup_num].push_back(std::move(msg.message_buffer));
+                            MessageBufferPool::give_back(std::move(msg.message_buffer));
                             if(node_id == members[member_index]) {
                                 pending_message_timestamps[subgroup_num].erase(h->timestamp);
                             }
@@ -347,19 +543,47 @@ bool MulticastGroup::create_rdmc_sst_groups() {
                 if(new_num_received > sst->num_received[member_index][subgroup_settings.num_received_offset + sender_rank]) {
                     sst->num_received[member_index][subgroup_settings.num_received_offset + sender_rank] = new_num_received;
                     // std::atomic_signal_fence(std::memory_order_acq_rel);
-                    auto* min_ptr = std::min_element(&sst->num_received[member_index][subgroup_settings.num_received_offset],
-                                                     &sst->num_received[member_index][subgroup_settings.num_received_offset + num_shard_senders]);
-                    uint min_index = std::distance(&sst->num_received[member_index][subgroup_settings.num_received_offset], min_ptr);
-                    auto new_seq_num = (*min_ptr + 1) * num_shard_senders + min_index - 1;
-                    if(static_cast<message_id_t>(new_seq_num) > sst->seq_num[member_index][subgroup_num]) {
-                        dbg_default_trace("Updating seq_num for subgroup {} to {}", subgroup_num, new_seq_num);
-                        sst->seq_num[member_index][subgroup_num] = new_seq_num;
+                    message_id_t new_seq_num;
+                    if(num_shard_senders == 1) {
+                        // single-sender fast path: the round-robin sequence
+                        // collapses to the sender's own message indices
+                        new_seq_num = new_num_received;
+                    } else {
+                        auto* min_ptr = std::min_element(&sst->num_received[member_index][subgroup_settings.num_received_offset],
+                                                         &sst->num_received[member_index][subgroup_settings.num_received_offset + num_shard_senders]);
+                        uint min_index = std::distance(&sst->num_received[member_index][subgroup_settings.num_received_offset], min_ptr);
+                        new_seq_num = (*min_ptr + 1) * num_shard_senders + min_index - 1;
+                    }
+                    {
+                        // combine the seq_num and num_received pushes into a
+                        // single RDMA write per receiver
+                        sst::SST<DerechoSST>::CoalescedPutsGuard coalesce_puts(*sst);
+                        if(new_seq_num > sst->seq_num[member_index][subgroup_num]) {
+                            trc_default_event("update_seq_num", subgroup_num, new_seq_num);
+                            sst->seq_num[member_index][subgroup_num] = new_seq_num;
+                            sst->put(shard_sst_indices,
+                                     sst->seq_num, subgroup_num);
+                        }
                         sst->put(shard_sst_indices,
-                                 sst->seq_num, subgroup_num);
+                                 sst->num_received,
+                                 subgroup_settings.num_received_offset + sender_rank);
+                        if(sst_slots_released) {
+                            // this RDMC arrival unblocked stashed SMC messages;
+                            // their senders need the freed slots pushed out
+                            sst->put(shard_sst_indices,
+                                     (char*)std::addressof(sst->num_received_sst[0][subgroup_settings.num_received_offset]) - sst->getBaseAddress(),
+                                     sizeof(decltype(sst->num_received_sst)::value_type) * num_shard_senders);
+                        }
+                    }
+                    if(num_shard_senders == 1 && subgroup_settings.mode != Mode::UNORDERED
+                       && !delivery_offloaded) {
+                        // our seq_num update may be the one that completes
+                        // global stability, so try to deliver right away
+                        // instead of waiting for the delivery predicate (when
+                        // deliveries are offloaded, the subgroup's lane keeps
+                        // them off this thread instead)
+                        delivery_trigger(subgroup_num, subgroup_settings, shard_sst_indices.size(), *sst);
                     }
-                    sst->put(shard_sst_indices,
-                             sst->num_received,
-                             subgroup_settings.num_received_offset + sender_rank);
                 }
             };
             // Capture rdmc_receive_handler by copy! The reference to it won't be valid after this constructor ends!
@@ -382,49 +606,74 @@ bool MulticastGroup::create_rdmc_sst_groups() {
                 continue;
             }
 
+            // If the previous view had an RDMC group for this (subgroup,
+            // sender) with the same membership and profile, migrate it to
+            // this view's group number (installing the freshly-captured
+            // handlers) instead of tearing it down and rebuilding it, so a
+            // membership change elsewhere doesn't pause this shard's
+            // multicast. Every member of the shard computes the same old and
+            // new numbers, so they all migrate consistently.
+            const auto group_key = std::make_pair(subgroup_num, node_id);
+            const auto prior_group = prior_rdmc_groups.find(group_key);
+            const bool can_migrate = prior_group != prior_rdmc_groups.end()
+                                     && prior_group->second.rotated_members == rotated_shard_members
+                                     && prior_group->second.block_size == subgroup_settings.profile.block_size
+                                     && prior_group->second.algorithm == subgroup_settings.profile.rdmc_send_algorithm;
+
             if(node_id == members[member_index]) {
                 //Create a group in which this node is the sender, and only self-receives happen
-                if(!rdmc::create_group(
-                           rdmc_group_num_offset, rotated_shard_members, subgroup_settings.profile.block_size, subgroup_settings.profile.rdmc_send_algorithm,
-                           [](size_t length) -> rdmc::receive_destination {
-                               assert_always(false);
-                               return {nullptr, 0};
-                           },
-                           receive_handler_plus_notify,
-                           [](std::optional<uint32_t>) {})) {
-                    return false;
+                auto sender_incoming_upcall = [](size_t length) -> rdmc::receive_destination {
+                    assert_always(false);
+                    return {nullptr, 0};
+                };
+                if(!(can_migrate
+                     && rdmc::migrate_group(prior_group->second.group_number, rdmc_group_num_offset,
+                                            rotated_shard_members, subgroup_settings.profile.block_size,
+                                            sender_incoming_upcall, receive_handler_plus_notify))) {
+                    if(!rdmc::create_group(
+                               rdmc_group_num_offset, rotated_shard_members, subgroup_settings.profile.block_size, subgroup_settings.profile.rdmc_send_algorithm,
+                               sender_incoming_upcall,
+                               receive_handler_plus_notify,
+                               [](std::optional<uint32_t>) {})) {
+                        return false;
+                    }
                 }
                 subgroup_to_rdmc_group[subgroup_num] = rdmc_group_num_offset;
-                rdmc_group_num_offset++;
             } else {
-                if(!rdmc::create_group(
-                           rdmc_group_num_offset, rotated_shard_members, subgroup_settings.profile.block_size, subgroup_settings.profile.rdmc_send_algorithm,
-                           [this, subgroup_num, node_id, max_msg_size=subgroup_settings.profile.max_msg_size](size_t length) {
-                               std::lock_guard<std::recursive_mutex> lock(msg_state_mtx);
-                               // assert(!free_message_buffers[subgroup_num].empty());
-			                   if(free_message_buffers[subgroup_num].empty()) {
-				                   free_message_buffers[subgroup_num].emplace_back(max_msg_size);
-			                   }
-                               //Create a Message struct to receive the data into.
-                               RDMCMessage msg;
-                               msg.sender_id = node_id;
-                               // The length variable is not the exact size of the msg,
-                               // but it is the nearest multiple of the block size greater then the size
-                               // so we will set the size in the receive handler
-                               msg.message_buffer = std::move(free_message_buffers[subgroup_num].back());
-                               free_message_buffers[subgroup_num].pop_back();
-
-                               rdmc::receive_destination ret{msg.message_buffer.mr, 0};
-                               current_receives[{subgroup_num, node_id}] = std::move(msg);
-
-                               assert(ret.mr->buffer != nullptr);
-                               return ret;
-                           },
-                           rdmc_receive_handler, [](std::optional<uint32_t>) {})) {
-                    return false;
+                auto receiver_incoming_upcall =
+                        [this, subgroup_num, node_id, max_msg_size=subgroup_settings.profile.max_msg_size](size_t length) {
+                            std::lock_guard<std::recursive_mutex> lock(msg_state_mtx);
+                            //Create a Message struct to receive the data into.
+                            RDMCMessage msg;
+                            msg.sender_id = node_id;
+                            // The length variable is not the exact size of the msg,
+                            // but it is the nearest multiple of the block size greater then the size
+                            // so we will set the size in the receive handler
+                            msg.message_buffer = MessageBufferPool::get(max_msg_size);
+
+                            rdmc::receive_destination ret{msg.message_buffer.mr, 0};
+                            current_receives[{subgroup_num, node_id}] = std::move(msg);
+
+                            assert(ret.mr->buffer != nullptr);
+                            return ret;
+                        };
+                if(!(can_migrate
+                     && rdmc::migrate_group(prior_group->second.group_number, rdmc_group_num_offset,
+                                            rotated_shard_members, subgroup_settings.profile.block_size,
+                                            receiver_incoming_upcall, rdmc_receive_handler))) {
+                    if(!rdmc::create_group(
+                               rdmc_group_num_offset, rotated_shard_members, subgroup_settings.profile.block_size, subgroup_settings.profile.rdmc_send_algorithm,
+                               receiver_incoming_upcall,
+                               rdmc_receive_handler, [](std::optional<uint32_t>) {})) {
+                        return false;
+                    }
                 }
-                rdmc_group_num_offset++;
             }
+            rdmc_groups_created[group_key] = RDMCGroupInfo{rdmc_group_num_offset,
+                                                           rotated_shard_members,
+                                                           subgroup_settings.profile.block_size,
+                                                           subgroup_settings.profile.rdmc_send_algorithm};
+            rdmc_group_num_offset++;
         }
     }
     return true;
@@ -450,18 +699,74 @@ void MulticastGroup::initialize_sst_row() {
 void MulticastGroup::deliver_message(RDMCMessage& msg, const subgroup_id_t& subgroup_num,
                                      const persistent::version_t& version,
                                      const uint64_t& msg_ts_us) {
+    // the low 32 bits of the version are the message's sequence number
+    MessageTimeline::record(subgroup_num, version & 0xffffffff, MessageTimeline::DELIVERY);
+    PerfEventCounters::Scope perf_scope(PerfEventCounters::DELIVERY);
     char* buf = msg.message_buffer.buffer.get();
     header* h = (header*)(buf);
+    if(msg.sender_id == members[member_index]) {
+        record_medium_latency(subgroup_num, true, get_time() - h->timestamp, msg.size);
+    }
+    sst->increment_perf_counter(PerfCounter::MESSAGES_DELIVERED);
+    if(msg.size > h->header_size) {
+        sst->increment_perf_counter(PerfCounter::BYTES_DELIVERED, msg.size - h->header_size);
+    }
+    if(h->fragment_state != static_cast<uint8_t>(FragmentState::COMPLETE)) {
+        /* A piece of a fragmented message: accumulate it, and deliver the
+         * reassembled payload as one message when the last piece arrives.
+         * Every fragment consumed a sequence number and a version; the
+         * application only sees the final fragment's. */
+        std::vector<char>& reassembly = fragment_reassembly[{subgroup_num, msg.sender_id}];
+        reassembly.insert(reassembly.end(), buf + h->header_size, buf + msg.size);
+        if(h->fragment_state == static_cast<uint8_t>(FragmentState::FRAGMENT)) {
+            return;
+        }
+        std::vector<char> whole_message = std::move(reassembly);
+        fragment_reassembly.erase({subgroup_num, msg.sender_id});
+        if(h->cooked_send) {
+            post_next_version_callback(subgroup_num, version, msg_ts_us);
+            rpc_callback(subgroup_num, msg.sender_id, whole_message.data(), whole_message.size());
+            if(callbacks.batch_stability_callback) {
+                current_delivery_batch.push_back({subgroup_num, msg.sender_id, msg.index, {}, version});
+            } else if(callbacks.global_stability_callback) {
+                callbacks.global_stability_callback(subgroup_num, msg.sender_id, msg.index, {}, version);
+            }
+        } else if(callbacks.batch_stability_callback) {
+            current_delivery_batch.push_back({subgroup_num, msg.sender_id, msg.index,
+                                              {{whole_message.data(), static_cast<long long int>(whole_message.size())}},
+                                              version});
+        } else if(callbacks.global_stability_callback) {
+            callbacks.global_stability_callback(subgroup_num, msg.sender_id, msg.index,
+                                                {{whole_message.data(), static_cast<long long int>(whole_message.size())}},
+                                                version);
+        }
+        // keep the payload alive until the delivery batch is flushed
+        delivered_fragment_buffers.push_back(std::move(whole_message));
+        return;
+    }
+    if(callbacks.speculative_confirm_callback && !h->cooked_send && msg.size > h->header_size) {
+        // finalizes an earlier speculative delivery of this message
+        callbacks.speculative_confirm_callback(subgroup_num, msg.sender_id, msg.index, {}, version);
+    }
     // cooked send
     if(h->cooked_send) {
         buf += h->header_size;
         auto payload_size = msg.size - h->header_size;
         post_next_version_callback(subgroup_num, version, msg_ts_us);
-        rpc_callback(subgroup_num, msg.sender_id, buf, payload_size);
-        if(callbacks.global_stability_callback) {
+        // skip the handler if it already ran on local receipt
+        if(!msg.delivered_early) {
+            rpc_callback(subgroup_num, msg.sender_id, buf, payload_size);
+        }
+        if(callbacks.batch_stability_callback) {
+            current_delivery_batch.push_back({subgroup_num, msg.sender_id, msg.index, {}, version});
+        } else if(callbacks.global_stability_callback) {
             callbacks.global_stability_callback(subgroup_num, msg.sender_id, msg.index, {},
                                                 version);
         }
+    } else if(msg.size > h->header_size && callbacks.batch_stability_callback) {
+        current_delivery_batch.push_back({subgroup_num, msg.sender_id, msg.index,
+                                          {{buf + h->header_size, msg.size - h->header_size}},
+                                          version});
     } else if(msg.size > h->header_size && callbacks.global_stability_callback) {
         callbacks.global_stability_callback(subgroup_num, msg.sender_id, msg.index,
                                             {{buf + h->header_size, msg.size - h->header_size}},
@@ -472,18 +777,79 @@ void MulticastGroup::deliver_message(RDMCMessage& msg, const subgroup_id_t& subg
 void MulticastGroup::deliver_message(SSTMessage& msg, const subgroup_id_t& subgroup_num,
                                      const persistent::version_t& version,
                                      const uint64_t& msg_ts_us) {
+    // the low 32 bits of the version are the message's sequence number
+    MessageTimeline::record(subgroup_num, version & 0xffffffff, MessageTimeline::DELIVERY);
+    PerfEventCounters::Scope perf_scope(PerfEventCounters::DELIVERY);
     char* buf = const_cast<char*>(msg.buf);
     header* h = (header*)(buf);
+    if(msg.sender_id == members[member_index]) {
+        record_medium_latency(subgroup_num, false, get_time() - h->timestamp, msg.size);
+    }
+    sst->increment_perf_counter(PerfCounter::MESSAGES_DELIVERED);
+    if(msg.size > h->header_size) {
+        sst->increment_perf_counter(PerfCounter::BYTES_DELIVERED, msg.size - h->header_size);
+    }
+    if(h->fragment_state != static_cast<uint8_t>(FragmentState::COMPLETE)) {
+        /* A piece of a fragmented message: accumulate it, and deliver the
+         * reassembled payload as one message when the last piece arrives.
+         * Every fragment consumed a sequence number and a version; the
+         * application only sees the final fragment's. The copy out of the
+         * slot region streams around the cache, so draining a fragment
+         * train does not evict the predicate thread's sequence words. */
+        std::vector<char>& reassembly = fragment_reassembly[{subgroup_num, msg.sender_id}];
+        const size_t reassembled_bytes = reassembly.size();
+        reassembly.resize(reassembled_bytes + (msg.size - h->header_size));
+        sst::stream_copy(reassembly.data() + reassembled_bytes, buf + h->header_size,
+                         msg.size - h->header_size);
+        if(h->fragment_state == static_cast<uint8_t>(FragmentState::FRAGMENT)) {
+            return;
+        }
+        std::vector<char> whole_message = std::move(reassembly);
+        fragment_reassembly.erase({subgroup_num, msg.sender_id});
+        if(h->cooked_send) {
+            post_next_version_callback(subgroup_num, version, msg_ts_us);
+            rpc_callback(subgroup_num, msg.sender_id, whole_message.data(), whole_message.size());
+            if(callbacks.batch_stability_callback) {
+                current_delivery_batch.push_back({subgroup_num, msg.sender_id, msg.index, {}, version});
+            } else if(callbacks.global_stability_callback) {
+                callbacks.global_stability_callback(subgroup_num, msg.sender_id, msg.index, {}, version);
+            }
+        } else if(callbacks.batch_stability_callback) {
+            current_delivery_batch.push_back({subgroup_num, msg.sender_id, msg.index,
+                                              {{whole_message.data(), static_cast<long long int>(whole_message.size())}},
+                                              version});
+        } else if(callbacks.global_stability_callback) {
+            callbacks.global_stability_callback(subgroup_num, msg.sender_id, msg.index,
+                                                {{whole_message.data(), static_cast<long long int>(whole_message.size())}},
+                                                version);
+        }
+        // keep the payload alive until the delivery batch is flushed
+        delivered_fragment_buffers.push_back(std::move(whole_message));
+        return;
+    }
+    if(callbacks.speculative_confirm_callback && !h->cooked_send && msg.size > h->header_size) {
+        // finalizes an earlier speculative delivery of this message
+        callbacks.speculative_confirm_callback(subgroup_num, msg.sender_id, msg.index, {}, version);
+    }
     // cooked send
     if(h->cooked_send) {
         buf += h->header_size;
         auto payload_size = msg.size - h->header_size;
         post_next_version_callback(subgroup_num, version, msg_ts_us);
-        rpc_callback(subgroup_num, msg.sender_id, buf, payload_size);
-        if(callbacks.global_stability_callback) {
+        // skip the handler if it already ran on local receipt
+        if(!msg.delivered_early) {
+            rpc_callback(subgroup_num, msg.sender_id, buf, payload_size);
+        }
+        if(callbacks.batch_stability_callback) {
+            current_delivery_batch.push_back({subgroup_num, msg.sender_id, msg.index, {}, version});
+        } else if(callbacks.global_stability_callback) {
             callbacks.global_stability_callback(subgroup_num, msg.sender_id, msg.index, {},
                                                 version);
         }
+    } else if(msg.size > h->header_size && callbacks.batch_stability_callback) {
+        current_delivery_batch.push_back({subgroup_num, msg.sender_id, msg.index,
+                                          {{buf + h->header_size, msg.size - h->header_size}},
+                                          version});
     } else if(msg.size > h->header_size && callbacks.global_stability_callback) {
         callbacks.global_stability_callback(subgroup_num, msg.sender_id, msg.index,
                                             {{buf + h->header_size, msg.size - h->header_size}},
@@ -491,6 +857,14 @@ void MulticastGroup::deliver_message(SSTMessage& msg, const subgroup_id_t& subgr
     }
 }
 
+void MulticastGroup::flush_delivery_batch() {
+    if(callbacks.batch_stability_callback && !current_delivery_batch.empty()) {
+        callbacks.batch_stability_callback(current_delivery_batch);
+        current_delivery_batch.clear();
+    }
+    delivered_fragment_buffers.clear();
+}
+
 bool MulticastGroup::version_message(RDMCMessage& msg, const subgroup_id_t& subgroup_num,
                                      const persistent::version_t& version, const uint64_t& msg_timestamp) {
     char* buf = msg.message_buffer.buffer.get();
@@ -539,7 +913,9 @@ void MulticastGroup::deliver_messages_upto(
         const std::vector<int32_t>& max_indices_for_senders,
         subgroup_id_t subgroup_num, uint32_t num_shard_senders) {
     bool non_null_msgs_delivered = false;
+    bool sst_slots_released = false;
     assert(max_indices_for_senders.size() == (size_t)num_shard_senders);
+    const SubgroupSettings& subgroup_settings = subgroup_settings_map.at(subgroup_num);
     std::lock_guard<std::recursive_mutex> lock(msg_state_mtx);
     int32_t curr_seq_num = sst->delivered_num[member_index][subgroup_num];
     int32_t max_seq_num = curr_seq_num;
@@ -565,22 +941,36 @@ void MulticastGroup::deliver_messages_upto(
             deliver_message(msg, subgroup_num, assigned_version, msg_ts/1000);
             non_null_msgs_delivered |= version_message(msg, subgroup_num, assigned_version, msg_ts);
             // free the message buffer only after it version_message has been called
-            free_message_buffers[subgroup_num].push_back(std::move(msg.message_buffer));
+            MessageBufferPool::give_back(std::move(msg.message_buffer));
             locally_stable_rdmc_messages[subgroup_num].erase(rdmc_msg_ptr);
         } else {
-            dbg_default_trace("Subgroup {}, deliver_messages_upto delivering an SST message with seq_num = {}",
-                              subgroup_num, seq_num);
-            auto& msg = locally_stable_sst_messages[subgroup_num].at(seq_num);
+            auto sst_msg_ptr = locally_stable_sst_messages[subgroup_num].find(seq_num);
+            if(sst_msg_ptr == locally_stable_sst_messages[subgroup_num].end()) {
+                // a suppressed null message: counted as received, but there
+                // is nothing to deliver
+                continue;
+            }
+            trc_default_event("deliver_upto_sst", subgroup_num, seq_num);
+            auto& msg = sst_msg_ptr->second;
             char* buf = (char*)msg.buf;
             uint64_t msg_ts = ((header*)buf)->timestamp;
             deliver_message(msg, subgroup_num, assigned_version, msg_ts/1000);
             non_null_msgs_delivered |= version_message(msg, subgroup_num, assigned_version, msg_ts);
-            locally_stable_sst_messages[subgroup_num].erase(seq_num);
+            locally_stable_sst_messages[subgroup_num].erase(sst_msg_ptr);
+            // delivered in place out of its SMC slot; release the slot now
+            sst->num_received_sst[member_index][subgroup_settings.num_received_offset + sender_rank]++;
+            sst_slots_released = true;
         }
     }
+    flush_delivery_batch();
     gmssst::set(sst->delivered_num[member_index][subgroup_num], max_seq_num);
     sst->put(get_shard_sst_indices(subgroup_num),
              sst->delivered_num, subgroup_num);
+    if(sst_slots_released) {
+        sst->put(get_shard_sst_indices(subgroup_num),
+                 (char*)std::addressof(sst->num_received_sst[0][subgroup_settings.num_received_offset]) - sst->getBaseAddress(),
+                 sizeof(decltype(sst->num_received_sst)::value_type) * num_shard_senders);
+    }
     if(non_null_msgs_delivered) {
         //Call the persistence_manager_post_persist_func
         std::get<1>(persistence_manager_callbacks)(subgroup_num, assigned_version);
@@ -624,14 +1014,34 @@ int32_t MulticastGroup::resolve_num_received(int32_t index, uint32_t num_receive
 bool MulticastGroup::receiver_predicate(const SubgroupSettings& subgroup_settings,
                                         const std::map<uint32_t, uint32_t>& shard_ranks_by_sender_rank,
                                         uint32_t num_shard_senders, const DerechoSST& sst) {
+    const uint64_t slot_width = subgroup_settings.profile.sst_max_msg_size + 2 * sizeof(uint64_t);
+    /* Each sender's probe touches a different row's cache line, and an RDMA
+     * write may have just invalidated it, so the scan is latency-bound on
+     * back-to-back misses. Compute each row's sequence-word address one
+     * iteration ahead and prefetch it, overlapping the next miss with the
+     * current compare. */
+    auto seq_word_addr = [&](uint sender_count) -> const volatile char* {
+        // probe against the drain cursor, not num_received_sst: the shared
+        // column lags behind at undelivered in-place messages
+        const int32_t num_received = num_received_sst_drained[subgroup_settings.num_received_offset + sender_count] + 1;
+        const uint32_t slot = num_received % subgroup_settings.profile.window_size;
+        return &sst.slots[node_id_to_sst_index.at(subgroup_settings.members[shard_ranks_by_sender_rank.at(sender_count)])]
+                         [subgroup_settings.slot_offset + slot_width * (slot + 1) - sizeof(uint64_t)];
+    };
+    const volatile char* probe_addr = seq_word_addr(0);
     for(uint sender_count = 0; sender_count < num_shard_senders; ++sender_count) {
-        int32_t num_received = sst.num_received_sst[member_index][subgroup_settings.num_received_offset + sender_count] + 1;
-        uint32_t slot = num_received % subgroup_settings.profile.window_size;
-        if(static_cast<long long int>((uint64_t&)sst.slots[node_id_to_sst_index.at(subgroup_settings.members[shard_ranks_by_sender_rank.at(sender_count)])]
-                                                          [subgroup_settings.slot_offset + (subgroup_settings.profile.sst_max_msg_size + 2 * sizeof(uint64_t)) * (slot + 1) - sizeof(uint64_t)])
+        const volatile char* next_addr = (sender_count + 1 < num_shard_senders)
+                                                 ? seq_word_addr(sender_count + 1)
+                                                 : nullptr;
+        if(next_addr != nullptr) {
+            sst::prefetch_for_read(next_addr);
+        }
+        const int32_t num_received = num_received_sst_drained[subgroup_settings.num_received_offset + sender_count] + 1;
+        if(static_cast<long long int>((uint64_t&)*probe_addr)
            == num_received / subgroup_settings.profile.window_size + 1) {
             return true;
         }
+        probe_addr = next_addr;
     }
     return false;
 }
@@ -648,17 +1058,50 @@ void MulticastGroup::sst_receive_handler(subgroup_id_t subgroup_num, const Subgr
 
     locally_stable_sst_messages[subgroup_num][sequence_number] = {node_id, index, size, data};
 
+    /* Order-insensitive delivery: a cooked message whose target function was
+     * tagged commutative is handed to the RPC layer as soon as it arrives; it
+     * stays in the delivery queue so version assignment and stability
+     * callbacks still happen in order. */
+    if(subgroup_settings.mode != Mode::UNORDERED && h->cooked_send
+       && h->fragment_state == static_cast<uint8_t>(FragmentState::COMPLETE)
+       && size > h->header_size && rpc_order_insensitive_query) {
+        char* payload = const_cast<char*>(data) + h->header_size;
+        const uint32_t payload_size = size - h->header_size;
+        if(rpc_order_insensitive_query(subgroup_num, payload, payload_size)) {
+            rpc_callback(subgroup_num, node_id, payload, payload_size);
+            locally_stable_sst_messages[subgroup_num][sequence_number].delivered_early = true;
+        }
+    }
+
+    /* Speculative delivery: see the RDMC receive handler */
+    if(callbacks.speculative_delivery_callback && !h->cooked_send
+       && h->fragment_state == static_cast<uint8_t>(FragmentState::COMPLETE)
+       && size > h->header_size) {
+        callbacks.speculative_delivery_callback(
+                subgroup_num, node_id, index,
+                {{const_cast<char*>(data) + h->header_size, static_cast<long long int>(size - h->header_size)}},
+                persistent::INVALID_VERSION);
+    }
+
     auto new_num_received = resolve_num_received(index, subgroup_settings.num_received_offset + sender_rank);
     /* NULL Send Scheme */
     // only if I am a sender in the subgroup and the subgroup is not in UNORDERED mode
-    if(subgroup_settings.sender_rank >= 0 && subgroup_settings.mode != Mode::UNORDERED) {
-        if(subgroup_settings.sender_rank < (int)sender_rank) {
-            while(future_message_indices[subgroup_num] <= new_num_received) {
-                get_buffer_and_send_auto_null(subgroup_num);
-            }
-        } else if(subgroup_settings.sender_rank > (int)sender_rank) {
-            while(future_message_indices[subgroup_num] < new_num_received) {
-                get_buffer_and_send_auto_null(subgroup_num);
+    if(subgroup_settings.sender_rank >= 0 && subgroup_settings.mode != Mode::UNORDERED
+       && subgroup_settings.sender_rank != (int)sender_rank) {
+        // lower-ranked senders must catch up to this sender's index;
+        // higher-ranked ones stay one index behind it
+        const int32_t target_index = (subgroup_settings.sender_rank < (int)sender_rank)
+                                             ? new_num_received + 1
+                                             : new_num_received;
+        if(subgroup_settings.profile.null_send_suppression) {
+            suppress_auto_null_sends(subgroup_num, subgroup_settings, target_index);
+        } else {
+            while(future_message_indices[subgroup_num] < target_index) {
+                if(!get_buffer_and_send_auto_null(subgroup_num)) {
+                    // ring full; delivery_trigger retries once slots free up
+                    deferred_auto_null_targets[subgroup_num] = target_index;
+                    break;
+                }
             }
         }
     }
@@ -682,6 +1125,8 @@ void MulticastGroup::sst_receive_handler(subgroup_id_t subgroup_num, const Subgr
                     pending_message_timestamps[subgroup_num].erase(h->timestamp);
                 }
                 locally_stable_sst_messages[subgroup_num].erase(locally_stable_sst_messages[subgroup_num].begin());
+                // the slot bytes are dead now, so release the slot to its sender
+                sst->num_received_sst[member_index][subgroup_settings.num_received_offset + sender_rank]++;
             } else {
                 assert(!locally_stable_rdmc_messages[subgroup_num].empty());
                 auto it2 = locally_stable_rdmc_messages[subgroup_num].begin();
@@ -695,7 +1140,7 @@ void MulticastGroup::sst_receive_handler(subgroup_id_t subgroup_num, const Subgr
                                                         {{buf + h->header_size, msg.size - h->header_size}},
                                                         persistent::INVALID_VERSION);
                 }
-                free_message_buffers[subgroup_num].push_back(std::move(msg.message_buffer));
+                MessageBufferPool::give_back(std::move(msg.message_buffer));
                 if(node_id == members[member_index]) {
                     pending_message_timestamps[subgroup_num].erase(h->timestamp);
                 }
@@ -706,63 +1151,152 @@ void MulticastGroup::sst_receive_handler(subgroup_id_t subgroup_num, const Subgr
     sst->num_received[member_index][subgroup_settings.num_received_offset + sender_rank] = new_num_received;
 }
 
+void MulticastGroup::raw_sst_receive_handler(subgroup_id_t subgroup_num, const SubgroupSettings& subgroup_settings,
+                                             const std::map<uint32_t, uint32_t>& shard_ranks_by_sender_rank,
+                                             uint32_t num_shard_senders, uint32_t sender_rank,
+                                             volatile char* data, uint64_t size) {
+    header* h = (header*)data;
+    const int32_t index = h->index;
+    const node_id_t node_id = subgroup_settings.members[shard_ranks_by_sender_rank.at(sender_rank)];
+    auto& num_received = sst->num_received[member_index][subgroup_settings.num_received_offset + sender_rank];
+    /* The fast path applies when this message is deliverable on the spot:
+     * it is the sender's next index, it is not a fragment, and no earlier
+     * message is stashed awaiting an in-flight RDMC transfer. SMC slots are
+     * drained in per-sender order, so on a pure-SMC raw subgroup this is
+     * every message. A registered speculative-delivery callback also forces
+     * the general path, which fires it before the stability upcall. */
+    if(index == num_received + 1
+       && h->fragment_state == static_cast<uint8_t>(FragmentState::COMPLETE)
+       && !callbacks.speculative_delivery_callback
+       && locally_stable_sst_messages[subgroup_num].empty()
+       && locally_stable_rdmc_messages[subgroup_num].empty()) {
+        // keep the receive-interval bookkeeping consistent with the general
+        // path; the in-order case is O(1)
+        resolve_num_received(index, subgroup_settings.num_received_offset + sender_rank);
+        if(size > h->header_size && callbacks.global_stability_callback) {
+            callbacks.global_stability_callback(
+                    subgroup_num, node_id, index,
+                    {{const_cast<char*>(data) + h->header_size, static_cast<long long int>(size - h->header_size)}},
+                    persistent::INVALID_VERSION);
+        }
+        if(node_id == members[member_index]) {
+            pending_message_timestamps[subgroup_num].erase(h->timestamp);
+        }
+        num_received = index;
+        // delivered straight out of the slot, so it can go back to the sender
+        sst->num_received_sst[member_index][subgroup_settings.num_received_offset + sender_rank]++;
+        return;
+    }
+    sst_receive_handler(subgroup_num, subgroup_settings, shard_ranks_by_sender_rank,
+                        num_shard_senders, sender_rank, data, size);
+}
+
 void MulticastGroup::receiver_function(subgroup_id_t subgroup_num, const SubgroupSettings& subgroup_settings,
                                        const std::map<uint32_t, uint32_t>& shard_ranks_by_sender_rank,
-                                       uint32_t num_shard_senders, DerechoSST& sst, unsigned int batch_size,
+                                       uint32_t num_shard_senders,
+                                       const std::vector<uint32_t>& shard_sst_indices, DerechoSST& sst,
                                        const std::function<void(uint32_t, volatile char*, uint32_t)>& sst_receive_handler_lambda) {
     DerechoParams profile = subgroup_settings.profile;
     const uint64_t slot_width = profile.sst_max_msg_size + 2 * sizeof(uint64_t);
     std::lock_guard<std::recursive_mutex> lock(msg_state_mtx);
-    for(uint i = 0; i < batch_size; ++i) {
+    /* Drain every ready slot in one pass: consume each sender's consecutive
+     * ready slots, and repeat until a full round over the senders finds
+     * nothing new, so a burst costs one predicate fire and one SST push
+     * instead of one cycle per message. The sender-side window gating bounds
+     * the work at window_size slots per sender per round. */
+    bool received_anything = false;
+    bool received_this_round = true;
+    while(received_this_round) {
+        received_this_round = false;
         for(uint sender_count = 0; sender_count < num_shard_senders; ++sender_count) {
-            auto num_received = sst.num_received_sst[member_index][subgroup_settings.num_received_offset + sender_count] + 1;
-            const uint32_t slot = num_received % profile.window_size;
             const uint32_t sender_sst_index = node_id_to_sst_index.at(
                     subgroup_settings.members[shard_ranks_by_sender_rank.at(sender_count)]);
-            const message_id_t next_seq = (uint64_t&)sst.slots[sender_sst_index]
-                                                              [subgroup_settings.slot_offset + slot_width * (slot + 1) - sizeof(uint64_t)];
-            if(next_seq == num_received / static_cast<int32_t>(profile.window_size) + 1) {
-                dbg_default_trace("receiver_trig calling sst_receive_handler_lambda. next_seq = {}, num_received = {}, sender rank = {}. Reading from SST row {}, slot {}",
-                                  next_seq, num_received, sender_count, sender_sst_index, subgroup_settings.slot_offset + slot_width * slot);
+            while(true) {
+                auto num_received = num_received_sst_drained[subgroup_settings.num_received_offset + sender_count] + 1;
+                const uint32_t slot = num_received % profile.window_size;
+                const message_id_t next_seq = (uint64_t&)sst.slots[sender_sst_index]
+                                                                  [subgroup_settings.slot_offset + slot_width * (slot + 1) - sizeof(uint64_t)];
+                if(next_seq != num_received / static_cast<int32_t>(profile.window_size) + 1) {
+                    break;
+                }
+                // a burst usually fills consecutive slots, so start the next
+                // slot's sequence word on its way while this one is handled
+                sst::prefetch_for_read(&sst.slots[sender_sst_index]
+                                                 [subgroup_settings.slot_offset
+                                                  + slot_width * (((num_received + 1) % profile.window_size) + 1) - sizeof(uint64_t)]);
+                trc_default_event("sst_receive", sender_sst_index, next_seq);
                 sst_receive_handler_lambda(sender_count,
                                            &sst.slots[sender_sst_index]
                                                      [subgroup_settings.slot_offset + slot_width * slot],
                                            (uint64_t&)sst.slots[sender_sst_index]
                                                                [subgroup_settings.slot_offset + slot_width * (slot + 1) - 2 * sizeof(uint64_t)]);
-                sst.num_received_sst[member_index][subgroup_settings.num_received_offset + sender_count] = num_received;
+                /* Delivery is in place, so the slot is not acknowledged back
+                 * to the sender here: num_received_sst only advances when the
+                 * stashed message is delivered (or was consumed in-handler,
+                 * as in UNORDERED mode) and its slot bytes are dead. Until
+                 * then the sender's window check keeps the slot intact. */
+                num_received_sst_drained[subgroup_settings.num_received_offset + sender_count] = num_received;
+                received_anything = true;
+                received_this_round = true;
             }
         }
     }
-    sst.put((char*)std::addressof(sst.num_received_sst[0][subgroup_settings.num_received_offset]) - sst.getBaseAddress(),
-            sizeof(decltype(sst.num_received_sst)::value_type) * num_shard_senders);
-    // std::atomic_signal_fence(std::memory_order_acq_rel);
-    auto* min_ptr = std::min_element(&sst.num_received[member_index][subgroup_settings.num_received_offset],
-                                     &sst.num_received[member_index][subgroup_settings.num_received_offset + num_shard_senders]);
-    int min_index = std::distance(&sst.num_received[member_index][subgroup_settings.num_received_offset], min_ptr);
-    message_id_t new_seq_num = (*min_ptr + 1) * num_shard_senders + min_index - 1;
-    if(new_seq_num > sst.seq_num[member_index][subgroup_num]) {
-        dbg_default_trace("Updating seq_num for subgroup {} to {}", subgroup_num, new_seq_num);
-        sst.seq_num[member_index][subgroup_num] = new_seq_num;
-        sst.put(sst.seq_num, subgroup_num);
+    {
+        // combine the num_received_sst, seq_num, and num_received pushes below
+        // into a single RDMA write per receiver; only the shard's rows need
+        // this subgroup's counters, so don't push them to the rest of the group
+        sst::SST<DerechoSST>::CoalescedPutsGuard coalesce_puts(sst);
+        sst.put(shard_sst_indices,
+                (char*)std::addressof(sst.num_received_sst[0][subgroup_settings.num_received_offset]) - sst.getBaseAddress(),
+                sizeof(decltype(sst.num_received_sst)::value_type) * num_shard_senders);
+        // std::atomic_signal_fence(std::memory_order_acq_rel);
+        message_id_t new_seq_num;
+        if(num_shard_senders == 1) {
+            // single-sender fast path: the round-robin sequence collapses to
+            // the sender's own message indices
+            new_seq_num = sst.num_received[member_index][subgroup_settings.num_received_offset];
+        } else {
+            auto* min_ptr = std::min_element(&sst.num_received[member_index][subgroup_settings.num_received_offset],
+                                             &sst.num_received[member_index][subgroup_settings.num_received_offset + num_shard_senders]);
+            int min_index = std::distance(&sst.num_received[member_index][subgroup_settings.num_received_offset], min_ptr);
+            new_seq_num = (*min_ptr + 1) * num_shard_senders + min_index - 1;
+        }
+        if(new_seq_num > sst.seq_num[member_index][subgroup_num]) {
+            trc_default_event("update_seq_num", subgroup_num, new_seq_num);
+            sst.seq_num[member_index][subgroup_num] = new_seq_num;
+            sst.put(shard_sst_indices, sst.seq_num, subgroup_num);
+        }
+        // num_received is column-major, so let the SST compute the offset
+        sst.put(shard_sst_indices, sst.num_received, subgroup_settings.num_received_offset, num_shard_senders);
+    }
+    if(num_shard_senders == 1 && subgroup_settings.mode != Mode::UNORDERED
+       && !delivery_offloaded) {
+        // our seq_num update may be the one that completes global stability,
+        // so try to deliver right away instead of waiting for the delivery
+        // predicate to poll (when deliveries are offloaded, the subgroup's
+        // lane runs them instead, keeping upcalls off the detect thread)
+        delivery_trigger(subgroup_num, subgroup_settings, subgroup_settings.members.size(), sst);
+    }
+    if(received_anything && subgroup_settings.mode == Mode::UNORDERED
+       && send_credits_callbacks[subgroup_num]) {
+        // in UNORDERED mode the send window is gated on num_received, so the
+        // receives above may have freed send credits
+        send_credits_callbacks[subgroup_num]();
     }
-    sst.put((char*)std::addressof(sst.num_received[0][subgroup_settings.num_received_offset]) - sst.getBaseAddress(),
-            sizeof(decltype(sst.num_received)::value_type) * num_shard_senders);
 }
 
 void MulticastGroup::delivery_trigger(subgroup_id_t subgroup_num, const SubgroupSettings& subgroup_settings,
                                       const uint32_t num_shard_members, DerechoSST& sst) {
     std::lock_guard<std::recursive_mutex> lock(msg_state_mtx);
-    // compute the min of the seq_num
-    message_id_t min_stable_num
-            = sst.seq_num[node_id_to_sst_index.at(subgroup_settings.members[0])][subgroup_num];
-    for(uint i = 0; i < num_shard_members; ++i) {
-        // to avoid a race condition, do not read the same SST entry twice
-        message_id_t stable_num_copy = sst.seq_num[node_id_to_sst_index.at(subgroup_settings.members[i])][subgroup_num];
-        min_stable_num = std::min(min_stable_num, stable_num_copy);
-    }
+    // compute the min of the seq_num with a single vectorized column scan,
+    // over the voting rows only: standby members do not gate stability
+    const std::vector<uint32_t> shard_sst_indices = get_shard_sst_indices(subgroup_num);
+    message_id_t min_stable_num = sst.seq_num.min_over_rows(get_voting_sst_indices(subgroup_num), subgroup_num);
 
     bool update_sst = false;
+    bool sst_slots_released = false;
     bool non_null_msgs_delivered = false;
+    const uint32_t num_shard_senders = get_num_senders(subgroup_settings.senders);
     persistent::version_t assigned_version = persistent::INVALID_VERSION;
     while(true) {
         if(locally_stable_rdmc_messages[subgroup_num].empty() && locally_stable_sst_messages[subgroup_num].empty()) {
@@ -778,8 +1312,7 @@ void MulticastGroup::delivery_trigger(subgroup_id_t subgroup_num, const Subgroup
         }
         if(least_undelivered_rdmc_seq_num < least_undelivered_sst_seq_num && least_undelivered_rdmc_seq_num <= min_stable_num) {
             update_sst = true;
-            dbg_default_trace("Subgroup {}, can deliver a locally stable RDMC message: min_stable_num={} and least_undelivered_seq_num={}",
-                              subgroup_num, min_stable_num, least_undelivered_rdmc_seq_num);
+            trc_default_event("deliver_rdmc_stable", subgroup_num, least_undelivered_rdmc_seq_num);
             RDMCMessage& msg = locally_stable_rdmc_messages[subgroup_num].begin()->second;
             char* buf = msg.message_buffer.buffer.get();
             uint64_t msg_ts = ((header*)buf)->timestamp;
@@ -788,13 +1321,12 @@ void MulticastGroup::delivery_trigger(subgroup_id_t subgroup_num, const Subgroup
             deliver_message(msg, subgroup_num, assigned_version, msg_ts/1000);
             non_null_msgs_delivered |= version_message(msg, subgroup_num, assigned_version, msg_ts);
             // free the message buffer only after version_message has been called
-            free_message_buffers[subgroup_num].push_back(std::move(msg.message_buffer));
+            MessageBufferPool::give_back(std::move(msg.message_buffer));
             sst.delivered_num[member_index][subgroup_num] = least_undelivered_rdmc_seq_num;
             locally_stable_rdmc_messages[subgroup_num].erase(locally_stable_rdmc_messages[subgroup_num].begin());
         } else if(least_undelivered_sst_seq_num < least_undelivered_rdmc_seq_num && least_undelivered_sst_seq_num <= min_stable_num) {
             update_sst = true;
-            dbg_default_trace("Subgroup {}, can deliver a locally stable SST message: min_stable_num={} and least_undelivered_seq_num={}",
-                              subgroup_num, min_stable_num, least_undelivered_sst_seq_num);
+            trc_default_event("deliver_sst_stable", subgroup_num, least_undelivered_sst_seq_num);
             SSTMessage& msg = locally_stable_sst_messages[subgroup_num].begin()->second;
             char* buf = (char*)msg.buf;
             uint64_t msg_ts = ((header*)buf)->timestamp;
@@ -803,17 +1335,48 @@ void MulticastGroup::delivery_trigger(subgroup_id_t subgroup_num, const Subgroup
             non_null_msgs_delivered |= version_message(msg, subgroup_num, assigned_version, msg_ts);
             sst.delivered_num[member_index][subgroup_num] = least_undelivered_sst_seq_num;
             locally_stable_sst_messages[subgroup_num].erase(locally_stable_sst_messages[subgroup_num].begin());
+            /* The message was delivered in place out of its SMC slot, so only
+             * now is the slot released back to the sender's window. Per-sender
+             * slots are drained and delivered in the same order, so one
+             * increment per delivery keeps the ring sequence exact. */
+            sst.num_received_sst[member_index][subgroup_settings.num_received_offset
+                                              + (least_undelivered_sst_seq_num % num_shard_senders)]++;
+            sst_slots_released = true;
         } else {
             break;
         }
     }
+    flush_delivery_batch();
     if(update_sst) {
-        sst.put(get_shard_sst_indices(subgroup_num),
+        sst.put(shard_sst_indices,
                 sst.delivered_num, subgroup_num);
+        if(sst_slots_released) {
+            // tell the SMC senders their delivered slots are reusable
+            sst.put(shard_sst_indices,
+                    (char*)std::addressof(sst.num_received_sst[0][subgroup_settings.num_received_offset]) - sst.getBaseAddress(),
+                    sizeof(decltype(sst.num_received_sst)::value_type) * num_shard_senders);
+        }
         // post persistence request for ordered mode.
         if(non_null_msgs_delivered) {
             std::get<1>(persistence_manager_callbacks)(subgroup_num, assigned_version);
         }
+        // delivered_num gates the send window, so the deliveries above may
+        // have freed send credits
+        if(send_credits_callbacks[subgroup_num]) {
+            send_credits_callbacks[subgroup_num]();
+        }
+        if(sst_slots_released && deferred_auto_null_targets[subgroup_num] >= 0) {
+            // an auto-null catch-up stalled on the full slot ring; the
+            // deliveries above freed slots, so finish it now
+            while(future_message_indices[subgroup_num] < deferred_auto_null_targets[subgroup_num]) {
+                if(!get_buffer_and_send_auto_null(subgroup_num)) {
+                    break;
+                }
+            }
+            if(future_message_indices[subgroup_num] >= deferred_auto_null_targets[subgroup_num]) {
+                deferred_auto_null_targets[subgroup_num] = -1;
+            }
+        }
     }
 }
 void MulticastGroup::register_predicates() {
@@ -831,72 +1394,119 @@ void MulticastGroup::register_predicates() {
             }
         }
 
+        // the full shard's rows (standbys included), precomputed once for the
+        // hot triggers: per-subgroup counter pushes go only to these rows
+        const std::vector<uint32_t> full_shard_sst_indices = get_shard_sst_indices(subgroup_num);
         auto receiver_pred = [this, subgroup_settings, shard_ranks_by_sender_rank, num_shard_senders](const DerechoSST& sst) {
             return receiver_predicate(subgroup_settings,
                                       shard_ranks_by_sender_rank, num_shard_senders, sst);
         };
-        auto batch_size = subgroup_settings.profile.window_size / 2;
-        if(!batch_size) {
-            batch_size = 1;
-        }
-        auto sst_receive_handler_lambda = [this, subgroup_num, subgroup_settings, shard_ranks_by_sender_rank,
-                                           num_shard_senders](uint32_t sender_rank, volatile char* data, uint64_t size) {
-            sst_receive_handler(subgroup_num, subgroup_settings,
-                                shard_ranks_by_sender_rank, num_shard_senders,
-                                sender_rank, data, size);
-        };
+        // raw (UNORDERED) subgroups get the dedicated fast-path handler,
+        // chosen once here rather than branching on the mode per message
+        std::function<void(uint32_t, volatile char*, uint32_t)> sst_receive_handler_lambda;
+        if(subgroup_settings.mode == Mode::UNORDERED) {
+            sst_receive_handler_lambda = [this, subgroup_num, subgroup_settings, shard_ranks_by_sender_rank,
+                                          num_shard_senders](uint32_t sender_rank, volatile char* data, uint64_t size) {
+                raw_sst_receive_handler(subgroup_num, subgroup_settings,
+                                        shard_ranks_by_sender_rank, num_shard_senders,
+                                        sender_rank, data, size);
+            };
+        } else {
+            sst_receive_handler_lambda = [this, subgroup_num, subgroup_settings, shard_ranks_by_sender_rank,
+                                          num_shard_senders](uint32_t sender_rank, volatile char* data, uint64_t size) {
+                sst_receive_handler(subgroup_num, subgroup_settings,
+                                    shard_ranks_by_sender_rank, num_shard_senders,
+                                    sender_rank, data, size);
+            };
+        }
         auto receiver_trig = [this, subgroup_num, subgroup_settings, shard_ranks_by_sender_rank,
-                              num_shard_senders, batch_size, sst_receive_handler_lambda](DerechoSST& sst) mutable {
+                              num_shard_senders, full_shard_sst_indices,
+                              sst_receive_handler_lambda](DerechoSST& sst) {
             receiver_function(subgroup_num, subgroup_settings,
-                              shard_ranks_by_sender_rank, num_shard_senders, sst,
-                              batch_size, sst_receive_handler_lambda);
+                              shard_ranks_by_sender_rank, num_shard_senders,
+                              full_shard_sst_indices, sst,
+                              sst_receive_handler_lambda);
         };
+        // shard the per-subgroup predicates by subgroup number, so one busy
+        // subgroup's delivery work doesn't delay the others when
+        // DERECHO/predicate_shards > 1
         receiver_pred_handles.emplace_back(sst->predicates.insert(receiver_pred, receiver_trig,
-                                                                  sst::PredicateType::RECURRENT));
+                                                                  sst::PredicateType::RECURRENT,
+                                                                  subgroup_num,
+                                                                  sst::PredicatePriority::LATENCY_CRITICAL,
+                                                                  "receiver_" + std::to_string(subgroup_num)));
 
         if(subgroup_settings.mode != Mode::UNORDERED) {
-            auto delivery_pred = [this, subgroup_num, subgroup_settings, num_shard_members](const DerechoSST& sst) {
-                std::lock_guard<std::recursive_mutex> lock(msg_state_mtx);
-                // compute the min of the seq_num
-                message_id_t min_stable_num
-                        = sst.seq_num[node_id_to_sst_index.at(subgroup_settings.members[0])][subgroup_num];
-                for(uint i = 0; i < num_shard_members; ++i) {
-                    // to avoid a race condition, do not read the same SST entry twice
-                    message_id_t stable_num_copy = sst.seq_num[node_id_to_sst_index.at(subgroup_settings.members[i])][subgroup_num];
-                    min_stable_num = std::min(min_stable_num, stable_num_copy);
+            // precompute the shard's voting SST row indices once so the hot
+            // predicates can scan columns without per-row map lookups; standby
+            // members' rows are excluded (except this node's own row) so they
+            // never gate stability or persistence
+            std::vector<uint32_t> shard_sst_indices;
+            for(std::size_t shard_rank = 0; shard_rank < subgroup_settings.members.size(); ++shard_rank) {
+                const uint32_t sst_index = node_id_to_sst_index.at(subgroup_settings.members[shard_rank]);
+                if(subgroup_settings.standbys.empty() || !subgroup_settings.standbys[shard_rank]
+                   || sst_index == static_cast<uint32_t>(member_index)) {
+                    shard_sst_indices.push_back(sst_index);
                 }
-
-		return min_stable_num > sst.delivered_num[member_index][subgroup_num];
+            }
+            auto delivery_pred = [this, subgroup_num, shard_sst_indices](const DerechoSST& sst) {
+                std::lock_guard<std::recursive_mutex> lock(msg_state_mtx);
+                // compute the min of the seq_num with a vectorized column scan
+                message_id_t min_stable_num = sst.seq_num.min_over_rows(shard_sst_indices, subgroup_num);
+                return min_stable_num > sst.delivered_num[member_index][subgroup_num];
             };
             auto delivery_trig = [this, subgroup_num, subgroup_settings, num_shard_members](DerechoSST& sst) mutable {
                 delivery_trigger(subgroup_num, subgroup_settings, num_shard_members, sst);
             };
 
+            // the trigger runs the application's delivery upcalls, so hand it
+            // to the offload executor's lane for this subgroup: one subgroup's
+            // heavyweight handler no longer delays the detect thread or other
+            // subgroups' deliveries, while same-lane serialization keeps each
+            // subgroup's deliveries in order
             delivery_pred_handles.emplace_back(sst->predicates.insert(delivery_pred, delivery_trig,
-                                                                      sst::PredicateType::RECURRENT));
+                                                                      sst::PredicateType::RECURRENT,
+                                                                      subgroup_num,
+                                                                      sst::PredicatePriority::LATENCY_CRITICAL,
+                                                                      "delivery_" + std::to_string(subgroup_num),
+                                                                      subgroup_num));
+
+            if(subgroup_settings.profile.null_send_suppression) {
+                // suppressed nulls arrive as SST counter updates rather than
+                // messages, so nothing else re-evaluates num_received for
+                // them; poll the published intervals with their own predicate
+                auto nulls_pred = [this, subgroup_settings, shard_ranks_by_sender_rank,
+                                   num_shard_senders](const DerechoSST& sst) {
+                    return suppressed_nulls_predicate(subgroup_settings, shard_ranks_by_sender_rank,
+                                                      num_shard_senders, sst);
+                };
+                auto nulls_trig = [this, subgroup_num, subgroup_settings, shard_ranks_by_sender_rank,
+                                   num_shard_senders, full_shard_sst_indices](DerechoSST& sst) {
+                    apply_suppressed_nulls(subgroup_num, subgroup_settings,
+                                           shard_ranks_by_sender_rank, num_shard_senders,
+                                           full_shard_sst_indices, sst);
+                };
+                receiver_pred_handles.emplace_back(sst->predicates.insert(nulls_pred, nulls_trig,
+                                                                          sst::PredicateType::RECURRENT,
+                                                                          subgroup_num,
+                                                                          sst::PredicatePriority::LATENCY_CRITICAL,
+                                                                          "suppressed_nulls_" + std::to_string(subgroup_num)));
+            }
 
-            auto persistence_pred = [this, subgroup_num, subgroup_settings, num_shard_members,
+            auto persistence_pred = [this, subgroup_num, shard_sst_indices,
                                      version_seen = persistent::INVALID_VERSION](const DerechoSST& sst) {
                 std::lock_guard<std::recursive_mutex> lock(msg_state_mtx);
-                // compute the min of the persisted_num
+                // compute the min of the persisted_num with a vectorized column scan
                 persistent::version_t min_persisted_num
-                        = sst.persisted_num[node_id_to_sst_index.at(subgroup_settings.members[0])][subgroup_num];
-                for(uint i = 1; i < num_shard_members; ++i) {
-                    persistent::version_t persisted_num_copy = sst.persisted_num[node_id_to_sst_index.at(subgroup_settings.members[i])][subgroup_num];
-                    min_persisted_num = std::min(min_persisted_num, persisted_num_copy);
-                }
+                        = sst.persisted_num.min_over_rows(shard_sst_indices, subgroup_num);
                 return (version_seen < min_persisted_num) && callbacks.global_persistence_callback;
             };
-            auto persistence_trig = [this, subgroup_num, subgroup_settings, num_shard_members,
+            auto persistence_trig = [this, subgroup_num, shard_sst_indices,
                                      version_seen = persistent::INVALID_VERSION](DerechoSST& sst) mutable {
                 std::lock_guard<std::recursive_mutex> lock(msg_state_mtx);
-                // compute the min of the persisted_num
+                // compute the min of the persisted_num with a vectorized column scan
                 persistent::version_t min_persisted_num
-                        = sst.persisted_num[node_id_to_sst_index.at(subgroup_settings.members[0])][subgroup_num];
-                for(uint i = 1; i < num_shard_members; ++i) {
-                    persistent::version_t persisted_num_copy = sst.persisted_num[node_id_to_sst_index.at(subgroup_settings.members[i])][subgroup_num];
-                    min_persisted_num = std::min(min_persisted_num, persisted_num_copy);
-                }
+                        = sst.persisted_num.min_over_rows(shard_sst_indices, subgroup_num);
                 // callbacks
                 if((version_seen < min_persisted_num) && callbacks.global_persistence_callback) {
                     callbacks.global_persistence_callback(subgroup_num, min_persisted_num);
@@ -904,7 +1514,9 @@ void MulticastGroup::register_predicates() {
                 }
             };
 
-            persistence_pred_handles.emplace_back(sst->predicates.insert(persistence_pred, persistence_trig, sst::PredicateType::RECURRENT));
+            persistence_pred_handles.emplace_back(sst->predicates.insert(persistence_pred, persistence_trig, sst::PredicateType::RECURRENT, subgroup_num,
+                                                                         sst::PredicatePriority::NORMAL,
+                                                                         "persistence_" + std::to_string(subgroup_num)));
 
             if(subgroup_settings.sender_rank >= 0) {
                 auto sender_pred = [this, subgroup_num, subgroup_settings, num_shard_members, num_shard_senders](const DerechoSST& sst) {
@@ -922,7 +1534,10 @@ void MulticastGroup::register_predicates() {
                     next_message_to_deliver[subgroup_num]++;
                 };
                 sender_pred_handles.emplace_back(sst->predicates.insert(sender_pred, sender_trig,
-                                                                        sst::PredicateType::RECURRENT));
+                                                                        sst::PredicateType::RECURRENT,
+                                                                        subgroup_num,
+                                                                        sst::PredicatePriority::NORMAL,
+                                                                        "sender_" + std::to_string(subgroup_num)));
             }
         } else {
             //This subgroup is in UNORDERED mode
@@ -941,10 +1556,27 @@ void MulticastGroup::register_predicates() {
                     sender_cv.notify_all();
                 };
                 sender_pred_handles.emplace_back(sst->predicates.insert(sender_pred, sender_trig,
-                                                                        sst::PredicateType::RECURRENT));
+                                                                        sst::PredicateType::RECURRENT,
+                                                                        subgroup_num,
+                                                                        sst::PredicatePriority::NORMAL,
+                                                                        "sender_" + std::to_string(subgroup_num)));
             }
         }
     }
+    // The piggyback lane is group-wide, not per-subgroup, so register its
+    // predicate once, in partition 0. Replies fulfill blocked callers, so it
+    // runs at the same priority as the receiver predicates.
+    if(piggyback_reply_max_size > 0) {
+        auto piggyback_pred = [this](const DerechoSST& sst) {
+            return piggyback_replies_predicate(sst);
+        };
+        auto piggyback_trig = [this](DerechoSST& sst) {
+            deliver_piggybacked_replies(sst);
+        };
+        receiver_pred_handles.emplace_back(sst->predicates.insert(
+                piggyback_pred, piggyback_trig, sst::PredicateType::RECURRENT, 0,
+                sst::PredicatePriority::LATENCY_CRITICAL, "piggyback_replies"));
+    }
 }
 
 MulticastGroup::~MulticastGroup() {
@@ -954,6 +1586,76 @@ MulticastGroup::~MulticastGroup() {
     }
 }
 
+void MulticastGroup::wedge_subgroups_containing(const std::vector<node_id_t>& failed_members) {
+    std::lock_guard<std::recursive_mutex> lock(msg_state_mtx);
+    for(const auto& settings_pair : subgroup_settings_map) {
+        if(wedged_subgroups.count(settings_pair.first) > 0) {
+            continue;
+        }
+        for(const node_id_t failed_id : failed_members) {
+            if(std::find(settings_pair.second.members.begin(), settings_pair.second.members.end(),
+                         failed_id)
+               != settings_pair.second.members.end()) {
+                dbg_default_debug("Wedging subgroup {}: its shard contains suspected node {}",
+                                  settings_pair.first, failed_id);
+                wedged_subgroups.insert(settings_pair.first);
+                break;
+            }
+        }
+    }
+}
+
+bool MulticastGroup::subgroup_is_wedged(subgroup_id_t subgroup_num) {
+    std::lock_guard<std::recursive_mutex> lock(msg_state_mtx);
+    return wedged_subgroups.count(subgroup_num) > 0;
+}
+
+bool MulticastGroup::drain_sends(uint64_t timeout_ms) {
+    draining = true;
+    const uint64_t deadline = get_time() + timeout_ms * uint64_t(1000000);
+    for(const auto& settings_pair : subgroup_settings_map) {
+        const subgroup_id_t subgroup_num = settings_pair.first;
+        const SubgroupSettings& subgroup_settings = settings_pair.second;
+        if(subgroup_settings.sender_rank < 0) {
+            continue;
+        }
+        const uint32_t num_shard_senders = get_num_senders(subgroup_settings.senders);
+        while(true) {
+            message_id_t last_message_index;
+            {
+                std::lock_guard<std::recursive_mutex> lock(msg_state_mtx);
+                last_message_index = future_message_indices[subgroup_num] - 1;
+            }
+            /* Every queued message is counted in future_message_indices, so
+             * once all voting rows have delivered (or received) the last
+             * index, the send queues are necessarily empty as well. */
+            bool clean_cut = true;
+            if(last_message_index >= 0) {
+                for(const uint32_t row : get_voting_sst_indices(subgroup_num)) {
+                    if(subgroup_settings.mode == Mode::UNORDERED
+                               ? sst->num_received[row][subgroup_settings.num_received_offset + subgroup_settings.sender_rank]
+                                         < static_cast<int32_t>(last_message_index)
+                               : sst->delivered_num[row][subgroup_num]
+                                         < static_cast<message_id_t>(last_message_index * num_shard_senders
+                                                                     + subgroup_settings.sender_rank)) {
+                        clean_cut = false;
+                        break;
+                    }
+                }
+            }
+            if(clean_cut) {
+                break;
+            }
+            if(get_time() > deadline) {
+                dbg_default_warn("Drain of subgroup {} did not reach a clean cut before the timeout", subgroup_num);
+                return false;
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+    }
+    return true;
+}
+
 void MulticastGroup::wedge() {
     bool thread_shutdown_existing = thread_shutdown.exchange(true);
     if(thread_shutdown_existing) {  // Wedge has already been called
@@ -990,15 +1692,18 @@ void MulticastGroup::wedge() {
 
 void MulticastGroup::send_loop() {
     pthread_setname_np(pthread_self(), "sender_thread");
+    pin_to_cpu(getConfInt32(CONF_DERECHO_SENDER_THREAD_CPU));
+    PhaseOccupancy::ThreadSlot& occupancy = PhaseOccupancy::registerThread("sender_thread");
     subgroup_id_t subgroup_to_send = 0;
     auto should_send_to_subgroup = [&](subgroup_id_t subgroup_num) {
         if(!rdmc_sst_groups_created) {
             return false;
         }
-        if(pending_sends[subgroup_num].empty()) {
+        RDMCMessage* pending_msg = pending_sends[subgroup_num].peek();
+        if(!pending_msg) {
             return false;
         }
-        RDMCMessage& msg = pending_sends[subgroup_num].front();
+        RDMCMessage& msg = *pending_msg;
         const SubgroupSettings& subgroup_settings = subgroup_settings_map.at(subgroup_num);
 
         int shard_sender_index = subgroup_settings.sender_rank;
@@ -1032,28 +1737,71 @@ void MulticastGroup::send_loop() {
 
         return true;
     };
+    /* Deficit round robin across the subgroups with an eligible pending
+     * message, weighted by each profile's sender_priority. Every scheduling
+     * round each backlogged subgroup earns quantum * priority bytes of
+     * credit and may send once its credit covers its head-of-line message,
+     * so a high-priority control subgroup sending small messages never waits
+     * more than a few rounds behind a bulk subgroup's large transfers.
+     * Subgroups with nothing eligible forfeit their credit, as in classic
+     * DRR, so an idle subgroup cannot save up a burst of priority. */
+    constexpr uint64_t drr_quantum_bytes = 65536;
+    std::vector<uint64_t> send_deficits(total_num_subgroups, 0);
     auto should_send = [&]() {
+        bool any_eligible = false;
+        std::vector<bool> eligible(total_num_subgroups, false);
         for(uint i = 1; i <= total_num_subgroups; ++i) {
             auto subgroup_num = (subgroup_to_send + i) % total_num_subgroups;
             if(should_send_to_subgroup(subgroup_num)) {
-                subgroup_to_send = subgroup_num;
-                return true;
+                eligible[subgroup_num] = true;
+                any_eligible = true;
+            } else {
+                send_deficits[subgroup_num] = 0;
             }
         }
-        return false;
+        if(!any_eligible) {
+            return false;
+        }
+        // Each pass grows every eligible subgroup's deficit by at least one
+        // quantum, and head-of-line sizes are bounded by max_msg_size, so
+        // this loop terminates
+        while(true) {
+            for(uint i = 1; i <= total_num_subgroups; ++i) {
+                auto subgroup_num = (subgroup_to_send + i) % total_num_subgroups;
+                if(!eligible[subgroup_num]) {
+                    continue;
+                }
+                const uint32_t priority = std::max(1u, subgroup_settings_map.at(subgroup_num).profile.sender_priority);
+                send_deficits[subgroup_num] += drr_quantum_bytes * priority;
+                const uint64_t head_size = pending_sends[subgroup_num].peek()->size;
+                if(send_deficits[subgroup_num] >= head_size) {
+                    send_deficits[subgroup_num] -= head_size;
+                    subgroup_to_send = subgroup_num;
+                    return true;
+                }
+            }
+        }
+    };
+    // occupancy accounting: the eligibility scan is EVALUATING, time blocked
+    // on the condition variable between scans is IDLE, and a true return
+    // hands the thread to the send path (WORKING) until the next scan
+    auto should_wake = [&]() {
+        occupancy.enter(PhaseOccupancy::EVALUATING);
+        const bool wake = thread_shutdown || should_send();
+        occupancy.enter(wake ? PhaseOccupancy::WORKING : PhaseOccupancy::IDLE);
+        return wake;
     };
-    auto should_wake = [&]() { return thread_shutdown || should_send(); };
     std::unique_lock<std::recursive_mutex> lock(msg_state_mtx);
     while(!thread_shutdown) {
         sender_cv.wait(lock, should_wake);
         if(!thread_shutdown) {
-            current_sends[subgroup_to_send] = std::move(pending_sends[subgroup_to_send].front());
-            dbg_default_trace("Calling send in subgroup {} on message {} from sender {}",
-                              subgroup_to_send, current_sends[subgroup_to_send]->index, current_sends[subgroup_to_send]->sender_id);
+            current_sends[subgroup_to_send] = std::move(*pending_sends[subgroup_to_send].peek());
+            trc_default_event("rdmc_send", subgroup_to_send, current_sends[subgroup_to_send]->index);
 	    // make sure there are > 1 members before issuing RDMC send
             if(subgroup_settings_map.at(subgroup_to_send).members.size() > 1) {
                 if(!rdmc::send(subgroup_to_rdmc_group.at(subgroup_to_send),
-                               current_sends[subgroup_to_send]->message_buffer.mr, 0,
+                               current_sends[subgroup_to_send]->message_buffer.mr,
+                               current_sends[subgroup_to_send]->message_buffer.mr_offset,
                                current_sends[subgroup_to_send]->size)) {
                     throw std::runtime_error("rdmc::send returned false");
                 }
@@ -1085,6 +1833,16 @@ const uint64_t MulticastGroup::compute_global_stability_frontier(uint32_t subgro
 
 void MulticastGroup::check_failures_loop() {
     pthread_setname_np(pthread_self(), "timeout_thread");
+    /* The heartbeat probe writes to every other member, so at a fixed
+     * per-node cadence the cluster-wide probe traffic grows quadratically
+     * with group size. Stretch the probe interval proportionally once the
+     * group exceeds this size, which caps total probe traffic at a linear
+     * growth rate. */
+    constexpr unsigned int heartbeat_scale_members = 16;
+    const uint64_t probe_interval_ns = static_cast<uint64_t>(sender_timeout) * 1000000ull
+                                       * std::max(1u, num_members / heartbeat_scale_members);
+    uint64_t last_probe_time = get_time();
+    uint64_t puts_at_last_tick = sst ? sst->get_puts_posted() : 0;
     while(!thread_shutdown) {
         std::this_thread::sleep_for(std::chrono::milliseconds(sender_timeout));
         if(sst) {
@@ -1114,31 +1872,44 @@ void MulticastGroup::check_failures_loop() {
                     }
                 }
             }
-            sst->put_with_completion((char*)std::addressof(sst->local_stability_frontier[0][0]) - sst->getBaseAddress(),
-                                     sizeof(sst->local_stability_frontier[0][0]) * sst->local_stability_frontier.size());
+            const size_t frontier_offset = (char*)std::addressof(sst->local_stability_frontier[0][0]) - sst->getBaseAddress();
+            const size_t frontier_size = sizeof(sst->local_stability_frontier[0][0]) * sst->local_stability_frontier.size();
+            const uint64_t puts_before_tick = sst->get_puts_posted();
+            const uint64_t tick_time = get_time();
+            // The stability frontier itself is refreshed with a cheap
+            // unsignaled push every tick
+            sst->put(frontier_offset, frontier_size);
+            if(puts_before_tick != puts_at_last_tick) {
+                // Data pushes since the last tick already probed the other
+                // members' NICs (their failures surface as error completions),
+                // so a heartbeat-only completion probe would be redundant
+                last_probe_time = tick_time;
+            } else if(tick_time - last_probe_time >= probe_interval_ns) {
+                sst->put_with_completion(frontier_offset, frontier_size);
+                last_probe_time = tick_time;
+            }
+            puts_at_last_tick = sst->get_puts_posted();
+            //This thread is also the lazy push for the performance counters
+            sst->push_perf_counters();
         }
     }
 }
 
 // we already hold the lock on msg_state_mtx when we call this
-void MulticastGroup::get_buffer_and_send_auto_null(subgroup_id_t subgroup_num) {
+bool MulticastGroup::get_buffer_and_send_auto_null(subgroup_id_t subgroup_num) {
     // short-circuits most of the normal checks because
     // we know that we received a message and are sending a null
     long long unsigned int msg_size = sizeof(header);
     const DerechoParams& profile = subgroup_settings_map.at(subgroup_num).profile;
     // very unlikely that msg_size does not fit in the max_msg_size since we are sending a NULL
     // but the user might not be interested in using SSTMC at all, then sst::max_msg_size can be zero
-    if(msg_size > profile.sst_max_msg_size) {
+    if(msg_size > medium_crossover(subgroup_num, profile)) {
         // Create new Message
         RDMCMessage msg;
         msg.sender_id = members[member_index];
         msg.index = future_message_indices[subgroup_num];
         msg.size = msg_size;
-        if(free_message_buffers[subgroup_num].empty()) {
-            free_message_buffers[subgroup_num].emplace_back(profile.max_msg_size);
-        }
-        msg.message_buffer = std::move(free_message_buffers[subgroup_num].back());
-        free_message_buffers[subgroup_num].pop_back();
+        msg.message_buffer = MessageBufferPool::get(profile.max_msg_size);
 
         auto current_time = get_time();
         pending_message_timestamps[subgroup_num].insert(current_time);
@@ -1149,14 +1920,22 @@ void MulticastGroup::get_buffer_and_send_auto_null(subgroup_id_t subgroup_num) {
         ((header*)buf)->index = msg.index;
         ((header*)buf)->timestamp = current_time;
         ((header*)buf)->cooked_send = false;
+        ((header*)buf)->fragment_state = static_cast<uint8_t>(FragmentState::COMPLETE);
 
         future_message_indices[subgroup_num]++;
-        pending_sends[subgroup_num].push(std::move(msg));
+        if(!pending_sends[subgroup_num].try_enqueue(std::move(msg))) {
+            throw derecho_exception("pending send ring overflowed its bound");
+        }
         sender_cv.notify_all();
     } else {
         char* buf = (char*)sst_multicast_group_ptrs[subgroup_num]->get_buffer(msg_size);
 
-        assert(buf);
+        if(!buf) {
+            // slots are only freed when their messages are delivered, so the
+            // window can legitimately be full here; the caller retries the
+            // null on the next receive event
+            return false;
+        }
 
         auto current_time = get_time();
         pending_message_timestamps[subgroup_num].insert(current_time);
@@ -1165,15 +1944,241 @@ void MulticastGroup::get_buffer_and_send_auto_null(subgroup_id_t subgroup_num) {
         ((header*)buf)->index = future_message_indices[subgroup_num];
         ((header*)buf)->timestamp = current_time;
         ((header*)buf)->cooked_send = false;
+        ((header*)buf)->fragment_state = static_cast<uint8_t>(FragmentState::COMPLETE);
 
         future_message_indices[subgroup_num]++;
         sst_multicast_group_ptrs[subgroup_num]->send();
     }
+    return true;
+}
+
+/** Packs a suppressed-null index interval into one SST cell, so senders can
+ * publish it with a single (atomic) 64-bit write. */
+static inline uint64_t pack_null_interval(int32_t first, int32_t last) {
+    return (static_cast<uint64_t>(static_cast<uint32_t>(first)) << 32)
+           | static_cast<uint32_t>(last);
+}
+
+static inline void unpack_null_interval(uint64_t packed, int32_t& first, int32_t& last) {
+    first = static_cast<int32_t>(packed >> 32);
+    last = static_cast<int32_t>(packed & 0xffffffffull);
+}
+
+// we already hold the lock on msg_state_mtx when we call this
+void MulticastGroup::suppress_auto_null_sends(subgroup_id_t subgroup_num,
+                                              const SubgroupSettings& subgroup_settings,
+                                              int32_t target_future_index) {
+    if(future_message_indices[subgroup_num] >= target_future_index) {
+        return;
+    }
+    const uint32_t my_entry = subgroup_settings.num_received_offset + subgroup_settings.sender_rank;
+    if(first_suppressed_null_index[subgroup_num] < 0) {
+        first_suppressed_null_index[subgroup_num] = future_message_indices[subgroup_num];
+    }
+    // count the suppressed nulls as received from ourselves, just as the
+    // loopback delivery of real null messages would have
+    int32_t new_num_received = sst->num_received[member_index][my_entry];
+    for(int32_t index = future_message_indices[subgroup_num]; index < target_future_index; index++) {
+        new_num_received = resolve_num_received(index, my_entry);
+    }
+    future_message_indices[subgroup_num] = target_future_index;
+    if(new_num_received > sst->num_received[member_index][my_entry]) {
+        sst->num_received[member_index][my_entry] = new_num_received;
+    }
+    sst->suppressed_nulls[member_index][my_entry]
+            = pack_null_interval(first_suppressed_null_index[subgroup_num], target_future_index - 1);
+    dbg_default_trace("Subgroup {}: suppressing null messages [{}, {}]", subgroup_num,
+                      first_suppressed_null_index[subgroup_num], target_future_index - 1);
+    // only the shard's members poll these entries
+    const std::vector<uint32_t> shard_sst_indices = get_shard_sst_indices(subgroup_num);
+    sst->put(shard_sst_indices, sst->suppressed_nulls, my_entry);
+    sst->put(shard_sst_indices, sst->num_received, my_entry);
+}
+
+bool MulticastGroup::suppressed_nulls_predicate(const SubgroupSettings& subgroup_settings,
+                                                const std::map<uint32_t, uint32_t>& shard_ranks_by_sender_rank,
+                                                uint32_t num_shard_senders, const DerechoSST& sst) {
+    for(uint sender_count = 0; sender_count < num_shard_senders; ++sender_count) {
+        const uint32_t entry = subgroup_settings.num_received_offset + sender_count;
+        const uint32_t sender_sst_index = node_id_to_sst_index.at(
+                subgroup_settings.members[shard_ranks_by_sender_rank.at(sender_count)]);
+        int32_t first_null, last_null;
+        unpack_null_interval(sst.suppressed_nulls[sender_sst_index][entry], first_null, last_null);
+        const int32_t num_received = sst.num_received[member_index][entry];
+        // the interval only counts once everything before it has arrived
+        if(last_null > num_received && num_received >= first_null - 1) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void MulticastGroup::apply_suppressed_nulls(subgroup_id_t subgroup_num,
+                                            const SubgroupSettings& subgroup_settings,
+                                            const std::map<uint32_t, uint32_t>& shard_ranks_by_sender_rank,
+                                            uint32_t num_shard_senders,
+                                            const std::vector<uint32_t>& shard_sst_indices,
+                                            DerechoSST& sst) {
+    std::lock_guard<std::recursive_mutex> lock(msg_state_mtx);
+    bool advanced = false;
+    for(uint sender_count = 0; sender_count < num_shard_senders; ++sender_count) {
+        const uint32_t entry = subgroup_settings.num_received_offset + sender_count;
+        const uint32_t sender_sst_index = node_id_to_sst_index.at(
+                subgroup_settings.members[shard_ranks_by_sender_rank.at(sender_count)]);
+        int32_t first_null, last_null;
+        unpack_null_interval(sst.suppressed_nulls[sender_sst_index][entry], first_null, last_null);
+        int32_t num_received = sst.num_received[member_index][entry];
+        if(last_null <= num_received || num_received < first_null - 1) {
+            continue;
+        }
+        trc_default_event("count_suppressed_nulls", subgroup_num, last_null);
+        for(int32_t index = num_received + 1; index <= last_null; index++) {
+            num_received = resolve_num_received(index, entry);
+        }
+        if(num_received > sst.num_received[member_index][entry]) {
+            sst.num_received[member_index][entry] = num_received;
+            advanced = true;
+        }
+    }
+    if(!advanced) {
+        return;
+    }
+    // mirror the seq_num update in receiver_function, combining the pushes
+    // into a single RDMA write per receiver and scoping them to the shard
+    sst::SST<DerechoSST>::CoalescedPutsGuard coalesce_puts(sst);
+    auto* min_ptr = std::min_element(&sst.num_received[member_index][subgroup_settings.num_received_offset],
+                                     &sst.num_received[member_index][subgroup_settings.num_received_offset + num_shard_senders]);
+    int min_index = std::distance(&sst.num_received[member_index][subgroup_settings.num_received_offset], min_ptr);
+    message_id_t new_seq_num = (*min_ptr + 1) * num_shard_senders + min_index - 1;
+    if(new_seq_num > sst.seq_num[member_index][subgroup_num]) {
+        trc_default_event("update_seq_num", subgroup_num, new_seq_num);
+        sst.seq_num[member_index][subgroup_num] = new_seq_num;
+        sst.put(shard_sst_indices, sst.seq_num, subgroup_num);
+    }
+    // num_received is column-major, so let the SST compute the offset
+    sst.put(shard_sst_indices, sst.num_received, subgroup_settings.num_received_offset, num_shard_senders);
+}
+
+bool MulticastGroup::try_piggyback_reply(node_id_t dest_id, char* reply_msg, uint32_t size) {
+    if(piggyback_reply_max_size == 0 || size > piggyback_reply_max_size) {
+        return false;
+    }
+    auto rank_search = node_id_to_sst_index.find(dest_id);
+    if(rank_search == node_id_to_sst_index.end()) {
+        return false;
+    }
+    const uint32_t dest_rank = rank_search->second;
+    const size_t slot_stride = piggyback_reply_max_size + 2 * sizeof(uint64_t);
+    std::lock_guard<std::mutex> lock(piggyback_mutex);
+    // flow control: never overwrite a slot the destination hasn't consumed yet
+    const uint64_t acked = sst->piggyback_reply_acks[dest_rank][member_index];
+    if(piggyback_replies_sent[dest_rank] - acked >= piggyback_reply_window) {
+        return false;
+    }
+    const uint64_t sent = piggyback_replies_sent[dest_rank]++;
+    const size_t slot_offset = (dest_rank * piggyback_reply_window + sent % piggyback_reply_window)
+                               * slot_stride;
+    volatile char* slot = &sst->piggyback_reply_slots[member_index][slot_offset];
+    memcpy(const_cast<char*>(slot), reply_msg, size);
+    ((uint64_t&)slot[piggyback_reply_max_size]) = size;
+    ((uint64_t&)slot[piggyback_reply_max_size + sizeof(uint64_t)]) = sent / piggyback_reply_window + 1;
+    // Push the reply and size word first, then the sequence number in a
+    // separate write: placement within a single RDMA write is unordered, but
+    // writes on the same connection are ordered, so a receiver that sees the
+    // new sequence number is guaranteed to see the reply as well. Both writes
+    // go only to the destination's row.
+    const size_t slot_base = (char*)std::addressof(sst->piggyback_reply_slots[0][slot_offset])
+                             - sst->getBaseAddress();
+    sst->put_segments({dest_rank}, {{slot_base, size},
+                                    {slot_base + piggyback_reply_max_size, sizeof(uint64_t)}});
+    sst->put({dest_rank}, slot_base + piggyback_reply_max_size + sizeof(uint64_t), sizeof(uint64_t));
+    return true;
+}
+
+bool MulticastGroup::piggyback_replies_predicate(const DerechoSST& sst) {
+    const size_t slot_stride = piggyback_reply_max_size + 2 * sizeof(uint64_t);
+    const size_t my_region = member_index * piggyback_reply_window * slot_stride;
+    for(uint sender = 0; sender < num_members; ++sender) {
+        if(sender == static_cast<uint>(member_index)) {
+            continue;
+        }
+        const uint64_t consumed = piggyback_replies_consumed[sender];
+        const size_t slot_offset = my_region + (consumed % piggyback_reply_window) * slot_stride;
+        if((uint64_t&)sst.piggyback_reply_slots[sender][slot_offset + piggyback_reply_max_size + sizeof(uint64_t)]
+           == consumed / piggyback_reply_window + 1) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void MulticastGroup::deliver_piggybacked_replies(DerechoSST& sst) {
+    const size_t slot_stride = piggyback_reply_max_size + 2 * sizeof(uint64_t);
+    const size_t my_region = member_index * piggyback_reply_window * slot_stride;
+    bool acked_anything = false;
+    for(uint sender = 0; sender < num_members; ++sender) {
+        if(sender == static_cast<uint>(member_index)) {
+            continue;
+        }
+        while(true) {
+            const uint64_t consumed = piggyback_replies_consumed[sender];
+            const size_t slot_offset = my_region + (consumed % piggyback_reply_window) * slot_stride;
+            volatile char* slot = &sst.piggyback_reply_slots[sender][slot_offset];
+            if((uint64_t&)slot[piggyback_reply_max_size + sizeof(uint64_t)]
+               != consumed / piggyback_reply_window + 1) {
+                break;
+            }
+            const uint64_t reply_size = (uint64_t&)slot[piggyback_reply_max_size];
+            // replies are routed by their header alone, so the subgroup
+            // argument is unused; pass 0
+            rpc_callback(0, members[sender], const_cast<char*>(slot), reply_size);
+            piggyback_replies_consumed[sender] = consumed + 1;
+            gmssst::set(sst.piggyback_reply_acks[member_index][sender], consumed + 1);
+            acked_anything = true;
+        }
+    }
+    if(acked_anything) {
+        // Tell the senders their slots are free. One write per sender would
+        // target just that sender's ack entry, but the whole ack vector is
+        // tiny, so push it to everyone in one pass.
+        sst.put(sst.piggyback_reply_acks);
+    }
+}
+
+int32_t MulticastGroup::compute_send_occupancy(subgroup_id_t subgroup_num,
+                                               const SubgroupSettings& subgroup_settings) {
+    const std::vector<node_id_t>& shard_members = subgroup_settings.members;
+    const uint32_t num_shard_senders = get_num_senders(subgroup_settings.senders);
+    const int shard_sender_index = subgroup_settings.sender_rank;
+    // Find the highest of this sender's message indices that is stable
+    // (delivered, or received in UNORDERED mode) everywhere in the shard
+    int32_t my_stable_index;
+    if(subgroup_settings.mode != Mode::UNORDERED) {
+        int32_t min_delivered_num = std::numeric_limits<int32_t>::max();
+        for(uint i = 0; i < shard_members.size(); ++i) {
+            min_delivered_num = std::min(min_delivered_num,
+                                         sst->delivered_num[node_id_to_sst_index.at(shard_members[i])][subgroup_num]);
+        }
+        // Sequence numbers interleave round-robin, so my index k is delivered
+        // when k * num_shard_senders + shard_sender_index is
+        const int32_t delta = min_delivered_num - shard_sender_index;
+        my_stable_index = (delta >= 0) ? delta / static_cast<int32_t>(num_shard_senders) : -1;
+    } else {
+        const auto num_received_offset = subgroup_settings.num_received_offset;
+        int32_t min_num_received = std::numeric_limits<int32_t>::max();
+        for(uint i = 0; i < shard_members.size(); ++i) {
+            min_num_received = std::min(min_num_received,
+                                        sst->num_received[node_id_to_sst_index.at(shard_members[i])][num_received_offset + shard_sender_index]);
+        }
+        my_stable_index = min_num_received;
+    }
+    return static_cast<int32_t>(future_message_indices[subgroup_num]) - my_stable_index - 1;
 }
 
 char* MulticastGroup::get_sendbuffer_ptr(subgroup_id_t subgroup_num,
                                          long long unsigned int payload_size,
-                                         bool cooked_send) {
+                                         bool cooked_send,
+                                         FragmentState fragment_state) {
     long long unsigned int msg_size = payload_size + sizeof(header);
     const SubgroupSettings& subgroup_settings = subgroup_settings_map.at(subgroup_num);
     if(msg_size > subgroup_settings.profile.max_msg_size) {
@@ -1182,6 +2187,11 @@ char* MulticastGroup::get_sendbuffer_ptr(subgroup_id_t subgroup_num,
         throw derecho_exception(exp_msg);
     }
 
+    if(wedged_subgroups.count(subgroup_num) > 0) {
+        // This shard contains a suspected node and was wedged ahead of the
+        // rest of the view; refuse new sends until the view change completes
+        return nullptr;
+    }
     std::vector<node_id_t> shard_members = subgroup_settings.members;
     auto num_shard_members = shard_members.size();
     // if the current node is not a sender, shard_sender_index will be -1
@@ -1191,33 +2201,15 @@ char* MulticastGroup::get_sendbuffer_ptr(subgroup_id_t subgroup_num,
     num_shard_senders = get_num_senders(shard_senders);
     assert(shard_sender_index >= 0);
 
-    if(subgroup_settings.mode != Mode::UNORDERED) {
-        for(uint i = 0; i < num_shard_members; ++i) {
-            if(sst->delivered_num[node_id_to_sst_index.at(shard_members[i])][subgroup_num]
-               < static_cast<int32_t>((future_message_indices[subgroup_num] - subgroup_settings.profile.window_size) * num_shard_senders + shard_sender_index)) {
-                return nullptr;
-            }
-        }
-    } else {
-        for(uint i = 0; i < num_shard_members; ++i) {
-            auto num_received_offset = subgroup_settings.num_received_offset;
-            if(sst->num_received[node_id_to_sst_index.at(shard_members[i])][num_received_offset + shard_sender_index]
-               < static_cast<int32_t>(future_message_indices[subgroup_num] - subgroup_settings.profile.window_size)) {
-                return nullptr;
-            }
-        }
+    if(!admit_to_send_window(subgroup_num, subgroup_settings)) {
+        return nullptr;
     }
 
-    if(msg_size > subgroup_settings.profile.sst_max_msg_size) {
+    if(msg_size > medium_crossover(subgroup_num, subgroup_settings.profile)) {
         if(thread_shutdown) {
             return nullptr;
         }
 
-        if(free_message_buffers[subgroup_num].empty()) {
-            free_message_buffers[subgroup_num].emplace_back(
-                    subgroup_settings.profile.max_msg_size);
-        }
-
         if(pending_sst_sends[subgroup_num] || next_sends[subgroup_num]) {
             return nullptr;
         }
@@ -1227,8 +2219,7 @@ char* MulticastGroup::get_sendbuffer_ptr(subgroup_id_t subgroup_num,
         msg.sender_id = members[member_index];
         msg.index = future_message_indices[subgroup_num];
         msg.size = msg_size;
-        msg.message_buffer = std::move(free_message_buffers[subgroup_num].back());
-        free_message_buffers[subgroup_num].pop_back();
+        msg.message_buffer = MessageBufferPool::get(subgroup_settings.profile.max_msg_size);
 
         auto current_time = get_time();
         pending_message_timestamps[subgroup_num].insert(current_time);
@@ -1239,9 +2230,12 @@ char* MulticastGroup::get_sendbuffer_ptr(subgroup_id_t subgroup_num,
         ((header*)buf)->index = msg.index;
         ((header*)buf)->timestamp = current_time;
         ((header*)buf)->cooked_send = cooked_send;
+        ((header*)buf)->fragment_state = static_cast<uint8_t>(fragment_state);
 
         next_sends[subgroup_num] = std::move(msg);
         future_message_indices[subgroup_num]++;
+        // a real message ends the current run of suppressed nulls
+        first_suppressed_null_index[subgroup_num] = -1;
 
         last_transfer_medium[subgroup_num] = true;
         return buf + sizeof(header);
@@ -1267,42 +2261,266 @@ char* MulticastGroup::get_sendbuffer_ptr(subgroup_id_t subgroup_num,
         ((header*)buf)->index = future_message_indices[subgroup_num];
         ((header*)buf)->timestamp = current_time;
         ((header*)buf)->cooked_send = cooked_send;
+        ((header*)buf)->fragment_state = static_cast<uint8_t>(fragment_state);
         future_message_indices[subgroup_num]++;
-        dbg_default_trace("Subgroup {}: get_sendbuffer_ptr increased future_message_indices to {}",
-                          subgroup_num, future_message_indices[subgroup_num]);
+        // a real message ends the current run of suppressed nulls
+        first_suppressed_null_index[subgroup_num] = -1;
+        trc_default_event("get_sendbuffer", subgroup_num, future_message_indices[subgroup_num]);
 
         last_transfer_medium[subgroup_num] = false;
         return buf + sizeof(header);
     }
 }
 
+bool MulticastGroup::admit_to_send_window(subgroup_id_t subgroup_num,
+                                          const SubgroupSettings& subgroup_settings) {
+    /* Admission check against the adaptive send window: refuse if admitting
+     * another message would put more than effective_window of this sender's
+     * messages in flight beyond the shard-wide stability frontier. With
+     * effective_window == profile.window_size this is exactly the old
+     * fixed-window check. */
+    AdaptiveSendWindow& send_window = adaptive_send_windows[subgroup_num];
+    const int32_t occupancy = compute_send_occupancy(subgroup_num, subgroup_settings);
+    if(occupancy >= static_cast<int32_t>(send_window.effective_window)) {
+        // A burst wants a deeper pipeline than the current window; grow it so
+        // the retry (and subsequent sends) can run further ahead, up to the
+        // preallocated maximum
+        if(send_window.effective_window < subgroup_settings.profile.window_size) {
+            send_window.effective_window = std::min(subgroup_settings.profile.window_size,
+                                                    2 * send_window.effective_window);
+        }
+        return false;
+    }
+    send_window.peak_occupancy = std::max(send_window.peak_occupancy,
+                                          static_cast<uint32_t>(occupancy) + 1);
+    if(++send_window.sends_since_adjust >= AdaptiveSendWindow::adjust_interval) {
+        // A whole interval fit comfortably in half the window, so this
+        // subgroup is running shallow: halve the window to bound how much
+        // stability lag a future burst can build up
+        if(send_window.peak_occupancy <= send_window.effective_window / 2) {
+            const uint32_t floor_window = std::min(AdaptiveSendWindow::min_window,
+                                                   subgroup_settings.profile.window_size);
+            send_window.effective_window = std::max(floor_window, send_window.effective_window / 2);
+        }
+        send_window.peak_occupancy = 0;
+        send_window.sends_since_adjust = 0;
+    }
+    return true;
+}
+
 bool MulticastGroup::send(subgroup_id_t subgroup_num, long long unsigned int payload_size,
                           const std::function<void(char* buf)>& msg_generator, bool cooked_send) {
-    if(!rdmc_sst_groups_created) {
+    if(payload_size + sizeof(header) > subgroup_settings_map.at(subgroup_num).profile.max_msg_size) {
+        return send_fragmented(subgroup_num, payload_size, msg_generator, cooked_send);
+    }
+    return send_single(subgroup_num, payload_size, msg_generator, cooked_send, FragmentState::COMPLETE);
+}
+
+bool MulticastGroup::send_single(subgroup_id_t subgroup_num, long long unsigned int payload_size,
+                                 const std::function<void(char* buf)>& msg_generator, bool cooked_send,
+                                 FragmentState fragment_state) {
+    if(!rdmc_sst_groups_created || draining) {
         return false;
     }
     std::unique_lock<std::recursive_mutex> lock(msg_state_mtx);
 
-    char* buf = get_sendbuffer_ptr(subgroup_num, payload_size, cooked_send);
+    char* buf = get_sendbuffer_ptr(subgroup_num, payload_size, cooked_send, fragment_state);
     while(!buf) {
         // Don't want any deadlocks. For example, this thread cannot get a buffer because delivery is lagging
         // but the SST detect thread cannot proceed (and deliver) because it requires the same lock
         // do not use defer_lock in the unique_lock declaration above and move unlock to the end of the loop.
         // That will cause a bug. We want to unlock only when we are sure that buf is nullptr.
         lock.unlock();
-        if(thread_shutdown) {
+        if(thread_shutdown || subgroup_is_wedged(subgroup_num)) {
             return false;
         }
         lock.lock();
-        buf = get_sendbuffer_ptr(subgroup_num, payload_size, cooked_send);
+        buf = get_sendbuffer_ptr(subgroup_num, payload_size, cooked_send, fragment_state);
     }
 
     // call to the user supplied message generator
     msg_generator(buf);
 
+    return finish_send(subgroup_num);
+}
+
+bool MulticastGroup::send_fragmented(subgroup_id_t subgroup_num, long long unsigned int payload_size,
+                                     const std::function<void(char* buf)>& msg_generator, bool cooked_send) {
+    const uint64_t max_fragment_payload
+            = subgroup_settings_map.at(subgroup_num).profile.max_msg_size - sizeof(header);
+    // Run the generator once, into a contiguous staging buffer, since it
+    // expects to see the whole message
+    std::vector<char> whole_message(payload_size);
+    msg_generator(whole_message.data());
+
+    // One train at a time from this node: receivers reassemble by appending,
+    // so interleaved trains from the same sender would corrupt each other
+    std::lock_guard<std::mutex> train_lock(fragmented_send_mtx);
+    uint64_t offset = 0;
+    while(offset < payload_size) {
+        const uint64_t fragment_size = std::min<uint64_t>(max_fragment_payload, payload_size - offset);
+        const bool last_fragment = (offset + fragment_size == payload_size);
+        const char* fragment_start = whole_message.data() + offset;
+        if(!send_single(subgroup_num, fragment_size,
+                        [fragment_start, fragment_size](char* buf) {
+                            memcpy(buf, fragment_start, fragment_size);
+                        },
+                        cooked_send,
+                        last_fragment ? FragmentState::LAST_FRAGMENT : FragmentState::FRAGMENT)) {
+            // Shutdown mid-train: receivers discard the partial train along
+            // with the rest of this group's state
+            return false;
+        }
+        offset += fragment_size;
+    }
+    return true;
+}
+
+bool MulticastGroup::send_zero_copy(subgroup_id_t subgroup_num, std::shared_ptr<rdma::memory_region> user_mr,
+                                    size_t offset, long long unsigned int payload_size,
+                                    std::function<void()> release_callback) {
+    if(!rdmc_sst_groups_created || draining) {
+        return false;
+    }
+    const long long unsigned int msg_size = payload_size + sizeof(header);
+    const SubgroupSettings& subgroup_settings = subgroup_settings_map.at(subgroup_num);
+    if(subgroup_settings.mode != Mode::UNORDERED) {
+        throw derecho_exception("send_zero_copy is only supported in UNORDERED (raw) subgroups");
+    }
+    if(msg_size > subgroup_settings.profile.max_msg_size) {
+        std::string exp_msg("Can't send messages of size larger than the maximum message size which is equal to ");
+        exp_msg += subgroup_settings.profile.max_msg_size;
+        throw derecho_exception(exp_msg);
+    }
+    if(offset + msg_size > user_mr->size) {
+        throw derecho_exception("Zero-copy send extends past the end of the registered memory region");
+    }
+    std::unique_lock<std::recursive_mutex> lock(msg_state_mtx);
+    // The same retry structure as send_single: drop the lock between
+    // attempts so a lagging delivery (which needs msg_state_mtx) can free
+    // the send window
+    while(true) {
+        if(thread_shutdown || subgroup_is_wedged(subgroup_num)) {
+            return false;
+        }
+        if(wedged_subgroups.count(subgroup_num) == 0
+           && !pending_sst_sends[subgroup_num] && !next_sends[subgroup_num]
+           && admit_to_send_window(subgroup_num, subgroup_settings)) {
+            break;
+        }
+        lock.unlock();
+        lock.lock();
+    }
+
+    RDMCMessage msg;
+    msg.sender_id = members[member_index];
+    msg.index = future_message_indices[subgroup_num];
+    msg.size = msg_size;
+    msg.message_buffer = MessageBuffer(std::move(user_mr), offset, std::move(release_callback));
+
+    auto current_time = get_time();
+    pending_message_timestamps[subgroup_num].insert(current_time);
+
+    // Fill header; the payload is already in place after it
+    char* buf = msg.message_buffer.buffer.get();
+    ((header*)buf)->header_size = sizeof(header);
+    ((header*)buf)->index = msg.index;
+    ((header*)buf)->timestamp = current_time;
+    ((header*)buf)->cooked_send = false;
+    ((header*)buf)->fragment_state = static_cast<uint8_t>(FragmentState::COMPLETE);
+
+    next_sends[subgroup_num] = std::move(msg);
+    future_message_indices[subgroup_num]++;
+    // a real message ends the current run of suppressed nulls
+    first_suppressed_null_index[subgroup_num] = -1;
+    last_transfer_medium[subgroup_num] = true;
+
+    return finish_send(subgroup_num);
+}
+
+bool MulticastGroup::try_send(subgroup_id_t subgroup_num, long long unsigned int payload_size,
+                              const std::function<void(char* buf)>& msg_generator, bool cooked_send) {
+    if(payload_size + sizeof(header) > subgroup_settings_map.at(subgroup_num).profile.max_msg_size) {
+        return try_send_fragmented(subgroup_num, payload_size, msg_generator, cooked_send);
+    }
+    if(!rdmc_sst_groups_created) {
+        return false;
+    }
+    std::unique_lock<std::recursive_mutex> lock(msg_state_mtx);
+    if(thread_shutdown) {
+        return false;
+    }
+
+    char* buf = get_sendbuffer_ptr(subgroup_num, payload_size, cooked_send);
+    if(!buf) {
+        return false;
+    }
+
+    // call to the user supplied message generator
+    msg_generator(buf);
+
+    return finish_send(subgroup_num);
+}
+
+bool MulticastGroup::try_send_fragmented(subgroup_id_t subgroup_num, long long unsigned int payload_size,
+                                         const std::function<void(char* buf)>& msg_generator, bool cooked_send) {
+    const SubgroupSettings& subgroup_settings = subgroup_settings_map.at(subgroup_num);
+    const uint64_t max_fragment_payload = subgroup_settings.profile.max_msg_size - sizeof(header);
+    const uint64_t num_fragments = (payload_size + max_fragment_payload - 1) / max_fragment_payload;
+    // A train cannot be aborted once started, so only begin one when every
+    // fragment has a credit; trains longer than the window can never satisfy
+    // that and must use the blocking send
+    if(num_fragments > subgroup_settings.profile.window_size) {
+        return false;
+    }
+    std::unique_lock<std::mutex> train_lock(fragmented_send_mtx, std::try_to_lock);
+    if(!train_lock.owns_lock()) {
+        return false;
+    }
+    if(static_cast<uint64_t>(get_send_credits(subgroup_num)) < num_fragments) {
+        return false;
+    }
+    // The credits reserved above make blocking unlikely, but a concurrent
+    // view change can still stall individual fragments briefly
+    std::vector<char> whole_message(payload_size);
+    msg_generator(whole_message.data());
+    uint64_t offset = 0;
+    while(offset < payload_size) {
+        const uint64_t fragment_size = std::min<uint64_t>(max_fragment_payload, payload_size - offset);
+        const bool last_fragment = (offset + fragment_size == payload_size);
+        const char* fragment_start = whole_message.data() + offset;
+        if(!send_single(subgroup_num, fragment_size,
+                        [fragment_start, fragment_size](char* buf) {
+                            memcpy(buf, fragment_start, fragment_size);
+                        },
+                        cooked_send,
+                        last_fragment ? FragmentState::LAST_FRAGMENT : FragmentState::FRAGMENT)) {
+            return false;
+        }
+        offset += fragment_size;
+    }
+    return true;
+}
+
+bool MulticastGroup::finish_send(subgroup_id_t subgroup_num) {
+    if(MessageTimeline::isEnabled()) {
+        const SubgroupSettings& subgroup_settings = subgroup_settings_map.at(subgroup_num);
+        if(subgroup_settings.sender_rank >= 0) {
+            // the message just built has the index assigned by get_sendbuffer_ptr
+            const message_id_t message_index = future_message_indices[subgroup_num] - 1;
+            const message_id_t sequence_number
+                    = message_index * get_num_senders(subgroup_settings.senders)
+                      + subgroup_settings.sender_rank;
+            MessageTimeline::record(subgroup_num, sequence_number, MessageTimeline::SEND);
+        }
+    }
+    sst->increment_perf_counter(PerfCounter::MESSAGES_SENT);
+
     if(last_transfer_medium[subgroup_num]) {
         assert(next_sends[subgroup_num]);
-        pending_sends[subgroup_num].push(std::move(*next_sends[subgroup_num]));
+        if(!pending_sends[subgroup_num].try_enqueue(std::move(*next_sends[subgroup_num]))) {
+            throw derecho_exception("pending send ring overflowed its bound");
+        }
         next_sends[subgroup_num] = std::nullopt;
         sender_cv.notify_all();
         return true;
@@ -1313,6 +2531,65 @@ bool MulticastGroup::send(subgroup_id_t subgroup_num, long long unsigned int pay
     }
 }
 
+uint64_t MulticastGroup::medium_crossover(subgroup_id_t subgroup_num, const DerechoParams& profile) const {
+    const uint64_t crossover = adaptive_medium_selectors[subgroup_num].crossover;
+    return (crossover == 0) ? profile.sst_max_msg_size : crossover;
+}
+
+void MulticastGroup::record_medium_latency(subgroup_id_t subgroup_num, bool via_rdmc,
+                                           uint64_t latency_ns, uint64_t msg_size) {
+    AdaptiveMediumSelector& selector = adaptive_medium_selectors[subgroup_num];
+    const uint64_t crossover = selector.crossover;
+    if(crossover == 0) {
+        // SMC is disabled for this subgroup; there is nothing to tune
+        return;
+    }
+    /* Only messages near the crossover say anything about where it belongs:
+     * sizes in [crossover/2, crossover] sample the SMC side of the boundary
+     * and sizes in (crossover, 2*crossover] the RDMC side. A 200-byte SMC
+     * latency and a 2MB RDMC latency are both irrelevant to it. */
+    if(msg_size < crossover / 2 || msg_size > crossover * 2) {
+        return;
+    }
+    uint64_t& medium_ewma = via_rdmc ? selector.rdmc_latency_ewma : selector.smc_latency_ewma;
+    medium_ewma = (medium_ewma == 0) ? latency_ns : (medium_ewma - medium_ewma / 8 + latency_ns / 8);
+    if(++selector.samples_since_adjust < AdaptiveMediumSelector::adjust_interval) {
+        return;
+    }
+    selector.samples_since_adjust = 0;
+    if(selector.smc_latency_ewma == 0 || selector.rdmc_latency_ewma == 0) {
+        // no basis for comparison until both media have been observed
+        return;
+    }
+    const uint64_t max_crossover = subgroup_settings_map.at(subgroup_num).profile.sst_max_msg_size;
+    const uint64_t min_crossover = std::max<uint64_t>(
+            1, max_crossover / AdaptiveMediumSelector::crossover_floor_divisor);
+    if(selector.smc_latency_ewma <= selector.rdmc_latency_ewma) {
+        // SMC is winning around the boundary: let larger messages use it
+        selector.crossover = std::min(max_crossover, crossover + crossover / 4);
+    } else {
+        // RDMC is winning: push borderline messages to it, but keep
+        // genuinely small messages on the SMC fast path
+        selector.crossover = std::max(min_crossover, crossover - crossover / 4);
+    }
+}
+
+int32_t MulticastGroup::get_send_credits(subgroup_id_t subgroup_num) {
+    const SubgroupSettings& subgroup_settings = subgroup_settings_map.at(subgroup_num);
+    if(subgroup_settings.sender_rank < 0) {
+        return 0;
+    }
+    std::lock_guard<std::recursive_mutex> lock(msg_state_mtx);
+    const int32_t credits = static_cast<int32_t>(adaptive_send_windows[subgroup_num].effective_window)
+                            - compute_send_occupancy(subgroup_num, subgroup_settings);
+    return std::max(credits, int32_t{0});
+}
+
+void MulticastGroup::set_send_credits_callback(subgroup_id_t subgroup_num, std::function<void()> callback) {
+    std::lock_guard<std::recursive_mutex> lock(msg_state_mtx);
+    send_credits_callbacks[subgroup_num] = std::move(callback);
+}
+
 bool MulticastGroup::check_pending_sst_sends(subgroup_id_t subgroup_num) {
     std::lock_guard<std::recursive_mutex> lock(msg_state_mtx);
     return pending_sst_sends[subgroup_num];
@@ -1328,6 +2605,21 @@ std::vector<uint32_t> MulticastGroup::get_shard_sst_indices(subgroup_id_t subgro
     return shard_sst_indices;
 }
 
+std::vector<uint32_t> MulticastGroup::get_voting_sst_indices(subgroup_id_t subgroup_num) {
+    const SubgroupSettings& settings = subgroup_settings_map.at(subgroup_num);
+    std::vector<uint32_t> voting_sst_indices;
+    for(std::size_t shard_rank = 0; shard_rank < settings.members.size(); ++shard_rank) {
+        const uint32_t sst_index = node_id_to_sst_index.at(settings.members[shard_rank]);
+        // the local node's own row always votes, even when it is a standby,
+        // so local delivery stays bounded by local contiguous receipt
+        if(settings.standbys.empty() || !settings.standbys[shard_rank]
+           || sst_index == static_cast<uint32_t>(member_index)) {
+            voting_sst_indices.push_back(sst_index);
+        }
+    }
+    return voting_sst_indices;
+}
+
 void MulticastGroup::debug_print() {
     using std::cout;
     using std::endl;
@@ -1356,10 +2648,7 @@ void MulticastGroup::debug_print() {
         cout << endl;
     }
 
-    std::cout << "Printing memory usage of free_message_buffers" << std::endl;
-    for(const auto& p : free_message_buffers) {
-        std::cout << "Subgroup " << p.first << ", Number of free buffers " << p.second.size() << std::endl;
-    }
+    MessageBufferPool::debug_print();
 }
 
 }  // namespace derecho
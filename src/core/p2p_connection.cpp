@@ -8,10 +8,30 @@
 #include <derecho/conf/conf.hpp>
 #include <derecho/core/detail/p2p_connection.hpp>
 #include <derecho/sst/detail/poll_utils.hpp>
+#include <derecho/utils/pinned_memory_budget.hpp>
 
 namespace sst {
-P2PConnection::P2PConnection(uint32_t my_node_id, uint32_t remote_id, uint64_t p2p_buf_size, const RequestParams& request_params) 
-    : my_node_id(my_node_id), remote_id(remote_id), request_params(request_params) {
+
+namespace {
+/* Publishes 'value' into the doorbell word at 'word_addr' unless a
+ * concurrent poster has already published something at least as large.
+ * The CAS loop makes the update a proper atomic fetch-max (the buffer
+ * bytes are plain chars, hence the __atomic builtins), so concurrent
+ * posters can neither lose each other's updates nor regress the word:
+ * it is always the highest post count published so far. */
+void doorbell_fetch_max(volatile char* word_addr, uint64_t value) {
+    uint64_t* word = reinterpret_cast<uint64_t*>(const_cast<char*>(word_addr));
+    uint64_t current = __atomic_load_n(word, __ATOMIC_RELAXED);
+    while(current < value
+          && !__atomic_compare_exchange_n(word, &current, value, true,
+                                          __ATOMIC_RELEASE, __ATOMIC_RELAXED)) {
+    }
+}
+}  // namespace
+
+P2PConnection::P2PConnection(uint32_t my_node_id, uint32_t remote_id, uint64_t p2p_buf_size, const RequestParams& request_params)
+    : my_node_id(my_node_id), remote_id(remote_id), request_params(request_params),
+      doorbell_offset(p2p_buf_size - sizeof(bool) - sizeof(uint64_t)) {
     incoming_p2p_buffer = std::make_unique<volatile char[]>(p2p_buf_size);
     outgoing_p2p_buffer = std::make_unique<volatile char[]>(p2p_buf_size);
     
@@ -24,11 +44,13 @@ P2PConnection::P2PConnection(uint32_t my_node_id, uint32_t remote_id, uint64_t p
 #ifdef USE_VERBS_API
         res = std::make_unique<resources>(remote_id, const_cast<char*>(incoming_p2p_buffer.get()),
                                           const_cast<char*>(outgoing_p2p_buffer.get()),
-                                          p2p_buf_size, p2p_buf_size);
+                                          p2p_buf_size, p2p_buf_size,
+                                          derecho::pinned_memory::p2p_account);
 #else
         res = std::make_unique<resources>(remote_id, const_cast<char*>(incoming_p2p_buffer.get()),
                                           const_cast<char*>(outgoing_p2p_buffer.get()),
-                                          p2p_buf_size, p2p_buf_size, my_node_id > remote_id);
+                                          p2p_buf_size, p2p_buf_size, my_node_id > remote_id,
+                                          derecho::pinned_memory::p2p_account);
 #endif
     }
 }
@@ -46,9 +68,21 @@ uint64_t P2PConnection::getOffsetBuf(REQUEST_TYPE type, uint64_t seq_num) {
     // return max_msg_size * (type * window_size + (seq_num % window_size));
 }
 
+bool P2PConnection::has_incoming_data() {
+    return (uint64_t&)incoming_p2p_buffer[doorbell_offset] != consumed_incoming;
+}
+
 // check if there's a new request from some node
-char* P2PConnection::probe() {
+char* P2PConnection::probe(LANE_CLASS lanes) {
     for(auto type : p2p_request_types) {
+        // the large-request lane has no slots unless tiering is configured
+        if(request_params.window_sizes[type] == 0) {
+            continue;
+        }
+        if((lanes == SMALL_LANES && type == P2P_LARGE_REQUEST)
+           || (lanes == BULK_LANE && type != P2P_LARGE_REQUEST)) {
+            continue;
+        }
         if((uint64_t&)incoming_p2p_buffer[getOffsetSeqNum(type, incoming_seq_nums_map[type])]
            == incoming_seq_nums_map[type] + 1) {
             last_type = type;
@@ -60,39 +94,176 @@ char* P2PConnection::probe() {
 }
 
 void P2PConnection::update_incoming_seq_num() {
+    if(last_type == REQUEST_TYPE::P2P_REPLY) {
+        // A consumed reply retires one outstanding request, freeing a slot
+        // on the request lanes
+        outstanding_request_count.fetch_sub(1);
+    }
     incoming_seq_nums_map[last_type]++;
+    consumed_incoming++;
 }
 
-char* P2PConnection::get_sendbuffer_ptr(REQUEST_TYPE type) {
-    prev_mode = type;
-    if(type != REQUEST_TYPE::P2P_REQUEST
-       || static_cast<int32_t>(incoming_seq_nums_map[REQUEST_TYPE::P2P_REPLY])
-                  > static_cast<int32_t>(outgoing_seq_nums_map[REQUEST_TYPE::P2P_REQUEST] - request_params.window_sizes[P2P_REQUEST])) {
-        (uint64_t&)outgoing_p2p_buffer[getOffsetSeqNum(type, outgoing_seq_nums_map[type])]
-                = outgoing_seq_nums_map[type] + 1;
-        return const_cast<char*>(outgoing_p2p_buffer.get())
-               + getOffsetBuf(type, outgoing_seq_nums_map[type]);
+std::optional<P2PConnection::SendSlot> P2PConnection::reserve_slot(REQUEST_TYPE type, uint64_t msg_size) {
+    std::vector<SendSlot> slots = reserve_slots(type, 1, msg_size);
+    if(slots.empty()) {
+        return std::nullopt;
     }
-    return nullptr;
+    return slots.front();
 }
 
-void P2PConnection::send() {
-    auto type = prev_mode;
+std::vector<P2PConnection::SendSlot> P2PConnection::reserve_slots(REQUEST_TYPE type,
+                                                                  std::size_t count,
+                                                                  uint64_t msg_size) {
+    if(type == REQUEST_TYPE::P2P_REQUEST
+       && request_params.window_sizes[P2P_LARGE_REQUEST] > 0
+       && msg_size > request_params.max_msg_sizes[P2P_REQUEST] - sizeof(uint64_t)) {
+        type = REQUEST_TYPE::P2P_LARGE_REQUEST;
+    }
+    if(type == REQUEST_TYPE::P2P_REQUEST || type == REQUEST_TYPE::P2P_LARGE_REQUEST) {
+        /* Replies for both request lanes arrive on the shared P2P_REPLY ring,
+         * so bound the total outstanding requests by this lane's window; that
+         * also keeps each lane from overwriting a slot the remote has not
+         * consumed yet. The optimistic increment-then-check makes the claim
+         * lock-free: a losing claimant backs its increment out, which can
+         * only make concurrent claimants fail spuriously, never admit too
+         * many. */
+        const int64_t prior_outstanding = outstanding_request_count.fetch_add(count);
+        if(prior_outstanding + static_cast<int64_t>(count)
+           > static_cast<int64_t>(request_params.window_sizes[type])) {
+            outstanding_request_count.fetch_sub(count);
+            return {};
+        }
+    }
+    const uint64_t first_seq_num = outgoing_seq_nums_map[type].fetch_add(count);
+    std::vector<SendSlot> slots;
+    slots.reserve(count);
+    for(std::size_t i = 0; i < count; ++i) {
+        const uint64_t seq_num = first_seq_num + i;
+        // The guard word is local until post(); writing it at reservation
+        // time keeps post() free of per-lane bookkeeping
+        (uint64_t&)outgoing_p2p_buffer[getOffsetSeqNum(type, seq_num)] = seq_num + 1;
+        slots.push_back({type, seq_num,
+                         const_cast<char*>(outgoing_p2p_buffer.get()) + getOffsetBuf(type, seq_num)});
+    }
+    return slots;
+}
+
+void P2PConnection::post(const SendSlot& slot) {
+    const REQUEST_TYPE type = slot.type;
     if(remote_id == my_node_id) {
         // there's no reason why memcpy shouldn't also copy guard and data separately
-        std::memcpy(const_cast<char*>(incoming_p2p_buffer.get()) + getOffsetBuf(type, outgoing_seq_nums_map[type]),
-                    const_cast<char*>(outgoing_p2p_buffer.get()) + getOffsetBuf(type, outgoing_seq_nums_map[type]),
+        std::memcpy(const_cast<char*>(incoming_p2p_buffer.get()) + getOffsetBuf(type, slot.seq_num),
+                    const_cast<char*>(outgoing_p2p_buffer.get()) + getOffsetBuf(type, slot.seq_num),
                     request_params.max_msg_sizes[type] - sizeof(uint64_t));
-        std::memcpy(const_cast<char*>(incoming_p2p_buffer.get()) + getOffsetSeqNum(type, outgoing_seq_nums_map[type]),
-                    const_cast<char*>(outgoing_p2p_buffer.get()) + getOffsetSeqNum(type, outgoing_seq_nums_map[type]),
+        std::memcpy(const_cast<char*>(incoming_p2p_buffer.get()) + getOffsetSeqNum(type, slot.seq_num),
+                    const_cast<char*>(outgoing_p2p_buffer.get()) + getOffsetSeqNum(type, slot.seq_num),
                     sizeof(uint64_t));
+        doorbell_fetch_max(incoming_p2p_buffer.get() + doorbell_offset,
+                           outgoing_doorbell.fetch_add(1) + 1);
     } else {
-        res->post_remote_write(getOffsetBuf(type, outgoing_seq_nums_map[type]),
+        res->post_remote_write(getOffsetBuf(type, slot.seq_num),
                                request_params.max_msg_sizes[type] - sizeof(uint64_t));
-        res->post_remote_write(getOffsetSeqNum(type, outgoing_seq_nums_map[type]),
-                                                      sizeof(uint64_t));
+        res->post_remote_write(getOffsetSeqNum(type, slot.seq_num),
+                               sizeof(uint64_t));
+        /* Ring the remote doorbell last; same-connection RDMA writes are
+         * delivered in order, so the seq num above is visible by the time
+         * the receiver observes the new doorbell value. The fetch-max keeps
+         * the word monotonic under concurrent posters, and each poster's
+         * RDMA write is posted after its own update, so every write carries
+         * at least this poster's count and the remote side converges to the
+         * true post count. */
+        doorbell_fetch_max(outgoing_p2p_buffer.get() + doorbell_offset,
+                           outgoing_doorbell.fetch_add(1) + 1);
+        res->post_remote_write(doorbell_offset, sizeof(uint64_t));
+    }
+}
+
+void P2PConnection::publish_query_snapshot(const char* data, uint64_t size) {
+    assert(request_params.query_snapshot_size > 0);
+    assert(size <= request_params.query_snapshot_size);
+    // The snapshot lives in the incoming buffer, which is the region remote
+    // nodes can target with one-sided operations
+    volatile char* region = incoming_p2p_buffer.get() + request_params.query_snapshot_offset;
+    const uint64_t tail_offset = 2 * sizeof(uint64_t) + request_params.query_snapshot_size;
+    // Seqlock write: bump the head version, copy the size and payload, then
+    // publish the matching tail version. A reader that overlaps this update
+    // observes head != tail and retries.
+    (uint64_t&)region[0] = snapshot_version + 1;
+    (uint64_t&)region[sizeof(uint64_t)] = size;
+    std::memcpy(const_cast<char*>(region) + 2 * sizeof(uint64_t), data, size);
+    (uint64_t&)region[tail_offset] = snapshot_version + 1;
+    snapshot_version++;
+}
+
+bool P2PConnection::fetch_query_snapshot(char* data_out, uint64_t& size_out) {
+    if(request_params.query_snapshot_size == 0) {
+        return false;
+    }
+    const uint64_t region_offset = request_params.query_snapshot_offset;
+    const uint64_t tail_offset = 2 * sizeof(uint64_t) + request_params.query_snapshot_size;
+    const uint64_t region_size = tail_offset + sizeof(uint64_t);
+    std::lock_guard<std::mutex> fetch_lock(snapshot_fetch_mutex);
+    // For a remote connection the read lands at the same offset in the
+    // outgoing buffer, which sends never touch; for the self connection the
+    // snapshot is read in place from the incoming buffer.
+    volatile char* region = (remote_id == my_node_id)
+                                    ? incoming_p2p_buffer.get() + region_offset
+                                    : outgoing_p2p_buffer.get() + region_offset;
+    /** Completion Queue poll timeout in millisec */
+    const int MAX_POLL_CQ_TIMEOUT = 2000;
+    struct timeval cur_time;
+    gettimeofday(&cur_time, NULL);
+    const unsigned long start_time_msec = (cur_time.tv_sec * 1000) + (cur_time.tv_usec / 1000);
+    const auto tid = std::this_thread::get_id();
+    const uint32_t ce_idx = util::polling_data.get_index(tid);
+    while(true) {
+        if(remote_id != my_node_id) {
+            util::polling_data.set_waiting(tid);
+#ifdef USE_VERBS_API
+            struct verbs_sender_ctxt sctxt;
+#else
+            struct lf_sender_ctxt sctxt;
+#endif
+            sctxt.remote_id = remote_id;
+            sctxt.ce_idx = ce_idx;
+#ifndef USE_VERBS_API
+            sctxt.remote_node_id = remote_id;
+#endif
+            res->post_remote_read_with_completion(&sctxt, region_offset, region_size);
+            // Wait for the read completion, so every byte of the snapshot has
+            // landed before the version words are checked
+            std::optional<std::pair<int32_t, int32_t>> ce;
+            while(!(ce = util::polling_data.get_completion_entry(tid))) {
+                gettimeofday(&cur_time, NULL);
+                const unsigned long cur_time_msec = (cur_time.tv_sec * 1000) + (cur_time.tv_usec / 1000);
+                if((cur_time_msec - start_time_msec) >= MAX_POLL_CQ_TIMEOUT) {
+                    util::polling_data.reset_waiting(tid);
+                    return false;
+                }
+            }
+            util::polling_data.reset_waiting(tid);
+        }
+        const uint64_t head_version = (uint64_t&)region[0];
+        const uint64_t snapshot_size = (uint64_t&)region[sizeof(uint64_t)];
+        if(head_version != 0 && head_version == (uint64_t&)region[tail_offset]
+           && snapshot_size <= request_params.query_snapshot_size) {
+            std::memcpy(data_out, const_cast<char*>(region) + 2 * sizeof(uint64_t), snapshot_size);
+            // The self connection reads the live buffer, so a concurrent
+            // publish could have overwritten the payload mid-copy; re-check
+            // the head version to detect that
+            if((uint64_t&)region[0] == head_version) {
+                size_out = snapshot_size;
+                return true;
+            }
+        }
+        // Nothing published yet (version 0) or a torn read: retry until the
+        // timeout expires
+        gettimeofday(&cur_time, NULL);
+        const unsigned long cur_time_msec = (cur_time.tv_sec * 1000) + (cur_time.tv_usec / 1000);
+        if((cur_time_msec - start_time_msec) >= MAX_POLL_CQ_TIMEOUT) {
+            return false;
+        }
     }
-    outgoing_seq_nums_map[type]++;
 }
 
 P2PConnection::~P2PConnection() {}
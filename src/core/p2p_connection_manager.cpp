@@ -6,10 +6,14 @@
 #include <derecho/conf/conf.hpp>
 #include <derecho/core/detail/p2p_connection_manager.hpp>
 #include <derecho/sst/detail/poll_utils.hpp>
+#include <derecho/utils/logger.hpp>
+#include <derecho/utils/time.h>
 
 namespace sst {
 P2PConnectionManager::P2PConnectionManager(const P2PParams params)
-        : my_node_id(params.my_node_id) {
+        : my_node_id(params.my_node_id),
+          max_external_connections(derecho::getConfUInt32(CONF_DERECHO_MAX_EXTERNAL_CONNECTIONS)),
+          external_idle_timeout_ms(derecho::getConfUInt32(CONF_DERECHO_EXTERNAL_IDLE_TIMEOUT_MS)) {
     
     // HARD-CODED. Adding another request type will break this
 
@@ -19,13 +23,32 @@ P2PConnectionManager::P2PConnectionManager(const P2PParams params)
     request_params.max_msg_sizes[P2P_REPLY] = params.max_p2p_reply_size;
     request_params.max_msg_sizes[P2P_REQUEST] = params.max_p2p_request_size;
     request_params.max_msg_sizes[RPC_REPLY] = params.max_rpc_reply_size;
+    request_params.window_sizes[P2P_LARGE_REQUEST] = 0;
+    request_params.max_msg_sizes[P2P_LARGE_REQUEST] = 0;
+    if(params.small_p2p_request_size > 0
+       && params.small_p2p_request_size < params.max_p2p_request_size) {
+        // Tiered layout: the common request ring only needs small slots, and
+        // the rare oversized requests go through a narrow max-sized lane.
+        // Both sides compute this layout from the same config values, so the
+        // buffers agree without an explicit negotiation round.
+        request_params.max_msg_sizes[P2P_REQUEST] = params.small_p2p_request_size;
+        request_params.window_sizes[P2P_LARGE_REQUEST] = params.large_request_window_size;
+        request_params.max_msg_sizes[P2P_LARGE_REQUEST] = params.max_p2p_request_size;
+    }
 
     p2p_buf_size = 0;
     for(uint8_t i = 0; i < num_request_types; ++i) {
         request_params.offsets[i] = p2p_buf_size;
         p2p_buf_size += request_params.window_sizes[i] * request_params.max_msg_sizes[i];
     }
-    p2p_buf_size += sizeof(bool);
+    // optional query snapshot region: head version, size word, payload, tail version
+    request_params.query_snapshot_offset = p2p_buf_size;
+    request_params.query_snapshot_size = params.query_snapshot_size;
+    if(params.query_snapshot_size > 0) {
+        p2p_buf_size += params.query_snapshot_size + 3 * sizeof(uint64_t);
+    }
+    // doorbell counter plus the heartbeat byte used by check_failures_loop
+    p2p_buf_size += sizeof(uint64_t) + sizeof(bool);
 
     p2p_connections[my_node_id] = std::make_unique<P2PConnection>(my_node_id, my_node_id, p2p_buf_size, request_params);
 
@@ -41,6 +64,12 @@ void P2PConnectionManager::add_connections(const std::vector<uint32_t>& node_ids
     for (const uint32_t remote_id : node_ids) {
 	if (p2p_connections.find(remote_id) == p2p_connections.end()) {
 	    p2p_connections.emplace(remote_id, std::make_unique<P2PConnection>(my_node_id, remote_id, p2p_buf_size, request_params));
+	    // a connection created after a snapshot was published starts with an
+	    // empty snapshot region, so write the current snapshot into it
+	    if(!current_query_snapshot.empty()) {
+	        p2p_connections[remote_id]->publish_query_snapshot(current_query_snapshot.data(),
+	                                                           current_query_snapshot.size());
+	    }
     	}
     }
 }
@@ -49,6 +78,101 @@ void P2PConnectionManager::remove_connections(const std::vector<uint32_t>& node_
     std::lock_guard<std::mutex> lock(connections_mutex);
     for(const uint32_t remote_id : node_ids) {
         p2p_connections.erase(remote_id);
+        on_demand_connections.erase(remote_id);
+        lazy_member_ids.erase(remote_id);
+    }
+}
+
+P2PConnectionManager::OnDemandConnection& P2PConnectionManager::get_or_create_on_demand(uint32_t node_id) {
+    auto search = on_demand_connections.find(node_id);
+    if(search != on_demand_connections.end()) {
+        return search->second;
+    }
+    if(max_external_connections > 0) {
+        // Lazy member connections live in this map but don't count toward the
+        // external-client cap and must never be evicted, so both the count and
+        // the LRU scan consider only non-member entries
+        uint32_t num_external = 0;
+        auto victim = on_demand_connections.end();
+        for(auto entry = on_demand_connections.begin(); entry != on_demand_connections.end(); ++entry) {
+            if(lazy_member_ids.find(entry->first) != lazy_member_ids.end()) {
+                continue;
+            }
+            ++num_external;
+            if(victim == on_demand_connections.end()
+               || entry->second.last_used_ns < victim->second.last_used_ns) {
+                victim = entry;
+            }
+        }
+        if(num_external >= max_external_connections
+           && lazy_member_ids.find(node_id) == lazy_member_ids.end()) {
+            dbg_default_debug("P2P: evicting on-demand connection to node {} to make room for node {}",
+                              victim->first, node_id);
+            on_demand_connections.erase(victim);
+        }
+    }
+    dbg_default_debug("P2P: creating on-demand connection to node {}", node_id);
+    OnDemandConnection& entry = on_demand_connections[node_id];
+    entry.connection = std::make_unique<P2PConnection>(my_node_id, node_id, p2p_buf_size, request_params);
+    entry.last_used_ns = get_time();
+    if(!current_query_snapshot.empty()) {
+        entry.connection->publish_query_snapshot(current_query_snapshot.data(),
+                                                 current_query_snapshot.size());
+    }
+    return entry;
+}
+
+void P2PConnectionManager::add_external_connection(uint32_t node_id) {
+    ensure_connection(node_id);
+}
+
+void P2PConnectionManager::set_lazy_members(const std::vector<uint32_t>& node_ids) {
+    std::lock_guard<std::mutex> lock(connections_mutex);
+    lazy_member_ids.clear();
+    for(const uint32_t remote_id : node_ids) {
+        if(remote_id != my_node_id) {
+            lazy_member_ids.insert(remote_id);
+        }
+    }
+}
+
+void P2PConnectionManager::ensure_connection(uint32_t node_id) {
+    std::lock_guard<std::mutex> lock(connections_mutex);
+    if(p2p_connections.find(node_id) == p2p_connections.end()) {
+        get_or_create_on_demand(node_id);
+    }
+}
+
+bool P2PConnectionManager::contains_node(uint32_t node_id) {
+    if(p2p_connections.find(node_id) != p2p_connections.end()) {
+        return true;
+    }
+    std::lock_guard<std::mutex> lock(connections_mutex);
+    return on_demand_connections.find(node_id) != on_demand_connections.end();
+}
+
+void P2PConnectionManager::sweep_idle_connections() {
+    if(external_idle_timeout_ms == 0) {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(connections_mutex);
+    if(on_demand_connections.empty()) {
+        return;
+    }
+    const uint64_t now_ns = get_time();
+    const uint64_t timeout_ns = uint64_t(external_idle_timeout_ms) * 1000000ull;
+    for(auto entry = on_demand_connections.begin(); entry != on_demand_connections.end();) {
+        if(lazy_member_ids.find(entry->first) != lazy_member_ids.end()) {
+            // a lazily-created member connection stays up for the rest of the
+            // view once the first message has paid for it
+            ++entry;
+        } else if(now_ns - entry->second.last_used_ns >= timeout_ns) {
+            dbg_default_debug("P2P: tearing down on-demand connection to node {} after {}ms idle",
+                              entry->first, external_idle_timeout_ms);
+            entry = on_demand_connections.erase(entry);
+        } else {
+            ++entry;
+        }
     }
 }
 
@@ -64,45 +188,132 @@ uint64_t P2PConnectionManager::get_max_p2p_reply_size() {
 }
 
 void P2PConnectionManager::update_incoming_seq_num() {
-    p2p_connections[last_node_id]->update_incoming_seq_num();
+    auto member_conn = p2p_connections.find(last_node_id);
+    if(member_conn != p2p_connections.end()) {
+        member_conn->second->update_incoming_seq_num();
+        return;
+    }
+    std::lock_guard<std::mutex> lock(connections_mutex);
+    auto search = on_demand_connections.find(last_node_id);
+    if(search != on_demand_connections.end()) {
+        search->second.connection->update_incoming_seq_num();
+    }
 }
 
 // check if there's a new request from any node
 std::optional<std::pair<uint32_t, char*>> P2PConnectionManager::probe_all() {
-    for(const auto& [node_id, p2p_conn] : p2p_connections) {
-        auto buf = p2p_conn->probe();
-        if(buf && buf[0]) {
-            last_node_id = node_id;
-            return std::pair<uint32_t, char*>(node_id, buf);
-        } else if(buf) {
-            // this means that we have a null reply
-            // we don't need to process it, but we still want to increment the seq num
-            p2p_conn->update_incoming_seq_num();
+    /* Priority scan: drain the small lanes of every connection before
+     * touching any bulk lane, so a tiny control RPC is never queued behind an
+     * unrelated large transfer from a connection earlier in the scan order.
+     * The bulk pass runs only when no small-lane message is pending anywhere,
+     * and is skipped entirely when large-request tiering is not configured
+     * (P2P_REQUEST then carries every size and the small pass covers it). */
+    auto probe_lanes = [this](LANE_CLASS lanes) -> std::optional<std::pair<uint32_t, char*>> {
+        for(const auto& [node_id, p2p_conn] : p2p_connections) {
+            // Cheap doorbell check first: idle connections cost one cached read
+            // instead of a seq-num probe per request type
+            if(!p2p_conn->has_incoming_data()) {
+                continue;
+            }
+            auto buf = p2p_conn->probe(lanes);
+            if(buf && buf[0]) {
+                last_node_id = node_id;
+                return std::pair<uint32_t, char*>(node_id, buf);
+            } else if(buf) {
+                // this means that we have a null reply
+                // we don't need to process it, but we still want to increment the seq num
+                p2p_conn->update_incoming_seq_num();
+            }
+        }
+        // then the on-demand (external client) connections, under the mutex
+        // that guards their creation and teardown
+        std::lock_guard<std::mutex> lock(connections_mutex);
+        for(auto& [node_id, entry] : on_demand_connections) {
+            if(!entry.connection->has_incoming_data()) {
+                continue;
+            }
+            auto buf = entry.connection->probe(lanes);
+            if(buf && buf[0]) {
+                entry.last_used_ns = get_time();
+                last_node_id = node_id;
+                return std::pair<uint32_t, char*>(node_id, buf);
+            } else if(buf) {
+                entry.connection->update_incoming_seq_num();
+            }
         }
+        return {};
+    };
+    auto small_message = probe_lanes(SMALL_LANES);
+    if(small_message || request_params.window_sizes[P2P_LARGE_REQUEST] == 0) {
+        return small_message;
     }
-    return {};
+    return probe_lanes(BULK_LANE);
 }
 
-char* P2PConnectionManager::get_sendbuffer_ptr(uint32_t node_id, REQUEST_TYPE type) {
-    return p2p_connections.at(node_id)->get_sendbuffer_ptr(type);
+std::optional<P2PConnection::SendSlot> P2PConnectionManager::reserve_slot(uint32_t node_id, REQUEST_TYPE type, uint64_t msg_size) {
+    auto member_conn = p2p_connections.find(node_id);
+    if(member_conn != p2p_connections.end()) {
+        return member_conn->second->reserve_slot(type, msg_size);
+    }
+    // not a member: an external client's connection, created on first use
+    std::lock_guard<std::mutex> lock(connections_mutex);
+    OnDemandConnection& entry = get_or_create_on_demand(node_id);
+    entry.last_used_ns = get_time();
+    return entry.connection->reserve_slot(type, msg_size);
 }
 
-void P2PConnectionManager::send(uint32_t node_id) {
-    p2p_connections.at(node_id)->send();
+void P2PConnectionManager::post(uint32_t node_id, const P2PConnection::SendSlot& slot) {
+    auto member_conn = p2p_connections.find(node_id);
+    if(member_conn != p2p_connections.end()) {
+        member_conn->second->post(slot);
+    } else {
+        std::lock_guard<std::mutex> lock(connections_mutex);
+        OnDemandConnection& entry = on_demand_connections.at(node_id);
+        entry.last_used_ns = get_time();
+        entry.connection->post(slot);
+    }
     if(node_id != my_node_id) {
         num_rdma_writes++;
     }
 }
 
+void P2PConnectionManager::publish_query_snapshot(const char* data, uint64_t size) {
+    std::lock_guard<std::mutex> lock(connections_mutex);
+    // Each connection has its own remotely-readable buffer, so the snapshot
+    // must be written into every one of them; the cached copy covers
+    // connections that are created later
+    current_query_snapshot.assign(data, data + size);
+    for(const auto& [node_id, p2p_conn] : p2p_connections) {
+        p2p_conn->publish_query_snapshot(data, size);
+    }
+    for(const auto& [node_id, entry] : on_demand_connections) {
+        entry.connection->publish_query_snapshot(data, size);
+    }
+}
+
+bool P2PConnectionManager::fetch_query_snapshot(uint32_t node_id, char* data_out, uint64_t& size_out) {
+    auto member_conn = p2p_connections.find(node_id);
+    if(member_conn != p2p_connections.end()) {
+        return member_conn->second->fetch_query_snapshot(data_out, size_out);
+    }
+    std::lock_guard<std::mutex> lock(connections_mutex);
+    OnDemandConnection& entry = get_or_create_on_demand(node_id);
+    entry.last_used_ns = get_time();
+    return entry.connection->fetch_query_snapshot(data_out, size_out);
+}
+
 void P2PConnectionManager::check_failures_loop() {
     pthread_setname_np(pthread_self(), "p2p_timeout");
 
-    uint32_t heartbeat_ms = derecho::getConfUInt32(CONF_DERECHO_HEARTBEAT_MS);
+    uint32_t heartbeat_ms = derecho::getConfSnapshot().heartbeat_ms;
     const auto tid = std::this_thread::get_id();
     // get id first
     uint32_t ce_idx = util::polling_data.get_index(tid);
     while(!thread_shutdown) {
         std::this_thread::sleep_for(std::chrono::milliseconds(heartbeat_ms));
+        // before the write-count check: idle teardown must run even (indeed,
+        // especially) when no traffic is flowing
+        sweep_idle_connections();
         if(num_rdma_writes < 1000) {
             continue;
         }
@@ -121,6 +332,9 @@ void P2PConnectionManager::check_failures_loop() {
             }
             sctxt[node_id].remote_id = node_id;
             sctxt[node_id].ce_idx = ce_idx;
+#ifndef USE_VERBS_API
+            sctxt[node_id].remote_node_id = node_id;
+#endif
 
             p2p_conn->get_res()->post_remote_write_with_completion(&sctxt[node_id], p2p_buf_size - sizeof(bool), sizeof(bool));
         } 
@@ -5,6 +5,11 @@
  */
 #include "derecho/core/detail/persistence_manager.hpp"
 
+#include <derecho/conf/conf.hpp>
+#include <derecho/utils/timeline.hpp>
+#include <derecho/utils/perf_events.hpp>
+#include <derecho/utils/phase_occupancy.hpp>
+
 namespace derecho {
 
 /** Constructor
@@ -15,11 +20,17 @@ PersistenceManager::PersistenceManager(
         const persistence_callback_t& _persistence_callback)
         : thread_shutdown(false),
           persistence_callback(_persistence_callback),
-          objects_by_subgroup_id(objects_map) {
+          objects_by_subgroup_id(objects_map),
+          parallel_persistence(getConfBoolean(CONF_PERS_PARALLEL_PERSISTENCE)),
+          compaction_interval_ms(getConfUInt32(CONF_PERS_COMPACTION_INTERVAL_MS)),
+          compaction_throttle_ms(getConfUInt32(CONF_PERS_COMPACTION_THROTTLE_MS)) {
     // initialize semaphore
     if(sem_init(&persistence_request_sem, 1, 0) != 0) {
         throw derecho_exception("Cannot initialize persistent_request_sem:errno=" + std::to_string(errno));
     }
+    if(sem_init(&callback_request_sem, 1, 0) != 0) {
+        throw derecho_exception("Cannot initialize callback_request_sem:errno=" + std::to_string(errno));
+    }
 }
 
 
@@ -27,22 +38,164 @@ PersistenceManager::PersistenceManager(
  */
 PersistenceManager::~PersistenceManager() {
     sem_destroy(&persistence_request_sem);
+    sem_destroy(&callback_request_sem);
 }
 
 void PersistenceManager::set_view_manager(ViewManager& view_manager) {
     this->view_manager = &view_manager;
 }
 
+/** Persist one request and publish the result; shared by both thread modes. */
+void PersistenceManager::handle_persist_request(const subgroup_id_t& subgroup_id,
+                                                const persistent::version_t& version) {
+    // persist
+    try {
+        auto search = objects_by_subgroup_id.find(subgroup_id);
+        if(search != objects_by_subgroup_id.end()) {
+            PerfEventCounters::Scope perf_scope(PerfEventCounters::PERSIST);
+            search->second.get().persist(version);
+        }
+        // this version (and any coalesced behind it) is now on stable storage
+        MessageTimeline::record(subgroup_id, version & 0xffffffff, MessageTimeline::PERSIST_COMPLETE);
+        // read lock the view
+        std::shared_lock<EpochSharedMutex> read_lock(view_manager->view_mutex);
+        // update the persisted_num in SST
+
+        View& Vc = *view_manager->curr_view;
+        Vc.gmsSST->persisted_num[Vc.gmsSST->get_local_index()][subgroup_id] = version;
+        Vc.gmsSST->increment_perf_counter(PerfCounter::VERSIONS_PERSISTED);
+        Vc.gmsSST->put(Vc.multicast_group->get_shard_sst_indices(subgroup_id),
+                       (char*)std::addressof(Vc.gmsSST->persisted_num[0][subgroup_id]) - Vc.gmsSST->getBaseAddress(),
+                       sizeof(long long int));
+    } catch(uint64_t exp) {
+        dbg_default_debug("exception on persist():subgroup={},ver={},exp={}.", subgroup_id, version, exp);
+        std::cout << "exception on persistent:subgroup=" << subgroup_id << ",ver=" << version << "exception=0x" << std::hex << exp << std::endl;
+    }
+
+    // hand the callback to the delivery thread, so this thread can start the
+    // next version's disk write without waiting on user code
+    if(this->persistence_callback != nullptr) {
+        while(cbq_lock.test_and_set(std::memory_order_acquire))  // acquire lock
+            ;                                                    // spin
+        callback_request_queue.push(std::make_tuple(subgroup_id, version));
+        cbq_lock.clear(std::memory_order_release);  // release lock
+        sem_post(&callback_request_sem);
+    }
+}
+
+/** One compaction pass over all persistent subgroups. */
+void PersistenceManager::run_compaction_pass() {
+    for(auto& id_and_object : objects_by_subgroup_id) {
+        if(thread_shutdown) {
+            return;
+        }
+        const subgroup_id_t subgroup_id = id_and_object.first;
+        ReplicatedObject& object = id_and_object.second.get();
+        if(!object.is_persistent()) {
+            continue;
+        }
+        try {
+            // compact towards the persistence frontier: anything below it is
+            // already on stable storage everywhere in this shard
+            const persistent::version_t frontier = object.get_minimum_latest_persisted_version();
+            if(frontier == persistent::INVALID_VERSION) {
+                continue;
+            }
+            auto last = last_compacted_version.find(subgroup_id);
+            if(last != last_compacted_version.end() && last->second == frontier) {
+                // no version persisted since the last pass, nothing to trim
+                continue;
+            }
+            const persistent::version_t floor = object.trim_to_safe_point(frontier);
+            dbg_default_debug("compacted subgroup {} to version {} (frontier {}).",
+                              subgroup_id, floor, frontier);
+            last_compacted_version[subgroup_id] = frontier;
+        } catch(uint64_t exp) {
+            dbg_default_debug("exception on trim_to_safe_point():subgroup={},exp={}.", subgroup_id, exp);
+        }
+        // pace the trim I/O so foreground persist() keeps the disk
+        if(compaction_throttle_ms > 0) {
+            std::unique_lock<std::mutex> lock(compaction_mutex);
+            compaction_cv.wait_for(lock, std::chrono::milliseconds(compaction_throttle_ms),
+                                   [this]() { return thread_shutdown.load(); });
+        }
+    }
+}
+
 /** Start the persistent thread. */
 void PersistenceManager::start() {
     //skip for raw subgroups -- NO, DON'T
     // if(replicated_objects == nullptr) return;
 
+    if(compaction_interval_ms > 0) {
+        this->compaction_thread = std::thread{[this]() {
+            pthread_setname_np(pthread_self(), "compaction");
+            std::unique_lock<std::mutex> lock(compaction_mutex);
+            while(!compaction_cv.wait_for(lock, std::chrono::milliseconds(compaction_interval_ms),
+                                          [this]() { return thread_shutdown.load(); })) {
+                lock.unlock();
+                run_compaction_pass();
+                lock.lock();
+            }
+        }};
+    }
+
+    // the callback-delivery thread serves both persistence modes; it only
+    // exists when there is a callback to deliver
+    if(persistence_callback != nullptr) {
+        this->callback_thread = std::thread{[this]() {
+            pthread_setname_np(pthread_self(), "persistcb");
+            do {
+                // wait for semaphore
+                sem_wait(&callback_request_sem);
+                while(cbq_lock.test_and_set(std::memory_order_acquire))  // acquire lock
+                    ;                                                    // spin
+                if(this->callback_request_queue.empty()) {
+                    cbq_lock.clear(std::memory_order_release);  // release lock
+                    if(this->thread_shutdown) {
+                        break;
+                    }
+                    continue;
+                }
+
+                subgroup_id_t subgroup_id = std::get<0>(callback_request_queue.front());
+                persistent::version_t version = std::get<1>(callback_request_queue.front());
+                callback_request_queue.pop();
+                cbq_lock.clear(std::memory_order_release);  // release lock
+
+                // no coalescing here: every persisted result gets its
+                // callback, in the order the persist threads produced them
+                this->persistence_callback(subgroup_id, version);
+
+                if(this->thread_shutdown) {
+                    while(cbq_lock.test_and_set(std::memory_order_acquire))  // acquire lock
+                        ;                                                    // spin
+                    if(callback_request_queue.empty()) {
+                        cbq_lock.clear(std::memory_order_release);  // release lock
+                        break;                                      // finish
+                    }
+                    cbq_lock.clear(std::memory_order_release);  // release lock
+                }
+            } while(true);
+        }};
+    }
+
+    // in parallel mode the per-subgroup workers are started lazily by
+    // post_persist_request, so there is no single persist thread to launch
+    if(parallel_persistence) {
+        return;
+    }
+
     this->persist_thread = std::thread{[this]() {
         pthread_setname_np(pthread_self(), "persist");
+        // occupancy accounting: waiting on the request semaphore is IDLE,
+        // draining the queue EVALUATING, and persisting WORKING
+        PhaseOccupancy::ThreadSlot& occupancy = PhaseOccupancy::registerThread("persist");
         do {
             // wait for semaphore
+            occupancy.enter(PhaseOccupancy::IDLE);
             sem_wait(&persistence_request_sem);
+            occupancy.enter(PhaseOccupancy::EVALUATING);
             while(prq_lock.test_and_set(std::memory_order_acquire))  // acquire lock
                 ;                                                    // spin
             if(this->persistence_request_queue.empty()) {
@@ -56,32 +209,19 @@ void PersistenceManager::start() {
             subgroup_id_t subgroup_id = std::get<0>(persistence_request_queue.front());
             persistent::version_t version = std::get<1>(persistence_request_queue.front());
             persistence_request_queue.pop();
-            prq_lock.clear(std::memory_order_release);  // release lock
-
-            // persist
-            try {
-                auto search = objects_by_subgroup_id.find(subgroup_id);
-                if(search != objects_by_subgroup_id.end()) {
-                    search->second.get().persist(version);
-                }
-                // read lock the view
-                std::shared_lock<std::shared_timed_mutex> read_lock(view_manager->view_mutex);
-                // update the persisted_num in SST
-
-                View& Vc = *view_manager->curr_view;
-                Vc.gmsSST->persisted_num[Vc.gmsSST->get_local_index()][subgroup_id] = version;
-                Vc.gmsSST->put(Vc.multicast_group->get_shard_sst_indices(subgroup_id),
-                               (char*)std::addressof(Vc.gmsSST->persisted_num[0][subgroup_id]) - Vc.gmsSST->getBaseAddress(),
-                               sizeof(long long int));
-            } catch(uint64_t exp) {
-                dbg_default_debug("exception on persist():subgroup={},ver={},exp={}.", subgroup_id, version, exp);
-                std::cout << "exception on persistent:subgroup=" << subgroup_id << ",ver=" << version << "exception=0x" << std::hex << exp << std::endl;
+            // group commit: coalesce the run of requests queued behind this
+            // one for the same subgroup; a single persist() through the
+            // highest version covers all of them with one log flush, since
+            // versions are posted in increasing order
+            while(!persistence_request_queue.empty()
+                  && std::get<0>(persistence_request_queue.front()) == subgroup_id) {
+                version = std::get<1>(persistence_request_queue.front());
+                persistence_request_queue.pop();
             }
+            prq_lock.clear(std::memory_order_release);  // release lock
 
-            // callback
-            if(this->persistence_callback != nullptr) {
-                this->persistence_callback(subgroup_id, version);
-            }
+            occupancy.enter(PhaseOccupancy::WORKING);
+            handle_persist_request(subgroup_id, version);
 
             if(this->thread_shutdown) {
                 while(prq_lock.test_and_set(std::memory_order_acquire))  // acquire lock
@@ -96,8 +236,77 @@ void PersistenceManager::start() {
     }};
 }
 
+/** Launch the worker thread for one subgroup's queue (parallel mode only). */
+void PersistenceManager::start_worker(const subgroup_id_t& subgroup_id, SubgroupWorker& worker) {
+    worker.worker_thread = std::thread{[this, subgroup_id, &worker]() {
+        pthread_setname_np(pthread_self(), ("persist" + std::to_string(subgroup_id)).c_str());
+        // same phase accounting as the single persist thread, one slot per worker
+        PhaseOccupancy::ThreadSlot& occupancy = PhaseOccupancy::registerThread(
+                "persist" + std::to_string(subgroup_id));
+        do {
+            // wait for semaphore
+            occupancy.enter(PhaseOccupancy::IDLE);
+            sem_wait(&worker.request_sem);
+            occupancy.enter(PhaseOccupancy::EVALUATING);
+            while(worker.queue_lock.test_and_set(std::memory_order_acquire))  // acquire lock
+                ;                                                             // spin
+            if(worker.request_queue.empty()) {
+                worker.queue_lock.clear(std::memory_order_release);  // release lock
+                if(this->thread_shutdown) {
+                    break;
+                }
+                continue;
+            }
+
+            persistent::version_t version = worker.request_queue.front();
+            worker.request_queue.pop();
+            // group commit: this queue holds only this subgroup's versions,
+            // in increasing order, so drain it and persist once through the
+            // highest version queued so far
+            while(!worker.request_queue.empty()) {
+                version = worker.request_queue.front();
+                worker.request_queue.pop();
+            }
+            worker.queue_lock.clear(std::memory_order_release);  // release lock
+
+            occupancy.enter(PhaseOccupancy::WORKING);
+            handle_persist_request(subgroup_id, version);
+
+            if(this->thread_shutdown) {
+                while(worker.queue_lock.test_and_set(std::memory_order_acquire))  // acquire lock
+                    ;                                                             // spin
+                if(worker.request_queue.empty()) {
+                    worker.queue_lock.clear(std::memory_order_release);  // release lock
+                    break;                                               // finish
+                }
+                worker.queue_lock.clear(std::memory_order_release);  // release lock
+            }
+        } while(true);
+    }};
+}
+
 /** post a persistence request */
 void PersistenceManager::post_persist_request(const subgroup_id_t& subgroup_id, const persistent::version_t& version) {
+    // the low 32 bits of the version are the message's sequence number
+    MessageTimeline::record(subgroup_id, version & 0xffffffff, MessageTimeline::PERSIST_REQUEST);
+    if(parallel_persistence) {
+        SubgroupWorker* worker;
+        {
+            std::lock_guard<std::mutex> map_lock(workers_map_mutex);
+            auto search = subgroup_workers.find(subgroup_id);
+            if(search == subgroup_workers.end()) {
+                search = subgroup_workers.emplace(subgroup_id, std::make_unique<SubgroupWorker>()).first;
+                start_worker(subgroup_id, *search->second);
+            }
+            worker = search->second.get();
+        }
+        while(worker->queue_lock.test_and_set(std::memory_order_acquire))  // acquire lock
+            ;                                                              // spin
+        worker->request_queue.push(version);
+        worker->queue_lock.clear(std::memory_order_release);  // release lock
+        sem_post(&worker->request_sem);
+        return;
+    }
     // request enqueue
     while(prq_lock.test_and_set(std::memory_order_acquire))  // acquire lock
         ;                                                    // spin
@@ -124,9 +333,36 @@ void PersistenceManager::shutdown(bool wait) {
 
     thread_shutdown = true;
     sem_post(&persistence_request_sem);  // kick the persistence thread in case it is sleeping
+    sem_post(&callback_request_sem);     // likewise the callback-delivery thread
+    compaction_cv.notify_all();          // wake the compaction thread from its inter-pass sleep
+    {
+        std::lock_guard<std::mutex> map_lock(workers_map_mutex);
+        for(auto& id_and_worker : subgroup_workers) {
+            sem_post(&id_and_worker.second->request_sem);
+        }
+    }
 
     if(wait) {
-        this->persist_thread.join();
+        if(this->persist_thread.joinable()) {
+            this->persist_thread.join();
+        }
+        if(this->compaction_thread.joinable()) {
+            this->compaction_thread.join();
+        }
+        {
+            std::lock_guard<std::mutex> map_lock(workers_map_mutex);
+            for(auto& id_and_worker : subgroup_workers) {
+                if(id_and_worker.second->worker_thread.joinable()) {
+                    id_and_worker.second->worker_thread.join();
+                }
+            }
+        }
+        // join the callback thread last, after the persist threads have
+        // stopped producing results, so queued callbacks still get delivered
+        if(this->callback_thread.joinable()) {
+            sem_post(&callback_request_sem);  // kick it in case it is sleeping
+            this->callback_thread.join();
+        }
     }
 }
 
@@ -1,4 +1,6 @@
+#include <list>
 #include <optional>
+#include <thread>
 
 #include <derecho/core/detail/container_template_functions.hpp>
 #include <derecho/core/detail/restart_state.hpp>
@@ -106,7 +108,9 @@ RestartLeaderState::RestartLeaderState(std::unique_ptr<View> _curr_view, Restart
 
 void RestartLeaderState::await_quorum(tcp::connection_listener& server_socket) {
     bool ready_to_restart = false;
+    bool all_members_rejoined = false;
     int time_remaining_ms = RESTART_LEADER_TIMEOUT;
+    std::list<std::thread> log_receiver_threads;
     while(time_remaining_ms > 0) {
         using namespace std::chrono;
         auto start_time = high_resolution_clock::now();
@@ -125,37 +129,63 @@ void RestartLeaderState::await_quorum(tcp::connection_listener& server_socket) {
             client_socket->read(joiner_id);
             client_socket->write(JoinResponse{JoinResponseCode::TOTAL_RESTART, my_id});
             dbg_default_debug("Node {} rejoined", joiner_id);
-            rejoined_node_ids.emplace(joiner_id);
 
-            //Receive and process the joining node's logs of the last known View and RaggedTrim
-            receive_joiner_logs(joiner_id, *client_socket);
-
-            //Receive the joining node's ports - this is part of the standard join logic
-            uint16_t joiner_gms_port = 0;
-            client_socket->read(joiner_gms_port);
-            uint16_t joiner_rpc_port = 0;
-            client_socket->read(joiner_rpc_port);
-            uint16_t joiner_sst_port = 0;
-            client_socket->read(joiner_sst_port);
-            uint16_t joiner_rdmc_port = 0;
-            client_socket->read(joiner_rdmc_port);
-            const ip_addr_t& joiner_ip = client_socket->get_remote_ip();
-            rejoined_node_ips_and_ports[joiner_id] = {joiner_ip, joiner_gms_port,
-                                                      joiner_rpc_port, joiner_sst_port, joiner_rdmc_port};
-            //Done receiving from this socket (for now), so store it in waiting_join_sockets for later
-            waiting_join_sockets.emplace(joiner_id, std::move(*client_socket));
-            //Check for quorum
+            /* Receive the joining node's logs and ports on a separate thread,
+             * so the accept loop can keep accepting and many rejoining nodes
+             * can send their logs concurrently */
+            log_receiver_threads.emplace_back(&RestartLeaderState::receive_joiner_data, this,
+                                              joiner_id, std::move(*client_socket));
+        }
+        {
+            /* Check for quorum; the lock keeps in-flight log receipts from
+             * mutating the restart state while the view is recomputed */
+            std::lock_guard<std::mutex> lock(joiner_data_mutex);
             ready_to_restart = has_restart_quorum();
             //If all the members have rejoined, no need to keep waiting
-            if(std::includes(rejoined_node_ids.begin(), rejoined_node_ids.end(),
-                             last_known_view_members.begin(), last_known_view_members.end())) {
-                return;
-            }
-        } else if(!ready_to_restart) {
+            all_members_rejoined = std::includes(rejoined_node_ids.begin(), rejoined_node_ids.end(),
+                                                 last_known_view_members.begin(), last_known_view_members.end());
+        }
+        if(all_members_rejoined) {
+            break;
+        }
+        if(!client_socket && !ready_to_restart) {
             //Accept timed out, but we haven't heard from enough nodes yet, so reset the timer
             time_remaining_ms = RESTART_LEADER_TIMEOUT;
         }
     }
+    //Wait for any still-running log receipts, so the rest of the restart
+    //protocol sees a stable set of rejoined nodes without needing the lock
+    for(std::thread& receiver_thread : log_receiver_threads) {
+        receiver_thread.join();
+    }
+    /* A log receipt may have finished after the last quorum check, so
+     * recompute the restart view once more to ensure it covers every node
+     * that will be sent the view (i.e. everything in waiting_join_sockets) */
+    has_restart_quorum();
+}
+
+void RestartLeaderState::receive_joiner_data(node_id_t joiner_id, tcp::socket client_socket) {
+    //Receive and process the joining node's logs of the last known View and RaggedTrim
+    receive_joiner_logs(joiner_id, client_socket);
+
+    //Receive the joining node's ports - this is part of the standard join logic
+    uint16_t joiner_gms_port = 0;
+    client_socket.read(joiner_gms_port);
+    uint16_t joiner_rpc_port = 0;
+    client_socket.read(joiner_rpc_port);
+    uint16_t joiner_sst_port = 0;
+    client_socket.read(joiner_sst_port);
+    uint16_t joiner_rdmc_port = 0;
+    client_socket.read(joiner_rdmc_port);
+    const ip_addr_t& joiner_ip = client_socket.get_remote_ip();
+
+    //Publish the node under the lock, so quorum checks only see fully-received joiners
+    std::lock_guard<std::mutex> lock(joiner_data_mutex);
+    rejoined_node_ids.emplace(joiner_id);
+    rejoined_node_ips_and_ports[joiner_id] = {joiner_ip, joiner_gms_port,
+                                              joiner_rpc_port, joiner_sst_port, joiner_rdmc_port};
+    //Done receiving from this socket (for now), so store it in waiting_join_sockets for later
+    waiting_join_sockets.emplace(joiner_id, std::move(client_socket));
 }
 
 bool RestartLeaderState::has_restart_quorum() {
@@ -182,6 +212,22 @@ void RestartLeaderState::receive_joiner_logs(const node_id_t& joiner_id, tcp::so
     client_socket.read(view_buffer, size_of_view);
     std::unique_ptr<View> client_view = mutils::from_bytes<View>(nullptr, view_buffer);
 
+    /* Read all of the joining node's RaggedTrims off the socket before
+     * touching any shared state, so that this node's merge (and other
+     * joiners' network transfers) can proceed in parallel */
+    std::size_t num_of_ragged_trims;
+    client_socket.read(num_of_ragged_trims);
+    std::vector<std::unique_ptr<RaggedTrim>> client_ragged_trims(num_of_ragged_trims);
+    for(std::size_t i = 0; i < num_of_ragged_trims; ++i) {
+        std::size_t size_of_ragged_trim;
+        client_socket.read(size_of_ragged_trim);
+        char buffer[size_of_ragged_trim];
+        client_socket.read(buffer, size_of_ragged_trim);
+        client_ragged_trims[i] = mutils::from_bytes<RaggedTrim>(nullptr, buffer);
+    }
+
+    //Merge into the shared longest-log state, which other receiver threads also update
+    std::lock_guard<std::mutex> lock(joiner_data_mutex);
     if(client_view->vid > curr_view->vid) {
         dbg_default_trace("Node {} had newer view {}, replacing view {} and discarding ragged trim",
                           joiner_id, client_view->vid, curr_view->vid);
@@ -197,15 +243,8 @@ void RestartLeaderState::receive_joiner_logs(const node_id_t& joiner_id, tcp::so
             }
         }
     }
-    //Receive the joining node's RaggedTrims
-    std::size_t num_of_ragged_trims;
-    client_socket.read(num_of_ragged_trims);
-    for(std::size_t i = 0; i < num_of_ragged_trims; ++i) {
-        std::size_t size_of_ragged_trim;
-        client_socket.read(size_of_ragged_trim);
-        char buffer[size_of_ragged_trim];
-        client_socket.read(buffer, size_of_ragged_trim);
-        std::unique_ptr<RaggedTrim> ragged_trim = mutils::from_bytes<RaggedTrim>(nullptr, buffer);
+    //Process the joining node's RaggedTrims
+    for(std::unique_ptr<RaggedTrim>& ragged_trim : client_ragged_trims) {
         dbg_default_trace("Received ragged trim for subgroup {}, shard {} from node {}",
                           ragged_trim->subgroup_id, ragged_trim->shard_num, joiner_id);
         /* If the joining node has an obsolete View, we only care about the
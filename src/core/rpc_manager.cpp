@@ -4,10 +4,20 @@
  * @date Feb 7, 2017
  */
 
+#include <algorithm>
 #include <cassert>
+#include <cstring>
 #include <iostream>
 
+#include <derecho/core/detail/external_client_protocol.hpp>
 #include <derecho/core/detail/rpc_manager.hpp>
+#include <derecho/tcp/tcp.hpp>
+#include <derecho/utils/phase_occupancy.hpp>
+#ifdef USE_VERBS_API
+#include <derecho/sst/detail/verbs.hpp>
+#else
+#include <derecho/sst/detail/lf.hpp>
+#endif
 
 namespace derecho {
 
@@ -15,21 +25,44 @@ namespace rpc {
 
 thread_local bool _in_rpc_handler = false;
 
+/** The RPCManager whose connections help_p2p_receive() polls; registered for
+ * the manager's lifetime. With multiple groups in one process the first one
+ * wins, which merely makes helping ineffective for the others' callers, not
+ * unsafe: draining any manager's messages is always valid. */
+static std::atomic<RPCManager*> helping_rpc_manager{nullptr};
+
 RPCManager::~RPCManager() {
+    RPCManager* this_manager = this;
+    helping_rpc_manager.compare_exchange_strong(this_manager, nullptr);
     thread_shutdown = true;
     if(rpc_thread.joinable()) {
         rpc_thread.join();
     }
+    if(deadline_thread.joinable()) {
+        deadline_thread.join();
+    }
+    if(external_client_thread.joinable()) {
+        external_client_thread.join();
+    }
 }
 
 void RPCManager::create_connections() {
+    const ConfSnapshot& conf = getConfSnapshot();
     connections = std::make_unique<sst::P2PConnectionManager>(sst::P2PParams{
             nid,
-	    getConfUInt32(CONF_DERECHO_P2P_WINDOW_SIZE),
+            conf.p2p_window_size,
             view_manager.view_max_rpc_window_size,
-	    getConfUInt64(CONF_DERECHO_MAX_P2P_REPLY_PAYLOAD_SIZE) + sizeof(header),
-	    getConfUInt64(CONF_DERECHO_MAX_P2P_REQUEST_PAYLOAD_SIZE) + sizeof(header),
-            view_manager.view_max_rpc_reply_payload_size + sizeof(header)});
+            conf.max_p2p_reply_payload_size + sizeof(header),
+            conf.max_p2p_request_payload_size + sizeof(header),
+            view_manager.view_max_rpc_reply_payload_size + sizeof(header),
+            conf.p2p_small_request_payload_size > 0
+                    ? conf.p2p_small_request_payload_size + sizeof(header)
+                    : 0,
+            conf.p2p_large_window_size,
+            getConfUInt64(CONF_DERECHO_QUERY_SNAPSHOT_SIZE)});
+    //Now that connections exist, reply waiters may help poll them
+    RPCManager* expected_registration = nullptr;
+    helping_rpc_manager.compare_exchange_strong(expected_registration, this);
 }
 
 void RPCManager::destroy_remote_invocable_class(uint32_t instance_id) {
@@ -42,6 +75,50 @@ void RPCManager::destroy_remote_invocable_class(uint32_t instance_id) {
             receivers_iterator++;
         }
     }
+    rebuild_dispatch_table();
+    //Also forget which of its functions were order-insensitive
+    for(auto opcode_iterator = order_insensitive_opcodes.begin();
+        opcode_iterator != order_insensitive_opcodes.end();) {
+        if(opcode_iterator->first == instance_id) {
+            opcode_iterator = order_insensitive_opcodes.erase(opcode_iterator);
+        } else {
+            opcode_iterator++;
+        }
+    }
+    //...and delete its reply combiners and any half-finished reductions
+    for(auto combiner_iterator = reply_combiners.begin();
+        combiner_iterator != reply_combiners.end();) {
+        if(combiner_iterator->first.subgroup_id == instance_id) {
+            combiner_iterator = reply_combiners.erase(combiner_iterator);
+        } else {
+            combiner_iterator++;
+        }
+    }
+    {
+        std::lock_guard<std::mutex> reductions_lock(reductions_mutex);
+        for(auto reduction_iterator = pending_reductions.begin();
+            reduction_iterator != pending_reductions.end();) {
+            if(std::get<0>(reduction_iterator->first).subgroup_id == instance_id) {
+                reduction_iterator = pending_reductions.erase(reduction_iterator);
+            } else {
+                reduction_iterator++;
+            }
+        }
+    }
+    //Drop scheduled deadlines for this class's calls before their
+    //PendingResults are destroyed along with wrapped_this
+    {
+        std::lock_guard<std::mutex> wheel_lock(deadline_wheel_mutex);
+        for(auto& bucket : deadline_wheel) {
+            for(auto entry_iterator = bucket.begin(); entry_iterator != bucket.end();) {
+                if(entry_iterator->subgroup_id == instance_id) {
+                    entry_iterator = bucket.erase(entry_iterator);
+                } else {
+                    entry_iterator++;
+                }
+            }
+        }
+    }
     //Deliver a node_removed_from_shard_exception to the QueryResults for this class
     //Important: This only works because the Replicated destructor runs before the
     //wrapped_this member is destroyed; otherwise the PendingResults we're referencing
@@ -57,10 +134,137 @@ void RPCManager::destroy_remote_invocable_class(uint32_t instance_id) {
     }
 }
 
+void RPCManager::rebuild_dispatch_table() {
+    dispatch_by_subgroup.clear();
+    std::vector<std::size_t> function_counts;
+    for(const auto& opcode_and_receiver : *receivers) {
+        const subgroup_id_t subgroup_id = opcode_and_receiver.first.subgroup_id;
+        if(subgroup_id >= function_counts.size()) {
+            function_counts.resize(subgroup_id + 1, 0);
+        }
+        ++function_counts[subgroup_id];
+    }
+    dispatch_by_subgroup.resize(function_counts.size());
+    for(std::size_t subgroup_id = 0; subgroup_id < function_counts.size(); ++subgroup_id) {
+        if(function_counts[subgroup_id] == 0) {
+            continue;
+        }
+        //Size each table to the next power of two above twice the function
+        //count, so open addressing rarely needs a second probe
+        std::size_t table_size = 4;
+        while(table_size < 2 * function_counts[subgroup_id]) {
+            table_size <<= 1;
+        }
+        dispatch_by_subgroup[subgroup_id].entries.resize(table_size);
+    }
+    for(const auto& opcode_and_receiver : *receivers) {
+        const Opcode& opcode = opcode_and_receiver.first;
+        auto& entries = dispatch_by_subgroup[opcode.subgroup_id].entries;
+        const std::size_t mask = entries.size() - 1;
+        std::size_t slot = SubgroupDispatchTable::slot_hash(opcode.function_id, opcode.is_reply) & mask;
+        while(entries[slot].receiver != nullptr) {
+            slot = (slot + 1) & mask;
+        }
+        entries[slot] = {opcode.function_id, opcode.is_reply, &opcode_and_receiver.second};
+    }
+}
+
 void RPCManager::start_listening() {
     std::lock_guard<std::mutex> lock(thread_start_mutex);
     thread_start = true;
     thread_start_cv.notify_all();
+    //Only nodes configured with an external port serve external clients
+    if(getConfUInt16(CONF_DERECHO_EXTERNAL_PORT) != 0) {
+        external_client_thread = std::thread(&RPCManager::external_client_loop, this);
+    }
+}
+
+void RPCManager::external_client_loop() {
+    pthread_setname_np(pthread_self(), "external_lstnr");
+    using namespace remote_invocation_utilities;
+    const uint16_t external_port = getConfUInt16(CONF_DERECHO_EXTERNAL_PORT);
+    std::unique_ptr<tcp::connection_listener> client_listener;
+    try {
+        client_listener = std::make_unique<tcp::connection_listener>(external_port);
+    } catch(tcp::exception&) {
+        dbg_default_error("Could not listen on external_port {}; external clients will not be served", external_port);
+        return;
+    }
+    dbg_default_debug("External-client listener started on port {}", external_port);
+    while(!thread_shutdown) {
+        std::optional<tcp::socket> client_socket;
+        try {
+            client_socket = client_listener->try_accept(1000);
+        } catch(tcp::exception&) {
+            continue;
+        }
+        if(!client_socket) {
+            continue;
+        }
+        //Handshake step 1: the client introduces itself. See
+        //external_client_protocol.hpp for the message sequence.
+        ExternalClientHello hello;
+        std::size_t client_ip_size;
+        if(!client_socket->read(hello) || !client_socket->read(client_ip_size)) {
+            continue;
+        }
+        std::string client_ip(client_ip_size, '\0');
+        if(!client_socket->read(&client_ip[0], client_ip_size)) {
+            continue;
+        }
+        //Handshake step 2: reply with this node's identity, the p2p buffer
+        //layout (the same P2PParams create_connections used), and the
+        //subgroup layout of the current view
+        const ConfSnapshot& conf = getConfSnapshot();
+        ExternalServerGreeting greeting;
+        greeting.server_id = nid;
+        greeting.sst_port = getConfUInt16(CONF_DERECHO_SST_PORT);
+        greeting.p2p_window_size = conf.p2p_window_size;
+        greeting.rpc_window_size = view_manager.view_max_rpc_window_size;
+        greeting.max_p2p_reply_size = conf.max_p2p_reply_payload_size + sizeof(header);
+        greeting.max_p2p_request_size = conf.max_p2p_request_payload_size + sizeof(header);
+        greeting.max_rpc_reply_size = view_manager.view_max_rpc_reply_payload_size + sizeof(header);
+        greeting.small_p2p_request_size = conf.p2p_small_request_payload_size > 0
+                                                  ? conf.p2p_small_request_payload_size + sizeof(header)
+                                                  : 0;
+        greeting.large_request_window_size = conf.p2p_large_window_size;
+        greeting.query_snapshot_size = getConfUInt64(CONF_DERECHO_QUERY_SNAPSHOT_SIZE);
+        std::map<subgroup_type_id_t, std::vector<subgroup_id_t>> subgroup_ids_by_type_id;
+        {
+            auto locked_view = view_manager.get_current_view();
+            subgroup_ids_by_type_id = locked_view.get().subgroup_ids_by_type_id;
+        }
+        greeting.num_subgroup_types = subgroup_ids_by_type_id.size();
+        client_socket->write(greeting);
+        const std::string my_ip = getConfString(CONF_DERECHO_LOCAL_IP);
+        std::size_t my_ip_size = my_ip.size();
+        client_socket->write(my_ip_size);
+        client_socket->write(my_ip.c_str(), my_ip_size);
+        for(const auto& type_and_ids : subgroup_ids_by_type_id) {
+            client_socket->write(type_and_ids.first);
+            client_socket->write(static_cast<uint32_t>(type_and_ids.second.size()));
+            for(const subgroup_id_t subgroup_id : type_and_ids.second) {
+                client_socket->write(subgroup_id);
+            }
+        }
+        //Handshake step 3: wait until the client's SST-level listener is up,
+        //since add_node on the lower-ID side connects with no retry
+        node_id_t ready_ack;
+        if(!client_socket->read(ready_ack) || ready_ack != hello.client_id) {
+            dbg_default_warn("External-client handshake from {} aborted before the ready ack", client_ip);
+            continue;
+        }
+        //Handshake step 4: open the SST-level connection and build this side
+        //of the P2PConnection, which blocks in the memory-region exchange
+        //while the client constructs its side
+        if(!sst::add_node(hello.client_id, {client_ip, hello.sst_port})) {
+            dbg_default_warn("Failed to open the SST-level connection to external client {} at {}",
+                             hello.client_id, client_ip);
+            continue;
+        }
+        connections->add_external_connection(hello.client_id);
+        dbg_default_info("External client {} connected from {}", hello.client_id, client_ip);
+    }
 }
 
 std::exception_ptr RPCManager::receive_message(
@@ -68,15 +272,18 @@ std::exception_ptr RPCManager::receive_message(
         std::size_t payload_size, const std::function<char*(int)>& out_alloc) {
     using namespace remote_invocation_utilities;
     assert(payload_size);
-    auto receiver_function_entry = receivers->find(indx);
-    if(receiver_function_entry == receivers->end()) {
+    const receive_fun_t* receiver_function
+            = indx.subgroup_id < dispatch_by_subgroup.size()
+                      ? dispatch_by_subgroup[indx.subgroup_id].lookup(indx.function_id, indx.is_reply)
+                      : nullptr;
+    if(receiver_function == nullptr) {
         dbg_default_error("Received an RPC message with an invalid RPC opcode! Opcode was ({}, {}, {}, {}).",
                           indx.class_id, indx.subgroup_id, indx.function_id, indx.is_reply);
         //TODO: We should reply with some kind of "no such method" error in this case
         return std::exception_ptr{};
     }
     std::size_t reply_header_size = header_space();
-    recv_ret reply_return = receiver_function_entry->second(
+    recv_ret reply_return = (*receiver_function)(
             &rdv, received_from, buf,
             [&out_alloc, &reply_header_size](std::size_t size) {
                 return out_alloc(size + reply_header_size) + reply_header_size;
@@ -106,27 +313,87 @@ std::exception_ptr RPCManager::parse_and_receive(char* buf, std::size_t size,
 
 void RPCManager::rpc_message_handler(subgroup_id_t subgroup_id, node_id_t sender_id,
                                      char* msg_buf, uint32_t buffer_size) {
+    using namespace remote_invocation_utilities;
     // WARNING: This assumes the current view doesn't change during execution!
     // (It accesses curr_view without a lock).
 
     // set the thread local rpc_handler context
     _in_rpc_handler = true;
 
+    //A standby member of the shard applies the update to keep its replicated
+    //state warm, but takes no part in the reply protocol: any reply the
+    //handler generates goes into scratch storage and is dropped
+    const auto my_shard_entry = view_manager.curr_view->my_subgroups.find(subgroup_id);
+    if(my_shard_entry != view_manager.curr_view->my_subgroups.end()) {
+        const SubView& my_shard_view = view_manager.curr_view->subgroup_shard_views
+                                               .at(subgroup_id)
+                                               .at(my_shard_entry->second);
+        if(my_shard_view.my_rank != -1 && !my_shard_view.is_standby.empty()
+           && my_shard_view.is_standby[my_shard_view.my_rank]) {
+            std::vector<char> scratch_reply;
+            parse_and_receive(msg_buf, buffer_size,
+                              [&scratch_reply](size_t size) -> char* {
+                                  scratch_reply.resize(size);
+                                  return scratch_reply.data();
+                              });
+            _in_rpc_handler = false;
+            return;
+        }
+    }
+
+    //Peek at the opcode to see whether this function's replies are combined
+    //up a reduction tree instead of each going straight back to the caller
+    std::size_t request_payload_size = buffer_size;
+    Opcode request_opcode;
+    node_id_t request_from;
+    uint32_t request_flags;
+    retrieve_header(nullptr, msg_buf, request_payload_size, request_opcode, request_from, request_flags);
+    const Opcode reply_opcode{request_opcode.class_id, request_opcode.subgroup_id,
+                              request_opcode.function_id, true};
+    const bool reduce_replies = reply_combiners.count(reply_opcode) > 0;
+
     //Use the reply-buffer allocation lambda to detect whether parse_and_receive generated a reply
     size_t reply_size = 0;
     char* reply_buf;
-    parse_and_receive(msg_buf, buffer_size,
-                      [this, &reply_buf, &reply_size, &sender_id](size_t size) -> char* {
-                          reply_size = size;
-                          if(reply_size <= connections->get_max_p2p_reply_size()) {
-                              reply_buf = (char*)connections->get_sendbuffer_ptr(
-                                      sender_id, sst::REQUEST_TYPE::RPC_REPLY);
-                              return reply_buf;
-                          } else {
-                              // the reply size is too large - not part of the design to handle it
-                              return nullptr;
-                          }
-                      });
+    std::optional<sst::P2PConnection::SendSlot> reply_slot;
+    std::vector<char> reduced_reply;
+    bool piggyback_reply = false;
+    std::vector<char> piggyback_buf;
+    if(reduce_replies) {
+        //The reply is a contribution to the reduction, not a P2P send, so
+        //keep it out of the P2P send buffers
+        parse_and_receive(msg_buf, buffer_size,
+                          [&reduced_reply, &reply_size](size_t size) -> char* {
+                              reply_size = size;
+                              reduced_reply.resize(size);
+                              return reduced_reply.data();
+                          });
+    } else {
+        parse_and_receive(msg_buf, buffer_size,
+                          [this, &reply_buf, &reply_slot, &reply_size, &piggyback_reply,
+                           &piggyback_buf, &sender_id](size_t size) -> char* {
+                              reply_size = size;
+                              if(sender_id != nid && reply_size <= piggyback_reply_max_size) {
+                                  //Small reply to a remote caller: stage it for the SST
+                                  //piggyback lane instead of consuming a P2P_REPLY slot
+                                  piggyback_reply = true;
+                                  piggyback_buf.resize(size);
+                                  reply_buf = piggyback_buf.data();
+                                  return reply_buf;
+                              }
+                              if(reply_size <= connections->get_max_p2p_reply_size()) {
+                                  //Reply-lane reservations have no window check,
+                                  //so this always succeeds
+                                  reply_slot = connections->reserve_slot(
+                                          sender_id, sst::REQUEST_TYPE::RPC_REPLY);
+                                  reply_buf = reply_slot->buf;
+                                  return reply_buf;
+                              } else {
+                                  // the reply size is too large - not part of the design to handle it
+                                  return nullptr;
+                              }
+                          });
+    }
     if(sender_id == nid) {
         //This is a self-receive of an RPC message I sent, so I have a reply-map that needs fulfilling
         const uint32_t my_shard = view_manager.curr_view->my_subgroups.at(subgroup_id);
@@ -137,28 +404,167 @@ void RPCManager::rpc_message_handler(subgroup_id_t subgroup_id, node_id_t sender
             // thread that called the orderedSend signal us
             // although the race condition is infinitely rare
             pending_results_cv.wait(lock, [&]() { return !pending_results_to_fulfill[subgroup_id].empty(); });
-            //We now know the membership of "all nodes in my shard of the subgroup" in the current view
+            //We now know the membership of "all nodes in my shard of the subgroup" in the current view.
+            //Standby members never reply, so they are left out of the reply map.
+            //With reduced replies, the only reply the caller will see is the combined one, delivered
+            //under its own node ID
+            const SubView& shard_view = view_manager.curr_view->subgroup_shard_views.at(subgroup_id).at(my_shard);
+            node_list_t voting_members;
+            for(std::size_t shard_rank = 0; shard_rank < shard_view.members.size(); ++shard_rank) {
+                if(shard_view.is_standby.empty() || !shard_view.is_standby[shard_rank]) {
+                    voting_members.push_back(shard_view.members[shard_rank]);
+                }
+            }
             pending_results_to_fulfill[subgroup_id].front().get().fulfill_map(
-                    view_manager.curr_view->subgroup_shard_views.at(subgroup_id).at(my_shard).members);
+                    reduce_replies ? node_list_t{nid} : voting_members);
             fulfilled_pending_results[subgroup_id].push_back(
                     std::move(pending_results_to_fulfill[subgroup_id].front()));
             pending_results_to_fulfill[subgroup_id].pop();
         }  //release pending_results_mutex
         if(reply_size > 0) {
-            //Since this was a self-receive, the reply also goes to myself
-            parse_and_receive(
-                    reply_buf, reply_size,
-                    [](size_t size) -> char* { assert_always(false); });
+            if(reduce_replies) {
+                //Feed my own reply into the reduction; the map above is
+                //fulfilled, so a completed reduction can deliver immediately
+                add_reduction_contribution(reply_opcode, sender_id,
+                                           reduced_reply.data() + header_space(),
+                                           reply_size - header_space());
+            } else {
+                //Since this was a self-receive, the reply also goes to myself
+                parse_and_receive(
+                        reply_buf, reply_size,
+                        [](size_t size) -> char* { assert_always(false); });
+            }
         }
     } else if(reply_size > 0) {
-        //Otherwise, the only thing to do is send the reply (if there was one)
-        connections->send(sender_id);
+        if(reduce_replies) {
+            add_reduction_contribution(reply_opcode, sender_id,
+                                       reduced_reply.data() + header_space(),
+                                       reply_size - header_space());
+        } else if(piggyback_reply) {
+            if(!view_manager.curr_view->multicast_group->try_piggyback_reply(
+                       sender_id, piggyback_buf.data(), reply_size)) {
+                //The destination's slot ring was full (or it isn't in this
+                //view's SST): fall back to a normal p2p reply
+                auto send_slot = connections->reserve_slot(
+                        sender_id, sst::REQUEST_TYPE::RPC_REPLY);
+                memcpy(send_slot->buf, piggyback_buf.data(), reply_size);
+                connections->post(sender_id, *send_slot);
+            }
+        } else {
+            //Otherwise, the only thing to do is send the reply (if there was one)
+            connections->post(sender_id, *reply_slot);
+        }
     }
 
     // clear the thread local rpc_handler context
     _in_rpc_handler = false;
 }
 
+bool RPCManager::is_order_insensitive_rpc(subgroup_id_t subgroup_id, char* msg_buf, uint32_t buffer_size) {
+    using namespace remote_invocation_utilities;
+    if(order_insensitive_opcodes.empty() || buffer_size < header_space()) {
+        return false;
+    }
+    std::size_t payload_size = buffer_size;
+    Opcode indx;
+    node_id_t received_from;
+    uint32_t flags;
+    retrieve_header(nullptr, msg_buf, payload_size, indx, received_from, flags);
+    return !indx.is_reply
+           && order_insensitive_opcodes.count({subgroup_id, indx.function_id}) > 0;
+}
+
+void RPCManager::add_reduction_contribution(const Opcode& reply_opcode, node_id_t caller_id,
+                                            const char* reply_payload, std::size_t payload_size) {
+    using namespace remote_invocation_utilities;
+    // WARNING: Like rpc_message_handler, this assumes the current view doesn't
+    // change during execution
+    const subgroup_id_t subgroup_id = reply_opcode.subgroup_id;
+    const long int invocation_id = ((const long int*)(reply_payload + 1))[0];
+    //Locate this node and the caller in the shard to derive the reduction
+    //tree: a binary heap over the shard members, rotated so the caller is root
+    const uint32_t my_shard = view_manager.curr_view->my_subgroups.at(subgroup_id);
+    const SubView& shard_view
+            = view_manager.curr_view->subgroup_shard_views.at(subgroup_id).at(my_shard);
+    //The tree spans only the voting members: standbys apply requests without
+    //replying, so they can never be interior nodes of a reduction
+    std::vector<node_id_t> shard_members;
+    for(std::size_t shard_rank = 0; shard_rank < shard_view.members.size(); ++shard_rank) {
+        if(shard_view.is_standby.empty() || !shard_view.is_standby[shard_rank]) {
+            shard_members.push_back(shard_view.members[shard_rank]);
+        }
+    }
+    const std::size_t num_shard_members = shard_members.size();
+    std::size_t my_rank = 0;
+    std::size_t caller_rank = 0;
+    for(std::size_t rank = 0; rank < num_shard_members; ++rank) {
+        if(shard_members[rank] == nid) {
+            my_rank = rank;
+        }
+        if(shard_members[rank] == caller_id) {
+            caller_rank = rank;
+        }
+    }
+    const std::size_t my_tree_rank = (my_rank + num_shard_members - caller_rank) % num_shard_members;
+    std::size_t num_children = 0;
+    if(2 * my_tree_rank + 1 < num_shard_members) {
+        num_children++;
+    }
+    if(2 * my_tree_rank + 2 < num_shard_members) {
+        num_children++;
+    }
+
+    ReductionState finished_state;
+    {
+        std::lock_guard<std::mutex> lock(reductions_mutex);
+        auto state_pair = pending_reductions.find({reply_opcode, caller_id, invocation_id});
+        if(state_pair == pending_reductions.end()) {
+            state_pair = pending_reductions.emplace(std::make_tuple(reply_opcode, caller_id, invocation_id),
+                                                    ReductionState{num_children + 1, {}})
+                                 .first;
+        }
+        ReductionState& state = state_pair->second;
+        if(state.reply_payload.empty()) {
+            state.reply_payload.assign(reply_payload, reply_payload + payload_size);
+        } else if(reply_payload[0]) {
+            //An exception anywhere in the subtree poisons the whole reduction
+            state.reply_payload.assign(reply_payload, reply_payload + payload_size);
+        } else if(!state.reply_payload[0]) {
+            //Combine the serialized values, which sit after the exception
+            //flag and the invocation ID in both payloads
+            reply_combiners.at(reply_opcode)(state.reply_payload.data() + 1 + sizeof(invocation_id),
+                                             reply_payload + 1 + sizeof(invocation_id));
+        }
+        if(--state.contributions_remaining > 0) {
+            return;
+        }
+        finished_state = std::move(state);
+        pending_reductions.erase(state_pair);
+    }  //release reductions_mutex before sending or delivering
+    if(my_tree_rank == 0) {
+        //This node is the caller: deliver the fully reduced reply to the
+        //PendingResults that rpc_message_handler already fulfilled
+        trc_default_event("reduced_reply_deliver", invocation_id, 0);
+        receive_message(reply_opcode, nid, finished_state.reply_payload.data(),
+                        finished_state.reply_payload.size(),
+                        [](size_t size) -> char* { assert_always(false); });
+    } else {
+        //Forward the subtree's reduced reply to this node's tree parent
+        const node_id_t parent_id = shard_members[((my_tree_rank - 1) / 2 + caller_rank) % num_shard_members];
+        trc_default_event("reduced_reply_forward", invocation_id, parent_id);
+        uint32_t reduced_flags = 0;
+        RPC_HEADER_FLAG_SET(reduced_flags, REDUCED);
+        //No lock is taken here: on the p2p receive path the caller already
+        //holds p2p_connections_mutex (re-locking it would self-deadlock),
+        //and on the delivery path the caller holds the view lock, which also
+        //prevents the connections from being reassigned
+        auto send_slot = connections->reserve_slot(parent_id, sst::REQUEST_TYPE::RPC_REPLY);
+        populate_header(send_slot->buf, finished_state.reply_payload.size(), reply_opcode, caller_id, reduced_flags);
+        memcpy(send_slot->buf + header_space(), finished_state.reply_payload.data(), finished_state.reply_payload.size());
+        connections->post(parent_id, *send_slot);
+    }
+}
+
 void RPCManager::p2p_message_handler(node_id_t sender_id, char* msg_buf, uint32_t buffer_size) {
     using namespace remote_invocation_utilities;
     const std::size_t header_size = header_space();
@@ -168,19 +574,26 @@ void RPCManager::p2p_message_handler(node_id_t sender_id, char* msg_buf, uint32_
     uint32_t flags;
     retrieve_header(nullptr, msg_buf, payload_size, indx, received_from, flags);
     size_t reply_size = 0;
-    if(indx.is_reply) {
+    std::optional<sst::P2PConnection::SendSlot> reply_slot;
+    if(indx.is_reply && RPC_HEADER_FLAG_TST(flags, REDUCED)) {
+        // A subtree's reduced reply, addressed to this node as an interior
+        // node of a reply-reduction tree. "received_from" is the original
+        // caller, not the child that forwarded the reply.
+        add_reduction_contribution(indx, received_from, msg_buf + header_size, payload_size);
+    } else if(indx.is_reply) {
         // REPLYs can be handled here because they do not block.
         receive_message(indx, received_from, msg_buf + header_size, payload_size,
-                        [this, &buffer_size, &reply_size, &sender_id](size_t _size) -> char* {
+                        [this, &buffer_size, &reply_size, &reply_slot, &sender_id](size_t _size) -> char* {
                             reply_size = _size;
                             if(reply_size <= buffer_size) {
-                                return (char*)connections->get_sendbuffer_ptr(
+                                reply_slot = connections->reserve_slot(
                                         sender_id, sst::REQUEST_TYPE::P2P_REPLY);
+                                return reply_slot->buf;
                             }
                             return nullptr;
                         });
         if(reply_size > 0) {
-            connections->send(sender_id);
+            connections->post(sender_id, *reply_slot);
         }
     } else if(RPC_HEADER_FLAG_TST(flags, CASCADE)) {
         // TODO: what is the lifetime of msg_buf? discuss with Sagar to make
@@ -188,10 +601,11 @@ void RPCManager::p2p_message_handler(node_id_t sender_id, char* msg_buf, uint32_
         // for cascading messages, we create a new thread.
         throw derecho::derecho_exception("Cascading P2P Send/Queries to be implemented!");
     } else {
-        // send to fifo queue.
-        std::unique_lock<std::mutex> lock(fifo_queue_mutex);
-        fifo_queue.emplace(sender_id, msg_buf, buffer_size);
-        fifo_queue_cv.notify_one();
+        // send to the fifo queue of the worker assigned to this sender
+        fifo_worker_queue& queue = *fifo_queues[sender_id % fifo_queues.size()];
+        std::unique_lock<std::mutex> lock(queue.mutex);
+        queue.requests.emplace(sender_id, msg_buf, buffer_size);
+        queue.cv.notify_one();
     }
 }
 
@@ -200,9 +614,22 @@ void RPCManager::new_view_callback(const View& new_view) {
     {
         std::lock_guard<std::mutex> connections_lock(p2p_connections_mutex);
         connections->remove_connections(new_view.departed);
-        connections->add_connections(new_view.members);
+        if(lazy_member_p2p) {
+            //Members' connections are built on first use (see reserve_p2p_buffer
+            //and p2p_connection_requested); just record who the members are so
+            //their connections are exempt from external-client eviction
+            connections->set_lazy_members(new_view.members);
+        } else {
+            connections->add_connections(new_view.members);
+        }
     }
     dbg_default_debug("Created new connections among the new view members");
+    {
+        //Drop half-finished reply reductions: the tree was derived from the
+        //old membership, and the calls they belong to are being failed anyway
+        std::lock_guard<std::mutex> reductions_lock(reductions_mutex);
+        pending_reductions.clear();
+    }
     std::lock_guard<std::mutex> lock(pending_results_mutex);
     for(auto& fulfilled_pending_results_pair : fulfilled_pending_results) {
         const subgroup_id_t subgroup_id = fulfilled_pending_results_pair.first;
@@ -230,6 +657,18 @@ void RPCManager::new_view_callback(const View& new_view) {
     }
 }
 
+void RPCManager::p2p_connection_requested(node_id_t node_id) {
+    if(connections->contains_node(node_id)) {
+        return;
+    }
+    dbg_default_debug("Lazy p2p: node {} requested a connection; building this side", node_id);
+    //The P2PConnection constructor blocks in the memory-region exchange with
+    //the requesting node, so run it off the predicate thread
+    std::thread([this, node_id]() {
+        connections->ensure_connection(node_id);
+    }).detach();
+}
+
 bool RPCManager::finish_rpc_send(subgroup_id_t subgroup_id, PendingBase& pending_results_handle) {
     std::lock_guard<std::mutex> lock(pending_results_mutex);
     pending_results_to_fulfill[subgroup_id].push(pending_results_handle);
@@ -237,33 +676,90 @@ bool RPCManager::finish_rpc_send(subgroup_id_t subgroup_id, PendingBase& pending
     return true;
 }
 
-volatile char* RPCManager::get_sendbuffer_ptr(uint32_t dest_id, sst::REQUEST_TYPE type) {
-    volatile char* buf;
+void RPCManager::schedule_rpc_deadline(subgroup_id_t subgroup_id, PendingBase& pending_results_handle,
+                                       std::chrono::milliseconds timeout) {
+    //Round up, so a deadline never fires early because of tick granularity
+    const uint64_t ticks_until_deadline
+            = (timeout + deadline_tick_interval - std::chrono::milliseconds(1)) / deadline_tick_interval;
+    std::lock_guard<std::mutex> wheel_lock(deadline_wheel_mutex);
+    if(deadline_wheel.empty()) {
+        deadline_wheel.resize(deadline_wheel_buckets);
+        deadline_thread = std::thread(&RPCManager::deadline_thread_loop, this);
+    }
+    const uint64_t deadline_tick = deadline_current_tick + std::max<uint64_t>(ticks_until_deadline, 1);
+    deadline_wheel[deadline_tick % deadline_wheel_buckets].push_back(
+            DeadlineEntry{subgroup_id, &pending_results_handle,
+                          pending_results_handle.invocation_epoch.load(), deadline_tick});
+}
+
+void RPCManager::deadline_thread_loop() {
+    pthread_setname_np(pthread_self(), "rpc_deadlines");
+    while(!thread_shutdown) {
+        std::this_thread::sleep_for(deadline_tick_interval);
+        std::list<DeadlineEntry> expired;
+        {
+            std::lock_guard<std::mutex> wheel_lock(deadline_wheel_mutex);
+            deadline_current_tick++;
+            std::list<DeadlineEntry>& bucket = deadline_wheel[deadline_current_tick % deadline_wheel_buckets];
+            for(auto entry_iterator = bucket.begin(); entry_iterator != bucket.end();) {
+                if(entry_iterator->deadline_tick <= deadline_current_tick) {
+                    expired.splice(expired.end(), bucket, entry_iterator++);
+                } else {
+                    //Due a whole revolution (or more) later; leave it in place
+                    entry_iterator++;
+                }
+            }
+        }
+        //Fulfill the promises outside the wheel lock, since continuations
+        //attached to the expiring calls run from set_exception
+        for(const DeadlineEntry& entry : expired) {
+            if(entry.pending->invocation_epoch == entry.epoch
+               && !entry.pending->all_responded()) {
+                dbg_default_debug("RPC deadline expired for a call in subgroup {}", entry.subgroup_id);
+                entry.pending->set_exception_for_timeout();
+            }
+        }
+    }
+}
+
+sst::P2PConnection::SendSlot RPCManager::reserve_p2p_buffer(uint32_t dest_id, sst::REQUEST_TYPE type, uint64_t msg_size) {
+    std::optional<sst::P2PConnection::SendSlot> slot;
     int curr_vid = -1;
     do {
         //This lock also prevents connections from being reassigned (because that happens
         //in new_view_callback), so we don't need p2p_connections_mutex
-        std::shared_lock<std::shared_timed_mutex> view_read_lock(view_manager.view_mutex);
+        std::shared_lock<EpochSharedMutex> view_read_lock(view_manager.view_mutex);
         //Check to see if the view changed between iterations of the loop, and re-get the rank
         if(curr_vid != view_manager.curr_view->vid) {
             curr_vid = view_manager.curr_view->vid;
         }
+        if(lazy_member_p2p && !connections->contains_node(dest_id)) {
+            //First contact with this member: raise the connect-request bit in
+            //its column of our SST row, so its predicate thread builds the
+            //other half of the connection while reserve_slot creates ours and
+            //blocks in the memory-region exchange
+            const int dest_rank = view_manager.curr_view->rank_of(dest_id);
+            if(dest_rank != -1) {
+                view_manager.curr_view->gmsSST->request_p2p_connection(dest_rank);
+            }
+        }
         try {
-            buf = connections->get_sendbuffer_ptr(dest_id, type);
+            slot = connections->reserve_slot(dest_id, type, msg_size);
         } catch(std::out_of_range& map_error) {
             throw node_removed_from_group_exception(dest_id);
         }
 
-    } while(!buf);
-    return buf;
+    } while(!slot);
+    return *slot;
 }
 
-void RPCManager::finish_p2p_send(node_id_t dest_id, subgroup_id_t dest_subgroup_id, PendingBase& pending_results_handle) {
+void RPCManager::post_p2p_send(node_id_t dest_id, const sst::P2PConnection::SendSlot& slot,
+                               subgroup_id_t dest_subgroup_id, PendingBase& pending_results_handle) {
     try {
         //This lock also prevents connections from being reassigned (because that happens
         //in new_view_callback), so we don't need p2p_connections_mutex
-        std::shared_lock<std::shared_timed_mutex> view_read_lock(view_manager.view_mutex);
-        connections->send(dest_id);
+        std::shared_lock<EpochSharedMutex> view_read_lock(view_manager.view_mutex);
+        connections->post(dest_id, slot);
     } catch(std::out_of_range& map_error) {
         throw node_removed_from_group_exception(dest_id);
     }
@@ -272,8 +768,27 @@ void RPCManager::finish_p2p_send(node_id_t dest_id, subgroup_id_t dest_subgroup_
     fulfilled_pending_results[dest_subgroup_id].push_back(pending_results_handle);
 }
 
-void RPCManager::fifo_worker() {
-    pthread_setname_np(pthread_self(), "fifo_thread");
+void RPCManager::publish_query_snapshot(const char* data, std::size_t size) {
+    std::lock_guard<std::mutex> connections_lock(p2p_connections_mutex);
+    connections->publish_query_snapshot(data, size);
+}
+
+bool RPCManager::one_sided_query(node_id_t target_id, char* data_out, std::size_t& size_out) {
+    try {
+        //This lock also prevents connections from being reassigned (because that happens
+        //in new_view_callback), so we don't need p2p_connections_mutex
+        std::shared_lock<EpochSharedMutex> view_read_lock(view_manager.view_mutex);
+        uint64_t fetched_size = 0;
+        const bool success = connections->fetch_query_snapshot(target_id, data_out, fetched_size);
+        size_out = fetched_size;
+        return success;
+    } catch(std::out_of_range& map_error) {
+        throw node_removed_from_group_exception(target_id);
+    }
+}
+
+void RPCManager::fifo_worker(uint32_t worker_index) {
+    pthread_setname_np(pthread_self(), ("fifo_thread_" + std::to_string(worker_index)).c_str());
     using namespace remote_invocation_utilities;
     const std::size_t header_size = header_space();
     std::size_t payload_size;
@@ -282,39 +797,46 @@ void RPCManager::fifo_worker() {
     uint32_t flags;
     size_t reply_size = 0;
     fifo_req request;
+    fifo_worker_queue& queue = *fifo_queues[worker_index];
 
     while(!thread_shutdown) {
         {
-            std::unique_lock<std::mutex> lock(fifo_queue_mutex);
-            fifo_queue_cv.wait(lock, [&]() { return !fifo_queue.empty() || thread_shutdown; });
+            std::unique_lock<std::mutex> lock(queue.mutex);
+            queue.cv.wait(lock, [&]() { return !queue.requests.empty() || thread_shutdown; });
             if(thread_shutdown) {
                 break;
             }
-            request = fifo_queue.front();
-            fifo_queue.pop();
+            request = queue.requests.front();
+            queue.requests.pop();
         }
         retrieve_header(nullptr, request.msg_buf, payload_size, indx, received_from, flags);
+        // reset per message: the reply lambda is only invoked when the
+        // function generates a reply, and a stale size would pair with the
+        // wrong slot
+        reply_size = 0;
         if(indx.is_reply || RPC_HEADER_FLAG_TST(flags, CASCADE)) {
             dbg_default_error("Invalid rpc message in fifo queue: is_reply={}, is_cascading={}",
                               indx.is_reply, RPC_HEADER_FLAG_TST(flags, CASCADE));
             throw derecho::derecho_exception("invalid rpc message in fifo queue...crash.");
         }
+        std::optional<sst::P2PConnection::SendSlot> reply_slot;
         receive_message(indx, received_from, request.msg_buf + header_size, payload_size,
-                        [this, &reply_size, &request](size_t _size) -> char* {
+                        [this, &reply_size, &reply_slot, &request](size_t _size) -> char* {
                             reply_size = _size;
                             if(reply_size <= request.buffer_size) {
-                                return (char*)connections->get_sendbuffer_ptr(
+                                reply_slot = connections->reserve_slot(
                                         request.sender_id, sst::REQUEST_TYPE::P2P_REPLY);
+                                return reply_slot->buf;
                             }
                             return nullptr;
                         });
         if(reply_size > 0) {
-            connections->send(request.sender_id);
+            connections->post(request.sender_id, *reply_slot);
         } else {
             // hack for now to "simulate" a reply for p2p_sends to functions that do not generate a reply
-            char* buf = connections->get_sendbuffer_ptr(request.sender_id, sst::REQUEST_TYPE::P2P_REPLY);
-            buf[0] = 0;
-            connections->send(request.sender_id);
+            auto null_slot = connections->reserve_slot(request.sender_id, sst::REQUEST_TYPE::P2P_REPLY);
+            null_slot->buf[0] = 0;
+            connections->post(request.sender_id, *null_slot);
         }
     }
 }
@@ -331,18 +853,30 @@ void RPCManager::p2p_receive_loop() {
         thread_start_cv.wait(lock, [this]() { return thread_start; });
     }
     dbg_default_debug("P2P listening thread started");
-    // start the fifo worker thread
-    fifo_worker_thread = std::thread(&RPCManager::fifo_worker, this);
+    // start the fifo worker pool
+    const uint32_t num_fifo_workers = std::max(getConfUInt32(CONF_DERECHO_RPC_WORKER_THREADS), 1u);
+    for(uint32_t worker_index = 0; worker_index < num_fifo_workers; ++worker_index) {
+        fifo_queues.emplace_back(std::make_unique<fifo_worker_queue>());
+    }
+    for(uint32_t worker_index = 0; worker_index < num_fifo_workers; ++worker_index) {
+        fifo_worker_threads.emplace_back(&RPCManager::fifo_worker, this, worker_index);
+    }
+    fifo_workers_started = true;
 
     struct timespec last_time, cur_time;
     clock_gettime(CLOCK_REALTIME, &last_time);
+    // occupancy accounting: probing the receive rings is EVALUATING,
+    // handling a message is WORKING, and the inactivity sleep is IDLE
+    PhaseOccupancy::ThreadSlot& occupancy = PhaseOccupancy::registerThread("rpc_thread");
 
     // loop event
     while(!thread_shutdown) {
+        occupancy.enter(PhaseOccupancy::EVALUATING);
         std::unique_lock<std::mutex> connections_lock(p2p_connections_mutex);
         auto optional_reply_pair = connections->probe_all();
         if(optional_reply_pair) {
             auto reply_pair = optional_reply_pair.value();
+            occupancy.enter(PhaseOccupancy::WORKING);
             p2p_message_handler(reply_pair.first, (char*)reply_pair.second, max_payload_size);
             connections->update_incoming_seq_num();
 
@@ -355,15 +889,47 @@ void RPCManager::p2p_receive_loop() {
                                         + (cur_time.tv_nsec - last_time.tv_nsec) / 1e6;
             if(time_elapsed_in_ms > 1) {
                 connections_lock.unlock();
+                occupancy.enter(PhaseOccupancy::IDLE);
                 using namespace std::chrono_literals;
                 std::this_thread::sleep_for(1ms);
                 connections_lock.lock();
             }
         }
     }
-    // stop fifo worker.
-    fifo_queue_cv.notify_one();
-    fifo_worker_thread.join();
+    // stop the fifo workers.
+    for(const auto& queue : fifo_queues) {
+        queue->cv.notify_one();
+    }
+    for(std::thread& worker_thread : fifo_worker_threads) {
+        worker_thread.join();
+    }
+}
+
+bool RPCManager::drain_one_p2p_message() {
+    static const uint64_t max_payload_size = getConfUInt64(CONF_SUBGROUP_DEFAULT_MAX_PAYLOAD_SIZE);
+    if(!fifo_workers_started || thread_shutdown) {
+        return false;
+    }
+    //try_to_lock: if the listening thread (or another helper) is mid-probe,
+    //spinning on the mutex would only serialize behind it, so report no
+    //progress and let the caller re-check its reply instead
+    std::unique_lock<std::mutex> connections_lock(p2p_connections_mutex, std::try_to_lock);
+    if(!connections_lock.owns_lock()) {
+        return false;
+    }
+    auto optional_reply_pair = connections->probe_all();
+    if(!optional_reply_pair) {
+        return false;
+    }
+    auto reply_pair = optional_reply_pair.value();
+    p2p_message_handler(reply_pair.first, (char*)reply_pair.second, max_payload_size);
+    connections->update_incoming_seq_num();
+    return true;
+}
+
+bool help_p2p_receive() {
+    RPCManager* manager = helping_rpc_manager.load(std::memory_order_acquire);
+    return manager != nullptr && manager->drain_one_p2p_message();
 }
 
 bool in_rpc_handler() {
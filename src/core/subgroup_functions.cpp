@@ -126,6 +126,50 @@ void DefaultSubgroupAllocator::compute_standard_memberships(
                                                   prev_view, curr_view, shard_sizes);
         }
     }
+    //With every shard's voting members in place, hand out any leftover nodes
+    //as hot standbys to the shards whose policies request them
+    assign_standby_replicas(subgroup_type_order, curr_view, subgroup_layouts);
+}
+
+void DefaultSubgroupAllocator::assign_standby_replicas(
+        const std::vector<std::type_index>& subgroup_type_order,
+        View& curr_view,
+        subgroup_allocation_map_t& subgroup_layouts) const {
+    for(const auto& subgroup_type : subgroup_type_order) {
+        if(!std::holds_alternative<SubgroupAllocationPolicy>(policies.at(subgroup_type))) {
+            continue;
+        }
+        const SubgroupAllocationPolicy& subgroup_type_policy
+                = std::get<SubgroupAllocationPolicy>(policies.at(subgroup_type));
+        subgroup_shard_layout_t& subgroup_allocation = subgroup_layouts.at(subgroup_type);
+        for(uint32_t subgroup_num = 0; subgroup_num < subgroup_allocation.size(); ++subgroup_num) {
+            const ShardAllocationPolicy& sharding_policy
+                    = subgroup_type_policy.identical_subgroups
+                              ? subgroup_type_policy.shard_policy_by_subgroup[0]
+                              : subgroup_type_policy.shard_policy_by_subgroup[subgroup_num];
+            if(sharding_policy.num_standby_replicas <= 0) {
+                continue;
+            }
+            for(uint32_t shard_num = 0; shard_num < subgroup_allocation[subgroup_num].size();
+                ++shard_num) {
+                SubView& shard_view = subgroup_allocation[subgroup_num][shard_num];
+                //Surviving standbys carried over by update_standard_subgroup_type count
+                //toward the target, so a stable view assigns nothing new here
+                int num_standbys = shard_view.members.size() - shard_view.num_voting_members();
+                while(num_standbys < sharding_policy.num_standby_replicas
+                      && curr_view.next_unassigned_rank < (int)curr_view.members.size()) {
+                    const int standby_rank = curr_view.next_unassigned_rank;
+                    curr_view.next_unassigned_rank++;
+                    shard_view.members.push_back(curr_view.members[standby_rank]);
+                    shard_view.is_sender.push_back(0);
+                    shard_view.is_standby.push_back(1);
+                    shard_view.member_ips_and_ports.push_back(
+                            curr_view.member_ips_and_ports[standby_rank]);
+                    num_standbys++;
+                }
+            }
+        }
+    }
 }
 
 std::map<std::type_index, std::vector<std::vector<uint32_t>>>
@@ -163,15 +207,27 @@ DefaultSubgroupAllocator::compute_standard_shard_sizes(
                     const SubView& previous_shard_assignment
                             = prev_view->subgroup_shard_views[previous_assignment_offset + subgroup_num]
                                                              [shard_num];
+                    /* Shard sizes count only voting members; surviving standbys
+                     * stay in the shard but are accounted for separately so the
+                     * even-incrementing loop below doesn't hand their nodes to
+                     * another shard. */
                     int num_nonfailed_nodes = 0;
+                    int num_surviving_standbys = 0;
                     for(std::size_t rank = 0; rank < previous_shard_assignment.members.size(); ++rank) {
-                        if(curr_view.rank_of(previous_shard_assignment.members[rank]) != -1) {
+                        if(curr_view.rank_of(previous_shard_assignment.members[rank]) == -1) {
+                            continue;
+                        }
+                        if(!previous_shard_assignment.is_standby.empty()
+                           && previous_shard_assignment.is_standby[rank]) {
+                            num_surviving_standbys++;
+                        } else {
                             num_nonfailed_nodes++;
                         }
                     }
                     if(num_nonfailed_nodes > min_shard_size) {
                         min_shard_size = num_nonfailed_nodes;
                     }
+                    nodes_needed += num_surviving_standbys;
                 }
                 shard_sizes[subgroup_type][subgroup_num][shard_num] = min_shard_size;
                 nodes_needed += min_shard_size;
@@ -274,6 +330,47 @@ subgroup_shard_layout_t DefaultSubgroupAllocator::update_standard_subgroup_type(
      * starting at the first subgroup's ID, and extending for num_subgroups entries.
      */
     const subgroup_id_t previous_assignment_offset = prev_view->subgroup_ids_by_type_id.at(subgroup_type_id)[0];
+    /* Fast path: if every shard keeps its previous size and, when members have
+     * departed, none of them belonged to this type, the shard-by-shard update
+     * below would reproduce the previous assignment exactly. In that case just
+     * copy it, skipping the member-survival scans and SubView construction.
+     * (ViewManager reinitializes each SubView's my_rank, joined, and departed
+     * after allocation, so the copied values don't matter.) */
+    bool assignment_unchanged = true;
+    for(uint32_t subgroup_num = 0;
+        assignment_unchanged && subgroup_num < shard_sizes.at(subgroup_type).size();
+        ++subgroup_num) {
+        for(uint32_t shard_num = 0;
+            assignment_unchanged && shard_num < shard_sizes.at(subgroup_type)[subgroup_num].size();
+            ++shard_num) {
+            const SubView& previous_shard_assignment
+                    = prev_view->subgroup_shard_views[previous_assignment_offset + subgroup_num]
+                                                     [shard_num];
+            if(shard_sizes.at(subgroup_type)[subgroup_num][shard_num]
+               != previous_shard_assignment.num_voting_members()) {
+                assignment_unchanged = false;
+            } else if(!curr_view.departed.empty()) {
+                for(const node_id_t& member_id : previous_shard_assignment.members) {
+                    if(curr_view.rank_of(member_id) == -1) {
+                        assignment_unchanged = false;
+                        break;
+                    }
+                }
+            }
+        }
+    }
+    if(assignment_unchanged) {
+        subgroup_shard_layout_t unchanged_assignment(shard_sizes.at(subgroup_type).size());
+        for(uint32_t subgroup_num = 0; subgroup_num < unchanged_assignment.size(); ++subgroup_num) {
+            for(uint32_t shard_num = 0; shard_num < shard_sizes.at(subgroup_type)[subgroup_num].size();
+                ++shard_num) {
+                unchanged_assignment[subgroup_num].emplace_back(
+                        prev_view->subgroup_shard_views[previous_assignment_offset + subgroup_num]
+                                                       [shard_num]);
+            }
+        }
+        return unchanged_assignment;
+    }
     subgroup_shard_layout_t next_assignment(shard_sizes.at(subgroup_type).size());
     for(uint32_t subgroup_num = 0; subgroup_num < next_assignment.size(); ++subgroup_num) {
         //The size of shard_sizes[subgroup_type][subgroup_num] is the number of shards
@@ -284,7 +381,9 @@ subgroup_shard_layout_t DefaultSubgroupAllocator::update_standard_subgroup_type(
                                                      [shard_num];
             std::vector<node_id_t> next_shard_members;
             std::vector<int> next_is_sender;
+            std::vector<int> next_is_standby;
             uint32_t allocated_shard_size = shard_sizes.at(subgroup_type)[subgroup_num][shard_num];
+            uint32_t num_voting_members = 0;
             //Add all the non-failed nodes from the previous assignment
             for(std::size_t rank = 0; rank < previous_shard_assignment.members.size(); ++rank) {
                 if(curr_view.rank_of(previous_shard_assignment.members[rank]) == -1) {
@@ -292,20 +391,42 @@ subgroup_shard_layout_t DefaultSubgroupAllocator::update_standard_subgroup_type(
                 }
                 next_shard_members.push_back(previous_shard_assignment.members[rank]);
                 next_is_sender.push_back(previous_shard_assignment.is_sender[rank]);
+                next_is_standby.push_back(previous_shard_assignment.is_standby.empty()
+                                                  ? 0
+                                                  : previous_shard_assignment.is_standby[rank]);
+                if(!next_is_standby.back()) {
+                    num_voting_members++;
+                }
+            }
+            /* Fill voting vacancies by promoting surviving standbys in place.
+             * A promoted node is already a shard member with warm state, so
+             * init_joined_departed sees no join for it and the new view needs
+             * only a log-tail sync instead of a full state transfer. */
+            for(std::size_t rank = 0;
+                rank < next_shard_members.size() && num_voting_members < allocated_shard_size;
+                ++rank) {
+                if(next_is_standby[rank]) {
+                    next_is_standby[rank] = 0;
+                    next_is_sender[rank] = 1;
+                    num_voting_members++;
+                }
             }
             //Add additional members if needed
-            while(next_shard_members.size() < allocated_shard_size) {
+            while(num_voting_members < allocated_shard_size) {
                 //This must be true if compute_standard_shard_sizes said our view was adequate
                 assert(curr_view.next_unassigned_rank < (int)curr_view.members.size());
                 next_shard_members.push_back(curr_view.members[curr_view.next_unassigned_rank]);
                 curr_view.next_unassigned_rank++;
                 //All members start out as senders with the default allocator
                 next_is_sender.push_back(true);
+                next_is_standby.push_back(0);
+                num_voting_members++;
             }
             next_assignment[subgroup_num].emplace_back(curr_view.make_subview(next_shard_members,
                                                                               previous_shard_assignment.mode,
                                                                               next_is_sender,
-                                                                              previous_shard_assignment.profile));
+                                                                              previous_shard_assignment.profile,
+                                                                              next_is_standby));
         }
     }
     return next_assignment;
@@ -0,0 +1,113 @@
+/**
+ * @file transport_context.cpp
+ */
+
+#include <derecho/core/detail/transport_context.hpp>
+
+#include <derecho/rdmc/rdmc.hpp>
+#include <derecho/utils/logger.hpp>
+
+#ifdef USE_VERBS_API
+#include <derecho/rdmc/detail/verbs_helper.hpp>
+#include <derecho/sst/detail/verbs.hpp>
+#else
+#include <derecho/rdmc/detail/lf_helper.hpp>
+#include <derecho/sst/detail/lf.hpp>
+#endif
+
+namespace derecho {
+
+TransportContext& TransportContext::get() {
+    static TransportContext instance;
+    return instance;
+}
+
+bool TransportContext::attach(const std::map<node_id_t, std::pair<ip_addr_t, uint16_t>>& rdmc_addrs_and_ports,
+                              const std::map<node_id_t, std::pair<ip_addr_t, uint16_t>>& sst_addrs_and_ports,
+                              node_id_t my_id) {
+    std::lock_guard<std::mutex> lock(mtx);
+    if(!initialized) {
+        dbg_default_debug("First group attaching: doing global initialization of RDMC and SST, including internal TCP connection setup");
+        if(!rdmc::initialize(rdmc_addrs_and_ports, my_id)) {
+            return false;
+        }
+#ifdef USE_VERBS_API
+        sst::verbs_initialize(sst_addrs_and_ports, my_id);
+#else
+        sst::lf_initialize(sst_addrs_and_ports, my_id);
+        //Fan transport-level failure evidence out to every attached group's
+        //handler; the transports are shared, so the event is not per-group
+        sst::set_node_failure_callback([this](uint32_t failed_node) {
+            std::lock_guard<std::mutex> handlers_lock(failure_handlers_mutex);
+            for(const auto& id_and_handler : failure_handlers) {
+                id_and_handler.second(failed_node);
+            }
+        });
+#endif
+        local_id = my_id;
+        for(const auto& node_and_addr : rdmc_addrs_and_ports) {
+            node_use_counts[node_and_addr.first] = 1;
+        }
+        initialized = true;
+        return true;
+    }
+    if(my_id != local_id) {
+        dbg_default_error("Group with local id {} cannot attach to the transport context, which was initialized with local id {}",
+                          my_id, local_id);
+        return false;
+    }
+    dbg_default_debug("Additional group attaching to the shared RDMA transports");
+    for(const auto& node_and_addr : rdmc_addrs_and_ports) {
+        const node_id_t node_id = node_and_addr.first;
+        if(node_use_counts[node_id]++ == 0 && node_id != local_id) {
+            rdmc::add_address(node_id, node_and_addr.second);
+            sst::add_node(node_id, sst_addrs_and_ports.at(node_id));
+        }
+    }
+    return true;
+}
+
+void TransportContext::add_node(node_id_t new_id,
+                                const std::pair<ip_addr_t, uint16_t>& rdmc_addr_and_port,
+                                const std::pair<ip_addr_t, uint16_t>& sst_addr_and_port) {
+    std::lock_guard<std::mutex> lock(mtx);
+    if(node_use_counts[new_id]++ > 0) {
+        dbg_default_debug("Node {} joined another group but is already connected; reusing its RDMA connections", new_id);
+        return;
+    }
+    rdmc::add_address(new_id, rdmc_addr_and_port);
+    sst::add_node(new_id, sst_addr_and_port);
+}
+
+void TransportContext::remove_node(node_id_t node_id) {
+    std::lock_guard<std::mutex> lock(mtx);
+    auto count_entry = node_use_counts.find(node_id);
+    if(count_entry == node_use_counts.end()) {
+        return;
+    }
+    if(--count_entry->second > 0) {
+        dbg_default_debug("Node {} left one group but remains a member of another; keeping its RDMA connections", node_id);
+        return;
+    }
+    node_use_counts.erase(count_entry);
+#ifdef USE_VERBS_API
+    rdma::impl::verbs_remove_connection(node_id);
+#else
+    rdma::impl::lf_remove_connection(node_id);
+#endif
+    sst::remove_node(node_id);
+}
+
+uint32_t TransportContext::register_failure_handler(const std::function<void(node_id_t)>& handler) {
+    std::lock_guard<std::mutex> handlers_lock(failure_handlers_mutex);
+    const uint32_t handler_id = next_handler_id++;
+    failure_handlers[handler_id] = handler;
+    return handler_id;
+}
+
+void TransportContext::deregister_failure_handler(uint32_t handler_id) {
+    std::lock_guard<std::mutex> handlers_lock(failure_handlers_mutex);
+    failure_handlers.erase(handler_id);
+}
+
+}  // namespace derecho
@@ -1,3 +1,4 @@
+#include <algorithm>
 #include <fstream>
 #include <iostream>
 #include <iterator>
@@ -16,6 +17,7 @@ SubView::SubView(int32_t num_members)
         : mode(Mode::ORDERED),
           members(num_members),
           is_sender(num_members, 1),
+          is_standby(num_members, 0),
           member_ips_and_ports(num_members),
           joined(0),
           departed(0),
@@ -31,6 +33,7 @@ SubView::SubView(Mode mode,
         : mode(mode),
           members(members),
           is_sender(members.size(), 1),
+          is_standby(members.size(), 0),
           member_ips_and_ports(member_ips_and_ports),
           my_rank(-1),
           profile(profile) {
@@ -40,7 +43,20 @@ SubView::SubView(Mode mode,
     }
 }
 
+void SubView::build_rank_index() {
+    node_id_to_rank.clear();
+    for(std::size_t rank = 0; rank < members.size(); ++rank) {
+        node_id_to_rank[members[rank]] = rank;
+    }
+}
+
 int SubView::rank_of(const node_id_t& who) const {
+    if(!node_id_to_rank.empty()) {
+        const auto rank_entry = node_id_to_rank.find(who);
+        return rank_entry == node_id_to_rank.end() ? -1 : rank_entry->second;
+    }
+    //SubViews under construction by the allocation functions have no index
+    //yet, since their membership can still grow; scan the member list instead
     for(std::size_t rank = 0; rank < members.size(); ++rank) {
         if(members[rank] == who) {
             return rank;
@@ -72,6 +88,16 @@ uint32_t SubView::num_senders() const {
     return num;
 }
 
+uint32_t SubView::num_voting_members() const {
+    uint32_t num = 0;
+    for(std::size_t rank = 0; rank < members.size(); ++rank) {
+        if(is_standby.empty() || !is_standby[rank]) {
+            num++;
+        }
+    }
+    return num;
+}
+
 void SubView::init_joined_departed(const SubView& previous_subview) {
     //To ensure this method is idempotent
     joined.clear();
@@ -114,6 +140,13 @@ View::View(const int32_t vid, const std::vector<node_id_t>& members,
     for(int rank = 0; rank < num_members; ++rank) {
         node_id_to_rank[members[rank]] = rank;
     }
+    //Deserialized SubViews have their final membership, so index them now;
+    //joining nodes never re-run make_subgroup_maps on a received View
+    for(auto& shard_views : this->subgroup_shard_views) {
+        for(auto& shard_view : shard_views) {
+            shard_view.build_rank_index();
+        }
+    }
 }
 
 int View::find_rank_of_leader() const {
@@ -173,7 +206,8 @@ int View::rank_of(const node_id_t& who) const {
 SubView View::make_subview(const std::vector<node_id_t>& with_members,
                            const Mode mode,
                            const std::vector<int>& is_sender,
-                           std::string profile) const {
+                           std::string profile,
+                           const std::vector<int>& is_standby) const {
     // Make the profile string all uppercase so that it is effectively case-insensitive
     std::transform(profile.begin(), profile.end(), profile.begin(), ::toupper);
     std::vector<std::tuple<ip_addr_t, uint16_t, uint16_t, uint16_t, uint16_t>> subview_member_ips_and_ports(with_members.size());
@@ -186,7 +220,11 @@ SubView View::make_subview(const std::vector<node_id_t>& with_members,
         subview_member_ips_and_ports[subview_rank] = member_ips_and_ports[view_rank_of_member];
     }
     // Note that joined and departed do not need to get initialized here; they will be initialized by ViewManager
-    return SubView(mode, with_members, is_sender, subview_member_ips_and_ports, profile);
+    SubView new_subview(mode, with_members, is_sender, subview_member_ips_and_ports, profile);
+    if(is_standby.size()) {
+        new_subview.is_standby = is_standby;
+    }
+    return new_subview;
 }
 
 int View::subview_rank_of_shard_leader(subgroup_id_t subgroup_id,
@@ -265,4 +303,36 @@ std::string View::debug_string() const {
     return s.str();
 }
 
+ViewDelta::ViewDelta(const View& next_view)
+        : vid(next_view.vid),
+          joined(next_view.joined),
+          departed(next_view.departed),
+          failed(next_view.failed),
+          next_unassigned_rank(next_view.next_unassigned_rank) {
+    for(const node_id_t& joiner_id : joined) {
+        joiner_ips_and_ports.emplace_back(next_view.member_ips_and_ports[next_view.rank_of(joiner_id)]);
+    }
+}
+
+std::unique_ptr<View> ViewDelta::make_next_view(const View& old_view,
+                                                const std::vector<std::type_index>& subgroup_type_order) const {
+    std::vector<node_id_t> members;
+    std::vector<std::tuple<ip_addr_t, uint16_t, uint16_t, uint16_t, uint16_t>> member_ips_and_ports;
+    //Surviving members keep their relative order, and joiners go at the end,
+    //which is the same layout ViewManager::make_next_view produces on the leader
+    for(int old_rank = 0; old_rank < old_view.num_members; ++old_rank) {
+        if(std::find(departed.begin(), departed.end(), old_view.members[old_rank]) == departed.end()) {
+            members.emplace_back(old_view.members[old_rank]);
+            member_ips_and_ports.emplace_back(old_view.member_ips_and_ports[old_rank]);
+        }
+    }
+    for(std::size_t joiner_num = 0; joiner_num < joined.size(); ++joiner_num) {
+        members.emplace_back(joined[joiner_num]);
+        member_ips_and_ports.emplace_back(joiner_ips_and_ports[joiner_num]);
+    }
+    return std::make_unique<View>(vid, members, member_ips_and_ports, failed,
+                                  joined, departed, 0, next_unassigned_rank,
+                                  subgroup_type_order);
+}
+
 }  // namespace derecho
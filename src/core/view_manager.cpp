@@ -4,11 +4,14 @@
  * @date Feb 6, 2017
  */
 
+#include <algorithm>
 #include <arpa/inet.h>
+#include <limits>
 #include <tuple>
 
 #include <derecho/core/derecho_exception.hpp>
 #include <derecho/core/detail/container_template_functions.hpp>
+#include <derecho/core/detail/transport_context.hpp>
 #include <derecho/core/detail/version_code.hpp>
 #include <derecho/core/detail/view_manager.hpp>
 #include <derecho/core/git_version.hpp>
@@ -16,14 +19,26 @@
 
 #include <derecho/persistent/Persistent.hpp>
 #include <derecho/utils/logger.hpp>
+#include <derecho/utils/time.h>
 
 #include <mutils/macro_utils.hpp>
 
+#ifdef USE_VERBS_API
+#include <derecho/rdmc/detail/verbs_helper.hpp>
+#else
+#include <derecho/rdmc/detail/lf_helper.hpp>
+#endif
+
 namespace derecho {
 
+/** The size of each RDMA write posted during RDMA state transfer; large
+ * objects are sent as a sequence of writes of this size so that no single
+ * write exceeds the provider's maximum message size. */
+constexpr std::size_t rdma_transfer_chunk_size = 1ull << 28;
+
 using lock_guard_t = std::lock_guard<std::mutex>;
 using unique_lock_t = std::unique_lock<std::mutex>;
-using shared_lock_t = std::shared_lock<std::shared_timed_mutex>;
+using shared_lock_t = std::shared_lock<EpochSharedMutex>;
 
 /* Leader/Restart Leader Constructor */
 ViewManager::ViewManager(
@@ -116,11 +131,20 @@ ViewManager::ViewManager(
 
 ViewManager::~ViewManager() {
     thread_shutdown = true;
+    if(transport_failure_handler_registered) {
+        TransportContext::get().deregister_failure_handler(transport_failure_handler_id);
+    }
     // force accept to return.
     tcp::socket s{"localhost", getConfUInt16(CONF_DERECHO_GMS_PORT)};
     if(client_listener_thread.joinable()) {
         client_listener_thread.join();
     }
+    unhandshaken_joins_cv.notify_all();
+    for(std::thread& join_handler : join_handler_threads) {
+        if(join_handler.joinable()) {
+            join_handler.join();
+        }
+    }
     old_views_cv.notify_all();
     if(old_view_cleanup_thread.joinable()) {
         old_view_cleanup_thread.join();
@@ -386,7 +410,9 @@ void ViewManager::send_logs() {
                 //Send object data to all shard members, since they will all be in receive_objects()
                 for(node_id_t shard_member : restart_view.subgroup_shard_views[subgroup_id][shard].members) {
                     if(shard_member != my_id) {
-                        send_subgroup_object(subgroup_id, shard_member);
+                        //During a total restart every node is still in its constructor,
+                        //before RDMA initialization, so always transfer over TCP
+                        send_subgroup_object(subgroup_id, shard_member, false);
                     }
                 }
             }
@@ -602,23 +628,23 @@ void ViewManager::leader_commit_initial_view() {
 }
 
 void ViewManager::initialize_rdmc_sst() {
-    dbg_default_debug("Starting global initialization of RDMC and SST, including internal TCP connection setup");
+    dbg_default_debug("Attaching to the shared RDMA transport context");
     // construct member_ips
     auto member_ips_and_rdmc_ports_map = make_member_ips_and_ports_map<PORT_TYPE::RDMC>(*curr_view);
-    if(!rdmc::initialize(member_ips_and_rdmc_ports_map,
-                         curr_view->members[curr_view->my_rank])) {
+    auto member_ips_and_sst_ports_map = make_member_ips_and_ports_map<PORT_TYPE::SST>(*curr_view);
+    if(!TransportContext::get().attach(member_ips_and_rdmc_ports_map,
+                                       member_ips_and_sst_ports_map,
+                                       curr_view->members[curr_view->my_rank])) {
         std::cout << "Global setup failed" << std::endl;
         exit(0);
     }
-    auto member_ips_and_sst_ports_map = make_member_ips_and_ports_map<PORT_TYPE::SST>(*curr_view);
-
-#ifdef USE_VERBS_API
-    sst::verbs_initialize(member_ips_and_sst_ports_map,
-                          curr_view->members[curr_view->my_rank]);
-#else
-    sst::lf_initialize(member_ips_and_sst_ports_map,
-                       curr_view->members[curr_view->my_rank]);
-#endif
+    //The handler only queues the evidence: it may run on the completion
+    //engine's polling thread, where report_failure's SST put would deadlock
+    transport_failure_handler_id = TransportContext::get().register_failure_handler(
+            [this](node_id_t failed_node) {
+                transport_suspicions.locked().access.push_back(failed_node);
+            });
+    transport_failure_handler_registered = true;
 }
 
 void ViewManager::create_threads() {
@@ -627,10 +653,19 @@ void ViewManager::create_threads() {
         while(!thread_shutdown) {
             tcp::socket client_socket = server_socket.accept();
             dbg_default_debug("Background thread got a client connection from {}", client_socket.get_remote_ip());
-            pending_join_sockets.locked().access.emplace_back(std::move(client_socket));
+            {
+                std::lock_guard<std::mutex> queue_lock(unhandshaken_joins_mutex);
+                unhandshaken_join_sockets.emplace_back(std::move(client_socket));
+            }
+            unhandshaken_joins_cv.notify_one();
         }
     }};
 
+    const uint32_t num_join_handlers = std::max(1u, getConfUInt32(CONF_DERECHO_JOIN_HANDLER_THREADS));
+    for(uint32_t i = 0; i < num_join_handlers; ++i) {
+        join_handler_threads.emplace_back([this]() { join_handshake_worker(); });
+    }
+
     old_view_cleanup_thread = std::thread([this]() {
         pthread_setname_np(pthread_self(), "old_view");
         while(!thread_shutdown) {
@@ -646,6 +681,77 @@ void ViewManager::create_threads() {
     });
 }
 
+void ViewManager::join_handshake_worker() {
+    pthread_setname_np(pthread_self(), "join_handler");
+    while(!thread_shutdown) {
+        tcp::socket client_socket;
+        {
+            std::unique_lock<std::mutex> queue_lock(unhandshaken_joins_mutex);
+            unhandshaken_joins_cv.wait(queue_lock, [this]() {
+                return !unhandshaken_join_sockets.empty() || thread_shutdown;
+            });
+            if(thread_shutdown) {
+                break;
+            }
+            client_socket = std::move(unhandshaken_join_sockets.front());
+            unhandshaken_join_sockets.pop_front();
+        }
+        perform_join_handshake(std::move(client_socket));
+    }
+}
+
+void ViewManager::perform_join_handshake(tcp::socket client_socket) {
+    //Exchange version codes; close the socket if the client has an incompatible version
+    uint64_t joiner_version_code;
+    client_socket.exchange(my_version_hashcode, joiner_version_code);
+    if(joiner_version_code != my_version_hashcode) {
+        rls_default_warn("Rejected a connection from client at {}. Client was running on an incompatible platform or used an incompatible compiler.",
+                         client_socket.get_remote_ip());
+        return;
+    }
+    node_id_t joining_client_id = 0;
+    client_socket.read(joining_client_id);
+    if(!active_leader) {
+        //Redirect the client to the current leader
+        shared_lock_t view_lock(view_mutex);
+        client_socket.write(JoinResponse{JoinResponseCode::LEADER_REDIRECT,
+                                         curr_view->members[curr_view->my_rank]});
+        const int rank_of_leader = curr_view->find_rank_of_leader();
+        client_socket.write(mutils::bytes_size(std::get<0>(
+                curr_view->member_ips_and_ports[rank_of_leader])));
+        auto bind_socket_write = [&client_socket](const char* bytes, std::size_t size) {
+            client_socket.write(bytes, size);
+        };
+        mutils::post_object(bind_socket_write,
+                            std::get<0>(curr_view->member_ips_and_ports[rank_of_leader]));
+        client_socket.write(std::get<PORT_TYPE::GMS>(
+                curr_view->member_ips_and_ports[rank_of_leader]));
+        return;
+    }
+    {
+        shared_lock_t view_lock(view_mutex);
+        const node_id_t my_id = curr_view->members[curr_view->my_rank];
+        if(curr_view->rank_of(joining_client_id) != -1) {
+            dbg_default_warn("Joining node at IP {} announced it has ID {}, which is already in the View!",
+                             client_socket.get_remote_ip(), joining_client_id);
+            client_socket.write(JoinResponse{JoinResponseCode::ID_IN_USE, my_id});
+            return;
+        }
+        client_socket.write(JoinResponse{JoinResponseCode::OK, my_id});
+    }
+    struct in_addr joiner_ip_packed;
+    inet_aton(client_socket.get_remote_ip().c_str(), &joiner_ip_packed);
+    PendingJoinRequest join_request;
+    join_request.joiner_id = joining_client_id;
+    join_request.joiner_ip_packed = joiner_ip_packed.s_addr;
+    client_socket.read(join_request.gms_port);
+    client_socket.read(join_request.rpc_port);
+    client_socket.read(join_request.sst_port);
+    client_socket.read(join_request.rdmc_port);
+    join_request.socket = std::move(client_socket);
+    pending_join_requests.locked().access.emplace_back(std::move(join_request));
+}
+
 void ViewManager::register_predicates() {
     /* Note that each trigger function must be wrapped in a lambda because it's
      * a member function, and lambdas are the only way to bind "this" to a member
@@ -659,16 +765,16 @@ void ViewManager::register_predicates() {
     };
     auto new_suspicion_trig = [this](DerechoSST& sst) { new_suspicion(sst); };
 
+    auto transport_suspicion_pred = [this](const DerechoSST& sst) {
+        return transport_suspicions.locked().access.size() > 0;
+    };
+    auto transport_suspicion_trig = [this](DerechoSST& sst) { process_transport_suspicions(); };
+
     auto start_join_pred = [this](const DerechoSST& sst) {
         return active_leader && has_pending_join();
     };
     auto propose_changes_trig = [this](DerechoSST& sst) { propose_changes(sst); };
 
-    auto reject_join_pred = [this](const DerechoSST& sst) {
-        return !active_leader && has_pending_join();
-    };
-    auto reject_join = [this](DerechoSST& sst) { redirect_join_attempt(sst); };
-
     auto change_commit_ready = [this](const DerechoSST& gmsSST) {
         return active_leader
                && min_acked(gmsSST, curr_view->failed) > gmsSST.num_committed[curr_view->my_rank];
@@ -710,14 +816,15 @@ void ViewManager::register_predicates() {
         follower_suspicion_handle = curr_view->gmsSST->predicates.insert(
                 nonleader_suspected_changed, new_suspicion_trig, sst::PredicateType::RECURRENT);
     }
+    if(!transport_suspicion_handle.is_valid()) {
+        transport_suspicion_handle = curr_view->gmsSST->predicates.insert(
+                transport_suspicion_pred, transport_suspicion_trig,
+                sst::PredicateType::RECURRENT);
+    }
     if(!start_join_handle.is_valid()) {
         start_join_handle = curr_view->gmsSST->predicates.insert(
                 start_join_pred, propose_changes_trig, sst::PredicateType::RECURRENT);
     }
-    if(!reject_join_handle.is_valid()) {
-        reject_join_handle = curr_view->gmsSST->predicates.insert(reject_join_pred, reject_join,
-                                                                  sst::PredicateType::RECURRENT);
-    }
     if(!change_commit_ready_handle.is_valid()) {
         change_commit_ready_handle = curr_view->gmsSST->predicates.insert(
                 change_commit_ready, commit_change, sst::PredicateType::RECURRENT);
@@ -732,6 +839,38 @@ void ViewManager::register_predicates() {
                 leader_committed_changes, view_change_trig,
                 sst::PredicateType::ONE_TIME);
     }
+
+    /* With lazy member p2p connections, the first send from another member
+     * raises a bit in its row asking this node to build its side of the
+     * connection; this predicate notices the bit and hands the requester's ID
+     * to RPCManager. The handled flags make the recurrent predicate fire once
+     * per requester, since the bit stays set for the rest of the view. */
+    if(getConfBoolean(CONF_DERECHO_LAZY_MEMBER_P2P) && p2p_connect_upcall) {
+        p2p_connect_handled.assign(curr_view->num_members, false);
+        auto p2p_connect_requested = [this](const DerechoSST& sst) {
+            for(int rank = 0; rank < curr_view->num_members; ++rank) {
+                if(rank != curr_view->my_rank && !p2p_connect_handled[rank]
+                   && sst.p2p_connect_request[rank][curr_view->my_rank]) {
+                    return true;
+                }
+            }
+            return false;
+        };
+        auto p2p_connect_trig = [this](DerechoSST& sst) {
+            for(int rank = 0; rank < curr_view->num_members; ++rank) {
+                if(rank != curr_view->my_rank && !p2p_connect_handled[rank]
+                   && sst.p2p_connect_request[rank][curr_view->my_rank]) {
+                    p2p_connect_handled[rank] = true;
+                    p2p_connect_upcall(curr_view->members[rank]);
+                }
+            }
+        };
+        if(!p2p_connect_handle.is_valid()) {
+            p2p_connect_handle = curr_view->gmsSST->predicates.insert(
+                    p2p_connect_requested, p2p_connect_trig,
+                    sst::PredicateType::RECURRENT);
+        }
+    }
 }
 
 /* ------------- 2. Predicate-Triggers That Implement View Management Logic ---------- */
@@ -743,6 +882,9 @@ void ViewManager::new_suspicion(DerechoSST& gmsSST) {
     }
 
     dbg_default_debug("Suspected[] changed");
+    if(current_view_change_timing.change_start_time == 0) {
+        current_view_change_timing.change_start_time = get_time();
+    }
     const int my_rank = curr_view->my_rank;
     //Cache this before changing failed[], so we can see if the leader changed
     const int old_leader_rank = curr_view->find_rank_of_leader();
@@ -763,7 +905,30 @@ void ViewManager::new_suspicion(DerechoSST& gmsSST) {
     }
 }
 
+void ViewManager::process_transport_suspicions() {
+    std::list<node_id_t> suspicions;
+    {
+        auto locked_queue = transport_suspicions.locked();
+        suspicions.swap(locked_queue.access);
+    }
+    for(const node_id_t who : suspicions) {
+        const int failed_rank = curr_view->rank_of(who);
+        //The evidence may be stale (the node already left or is already
+        //suspected), and connections to non-members can fail without any
+        //membership consequences
+        if(failed_rank == -1 || curr_view->failed[failed_rank]
+           || curr_view->gmsSST->suspected[curr_view->my_rank][failed_rank]) {
+            continue;
+        }
+        dbg_default_warn("Transport layer reported hard failure evidence for node {}; suspecting it without waiting for a heartbeat timeout", who);
+        report_failure(who);
+    }
+}
+
 void ViewManager::propose_changes(DerechoSST& gmsSST) {
+    if(current_view_change_timing.change_start_time == 0) {
+        current_view_change_timing.change_start_time = get_time();
+    }
     const int my_rank = curr_view->my_rank;
     bool done_with_joins = !has_pending_join();
     while(!done_with_joins || suspected_not_equal(gmsSST, last_suspected)) {
@@ -799,15 +964,17 @@ void ViewManager::propose_changes(DerechoSST& gmsSST) {
                 done_with_joins = true;
                 continue;
             }
-            {  //Lock scope for pending_join_sockets
-                auto pending_join_sockets_locked = pending_join_sockets.locked();
-                proposed_join_sockets.splice(proposed_join_sockets.end(),
-                                             pending_join_sockets_locked.access,
-                                             pending_join_sockets_locked.access.begin());
+            PendingJoinRequest join_request;
+            {  //Lock scope for pending_join_requests
+                auto pending_join_requests_locked = pending_join_requests.locked();
+                join_request = std::move(pending_join_requests_locked.access.front());
+                pending_join_requests_locked.access.pop_front();
+            }
+            if(receive_join(gmsSST, join_request)) {
+                //Save the socket for sending the new View once the join commits
+                proposed_join_sockets.emplace_back(std::move(join_request.socket));
             }
-            bool success = receive_join(gmsSST, proposed_join_sockets.back());
-            //If the join failed, close the socket
-            if(!success) proposed_join_sockets.pop_back();
+            //If the join failed, dropping the request closes the socket
 
             done_with_joins = !has_pending_join();
         }
@@ -825,7 +992,7 @@ void ViewManager::propose_changes(DerechoSST& gmsSST) {
     dbg_default_debug("Checking provisioning of view {}", next_view->vid);
     make_subgroup_maps(subgroup_info, curr_view, *next_view);
     if(!next_view->is_adequately_provisioned) {
-        //Don't push the proposed changes yet; the view will stay wedged but view-change won't start
+        //Don't push the proposed changes yet; the view keeps running but view-change won't start
         dbg_default_debug("Next view would not be adequately provisioned, waiting for more joins.");
         gmssst::set(gmsSST.changes[my_rank][last_change_index].end_of_view, false);
     } else {
@@ -839,39 +1006,6 @@ void ViewManager::propose_changes(DerechoSST& gmsSST) {
     }
 }
 
-void ViewManager::redirect_join_attempt(DerechoSST& gmsSST) {
-    tcp::socket client_socket;
-    {
-        auto pending_join_sockets_locked = pending_join_sockets.locked();
-        client_socket = std::move(pending_join_sockets_locked.access.front());
-        pending_join_sockets_locked.access.pop_front();
-    }
-    //Exchange version codes; close the socket if the client has an incompatible version
-    uint64_t joiner_version_code;
-    client_socket.exchange(my_version_hashcode, joiner_version_code);
-    if(joiner_version_code != my_version_hashcode) {
-        rls_default_warn("Rejected a connection from client at {}. Client was running on an incompatible platform or used an incompatible compiler.",
-                         client_socket.get_remote_ip());
-        return;
-    }
-    //Read the client's ID, but ignore it, since the leader will check it again anyway
-    node_id_t joiner_id;
-    client_socket.read(joiner_id);
-    client_socket.write(JoinResponse{JoinResponseCode::LEADER_REDIRECT,
-                                     curr_view->members[curr_view->my_rank]});
-    //Send the client the IP address of the current leader
-    const int rank_of_leader = curr_view->find_rank_of_leader();
-    client_socket.write(mutils::bytes_size(std::get<0>(
-            curr_view->member_ips_and_ports[rank_of_leader])));
-    auto bind_socket_write = [&client_socket](const char* bytes, std::size_t size) {
-        client_socket.write(bytes, size);
-    };
-    mutils::post_object(bind_socket_write,
-                        std::get<0>(curr_view->member_ips_and_ports[rank_of_leader]));
-    client_socket.write(std::get<PORT_TYPE::GMS>(
-            curr_view->member_ips_and_ports[rank_of_leader]));
-}
-
 void ViewManager::new_leader_takeover(DerechoSST& gmsSST) {
     bool prior_changes_found = copy_prior_leader_proposals(gmsSST);
     dbg_default_debug("Taking over as the new leader; everyone suspects prior leaders.");
@@ -985,17 +1119,32 @@ void ViewManager::acknowledge_proposed_change(DerechoSST& gmsSST) {
         gmsSST.put(gmsSST.num_committed);
     }
     gmsSST.put(gmsSST.num_acked);
-    dbg_default_debug("Wedging current view.");
-    curr_view->wedge();
-    dbg_default_debug("Done wedging current view.");
+    /* Wedge only the shards affected by the proposed changes: a departing
+     * member stalls its own shards anyway, and a join does not touch any
+     * existing shard's traffic. The full wedge is deferred until the leader
+     * commits the change and start_meta_wedge runs, so unaffected subgroups
+     * keep delivering through the proposal and acknowledgment rounds. */
+    std::vector<node_id_t> departing_members;
+    for(int change_index = 0;
+        change_index < gmsSST.num_changes[myRank] - gmsSST.num_installed[myRank];
+        ++change_index) {
+        const node_id_t change_id = gmsSST.changes[myRank][change_index].change_id;
+        if(curr_view->rank_of(change_id) != -1) {
+            departing_members.emplace_back(change_id);
+        }
+    }
+    dbg_default_debug("Wedging the shards affected by the proposed changes.");
+    curr_view->multicast_group->wedge_subgroups_containing(departing_members);
 }
 
 void ViewManager::start_meta_wedge(DerechoSST& gmsSST) {
     dbg_default_debug("Meta-wedging view {}", curr_view->vid);
+    if(current_view_change_timing.wedge_time == 0) {
+        current_view_change_timing.wedge_time = get_time();
+    }
     // Disable all the other SST predicates, except suspected_changed and the
     // one I'm about to register
     gmsSST.predicates.remove(start_join_handle);
-    gmsSST.predicates.remove(reject_join_handle);
     gmsSST.predicates.remove(change_commit_ready_handle);
     gmsSST.predicates.remove(leader_proposed_handle);
 
@@ -1160,8 +1309,11 @@ void ViewManager::echo_ragged_trim(
         deliver_ragged_trim(gmsSST);
     };
 
+    // ragged-trim delivery is view-change housekeeping; keep it out of the
+    // latency-critical evaluation path
     gmsSST.predicates.insert(everyone_echoed_pred, deliver_ragged_trim_trig,
-                             sst::PredicateType::ONE_TIME);
+                             sst::PredicateType::ONE_TIME, -1,
+                             sst::PredicatePriority::BACKGROUND);
 }
 
 void ViewManager::deliver_ragged_trim(DerechoSST& gmsSST) {
@@ -1217,42 +1369,122 @@ void ViewManager::deliver_ragged_trim(DerechoSST& gmsSST) {
     };
 
     gmsSST.predicates.insert(persistence_finished_pred, finish_view_change_trig,
-                             sst::PredicateType::ONE_TIME);
+                             sst::PredicateType::ONE_TIME, -1,
+                             sst::PredicatePriority::BACKGROUND);
 }
 
 void ViewManager::finish_view_change(DerechoSST& gmsSST) {
     dbg_default_debug("Ragged trim messages are persisted, finishing view change");
-    std::unique_lock<std::shared_timed_mutex> write_lock(view_mutex);
+    if(current_view_change_timing.ragged_trim_time == 0) {
+        current_view_change_timing.ragged_trim_time = get_time();
+    }
+    std::unique_lock<EpochSharedMutex> write_lock(view_mutex);
 
     // Disable all the other SST predicates, except suspected_changed
     gmsSST.predicates.remove(start_join_handle);
-    gmsSST.predicates.remove(reject_join_handle);
     gmsSST.predicates.remove(change_commit_ready_handle);
     gmsSST.predicates.remove(leader_proposed_handle);
 
     const node_id_t my_id = curr_view->members[curr_view->my_rank];
 
-    //Send the new view from the leader to non-leaders in the old view using the TCP sockets
+    //Send the new view from the leader to non-leaders in the old view. When
+    //the serialized view (or delta) fits in the SST's view_delta_buffer it is
+    //disseminated with one RDMA push to every standing member; the per-member
+    //TCP sends remain only as the fallback for oversized views.
+    const bool use_delta_views = getConfBoolean(CONF_DERECHO_DELTA_VIEWS);
     if(active_leader) {
-        for(int i = 0; i < curr_view->num_members; ++i) {
-            if(i != curr_view->my_rank && !curr_view->failed[i]) {
-                LockedReference<std::unique_lock<std::mutex>, tcp::socket> member_socket
-                        = tcp_sockets->get_socket(curr_view->members[i]);
-                send_view(*next_view, member_socket.get());
+        const int my_rank = curr_view->my_rank;
+        std::unique_ptr<ViewDelta> view_delta;
+        std::size_t send_size;
+        if(use_delta_views) {
+            //Standing members have curr_view, so they only need the changes
+            view_delta = std::make_unique<ViewDelta>(*next_view);
+            send_size = mutils::bytes_size(*view_delta);
+        } else {
+            send_size = mutils::bytes_size(*next_view);
+        }
+        if(send_size <= gmsSST.view_delta_buffer.size()) {
+            dbg_default_debug("Disseminating the new view ({} bytes) through the SST", send_size);
+            if(use_delta_views) {
+                mutils::to_bytes(*view_delta, const_cast<char*>(gmsSST.view_delta_buffer[my_rank]));
+            } else {
+                mutils::to_bytes(*next_view, const_cast<char*>(gmsSST.view_delta_buffer[my_rank]));
+            }
+            gmsSST.view_delta_size[my_rank] = send_size;
+            gmsSST.view_delta_vid[my_rank] = next_view->vid;
+            //Push the buffer before the header: RDMA writes on each
+            //connection are applied in order, so a member that sees the new
+            //VID in the header can safely read the buffer
+            gmsSST.put(gmsSST.view_delta_buffer.get_base() - gmsSST.getBaseAddress(), send_size);
+            gmsSST.put(gmsSST.view_delta_size.get_base() - gmsSST.getBaseAddress(),
+                       sizeof(gmsSST.view_delta_size[0]) + sizeof(gmsSST.view_delta_vid[0]));
+        } else {
+            //Announce the TCP fallback through the header, then send as before
+            gmsSST.view_delta_size[my_rank] = 0;
+            gmsSST.view_delta_vid[my_rank] = next_view->vid;
+            gmsSST.put(gmsSST.view_delta_size.get_base() - gmsSST.getBaseAddress(),
+                       sizeof(gmsSST.view_delta_size[0]) + sizeof(gmsSST.view_delta_vid[0]));
+            for(int i = 0; i < curr_view->num_members; ++i) {
+                if(i != curr_view->my_rank && !curr_view->failed[i]) {
+                    LockedReference<std::unique_lock<std::mutex>, tcp::socket> member_socket
+                            = tcp_sockets->get_socket(curr_view->members[i]);
+                    if(use_delta_views) {
+                        send_view_delta(*next_view, member_socket.get());
+                    } else {
+                        send_view(*next_view, member_socket.get());
+                    }
+                }
             }
         }
     } else {
-        //Standard procedure for receiving a View, copied from receive_view_and_leaders
-        const node_id_t leader_id = curr_view->members[curr_view->find_rank_of_leader()];
-        std::size_t size_of_view;
-        bool success = tcp_sockets->read(leader_id, reinterpret_cast<char*>(&size_of_view), sizeof(size_of_view));
-        assert(success);
-        char buffer[size_of_view];
-        success = tcp_sockets->read(leader_id, buffer, size_of_view);
-        assert(success);
-        next_view = mutils::from_bytes<View>(nullptr, buffer);
-        next_view->subgroup_type_order = subgroup_type_order;
-        next_view->my_rank = next_view->rank_of(my_id);
+        const int leader_rank = curr_view->find_rank_of_leader();
+        const node_id_t leader_id = curr_view->members[leader_rank];
+        const int32_t next_vid = curr_view->vid + 1;
+        //Wait for the leader to publish the next view's header; this replaces
+        //the blocking TCP read that used to wait here
+        while(gmsSST.view_delta_vid[leader_rank] != next_vid
+              && !gmsSST.suspected[curr_view->my_rank][leader_rank]) {
+        }
+        assert(gmsSST.view_delta_vid[leader_rank] == next_vid);
+        const uint64_t size_in_sst = gmsSST.view_delta_size[leader_rank];
+        if(use_delta_views) {
+            std::unique_ptr<ViewDelta> view_delta;
+            if(size_in_sst > 0) {
+                view_delta = mutils::from_bytes<ViewDelta>(
+                        nullptr, const_cast<char*>(gmsSST.view_delta_buffer[leader_rank]));
+            } else {
+                //TCP fallback for a delta larger than the SST buffer
+                std::size_t size_of_delta;
+                bool success = tcp_sockets->read(leader_id, reinterpret_cast<char*>(&size_of_delta), sizeof(size_of_delta));
+                assert(success);
+                char buffer[size_of_delta];
+                success = tcp_sockets->read(leader_id, buffer, size_of_delta);
+                assert(success);
+                view_delta = mutils::from_bytes<ViewDelta>(nullptr, buffer);
+            }
+            next_view = view_delta->make_next_view(*curr_view, subgroup_type_order);
+            /* Rebuild the subgroup layouts locally instead of receiving them; the
+             * membership functions are deterministic, so this produces the same
+             * layouts the leader computed */
+            make_subgroup_maps(subgroup_info, curr_view, *next_view);
+            next_view->my_rank = next_view->rank_of(my_id);
+        } else {
+            if(size_in_sst > 0) {
+                next_view = mutils::from_bytes<View>(
+                        nullptr, const_cast<char*>(gmsSST.view_delta_buffer[leader_rank]));
+            } else {
+                //Standard procedure for receiving a View, copied from receive_view_and_leaders
+                std::size_t size_of_view;
+                bool success = tcp_sockets->read(leader_id, reinterpret_cast<char*>(&size_of_view), sizeof(size_of_view));
+                assert(success);
+                char buffer[size_of_view];
+                success = tcp_sockets->read(leader_id, buffer, size_of_view);
+                assert(success);
+                next_view = mutils::from_bytes<View>(nullptr, buffer);
+            }
+            next_view->subgroup_type_order = subgroup_type_order;
+            next_view->my_rank = next_view->rank_of(my_id);
+        }
     }
 
     std::map<subgroup_id_t, SubgroupSettings> next_subgroup_settings;
@@ -1269,19 +1501,28 @@ void ViewManager::finish_view_change(DerechoSST& gmsSST) {
     if(active_leader && next_view->joined.size() > 0) {
         // If j joins have been committed, pop the next j sockets off
         // proposed_join_sockets and send them the new View and old shard
-        // leaders list
+        // leaders list, in parallel so one slow joiner doesn't delay the rest
         for(std::size_t c = 0; c < next_view->joined.size(); ++c) {
-            send_view(*next_view, proposed_join_sockets.front());
-            std::size_t size_of_vector = mutils::bytes_size(old_shard_leaders_by_id);
-            proposed_join_sockets.front().write(size_of_vector);
-            mutils::post_object([this](const char* bytes, std::size_t size) {
-                proposed_join_sockets.front().write(bytes, size);
-            },
-                                old_shard_leaders_by_id);
             // save the socket for the commit step
             joiner_sockets.emplace_back(std::move(proposed_join_sockets.front()));
             proposed_join_sockets.pop_front();
         }
+        const std::size_t size_of_vector = mutils::bytes_size(old_shard_leaders_by_id);
+        std::vector<std::thread> view_senders;
+        for(tcp::socket& joiner_socket : joiner_sockets) {
+            tcp::socket* const socket_ptr = &joiner_socket;
+            view_senders.emplace_back([this, socket_ptr, size_of_vector, &old_shard_leaders_by_id]() {
+                send_view(*next_view, *socket_ptr);
+                socket_ptr->write(size_of_vector);
+                mutils::post_object([socket_ptr](const char* bytes, std::size_t size) {
+                    socket_ptr->write(bytes, size);
+                },
+                                    old_shard_leaders_by_id);
+            });
+        }
+        for(std::thread& sender_thread : view_senders) {
+            sender_thread.join();
+        }
     }
 
     // Set up TCP connections to the joined nodes
@@ -1306,46 +1547,32 @@ void ViewManager::finish_view_change(DerechoSST& gmsSST) {
         joiner_sockets.clear();
     }
 
-    // Delete the last three GMS predicates from the old SST in preparation for deleting it
+    // Delete the last GMS predicates from the old SST in preparation for deleting it
     gmsSST.predicates.remove(leader_committed_handle);
     gmsSST.predicates.remove(leader_suspicion_handle);
     gmsSST.predicates.remove(follower_suspicion_handle);
+    gmsSST.predicates.remove(p2p_connect_handle);
 
     dbg_default_debug("Starting creation of new SST and DerechoGroup for view {}", next_view->vid);
     for(const node_id_t failed_node_id : next_view->departed) {
         dbg_default_debug("Removing global TCP connections for failed node {} from RDMC and SST", failed_node_id);
-#ifdef USE_VERBS_API
-        rdma::impl::verbs_remove_connection(failed_node_id);
-#else
-        rdma::impl::lf_remove_connection(failed_node_id);
-#endif
-        sst::remove_node(failed_node_id);
+        TransportContext::get().remove_node(failed_node_id);
     }
     // if new members have joined, add their RDMA connections to SST and RDMC
     for(std::size_t i = 0; i < next_view->joined.size(); ++i) {
         // The new members will be the last joined.size() elements of the members lists
         int joiner_rank = next_view->num_members - next_view->joined.size() + i;
         dbg_default_debug("Adding RDMC connection to node {}, at IP {} and port {}", next_view->members[joiner_rank], std::get<0>(next_view->member_ips_and_ports[joiner_rank]), std::get<PORT_TYPE::RDMC>(next_view->member_ips_and_ports[joiner_rank]));
-
-#ifdef USE_VERBS_API
-        rdma::impl::verbs_add_connection(next_view->members[joiner_rank],
-                                         next_view->member_ips_and_ports[joiner_rank], my_id);
-#else
-        rdma::impl::lf_add_connection(
+        TransportContext::get().add_node(
                 next_view->members[joiner_rank],
                 std::pair<ip_addr_t, uint16_t>{
                         std::get<0>(next_view->member_ips_and_ports[joiner_rank]),
                         std::get<PORT_TYPE::RDMC>(
+                                next_view->member_ips_and_ports[joiner_rank])},
+                std::pair<ip_addr_t, uint16_t>{
+                        std::get<0>(next_view->member_ips_and_ports[joiner_rank]),
+                        std::get<PORT_TYPE::SST>(
                                 next_view->member_ips_and_ports[joiner_rank])});
-#endif
-    }
-    for(std::size_t i = 0; i < next_view->joined.size(); ++i) {
-        int joiner_rank = next_view->num_members - next_view->joined.size() + i;
-        sst::add_node(next_view->members[joiner_rank],
-                      std::pair<ip_addr_t, uint16_t>{
-                              std::get<0>(next_view->member_ips_and_ports[joiner_rank]),
-                              std::get<PORT_TYPE::SST>(
-                                      next_view->member_ips_and_ports[joiner_rank])});
     }
 
     // This will block until everyone responds to SST/RDMC initial handshakes
@@ -1385,11 +1612,26 @@ void ViewManager::finish_view_change(DerechoSST& gmsSST) {
         view_upcall(*curr_view);
     }
 
+    // Record this change's completed timing milestones and reset for the next
+    current_view_change_timing.install_time = get_time();
+    current_view_change_timing.new_vid = curr_view->vid;
+    current_view_change_timing.old_vid = curr_view->vid - 1;
+    {
+        std::lock_guard<std::mutex> timing_lock(view_change_timing_mutex);
+        view_change_timings.push_back(current_view_change_timing);
+    }
+    current_view_change_timing = ViewChangeTiming{};
+
     curr_view->gmsSST->start_predicate_evaluation();
     view_change_cv.notify_all();
     dbg_default_debug("Done with view change to view {}", curr_view->vid);
 }
 
+std::vector<ViewChangeTiming> ViewManager::get_view_change_timings() {
+    std::lock_guard<std::mutex> timing_lock(view_change_timing_mutex);
+    return view_change_timings;
+}
+
 /* ------------- 3. Helper Functions for Predicates and Triggers ------------- */
 
 void ViewManager::construct_multicast_group(CallbackSet callbacks,
@@ -1408,7 +1650,7 @@ void ViewManager::construct_multicast_group(CallbackSet callbacks,
     curr_view->multicast_group = std::make_unique<MulticastGroup>(
             curr_view->members, curr_view->members[curr_view->my_rank],
             curr_view->gmsSST, callbacks, num_subgroups, subgroup_settings,
-            getConfUInt32(CONF_DERECHO_HEARTBEAT_MS),
+            getConfSnapshot().heartbeat_ms,
             [this](const subgroup_id_t& subgroup_id, const persistent::version_t& ver, const uint64_t& msg_ts) {
                 assert(subgroup_objects.find(subgroup_id) != subgroup_objects.end());
                 subgroup_objects.at(subgroup_id).get().post_next_version(ver, msg_ts);
@@ -1445,40 +1687,21 @@ void ViewManager::transition_multicast_group(
     next_view->gmsSST->init_local_row_from_previous(
             (*curr_view->gmsSST), curr_view->my_rank, changes_installed);
     gmssst::set(next_view->gmsSST->vid[next_view->my_rank], next_view->vid);
+    next_view->gmsSST->increment_perf_counter(PerfCounter::VIEW_CHANGES);
 }
 
-bool ViewManager::receive_join(DerechoSST& gmsSST, tcp::socket& client_socket) {
-    struct in_addr joiner_ip_packed;
-    inet_aton(client_socket.get_remote_ip().c_str(), &joiner_ip_packed);
-
-    uint64_t joiner_version_code;
-    client_socket.exchange(my_version_hashcode, joiner_version_code);
-    if(joiner_version_code != my_version_hashcode) {
-        rls_default_warn("Rejected a connection from client at {}. Client was running on an incompatible platform or used an incompatible compiler.",
-                         client_socket.get_remote_ip());
-        return false;
-    }
+bool ViewManager::receive_join(DerechoSST& gmsSST, PendingJoinRequest& join_request) {
     const node_id_t my_id = curr_view->members[curr_view->my_rank];
-    node_id_t joining_client_id = 0;
-    client_socket.read(joining_client_id);
-
-    if(curr_view->rank_of(joining_client_id) != -1) {
-        dbg_default_warn("Joining node at IP {} announced it has ID {}, which is already in the View!", client_socket.get_remote_ip(), joining_client_id);
-        client_socket.write(JoinResponse{JoinResponseCode::ID_IN_USE, my_id});
+    //The handshake thread checked the ID against the View it saw, but another
+    //join with the same ID may have been proposed since then
+    if(curr_view->rank_of(join_request.joiner_id) != -1
+       || changes_contains(gmsSST, join_request.joiner_id)) {
+        dbg_default_warn("Joining node with ID {} conflicts with a node already in the View or a pending change!",
+                         join_request.joiner_id);
         return false;
     }
-    client_socket.write(JoinResponse{JoinResponseCode::OK, my_id});
-
-    uint16_t joiner_gms_port = 0;
-    client_socket.read(joiner_gms_port);
-    uint16_t joiner_rpc_port = 0;
-    client_socket.read(joiner_rpc_port);
-    uint16_t joiner_sst_port = 0;
-    client_socket.read(joiner_sst_port);
-    uint16_t joiner_rdmc_port = 0;
-    client_socket.read(joiner_rdmc_port);
 
-    dbg_default_debug("Proposing change to add node {}", joining_client_id);
+    dbg_default_debug("Proposing change to add node {}", join_request.joiner_id);
     size_t next_change_index = gmsSST.num_changes[curr_view->my_rank]
                                - gmsSST.num_installed[curr_view->my_rank];
     if(next_change_index == gmsSST.changes.size()) {
@@ -1488,25 +1711,23 @@ bool ViewManager::receive_join(DerechoSST& gmsSST, tcp::socket& client_socket) {
         throw derecho_exception("Too many changes at once! Processing a join, but ran out of room in the pending changes list.");
     }
     gmssst::set(gmsSST.changes[curr_view->my_rank][next_change_index],
-                make_change_proposal(my_id, joining_client_id));
+                make_change_proposal(my_id, join_request.joiner_id));
     gmssst::set(gmsSST.joiner_ips[curr_view->my_rank][next_change_index],
-                joiner_ip_packed.s_addr);
+                join_request.joiner_ip_packed);
     gmssst::set(gmsSST.joiner_gms_ports[curr_view->my_rank][next_change_index],
-                joiner_gms_port);
+                join_request.gms_port);
     gmssst::set(gmsSST.joiner_rpc_ports[curr_view->my_rank][next_change_index],
-                joiner_rpc_port);
+                join_request.rpc_port);
     gmssst::set(gmsSST.joiner_sst_ports[curr_view->my_rank][next_change_index],
-                joiner_sst_port);
+                join_request.sst_port);
     gmssst::set(gmsSST.joiner_rdmc_ports[curr_view->my_rank][next_change_index],
-                joiner_rdmc_port);
+                join_request.rdmc_port);
 
     gmssst::increment(gmsSST.num_changes[curr_view->my_rank]);
     //Don't actually push the proposed join yet, because we don't know if it's the last change in the batch
 
-    if(!curr_view->is_wedged()) {
-        dbg_default_debug("Wedging view {}", curr_view->vid);
-        curr_view->wedge();
-    }
+    /* A join adds no member to any existing shard, so nothing needs to wedge
+     * yet; the whole view wedges in start_meta_wedge once the change commits. */
     return true;
 }
 
@@ -1543,11 +1764,22 @@ std::vector<int> ViewManager::process_suspicions(DerechoSST& gmsSST) {
                 }
             }
 
-            dbg_default_debug("GMS telling SST to freeze row {}", curr_rank);
-            gmsSST.freeze(curr_rank);
-            //These two lines are the same as Vc.wedge()
-            curr_view->multicast_group->wedge();
-            gmssst::set(gmsSST.wedged[my_rank], true);
+            /* A planned departure (rip set) leaves the node alive and its
+             * connection healthy until the rest of the membership has wedged,
+             * so keep pushing GMS state to it; its row is dropped with this
+             * SST at view install. Freezing is for crashed nodes whose queue
+             * pairs would stall put_with_completion. */
+            if(gmsSST.rip[curr_rank]) {
+                dbg_default_debug("Node {} departed gracefully; not freezing its row", curr_view->members[curr_rank]);
+            } else {
+                dbg_default_debug("GMS telling SST to freeze row {}", curr_rank);
+                gmsSST.freeze(curr_rank);
+            }
+            /* Wedge only the subgroups whose shards contain the failed node;
+             * the rest keep sending and delivering until the view change
+             * commits and start_meta_wedge wedges the whole view. */
+            curr_view->multicast_group->wedge_subgroups_containing(
+                    {curr_view->members[curr_rank]});
             //Synchronize Vc.failed with gmsSST.suspected
             curr_view->failed[curr_rank] = true;
             curr_view->num_failed++;
@@ -1564,8 +1796,6 @@ std::vector<int> ViewManager::process_suspicions(DerechoSST& gmsSST) {
 
             // push change to gmsSST.suspected[myRank]
             gmsSST.put(gmsSST.suspected);
-            // push change to gmsSST.wedged[myRank]
-            gmsSST.put(gmsSST.wedged);
         }
     }
     return failed_ranks;
@@ -1581,6 +1811,17 @@ void ViewManager::send_view(const View& new_view, tcp::socket& client_socket) {
     mutils::post_object(bind_socket_write, new_view);
 }
 
+void ViewManager::send_view_delta(const View& new_view, tcp::socket& client_socket) {
+    dbg_default_debug("Sending node at {} a delta for the new view", client_socket.get_remote_ip());
+    ViewDelta view_delta(new_view);
+    auto bind_socket_write = [&client_socket](const char* bytes, std::size_t size) {
+        client_socket.write(bytes, size);
+    };
+    std::size_t size_of_delta = mutils::bytes_size(view_delta);
+    client_socket.write(size_of_delta);
+    mutils::post_object(bind_socket_write, view_delta);
+}
+
 void ViewManager::send_objects_to_new_members(const View& new_view, const vector_int64_2d& old_shard_leaders) {
     node_id_t my_id = new_view.members[new_view.my_rank];
     for(subgroup_id_t subgroup_id = 0; subgroup_id < old_shard_leaders.size(); ++subgroup_id) {
@@ -1590,7 +1831,13 @@ void ViewManager::send_objects_to_new_members(const View& new_view, const vector
                 //send its object state to the new members
                 for(node_id_t shard_joiner : new_view.subgroup_shard_views[subgroup_id][shard].joined) {
                     if(shard_joiner != my_id) {
-                        send_subgroup_object(subgroup_id, shard_joiner);
+                        //A node newly added to the shard has working RDMA connections
+                        //unless it is also newly added to the group
+                        const bool receiver_has_fabric
+                                = std::find(new_view.joined.begin(), new_view.joined.end(),
+                                            shard_joiner)
+                                  == new_view.joined.end();
+                        send_subgroup_object(subgroup_id, shard_joiner, receiver_has_fabric);
                     }
                 }
             }
@@ -1604,7 +1851,8 @@ void ViewManager::send_objects_to_new_members(const View& new_view, const vector
  * be attempting to send an object to node B at the same time as B is attempting to send a
  * different object to A, and neither node will be able to send the log tail length that
  * the other one is waiting on. */
-void ViewManager::send_subgroup_object(subgroup_id_t subgroup_id, node_id_t new_node_id) {
+void ViewManager::send_subgroup_object(subgroup_id_t subgroup_id, node_id_t new_node_id,
+                                       bool receiver_has_fabric) {
     LockedReference<std::unique_lock<std::mutex>, tcp::socket> joiner_socket = tcp_sockets->get_socket(new_node_id);
     ReplicatedObject& subgroup_object = subgroup_objects.at(subgroup_id);
     if(subgroup_object.is_persistent()) {
@@ -1613,9 +1861,122 @@ void ViewManager::send_subgroup_object(subgroup_id_t subgroup_id, node_id_t new_
         joiner_socket.get().read(persistent_log_length);
         persistent::PersistentRegistry::setEarliestVersionToSerialize(persistent_log_length);
         dbg_default_debug("Got log tail length {}", persistent_log_length);
+        if(getConfBoolean(CONF_DERECHO_STATE_TRANSFER_LOG_SUFFIX)) {
+            /* Log-suffix catch-up: if this node's logs still retain every
+             * version past the rejoiner's log tail, and the missing suffix is
+             * smaller than the full object, send just the suffix and let the
+             * rejoiner merge it into its existing logs. */
+            const std::size_t log_tail_size = subgroup_object.get_log_tail_size(persistent_log_length);
+            const bool tail_is_complete = persistent_log_length != persistent::INVALID_VERSION
+                                          && subgroup_object.get_maximum_earliest_version() <= persistent_log_length;
+            const bool send_suffix = tail_is_complete && log_tail_size < subgroup_object.object_size();
+            joiner_socket.get().write(send_suffix);
+            if(send_suffix) {
+                joiner_socket.get().write(log_tail_size);
+                subgroup_object.send_log_tail(joiner_socket.get(), persistent_log_length);
+                dbg_default_debug("Sent log suffix of size {} for subgroup {} to node {}",
+                                  log_tail_size, subgroup_id, new_node_id);
+                return;
+            }
+        }
+    }
+    if(getConfBoolean(CONF_DERECHO_STATE_TRANSFER_RDMA) && receiver_has_fabric) {
+        /* RDMA transfer: serialize the object into a registered buffer and
+         * write it into a memory region the receiver exposes, finishing with
+         * a flag word one past the payload; RDMA writes on the same connection
+         * are placed in order, so the flag tells the receiver the payload is
+         * complete. The control socket carries the size word, the receiver's
+         * region address and key, and a final acknowledgment that lets this
+         * node know it is safe to tear the connection down. */
+        const std::size_t total_size = subgroup_object.object_size();
+        joiner_socket.get().write(total_size);
+        uint64_t destination_addr = 0;
+        uint64_t destination_key = 0;
+        joiner_socket.get().read(destination_addr);
+        joiner_socket.get().read(destination_key);
+        auto object_buffer = std::make_unique<char[]>(total_size + sizeof(uint64_t));
+        subgroup_object.serialize_object(object_buffer.get());
+        reinterpret_cast<uint64_t&>(object_buffer[total_size]) = 1;
+        rdma::memory_region source_mr(object_buffer.get(), total_size + sizeof(uint64_t));
+#ifdef USE_VERBS_API
+        rdma::remote_memory_region destination_mr(destination_addr, total_size + sizeof(uint64_t),
+                                                  static_cast<uint32_t>(destination_key));
+        rdma::queue_pair transfer_connection(new_node_id);
+#else
+        rdma::remote_memory_region destination_mr(destination_addr, total_size + sizeof(uint64_t),
+                                                  destination_key);
+        rdma::endpoint transfer_connection(new_node_id,
+                                           getConfUInt32(CONF_DERECHO_LOCAL_ID) < new_node_id);
+#endif
+        dbg_default_debug("Sending Replicated Object state for subgroup {} to node {} over RDMA",
+                          subgroup_id, new_node_id);
+        for(std::size_t offset = 0; offset < total_size; offset += rdma_transfer_chunk_size) {
+            const std::size_t chunk_length = std::min(total_size - offset, rdma_transfer_chunk_size);
+            if(!transfer_connection.post_write(source_mr, offset, chunk_length, 0,
+                                               destination_mr, offset,
+                                               rdma::message_type::ignored())) {
+                throw derecho_exception("Failed to post an RDMA write during state transfer");
+            }
+        }
+        //The flag word must be a separate write: bytes within one RDMA write
+        //are not placed in order, but successive writes are
+        if(!transfer_connection.post_write(source_mr, total_size, sizeof(uint64_t), 0,
+                                           destination_mr, total_size,
+                                           rdma::message_type::ignored())) {
+            throw derecho_exception("Failed to post an RDMA write during state transfer");
+        }
+        bool transfer_received = false;
+        joiner_socket.get().read(transfer_received);
+        return;
+    }
+    const uint32_t num_stripes = getConfUInt32(CONF_DERECHO_STATE_TRANSFER_STRIPES);
+    if(num_stripes <= 1) {
+        dbg_default_debug("Sending Replicated Object state for subgroup {} to node {}", subgroup_id, new_node_id);
+        subgroup_object.send_object(joiner_socket.get());
+        return;
+    }
+    /* Striped transfer: serialize the object into a buffer, then send disjoint
+     * ranges of it over num_stripes parallel sockets to a listener on the
+     * receiving node. The receiver sends the listener's port when it is ready
+     * to accept stripes (a blocking read that mirrors the log-tail read above),
+     * and the control socket still carries the size word exactly as in the
+     * single-stream protocol. */
+    uint16_t stripe_port = 0;
+    joiner_socket.get().read(stripe_port);
+    const std::size_t total_size = subgroup_object.object_size();
+    auto object_buffer = std::make_unique<char[]>(total_size);
+    subgroup_object.serialize_object(object_buffer.get());
+    joiner_socket.get().write(total_size);
+    dbg_default_debug("Sending Replicated Object state for subgroup {} to node {} over {} stripes",
+                      subgroup_id, new_node_id, num_stripes);
+    const std::string joiner_ip = joiner_socket.get().get_remote_ip();
+    std::vector<std::thread> stripe_threads;
+    for(uint32_t stripe = 0; stripe < num_stripes; ++stripe) {
+        stripe_threads.emplace_back([&, stripe]() {
+            try {
+                tcp::socket stripe_socket(joiner_ip, stripe_port);
+                stripe_socket.write(subgroup_id);
+                stripe_socket.write(stripe);
+                const auto range = stripe_range(total_size, num_stripes, stripe);
+                stripe_socket.write(object_buffer.get() + range.first, range.second);
+            } catch(tcp::connection_failure&) {
+                dbg_default_error("Failed to connect a stripe socket to node {} on port {}",
+                                  new_node_id, stripe_port);
+            }
+        });
+    }
+    for(auto& stripe_thread : stripe_threads) {
+        stripe_thread.join();
     }
-    dbg_default_debug("Sending Replicated Object state for subgroup {} to node {}", subgroup_id, new_node_id);
-    subgroup_object.send_object(joiner_socket.get());
+}
+
+std::pair<std::size_t, std::size_t> ViewManager::stripe_range(std::size_t total_size,
+                                                              uint32_t num_stripes,
+                                                              uint32_t stripe_index) {
+    const std::size_t stripe_size = (total_size + num_stripes - 1) / num_stripes;
+    const std::size_t offset = std::min(total_size, stripe_index * stripe_size);
+    const std::size_t length = std::min(total_size - offset, stripe_size);
+    return {offset, length};
 }
 
 void ViewManager::update_tcp_connections(const View& new_view) {
@@ -1683,6 +2044,9 @@ void ViewManager::make_subgroup_maps(const SubgroupInfo& subgroup_info,
             uint32_t num_shards = curr_type_subviews[subgroup_index].size();
             for(uint shard_num = 0; shard_num < num_shards; ++shard_num) {
                 SubView& shard_view = curr_type_subviews[subgroup_index][shard_num];
+                //The allocation functions are done, so membership is final
+                //and the shard's node-ID-to-rank index can be built
+                shard_view.build_rank_index();
                 shard_view.my_rank = shard_view.rank_of(curr_view.members[curr_view.my_rank]);
                 if(shard_view.my_rank != -1) {
                     // Initialize my_subgroups
@@ -1741,6 +2105,7 @@ std::pair<uint32_t, uint32_t> ViewManager::derive_subgroup_settings(View& view,
                         (uint32_t)shard_view.my_rank,
                         shard_view.members,
                         shard_view.is_sender,
+                        shard_view.is_standby,
                         shard_view.sender_rank_of(shard_view.my_rank),
                         num_received_offset,
                         slot_offset,
@@ -2199,6 +2564,55 @@ void ViewManager::leave() {
     thread_shutdown = true;
 }
 
+void ViewManager::graceful_leave() {
+    shared_lock_t lock(view_mutex);
+    dbg_default_info("Gracefully leaving the group.");
+    const uint64_t phase_timeout_ms = getConfUInt64(CONF_DERECHO_LEAVE_DRAIN_TIMEOUT_MS);
+    //Phase 1: stop sending and drain in-flight multicasts to a clean cut, so
+    //the view change that removes this node has none of its messages to trim
+    if(phase_timeout_ms > 0 && !curr_view->multicast_group->drain_sends(phase_timeout_ms)) {
+        dbg_default_warn("Graceful leave could not drain to a clean cut within {} ms; announcing departure anyway",
+                         phase_timeout_ms);
+    }
+    curr_view->gmsSST->predicates.clear();
+    //Phase 2: announce the departure. The rip bit is pushed (with completion)
+    //before the suspicion bit, and RDMA writes on a connection apply in
+    //order, so by the time any member observes the suspicion it already
+    //knows this is a planned departure. The view change starts from that SST
+    //write; no heartbeat timeout is involved.
+    curr_view->gmsSST->rip[curr_view->my_rank] = true;
+    curr_view->gmsSST->put_with_completion(curr_view->gmsSST->rip.get_base() - curr_view->gmsSST->getBaseAddress(),
+                                           sizeof(curr_view->gmsSST->rip[0]));
+    gmssst::set(curr_view->gmsSST->suspected[curr_view->my_rank][curr_view->my_rank], true);
+    curr_view->gmsSST->put_with_completion(curr_view->gmsSST->suspected);
+    //Phase 3: wait until every live member has wedged. Members do not freeze
+    //a departing (rip) node's connection when they suspect it, so their GMS
+    //state keeps arriving here; once they are all wedged, the delivery cut
+    //for the old view is fixed and nothing of ours is needed any longer.
+    const uint64_t wedge_deadline = get_time() + phase_timeout_ms * uint64_t(1000000);
+    bool all_wedged = false;
+    while(!all_wedged && get_time() < wedge_deadline) {
+        all_wedged = true;
+        for(int r = 0; r < curr_view->num_members; ++r) {
+            if(r != curr_view->my_rank && !curr_view->gmsSST->suspected[curr_view->my_rank][r]
+               && !curr_view->gmsSST->wedged[r]) {
+                all_wedged = false;
+                break;
+            }
+        }
+        if(!all_wedged) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+    }
+    if(!all_wedged) {
+        dbg_default_warn("Graceful leave timed out waiting for the remaining members to wedge; shutting down anyway");
+    }
+    //Phase 4: only now stop this node's threads and destroy its RDMC groups,
+    //after the rest of the membership has stopped relying on them
+    curr_view->multicast_group->wedge();
+    thread_shutdown = true;
+}
+
 void ViewManager::send(subgroup_id_t subgroup_num, long long unsigned int payload_size,
                        const std::function<void(char* buf)>& msg_generator, bool cooked_send) {
     shared_lock_t lock(view_mutex);
@@ -2208,6 +2622,34 @@ void ViewManager::send(subgroup_id_t subgroup_num, long long unsigned int payloa
     });
 }
 
+void ViewManager::send_zero_copy(subgroup_id_t subgroup_num, std::shared_ptr<rdma::memory_region> user_mr,
+                                 size_t offset, long long unsigned int payload_size,
+                                 std::function<void()> release_callback) {
+    shared_lock_t lock(view_mutex);
+    view_change_cv.wait(lock, [&]() {
+        //Copies, not moves: the predicate may run again after a view change
+        return curr_view->multicast_group->send_zero_copy(subgroup_num, user_mr, offset,
+                                                          payload_size, release_callback);
+    });
+}
+
+bool ViewManager::try_send(subgroup_id_t subgroup_num, long long unsigned int payload_size,
+                           const std::function<void(char* buf)>& msg_generator, bool cooked_send) {
+    shared_lock_t lock(view_mutex);
+    return curr_view->multicast_group->try_send(subgroup_num, payload_size,
+                                                msg_generator, cooked_send);
+}
+
+int32_t ViewManager::get_send_credits(subgroup_id_t subgroup_num) {
+    shared_lock_t lock(view_mutex);
+    return curr_view->multicast_group->get_send_credits(subgroup_num);
+}
+
+void ViewManager::set_send_credits_callback(subgroup_id_t subgroup_num, std::function<void()> callback) {
+    shared_lock_t lock(view_mutex);
+    curr_view->multicast_group->set_send_credits_callback(subgroup_num, std::move(callback));
+}
+
 const uint64_t ViewManager::compute_global_stability_frontier(subgroup_id_t subgroup_num) {
     shared_lock_t lock(view_mutex);
     return curr_view->multicast_group->compute_global_stability_frontier(subgroup_num);
@@ -2217,6 +2659,10 @@ void ViewManager::add_view_upcall(const view_upcall_t& upcall) {
     view_upcalls.emplace_back(upcall);
 }
 
+void ViewManager::register_p2p_connect_upcall(const std::function<void(node_id_t)>& upcall) {
+    p2p_connect_upcall = upcall;
+}
+
 std::vector<node_id_t> ViewManager::get_members() {
     shared_lock_t read_lock(view_mutex);
     return curr_view->members;
@@ -2227,6 +2673,46 @@ int32_t ViewManager::get_my_rank() {
     return curr_view->my_rank;
 }
 
+uint64_t ViewManager::read_perf_counter(PerfCounter counter) {
+    shared_lock_t read_lock(view_mutex);
+    return curr_view->gmsSST->read_perf_counter(curr_view->my_rank, counter);
+}
+
+uint64_t ViewManager::read_perf_counter_total(PerfCounter counter) {
+    shared_lock_t read_lock(view_mutex);
+    return curr_view->gmsSST->read_perf_counter_total(counter);
+}
+
+void ViewManager::publish_load_metric(uint64_t value) {
+    shared_lock_t read_lock(view_mutex);
+    curr_view->gmsSST->publish_load_metric(value);
+}
+
+node_id_t ViewManager::get_least_loaded_shard_member(subgroup_id_t subgroup_id, uint32_t shard_num) {
+    shared_lock_t read_lock(view_mutex);
+    const DerechoSST& gmsSST = *curr_view->gmsSST;
+    const SubView& shard_view = curr_view->subgroup_shard_views.at(subgroup_id).at(shard_num);
+    node_id_t best_member = 0;
+    bool found_member = false;
+    uint64_t best_load = std::numeric_limits<uint64_t>::max();
+    for(const node_id_t member : shard_view.members) {
+        const int rank = curr_view->rank_of(member);
+        if(rank == -1 || curr_view->failed[rank]) {
+            continue;
+        }
+        const uint64_t load = gmsSST.read_load_metric(rank);
+        if(!found_member || load < best_load) {
+            best_load = load;
+            best_member = member;
+            found_member = true;
+        }
+    }
+    if(!found_member) {
+        throw derecho_exception("get_least_loaded_shard_member: shard has no live members");
+    }
+    return best_member;
+}
+
 std::vector<std::vector<node_id_t>> ViewManager::get_subgroup_members(subgroup_type_id_t subgroup_type, uint32_t subgroup_index) {
     shared_lock_t read_lock(view_mutex);
     subgroup_id_t subgroup_id = curr_view->subgroup_ids_by_type_id.at(subgroup_type).at(subgroup_index);
@@ -2259,6 +2745,75 @@ void ViewManager::barrier_sync() {
     curr_view->gmsSST->sync_with_members();
 }
 
+void ViewManager::sst_barrier() {
+    await_sst_barrier(enter_sst_barrier(), std::nullopt, 0);
+}
+
+void ViewManager::sst_barrier(subgroup_type_id_t subgroup_type, uint32_t subgroup_index) {
+    await_sst_barrier(enter_sst_barrier(), subgroup_type, subgroup_index);
+}
+
+uint64_t ViewManager::enter_sst_barrier() {
+    shared_lock_t read_lock(view_mutex);
+    DerechoSST& gmsSST = *curr_view->gmsSST;
+    const int my_row = gmsSST.get_local_index();
+    const uint64_t target = gmsSST.barrier_counter[my_row] + 1;
+    gmsSST.barrier_counter[my_row] = target;
+    gmsSST.put(gmsSST.barrier_counter);
+    return target;
+}
+
+void ViewManager::await_sst_barrier(uint64_t target, std::optional<subgroup_type_id_t> subgroup_type,
+                                    uint32_t subgroup_index) {
+    //Barriers among already-arrived participants complete within the spin
+    //window; after it, back off to sleeping so a barrier that waits for a
+    //long application phase on another node does not burn a core
+    constexpr int spin_iterations = 100000;
+    int iterations = 0;
+    while(true) {
+        {
+            shared_lock_t read_lock(view_mutex);
+            const DerechoSST& gmsSST = *curr_view->gmsSST;
+            bool all_reached = true;
+            if(!subgroup_type) {
+                for(int rank = 0; rank < curr_view->num_members; ++rank) {
+                    if(!curr_view->failed[rank] && gmsSST.barrier_counter[rank] < target) {
+                        all_reached = false;
+                        break;
+                    }
+                }
+            } else {
+                const subgroup_id_t subgroup_id
+                        = curr_view->subgroup_ids_by_type_id.at(*subgroup_type).at(subgroup_index);
+                auto my_shard_entry = curr_view->my_subgroups.find(subgroup_id);
+                if(my_shard_entry == curr_view->my_subgroups.end()) {
+                    throw derecho_exception("sst_barrier called for a subgroup this node is not a member of");
+                }
+                const SubView& shard_view
+                        = curr_view->subgroup_shard_views.at(subgroup_id).at(my_shard_entry->second);
+                for(const node_id_t member : shard_view.members) {
+                    const int rank = curr_view->rank_of(member);
+                    if(rank != -1 && !curr_view->failed[rank]
+                       && gmsSST.barrier_counter[rank] < target) {
+                        all_reached = false;
+                        break;
+                    }
+                }
+            }
+            if(all_reached) {
+                return;
+            }
+        }
+        if(++iterations < spin_iterations) {
+#if defined(__x86_64__) || defined(__i386__)
+            asm volatile("pause");
+#endif
+        } else {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+    }
+}
+
 SharedLockedReference<View> ViewManager::get_current_view() {
     assert(curr_view);
     return SharedLockedReference<View>(*curr_view, view_mutex);
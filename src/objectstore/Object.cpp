@@ -5,23 +5,40 @@ namespace objectstore{
     Blob::Blob(const char* const b, const decltype(size) s) :
         bytes(nullptr), size(0) {
         if(s > 0) {
-            bytes = new char[s];
-            memcpy(bytes, b, s);
+            // the only copy this blob's data will ever see
+            storage = std::shared_ptr<char>(new char[s], std::default_delete<char[]>());
+            memcpy(storage.get(), b, s);
+            bytes = storage.get();
             size = s;
         }
     }
 
-    Blob::Blob(const Blob& other) :
+    // constructor - adopt the buffer without copying
+    Blob::Blob(std::unique_ptr<char[]> b, const decltype(size) s) :
+        bytes(nullptr), size(0) {
+        if(s > 0) {
+            storage = std::shared_ptr<char>(b.release(), std::default_delete<char[]>());
+            bytes = storage.get();
+            size = s;
+        }
+    }
+
+    // constructor - share caller-provided refcounted storage without copying
+    Blob::Blob(std::shared_ptr<char> st, char* b, const decltype(size) s) :
         bytes(nullptr), size(0) {
-        if(other.size > 0) {
-            bytes = new char[other.size];
-            memcpy(bytes, other.bytes, other.size);
-            size = other.size;
+        if(s > 0) {
+            storage = std::move(st);
+            bytes = b;
+            size = s;
         }
     }
 
-    Blob::Blob(Blob&& other) : 
-        bytes(other.bytes), size(other.size) {
+    // copy constructor - share the refcounted data
+    Blob::Blob(const Blob& other) :
+        bytes(other.bytes), size(other.size), storage(other.storage) {}
+
+    Blob::Blob(Blob&& other) :
+        bytes(other.bytes), size(other.size), storage(std::move(other.storage)) {
         other.bytes = nullptr;
         other.size = 0;
     }
@@ -29,30 +46,21 @@ namespace objectstore{
     Blob::Blob() : bytes(nullptr), size(0) {}
 
     Blob::~Blob() {
-        if(bytes) delete bytes;
+        // the backing array is freed with its last reference
     }
 
     Blob& Blob::operator=(Blob&& other) {
-        char* swp_bytes = other.bytes;
-        std::size_t swp_size = other.size;
-        other.bytes = bytes;
-        other.size = size;
-        bytes = swp_bytes;
-        size = swp_size;
+        std::swap(bytes, other.bytes);
+        std::swap(size, other.size);
+        std::swap(storage, other.storage);
         return *this;
     }
 
+    // copy evaluator - share the refcounted data
     Blob& Blob::operator=(const Blob& other) {
-        if(bytes != nullptr) {
-            delete bytes;
-        }
+        bytes = other.bytes;
         size = other.size;
-        if(size > 0) {
-            bytes = new char[size];
-            memcpy(bytes, other.bytes, size);
-        } else {
-            bytes = nullptr;
-        }
+        storage = other.storage;
         return *this;
     }
 
@@ -95,13 +103,26 @@ namespace objectstore{
     Object::Object(const OID& _oid, const Blob& _blob) : ver(INVALID_VERSION,0),
                                                  oid(_oid),
                                                  blob(_blob) {}
+    // constructor 0.1 : move the blob in instead of copying it
+    Object::Object(const OID& _oid, Blob&& _blob) : ver(INVALID_VERSION,0),
+                                            oid(_oid),
+                                            blob(std::move(_blob)) {}
+
     // constructor 0.5 : copy constructor
     Object::Object(const std::tuple<persistent::version_t,uint64_t> _ver, const OID& _oid, const Blob& _blob) : ver(_ver), oid(_oid), blob(_blob) {}
 
+    // constructor 0.6 : move the blob in instead of copying it
+    Object::Object(const std::tuple<persistent::version_t,uint64_t> _ver, const OID& _oid, Blob&& _blob) : ver(_ver), oid(_oid), blob(std::move(_blob)) {}
+
     // constructor 1 : copy consotructor
     Object::Object(const uint64_t _oid, const char* const _b, const std::size_t _s) : ver(INVALID_VERSION,0),
                                                                               oid(_oid),
                                                                               blob(_b, _s) {}
+
+    // constructor 1.1 : adopt the buffer without copying
+    Object::Object(const uint64_t _oid, std::unique_ptr<char[]> _b, const std::size_t _s) : ver(INVALID_VERSION,0),
+                                                                                    oid(_oid),
+                                                                                    blob(std::move(_b), _s) {}
     // constructor 1.5 : copy constructor
     Object::Object(const std::tuple<persistent::version_t,uint64_t> _ver, const uint64_t _oid, const char* const _b, const std::size_t _s) : ver(_ver), oid(_oid), blob(_b, _s) {}
 
@@ -115,4 +136,20 @@ namespace objectstore{
                                   blob(other.blob) {}
     // constructor 4 : default invalid constructor
     Object::Object() : ver(INVALID_VERSION,0), oid(INV_OID) {}
+
+    // move evaluator:
+    Object& Object::operator=(Object&& other) {
+        this->ver = other.ver;
+        this->oid = other.oid;
+        this->blob = std::move(other.blob);
+        return *this;
+    }
+
+    // copy evaluator:
+    Object& Object::operator=(const Object& other) {
+        this->ver = other.ver;
+        this->oid = other.oid;
+        this->blob = other.blob;
+        return *this;
+    }
 }
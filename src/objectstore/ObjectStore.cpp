@@ -1,10 +1,22 @@
 #include <derecho/objectstore/ObjectStore.hpp>
 #include <derecho/utils/logger.hpp>
 #include <algorithm>
+#include <array>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
 #include <errno.h>
+#include <fcntl.h>
 #include <iostream>
 #include <map>
+#include <mutex>
 #include <optional>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
 
 namespace objectstore {
 
@@ -17,15 +29,23 @@ namespace objectstore {
 
     A short summary of the classes:
 
+    - ObjectTable
+    The in-memory object index shared by the replica types: an
+    open-addressing hash table over a pooled object heap.
+
     - DeltaObjectStoreCore
     Delta feature is enabled.
 
     - VolatileUnloggedObjectStore (Type for a derecho subgroup)
     The implementation of an object store with out persistence and log.
 
+    - MappedObjectArena
+    The memory-mapped object heap behind PersistentUnloggedObjectStore.
+
     - PersistentUnloggedObjectStore (Type for a derecho subgroup)
     The implementation of an object store with persistence. Operations are
-    unlogged.
+    unlogged: only the current state is kept, in a memory-mapped arena whose
+    restart path is an mmap plus a checksum-validated index walk.
 
     - PersistentLoggedObjectStore (Type for a derecho subgroup)
     The implementation of an object store with both persistence and log. We
@@ -52,6 +72,241 @@ namespace objectstore {
 #define CONF_OBJECTSTORE_REPLICAS "OBJECTSTORE/replicas"
 #define CONF_OBJECTSTORE_PERSISTED "OBJECTSTORE/persisted"
 #define CONF_OBJECTSTORE_LOGGED "OBJECTSTORE/logged"
+#define CONF_OBJECTSTORE_SHARDS "OBJECTSTORE/shards"
+#define CONF_OBJECTSTORE_READ_CACHE "OBJECTSTORE/read_cache"
+#define CONF_OBJECTSTORE_READ_CACHE_SIZE "OBJECTSTORE/read_cache_size"
+#define CONF_OBJECTSTORE_PUT_WINDOW_SIZE "OBJECTSTORE/put_window_size"
+#define CONF_OBJECTSTORE_PUT_BATCH_SIZE "OBJECTSTORE/put_batch_size"
+#define CONF_OBJECTSTORE_LARGE_OBJECT_THRESHOLD "OBJECTSTORE/large_object_threshold"
+#define CONF_OBJECTSTORE_ARENA_FILE "OBJECTSTORE/arena_file"
+#define CONF_OBJECTSTORE_ARENA_SIZE "OBJECTSTORE/arena_size"
+
+// The in-memory object index used by the replica types. Lookups go through an
+// open-addressing hash table (linear probing, power-of-two capacity) whose
+// slots hold indices into a pooled object heap, so a get is one hash, a short
+// probe over a flat array, and one pool access - no tree descent and no
+// per-object allocation on the index path. The pool is a deque: object
+// addresses stay stable when it grows, so find() can hand out views into the
+// heap instead of copies, and erased entries are recycled through a free list
+// rather than returned to the allocator.
+class ObjectTable : public mutils::ByteRepresentable {
+    // slot markers; pool indices above SLOT_TOMBSTONE are unrepresentable
+    static constexpr uint32_t SLOT_EMPTY = 0xffffffffu;
+    static constexpr uint32_t SLOT_TOMBSTONE = 0xfffffffeu;
+    static constexpr std::size_t INITIAL_CAPACITY = 128;
+
+    std::vector<uint32_t> slots;      // the hash index: pool indices or slot markers
+    std::deque<Object> pool;          // the object heap
+    std::vector<uint32_t> free_pool_entries;
+    std::size_t live_count = 0;
+    std::size_t used_slots = 0;       // live entries plus tombstones
+
+    // The 64-bit finalizer from MurmurHash3 - deliberately a different mix
+    // than the one shard routing uses, so that within one shard the table
+    // slots are not correlated with the bits the shard modulus consumed.
+    static inline std::size_t hashOID(const OID& oid) {
+        uint64_t x = oid;
+        x ^= x >> 33;
+        x *= 0xff51afd7ed558ccdull;
+        x ^= x >> 33;
+        x *= 0xc4ceb9fe1a85ec53ull;
+        x ^= x >> 33;
+        return (std::size_t)x;
+    }
+
+    // rebuild the index at the given power-of-two capacity, dropping tombstones
+    void rehash(std::size_t new_capacity) {
+        std::vector<uint32_t> old_slots(new_capacity, SLOT_EMPTY);
+        old_slots.swap(slots);
+        used_slots = live_count;
+        const std::size_t mask = slots.size() - 1;
+        for(const uint32_t entry : old_slots) {
+            if(entry == SLOT_EMPTY || entry == SLOT_TOMBSTONE) {
+                continue;
+            }
+            std::size_t idx = hashOID(pool[entry].oid) & mask;
+            while(slots[idx] != SLOT_EMPTY) {
+                idx = (idx + 1) & mask;
+            }
+            slots[idx] = entry;
+        }
+    }
+
+    // keep the load factor (including tombstones) under 0.7
+    inline void maybe_grow() {
+        if((used_slots + 1) * 10 >= slots.size() * 7) {
+            rehash(slots.size() * 2);
+        }
+    }
+
+    // place an object already in the pool; shared by the two put() flavors
+    const Object& index_pool_entry(std::size_t slot_idx, uint32_t entry, bool into_empty_slot) {
+        if(into_empty_slot) {
+            used_slots++;
+        }
+        slots[slot_idx] = entry;
+        live_count++;
+        return pool[entry];
+    }
+
+public:
+    ObjectTable() : slots(INITIAL_CAPACITY, SLOT_EMPTY) {}
+
+    std::size_t size() const {
+        return live_count;
+    }
+
+    // look up an object
+    // @RETURN
+    //     a view into the object heap, valid until the object is removed or
+    //     replaced, or nullptr if oid is not in the table.
+    const Object* find(const OID& oid) const {
+        const std::size_t mask = slots.size() - 1;
+        std::size_t idx = hashOID(oid) & mask;
+        while(slots[idx] != SLOT_EMPTY) {
+            if(slots[idx] != SLOT_TOMBSTONE && pool[slots[idx]].oid == oid) {
+                return &pool[slots[idx]];
+            }
+            idx = (idx + 1) & mask;
+        }
+        return nullptr;
+    }
+
+    // insert or replace an object
+    // @RETURN
+    //     a view of the stored object in the heap
+    template <typename ObjectType>
+    const Object& put(ObjectType&& object) {
+        maybe_grow();
+        const std::size_t mask = slots.size() - 1;
+        std::size_t idx = hashOID(object.oid) & mask;
+        std::size_t first_tombstone = SIZE_MAX;
+        while(slots[idx] != SLOT_EMPTY) {
+            if(slots[idx] == SLOT_TOMBSTONE) {
+                if(first_tombstone == SIZE_MAX) {
+                    first_tombstone = idx;
+                }
+            } else if(pool[slots[idx]].oid == object.oid) {
+                // replace in place
+                pool[slots[idx]] = std::forward<ObjectType>(object);
+                return pool[slots[idx]];
+            }
+            idx = (idx + 1) & mask;
+        }
+        const bool into_empty_slot = (first_tombstone == SIZE_MAX);
+        if(!into_empty_slot) {
+            idx = first_tombstone;
+        }
+        uint32_t entry;
+        if(!free_pool_entries.empty()) {
+            entry = free_pool_entries.back();
+            free_pool_entries.pop_back();
+            pool[entry] = std::forward<ObjectType>(object);
+        } else {
+            entry = (uint32_t)pool.size();
+            pool.emplace_back(std::forward<ObjectType>(object));
+        }
+        return index_pool_entry(idx, entry, into_empty_slot);
+    }
+
+    // remove an object
+    // @RETURN
+    //     true if oid was in the table
+    bool erase(const OID& oid) {
+        const std::size_t mask = slots.size() - 1;
+        std::size_t idx = hashOID(oid) & mask;
+        while(slots[idx] != SLOT_EMPTY) {
+            if(slots[idx] != SLOT_TOMBSTONE && pool[slots[idx]].oid == oid) {
+                free_pool_entries.push_back(slots[idx]);
+                // release the blob now; the pool entry itself is recycled
+                pool[slots[idx]] = Object();
+                slots[idx] = SLOT_TOMBSTONE;
+                live_count--;
+                return true;
+            }
+            idx = (idx + 1) & mask;
+        }
+        return false;
+    }
+
+    // visit every live object (in index order)
+    template <typename Func>
+    void for_each(Func&& fun) const {
+        for(const uint32_t entry : slots) {
+            if(entry != SLOT_EMPTY && entry != SLOT_TOMBSTONE) {
+                fun(pool[entry]);
+            }
+        }
+    }
+
+    // serialization/deserialization support. The wire format is the live
+    // count followed by the serialized objects; the index is rebuilt on
+    // deserialization rather than shipped.
+    std::size_t bytes_size() const {
+        std::size_t size = sizeof(std::size_t);
+        for_each([&size](const Object& object) { size += mutils::bytes_size(object); });
+        return size;
+    }
+
+    std::size_t to_bytes(char* v) const {
+        ((std::size_t*)v)[0] = live_count;
+        std::size_t offset = sizeof(std::size_t);
+        for_each([&](const Object& object) { offset += mutils::to_bytes(object, v + offset); });
+        return offset;
+    }
+
+    void post_object(const std::function<void(char const* const, std::size_t)>& f) const {
+        f((char*)&live_count, sizeof(live_count));
+        for_each([&f](const Object& object) { mutils::post_object(f, object); });
+    }
+
+    void ensure_registered(mutils::DeserializationManager&) {}
+
+    static std::unique_ptr<ObjectTable> from_bytes(mutils::DeserializationManager* dsm, char const* buf) {
+        auto table = std::make_unique<ObjectTable>();
+        const std::size_t count = ((const std::size_t*)buf)[0];
+        // size the index for the incoming objects up front
+        std::size_t capacity = INITIAL_CAPACITY;
+        while(count * 10 >= capacity * 7) {
+            capacity *= 2;
+        }
+        table->rehash(capacity);
+        std::size_t offset = sizeof(std::size_t);
+        for(std::size_t i = 0; i < count; i++) {
+            auto object = mutils::from_bytes<Object>(dsm, buf + offset);
+            offset += mutils::bytes_size(*object);
+            table->put(std::move(*object));
+        }
+        return table;
+    }
+};
+
+// collect one reply-sized chunk of an ordered range scan from a table. The
+// hash index has no ordered iteration, so each chunk is a filtered sweep of
+// the table followed by a sort of the matches - the price of the O(1) point
+// lookups the index was chosen for.
+static std::vector<Object> scanObjectTable(const ObjectTable& table, const OID& from,
+                                           const OID& end_oid, const uint64_t& max_bytes) {
+    std::vector<const Object*> matches;
+    table.for_each([&](const Object& object) {
+        if(object.oid >= from && object.oid <= end_oid) {
+            matches.push_back(&object);
+        }
+    });
+    std::sort(matches.begin(), matches.end(),
+              [](const Object* a, const Object* b) { return a->oid < b->oid; });
+    std::vector<Object> batch;
+    std::size_t bytes = 0;
+    for(const Object* object : matches) {
+        bytes += mutils::bytes_size(*object);
+        // always return at least one match so the caller makes progress
+        if(!batch.empty() && bytes > max_bytes) {
+            break;
+        }
+        batch.push_back(*object);
+    }
+    return batch;
+}
 
 class IObjectStoreAPI {
 public:
@@ -89,6 +344,68 @@ public:
     //     return the object. If an invalid object is returned, oid is not
     //     found or is not found at time ts_us.
     virtual const Object get_by_time(const OID& oid, const uint64_t& ts_us) = 0;
+    // read the current version of an object without shipping its blob. Used
+    // by the client-side read cache to validate a cached copy cheaply. The
+    // read is local to the contacted replica, not ordered.
+    // @PARAM oid
+    //     the object id
+    // @RETURN
+    //     the version of the stored object, or INVALID_VERSION if oid is not
+    //     found.
+    virtual std::tuple<version_t,uint64_t> getVersion(const OID& oid) = 0;
+    // insert or update a batch of objects with a single ordered send. Used by
+    // the windowed put path to amortize the round-trip cost over many small
+    // puts.
+    // @PARAM batch - the objects to be inserted or updated
+    // @RETURN
+    //     the new versions, in the same order as 'batch'
+    virtual std::vector<std::tuple<version_t,uint64_t>> putBatch(const std::vector<Object>& batch) = 0;
+    // read a batch of objects in one round trip. Like getVersion, the reads
+    // are local to the contacted replica, not ordered.
+    // @PARAM oids
+    //     the object ids to read
+    // @PARAM max_bytes
+    //     the reply byte budget. The reply covers a prefix of 'oids' (at
+    //     least one entry, so the caller always makes progress) whose
+    //     serialized objects fit the budget; the caller re-requests the rest.
+    // @RETURN
+    //     the objects for that prefix, aligned with 'oids'; an invalid
+    //     object marks an id that was not found.
+    virtual std::vector<Object> getBatch(const std::vector<OID>& oids, const uint64_t& max_bytes) = 0;
+    // read one chunk of an ordered key-range scan, locally on the contacted
+    // replica.
+    // @PARAM from
+    //     the first object id of interest (inclusive)
+    // @PARAM end_oid
+    //     the last object id of interest (inclusive)
+    // @PARAM max_bytes
+    //     the reply byte budget, applied as in getBatch
+    // @RETURN
+    //     the stored objects with from <= oid <= end_oid in ascending id
+    //     order, truncated to the budget; empty if the range holds nothing.
+    //     The caller continues from the last returned id plus one.
+    virtual std::vector<Object> scanChunk(const OID& from, const OID& end_oid, const uint64_t& max_bytes) = 0;
+    // stage one shard's portion of a cross-shard transaction. Relay target:
+    // runs the ordered prepare on behalf of a node outside the shard.
+    // @PARAM txid
+    //     the group-wide transaction id
+    // @PARAM batch
+    //     the objects this shard will install on commit
+    // @RETURN
+    //     true once the shard has staged the batch
+    virtual bool prepareTxn(const uint64_t& txid, const std::vector<Object>& batch) = 0;
+    // commit a staged transaction on this shard. Relay target like
+    // prepareTxn.
+    // @PARAM txid
+    //     the transaction id passed to prepareTxn
+    // @RETURN
+    //     the new versions, in the same order as the staged batch; empty if
+    //     txid is unknown.
+    virtual std::vector<std::tuple<version_t,uint64_t>> commitTxn(const uint64_t& txid) = 0;
+    // drop a staged transaction on this shard. Relay target like prepareTxn.
+    // @RETURN
+    //     true if txid was staged
+    virtual bool abortTxn(const uint64_t& txid) = 0;
 };
 
 class IReplica {
@@ -112,6 +429,33 @@ public:
     //     return the object. If an invalid object is returned, oid is not
     //     found.
     virtual const Object orderedGet(const OID& oid) = 0;
+    // Perform an ordered 'put' of a whole batch in the subgroup. All objects
+    // in the batch receive the version of the one ordered message that
+    // carried them.
+    // @PARAM batch
+    //     the objects to be inserted or updated
+    // @RETURN
+    //     the new versions, in the same order as 'batch'
+    virtual std::vector<std::tuple<version_t,uint64_t>> orderedPutBatch(const std::vector<Object>& batch) = 0;
+    // Perform the ordered prepare of a cross-shard transaction: stage the
+    // batch under txid without installing it.
+    // @PARAM txid
+    //     the group-wide transaction id
+    // @PARAM batch
+    //     the objects this shard will install on commit
+    // @RETURN
+    //     true once the batch is staged
+    virtual bool orderedPrepareTxn(const uint64_t& txid, const std::vector<Object>& batch) = 0;
+    // Perform the ordered commit of a staged transaction. The whole batch
+    // receives the version of the commit message.
+    // @RETURN
+    //     the new versions, in the same order as the staged batch; empty if
+    //     txid is unknown.
+    virtual std::vector<std::tuple<version_t,uint64_t>> orderedCommitTxn(const uint64_t& txid) = 0;
+    // Perform the ordered abort of a staged transaction.
+    // @RETURN
+    //     true if txid was staged
+    virtual bool orderedAbortTxn(const uint64_t& txid) = 0;
 };
 
 class VolatileUnloggedObjectStore : public IReplica,
@@ -120,9 +464,20 @@ class VolatileUnloggedObjectStore : public IReplica,
                                     public IObjectStoreAPI {
 public:
     using derecho::GroupReference::group;
-    std::map<OID, Object> objects;
+    ObjectTable objects;
     const ObjectWatcher object_watcher;
     const Object inv_obj;
+    // large-object blobs staged over p2p, keyed by transfer handle, awaiting
+    // the ordered (oid, handle) message that installs them. Part of the
+    // replicated state: a joiner must receive in-flight stages or it would
+    // have nothing to install when the ordered message arrives.
+    std::map<uint64_t, Object> staged_large_objects;
+    std::mutex staged_objects_mutex;
+    // cross-shard transaction batches staged by an ordered prepare, awaiting
+    // the ordered commit (or abort) that resolves them. Only touched from the
+    // delivery path, so no lock. Part of the replicated state: a joiner that
+    // missed the prepare must still install the batch on commit.
+    std::map<uint64_t, std::vector<Object>> staged_transactions;
 
     REGISTER_RPC_FUNCTIONS(VolatileUnloggedObjectStore,
                            orderedPut,
@@ -131,7 +486,21 @@ public:
                            put,
                            remove,
                            get,
-                           get_by_time);
+                           get_by_time,
+                           getVersion,
+                           putBatch,
+                           orderedPutBatch,
+                           getBatch,
+                           scanChunk,
+                           putLarge,
+                           stageLargeObject,
+                           orderedPutLarge,
+                           prepareTxn,
+                           commitTxn,
+                           abortTxn,
+                           orderedPrepareTxn,
+                           orderedCommitTxn,
+                           orderedAbortTxn);
 
     inline std::tuple<version_t,uint64_t> get_version() {
         derecho::Replicated<VolatileUnloggedObjectStore>& subgroup_handle = group->template get_subgroup<VolatileUnloggedObjectStore>();
@@ -150,6 +519,25 @@ public:
         }
         return vRet;
     }
+    // relay target for a large put: runs the ordered phase on behalf of a
+    // node outside the owning shard (the blob was already staged over p2p)
+    virtual std::tuple<version_t,uint64_t> putLarge(const OID& oid, const uint64_t& handle) {
+        auto& subgroup_handle = group->template get_subgroup<VolatileUnloggedObjectStore>();
+        auto results = subgroup_handle.template ordered_send<RPC_NAME(orderedPutLarge)>(oid, handle);
+        decltype(results)::ReplyMap& replies = results.get();
+        std::tuple<version_t,uint64_t> vRet(INVALID_VERSION,0);
+        for(auto& reply_pair : replies) {
+            vRet = reply_pair.second.get();
+        }
+        return vRet;
+    }
+    // p2p target: hold a large object's bytes until the ordered message
+    // carrying its handle is delivered. The reply doubles as the staging ack.
+    virtual bool stageLargeObject(const uint64_t& handle, const Object& object) {
+        std::lock_guard<std::mutex> guard(staged_objects_mutex);
+        staged_large_objects[handle] = object;
+        return true;
+    }
     // @override IObjectStoreAPI::remove
     virtual std::tuple<version_t,uint64_t> remove(const OID& oid) {
         auto& subgroup_handle = group->template get_subgroup<VolatileUnloggedObjectStore>();
@@ -184,20 +572,112 @@ public:
                          typeid(*this).name(), __func__, oid, ts_us);
         return inv_obj;
     }
+    // @override IObjectStoreAPI::getVersion
+    virtual std::tuple<version_t,uint64_t> getVersion(const OID& oid) {
+        if(const Object* object = objects.find(oid)) {
+            return object->ver;
+        }
+        return std::tuple<version_t,uint64_t>(INVALID_VERSION,0);
+    }
+    // @override IObjectStoreAPI::getBatch
+    virtual std::vector<Object> getBatch(const std::vector<OID>& oids, const uint64_t& max_bytes) {
+        std::vector<Object> batch;
+        std::size_t bytes = 0;
+        for(const OID& oid : oids) {
+            const Object* object = objects.find(oid);
+            const Object& result = object ? *object : inv_obj;
+            bytes += mutils::bytes_size(result);
+            // always cover at least one id so the caller makes progress
+            if(!batch.empty() && bytes > max_bytes) {
+                break;
+            }
+            batch.push_back(result);
+        }
+        return batch;
+    }
+    // @override IObjectStoreAPI::scanChunk
+    virtual std::vector<Object> scanChunk(const OID& from, const OID& end_oid, const uint64_t& max_bytes) {
+        return scanObjectTable(objects, from, end_oid, max_bytes);
+    }
+    // @override IObjectStoreAPI::putBatch
+    virtual std::vector<std::tuple<version_t,uint64_t>> putBatch(const std::vector<Object>& batch) {
+        auto& subgroup_handle = group->template get_subgroup<VolatileUnloggedObjectStore>();
+        auto results = subgroup_handle.template ordered_send<RPC_NAME(orderedPutBatch)>(batch);
+        decltype(results)::ReplyMap& replies = results.get();
+        std::vector<std::tuple<version_t,uint64_t>> vRet;
+        for(auto& reply_pair : replies) {
+            vRet = reply_pair.second.get();
+        }
+        return vRet;
+    }
+    // @override IObjectStoreAPI::prepareTxn
+    virtual bool prepareTxn(const uint64_t& txid, const std::vector<Object>& batch) {
+        auto& subgroup_handle = group->template get_subgroup<VolatileUnloggedObjectStore>();
+        auto results = subgroup_handle.template ordered_send<RPC_NAME(orderedPrepareTxn)>(txid, batch);
+        bool prepared = true;
+        for(auto& reply_pair : results.get()) {
+            prepared = reply_pair.second.get() && prepared;
+        }
+        return prepared;
+    }
+    // @override IObjectStoreAPI::commitTxn
+    virtual std::vector<std::tuple<version_t,uint64_t>> commitTxn(const uint64_t& txid) {
+        auto& subgroup_handle = group->template get_subgroup<VolatileUnloggedObjectStore>();
+        auto results = subgroup_handle.template ordered_send<RPC_NAME(orderedCommitTxn)>(txid);
+        std::vector<std::tuple<version_t,uint64_t>> vRet;
+        for(auto& reply_pair : results.get()) {
+            vRet = reply_pair.second.get();
+        }
+        return vRet;
+    }
+    // @override IObjectStoreAPI::abortTxn
+    virtual bool abortTxn(const uint64_t& txid) {
+        auto& subgroup_handle = group->template get_subgroup<VolatileUnloggedObjectStore>();
+        auto results = subgroup_handle.template ordered_send<RPC_NAME(orderedAbortTxn)>(txid);
+        bool aborted = true;
+        for(auto& reply_pair : results.get()) {
+            aborted = reply_pair.second.get() && aborted;
+        }
+        return aborted;
+    }
 
     // This is for REGISTER_RPC_FUNCTIONS
     // @override IReplica::orderedPut
     virtual std::tuple<version_t,uint64_t> orderedPut(const Object& object) {
         std::tuple<version_t,uint64_t> version = get_version();
         dbg_default_info("orderedPut object:{},version:0x{:x},timestamp:{}", object.oid, std::get<0>(version), std::get<1>(version));
-        this->objects.erase(object.oid);
         object.ver = version;
-        this->objects.emplace(object.oid, object);  // copy constructor
+        const Object& stored = this->objects.put(object);  // one copy into the heap
         // call object watcher
         if(object_watcher) {
-            object_watcher(object.oid, object);
+            object_watcher(stored.oid, stored);
         }
-        return object.ver;
+        return stored.ver;
+    }
+    // the ordered phase of a large put: the multicast carried only the
+    // handle, the bytes were staged by stageLargeObject
+    virtual std::tuple<version_t,uint64_t> orderedPutLarge(const OID& oid, const uint64_t& handle) {
+        std::tuple<version_t,uint64_t> version = get_version();
+        dbg_default_info("orderedPutLarge object:{},handle:0x{:x},version:0x{:x},timestamp:{}", oid, handle, std::get<0>(version), std::get<1>(version));
+        Object staged;
+        {
+            std::lock_guard<std::mutex> guard(staged_objects_mutex);
+            auto search = staged_large_objects.find(handle);
+            if(search == staged_large_objects.end()) {
+                // staging is acked by every replica before the ordered send,
+                // so this can only happen after a local restart in between
+                dbg_default_error("orderedPutLarge: no staged bytes for handle 0x{:x} (oid={})", handle, oid);
+                return std::tuple<version_t,uint64_t>(INVALID_VERSION,0);
+            }
+            staged = std::move(search->second);
+            staged_large_objects.erase(search);
+        }
+        staged.ver = version;
+        const Object& stored = this->objects.put(std::move(staged));
+        if(object_watcher) {
+            object_watcher(stored.oid, stored);
+        }
+        return stored.ver;
     }
     // @override IReplica::orderedRemove
     virtual std::tuple<version_t,uint64_t> orderedRemove(const OID& oid) {
@@ -212,14 +692,65 @@ public:
     virtual const Object orderedGet(const OID& oid) {
         auto version = get_version();
         dbg_default_info("orderedGet object:{},version:0x{:x},timestamp:{}", oid, std::get<0>(version), std::get<1>(version));
-        if(objects.find(oid) != objects.end()) {
-            return objects.at(oid);
-        } else {
-            return this->inv_obj;
+        // the view is only copied once, into the reply
+        if(const Object* object = objects.find(oid)) {
+            return *object;
+        }
+        return this->inv_obj;
+    }
+    // @override IReplica::orderedPutBatch
+    virtual std::vector<std::tuple<version_t,uint64_t>> orderedPutBatch(const std::vector<Object>& batch) {
+        std::tuple<version_t,uint64_t> version = get_version();
+        dbg_default_info("orderedPutBatch of {} objects,version:0x{:x},timestamp:{}", batch.size(), std::get<0>(version), std::get<1>(version));
+        std::vector<std::tuple<version_t,uint64_t>> versions;
+        versions.reserve(batch.size());
+        for(const Object& object : batch) {
+            object.ver = version;
+            const Object& stored = this->objects.put(object);
+            if(object_watcher) {
+                object_watcher(stored.oid, stored);
+            }
+            versions.push_back(version);
+        }
+        return versions;
+    }
+    // @override IReplica::orderedPrepareTxn
+    virtual bool orderedPrepareTxn(const uint64_t& txid, const std::vector<Object>& batch) {
+        dbg_default_info("orderedPrepareTxn txid:0x{:x} of {} objects", txid, batch.size());
+        staged_transactions[txid] = batch;
+        return true;
+    }
+    // @override IReplica::orderedCommitTxn
+    virtual std::vector<std::tuple<version_t,uint64_t>> orderedCommitTxn(const uint64_t& txid) {
+        std::tuple<version_t,uint64_t> version = get_version();
+        dbg_default_info("orderedCommitTxn txid:0x{:x},version:0x{:x},timestamp:{}", txid, std::get<0>(version), std::get<1>(version));
+        auto search = staged_transactions.find(txid);
+        if(search == staged_transactions.end()) {
+            // the prepare is acked by the whole shard before the commit is
+            // sent, so this can only happen after a local restart in between
+            dbg_default_error("orderedCommitTxn: no staged batch for txid 0x{:x}", txid);
+            return {};
         }
+        std::vector<std::tuple<version_t,uint64_t>> versions;
+        versions.reserve(search->second.size());
+        for(const Object& object : search->second) {
+            object.ver = version;
+            const Object& stored = this->objects.put(object);
+            if(object_watcher) {
+                object_watcher(stored.oid, stored);
+            }
+            versions.push_back(version);
+        }
+        staged_transactions.erase(search);
+        return versions;
+    }
+    // @override IReplica::orderedAbortTxn
+    virtual bool orderedAbortTxn(const uint64_t& txid) {
+        dbg_default_info("orderedAbortTxn txid:0x{:x}", txid);
+        return staged_transactions.erase(txid) > 0;
     }
 
-    DEFAULT_SERIALIZE(objects);
+    DEFAULT_SERIALIZE(objects, staged_large_objects, staged_transactions);
 
     static std::unique_ptr<VolatileUnloggedObjectStore> from_bytes(mutils::DeserializationManager* dsm, char const* buf) {
 // OPTION ONE to test
@@ -227,8 +758,14 @@ public:
 //                std::move(*mutils::from_bytes<decltype(objects)>(dsm, buf)),
 //                dsm->mgr<IObjectStoreService>().getObjectWatcher());
         auto ptr_to_objects = mutils::from_bytes<decltype(objects)>(dsm, buf);
+        std::size_t offset = mutils::bytes_size(*ptr_to_objects);
+        auto ptr_to_staged_objects = mutils::from_bytes<decltype(staged_large_objects)>(dsm, buf + offset);
+        offset += mutils::bytes_size(*ptr_to_staged_objects);
+        auto ptr_to_staged_txns = mutils::from_bytes<decltype(staged_transactions)>(dsm, buf + offset);
         auto ptr_to_return = std::make_unique<VolatileUnloggedObjectStore>(std::move(*ptr_to_objects),
                 dsm->mgr<IObjectStoreService>().getObjectWatcher());
+        ptr_to_return->staged_large_objects = std::move(*ptr_to_staged_objects);
+        ptr_to_return->staged_transactions = std::move(*ptr_to_staged_txns);
         ptr_to_objects.release(); // to avoid double free.
         return ptr_to_return;
     }
@@ -239,8 +776,643 @@ public:
 
     // constructors
     VolatileUnloggedObjectStore(const ObjectWatcher& ow) : object_watcher(ow) {}
-    VolatileUnloggedObjectStore(const std::map<OID, Object>& _objects, const ObjectWatcher& ow) : objects(_objects), object_watcher(ow) {}
-    VolatileUnloggedObjectStore(std::map<OID, Object>&& _objects, const ObjectWatcher& ow) : objects(std::move(_objects)), object_watcher(ow) {}
+    VolatileUnloggedObjectStore(const ObjectTable& _objects, const ObjectWatcher& ow) : objects(_objects), object_watcher(ow) {}
+    VolatileUnloggedObjectStore(ObjectTable&& _objects, const ObjectWatcher& ow) : objects(std::move(_objects)), object_watcher(ow) {}
+};
+
+// The memory-mapped object heap backing PersistentUnloggedObjectStore. Object
+// payloads live in a persistent arena file mapped MAP_SHARED: a put appends a
+// checksummed record and the stored blob points straight at the mapped bytes,
+// so the OS page cache decides which objects stay resident and writeback runs
+// through the mapping. Restart is an mmap plus a checksum-validated walk of
+// the committed records - an index rebuild at memory speed - instead of a log
+// replay.
+//
+// The arena is append-only while running: an overwrite or a remove appends a
+// new record (or a tombstone) and the superseded record becomes garbage,
+// reclaimed by the compacting rewrite that runs at load time once the garbage
+// outweighs the live set. The file is created sparse at its full configured
+// capacity and the mapping is never moved or grown, so blob pointers into it
+// stay valid for the life of the process.
+class MappedObjectArena {
+    static constexpr uint64_t ARENA_MAGIC = 0x414e455241534f44ull;  // "DOSARENA"
+    static constexpr uint64_t ARENA_FORMAT = 1;
+    static constexpr uint32_t RECORD_TOMBSTONE = 0x1;
+
+    struct ArenaHeader {
+        uint64_t magic;
+        uint64_t format_version;
+        uint64_t capacity;
+        // bytes of committed records following the header; advanced only
+        // after the record bytes and checksum are in place, so a torn append
+        // is invisible after a crash
+        uint64_t committed_bytes;
+    };
+
+    struct RecordHeader {
+        OID oid;
+        version_t ver;
+        uint64_t timestamp;
+        uint64_t payload_size;
+        uint32_t flags;
+        uint32_t crc;  // over the fields above and the payload
+    };
+
+    int fd = -1;
+    char* base = nullptr;  // the mapping; ArenaHeader at offset 0
+    uint64_t capacity = 0;
+    ArenaHeader* header = nullptr;
+
+    // records are 8-byte aligned so the header fields can be read in place
+    static constexpr uint64_t align8(uint64_t n) {
+        return (n + 7) & ~7ull;
+    }
+
+    // CRC-32C over a byte range, chainable through 'crc'
+    static uint32_t crc32c(uint32_t crc, const void* data, std::size_t len) {
+        static const std::array<uint32_t, 256> table = [] {
+            std::array<uint32_t, 256> t{};
+            for(uint32_t i = 0; i < 256; i++) {
+                uint32_t c = i;
+                for(int k = 0; k < 8; k++) {
+                    c = (c >> 1) ^ (0x82f63b78u & (0u - (c & 1)));
+                }
+                t[i] = c;
+            }
+            return t;
+        }();
+        const uint8_t* p = (const uint8_t*)data;
+        crc = ~crc;
+        while(len--) {
+            crc = (crc >> 8) ^ table[(crc ^ *p++) & 0xff];
+        }
+        return ~crc;
+    }
+
+    // the record checksum: the header fields up to 'crc', then the payload
+    static uint32_t recordCRC(const RecordHeader& rh, const char* payload) {
+        uint32_t crc = crc32c(0, &rh, offsetof(RecordHeader, crc));
+        return crc32c(crc, payload, rh.payload_size);
+    }
+
+    // a blob viewing a mapped payload. The deleter is a no-op: the mapping
+    // lives as long as the process, and durability is the file's.
+    Blob mappedBlob(char* payload, std::size_t size) {
+        return Blob(std::shared_ptr<char>(payload, [](char*) {}), payload, size);
+    }
+
+    // schedule writeback of the record at [addr, addr+len); msync wants
+    // page-aligned addresses
+    void scheduleWriteback(char* addr, std::size_t len) {
+        static const std::size_t page = sysconf(_SC_PAGESIZE);
+        char* start = base + (((std::size_t)(addr - base)) & ~(page - 1));
+        msync(start, (addr + len) - start, MS_ASYNC);
+    }
+
+    // validate-walk the committed records into 'table' (last write wins,
+    // tombstones erase), truncating the committed region at the first torn
+    // or corrupt record.
+    // @RETURN the record bytes still referenced by the index
+    uint64_t buildIndex(ObjectTable& table) {
+        uint64_t offset = 0;
+        while(offset + sizeof(RecordHeader) <= header->committed_bytes) {
+            char* record = base + sizeof(ArenaHeader) + offset;
+            RecordHeader rh;
+            memcpy(&rh, record, sizeof(rh));
+            const uint64_t need = align8(sizeof(RecordHeader) + rh.payload_size);
+            if(offset + need > header->committed_bytes) {
+                dbg_default_error("object arena: torn record at offset {}; truncating", offset);
+                break;
+            }
+            const uint32_t expected = rh.crc;
+            rh.crc = 0;
+            if(recordCRC(rh, record + sizeof(RecordHeader)) != expected) {
+                dbg_default_error("object arena: checksum mismatch at offset {}; truncating", offset);
+                break;
+            }
+            if(rh.flags & RECORD_TOMBSTONE) {
+                table.erase(rh.oid);
+            } else {
+                table.put(Object(std::tuple<version_t, uint64_t>(rh.ver, rh.timestamp), rh.oid,
+                                 mappedBlob(record + sizeof(RecordHeader), rh.payload_size)));
+            }
+            offset += need;
+        }
+        header->committed_bytes = offset;
+        uint64_t live_bytes = 0;
+        table.for_each([&live_bytes](const Object& object) {
+            live_bytes += align8(sizeof(RecordHeader) + object.blob.size);
+        });
+        return live_bytes;
+    }
+
+    // rewrite the live set to the front of the arena. Records move, so this
+    // only runs at load time, before any blob views of the mapping are
+    // handed out; the caller rebuilds the index afterwards.
+    void compactRecords(const ObjectTable& table) {
+        uint64_t read_offset = 0;
+        uint64_t write_offset = 0;
+        while(read_offset + sizeof(RecordHeader) <= header->committed_bytes) {
+            char* record = base + sizeof(ArenaHeader) + read_offset;
+            RecordHeader rh;
+            memcpy(&rh, record, sizeof(rh));
+            const uint64_t need = align8(sizeof(RecordHeader) + rh.payload_size);
+            // a record is live iff it carries the version the index kept;
+            // versions are unique per ordered delivery
+            const Object* indexed = (rh.flags & RECORD_TOMBSTONE) ? nullptr : table.find(rh.oid);
+            if(indexed && indexed->ver == std::tuple<version_t, uint64_t>(rh.ver, rh.timestamp)) {
+                if(write_offset != read_offset) {
+                    // the write cursor never passes the read cursor
+                    memmove(base + sizeof(ArenaHeader) + write_offset, record, need);
+                }
+                write_offset += need;
+            }
+            read_offset += need;
+        }
+        header->committed_bytes = write_offset;
+        msync(base, sizeof(ArenaHeader) + write_offset, MS_SYNC);
+    }
+
+public:
+    MappedObjectArena(const std::string& path, uint64_t capacity_bytes) : capacity(capacity_bytes) {
+        fd = open(path.c_str(), O_RDWR | O_CREAT, S_IRUSR | S_IWUSR);
+        if(fd < 0) {
+            throw derecho::derecho_exception("Cannot open object arena file: " + path);
+        }
+        struct stat st;
+        if(fstat(fd, &st) != 0) {
+            throw derecho::derecho_exception("Cannot stat object arena file: " + path);
+        }
+        const bool fresh = (st.st_size == 0);
+        if((uint64_t)st.st_size > capacity) {
+            // never shrink an arena that may hold data
+            capacity = st.st_size;
+        } else if((uint64_t)st.st_size < capacity && ftruncate(fd, capacity) != 0) {
+            throw derecho::derecho_exception("Cannot size object arena file: " + path);
+        }
+        base = (char*)mmap(nullptr, capacity, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        if(base == MAP_FAILED) {
+            throw derecho::derecho_exception("Cannot map object arena file: " + path);
+        }
+        header = (ArenaHeader*)base;
+        if(fresh || header->magic != ARENA_MAGIC || header->format_version != ARENA_FORMAT) {
+            if(!fresh) {
+                dbg_default_warn("object arena {} has an unrecognized header; reinitializing", path);
+            }
+            header->magic = ARENA_MAGIC;
+            header->format_version = ARENA_FORMAT;
+            header->capacity = capacity;
+            header->committed_bytes = 0;
+        }
+    }
+
+    ~MappedObjectArena() {
+        if(base != nullptr) {
+            msync(base, capacity, MS_SYNC);
+            munmap(base, capacity);
+        }
+        if(fd >= 0) {
+            close(fd);
+        }
+    }
+
+    // append one object record. Appends run on the (serialized) delivery
+    // path, like the index updates they pair with.
+    // @RETURN
+    //     a blob viewing the mapped payload, or std::nullopt if the arena is
+    //     out of space
+    std::optional<Blob> append(const Object& object) {
+        const uint64_t need = align8(sizeof(RecordHeader) + object.blob.size);
+        if(sizeof(ArenaHeader) + header->committed_bytes + need > capacity) {
+            return std::nullopt;
+        }
+        char* record = base + sizeof(ArenaHeader) + header->committed_bytes;
+        RecordHeader rh;
+        rh.oid = object.oid;
+        rh.ver = std::get<0>(object.ver);
+        rh.timestamp = std::get<1>(object.ver);
+        rh.payload_size = object.blob.size;
+        rh.flags = 0;
+        rh.crc = 0;
+        rh.crc = recordCRC(rh, object.blob.bytes);
+        memcpy(record, &rh, sizeof(rh));
+        if(object.blob.size > 0) {
+            memcpy(record + sizeof(rh), object.blob.bytes, object.blob.size);
+        }
+        header->committed_bytes += need;
+        scheduleWriteback(record, need);
+        return mappedBlob(record + sizeof(RecordHeader), object.blob.size);
+    }
+
+    // append a tombstone for oid
+    // @RETURN false if the arena is out of space
+    bool appendTombstone(const OID& oid, const std::tuple<version_t, uint64_t>& ver) {
+        const uint64_t need = align8(sizeof(RecordHeader));
+        if(sizeof(ArenaHeader) + header->committed_bytes + need > capacity) {
+            return false;
+        }
+        char* record = base + sizeof(ArenaHeader) + header->committed_bytes;
+        RecordHeader rh;
+        rh.oid = oid;
+        rh.ver = std::get<0>(ver);
+        rh.timestamp = std::get<1>(ver);
+        rh.payload_size = 0;
+        rh.flags = RECORD_TOMBSTONE;
+        rh.crc = 0;
+        rh.crc = recordCRC(rh, nullptr);
+        memcpy(record, &rh, sizeof(rh));
+        header->committed_bytes += need;
+        scheduleWriteback(record, need);
+        return true;
+    }
+
+    // the instant-restart path: rebuild the index from the committed records,
+    // compacting first if the garbage outweighs the live set
+    void load(ObjectTable& table) {
+        const uint64_t live_bytes = buildIndex(table);
+        if(header->committed_bytes - live_bytes > live_bytes) {
+            dbg_default_info("object arena: compacting {} committed bytes down to {} live bytes",
+                             header->committed_bytes, live_bytes);
+            compactRecords(table);
+            table = ObjectTable();
+            buildIndex(table);
+        }
+    }
+
+    // the state-transfer path: replace the arena contents with the received
+    // table
+    // @RETURN a rebuilt table whose blobs view the mapped bytes
+    ObjectTable adopt(const ObjectTable& received) {
+        header->committed_bytes = 0;
+        ObjectTable table;
+        received.for_each([&](const Object& object) {
+            std::optional<Blob> mapped = append(object);
+            if(!mapped) {
+                throw derecho::derecho_exception("ObjectStore arena is too small for the transferred state");
+            }
+            table.put(Object(object.ver, object.oid, std::move(*mapped)));
+        });
+        return table;
+    }
+};
+
+// The node-local arena shared by every PersistentUnloggedObjectStore
+// incarnation on this node: a view change or state transfer replaces the
+// replicated object, not the file behind it. Sited next to the persistence
+// layer's logs unless OBJECTSTORE/arena_file says otherwise.
+static MappedObjectArena& localObjectArena() {
+    static MappedObjectArena arena = [] {
+        std::string path;
+        if(derecho::hasCustomizedConfKey(CONF_OBJECTSTORE_ARENA_FILE)) {
+            path = derecho::getConfString(CONF_OBJECTSTORE_ARENA_FILE);
+        } else {
+            const std::string dir = derecho::getConfString(CONF_PERS_FILE_PATH);
+            mkdir(dir.c_str(), S_IRWXU | S_IRWXG | S_IROTH | S_IXOTH);  // a pre-existing directory is fine
+            path = dir + "/objectstore-" + std::to_string(derecho::getConfUInt64(CONF_DERECHO_LOCAL_ID)) + ".arena";
+        }
+        // the file is sparse, so the default capacity is deliberately roomy
+        const uint64_t arena_size = derecho::hasCustomizedConfKey(CONF_OBJECTSTORE_ARENA_SIZE)
+                                            ? derecho::getConfUInt64(CONF_OBJECTSTORE_ARENA_SIZE)
+                                            : (1ull << 34);
+        return MappedObjectArena(path, arena_size);
+    }();
+    return arena;
+}
+
+// The persistent-unlogged replica type: current-state-only semantics like
+// VolatileUnloggedObjectStore, but the object heap lives in the node-local
+// memory-mapped arena, so the contents survive a restart and come back with
+// an mmap plus a validated index walk instead of a log replay. Versioned and
+// temporal queries are not supported - keeping only the current state is
+// what makes the restart (and write) path this much cheaper than
+// PersistentLoggedObjectStore.
+class PersistentUnloggedObjectStore : public IReplica,
+                                      public mutils::ByteRepresentable,
+                                      public derecho::GroupReference,
+                                      public IObjectStoreAPI {
+public:
+    using derecho::GroupReference::group;
+    MappedObjectArena& arena;
+    ObjectTable objects;
+    const ObjectWatcher object_watcher;
+    const Object inv_obj;
+    // large-object blobs staged over p2p, keyed by transfer handle, awaiting
+    // the ordered (oid, handle) message that installs them. Part of the
+    // replicated state: a joiner must receive in-flight stages or it would
+    // have nothing to install when the ordered message arrives.
+    std::map<uint64_t, Object> staged_large_objects;
+    std::mutex staged_objects_mutex;
+
+    // cross-shard transaction batches staged by an ordered prepare, awaiting
+    // the ordered commit (or abort) that resolves them. Only touched from the
+    // delivery path, so no lock. Part of the replicated state: a joiner that
+    // missed the prepare must still install the batch on commit.
+    std::map<uint64_t, std::vector<Object>> staged_transactions;
+
+    REGISTER_RPC_FUNCTIONS(PersistentUnloggedObjectStore,
+                           orderedPut,
+                           orderedRemove,
+                           orderedGet,
+                           put,
+                           remove,
+                           get,
+                           get_by_time,
+                           getVersion,
+                           putBatch,
+                           orderedPutBatch,
+                           getBatch,
+                           scanChunk,
+                           putLarge,
+                           stageLargeObject,
+                           orderedPutLarge,
+                           prepareTxn,
+                           commitTxn,
+                           abortTxn,
+                           orderedPrepareTxn,
+                           orderedCommitTxn,
+                           orderedAbortTxn);
+
+    inline std::tuple<version_t,uint64_t> get_version() {
+        derecho::Replicated<PersistentUnloggedObjectStore>& subgroup_handle = group->template get_subgroup<PersistentUnloggedObjectStore>();
+        return subgroup_handle.get_next_version();
+    }
+
+    // install one versioned object into the arena and the index; shared by
+    // the ordered put flavors
+    std::tuple<version_t,uint64_t> installObject(const Object& object) {
+        std::optional<Blob> mapped = arena.append(object);
+        if(!mapped) {
+            // deterministic across the shard: every replica appends the same
+            // records in the same order
+            dbg_default_error("object arena is full; put of object {} dropped", object.oid);
+            return std::tuple<version_t,uint64_t>(INVALID_VERSION,0);
+        }
+        const Object& stored = this->objects.put(Object(object.ver, object.oid, std::move(*mapped)));
+        if(object_watcher) {
+            object_watcher(stored.oid, stored);
+        }
+        return stored.ver;
+    }
+
+    // @override IObjectStoreAPI::put
+    virtual std::tuple<version_t,uint64_t> put(const Object& object) {
+        derecho::Replicated<PersistentUnloggedObjectStore>& subgroup_handle = group->template get_subgroup<PersistentUnloggedObjectStore>();
+        auto results = subgroup_handle.ordered_send<RPC_NAME(orderedPut)>(object);
+        decltype(results)::ReplyMap& replies = results.get();
+        std::tuple<version_t,uint64_t> vRet(INVALID_VERSION,0);
+        for(auto& reply_pair : replies) {
+            vRet = reply_pair.second.get();
+        }
+        return vRet;
+    }
+    // relay target for a large put: runs the ordered phase on behalf of a
+    // node outside the owning shard (the blob was already staged over p2p)
+    virtual std::tuple<version_t,uint64_t> putLarge(const OID& oid, const uint64_t& handle) {
+        auto& subgroup_handle = group->template get_subgroup<PersistentUnloggedObjectStore>();
+        auto results = subgroup_handle.template ordered_send<RPC_NAME(orderedPutLarge)>(oid, handle);
+        decltype(results)::ReplyMap& replies = results.get();
+        std::tuple<version_t,uint64_t> vRet(INVALID_VERSION,0);
+        for(auto& reply_pair : replies) {
+            vRet = reply_pair.second.get();
+        }
+        return vRet;
+    }
+    // p2p target: hold a large object's bytes until the ordered message
+    // carrying its handle is delivered. The reply doubles as the staging ack.
+    virtual bool stageLargeObject(const uint64_t& handle, const Object& object) {
+        std::lock_guard<std::mutex> guard(staged_objects_mutex);
+        staged_large_objects[handle] = object;
+        return true;
+    }
+    // @override IObjectStoreAPI::remove
+    virtual std::tuple<version_t,uint64_t> remove(const OID& oid) {
+        auto& subgroup_handle = group->template get_subgroup<PersistentUnloggedObjectStore>();
+        derecho::rpc::QueryResults<std::tuple<version_t,uint64_t>> results = subgroup_handle.template ordered_send<RPC_NAME(orderedRemove)>(oid);
+        decltype(results)::ReplyMap& replies = results.get();
+        std::tuple<version_t,uint64_t> vRet(INVALID_VERSION,0);
+        for(auto& reply_pair : replies) {
+            vRet = reply_pair.second.get();
+        }
+        return vRet;
+    }
+    // @override IObjectStoreAPI::get
+    virtual const Object get(const OID& oid, const version_t& ver) {
+        // check version
+        if(ver != INVALID_VERSION) {
+            dbg_default_info("{}:{} does not support versioned query ( oid = {}; ver = 0x{:x} ). Return with an invalid object.",
+                             typeid(*this).name(), __func__, oid, ver);
+            return inv_obj;
+        }
+
+        auto& subgroup_handle = group->template get_subgroup<PersistentUnloggedObjectStore>();
+        derecho::rpc::QueryResults<const Object> results = subgroup_handle.template ordered_send<RPC_NAME(orderedGet)>(oid);
+        decltype(results)::ReplyMap& replies = results.get();
+        return replies.begin()->second.get();
+    }
+    // @override IObjectStoreAPI::get_by_time
+    virtual const Object get_by_time(const OID& oid, const uint64_t& ts_us) {
+        dbg_default_info("{}:{} does not support temporal query (oid = {}; timestamp = {} us). Return with an invalid object.",
+                         typeid(*this).name(), __func__, oid, ts_us);
+        return inv_obj;
+    }
+    // @override IObjectStoreAPI::getVersion
+    virtual std::tuple<version_t,uint64_t> getVersion(const OID& oid) {
+        if(const Object* object = objects.find(oid)) {
+            return object->ver;
+        }
+        return std::tuple<version_t,uint64_t>(INVALID_VERSION,0);
+    }
+    // @override IObjectStoreAPI::getBatch
+    virtual std::vector<Object> getBatch(const std::vector<OID>& oids, const uint64_t& max_bytes) {
+        std::vector<Object> batch;
+        std::size_t bytes = 0;
+        for(const OID& oid : oids) {
+            const Object* object = objects.find(oid);
+            const Object& result = object ? *object : inv_obj;
+            bytes += mutils::bytes_size(result);
+            // always cover at least one id so the caller makes progress
+            if(!batch.empty() && bytes > max_bytes) {
+                break;
+            }
+            batch.push_back(result);
+        }
+        return batch;
+    }
+    // @override IObjectStoreAPI::scanChunk
+    virtual std::vector<Object> scanChunk(const OID& from, const OID& end_oid, const uint64_t& max_bytes) {
+        return scanObjectTable(objects, from, end_oid, max_bytes);
+    }
+    // @override IObjectStoreAPI::putBatch
+    virtual std::vector<std::tuple<version_t,uint64_t>> putBatch(const std::vector<Object>& batch) {
+        auto& subgroup_handle = group->template get_subgroup<PersistentUnloggedObjectStore>();
+        auto results = subgroup_handle.template ordered_send<RPC_NAME(orderedPutBatch)>(batch);
+        decltype(results)::ReplyMap& replies = results.get();
+        std::vector<std::tuple<version_t,uint64_t>> vRet;
+        for(auto& reply_pair : replies) {
+            vRet = reply_pair.second.get();
+        }
+        return vRet;
+    }
+    // @override IObjectStoreAPI::prepareTxn
+    virtual bool prepareTxn(const uint64_t& txid, const std::vector<Object>& batch) {
+        auto& subgroup_handle = group->template get_subgroup<PersistentUnloggedObjectStore>();
+        auto results = subgroup_handle.template ordered_send<RPC_NAME(orderedPrepareTxn)>(txid, batch);
+        bool prepared = true;
+        for(auto& reply_pair : results.get()) {
+            prepared = reply_pair.second.get() && prepared;
+        }
+        return prepared;
+    }
+    // @override IObjectStoreAPI::commitTxn
+    virtual std::vector<std::tuple<version_t,uint64_t>> commitTxn(const uint64_t& txid) {
+        auto& subgroup_handle = group->template get_subgroup<PersistentUnloggedObjectStore>();
+        auto results = subgroup_handle.template ordered_send<RPC_NAME(orderedCommitTxn)>(txid);
+        std::vector<std::tuple<version_t,uint64_t>> vRet;
+        for(auto& reply_pair : results.get()) {
+            vRet = reply_pair.second.get();
+        }
+        return vRet;
+    }
+    // @override IObjectStoreAPI::abortTxn
+    virtual bool abortTxn(const uint64_t& txid) {
+        auto& subgroup_handle = group->template get_subgroup<PersistentUnloggedObjectStore>();
+        auto results = subgroup_handle.template ordered_send<RPC_NAME(orderedAbortTxn)>(txid);
+        bool aborted = true;
+        for(auto& reply_pair : results.get()) {
+            aborted = reply_pair.second.get() && aborted;
+        }
+        return aborted;
+    }
+
+    // This is for REGISTER_RPC_FUNCTIONS
+    // @override IReplica::orderedPut
+    virtual std::tuple<version_t,uint64_t> orderedPut(const Object& object) {
+        std::tuple<version_t,uint64_t> version = get_version();
+        dbg_default_info("orderedPut object:{},version:0x{:x},timestamp:{}", object.oid, std::get<0>(version), std::get<1>(version));
+        object.ver = version;
+        return installObject(object);
+    }
+    // the ordered phase of a large put: the multicast carried only the
+    // handle, the bytes were staged by stageLargeObject
+    virtual std::tuple<version_t,uint64_t> orderedPutLarge(const OID& oid, const uint64_t& handle) {
+        std::tuple<version_t,uint64_t> version = get_version();
+        dbg_default_info("orderedPutLarge object:{},handle:0x{:x},version:0x{:x},timestamp:{}", oid, handle, std::get<0>(version), std::get<1>(version));
+        Object staged;
+        {
+            std::lock_guard<std::mutex> guard(staged_objects_mutex);
+            auto search = staged_large_objects.find(handle);
+            if(search == staged_large_objects.end()) {
+                // staging is acked by every replica before the ordered send,
+                // so this can only happen after a local restart in between
+                dbg_default_error("orderedPutLarge: no staged bytes for handle 0x{:x} (oid={})", handle, oid);
+                return std::tuple<version_t,uint64_t>(INVALID_VERSION,0);
+            }
+            staged = std::move(search->second);
+            staged_large_objects.erase(search);
+        }
+        staged.ver = version;
+        return installObject(staged);
+    }
+    // @override IReplica::orderedRemove
+    virtual std::tuple<version_t,uint64_t> orderedRemove(const OID& oid) {
+        auto version = get_version();
+        dbg_default_info("orderedRemove object:{},version:0x{:x},timestamp:{}", oid, std::get<0>(version), std::get<1>(version));
+        if(this->objects.erase(oid)) {
+            if(!arena.appendTombstone(oid, version)) {
+                // the remove still happened in memory; it just will not
+                // survive a restart
+                dbg_default_error("object arena is full; remove of object {} is not durable", oid);
+            }
+            object_watcher(oid, inv_obj);
+        }
+        return version;
+    }
+    // @override IReplica::orderedGet
+    virtual const Object orderedGet(const OID& oid) {
+        auto version = get_version();
+        dbg_default_info("orderedGet object:{},version:0x{:x},timestamp:{}", oid, std::get<0>(version), std::get<1>(version));
+        // the view is only copied once, into the reply
+        if(const Object* object = objects.find(oid)) {
+            return *object;
+        }
+        return this->inv_obj;
+    }
+    // @override IReplica::orderedPutBatch
+    virtual std::vector<std::tuple<version_t,uint64_t>> orderedPutBatch(const std::vector<Object>& batch) {
+        std::tuple<version_t,uint64_t> version = get_version();
+        dbg_default_info("orderedPutBatch of {} objects,version:0x{:x},timestamp:{}", batch.size(), std::get<0>(version), std::get<1>(version));
+        std::vector<std::tuple<version_t,uint64_t>> versions;
+        versions.reserve(batch.size());
+        for(const Object& object : batch) {
+            object.ver = version;
+            versions.push_back(installObject(object));
+        }
+        return versions;
+    }
+    // @override IReplica::orderedPrepareTxn
+    virtual bool orderedPrepareTxn(const uint64_t& txid, const std::vector<Object>& batch) {
+        dbg_default_info("orderedPrepareTxn txid:0x{:x} of {} objects", txid, batch.size());
+        staged_transactions[txid] = batch;
+        return true;
+    }
+    // @override IReplica::orderedCommitTxn
+    virtual std::vector<std::tuple<version_t,uint64_t>> orderedCommitTxn(const uint64_t& txid) {
+        std::tuple<version_t,uint64_t> version = get_version();
+        dbg_default_info("orderedCommitTxn txid:0x{:x},version:0x{:x},timestamp:{}", txid, std::get<0>(version), std::get<1>(version));
+        auto search = staged_transactions.find(txid);
+        if(search == staged_transactions.end()) {
+            // the prepare is acked by the whole shard before the commit is
+            // sent, so this can only happen after a local restart in between
+            dbg_default_error("orderedCommitTxn: no staged batch for txid 0x{:x}", txid);
+            return {};
+        }
+        std::vector<std::tuple<version_t,uint64_t>> versions;
+        versions.reserve(search->second.size());
+        for(const Object& object : search->second) {
+            object.ver = version;
+            versions.push_back(installObject(object));
+        }
+        staged_transactions.erase(search);
+        return versions;
+    }
+    // @override IReplica::orderedAbortTxn
+    virtual bool orderedAbortTxn(const uint64_t& txid) {
+        dbg_default_info("orderedAbortTxn txid:0x{:x}", txid);
+        return staged_transactions.erase(txid) > 0;
+    }
+
+    DEFAULT_SERIALIZE(objects, staged_large_objects, staged_transactions);
+
+    static std::unique_ptr<PersistentUnloggedObjectStore> from_bytes(mutils::DeserializationManager* dsm, char const* buf) {
+        auto ptr_to_objects = mutils::from_bytes<decltype(objects)>(dsm, buf);
+        std::size_t offset = mutils::bytes_size(*ptr_to_objects);
+        auto ptr_to_staged_objects = mutils::from_bytes<decltype(staged_large_objects)>(dsm, buf + offset);
+        offset += mutils::bytes_size(*ptr_to_staged_objects);
+        auto ptr_to_staged_txns = mutils::from_bytes<decltype(staged_transactions)>(dsm, buf + offset);
+        auto ptr_to_return = std::make_unique<PersistentUnloggedObjectStore>(std::move(*ptr_to_objects),
+                dsm->mgr<IObjectStoreService>().getObjectWatcher());
+        ptr_to_return->staged_large_objects = std::move(*ptr_to_staged_objects);
+        ptr_to_return->staged_transactions = std::move(*ptr_to_staged_txns);
+        ptr_to_objects.release(); // to avoid double free.
+        return ptr_to_return;
+    }
+
+    DEFAULT_DESERIALIZE_NOALLOC(PersistentUnloggedObjectStore);
+
+    void ensure_registered(mutils::DeserializationManager&) {}
+
+    // constructors. The first is the restart path: map the arena and rebuild
+    // the index from the committed records. The other two are the
+    // state-transfer path: the received table replaces the arena contents,
+    // and the rebuilt index points back into the mapping.
+    PersistentUnloggedObjectStore(const ObjectWatcher& ow) : arena(localObjectArena()), object_watcher(ow) {
+        arena.load(objects);
+        dbg_default_info("object arena restart: {} objects recovered", objects.size());
+    }
+    PersistentUnloggedObjectStore(const ObjectTable& _objects, const ObjectWatcher& ow)
+            : arena(localObjectArena()), objects(arena.adopt(_objects)), object_watcher(ow) {}
+    PersistentUnloggedObjectStore(ObjectTable&& _objects, const ObjectWatcher& ow)
+            : arena(localObjectArena()), objects(arena.adopt(_objects)), object_watcher(ow) {}
 };
 
 // Enable the Delta feature
@@ -249,7 +1421,8 @@ class DeltaObjectStoreCore : public mutils::ByteRepresentable,
 #define DEFAULT_DELTA_BUFFER_CAPACITY (4096)
     enum _OPID {
         PUT,
-        REMOVE
+        REMOVE,
+        PUT_BATCH
     };
     // _dosc_delta is a name used only for struct constructor.
     struct {
@@ -317,7 +1490,7 @@ class DeltaObjectStoreCore : public mutils::ByteRepresentable,
     }
 
 public:
-    std::map<OID, Object> objects;
+    ObjectTable objects;
     const ObjectWatcher object_watcher;
     const Object inv_obj;
     ///////////////////////////////////////////////////////////////////////////
@@ -329,6 +1502,8 @@ public:
     // [OPID:REMOVE][oid]
     // 3) get(const OID& oid)
     // no need to prepare a delta
+    // 4) putBatch(const std::vector<Object>& batch)
+    // [OPID:PUT_BATCH][batch]
     ///////////////////////////////////////////////////////////////////////////
     // @override IDeltaSupport::finalizeCurrentDelta()
     virtual void finalizeCurrentDelta(const DeltaFinalizer& df) {
@@ -340,11 +1515,16 @@ public:
         const char* data = (delta + sizeof(const uint32_t));
         switch(*(const uint32_t*)delta) {
             case PUT:
-                applyOrderedPut(*mutils::from_bytes<Object>(nullptr, data));
+                applyOrderedPut(std::move(*mutils::from_bytes<Object>(nullptr, data)));
                 break;
             case REMOVE:
                 applyOrderedRemove(*(const OID*)data);
                 break;
+            case PUT_BATCH:
+                for(Object& object : *mutils::from_bytes<std::vector<Object>>(nullptr, data)) {
+                    applyOrderedPut(std::move(object));
+                }
+                break;
             default:
                 std::cerr << __FILE__ << ":" << __LINE__ << ":" << __func__ << " " << std::endl;
         };
@@ -361,13 +1541,15 @@ public:
         return std::make_unique<DeltaObjectStoreCore>((ObjectWatcher){});
     }
 
-    inline void applyOrderedPut(const Object& object) {
+    // object is forwarded into the table, so a moved-in argument moves its
+    // buffer all the way to the heap
+    template <typename ObjectType>
+    inline void applyOrderedPut(ObjectType&& object) {
         // put
-        this->objects.erase(object.oid);
-        this->objects.emplace(object.oid, object);
+        const Object& stored = this->objects.put(std::forward<ObjectType>(object));
         // call object watcher
         if(object_watcher) {
-            object_watcher(object.oid, object);
+            object_watcher(stored.oid, stored);
         }
     }
     inline bool applyOrderedRemove(const OID& oid) {
@@ -396,6 +1578,20 @@ public:
         return true;
     }
     // Can we get the serialized operation representation from Derecho?
+    virtual void orderedPutBatch(const std::vector<Object>& batch) {
+        // create one delta covering the whole batch.
+        assert(this->delta.isEmpty());
+        const std::size_t data_size = mutils::bytes_size(batch);
+        this->delta.calibrate(data_size);
+        mutils::to_bytes(batch, this->delta.dataPtr());
+        this->delta.setDataLen(data_size);
+        this->delta.setOpid(PUT_BATCH);
+        // apply the batch
+        for(const Object& object : batch) {
+            applyOrderedPut(object);
+        }
+    }
+    // Can we get the serialized operation representation from Derecho?
     virtual bool orderedRemove(const OID& oid) {
         // create delta
         assert(this->delta.isEmpty());
@@ -408,11 +1604,10 @@ public:
     }
 
     virtual const Object orderedGet(const OID& oid) {
-        if(objects.find(oid) != objects.end()) {
-            return objects.at(oid);
-        } else {
-            return this->inv_obj;
+        if(const Object* object = objects.find(oid)) {
+            return *object;
         }
+        return this->inv_obj;
     }
 
     // Not going to register them as RPC functions because DeltaObjectStoreCore
@@ -445,10 +1640,10 @@ public:
     DeltaObjectStoreCore(const ObjectWatcher& ow) : object_watcher(ow) {
         initialize_delta();
     }
-    DeltaObjectStoreCore(const std::map<OID, Object>& _objects, const ObjectWatcher& ow) : objects(_objects), object_watcher(ow) {
+    DeltaObjectStoreCore(const ObjectTable& _objects, const ObjectWatcher& ow) : objects(_objects), object_watcher(ow) {
         initialize_delta();
     }
-    DeltaObjectStoreCore(std::map<OID, Object>&& _objects, const ObjectWatcher& ow) : objects(_objects), object_watcher(ow) {
+    DeltaObjectStoreCore(ObjectTable&& _objects, const ObjectWatcher& ow) : objects(std::move(_objects)), object_watcher(ow) {
         initialize_delta();
     }
     virtual ~DeltaObjectStoreCore() {
@@ -465,6 +1660,19 @@ class PersistentLoggedObjectStore : public mutils::ByteRepresentable,
                                     public IReplica {
 private:
     const Object inv_obj;
+    // large-object blobs staged over p2p, keyed by transfer handle, awaiting
+    // the ordered (oid, handle) message that installs them. Not part of the
+    // persistent log, but part of the serialized state a joiner receives: it
+    // must see in-flight stages or it would have nothing to install when the
+    // ordered message arrives.
+    std::map<uint64_t, Object> staged_large_objects;
+    std::mutex staged_objects_mutex;
+    // cross-shard transaction batches staged by an ordered prepare, awaiting
+    // the ordered commit (or abort) that resolves them. Only touched from the
+    // delivery path, so no lock. Not part of the persistent log, but part of
+    // the serialized state a joiner receives, so a joiner that missed the
+    // prepare still installs the batch on commit.
+    std::map<uint64_t, std::vector<Object>> staged_transactions;
 
 public:
     using derecho::GroupReference::group;
@@ -477,7 +1685,21 @@ public:
                            put,
                            remove,
                            get,
-                           get_by_time);
+                           get_by_time,
+                           getVersion,
+                           putBatch,
+                           orderedPutBatch,
+                           getBatch,
+                           scanChunk,
+                           putLarge,
+                           stageLargeObject,
+                           orderedPutLarge,
+                           prepareTxn,
+                           commitTxn,
+                           abortTxn,
+                           orderedPrepareTxn,
+                           orderedCommitTxn,
+                           orderedAbortTxn);
 
     // @override IReplica::orderedPut
     virtual std::tuple<version_t,uint64_t> orderedPut(const Object& object) {
@@ -487,6 +1709,29 @@ public:
         this->persistent_objectstore->orderedPut(object);
         return object.ver;
     }
+    // the ordered phase of a large put: the multicast carried only the
+    // handle, the bytes were staged by stageLargeObject
+    virtual std::tuple<version_t,uint64_t> orderedPutLarge(const OID& oid, const uint64_t& handle) {
+        auto& subgroup_handle = group->template get_subgroup<PersistentLoggedObjectStore>();
+        std::tuple<version_t,uint64_t> version = subgroup_handle.get_next_version();
+        dbg_default_info("orderedPutLarge object:{},handle:0x{:x},version:0x{:x},timestamp:{}", oid, handle, std::get<0>(version), std::get<1>(version));
+        Object staged;
+        {
+            std::lock_guard<std::mutex> guard(staged_objects_mutex);
+            auto search = staged_large_objects.find(handle);
+            if(search == staged_large_objects.end()) {
+                // staging is acked by every replica before the ordered send,
+                // so this can only happen after a local restart in between
+                dbg_default_error("orderedPutLarge: no staged bytes for handle 0x{:x} (oid={})", handle, oid);
+                return std::tuple<version_t,uint64_t>(INVALID_VERSION,0);
+            }
+            staged = std::move(search->second);
+            staged_large_objects.erase(search);
+        }
+        staged.ver = version;
+        this->persistent_objectstore->orderedPut(staged);
+        return staged.ver;
+    }
     // @override IReplica::orderedRemove
     virtual std::tuple<version_t,uint64_t> orderedRemove(const OID& oid) {
         auto& subgroup_handle = group->template get_subgroup<PersistentLoggedObjectStore>();
@@ -504,6 +1749,51 @@ public:
 #endif
         return this->persistent_objectstore->orderedGet(oid);
     }
+    // @override IReplica::orderedPutBatch
+    virtual std::vector<std::tuple<version_t,uint64_t>> orderedPutBatch(const std::vector<Object>& batch) {
+        auto& subgroup_handle = group->template get_subgroup<PersistentLoggedObjectStore>();
+        // the whole batch rides one ordered message, so it is one version
+        std::tuple<version_t,uint64_t> version = subgroup_handle.get_next_version();
+        dbg_default_info("orderedPutBatch of {} objects,version:0x{:x},timestamp:{}", batch.size(), std::get<0>(version), std::get<1>(version));
+        for(const Object& object : batch) {
+            object.ver = version;
+        }
+        this->persistent_objectstore->orderedPutBatch(batch);
+        return std::vector<std::tuple<version_t,uint64_t>>(batch.size(), version);
+    }
+    // @override IReplica::orderedPrepareTxn
+    virtual bool orderedPrepareTxn(const uint64_t& txid, const std::vector<Object>& batch) {
+        dbg_default_info("orderedPrepareTxn txid:0x{:x} of {} objects", txid, batch.size());
+        staged_transactions[txid] = batch;
+        return true;
+    }
+    // @override IReplica::orderedCommitTxn
+    virtual std::vector<std::tuple<version_t,uint64_t>> orderedCommitTxn(const uint64_t& txid) {
+        auto& subgroup_handle = group->template get_subgroup<PersistentLoggedObjectStore>();
+        std::tuple<version_t,uint64_t> version = subgroup_handle.get_next_version();
+        dbg_default_info("orderedCommitTxn txid:0x{:x},version:0x{:x},timestamp:{}", txid, std::get<0>(version), std::get<1>(version));
+        auto search = staged_transactions.find(txid);
+        if(search == staged_transactions.end()) {
+            // the prepare is acked by the whole shard before the commit is
+            // sent, so this can only happen after a local restart in between
+            dbg_default_error("orderedCommitTxn: no staged batch for txid 0x{:x}", txid);
+            return {};
+        }
+        // like orderedPutBatch: the batch rides one ordered message, so it
+        // logs as one version
+        for(const Object& object : search->second) {
+            object.ver = version;
+        }
+        this->persistent_objectstore->orderedPutBatch(search->second);
+        std::vector<std::tuple<version_t,uint64_t>> versions(search->second.size(), version);
+        staged_transactions.erase(search);
+        return versions;
+    }
+    // @override IReplica::orderedAbortTxn
+    virtual bool orderedAbortTxn(const uint64_t& txid) {
+        dbg_default_info("orderedAbortTxn txid:0x{:x}", txid);
+        return staged_transactions.erase(txid) > 0;
+    }
     // @override IObjectStoreAPI::put
     virtual std::tuple<version_t,uint64_t> put(const Object& object) {
         auto& subgroup_handle = group->template get_subgroup<PersistentLoggedObjectStore>();
@@ -515,6 +1805,25 @@ public:
         }
         return vRet;
     }
+    // relay target for a large put: runs the ordered phase on behalf of a
+    // node outside the owning shard (the blob was already staged over p2p)
+    virtual std::tuple<version_t,uint64_t> putLarge(const OID& oid, const uint64_t& handle) {
+        auto& subgroup_handle = group->template get_subgroup<PersistentLoggedObjectStore>();
+        auto results = subgroup_handle.template ordered_send<RPC_NAME(orderedPutLarge)>(oid, handle);
+        decltype(results)::ReplyMap& replies = results.get();
+        std::tuple<version_t,uint64_t> vRet(INVALID_VERSION,0);
+        for(auto& reply_pair : replies) {
+            vRet = reply_pair.second.get();
+        }
+        return vRet;
+    }
+    // p2p target: hold a large object's bytes until the ordered message
+    // carrying its handle is delivered. The reply doubles as the staging ack.
+    virtual bool stageLargeObject(const uint64_t& handle, const Object& object) {
+        std::lock_guard<std::mutex> guard(staged_objects_mutex);
+        staged_large_objects[handle] = object;
+        return true;
+    }
     // @override IObjectStoreAPI::remove
     virtual std::tuple<version_t,uint64_t> remove(const OID& oid) {
         auto& subgroup_handle = group->template get_subgroup<PersistentLoggedObjectStore>();
@@ -546,24 +1855,94 @@ public:
             }
             // 2 - return the object
             // TODO:
-            // - avoid copy here!!!
             // - delta implementation needs to be improved!!! The existing
             //   implementation of Persistent<T> will Rebuild the whole object
             //   store on each versioned call. Fix this in persistent/
             //   Persistent.hpp
-            try {
-                return persistent_objectstore[ver]->objects.at(oid);
-            } catch(std::out_of_range& ex) {
-                return inv_obj;
+            auto versioned_state = persistent_objectstore[ver];
+            if(const Object* object = versioned_state->objects.find(oid)) {
+                return *object;
+            }
+            return inv_obj;
+        }
+    }
+    // @override IObjectStoreAPI::getVersion
+    virtual std::tuple<version_t,uint64_t> getVersion(const OID& oid) {
+        if(const Object* object = this->persistent_objectstore->objects.find(oid)) {
+            return object->ver;
+        }
+        return std::tuple<version_t,uint64_t>(INVALID_VERSION,0);
+    }
+    // @override IObjectStoreAPI::getBatch
+    virtual std::vector<Object> getBatch(const std::vector<OID>& oids, const uint64_t& max_bytes) {
+        std::vector<Object> batch;
+        std::size_t bytes = 0;
+        for(const OID& oid : oids) {
+            const Object* object = this->persistent_objectstore->objects.find(oid);
+            const Object& result = object ? *object : inv_obj;
+            bytes += mutils::bytes_size(result);
+            // always cover at least one id so the caller makes progress
+            if(!batch.empty() && bytes > max_bytes) {
+                break;
             }
+            batch.push_back(result);
+        }
+        return batch;
+    }
+    // @override IObjectStoreAPI::scanChunk
+    virtual std::vector<Object> scanChunk(const OID& from, const OID& end_oid, const uint64_t& max_bytes) {
+        return scanObjectTable(this->persistent_objectstore->objects, from, end_oid, max_bytes);
+    }
+    // @override IObjectStoreAPI::putBatch
+    virtual std::vector<std::tuple<version_t,uint64_t>> putBatch(const std::vector<Object>& batch) {
+        auto& subgroup_handle = group->template get_subgroup<PersistentLoggedObjectStore>();
+        auto results = subgroup_handle.template ordered_send<RPC_NAME(orderedPutBatch)>(batch);
+        decltype(results)::ReplyMap& replies = results.get();
+        std::vector<std::tuple<version_t,uint64_t>> vRet;
+        for(auto& reply_pair : replies) {
+            vRet = reply_pair.second.get();
         }
+        return vRet;
+    }
+    // @override IObjectStoreAPI::prepareTxn
+    virtual bool prepareTxn(const uint64_t& txid, const std::vector<Object>& batch) {
+        auto& subgroup_handle = group->template get_subgroup<PersistentLoggedObjectStore>();
+        auto results = subgroup_handle.template ordered_send<RPC_NAME(orderedPrepareTxn)>(txid, batch);
+        bool prepared = true;
+        for(auto& reply_pair : results.get()) {
+            prepared = reply_pair.second.get() && prepared;
+        }
+        return prepared;
+    }
+    // @override IObjectStoreAPI::commitTxn
+    virtual std::vector<std::tuple<version_t,uint64_t>> commitTxn(const uint64_t& txid) {
+        auto& subgroup_handle = group->template get_subgroup<PersistentLoggedObjectStore>();
+        auto results = subgroup_handle.template ordered_send<RPC_NAME(orderedCommitTxn)>(txid);
+        std::vector<std::tuple<version_t,uint64_t>> vRet;
+        for(auto& reply_pair : results.get()) {
+            vRet = reply_pair.second.get();
+        }
+        return vRet;
+    }
+    // @override IObjectStoreAPI::abortTxn
+    virtual bool abortTxn(const uint64_t& txid) {
+        auto& subgroup_handle = group->template get_subgroup<PersistentLoggedObjectStore>();
+        auto results = subgroup_handle.template ordered_send<RPC_NAME(orderedAbortTxn)>(txid);
+        bool aborted = true;
+        for(auto& reply_pair : results.get()) {
+            aborted = reply_pair.second.get() && aborted;
+        }
+        return aborted;
     }
     // @override IObjectStoreAPI::get_by_time
     virtual const Object get_by_time(const OID& oid, const uint64_t& ts_us) {
         dbg_default_debug("get_by_time, oid={}, ts={}.", oid, ts_us);
         const HLC hlc(ts_us,0ull); // generate a hybrid logical clock: TODO: do we have to use HLC????
         try{
-            return persistent_objectstore.get(hlc)->objects.at(oid);
+            auto versioned_state = persistent_objectstore.get(hlc);
+            if(const Object* object = versioned_state->objects.find(oid)) {
+                return *object;
+            }
         } catch (const int64_t &ex) {
             dbg_default_warn("temporal query throws exception:0x{:x}. oid={}, ts={}", ex, oid, ts_us);
         } catch (...) {
@@ -574,7 +1953,7 @@ public:
 
     // DEFAULT_SERIALIZATION_SUPPORT(PersistentLoggedObjectStore,persistent_objectstore);
 
-    DEFAULT_SERIALIZE(persistent_objectstore);
+    DEFAULT_SERIALIZE(persistent_objectstore, staged_large_objects, staged_transactions);
 
     static std::unique_ptr<PersistentLoggedObjectStore> from_bytes(mutils::DeserializationManager* dsm, char const*
                                                                                                                 buf) {
@@ -583,7 +1962,13 @@ public:
 //                std::move(*mutils::from_bytes<decltype(persistent_objectstore)>(dsm, buf)));
 // OPTION TWO
         auto ptr_to_persistent_objectstore = mutils::from_bytes<decltype(persistent_objectstore)>(dsm, buf);
+        std::size_t offset = mutils::bytes_size(*ptr_to_persistent_objectstore);
+        auto ptr_to_staged_objects = mutils::from_bytes<decltype(staged_large_objects)>(dsm, buf + offset);
+        offset += mutils::bytes_size(*ptr_to_staged_objects);
+        auto ptr_to_staged_txns = mutils::from_bytes<decltype(staged_transactions)>(dsm, buf + offset);
         auto ptr_to_return = std::make_unique<PersistentLoggedObjectStore>(std::move(*ptr_to_persistent_objectstore));
+        ptr_to_return->staged_large_objects = std::move(*ptr_to_staged_objects);
+        ptr_to_return->staged_transactions = std::move(*ptr_to_staged_txns);
         ptr_to_persistent_objectstore.release(); // to avoid double free.
         return ptr_to_return;
     }
@@ -643,6 +2028,129 @@ static std::vector<node_id_t> parseReplicaList(
     return replicas;
 }
 
+// partition the configured replica list into shards
+// @PARAM replicas
+//     the full replica list from CONF_OBJECTSTORE_REPLICAS
+// @PARAM num_shards
+//     the shard count from CONF_OBJECTSTORE_SHARDS
+// @RETURN
+//     one replica list per shard. A replica's shard is its position in the
+//     configured list modulo the shard count, so the assignment is stable
+//     across views and identical on every node.
+static std::vector<std::vector<node_id_t>> partitionReplicasByShard(
+        const std::vector<node_id_t>& replicas, uint32_t num_shards) {
+    if(num_shards == 0 || num_shards > replicas.size()) {
+        dbg_default_error("Invalid shard count {} for {} replicas.", num_shards, replicas.size());
+        throw derecho::derecho_exception("Invalid ObjectStore shard count.");
+    }
+    std::vector<std::vector<node_id_t>> shards(num_shards);
+    for(std::size_t i = 0; i < replicas.size(); i++) {
+        shards[i % num_shards].push_back(replicas[i]);
+    }
+    return shards;
+}
+
+// find the shard a replica node belongs to
+// @RETURN
+//     the shard index, or -1 if the node is not in the replica list.
+static int32_t shardOfReplica(const std::vector<node_id_t>& replicas,
+                              node_id_t id, uint32_t num_shards) {
+    for(std::size_t i = 0; i < replicas.size(); i++) {
+        if(replicas[i] == id) {
+            return (int32_t)(i % num_shards);
+        }
+    }
+    return -1;
+}
+
+// key-to-shard routing. The oid is run through a 64-bit mix (the splitmix64
+// finalizer) before the modulus so that sequentially allocated object ids
+// spread across all shards instead of striping onto one. Shard membership
+// itself comes from the static replica list, so this fixed hash gives every
+// node (replica or client) the same consistent key-to-shard mapping without
+// any ring state to exchange.
+static inline uint32_t shardOfOID(const OID& oid, uint32_t num_shards) {
+    uint64_t x = oid;
+    x ^= x >> 30;
+    x *= 0xbf58476d1ce4e5b9ull;
+    x ^= x >> 27;
+    x *= 0x94d049bb133111ebull;
+    x ^= x >> 31;
+    return (uint32_t)(x % num_shards);
+}
+
+/**
+ * Runs the user's watcher callbacks on a dedicated dispatch thread instead of
+ * the delivery path, so a slow watcher cannot stall ordered delivery for the
+ * whole shard. The replicated objects enqueue each change (one object copy -
+ * the price of leaving the critical path) and the single dispatch thread
+ * drains the queue in enqueue order, which preserves per-key notification
+ * order. If a batch watcher is registered, each drain becomes one callback
+ * covering every change queued since the previous one; otherwise the
+ * per-change watcher is invoked for each entry in order.
+ */
+class WatcherDispatcher {
+    const ObjectWatcher user_watcher;
+    const ObjectBatchWatcher batch_watcher;
+    std::vector<std::pair<OID, Object>> pending_changes;
+    std::mutex queue_mutex;
+    std::condition_variable queue_cv;
+    std::thread dispatch_thread;
+    bool shutdown = false;
+
+public:
+    WatcherDispatcher(const ObjectWatcher& ow, const ObjectBatchWatcher& bow)
+            : user_watcher(ow), batch_watcher(bow) {
+        if(user_watcher || batch_watcher) {
+            dispatch_thread = std::thread(&WatcherDispatcher::dispatch_loop, this);
+        }
+    }
+
+    ~WatcherDispatcher() {
+        {
+            std::lock_guard<std::mutex> lock(queue_mutex);
+            shutdown = true;
+        }
+        queue_cv.notify_one();
+        if(dispatch_thread.joinable()) {
+            dispatch_thread.join();
+        }
+    }
+
+    void notify(const OID& oid, const Object& object) {
+        {
+            std::lock_guard<std::mutex> lock(queue_mutex);
+            pending_changes.emplace_back(oid, object);
+        }
+        queue_cv.notify_one();
+    }
+
+private:
+    void dispatch_loop() {
+        pthread_setname_np(pthread_self(), "os_watchers");
+        std::vector<std::pair<OID, Object>> batch;
+        while(true) {
+            {
+                std::unique_lock<std::mutex> lock(queue_mutex);
+                queue_cv.wait(lock, [this]() { return shutdown || !pending_changes.empty(); });
+                if(pending_changes.empty()) {
+                    // shutdown, and every queued change has been delivered
+                    return;
+                }
+                batch.swap(pending_changes);
+            }
+            if(batch_watcher) {
+                batch_watcher(batch);
+            } else {
+                for(const auto& [oid, object] : batch) {
+                    user_watcher(oid, object);
+                }
+            }
+            batch.clear();
+        }
+    }
+};
+
 class ObjectStoreService : public IObjectStoreService {
 private:
     enum OSSMode {
@@ -652,25 +2160,85 @@ private:
         PERSISTENT_LOGGED
     };
     OSSMode mode;
-    const ObjectWatcher& object_watcher;
+    // runs the user's watcher callbacks off the delivery path
+    WatcherDispatcher watcher_dispatcher;
+    // the watcher handed to the replicated objects: it only enqueues into the
+    // dispatcher, so the delivery path pays one object copy per change
+    const ObjectWatcher object_watcher;
     std::vector<node_id_t> replicas;
+    const uint32_t num_shards;
+    // the replica list partitioned by shard, fixed at startup
+    const std::vector<std::vector<node_id_t>> shard_replicas;
     const bool bReplica;
     const node_id_t myid;
-    derecho::Group<VolatileUnloggedObjectStore, PersistentLoggedObjectStore> group;
+    // the shard this node replicates, or -1 if it is a client
+    const int32_t my_shard;
+    // the client-side read cache (see _bio_get). Off by default because a
+    // validated cache read is replica-local consistency, not an ordered read.
+    const bool read_cache_enabled;
+    const std::size_t read_cache_capacity;
+    // the windowed put pipeline (see wio_put)
+    const std::size_t put_window_size;
+    const std::size_t put_batch_size;
+    // puts at or above this blob size bypass the ordered-send slot machinery:
+    // the bytes are staged on each replica over p2p first and the ordered
+    // multicast carries only (oid, handle), so object size no longer dictates
+    // the multicast window memory. 0 disables the hybrid path.
+    const uint64_t large_object_threshold;
+    // low half of the next staging handle; the high half is this node's id
+    std::atomic<uint64_t> next_large_handle{0};
+    // low half of the next cross-shard transaction id, issued like the
+    // staging handles so ids are unique group-wide
+    std::atomic<uint64_t> next_txn_id{0};
+    derecho::Group<VolatileUnloggedObjectStore, PersistentUnloggedObjectStore, PersistentLoggedObjectStore> group;
     // TODO: WHY do I need "write_mutex"? I should be able to update the data
     // concurrently from multiple threads. Right?
     std::mutex write_mutex;
+    std::map<OID, Object> read_cache;
+    std::mutex read_cache_mutex;
+
+    // a dispatched put batch whose completion is still outstanding
+    struct PendingPutBatch {
+        std::vector<OID> oids;
+        std::vector<put_completion_t> completions;
+        derecho::rpc::QueryResults<std::vector<std::tuple<version_t,uint64_t>>> results;
+        PendingPutBatch(std::vector<OID>&& _oids,
+                        std::vector<put_completion_t>&& _completions,
+                        derecho::rpc::QueryResults<std::vector<std::tuple<version_t,uint64_t>>>&& _results)
+                : oids(std::move(_oids)),
+                  completions(std::move(_completions)),
+                  results(std::move(_results)) {}
+    };
+    std::mutex put_window_mutex;
+    // puts accumulating toward the next batch, one buffer per shard since a
+    // batch rides a single ordered send
+    std::vector<std::vector<Object>> shard_put_buffer;
+    std::vector<std::vector<put_completion_t>> shard_put_completions;
+    std::deque<PendingPutBatch> put_window;
 
 public:
     // constructor
-    ObjectStoreService(const ObjectWatcher& ow) : mode(
+    ObjectStoreService(const ObjectWatcher& ow, const ObjectBatchWatcher& bow) : mode(
                                                           derecho::getConfBoolean(CONF_OBJECTSTORE_PERSISTED) ? (derecho::getConfBoolean(CONF_OBJECTSTORE_LOGGED) ? PERSISTENT_LOGGED : PERSISTENT_UNLOGGED) : (derecho::getConfBoolean(CONF_OBJECTSTORE_LOGGED) ? VOLATILE_LOGGED : VOLATILE_UNLOGGED)),
-                                                  object_watcher(ow),
+                                                  watcher_dispatcher(ow, bow),
+                                                  object_watcher((ow || bow)
+                                                                         ? ObjectWatcher([this](const OID& oid, const Object& object) {
+                                                                               watcher_dispatcher.notify(oid, object);
+                                                                           })
+                                                                         : ObjectWatcher{}),
                                                   replicas(parseReplicaList(derecho::getConfString(CONF_OBJECTSTORE_REPLICAS))),
+                                                  num_shards(derecho::hasCustomizedConfKey(CONF_OBJECTSTORE_SHARDS) ? derecho::getConfUInt32(CONF_OBJECTSTORE_SHARDS) : 1),
+                                                  shard_replicas(partitionReplicasByShard(replicas, num_shards)),
                                                   bReplica(std::find(replicas.begin(), replicas.end(),
                                                                      derecho::getConfUInt64(CONF_DERECHO_LOCAL_ID))
                                                            != replicas.end()),
                                                   myid(derecho::getConfUInt64(CONF_DERECHO_LOCAL_ID)),
+                                                  my_shard(shardOfReplica(replicas, myid, num_shards)),
+                                                  read_cache_enabled(derecho::hasCustomizedConfKey(CONF_OBJECTSTORE_READ_CACHE) && derecho::getConfBoolean(CONF_OBJECTSTORE_READ_CACHE)),
+                                                  read_cache_capacity(derecho::hasCustomizedConfKey(CONF_OBJECTSTORE_READ_CACHE_SIZE) ? derecho::getConfUInt64(CONF_OBJECTSTORE_READ_CACHE_SIZE) : 65536),
+                                                  put_window_size(derecho::hasCustomizedConfKey(CONF_OBJECTSTORE_PUT_WINDOW_SIZE) ? derecho::getConfUInt64(CONF_OBJECTSTORE_PUT_WINDOW_SIZE) : 16),
+                                                  put_batch_size(derecho::hasCustomizedConfKey(CONF_OBJECTSTORE_PUT_BATCH_SIZE) ? derecho::getConfUInt64(CONF_OBJECTSTORE_PUT_BATCH_SIZE) : 64),
+                                                  large_object_threshold(derecho::hasCustomizedConfKey(CONF_OBJECTSTORE_LARGE_OBJECT_THRESHOLD) ? derecho::getConfUInt64(CONF_OBJECTSTORE_LARGE_OBJECT_THRESHOLD) : (1ull << 20)),
                                                   group(
                                                           {},  // callback set
                                                           // derecho::SubgroupInfo
@@ -680,21 +2248,24 @@ public:
                                                                          derecho::View& curr_view) {
                                                                       derecho::subgroup_allocation_map_t subgroup_allocation;
                                                                       for(const auto& subgroup_type : subgroup_type_order) {
-                                                                          if(subgroup_type == std::type_index(typeid(VolatileUnloggedObjectStore)) || subgroup_type == std::type_index(typeid(PersistentLoggedObjectStore))) {
-                                                                              std::vector<node_id_t> active_replicas;
-                                                                              for(uint32_t i = 0; i < curr_view.members.size(); i++) {
-                                                                                  const node_id_t id = curr_view.members[i];
-                                                                                  if(!curr_view.failed[i] && std::find(replicas.begin(), replicas.end(), id) != replicas.end()) {
-                                                                                      active_replicas.push_back(id);
+                                                                          if(subgroup_type == std::type_index(typeid(VolatileUnloggedObjectStore)) || subgroup_type == std::type_index(typeid(PersistentUnloggedObjectStore)) || subgroup_type == std::type_index(typeid(PersistentLoggedObjectStore))) {
+                                                                              // one subgroup with one shard (subview) per configured shard; each
+                                                                              // shard must independently meet the minimum replication factor
+                                                                              derecho::subgroup_shard_layout_t subgroup_vector(1);
+                                                                              for(const auto& shard_members : shard_replicas) {
+                                                                                  std::vector<node_id_t> active_replicas;
+                                                                                  for(uint32_t i = 0; i < curr_view.members.size(); i++) {
+                                                                                      const node_id_t id = curr_view.members[i];
+                                                                                      if(!curr_view.failed[i] && std::find(shard_members.begin(), shard_members.end(), id) != shard_members.end()) {
+                                                                                          active_replicas.push_back(id);
+                                                                                      }
                                                                                   }
+                                                                                  if(active_replicas.size() < derecho::getConfUInt32(CONF_OBJECTSTORE_MIN_REPLICATION_FACTOR)) {
+                                                                                      throw derecho::subgroup_provisioning_exception();
+                                                                                  }
+                                                                                  subgroup_vector[0].emplace_back(curr_view.make_subview(active_replicas));
+                                                                                  curr_view.next_unassigned_rank += active_replicas.size();
                                                                               }
-                                                                              if(active_replicas.size() < derecho::getConfUInt32(CONF_OBJECTSTORE_MIN_REPLICATION_FACTOR)) {
-                                                                                  throw derecho::subgroup_provisioning_exception();
-                                                                              }
-
-                                                                              derecho::subgroup_shard_layout_t subgroup_vector(1);
-                                                                              subgroup_vector[0].emplace_back(curr_view.make_subview(active_replicas));
-                                                                              curr_view.next_unassigned_rank += active_replicas.size();
                                                                               subgroup_allocation.emplace(subgroup_type, std::move(subgroup_vector));
                                                                           } else {
                                                                               subgroup_allocation.emplace(subgroup_type, derecho::subgroup_shard_layout_t{});
@@ -706,12 +2277,15 @@ public:
                                                           std::vector<derecho::view_upcall_t>{},  // view up-calls
                                                           // factories ...
                                                           [this](persistent::PersistentRegistry*) { return std::make_unique<VolatileUnloggedObjectStore>(object_watcher); },
+                                                          [this](persistent::PersistentRegistry*) { return std::make_unique<PersistentUnloggedObjectStore>(object_watcher); },
                                                           [this](persistent::PersistentRegistry* pr) { return std::make_unique<PersistentLoggedObjectStore>(pr, *this); }) {
+        shard_put_buffer.resize(num_shards);
+        shard_put_completions.resize(num_shards);
         // Unimplemented yet:
-        if(mode == PERSISTENT_UNLOGGED || mode == VOLATILE_LOGGED) {
+        if(mode == VOLATILE_LOGGED) {
             // log it
             dbg_default_error("ObjectStoreService mode {} is not supported yet.", mode);
-            throw derecho::derecho_exception("Unimplmented ObjectStoreService mode: persistent_unlogged/volatile_logged.");
+            throw derecho::derecho_exception("Unimplmented ObjectStoreService mode: volatile_logged.");
         }
     }
 
@@ -719,18 +2293,136 @@ public:
         return bReplica;
     }
 
+    virtual uint32_t getNumShards() {
+        return num_shards;
+    }
+
+    virtual uint32_t shardOfKey(const OID& oid) {
+        return shardOfOID(oid, num_shards);
+    }
+
+    // pick a static mapped replica of the given shard to receive relayed
+    // requests. Use random mapping for load-balance?
+    inline node_id_t shardTarget(uint32_t shard) {
+        return shard_replicas[shard][myid % shard_replicas[shard].size()];
+    }
+
+    // true if _aio_get would fetch this key over p2p rather than through this
+    // node's own shard - the only case where the read cache pays off
+    inline bool isRemoteRead(const OID& oid, const bool& force_client) {
+        return !(bReplica && !force_client && (int32_t)shardOfKey(oid) == my_shard);
+    }
+
+    // read cache helpers. Invalidation of writes from other nodes is by the
+    // getVersion probe in _bio_get, not by notification: ObjectWatcher only
+    // fires on replicas, never on the clients that hold this cache.
+    inline std::optional<Object> cacheLookup(const OID& oid) {
+        std::lock_guard<std::mutex> guard(read_cache_mutex);
+        auto search = read_cache.find(oid);
+        if(search != read_cache.end()) {
+            return search->second;
+        }
+        return std::nullopt;
+    }
+
+    inline void cacheStore(const Object& object) {
+        std::lock_guard<std::mutex> guard(read_cache_mutex);
+        if(read_cache.size() >= read_cache_capacity && read_cache.find(object.oid) == read_cache.end()) {
+            // evict an arbitrary entry; a miss just costs one refetch
+            read_cache.erase(read_cache.begin());
+        }
+        read_cache[object.oid] = object;
+    }
+
+    inline void cacheInvalidate(const OID& oid) {
+        std::lock_guard<std::mutex> guard(read_cache_mutex);
+        read_cache.erase(oid);
+    }
+
+    // version probe for cache validation: a p2p round trip that ships a
+    // version tuple instead of the blob
+    template <typename T>
+    derecho::rpc::QueryResults<std::tuple<version_t,uint64_t>> _aio_get_version(const OID& oid, const bool& force_client) {
+        std::lock_guard<std::mutex> guard(write_mutex);
+        const uint32_t shard = shardOfKey(oid);
+        if(bReplica && !force_client) {
+            derecho::Replicated<T>& os_rpc_handle = group.template get_subgroup<T>();
+            node_id_t target = ((int32_t)shard == my_shard) ? myid : shardTarget(shard);
+            return std::move(os_rpc_handle.template p2p_send<RPC_NAME(getVersion)>(target, oid));
+        } else {
+            derecho::ExternalCaller<T>& os_p2p_handle = group.template get_nonmember_subgroup<T>();
+            return std::move(os_p2p_handle.template p2p_send<RPC_NAME(getVersion)>(shardTarget(shard), oid));
+        }
+    }
+
+    // hybrid large-object put: the blob is shipped to every replica of the
+    // owning shard over p2p and held under a fresh transfer handle; the
+    // ordered multicast then carries only (oid, handle). Delivery order is
+    // still fixed by the ordered message - the handle just tells each replica
+    // which staged bytes that slot installs - so a large put keeps put
+    // ordering without sizing the multicast window for the blob.
+    template <typename T>
+    derecho::rpc::QueryResults<std::tuple<version_t,uint64_t>> _aio_put_large(const Object& object, const bool& force_client) {
+        if(read_cache_enabled) {
+            cacheInvalidate(object.oid);
+        }
+        std::lock_guard<std::mutex> guard(write_mutex);
+        const uint32_t shard = shardOfKey(object.oid);
+        // handles must be unique group-wide since any node may issue them
+        const uint64_t handle = (static_cast<uint64_t>(myid) << 32) | (next_large_handle++ & 0xffffffffull);
+        // stage on every replica and wait for the acks before the ordered
+        // step, so the ordered message finds the bytes wherever it delivers
+        auto stage_on_all = [&](auto& rpc_handle) {
+            for(const node_id_t replica : shard_replicas[shard]) {
+                try {
+                    auto stage_results = rpc_handle.template p2p_send<RPC_NAME(stageLargeObject)>(replica, handle, object);
+                    for(auto& reply_pair : stage_results.get()) {
+                        reply_pair.second.get();
+                    }
+                } catch(derecho::derecho_exception& ex) {
+                    // a replica we cannot stage to has left the group, so it
+                    // will not see the ordered message either
+                    dbg_default_warn("large put staging skipped node {} (oid={}): {}", replica, object.oid, ex.what());
+                }
+            }
+        };
+        if(bReplica && !force_client) {
+            derecho::Replicated<T>& os_rpc_handle = group.template get_subgroup<T>();
+            stage_on_all(os_rpc_handle);
+            if((int32_t)shard == my_shard) {
+                return std::move(os_rpc_handle.template ordered_send<RPC_NAME(orderedPutLarge)>(object.oid, handle));
+            }
+            return std::move(os_rpc_handle.template p2p_send<RPC_NAME(putLarge)>(shardTarget(shard), object.oid, handle));
+        } else {
+            derecho::ExternalCaller<T>& os_p2p_handle = group.template get_nonmember_subgroup<T>();
+            stage_on_all(os_p2p_handle);
+            return std::move(os_p2p_handle.template p2p_send<RPC_NAME(putLarge)>(shardTarget(shard), object.oid, handle));
+        }
+    }
+
     template <typename T>
     derecho::rpc::QueryResults<std::tuple<version_t,uint64_t>> _aio_put(const Object& object, const bool& force_client) {
+        if(large_object_threshold > 0 && object.blob.size >= large_object_threshold) {
+            return this->template _aio_put_large<T>(object, force_client);
+        }
+        if(read_cache_enabled) {
+            // the version assigned by this write is not known yet; drop the
+            // entry and let the next read refill it
+            cacheInvalidate(object.oid);
+        }
         std::lock_guard<std::mutex> guard(write_mutex);
+        const uint32_t shard = shardOfKey(object.oid);
         if(bReplica && !force_client) {
-            // replica server can do ordered send
             derecho::Replicated<T>& os_rpc_handle = group.template get_subgroup<T>();
-            return std::move(os_rpc_handle.template ordered_send<RPC_NAME(orderedPut)>(object));
+            if((int32_t)shard == my_shard) {
+                // a replica of the owning shard can do ordered send
+                return std::move(os_rpc_handle.template ordered_send<RPC_NAME(orderedPut)>(object));
+            }
+            // a replica of another shard relays over p2p, like a client
+            return std::move(os_rpc_handle.template p2p_send<RPC_NAME(put)>(shardTarget(shard), object));
         } else {
-            // send request to a static mapped replica. Use random mapping for load-balance?
-            node_id_t target = replicas[myid % replicas.size()];
             derecho::ExternalCaller<T>& os_p2p_handle = group.get_nonmember_subgroup<T>();
-            return std::move(os_p2p_handle.template p2p_send<RPC_NAME(put)>(target, object));
+            return std::move(os_p2p_handle.template p2p_send<RPC_NAME(put)>(shardTarget(shard), object));
         }
     }
 
@@ -754,6 +2446,9 @@ public:
             case VOLATILE_UNLOGGED:
                 vRet = this->template _bio_put<VolatileUnloggedObjectStore>(object, force_client);
                 break;
+            case PERSISTENT_UNLOGGED:
+                vRet = this->template _bio_put<PersistentUnloggedObjectStore>(object, force_client);
+                break;
             case PERSISTENT_LOGGED:
                 vRet = this->template _bio_put<PersistentLoggedObjectStore>(object, force_client);
                 break;
@@ -769,6 +2464,8 @@ public:
         switch(this->mode) {
             case VOLATILE_UNLOGGED:
                 return this->template _aio_put<VolatileUnloggedObjectStore>(object, force_client);
+            case PERSISTENT_UNLOGGED:
+                return this->template _aio_put<PersistentUnloggedObjectStore>(object, force_client);
             case PERSISTENT_LOGGED:
                 return this->template _aio_put<PersistentLoggedObjectStore>(object, force_client);
             default:
@@ -779,16 +2476,22 @@ public:
 
     template <typename T>
     derecho::rpc::QueryResults<std::tuple<version_t,uint64_t>> _aio_remove(const OID& oid, const bool& force_client) {
+        if(read_cache_enabled) {
+            cacheInvalidate(oid);
+        }
         std::lock_guard<std::mutex> guard(write_mutex);
+        const uint32_t shard = shardOfKey(oid);
         if(bReplica && !force_client) {
-            // replica server can do ordered send
             derecho::Replicated<T>& os_rpc_handle = group.template get_subgroup<T>();
-            return std::move(os_rpc_handle.template ordered_send<RPC_NAME(orderedRemove)>(oid));
+            if((int32_t)shard == my_shard) {
+                // a replica of the owning shard can do ordered send
+                return std::move(os_rpc_handle.template ordered_send<RPC_NAME(orderedRemove)>(oid));
+            }
+            // a replica of another shard relays over p2p, like a client
+            return std::move(os_rpc_handle.template p2p_send<RPC_NAME(remove)>(shardTarget(shard), oid));
         } else {
-            // send request to a static mapped replica. Use random mapping for load-balance?
-            node_id_t target = replicas[myid % replicas.size()];
             derecho::ExternalCaller<T>& os_p2p_handle = group.get_nonmember_subgroup<T>();
-            return std::move(os_p2p_handle.template p2p_send<RPC_NAME(remove)>(target, oid));
+            return std::move(os_p2p_handle.template p2p_send<RPC_NAME(remove)>(shardTarget(shard), oid));
         }
     }
 
@@ -810,6 +2513,8 @@ public:
         switch(this->mode) {
             case VOLATILE_UNLOGGED:
                 return this->template _bio_remove<VolatileUnloggedObjectStore>(oid, force_client);
+            case PERSISTENT_UNLOGGED:
+                return this->template _bio_remove<PersistentUnloggedObjectStore>(oid, force_client);
             case PERSISTENT_LOGGED:
                 return this->template _bio_remove<PersistentLoggedObjectStore>(oid, force_client);
             default:
@@ -824,6 +2529,8 @@ public:
         switch(this->mode) {
             case VOLATILE_UNLOGGED:
                 return this->template _aio_remove<VolatileUnloggedObjectStore>(oid, force_client);
+            case PERSISTENT_UNLOGGED:
+                return this->template _aio_remove<PersistentUnloggedObjectStore>(oid, force_client);
             case PERSISTENT_LOGGED:
                 return this->template _aio_remove<PersistentLoggedObjectStore>(oid, force_client);
             default:
@@ -836,44 +2543,61 @@ public:
     template <typename T>
     derecho::rpc::QueryResults<const Object> _aio_get(const OID& oid, const version_t& ver, const bool& force_client) {
         std::lock_guard<std::mutex> guard(write_mutex);
+        const uint32_t shard = shardOfKey(oid);
         if(bReplica && !force_client) {
             derecho::Replicated<T>& os_rpc_handle = group.template get_subgroup<T>();
-            if(ver == INVALID_VERSION) {
-                // replica server can do ordered send
+            if((int32_t)shard == my_shard && ver == INVALID_VERSION) {
+                // a replica of the owning shard can do ordered send
                 return std::move(os_rpc_handle.template ordered_send<RPC_NAME(orderedGet)>(oid));
-            } else {
-                // send a local p2p send/query to access history versions
-                return std::move(os_rpc_handle.template p2p_send<RPC_NAME(get)>(myid, oid, ver));
             }
+            // keys owned by other shards relay over p2p; a versioned query of
+            // a locally owned key is a local p2p send to access history versions
+            node_id_t target = ((int32_t)shard == my_shard) ? myid : shardTarget(shard);
+            return std::move(os_rpc_handle.template p2p_send<RPC_NAME(get)>(target, oid, ver));
         } else {
-            // Send request to a static mapped replica. Use random mapping for load-balance?
-            node_id_t target = replicas[myid % replicas.size()];
             derecho::ExternalCaller<T>& os_p2p_handle = group.template get_nonmember_subgroup<T>();
-            return std::move(os_p2p_handle.template p2p_send<RPC_NAME(get)>(target, oid, ver));
+            return std::move(os_p2p_handle.template p2p_send<RPC_NAME(get)>(shardTarget(shard), oid, ver));
         }
     }
 
     template <typename T>
     derecho::rpc::QueryResults<const Object> _aio_get(const OID& oid, const uint64_t& ts_us) {
         std::lock_guard<std::mutex> guard(write_mutex);
+        const uint32_t shard = shardOfKey(oid);
         if (bReplica) {
-            // send to myself.
+            // send to myself if this shard owns the key, otherwise to a replica
+            // of the owning shard
             derecho::Replicated<T>& os_rpc_handle = group.template get_subgroup<T>();
-            return std::move(os_rpc_handle.template p2p_send<RPC_NAME(get_by_time)>(myid, oid, ts_us));
+            node_id_t target = ((int32_t)shard == my_shard) ? myid : shardTarget(shard);
+            return std::move(os_rpc_handle.template p2p_send<RPC_NAME(get_by_time)>(target, oid, ts_us));
         } else {
-            // Send request to a static mapped replica. Use random mapping for load-balance?
-            node_id_t target = replicas[myid % replicas.size()];
             derecho::ExternalCaller<T>& os_p2p_handle = group.template get_nonmember_subgroup<T>();
-            return std::move(os_p2p_handle.template p2p_send<RPC_NAME(get_by_time)>(target, oid, ts_us));
+            return std::move(os_p2p_handle.template p2p_send<RPC_NAME(get_by_time)>(shardTarget(shard), oid, ts_us));
         }
     }
 
     template <typename T>
     Object _bio_get(const OID& oid, const version_t& ver, const bool& force_client) {
+        const bool cacheable = read_cache_enabled && ver == INVALID_VERSION && isRemoteRead(oid, force_client);
+        if(cacheable) {
+            std::optional<Object> cached = cacheLookup(oid);
+            if(cached) {
+                // validate the cached copy with a version probe
+                derecho::rpc::QueryResults<std::tuple<version_t,uint64_t>> probe = this->template _aio_get_version<T>(oid, force_client);
+                decltype(probe)::ReplyMap& probe_replies = probe.get();
+                if(probe_replies.begin()->second.get() == cached->ver) {
+                    return std::move(*cached);
+                }
+            }
+        }
         derecho::rpc::QueryResults<const Object> results = this->template _aio_get<T>(oid, ver, force_client);
         decltype(results)::ReplyMap& replies = results.get();
         // should we check reply consistency?
-        return replies.begin()->second.get();
+        Object object = replies.begin()->second.get();
+        if(cacheable && object.oid != INV_OID) {
+            cacheStore(object);
+        }
+        return object;
     }
 
     template <typename T>
@@ -888,6 +2612,8 @@ public:
         switch(this->mode) {
             case VOLATILE_UNLOGGED:
                 return this->template _bio_get<VolatileUnloggedObjectStore>(oid, ver, force_client);
+            case PERSISTENT_UNLOGGED:
+                return this->template _bio_get<PersistentUnloggedObjectStore>(oid, ver, force_client);
             case PERSISTENT_LOGGED:
                 return this->template _bio_get<PersistentLoggedObjectStore>(oid, ver, force_client);
             default:
@@ -901,6 +2627,8 @@ public:
         switch(this->mode) {
             case VOLATILE_UNLOGGED:
                 return this->template _bio_get<VolatileUnloggedObjectStore>(oid, ts_us);
+            case PERSISTENT_UNLOGGED:
+                return this->template _bio_get<PersistentUnloggedObjectStore>(oid, ts_us);
             case PERSISTENT_LOGGED:
                 return this->template _bio_get<PersistentLoggedObjectStore>(oid, ts_us);
             default:
@@ -914,6 +2642,8 @@ public:
         switch(this->mode) {
             case VOLATILE_UNLOGGED:
                 return this->template _aio_get<VolatileUnloggedObjectStore>(oid, ver, force_client);
+            case PERSISTENT_UNLOGGED:
+                return this->template _aio_get<PersistentUnloggedObjectStore>(oid, ver, force_client);
             case PERSISTENT_LOGGED:
                 return this->template _aio_get<PersistentLoggedObjectStore>(oid, ver, force_client);
             default:
@@ -927,6 +2657,8 @@ public:
         switch(this->mode) {
             case VOLATILE_UNLOGGED:
                 return this->template _aio_get<VolatileUnloggedObjectStore>(oid, ts_us);
+            case PERSISTENT_UNLOGGED:
+                return this->template _aio_get<PersistentUnloggedObjectStore>(oid, ts_us);
             case PERSISTENT_LOGGED:
                 return this->template _aio_get<PersistentLoggedObjectStore>(oid, ts_us);
             default:
@@ -935,6 +2667,405 @@ public:
         }
     }
 
+    // blocking multi-put. The non-blocking puts are posted for all objects
+    // (each routed to its owning shard) before any reply is awaited, so
+    // writes to different shards run through their ordered-send pipelines in
+    // parallel.
+    virtual std::vector<std::tuple<version_t,uint64_t>> bio_multi_put(const std::vector<Object>& objects, const bool& force_client) {
+        dbg_default_debug("bio_multi_put {} objects, mode={}, force_client={}", objects.size(), mode, force_client);
+        std::vector<derecho::rpc::QueryResults<std::tuple<version_t,uint64_t>>> pending;
+        pending.reserve(objects.size());
+        for(const Object& object : objects) {
+            pending.emplace_back(this->aio_put(object, force_client));
+        }
+        std::vector<std::tuple<version_t,uint64_t>> versions;
+        versions.reserve(objects.size());
+        for(auto& results : pending) {
+            derecho::rpc::QueryResults<std::tuple<version_t,uint64_t>>::ReplyMap& replies = results.get();
+            std::tuple<version_t,uint64_t> vRet(INVALID_VERSION,0);
+            for(auto& reply_pair : replies) {
+                vRet = reply_pair.second.get();
+            }
+            versions.push_back(vRet);
+        }
+        return versions;
+    }
+
+    // transactional put send helpers, routed like _aio_put: ordered send for
+    // this node's own shard, p2p relay otherwise
+    template <typename T>
+    derecho::rpc::QueryResults<bool> _aio_prepare_txn(const uint64_t& txid, const std::vector<Object>& batch,
+                                                      const uint32_t& shard, const bool& force_client) {
+        std::lock_guard<std::mutex> guard(write_mutex);
+        if(bReplica && !force_client) {
+            derecho::Replicated<T>& os_rpc_handle = group.template get_subgroup<T>();
+            if((int32_t)shard == my_shard) {
+                return std::move(os_rpc_handle.template ordered_send<RPC_NAME(orderedPrepareTxn)>(txid, batch));
+            }
+            return std::move(os_rpc_handle.template p2p_send<RPC_NAME(prepareTxn)>(shardTarget(shard), txid, batch));
+        } else {
+            derecho::ExternalCaller<T>& os_p2p_handle = group.template get_nonmember_subgroup<T>();
+            return std::move(os_p2p_handle.template p2p_send<RPC_NAME(prepareTxn)>(shardTarget(shard), txid, batch));
+        }
+    }
+
+    template <typename T>
+    derecho::rpc::QueryResults<std::vector<std::tuple<version_t,uint64_t>>> _aio_commit_txn(const uint64_t& txid,
+                                                                                            const uint32_t& shard, const bool& force_client) {
+        std::lock_guard<std::mutex> guard(write_mutex);
+        if(bReplica && !force_client) {
+            derecho::Replicated<T>& os_rpc_handle = group.template get_subgroup<T>();
+            if((int32_t)shard == my_shard) {
+                return std::move(os_rpc_handle.template ordered_send<RPC_NAME(orderedCommitTxn)>(txid));
+            }
+            return std::move(os_rpc_handle.template p2p_send<RPC_NAME(commitTxn)>(shardTarget(shard), txid));
+        } else {
+            derecho::ExternalCaller<T>& os_p2p_handle = group.template get_nonmember_subgroup<T>();
+            return std::move(os_p2p_handle.template p2p_send<RPC_NAME(commitTxn)>(shardTarget(shard), txid));
+        }
+    }
+
+    template <typename T>
+    derecho::rpc::QueryResults<bool> _aio_abort_txn(const uint64_t& txid, const uint32_t& shard, const bool& force_client) {
+        std::lock_guard<std::mutex> guard(write_mutex);
+        if(bReplica && !force_client) {
+            derecho::Replicated<T>& os_rpc_handle = group.template get_subgroup<T>();
+            if((int32_t)shard == my_shard) {
+                return std::move(os_rpc_handle.template ordered_send<RPC_NAME(orderedAbortTxn)>(txid));
+            }
+            return std::move(os_rpc_handle.template p2p_send<RPC_NAME(abortTxn)>(shardTarget(shard), txid));
+        } else {
+            derecho::ExternalCaller<T>& os_p2p_handle = group.template get_nonmember_subgroup<T>();
+            return std::move(os_p2p_handle.template p2p_send<RPC_NAME(abortTxn)>(shardTarget(shard), txid));
+        }
+    }
+
+    template <typename T>
+    std::vector<std::tuple<version_t,uint64_t>> _bio_txn_put(const std::vector<Object>& objects, const bool& force_client) {
+        // assign each object to its owning shard, remembering positions so
+        // the returned versions align with the input
+        std::vector<std::vector<Object>> shard_objects(num_shards);
+        std::vector<std::vector<std::size_t>> shard_positions(num_shards);
+        for(std::size_t i = 0; i < objects.size(); i++) {
+            const uint32_t shard = shardOfKey(objects[i].oid);
+            shard_objects[shard].push_back(objects[i]);
+            shard_positions[shard].push_back(i);
+        }
+        if(read_cache_enabled) {
+            for(const Object& object : objects) {
+                cacheInvalidate(object.oid);
+            }
+        }
+        const uint64_t txid = (static_cast<uint64_t>(myid) << 32) | (next_txn_id++ & 0xffffffffull);
+        // barrier phase one: every involved shard stages its portion with one
+        // ordered message; the prepares are posted before any ack is awaited,
+        // so the staging runs in parallel across shards
+        std::vector<std::pair<uint32_t, derecho::rpc::QueryResults<bool>>> prepares;
+        for(uint32_t shard = 0; shard < num_shards; shard++) {
+            if(!shard_objects[shard].empty()) {
+                prepares.emplace_back(shard,
+                                      this->template _aio_prepare_txn<T>(txid, shard_objects[shard], shard, force_client));
+            }
+        }
+        bool prepared = true;
+        for(auto& [shard, results] : prepares) {
+            try {
+                for(auto& reply_pair : results.get()) {
+                    prepared = reply_pair.second.get() && prepared;
+                }
+            } catch(derecho::derecho_exception& ex) {
+                dbg_default_error("txn 0x{:x}: prepare failed on shard {}: {}", txid, shard, ex.what());
+                prepared = false;
+            }
+        }
+        if(!prepared) {
+            // roll back whatever did stage
+            for(auto& [shard, results] : prepares) {
+                try {
+                    auto abort_results = this->template _aio_abort_txn<T>(txid, shard, force_client);
+                    for(auto& reply_pair : abort_results.get()) {
+                        reply_pair.second.get();
+                    }
+                } catch(derecho::derecho_exception& ex) {
+                    dbg_default_warn("txn 0x{:x}: abort on shard {} failed: {}", txid, shard, ex.what());
+                }
+            }
+            return std::vector<std::tuple<version_t,uint64_t>>(objects.size(),
+                                                               std::tuple<version_t,uint64_t>(INVALID_VERSION,0));
+        }
+        // barrier phase two: every shard holds the staged batch, so the
+        // commits cannot miss; posted in parallel like the prepares
+        std::vector<std::pair<uint32_t, derecho::rpc::QueryResults<std::vector<std::tuple<version_t,uint64_t>>>>> commits;
+        for(auto& [shard, results] : prepares) {
+            commits.emplace_back(shard, this->template _aio_commit_txn<T>(txid, shard, force_client));
+        }
+        std::vector<std::tuple<version_t,uint64_t>> versions(objects.size(),
+                                                             std::tuple<version_t,uint64_t>(INVALID_VERSION,0));
+        for(auto& [shard, results] : commits) {
+            std::vector<std::tuple<version_t,uint64_t>> shard_versions;
+            for(auto& reply_pair : results.get()) {
+                shard_versions = reply_pair.second.get();
+            }
+            for(std::size_t i = 0; i < shard_positions[shard].size() && i < shard_versions.size(); i++) {
+                versions[shard_positions[shard][i]] = shard_versions[i];
+            }
+        }
+        return versions;
+    }
+
+    // blocking transactional multi-put: stage on every involved shard, then
+    // commit everywhere once all shards have staged. One prepare and one
+    // commit message per shard regardless of batch size, so the coordination
+    // cost amortizes over the batch.
+    virtual std::vector<std::tuple<version_t,uint64_t>> bio_txn_put(const std::vector<Object>& objects, const bool& force_client) {
+        dbg_default_debug("bio_txn_put {} objects, mode={}, force_client={}", objects.size(), mode, force_client);
+        switch(this->mode) {
+            case VOLATILE_UNLOGGED:
+                return this->template _bio_txn_put<VolatileUnloggedObjectStore>(objects, force_client);
+            case PERSISTENT_UNLOGGED:
+                return this->template _bio_txn_put<PersistentUnloggedObjectStore>(objects, force_client);
+            case PERSISTENT_LOGGED:
+                return this->template _bio_txn_put<PersistentLoggedObjectStore>(objects, force_client);
+            default:
+                dbg_default_error("Cannot execute 'txn_put' in unsupported mode {}.", mode);
+                throw derecho::derecho_exception("Cannot execute 'txn_put' in unsupported mode");
+        }
+    }
+
+    // the reply byte budget for chunked batch reads: the configured p2p
+    // reply payload limit, minus headroom for the reply headers and the
+    // container framing
+    inline uint64_t replyChunkBudget() {
+        const uint64_t max_reply = derecho::getConfUInt64(CONF_DERECHO_MAX_P2P_REPLY_PAYLOAD_SIZE);
+        return (max_reply > 1024) ? (max_reply - 1024) : (max_reply / 2);
+    }
+
+    // how many OIDs fit in one batch-read request, by the same logic
+    inline std::size_t requestChunkOIDCount() {
+        const uint64_t max_request = derecho::getConfUInt64(CONF_DERECHO_MAX_P2P_REQUEST_PAYLOAD_SIZE);
+        const uint64_t budget = (max_request > 1024) ? (max_request - 1024) : (max_request / 2);
+        return std::max<std::size_t>(1, budget / sizeof(OID));
+    }
+
+    template <typename T>
+    derecho::rpc::QueryResults<std::vector<Object>> _aio_get_batch(const std::vector<OID>& oids, const uint64_t& max_bytes,
+                                                                   const uint32_t& shard, const bool& force_client) {
+        std::lock_guard<std::mutex> guard(write_mutex);
+        if(bReplica && !force_client) {
+            derecho::Replicated<T>& os_rpc_handle = group.template get_subgroup<T>();
+            node_id_t target = ((int32_t)shard == my_shard) ? myid : shardTarget(shard);
+            return std::move(os_rpc_handle.template p2p_send<RPC_NAME(getBatch)>(target, oids, max_bytes));
+        } else {
+            derecho::ExternalCaller<T>& os_p2p_handle = group.template get_nonmember_subgroup<T>();
+            return std::move(os_p2p_handle.template p2p_send<RPC_NAME(getBatch)>(shardTarget(shard), oids, max_bytes));
+        }
+    }
+
+    template <typename T>
+    derecho::rpc::QueryResults<std::vector<Object>> _aio_scan_chunk(const OID& from, const OID& end_oid, const uint64_t& max_bytes,
+                                                                    const uint32_t& shard, const bool& force_client) {
+        std::lock_guard<std::mutex> guard(write_mutex);
+        if(bReplica && !force_client) {
+            derecho::Replicated<T>& os_rpc_handle = group.template get_subgroup<T>();
+            node_id_t target = ((int32_t)shard == my_shard) ? myid : shardTarget(shard);
+            return std::move(os_rpc_handle.template p2p_send<RPC_NAME(scanChunk)>(target, from, end_oid, max_bytes));
+        } else {
+            derecho::ExternalCaller<T>& os_p2p_handle = group.template get_nonmember_subgroup<T>();
+            return std::move(os_p2p_handle.template p2p_send<RPC_NAME(scanChunk)>(shardTarget(shard), from, end_oid, max_bytes));
+        }
+    }
+
+    template <typename T>
+    std::map<OID, Object> _bio_multi_get(const std::vector<OID>& oids, const bool& force_client) {
+        // group the keys by owning shard, then pull each shard's objects in
+        // reply-sized chunks
+        std::vector<std::vector<OID>> shard_oids(num_shards);
+        for(const OID& oid : oids) {
+            shard_oids[shardOfKey(oid)].push_back(oid);
+        }
+        const uint64_t reply_budget = replyChunkBudget();
+        const std::size_t request_chunk = requestChunkOIDCount();
+        std::map<OID, Object> results;
+        for(uint32_t shard = 0; shard < num_shards; shard++) {
+            std::size_t offset = 0;
+            while(offset < shard_oids[shard].size()) {
+                const std::size_t count = std::min(request_chunk, shard_oids[shard].size() - offset);
+                std::vector<OID> chunk(shard_oids[shard].begin() + offset,
+                                       shard_oids[shard].begin() + offset + count);
+                derecho::rpc::QueryResults<std::vector<Object>> query
+                        = this->template _aio_get_batch<T>(chunk, reply_budget, shard, force_client);
+                decltype(query)::ReplyMap& replies = query.get();
+                std::vector<Object> batch = replies.begin()->second.get();
+                // the reply covers a prefix of the chunk; re-request the rest
+                for(std::size_t i = 0; i < batch.size(); i++) {
+                    results.emplace(chunk[i], std::move(batch[i]));
+                }
+                offset += batch.size();
+            }
+        }
+        return results;
+    }
+
+    template <typename T>
+    std::map<OID, Object> _bio_scan(const OID& begin_oid, const OID& end_oid, const bool& force_client) {
+        const uint64_t reply_budget = replyChunkBudget();
+        std::map<OID, Object> results;
+        // every shard can own keys in the range, so each is scanned
+        for(uint32_t shard = 0; shard < num_shards; shard++) {
+            OID from = begin_oid;
+            while(true) {
+                derecho::rpc::QueryResults<std::vector<Object>> query
+                        = this->template _aio_scan_chunk<T>(from, end_oid, reply_budget, shard, force_client);
+                decltype(query)::ReplyMap& replies = query.get();
+                std::vector<Object> batch = replies.begin()->second.get();
+                if(batch.empty()) {
+                    break;
+                }
+                const OID last = batch.back().oid;
+                for(Object& object : batch) {
+                    results.emplace(object.oid, std::move(object));
+                }
+                if(last >= end_oid) {
+                    break;
+                }
+                from = last + 1;
+            }
+        }
+        return results;
+    }
+
+    // blocking multi-get: one batched request per shard per reply-sized
+    // chunk instead of one round trip per key. Like the read cache, batch
+    // reads are local to the contacted replica, not ordered.
+    virtual std::map<OID, Object> bio_multi_get(const std::vector<OID>& oids, const bool& force_client) {
+        dbg_default_debug("bio_multi_get {} keys, mode={}, force_client={}", oids.size(), mode, force_client);
+        switch(this->mode) {
+            case VOLATILE_UNLOGGED:
+                return this->template _bio_multi_get<VolatileUnloggedObjectStore>(oids, force_client);
+            case PERSISTENT_UNLOGGED:
+                return this->template _bio_multi_get<PersistentUnloggedObjectStore>(oids, force_client);
+            case PERSISTENT_LOGGED:
+                return this->template _bio_multi_get<PersistentLoggedObjectStore>(oids, force_client);
+            default:
+                dbg_default_error("Cannot execute 'multi_get' in unsupported mode {}.", mode);
+                throw derecho::derecho_exception("Cannot execute 'multi_get' in unsupported mode");
+        }
+    }
+
+    // blocking ordered range scan, chunked the same way
+    virtual std::map<OID, Object> bio_scan(const OID& begin_oid, const OID& end_oid, const bool& force_client) {
+        dbg_default_debug("bio_scan range=[{},{}], mode={}, force_client={}", begin_oid, end_oid, mode, force_client);
+        switch(this->mode) {
+            case VOLATILE_UNLOGGED:
+                return this->template _bio_scan<VolatileUnloggedObjectStore>(begin_oid, end_oid, force_client);
+            case PERSISTENT_UNLOGGED:
+                return this->template _bio_scan<PersistentUnloggedObjectStore>(begin_oid, end_oid, force_client);
+            case PERSISTENT_LOGGED:
+                return this->template _bio_scan<PersistentLoggedObjectStore>(begin_oid, end_oid, force_client);
+            default:
+                dbg_default_error("Cannot execute 'scan' in unsupported mode {}.", mode);
+                throw derecho::derecho_exception("Cannot execute 'scan' in unsupported mode");
+        }
+    }
+
+    // batch put send, routed like _aio_put but carrying a whole batch
+    template <typename T>
+    derecho::rpc::QueryResults<std::vector<std::tuple<version_t,uint64_t>>> _aio_put_batch(const std::vector<Object>& batch, const uint32_t& shard) {
+        std::lock_guard<std::mutex> guard(write_mutex);
+        if(bReplica && (int32_t)shard == my_shard) {
+            derecho::Replicated<T>& os_rpc_handle = group.template get_subgroup<T>();
+            return std::move(os_rpc_handle.template ordered_send<RPC_NAME(orderedPutBatch)>(batch));
+        } else if(bReplica) {
+            derecho::Replicated<T>& os_rpc_handle = group.template get_subgroup<T>();
+            return std::move(os_rpc_handle.template p2p_send<RPC_NAME(putBatch)>(shardTarget(shard), batch));
+        } else {
+            derecho::ExternalCaller<T>& os_p2p_handle = group.template get_nonmember_subgroup<T>();
+            return std::move(os_p2p_handle.template p2p_send<RPC_NAME(putBatch)>(shardTarget(shard), batch));
+        }
+    }
+
+    // await the oldest outstanding batch and fire its completions.
+    // put_window_mutex must be held.
+    void completeOldestBatch() {
+        PendingPutBatch batch = std::move(put_window.front());
+        put_window.pop_front();
+        decltype(batch.results)::ReplyMap& replies = batch.results.get();
+        std::vector<std::tuple<version_t,uint64_t>> versions;
+        for(auto& reply_pair : replies) {
+            versions = reply_pair.second.get();
+        }
+        for(std::size_t i = 0; i < batch.oids.size(); i++) {
+            if(batch.completions[i]) {
+                batch.completions[i](batch.oids[i],
+                                     (i < versions.size()) ? versions[i]
+                                                           : std::tuple<version_t,uint64_t>(INVALID_VERSION,0));
+            }
+        }
+    }
+
+    // send one shard's accumulated puts as a single batch, making room in
+    // the window first. put_window_mutex must be held.
+    void dispatchShardBatch(const uint32_t& shard) {
+        if(shard_put_buffer[shard].empty()) {
+            return;
+        }
+        while(put_window.size() >= put_window_size) {
+            completeOldestBatch();
+        }
+        std::vector<Object> batch;
+        batch.swap(shard_put_buffer[shard]);
+        std::vector<put_completion_t> completions;
+        completions.swap(shard_put_completions[shard]);
+        std::vector<OID> oids;
+        oids.reserve(batch.size());
+        for(const Object& object : batch) {
+            oids.push_back(object.oid);
+        }
+        switch(this->mode) {
+            case VOLATILE_UNLOGGED:
+                put_window.emplace_back(std::move(oids), std::move(completions),
+                                        this->template _aio_put_batch<VolatileUnloggedObjectStore>(batch, shard));
+                break;
+            case PERSISTENT_UNLOGGED:
+                put_window.emplace_back(std::move(oids), std::move(completions),
+                                        this->template _aio_put_batch<PersistentUnloggedObjectStore>(batch, shard));
+                break;
+            case PERSISTENT_LOGGED:
+                put_window.emplace_back(std::move(oids), std::move(completions),
+                                        this->template _aio_put_batch<PersistentLoggedObjectStore>(batch, shard));
+                break;
+            default:
+                dbg_default_error("Cannot execute 'put' in unsupported mode {}.", mode);
+                throw derecho::derecho_exception("Cannot execute 'put' in unsupported mode");
+        }
+    }
+
+    // windowed put
+    virtual void wio_put(const Object& object, const put_completion_t& completion) {
+        dbg_default_debug("wio_put object id={}, mode={}", object.oid, mode);
+        if(read_cache_enabled) {
+            cacheInvalidate(object.oid);
+        }
+        std::lock_guard<std::mutex> guard(put_window_mutex);
+        const uint32_t shard = shardOfKey(object.oid);
+        shard_put_buffer[shard].push_back(object);
+        shard_put_completions[shard].push_back(completion);
+        if(shard_put_buffer[shard].size() >= put_batch_size) {
+            dispatchShardBatch(shard);
+        }
+    }
+
+    // drain the put pipeline
+    virtual void wio_flush() {
+        std::lock_guard<std::mutex> guard(put_window_mutex);
+        for(uint32_t shard = 0; shard < num_shards; shard++) {
+            dispatchShardBatch(shard);
+        }
+        while(!put_window.empty()) {
+            completeOldestBatch();
+        }
+    }
+
     virtual void leave(bool group_shutdown) {
         if(group_shutdown) {
             group.barrier_sync();
@@ -947,7 +3078,8 @@ public:
     }
 
     // get singleton
-    static IObjectStoreService& get(int argc, char** argv, const ObjectWatcher& ow = {});
+    static IObjectStoreService& get(int argc, char** argv, const ObjectWatcher& ow = {},
+                                    const ObjectBatchWatcher& bow = {});
 };
 
 // The singleton unique pointer
@@ -956,12 +3088,13 @@ std::shared_ptr<IObjectStoreService> IObjectStoreService::singleton;
 // get the singleton
 // NOTE: caller only get access to this member object. The ownership of this
 // object is NOT transferred.
-IObjectStoreService& IObjectStoreService::getObjectStoreService(int argc, char** argv, const ObjectWatcher& ow) {
+IObjectStoreService& IObjectStoreService::getObjectStoreService(int argc, char** argv, const ObjectWatcher& ow,
+                                                                const ObjectBatchWatcher& bow) {
     if(IObjectStoreService::singleton.get() == nullptr) {
         // step 1: initialize the configuration
         derecho::Conf::initialize(argc, argv);
         // step 2: create the group resources
-        IObjectStoreService::singleton = std::make_shared<ObjectStoreService>(ow);
+        IObjectStoreService::singleton = std::make_shared<ObjectStoreService>(ow, bow);
     }
 
     return *IObjectStoreService::singleton.get();
@@ -0,0 +1,57 @@
+#include <derecho/persistent/detail/Crc32c.hpp>
+
+#ifdef __SSE4_2__
+#include <nmmintrin.h>
+#endif
+
+namespace persistent {
+namespace checksum {
+
+#ifndef __SSE4_2__
+// slice-by-one lookup table for the Castagnoli polynomial (reflected:
+// 0x82f63b78), built once on first use.
+static const uint32_t* crc32c_table() noexcept(true) {
+    static uint32_t table[256];
+    static bool initialized = false;
+    if(!initialized) {
+        for(uint32_t i = 0; i < 256; i++) {
+            uint32_t c = i;
+            for(int k = 0; k < 8; k++) {
+                c = (c & 1) ? (0x82f63b78u ^ (c >> 1)) : (c >> 1);
+            }
+            table[i] = c;
+        }
+        initialized = true;
+    }
+    return table;
+}
+#endif  //__SSE4_2__
+
+uint32_t crc32c(const uint32_t crc, const void* data, const size_t size) noexcept(true) {
+    uint32_t c = ~crc;
+    const uint8_t* p = (const uint8_t*)data;
+    size_t remaining = size;
+#ifdef __SSE4_2__
+    while(remaining >= sizeof(uint64_t)) {
+        uint64_t chunk;
+        __builtin_memcpy(&chunk, p, sizeof(chunk));
+        c = (uint32_t)_mm_crc32_u64(c, chunk);
+        p += sizeof(uint64_t);
+        remaining -= sizeof(uint64_t);
+    }
+    while(remaining > 0) {
+        c = _mm_crc32_u8(c, *p++);
+        remaining--;
+    }
+#else
+    const uint32_t* table = crc32c_table();
+    while(remaining > 0) {
+        c = table[(c ^ *p++) & 0xff] ^ (c >> 8);
+        remaining--;
+    }
+#endif  //__SSE4_2__
+    return ~c;
+}
+
+}  // namespace checksum
+}  // namespace persistent
@@ -1,6 +1,11 @@
 #include <derecho/persistent/detail/FilePersistLog.hpp>
+#include <derecho/persistent/detail/Crc32c.hpp>
+#include <derecho/persistent/detail/LogCompression.hpp>
+#include <derecho/persistent/detail/SharedLogGroup.hpp>
 #include <derecho/persistent/detail/util.hpp>
 #include <derecho/conf/conf.hpp>
+#include <algorithm>
+#include <atomic>
 #include <dirent.h>
 #include <errno.h>
 #include <fcntl.h>
@@ -9,7 +14,10 @@
 #include <string>
 #include <sys/mman.h>
 #include <sys/stat.h>
+#include <thread>
+#include <tuple>
 #include <unistd.h>
+#include <vector>
 
 #if __GNUC__ > 7
 #include <filesystem>
@@ -36,12 +44,18 @@ FilePersistLog::FilePersistLog(const string& name, const string& dataPath) noexc
                                                                                              m_sMetaFile(dataPath + "/" + name + "." + META_FILE_SUFFIX),
                                                                                              m_sLogFile(dataPath + "/" + name + "." + LOG_FILE_SUFFIX),
                                                                                              m_sDataFile(dataPath + "/" + name + "." + DATA_FILE_SUFFIX),
+                                                                                             m_sCkptFile(dataPath + "/" + name + "." + CKPT_FILE_SUFFIX),
                                                                                              m_iMaxLogEntry(derecho::getConfUInt64(CONF_PERS_MAX_LOG_ENTRY)),
                                                                                              m_iMaxDataSize(derecho::getConfUInt64(CONF_PERS_MAX_DATA_SIZE)),
+                                                                                             m_bCompression(derecho::getConfBoolean(CONF_PERS_COMPRESSION)),
+                                                                                             m_pGroup(nullptr),
+                                                                                             m_iLogSectionOffset(0),
+                                                                                             m_iDataSectionOffset(0),
                                                                                              m_iLogFileDesc(-1),
                                                                                              m_iDataFileDesc(-1),
                                                                                              m_pLog(MAP_FAILED),
-                                                                                             m_pData(MAP_FAILED) {
+                                                                                             m_pData(MAP_FAILED),
+                                                                                             m_trimGeneration(0) {
     if(pthread_rwlock_init(&this->m_rwlock, NULL) != 0) {
         throw PERSIST_EXP_RWLOCK_INIT(errno);
     }
@@ -56,6 +70,39 @@ FilePersistLog::FilePersistLog(const string& name, const string& dataPath) noexc
     dbg_default_trace("{0} constructor: after load()", name);
 }
 
+FilePersistLog::FilePersistLog(const string& name, const string& dataPath,
+                               const std::shared_ptr<SharedLogGroup>& group) noexcept(false)
+        : PersistLog(name),
+          m_sDataPath(dataPath),
+          m_sMetaFile(dataPath + "/" + name + "." + META_FILE_SUFFIX),
+          m_sLogFile(group->getLogFilePath()),
+          m_sDataFile(group->getDataFilePath()),
+          m_sCkptFile(dataPath + "/" + name + "." + CKPT_FILE_SUFFIX),
+          m_iMaxLogEntry(derecho::getConfUInt64(CONF_PERS_MAX_LOG_ENTRY)),
+          m_iMaxDataSize(derecho::getConfUInt64(CONF_PERS_MAX_DATA_SIZE)),
+          m_bCompression(derecho::getConfBoolean(CONF_PERS_COMPRESSION)),
+          m_pGroup(group),
+          m_iLogSectionOffset(0),
+          m_iDataSectionOffset(0),
+          m_iLogFileDesc(-1),
+          m_iDataFileDesc(-1),
+          m_pLog(MAP_FAILED),
+          m_pData(MAP_FAILED),
+          m_trimGeneration(0) {
+    if(pthread_rwlock_init(&this->m_rwlock, NULL) != 0) {
+        throw PERSIST_EXP_RWLOCK_INIT(errno);
+    }
+    if(pthread_mutex_init(&this->m_perslock, NULL) != 0) {
+        throw PERSIST_EXP_MUTEX_INIT(errno);
+    }
+    dbg_default_trace("{0} constructor(grouped): before load()", name);
+    if(derecho::getConfBoolean(CONF_PERS_RESET)) {
+        reset();
+    }
+    load();
+    dbg_default_trace("{0} constructor(grouped): after load()", name);
+}
+
 void FilePersistLog::reset() noexcept(false) {
     dbg_default_trace("{0} reset state...begin", this->m_sName);
     if(fs::exists(this->m_sMetaFile)) {
@@ -63,12 +110,22 @@ void FilePersistLog::reset() noexcept(false) {
             dbg_default_error("{0} reset failed to remove the file:{1}", this->m_sName, this->m_sMetaFile);
             throw PERSIST_EXP_REMOVE_FILE(errno);
         }
-        if(!fs::remove(this->m_sLogFile)) {
-            dbg_default_error("{0} reset failed to remove the file:{1}", this->m_sName, this->m_sLogFile);
-            throw PERSIST_EXP_REMOVE_FILE(errno);
+        // in grouped mode the log and data files belong to the shared log
+        // group, which resets them itself
+        if(this->m_pGroup == nullptr) {
+            if(!fs::remove(this->m_sLogFile)) {
+                dbg_default_error("{0} reset failed to remove the file:{1}", this->m_sName, this->m_sLogFile);
+                throw PERSIST_EXP_REMOVE_FILE(errno);
+            }
+            if(!fs::remove(this->m_sDataFile)) {
+                dbg_default_error("{0} reset failed to remove the file:{1}", this->m_sName, this->m_sDataFile);
+                throw PERSIST_EXP_REMOVE_FILE(errno);
+            }
         }
-        if(!fs::remove(this->m_sDataFile)) {
-            dbg_default_error("{0} reset failed to remove the file:{1}", this->m_sName, this->m_sDataFile);
+    }
+    if(fs::exists(this->m_sCkptFile)) {
+        if(!fs::remove(this->m_sCkptFile)) {
+            dbg_default_error("{0} reset failed to remove the file:{1}", this->m_sName, this->m_sCkptFile);
             throw PERSIST_EXP_REMOVE_FILE(errno);
         }
     }
@@ -82,17 +139,28 @@ void FilePersistLog::load() noexcept(false) {
     dbg_default_trace("{0}:checkOrCreateDir passed.", this->m_sName);
     // STEP 1: check and create files.
     bool bCreate = checkOrCreateMetaFile();
-    checkOrCreateLogFile();
-    checkOrCreateDataFile();
-    dbg_default_trace("{0}:checkOrCreateDataFile passed.", this->m_sName);
-    // STEP 2: open files
-    this->m_iLogFileDesc = open(this->m_sLogFile.c_str(), O_RDWR);
-    if(this->m_iLogFileDesc == -1) {
-        throw PERSIST_EXP_OPEN_FILE(errno);
-    }
-    this->m_iDataFileDesc = open(this->m_sDataFile.c_str(), O_RDWR);
-    if(this->m_iDataFileDesc == -1) {
-        throw PERSIST_EXP_OPEN_FILE(errno);
+    if(this->m_pGroup == nullptr) {
+        checkOrCreateLogFile();
+        checkOrCreateDataFile();
+        dbg_default_trace("{0}:checkOrCreateDataFile passed.", this->m_sName);
+        // STEP 2: open files
+        this->m_iLogFileDesc = open(this->m_sLogFile.c_str(), O_RDWR);
+        if(this->m_iLogFileDesc == -1) {
+            throw PERSIST_EXP_OPEN_FILE(errno);
+        }
+        this->m_iDataFileDesc = open(this->m_sDataFile.c_str(), O_RDWR);
+        if(this->m_iDataFileDesc == -1) {
+            throw PERSIST_EXP_OPEN_FILE(errno);
+        }
+    } else {
+        // STEP 1/2 (grouped): the rings live in sections of the group's
+        // shared files, which the group sizes, owns, and keeps open
+        std::tie(this->m_iLogSectionOffset, this->m_iDataSectionOffset)
+                = this->m_pGroup->addSection(MAX_LOG_SIZE, MAX_DATA_SIZE);
+        this->m_iLogFileDesc = this->m_pGroup->getLogFileDesc();
+        this->m_iDataFileDesc = this->m_pGroup->getDataFileDesc();
+        dbg_default_trace("{0}:joined shared log group at log offset {1}, data offset {2}.",
+                          this->m_sName, this->m_iLogSectionOffset, this->m_iDataSectionOffset);
     }
     // STEP 3: mmap to memory
     //// we map the log entry and data twice to faciliate the search and data
@@ -103,11 +171,11 @@ void FilePersistLog::load() noexcept(false) {
         dbg_default_error("{0}:reserve map space for log failed.", this->m_sName);
         throw PERSIST_EXP_MMAP_FILE(errno);
     }
-    if(mmap(this->m_pLog, MAX_LOG_SIZE, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_FIXED, this->m_iLogFileDesc, 0) == MAP_FAILED) {
+    if(mmap(this->m_pLog, MAX_LOG_SIZE, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_FIXED, this->m_iLogFileDesc, this->m_iLogSectionOffset) == MAP_FAILED) {
         dbg_default_error("{0}:map ringbuffer space for the first half of log failed. Is the size of log ringbuffer aligned to page?", this->m_sName);
         throw PERSIST_EXP_MMAP_FILE(errno);
     }
-    if(mmap((void*)((uint64_t)this->m_pLog + MAX_LOG_SIZE), MAX_LOG_SIZE, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_FIXED, this->m_iLogFileDesc, 0) == MAP_FAILED) {
+    if(mmap((void*)((uint64_t)this->m_pLog + MAX_LOG_SIZE), MAX_LOG_SIZE, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_FIXED, this->m_iLogFileDesc, this->m_iLogSectionOffset) == MAP_FAILED) {
         dbg_default_error("{0}:map ringbuffer space for the second half of log failed. Is the size of log ringbuffer aligned to page?", this->m_sName);
         throw PERSIST_EXP_MMAP_FILE(errno);
     }
@@ -117,11 +185,11 @@ void FilePersistLog::load() noexcept(false) {
         dbg_default_error("{0}:reserve map space for data failed.", this->m_sName);
         throw PERSIST_EXP_MMAP_FILE(errno);
     }
-    if(mmap(this->m_pData, (size_t)(MAX_DATA_SIZE), PROT_READ | PROT_WRITE, MAP_SHARED | MAP_FIXED, this->m_iDataFileDesc, 0) == MAP_FAILED) {
+    if(mmap(this->m_pData, (size_t)(MAX_DATA_SIZE), PROT_READ | PROT_WRITE, MAP_SHARED | MAP_FIXED, this->m_iDataFileDesc, this->m_iDataSectionOffset) == MAP_FAILED) {
         dbg_default_error("{0}:map ringbuffer space for the first half of data failed. Is the size of data ringbuffer aligned to page?", this->m_sName);
         throw PERSIST_EXP_MMAP_FILE(errno);
     }
-    if(mmap((void*)((uint64_t)this->m_pData + MAX_DATA_SIZE), (size_t)MAX_DATA_SIZE, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_FIXED, this->m_iDataFileDesc, 0) == MAP_FAILED) {
+    if(mmap((void*)((uint64_t)this->m_pData + MAX_DATA_SIZE), (size_t)MAX_DATA_SIZE, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_FIXED, this->m_iDataFileDesc, this->m_iDataSectionOffset) == MAP_FAILED) {
         dbg_default_error("{0}:map ringbuffer space for the second half of data failed. Is the size of data ringbuffer aligned to page?", this->m_sName);
         throw PERSIST_EXP_MMAP_FILE(errno);
     }
@@ -131,9 +199,11 @@ void FilePersistLog::load() noexcept(false) {
         META_HEADER->fields.head = 0ll;
         META_HEADER->fields.tail = 0ll;
         META_HEADER->fields.ver = INVALID_VERSION;
+        META_HEADER->fields.ckpt = INVALID_VERSION;
         META_HEADER_PERS->fields.head = -1ll;  // -1 means uninitialized
         META_HEADER_PERS->fields.tail = -1ll;  // -1 means uninitialized
         META_HEADER_PERS->fields.ver = INVALID_VERSION;
+        META_HEADER_PERS->fields.ckpt = INVALID_VERSION;
         // persist the header
         FPL_RDLOCK;
         FPL_PERS_LOCK;
@@ -163,6 +233,13 @@ void FilePersistLog::load() noexcept(false) {
             }
             close(fd);
             *META_HEADER = *META_HEADER_PERS;
+            // fault the rings in with a thread pool while this thread runs
+            // verification and index rebuilding, which only walk the log in
+            // order; on a big log the page-in dominates restart time.
+            std::vector<std::thread> prefaulters = prefaultUsedRanges();
+            if(derecho::getConfBoolean(CONF_PERS_VERIFY_ON_LOAD)) {
+                verifyLogOnLoad();
+            }
             // update mhlc index
             for(int64_t idx = META_HEADER->fields.head; idx < META_HEADER->fields.tail; idx++) {
                 struct hlc_index_entry _ent;
@@ -170,6 +247,10 @@ void FilePersistLog::load() noexcept(false) {
                 _ent.hlc.m_logic = LOG_ENTRY_AT(idx)->fields.hlc_l;
                 _ent.log_idx = idx;
                 this->hidx.insert(_ent);
+                this->vidx.emplace_back(LOG_ENTRY_AT(idx)->fields.ver, idx);
+            }
+            for(auto& thd : prefaulters) {
+                thd.join();
             }
         } catch(uint64_t e) {
             FPL_PERS_UNLOCK;
@@ -192,6 +273,9 @@ void FilePersistLog::load() noexcept(false) {
 }
 
 FilePersistLog::~FilePersistLog() noexcept(true) {
+    if(this->m_pGroup != nullptr) {
+        this->m_pGroup->forgetMember(this);
+    }
     pthread_rwlock_destroy(&this->m_rwlock);
     pthread_mutex_destroy(&this->m_perslock);
     if(this->m_pData != MAP_FAILED) {
@@ -202,10 +286,11 @@ FilePersistLog::~FilePersistLog() noexcept(true) {
         munmap(m_pLog, MAX_LOG_SIZE);
     }
     this->m_pLog = nullptr;  // prevent ~MemLog() destructor to release it again.
-    if(this->m_iLogFileDesc != -1) {
+    // in grouped mode the group owns (and closes) the file descriptors
+    if(this->m_iLogFileDesc != -1 && this->m_pGroup == nullptr) {
         close(this->m_iLogFileDesc);
     }
-    if(this->m_iDataFileDesc != -1) {
+    if(this->m_iDataFileDesc != -1 && this->m_pGroup == nullptr) {
         close(this->m_iDataFileDesc);
     }
 }
@@ -256,16 +341,34 @@ void FilePersistLog::append(const void* pdat, const uint64_t& size, const int64_
 #pragma GCC diagnostic pop
     dbg_default_trace("{0} append:validate check2 Finished.", this->m_sName);
 
-    // copy data
-    memcpy(NEXT_DATA, pdat, size);
+    // copy data, compressing it on the way when that actually shrinks it
+    uint64_t dlen = size;
+    uint64_t rawlen = 0;
+    if(this->m_bCompression && size > 0) {
+        thread_local std::vector<uint8_t> compress_scratch;
+        compress_scratch.resize(compression::maxCompressedSize(size));
+        const size_t csize = compression::compress(pdat, size, compress_scratch.data());
+        if(csize < size) {
+            memcpy(NEXT_DATA, compress_scratch.data(), csize);
+            dlen = csize;
+            rawlen = size;
+        } else {
+            // incompressible payload: store it raw
+            memcpy(NEXT_DATA, pdat, size);
+        }
+    } else {
+        memcpy(NEXT_DATA, pdat, size);
+    }
     dbg_default_trace("{0} append:data is copied to log.", this->m_sName);
 
     // fill the log entry
     NEXT_LOG_ENTRY->fields.ver = ver;
-    NEXT_LOG_ENTRY->fields.dlen = size;
+    NEXT_LOG_ENTRY->fields.dlen = dlen;
+    NEXT_LOG_ENTRY->fields.rawlen = rawlen;
     NEXT_LOG_ENTRY->fields.ofst = NEXT_DATA_OFST;
     NEXT_LOG_ENTRY->fields.hlc_r = mhlc.m_rtc_us;
     NEXT_LOG_ENTRY->fields.hlc_l = mhlc.m_logic;
+    NEXT_LOG_ENTRY->fields.crc32 = checksumLogEntry(NEXT_LOG_ENTRY, LOG_ENTRY_DATA(NEXT_LOG_ENTRY));
     /* No Sync required here.
     if (msync(ALIGN_TO_PAGE(NEXT_LOG_ENTRY), 
         sizeof(LogEntry) + (((uint64_t)NEXT_LOG_ENTRY) % PAGE_SIZE),MS_SYNC) != 0) {
@@ -276,6 +379,7 @@ void FilePersistLog::append(const void* pdat, const uint64_t& size, const int64_
 
     // update meta header
     this->hidx.insert(hlc_index_entry{mhlc, META_HEADER->fields.tail});
+    this->vidx.emplace_back(ver, META_HEADER->fields.tail);
     META_HEADER->fields.tail++;
     META_HEADER->fields.ver = ver;
     dbg_default_trace("{0} append:log entry and meta data are updated.", this->m_sName);
@@ -320,6 +424,24 @@ const int64_t FilePersistLog::persist(const bool preLocked) noexcept(false) {
         return ver_ret;
     }
 
+    // Grouped mode: leave the dirty ring pages to the group's single
+    // fdatasync and stage the meta commit to run after it; the registry
+    // calls SharedLogGroup::sync() once per persist batch.
+    if(this->m_pGroup != nullptr) {
+        MetaHeader shadow_header = *META_HEADER;
+        if(NUM_USED_SLOTS > 0) {
+            ver_ret = META_HEADER->fields.ver;
+        }
+        if(!preLocked) {
+            FPL_UNLOCK;
+        }
+        this->m_pGroup->stageCommit(this, shadow_header);
+        if(!preLocked) {
+            FPL_PERS_UNLOCK;
+        }
+        return ver_ret;
+    }
+
     //flush data
     dbg_default_trace("{0} flush data,log,and meta.", this->m_sName);
     try {
@@ -419,19 +541,54 @@ const version_t FilePersistLog::getLastPersisted() noexcept(false) {
     return last_persisted;
 }
 
+int64_t FilePersistLog::lookupVersionIndex(const int64_t& ver) noexcept(false) {
+    if(this->vidx.empty()) {
+        // the cache should only be empty when the log is; keep the mmap
+        // binary search as a safety net
+        return binarySearch<int64_t>(
+                [&](const LogEntry* ple) {
+                    return ple->fields.ver;
+                },
+                ver,
+                META_HEADER->fields.head,
+                META_HEADER->fields.tail);
+    }
+    // constant-time fast path for "latest or near-latest" lookups
+    if(this->vidx.back().first <= ver) {
+        return this->vidx.back().second;
+    }
+    auto it = std::upper_bound(this->vidx.begin(), this->vidx.end(), ver,
+                               [](const int64_t& v, const std::pair<int64_t, int64_t>& ent) {
+                                   return v < ent.first;
+                               });
+    if(it == this->vidx.begin()) {
+        return (int64_t)-1L;
+    }
+    --it;
+    // a not-yet-pruned entry below the head has been trimmed away
+    if(it->second < META_HEADER->fields.head) {
+        return (int64_t)-1L;
+    }
+    return it->second;
+}
+
+void FilePersistLog::pruneVersionIndex() noexcept(true) {
+    while(!this->vidx.empty() && this->vidx.back().second >= META_HEADER->fields.tail) {
+        this->vidx.pop_back();
+    }
+    auto it = this->vidx.begin();
+    while(it != this->vidx.end() && it->second < META_HEADER->fields.head) {
+        ++it;
+    }
+    this->vidx.erase(this->vidx.begin(), it);
+}
+
 int64_t FilePersistLog::getVersionIndex(const version_t& ver) {
     FPL_RDLOCK;
 
-    //binary search
-    dbg_default_trace("{0} - begin binary search.", this->m_sName);
-    int64_t l_idx = binarySearch<int64_t>(
-            [&](const LogEntry* ple) {
-                return ple->fields.ver;
-            },
-            ver,
-            META_HEADER->fields.head,
-            META_HEADER->fields.tail);
-    dbg_default_trace("{0} - end binary search.", this->m_sName);
+    dbg_default_trace("{0} - begin version index lookup.", this->m_sName);
+    int64_t l_idx = lookupVersionIndex(ver);
+    dbg_default_trace("{0} - end version index lookup.", this->m_sName);
 
     FPL_UNLOCK;
 
@@ -440,6 +597,136 @@ int64_t FilePersistLog::getVersionIndex(const version_t& ver) {
     return l_idx;
 }
 
+const void* FilePersistLog::entryData(const LogEntry* ple) noexcept(false) {
+    if(ple->fields.rawlen == 0) {
+        return LOG_ENTRY_DATA(ple);
+    }
+    // one scratch per thread: each caller consumes the returned payload
+    // before its next read, and concurrent readers do not share it
+    thread_local std::vector<uint8_t> decompress_scratch;
+    decompress_scratch.resize(ple->fields.rawlen);
+    compression::decompress(LOG_ENTRY_DATA(ple), ple->fields.dlen,
+                            decompress_scratch.data(), ple->fields.rawlen);
+    return decompress_scratch.data();
+}
+
+uint32_t FilePersistLog::checksumLogEntry(const LogEntry* ple, const void* pdat) noexcept(true) {
+    // ver and dlen are contiguous, as are hlc_r/hlc_l/rawlen; ofst is skipped
+    // because mergeLogEntryFromByteArray() rewrites it for the local ring.
+    uint32_t crc = checksum::crc32c(0, &ple->fields.ver, sizeof(ple->fields.ver) + sizeof(ple->fields.dlen));
+    crc = checksum::crc32c(crc, &ple->fields.hlc_r, sizeof(ple->fields.hlc_r) + sizeof(ple->fields.hlc_l) + sizeof(ple->fields.rawlen));
+    crc = checksum::crc32c(crc, pdat, ple->fields.dlen);
+    // zero is reserved for "no checksum recorded"; the writer and the
+    // verifier apply the same mapping, so verification is unaffected.
+    return (crc == 0) ? 0x1u : crc;
+}
+
+void FilePersistLog::verifyLogOnLoad() noexcept(false) {
+    const int64_t head = META_HEADER->fields.head;
+    const int64_t tail = META_HEADER->fields.tail;
+    if(tail <= head) {
+        return;
+    }
+    // each thread scans a contiguous slice of the log and reports the first
+    // entry in its slice that fails; the cut point is the minimum of those.
+    const int64_t num_entries = tail - head;
+    const int64_t num_threads = std::min((int64_t)std::max(std::thread::hardware_concurrency(), 1u), num_entries);
+    const int64_t slice = (num_entries + num_threads - 1) / num_threads;
+    std::atomic<int64_t> first_bad(tail);
+    std::vector<std::thread> verifiers;
+    for(int64_t t = 0; t < num_threads; t++) {
+        const int64_t from = head + t * slice;
+        const int64_t to = std::min(from + slice, tail);
+        verifiers.emplace_back([this, from, to, &first_bad]() {
+            for(int64_t idx = from; idx < to; idx++) {
+                const LogEntry* ple = LOG_ENTRY_AT(idx);
+                const bool ok = (ple->fields.dlen <= MAX_DATA_SIZE)
+                                && (ple->fields.crc32 == 0  // no checksum recorded
+                                    || ple->fields.crc32 == checksumLogEntry(ple, LOG_ENTRY_DATA(ple)));
+                if(!ok) {
+                    int64_t seen = first_bad.load();
+                    while(idx < seen && !first_bad.compare_exchange_weak(seen, idx)) {
+                    }
+                    // everything after a torn write is suspect; the rest of
+                    // this slice is covered by the truncation below.
+                    break;
+                }
+            }
+        });
+    }
+    for(auto& thd : verifiers) {
+        thd.join();
+    }
+    const int64_t cut = first_bad.load();
+    if(cut < tail) {
+        dbg_default_warn("{0} verify-on-load: checksum mismatch at log entry {1}, truncating tail from {2}.",
+                         this->m_sName, cut, tail);
+        META_HEADER->fields.tail = cut;
+        META_HEADER->fields.ver = (cut > head) ? (int64_t)LOG_ENTRY_AT(cut - 1)->fields.ver : (int64_t)INVALID_VERSION;
+        *META_HEADER_PERS = *META_HEADER;
+        persistMetaHeaderAtomically(META_HEADER);
+    }
+    dbg_default_trace("{0} verify-on-load: {1} entries verified.", this->m_sName, (cut - head));
+}
+
+std::vector<std::thread> FilePersistLog::prefaultUsedRanges() noexcept(true) {
+    std::vector<std::thread> prefaulters;
+    if(NUM_USED_SLOTS <= 0) {
+        return prefaulters;
+    }
+    // the double mapping keeps the used slice of each ring contiguous even
+    // when it wraps, so one (base, length) pair per ring covers everything.
+    struct range_t {
+        uint8_t* base;
+        uint64_t length;
+    } ranges[2] = {
+            {(uint8_t*)LOG_ENTRY_AT(META_HEADER->fields.head),
+             (uint64_t)NUM_USED_SLOTS * sizeof(LogEntry)},
+            {(uint8_t*)LOG_ENTRY_DATA(LOG_ENTRY_AT(META_HEADER->fields.head)),
+             (uint64_t)NUM_USED_BYTES}};
+    // give each worker a sizable slice: the point is overlapping major
+    // faults with indexing, not spawning threads for a small log.
+    static const uint64_t MIN_SLICE = (16ull << 20);
+    const uint64_t num_threads = std::max(std::thread::hardware_concurrency(), 1u);
+    for(const range_t& range : ranges) {
+        const uint64_t slice = std::max(MIN_SLICE, (range.length + num_threads - 1) / num_threads);
+        uint8_t* base = range.base;
+        uint64_t remaining = range.length;
+        while(remaining > 0) {
+            const uint64_t len = std::min(slice, remaining);
+            prefaulters.emplace_back([base, len]() {
+                uint8_t* page = (uint8_t*)ALIGN_TO_PAGE(base);
+                madvise(page, len + (uint64_t)(base - page), MADV_WILLNEED);
+                // touching a byte per page forces the page-in now, on this
+                // thread, instead of at the first get() of each version
+                volatile uint8_t sink = 0;
+                for(; page < base + len; page += PAGE_SIZE) {
+                    sink += *page;
+                }
+                (void)sink;
+            });
+            base += len;
+            remaining -= len;
+        }
+    }
+    return prefaulters;
+}
+
+version_t FilePersistLog::getVersionByIndex(const int64_t& eidx) noexcept(false) {
+    FPL_RDLOCK;
+
+    int64_t ridx = (eidx < 0) ? (META_HEADER->fields.tail + eidx) : eidx;
+
+    if(META_HEADER->fields.tail <= ridx || ridx < META_HEADER->fields.head) {
+        FPL_UNLOCK;
+        return INVALID_VERSION;
+    }
+    const version_t ver = LOG_ENTRY_AT(ridx)->fields.ver;
+    FPL_UNLOCK;
+
+    return ver;
+}
+
 const void* FilePersistLog::getEntryByIndex(const int64_t& eidx) noexcept(false) {
     FPL_RDLOCK;
     dbg_default_trace("{0}-getEntryByIndex-head:{1},tail:{2},eidx:{3}",
@@ -460,7 +747,7 @@ const void* FilePersistLog::getEntryByIndex(const int64_t& eidx) noexcept(false)
                       (LOG_ENTRY_AT(ridx))->fields.hlc_r,
                       (LOG_ENTRY_AT(ridx))->fields.hlc_l);
 
-    return LOG_ENTRY_DATA(LOG_ENTRY_AT(ridx));
+    return entryData(LOG_ENTRY_AT(ridx));
 }
 
 /** MOVED TO .hpp
@@ -516,17 +803,10 @@ const void* FilePersistLog::getEntry(const int64_t& ver) noexcept(false) {
 
     FPL_RDLOCK;
 
-    //binary search
-    dbg_default_trace("{0} - begin binary search.", this->m_sName);
-    int64_t l_idx = binarySearch<int64_t>(
-            [&](const LogEntry* ple) {
-                return ple->fields.ver;
-            },
-            ver,
-            META_HEADER->fields.head,
-            META_HEADER->fields.tail);
+    dbg_default_trace("{0} - begin version index lookup.", this->m_sName);
+    int64_t l_idx = lookupVersionIndex(ver);
     ple = (l_idx == -1) ? nullptr : LOG_ENTRY_AT(l_idx);
-    dbg_default_trace("{0} - end binary search.", this->m_sName);
+    dbg_default_trace("{0} - end version index lookup.", this->m_sName);
 
     FPL_UNLOCK;
 
@@ -537,7 +817,73 @@ const void* FilePersistLog::getEntry(const int64_t& ver) noexcept(false) {
 
     dbg_default_trace("{0} getEntry at ({1},{2})", this->m_sName, ple->fields.hlc_r, ple->fields.hlc_l);
 
-    return LOG_ENTRY_DATA(ple);
+    return entryData(ple);
+}
+
+EntrySpan FilePersistLog::getEntrySpan(const int64_t& ver) noexcept(false) {
+    EntrySpan span;
+
+    FPL_RDLOCK;
+    int64_t l_idx = lookupVersionIndex(ver);
+    if(l_idx != -1) {
+        const LogEntry* ple = LOG_ENTRY_AT(l_idx);
+        span.data = entryData(ple);
+        span.size = (ple->fields.rawlen == 0) ? ple->fields.dlen : ple->fields.rawlen;
+        span.ver = ple->fields.ver;
+        span.generation = this->m_trimGeneration;
+    }
+    FPL_UNLOCK;
+
+    return span;
+}
+
+EntrySpan FilePersistLog::getEntrySpanByIndex(const int64_t& eidx) noexcept(false) {
+    EntrySpan span;
+
+    FPL_RDLOCK;
+    int64_t ridx = (eidx < 0) ? (META_HEADER->fields.tail + eidx) : eidx;
+    if(META_HEADER->fields.tail <= ridx || ridx < META_HEADER->fields.head) {
+        FPL_UNLOCK;
+        throw PERSIST_EXP_INV_ENTRY_IDX(eidx);
+    }
+    const LogEntry* ple = LOG_ENTRY_AT(ridx);
+    span.data = entryData(ple);
+    span.size = (ple->fields.rawlen == 0) ? ple->fields.dlen : ple->fields.rawlen;
+    span.ver = ple->fields.ver;
+    span.generation = this->m_trimGeneration;
+    FPL_UNLOCK;
+
+    return span;
+}
+
+uint64_t FilePersistLog::getTrimGeneration() noexcept(true) {
+    return this->m_trimGeneration;
+}
+
+void FilePersistLog::adviseSequentialRange(const int64_t& first_idx, const int64_t& last_idx) noexcept(false) {
+    FPL_RDLOCK;
+    const int64_t first = std::max(first_idx, META_HEADER->fields.head);
+    const int64_t last = std::min(last_idx, META_HEADER->fields.tail - 1);
+    if(first > last) {
+        FPL_UNLOCK;
+        return;
+    }
+    // the double mapping keeps the scanned slice of each ring contiguous
+    // even when it wraps, so one (base, length) pair per ring covers the
+    // whole range (same trick prefaultUsedRanges() relies on)
+    const LogEntry* first_entry = LOG_ENTRY_AT(first);
+    const LogEntry* last_entry = LOG_ENTRY_AT(last);
+    uint8_t* data_base = (uint8_t*)LOG_ENTRY_DATA(first_entry);
+    const uint64_t data_length = (last_entry->fields.ofst + last_entry->fields.dlen) - first_entry->fields.ofst;
+    uint8_t* log_base = (uint8_t*)LOG_ENTRY_AT(first);
+    const uint64_t log_length = (uint64_t)(last - first + 1) * sizeof(LogEntry);
+    FPL_UNLOCK;
+
+    // advisory only, so it is safe to drop the lock before the syscalls
+    uint8_t* page = (uint8_t*)ALIGN_TO_PAGE(data_base);
+    madvise(page, data_length + (uint64_t)(data_base - page), MADV_SEQUENTIAL);
+    page = (uint8_t*)ALIGN_TO_PAGE(log_base);
+    madvise(page, log_length + (uint64_t)(log_base - page), MADV_SEQUENTIAL);
 }
 
 int64_t FilePersistLog::getHLCIndex(const HLC& rhlc) noexcept(false) {
@@ -559,6 +905,35 @@ int64_t FilePersistLog::getHLCIndex(const HLC& rhlc) noexcept(false) {
     return INVALID_INDEX;
 }
 
+bool FilePersistLog::getHLCIndexRange(const HLC& hlc_begin, const HLC& hlc_end,
+                                      int64_t& first_idx, int64_t& last_idx) noexcept(false) {
+    first_idx = INVALID_INDEX;
+    last_idx = INVALID_INDEX;
+    if(hlc_end < hlc_begin) {
+        return false;
+    }
+    FPL_RDLOCK;
+    dbg_default_trace("getHLCIndexRange for hlc({0},{1})..({2},{3})",
+                      hlc_begin.m_rtc_us, hlc_begin.m_logic, hlc_end.m_rtc_us, hlc_end.m_logic);
+    // one descent finds the start of the range; the rest of the walk follows
+    // the index in order
+    struct hlc_index_entry skey(hlc_begin, 0);
+    for(auto itr = this->hidx.lower_bound(skey);
+        itr != this->hidx.end() && !(hlc_end < itr->hlc); itr++) {
+        // the index can retain entries that a trim has already dropped
+        if(itr->log_idx < META_HEADER->fields.head || itr->log_idx >= META_HEADER->fields.tail) {
+            continue;
+        }
+        if(first_idx == INVALID_INDEX) {
+            first_idx = itr->log_idx;
+        }
+        last_idx = itr->log_idx;
+    }
+    FPL_UNLOCK;
+    dbg_default_trace("{0} getHLCIndexRange found [{1},{2}]", this->m_sName, first_idx, last_idx);
+    return first_idx != INVALID_INDEX;
+}
+
 const void* FilePersistLog::getEntry(const HLC& rhlc) noexcept(false) {
     LogEntry* ple = nullptr;
     //    unsigned __int128 key = ((((unsigned __int128)rhlc.m_rtc_us)<<64) | rhlc.m_logic);
@@ -604,7 +979,7 @@ const void* FilePersistLog::getEntry(const HLC& rhlc) noexcept(false) {
 
     dbg_default_trace("{0} getEntry at ({1},{2})", this->m_sName, ple->fields.hlc_r, ple->fields.hlc_l);
 
-    return LOG_ENTRY_DATA(ple);
+    return entryData(ple);
 }
 
 // trim by index
@@ -627,6 +1002,8 @@ void FilePersistLog::trimByIndex(const int64_t& idx) noexcept(false) {
         return;
     }
     META_HEADER->fields.head = idx + 1;
+    this->m_trimGeneration++;
+    pruneVersionIndex();
     try {
         persist(true);
     } catch(uint64_t e) {
@@ -662,6 +1039,18 @@ void FilePersistLog::trim(const HLC& hlc) noexcept(false) {
     dbg_default_trace("{0} trim at time: {1}.{2}...done", this->m_sName, hlc.m_rtc_us, hlc.m_logic);
 }
 
+void FilePersistLog::commitMetaHeader(const MetaHeader& shadow_header) noexcept(false) {
+    MetaHeader header_copy = shadow_header;
+    FPL_PERS_LOCK;
+    try {
+        persistMetaHeaderAtomically(&header_copy);
+    } catch(uint64_t e) {
+        FPL_PERS_UNLOCK;
+        throw e;
+    }
+    FPL_PERS_UNLOCK;
+}
+
 void FilePersistLog::persistMetaHeaderAtomically(MetaHeader* pShadowHeader) noexcept(false) {
     // STEP 1: get file name
     const string swpFile = this->m_sMetaFile + "." + SWAP_FILE_SUFFIX;
@@ -702,29 +1091,22 @@ int64_t FilePersistLog::getMinimumIndexBeyondVersion(const int64_t& ver) noexcep
         return META_HEADER->fields.head;
     }
 
-    // binary search
-    dbg_default_trace("{0}[{1}] - begin binary search.", this->m_sName, __func__);
-    int64_t l_idx = binarySearch<int64_t>(
-            [&](const LogEntry* ple) {
-                return ple->fields.ver;
-            },
-            ver,
-            META_HEADER->fields.head,
-            META_HEADER->fields.tail);
+    dbg_default_trace("{0}[{1}] - begin version index lookup.", this->m_sName, __func__);
+    int64_t l_idx = lookupVersionIndex(ver);
 
     if(l_idx == -1) {
         // if binary search failed, it means the requested version is earlier
         // than the earliest available log so we return the earliest log entry
         // we have.
         rIndex = META_HEADER->fields.head;
-        dbg_default_trace("{0}[{1}] - binary search failed, return the earliest version {2}", this->m_sName, __func__, ver);
+        dbg_default_trace("{0}[{1}] - version lookup failed, return the earliest version {2}", this->m_sName, __func__, ver);
     } else if((l_idx + 1) == META_HEADER->fields.tail) {
         // if binary search found the last one, it means ver is in the future return INVALID_INDEX.
         // use the default rIndex value (INVALID_INDEX)
-        dbg_default_trace("{0}[{1}] - binary search returns the last entry in the log. return INVALID_INDEX.", this->m_sName, __func__);
+        dbg_default_trace("{0}[{1}] - version lookup returns the last entry in the log. return INVALID_INDEX.", this->m_sName, __func__);
     } else {
         // binary search found some entry earlier than the last one. return l_idx+1:
-        dbg_default_trace("{0}[{1}] - binary search returns an entry earlier than the last one, return ldx+1:{2}", this->m_sName, __func__, l_idx + 1);
+        dbg_default_trace("{0}[{1}] - version lookup returns an entry earlier than the last one, return ldx+1:{2}", this->m_sName, __func__, l_idx + 1);
         rIndex = l_idx + 1;
     }
 
@@ -789,7 +1171,40 @@ void FilePersistLog::post_object(const std::function<void(char const* const, std
     }
 }
 
-void FilePersistLog::applyLogTail(char const* v) noexcept(false) {
+void FilePersistLog::postLogTail(const std::function<void(char const* const, std::size_t)>& f,
+                                 const FileRangePostFunc& file_f,
+                                 const int64_t& ver) noexcept(false) {
+    int64_t idx = this->getMinimumIndexBeyondVersion(ver);
+    // latest_version
+    int64_t latest_version = this->getLatestVersion();
+    f((char*)&latest_version, sizeof(int64_t));
+    // nr_log_entry
+    int64_t nr_log_entry = (idx == INVALID_INDEX) ? 0 : (META_HEADER->fields.tail - idx);
+    f((char*)&nr_log_entry, sizeof(int64_t));
+    // log_entries: the 64-byte entry struct goes through f, but the payload
+    // is handed to file_f as a range of the data file. The data region is
+    // mmap-ed MAP_SHARED, so the page cache a sendfile-backed consumer reads
+    // from holds the same pages the log writes to -- no msync is needed
+    // first. A payload that wraps the data ring is contiguous in memory only
+    // through the double mapping, so it is posted as two file ranges.
+    if(idx != INVALID_INDEX) {
+        while(idx < META_HEADER->fields.tail) {
+            const LogEntry* ple = LOG_ENTRY_AT(idx);
+            f((const char*)ple, sizeof(LogEntry));
+            if(ple->fields.dlen > 0) {
+                const uint64_t ring_ofst = ple->fields.ofst % MAX_DATA_SIZE;
+                const uint64_t len_to_end = std::min(ple->fields.dlen, MAX_DATA_SIZE - ring_ofst);
+                file_f(this->m_iDataFileDesc, this->m_iDataSectionOffset + ring_ofst, len_to_end);
+                if(len_to_end < ple->fields.dlen) {
+                    file_f(this->m_iDataFileDesc, this->m_iDataSectionOffset, ple->fields.dlen - len_to_end);
+                }
+            }
+            idx++;
+        }
+    }
+}
+
+size_t FilePersistLog::applyLogTail(char const* v) noexcept(false) {
     size_t ofst = 0;
     // latest_version
     int64_t latest_version = *(const int64_t*)(v + ofst);
@@ -803,6 +1218,98 @@ void FilePersistLog::applyLogTail(char const* v) noexcept(false) {
     }
     // update the latest version.
     META_HEADER->fields.ver = latest_version;
+    return ofst;
+}
+
+version_t FilePersistLog::getCheckpointVersion() noexcept(false) {
+    FPL_RDLOCK;
+    version_t ver = META_HEADER->fields.ckpt;
+    FPL_UNLOCK;
+    return ver;
+}
+
+void FilePersistLog::writeCheckpoint(const version_t& ver, const void* data,
+                                     const uint64_t& size) noexcept(false) {
+    dbg_default_trace("{0} write checkpoint at version {1}, {2} bytes.", this->m_sName, ver, size);
+    // STEP 1: write the snapshot to a swap file. The leading version doubles
+    // as the validity cross-check against the ckpt field in the meta header.
+    const string swpFile = this->m_sCkptFile + "." + SWAP_FILE_SUFFIX;
+    int fd = open(swpFile.c_str(), O_RDWR | O_CREAT | O_TRUNC, S_IWUSR | S_IRUSR | S_IRGRP | S_IWGRP | S_IROTH);
+    if(fd == -1) {
+        throw PERSIST_EXP_OPEN_FILE(errno);
+    }
+    int64_t header[2] = {ver, (int64_t)size};
+    if(write(fd, header, sizeof(header)) != sizeof(header)) {
+        close(fd);
+        throw PERSIST_EXP_WRITE_FILE(errno);
+    }
+    uint64_t nWritten = 0;
+    while(nWritten < size) {
+        ssize_t ret = write(fd, (const char*)data + nWritten, size - nWritten);
+        if(ret < 0) {
+            close(fd);
+            throw PERSIST_EXP_WRITE_FILE(errno);
+        }
+        nWritten += ret;
+    }
+    if(fsync(fd) != 0) {
+        close(fd);
+        throw PERSIST_EXP_WRITE_FILE(errno);
+    }
+    close(fd);
+    // STEP 2: atomically replace the checkpoint file
+    if(rename(swpFile.c_str(), this->m_sCkptFile.c_str()) != 0) {
+        throw PERSIST_EXP_RENAME_FILE(errno);
+    }
+    // STEP 3: record the checkpoint version and commit the meta header, so
+    // the checkpoint is honored after a restart even if no further version
+    // is ever persisted. A crash before the commit leaves the recorded
+    // version stale, which loadCheckpoint() detects and ignores.
+    FPL_WRLOCK;
+    META_HEADER->fields.ckpt = ver;
+    FPL_UNLOCK;
+    this->persist();
+    dbg_default_trace("{0} write checkpoint at version {1}...done", this->m_sName, ver);
+}
+
+std::unique_ptr<char[]> FilePersistLog::loadCheckpoint(version_t& ver) noexcept(false) {
+    ver = INVALID_VERSION;
+    FPL_RDLOCK;
+    const version_t recorded = META_HEADER->fields.ckpt;
+    const version_t latest = META_HEADER->fields.ver;
+    FPL_UNLOCK;
+    if(recorded == INVALID_VERSION || recorded > latest) {
+        return nullptr;
+    }
+    int fd = open(this->m_sCkptFile.c_str(), O_RDONLY);
+    if(fd == -1) {
+        // no checkpoint file: the recorded version is a leftover (or, for a
+        // meta header written before the ckpt field existed, padding noise)
+        return nullptr;
+    }
+    int64_t header[2];
+    if(read(fd, header, sizeof(header)) != sizeof(header) || header[0] != recorded || header[1] < 0) {
+        dbg_default_warn("{0} ignores a stale or damaged checkpoint file (recorded version {1}).",
+                         this->m_sName, recorded);
+        close(fd);
+        return nullptr;
+    }
+    std::unique_ptr<char[]> data = std::make_unique<char[]>(header[1]);
+    int64_t nRead = 0;
+    while(nRead < header[1]) {
+        ssize_t ret = read(fd, data.get() + nRead, header[1] - nRead);
+        if(ret <= 0) {
+            dbg_default_warn("{0} ignores a truncated checkpoint file (recorded version {1}).",
+                             this->m_sName, recorded);
+            close(fd);
+            return nullptr;
+        }
+        nRead += ret;
+    }
+    close(fd);
+    ver = recorded;
+    dbg_default_trace("{0} loaded checkpoint at version {1}, {2} bytes.", this->m_sName, ver, nRead);
+    return data;
 }
 
 size_t FilePersistLog::byteSizeOfLogEntry(const LogEntry* ple) noexcept(false) {
@@ -853,6 +1360,7 @@ size_t FilePersistLog::mergeLogEntryFromByteArray(const char* ba) noexcept(false
     memcpy(NEXT_LOG_ENTRY, cple, sizeof(LogEntry));
     NEXT_LOG_ENTRY->fields.ofst = NEXT_DATA_OFST;
     this->hidx.insert(hlc_index_entry{HLC{cple->fields.hlc_r, cple->fields.hlc_l}, META_HEADER->fields.tail});
+    this->vidx.emplace_back(cple->fields.ver, META_HEADER->fields.tail);
     META_HEADER->fields.tail++;
     META_HEADER->fields.ver = cple->fields.ver;
     dbg_default_trace("{0} merge log:log entry and meta data are updated.", __func__);
@@ -942,6 +1450,12 @@ void FilePersistLog::truncate(const int64_t& ver) noexcept(false) {
     }
     if(META_HEADER->fields.ver > ver)
         META_HEADER->fields.ver = ver;
+    // a checkpoint beyond the truncation point captures rolled-back
+    // versions, so it must not be used for recovery anymore
+    if(META_HEADER->fields.ckpt > ver)
+        META_HEADER->fields.ckpt = INVALID_VERSION;
+    this->m_trimGeneration++;
+    pruneVersionIndex();
     // STEP 3: update PERSISTENT STATE
     FPL_PERS_LOCK;
     try {
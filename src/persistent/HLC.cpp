@@ -1,15 +1,28 @@
 #include <derecho/persistent/HLC.hpp>
+#include <derecho/utils/time.h>
 #include <errno.h>
 #include <time.h>
 
+// The lock-free tick() fast path needs a 16-byte compare-and-swap over the
+// (rtc, logic) pair; gcc only emits cmpxchg16b for the __sync builtins when
+// the target supports it (-mcx16), and signals that with this macro. Without
+// it, tick() keeps the spinlock path.
+#if defined(__x86_64__) && defined(__GCC_HAVE_SYNC_COMPARE_AND_SWAP_16)
+#define HLC_HAS_CAS16 1
+// m_rtc_us sits in the low 64 bits on little-endian x86.
+static inline unsigned __int128 hlc_pack(uint64_t rtc, uint64_t logic) {
+    return (((unsigned __int128)logic) << 64) | rtc;
+}
+// atomic 16-byte load: a compare-and-swap of 0 with 0 returns the current
+// value and only ever rewrites a zero pair with itself.
+static inline unsigned __int128 hlc_load(unsigned __int128* pair) {
+    return __sync_val_compare_and_swap(pair, (unsigned __int128)0, (unsigned __int128)0);
+}
+#endif
+
 // return microsecond
 uint64_t read_rtc_us() noexcept(false) {
-    struct timespec tp;
-    if(clock_gettime(CLOCK_REALTIME, &tp) != 0) {
-        throw HLC_EXP_READ_RTC(errno);
-    } else {
-        return (uint64_t)tp.tv_sec * 1000000 + tp.tv_nsec / 1000;
-    }
+    return get_realtime_us();
 }
 
 HLC::HLC() noexcept(false) {
@@ -42,6 +55,23 @@ HLC::~HLC() noexcept(false) {
     }
 
 void HLC::tick(bool thread_safe) noexcept(false) {
+#ifdef HLC_HAS_CAS16
+    if(thread_safe) {
+        unsigned __int128* pair = (unsigned __int128*)&this->m_rtc_us;
+        while(true) {
+            const unsigned __int128 seen = hlc_load(pair);
+            const uint64_t rtc_seen = (uint64_t)seen;
+            const uint64_t logic_seen = (uint64_t)(seen >> 64);
+            const uint64_t rtc = read_rtc_us();
+            const unsigned __int128 next = (rtc <= rtc_seen)
+                                                   ? hlc_pack(rtc_seen, logic_seen + 1)
+                                                   : hlc_pack(rtc, 0ull);
+            if(__sync_bool_compare_and_swap(pair, seen, next)) {
+                return;
+            }
+        }
+    }
+#endif
     if(thread_safe) {
         HLC_LOCK
     }
@@ -60,6 +90,29 @@ void HLC::tick(bool thread_safe) noexcept(false) {
 }
 
 void HLC::tick(const HLC &msgHlc, bool thread_safe) noexcept(false) {
+#ifdef HLC_HAS_CAS16
+    if(thread_safe) {
+        unsigned __int128* pair = (unsigned __int128*)&this->m_rtc_us;
+        while(true) {
+            const unsigned __int128 seen = hlc_load(pair);
+            const uint64_t rtc_seen = (uint64_t)seen;
+            const uint64_t logic_seen = (uint64_t)(seen >> 64);
+            const uint64_t rtc = read_rtc_us();
+            unsigned __int128 next;
+            if((rtc > rtc_seen) && (rtc > msgHlc.m_rtc_us)) {
+                next = hlc_pack(rtc, 0ull);
+            } else if((rtc_seen > msgHlc.m_rtc_us)
+                      || (rtc_seen == msgHlc.m_rtc_us && logic_seen >= msgHlc.m_logic)) {
+                next = hlc_pack(rtc_seen, logic_seen + 1);
+            } else {
+                next = hlc_pack(msgHlc.m_rtc_us, msgHlc.m_logic + 1);
+            }
+            if(__sync_bool_compare_and_swap(pair, seen, next)) {
+                return;
+            }
+        }
+    }
+#endif
     if(thread_safe) {
         HLC_LOCK
     }
@@ -0,0 +1,282 @@
+#include <derecho/persistent/detail/IoUringPersistLog.hpp>
+#include <derecho/utils/logger.hpp>
+#include <errno.h>
+#include <string.h>
+
+#if __has_include(<linux/io_uring.h>)
+#define DERECHO_HAS_IO_URING 1
+#include <fcntl.h>
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+// the io_uring syscall numbers may be missing from older libc headers even
+// when the kernel headers define the ring ABI
+#ifndef __NR_io_uring_setup
+#define __NR_io_uring_setup 425
+#endif
+#ifndef __NR_io_uring_enter
+#define __NR_io_uring_enter 426
+#endif
+#endif  //__has_include(<linux/io_uring.h>)
+
+using namespace std;
+
+namespace persistent {
+
+// enough for the worst case of one persist(): two wrapped ranges per file
+// plus one fsync per file
+#define IO_URING_QUEUE_DEPTH (8)
+
+IoUringPersistLog::IoUringPersistLog(const string& name, const string& dataPath) noexcept(false)
+        : FilePersistLog(name, dataPath),
+          m_iRingFd(-1) {
+    if(!setupRing()) {
+        dbg_default_warn("{0}: io_uring unavailable, falling back to msync persistence.", this->m_sName);
+    }
+}
+
+IoUringPersistLog::~IoUringPersistLog() noexcept(true) {
+    teardownRing();
+}
+
+#ifdef DERECHO_HAS_IO_URING
+
+bool IoUringPersistLog::setupRing() noexcept(true) {
+    struct io_uring_params params;
+    memset(&params, 0, sizeof(params));
+    m_iRingFd = (int)syscall(__NR_io_uring_setup, IO_URING_QUEUE_DEPTH, &params);
+    if(m_iRingFd < 0) {
+        m_iRingFd = -1;
+        return false;
+    }
+    m_nSqEntries = params.sq_entries;
+    m_nCqEntries = params.cq_entries;
+    m_szSqRing = params.sq_off.array + params.sq_entries * sizeof(uint32_t);
+    m_szCqRing = params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+    if(params.features & IORING_FEAT_SINGLE_MMAP) {
+        // newer kernels expose both rings through one mapping
+        m_szSqRing = m_szCqRing = (m_szSqRing > m_szCqRing) ? m_szSqRing : m_szCqRing;
+    }
+    m_pSqRing = mmap(NULL, m_szSqRing, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                     m_iRingFd, IORING_OFF_SQ_RING);
+    if(m_pSqRing == MAP_FAILED) {
+        close(m_iRingFd);
+        m_iRingFd = -1;
+        return false;
+    }
+    if(params.features & IORING_FEAT_SINGLE_MMAP) {
+        m_pCqRing = m_pSqRing;
+    } else {
+        m_pCqRing = mmap(NULL, m_szCqRing, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                         m_iRingFd, IORING_OFF_CQ_RING);
+        if(m_pCqRing == MAP_FAILED) {
+            munmap(m_pSqRing, m_szSqRing);
+            close(m_iRingFd);
+            m_iRingFd = -1;
+            return false;
+        }
+    }
+    m_szSqes = params.sq_entries * sizeof(struct io_uring_sqe);
+    m_pSqes = mmap(NULL, m_szSqes, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                   m_iRingFd, IORING_OFF_SQES);
+    if(m_pSqes == MAP_FAILED) {
+        if(m_pCqRing != m_pSqRing) {
+            munmap(m_pCqRing, m_szCqRing);
+        }
+        munmap(m_pSqRing, m_szSqRing);
+        close(m_iRingFd);
+        m_iRingFd = -1;
+        return false;
+    }
+    m_pSqHead = (uint32_t*)((uint8_t*)m_pSqRing + params.sq_off.head);
+    m_pSqTail = (uint32_t*)((uint8_t*)m_pSqRing + params.sq_off.tail);
+    m_pSqMask = (uint32_t*)((uint8_t*)m_pSqRing + params.sq_off.ring_mask);
+    m_pSqArray = (uint32_t*)((uint8_t*)m_pSqRing + params.sq_off.array);
+    m_pCqHead = (uint32_t*)((uint8_t*)m_pCqRing + params.cq_off.head);
+    m_pCqTail = (uint32_t*)((uint8_t*)m_pCqRing + params.cq_off.tail);
+    m_pCqMask = (uint32_t*)((uint8_t*)m_pCqRing + params.cq_off.ring_mask);
+    m_pCqes = (void*)((uint8_t*)m_pCqRing + params.cq_off.cqes);
+    return true;
+}
+
+void IoUringPersistLog::teardownRing() noexcept(true) {
+    if(m_iRingFd < 0) {
+        return;
+    }
+    munmap(m_pSqes, m_szSqes);
+    if(m_pCqRing != m_pSqRing) {
+        munmap(m_pCqRing, m_szCqRing);
+    }
+    munmap(m_pSqRing, m_szSqRing);
+    close(m_iRingFd);
+    m_iRingFd = -1;
+}
+
+void* IoUringPersistLog::nextSqe() noexcept(true) {
+    // the ring is used only by the persist thread under m_perslock, so the
+    // tail update needs only a release barrier against the kernel's reader
+    uint32_t tail = *m_pSqTail;
+    uint32_t idx = tail & *m_pSqMask;
+    struct io_uring_sqe* sqe = &((struct io_uring_sqe*)m_pSqes)[idx];
+    memset(sqe, 0, sizeof(struct io_uring_sqe));
+    m_pSqArray[idx] = idx;
+    __atomic_store_n(m_pSqTail, tail + 1, __ATOMIC_RELEASE);
+    return sqe;
+}
+
+uint32_t IoUringPersistLog::queueRangeWriteback(int fd, uint64_t fileOffset, uint64_t length,
+                                                uint64_t fileSize) noexcept(false) {
+    uint32_t numEntries = 0;
+    while(length > 0) {
+        // the flushed range is contiguous in the double mapping but may wrap
+        // around the end of the underlying file
+        uint64_t chunk = (fileOffset + length > fileSize) ? (fileSize - fileOffset) : length;
+        struct io_uring_sqe* sqe = (struct io_uring_sqe*)nextSqe();
+        sqe->opcode = IORING_OP_SYNC_FILE_RANGE;
+        sqe->fd = fd;
+        sqe->off = fileOffset;
+        sqe->len = (uint32_t)chunk;
+        sqe->sync_range_flags = SYNC_FILE_RANGE_WAIT_BEFORE | SYNC_FILE_RANGE_WRITE;
+        numEntries++;
+        length -= chunk;
+        fileOffset = 0;
+    }
+    return numEntries;
+}
+
+uint32_t IoUringPersistLog::queueDataSync(int fd) noexcept(false) {
+    struct io_uring_sqe* sqe = (struct io_uring_sqe*)nextSqe();
+    sqe->opcode = IORING_OP_FSYNC;
+    sqe->fd = fd;
+    sqe->fsync_flags = IORING_FSYNC_DATASYNC;
+    return 1;
+}
+
+void IoUringPersistLog::submitAndWait(uint32_t numEntries) noexcept(false) {
+    int ret = (int)syscall(__NR_io_uring_enter, m_iRingFd, numEntries, numEntries,
+                           IORING_ENTER_GETEVENTS, NULL, 0);
+    if(ret < 0) {
+        throw PERSIST_EXP_IO_URING(errno);
+    }
+    // reap the completions and surface the first failure, if any
+    int firstError = 0;
+    uint32_t head = __atomic_load_n(m_pCqHead, __ATOMIC_ACQUIRE);
+    const uint32_t tail = __atomic_load_n(m_pCqTail, __ATOMIC_ACQUIRE);
+    while(head != tail) {
+        struct io_uring_cqe* cqe = &((struct io_uring_cqe*)m_pCqes)[head & *m_pCqMask];
+        if(cqe->res < 0 && firstError == 0) {
+            firstError = -cqe->res;
+        }
+        head++;
+    }
+    __atomic_store_n(m_pCqHead, head, __ATOMIC_RELEASE);
+    if(firstError != 0) {
+        throw PERSIST_EXP_IO_URING(firstError);
+    }
+}
+
+const version_t IoUringPersistLog::persist(const bool preLocked) noexcept(false) {
+    if(m_iRingFd < 0) {
+        return FilePersistLog::persist(preLocked);
+    }
+    int64_t ver_ret = INVALID_VERSION;
+    if(!preLocked) {
+        FPL_PERS_LOCK;
+        FPL_RDLOCK;
+    }
+
+    if(*META_HEADER == *META_HEADER_PERS) {
+        if(CURR_LOG_IDX != -1) {
+            ver_ret = META_HEADER->fields.ver;
+        }
+        if(!preLocked) {
+            FPL_UNLOCK;
+            FPL_PERS_UNLOCK;
+        }
+        return ver_ret;
+    }
+
+    dbg_default_trace("{0} flush data,log,and meta via io_uring.", this->m_sName);
+    try {
+        // shadow the current state, as in FilePersistLog::persist
+        void *flush_dstart = nullptr, *flush_lstart = nullptr;
+        size_t flush_dlen = 0, flush_llen = 0;
+        MetaHeader shadow_header = *META_HEADER;
+        if((NUM_USED_SLOTS > 0) && (NEXT_LOG_ENTRY > NEXT_LOG_ENTRY_PERS)) {
+            flush_dlen = (LOG_ENTRY_AT(CURR_LOG_IDX)->fields.ofst + LOG_ENTRY_AT(CURR_LOG_IDX)->fields.dlen - NEXT_LOG_ENTRY_PERS->fields.ofst);
+            flush_dstart = ALIGN_TO_PAGE(NEXT_DATA_PERS);
+            flush_dlen += ((int64_t)NEXT_DATA_PERS) % PAGE_SIZE;
+            flush_lstart = ALIGN_TO_PAGE(NEXT_LOG_ENTRY_PERS);
+            flush_llen = ((size_t)NEXT_LOG_ENTRY - (size_t)NEXT_LOG_ENTRY_PERS) + ((int64_t)NEXT_LOG_ENTRY_PERS) % PAGE_SIZE;
+        }
+        if(NUM_USED_SLOTS > 0) {
+            ver_ret = META_HEADER->fields.ver;
+        }
+        if(!preLocked) {
+            FPL_UNLOCK;
+        }
+        // submit the data and log writebacks plus the durability fsyncs in
+        // one batch, so the kernel overlaps the I/O on both files
+        uint32_t numEntries = 0;
+        if(flush_dlen > 0) {
+            numEntries += queueRangeWriteback(this->m_iDataFileDesc,
+                                              ((uint64_t)flush_dstart - (uint64_t)this->m_pData) % MAX_DATA_SIZE,
+                                              flush_dlen, MAX_DATA_SIZE);
+            numEntries += queueDataSync(this->m_iDataFileDesc);
+        }
+        if(flush_llen > 0) {
+            numEntries += queueRangeWriteback(this->m_iLogFileDesc,
+                                              ((uint64_t)flush_lstart - (uint64_t)this->m_pLog) % MAX_LOG_SIZE,
+                                              flush_llen, MAX_LOG_SIZE);
+            numEntries += queueDataSync(this->m_iLogFileDesc);
+        }
+        if(numEntries > 0) {
+            submitAndWait(numEntries);
+        }
+        // flush meta data
+        this->persistMetaHeaderAtomically(&shadow_header);
+    } catch(uint64_t e) {
+        if(!preLocked) {
+            FPL_PERS_UNLOCK;
+        }
+        throw e;
+    }
+    dbg_default_trace("{0} flush data,log,and meta via io_uring...done.", this->m_sName);
+
+    if(!preLocked) {
+        FPL_PERS_UNLOCK;
+    }
+    return ver_ret;
+}
+
+#else  //DERECHO_HAS_IO_URING
+
+bool IoUringPersistLog::setupRing() noexcept(true) {
+    return false;
+}
+
+void IoUringPersistLog::teardownRing() noexcept(true) {}
+
+void* IoUringPersistLog::nextSqe() noexcept(true) {
+    return nullptr;
+}
+
+uint32_t IoUringPersistLog::queueRangeWriteback(int, uint64_t, uint64_t, uint64_t) noexcept(false) {
+    return 0;
+}
+
+uint32_t IoUringPersistLog::queueDataSync(int) noexcept(false) {
+    return 0;
+}
+
+void IoUringPersistLog::submitAndWait(uint32_t) noexcept(false) {}
+
+const version_t IoUringPersistLog::persist(const bool preLocked) noexcept(false) {
+    return FilePersistLog::persist(preLocked);
+}
+
+#endif  //DERECHO_HAS_IO_URING
+
+}  // namespace persistent
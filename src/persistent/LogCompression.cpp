@@ -0,0 +1,134 @@
+#include <derecho/persistent/detail/LogCompression.hpp>
+
+#include <cstring>
+
+namespace persistent {
+namespace compression {
+
+// minimum useful match length: a sequence costs at least 3 bytes
+// (token + offset), so shorter matches are stored as literals
+#define MIN_MATCH (4)
+// matches reach at most this far back (the offset field is 16 bits)
+#define MAX_OFFSET (65535)
+// 12-bit hash table over 4-byte prefixes
+#define HASH_BITS (12)
+#define HASH_SIZE (1 << HASH_BITS)
+
+static inline uint32_t hash4(const uint8_t* p) noexcept(true) {
+    uint32_t v;
+    memcpy(&v, p, sizeof(v));
+    return (v * 2654435761u) >> (32 - HASH_BITS);
+}
+
+size_t maxCompressedSize(const size_t size) noexcept(true) {
+    // all-literal worst case: one run byte per 255 literals plus the
+    // token/terminator overhead
+    return size + size / 255 + 16;
+}
+
+// write a literal/match count above the nibble limit as a 255-run
+static inline uint8_t* putRun(uint8_t* out, size_t count) noexcept(true) {
+    count -= 15;
+    while(count >= 255) {
+        *out++ = 255;
+        count -= 255;
+    }
+    *out++ = (uint8_t)count;
+    return out;
+}
+
+size_t compress(const void* vsrc, const size_t size, void* vdst) noexcept(true) {
+    const uint8_t* src = (const uint8_t*)vsrc;
+    uint8_t* dst = (uint8_t*)vdst;
+    uint8_t* out = dst;
+    // candidate positions + 1; 0 means empty
+    uint32_t table[HASH_SIZE] = {0};
+
+    size_t anchor = 0;
+    size_t pos = 0;
+    while(pos + MIN_MATCH <= size) {
+        const uint32_t h = hash4(src + pos);
+        const uint32_t cand = table[h];
+        table[h] = (uint32_t)(pos + 1);
+        if(cand != 0 && pos + 1 - cand <= MAX_OFFSET
+           && memcmp(src + cand - 1, src + pos, MIN_MATCH) == 0) {
+            const size_t match_pos = cand - 1;
+            size_t len = MIN_MATCH;
+            while(pos + len < size && src[match_pos + len] == src[pos + len]) {
+                len++;
+            }
+            const size_t literals = pos - anchor;
+            const size_t mlen = len - MIN_MATCH;
+            *out++ = (uint8_t)(((literals < 15 ? literals : 15) << 4)
+                               | (mlen < 15 ? mlen : 15));
+            if(literals >= 15) {
+                out = putRun(out, literals);
+            }
+            memcpy(out, src + anchor, literals);
+            out += literals;
+            const uint16_t offset = (uint16_t)(pos - match_pos);
+            *out++ = (uint8_t)(offset & 0xff);
+            *out++ = (uint8_t)(offset >> 8);
+            if(mlen >= 15) {
+                out = putRun(out, mlen);
+            }
+            pos += len;
+            anchor = pos;
+        } else {
+            pos++;
+        }
+    }
+    // the final sequence carries the remaining literals and no match
+    const size_t literals = size - anchor;
+    *out++ = (uint8_t)((literals < 15 ? literals : 15) << 4);
+    if(literals >= 15) {
+        out = putRun(out, literals);
+    }
+    memcpy(out, src + anchor, literals);
+    out += literals;
+    return (size_t)(out - dst);
+}
+
+void decompress(const void* vsrc, const size_t size, void* vdst, const size_t raw_size) noexcept(true) {
+    const uint8_t* in = (const uint8_t*)vsrc;
+    const uint8_t* const in_end = in + size;
+    uint8_t* out = (uint8_t*)vdst;
+    uint8_t* const out_end = out + raw_size;
+
+    while(in < in_end && out < out_end) {
+        const uint8_t token = *in++;
+        size_t literals = token >> 4;
+        if(literals == 15) {
+            uint8_t run;
+            do {
+                run = *in++;
+                literals += run;
+            } while(run == 255);
+        }
+        memcpy(out, in, literals);
+        in += literals;
+        out += literals;
+        if(in >= in_end) {
+            break;  // the final sequence has no match
+        }
+        size_t offset = (size_t)in[0] | ((size_t)in[1] << 8);
+        in += 2;
+        size_t mlen = (token & 0x0f);
+        if(mlen == 15) {
+            uint8_t run;
+            do {
+                run = *in++;
+                mlen += run;
+            } while(run == 255);
+        }
+        mlen += MIN_MATCH;
+        // byte-by-byte so overlapping matches (offset < mlen) replicate
+        const uint8_t* match = out - offset;
+        while(mlen-- > 0) {
+            *out++ = *match++;
+        }
+    }
+}
+
+}  // namespace compression
+}  // namespace persistent
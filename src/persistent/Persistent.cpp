@@ -1,4 +1,6 @@
 #include <derecho/persistent/Persistent.hpp>
+#include <derecho/persistent/detail/SharedLogGroup.hpp>
+#include <derecho/conf/conf.hpp>
 
 namespace persistent {
 
@@ -9,6 +11,11 @@ namespace persistent {
 #define TRIM_FUNC_IDX (2)
 #define GET_ML_PERSISTED_VER (3)
 #define TRUNCATE_FUNC_IDX (4)
+#define GET_EARLIEST_VER (5)
+#define LOG_TAIL_SIZE_FUNC_IDX (6)
+#define LOG_TAIL_SERIALIZE_FUNC_IDX (7)
+#define LOG_TAIL_APPLY_FUNC_IDX (8)
+#define SAFE_TRIM_FUNC_IDX (9)
 
     PersistentRegistry::PersistentRegistry(
         ITemporalQueryFrontierProvider* tqfp,
@@ -17,6 +24,12 @@ namespace persistent {
         uint32_t shard_num) : 
         _subgroup_prefix(generate_prefix(subgroup_type, subgroup_index, shard_num)),
         _temporal_query_frontier_provider(tqfp) {
+        if(derecho::getConfBoolean(CONF_PERS_SHARED_LOG)) {
+            // all of this registry's file-backed fields will share one
+            // sectioned log, so each persist batch needs only one sync
+            _shared_log_group = std::make_shared<SharedLogGroup>(
+                _subgroup_prefix + "-shared", getPersFilePath());
+        }
     }
 
     PersistentRegistry::~PersistentRegistry() {
@@ -28,13 +41,27 @@ namespace persistent {
     };
 
     const int64_t PersistentRegistry::persist() noexcept(false) {
-        return callFuncMin<PERSIST_FUNC_IDX, int64_t>();
+        const int64_t min_ver = callFuncMin<PERSIST_FUNC_IDX, int64_t>();
+        if(_shared_log_group != nullptr) {
+            // grouped fields only staged their meta commits; this is the
+            // one durability barrier for the whole batch
+            _shared_log_group->sync();
+        }
+        return min_ver;
     };
 
+    std::shared_ptr<SharedLogGroup> PersistentRegistry::getSharedLogGroup() noexcept(true) {
+        return _shared_log_group;
+    }
+
     void PersistentRegistry::trim(const int64_t& earliest_version) noexcept(false) {
         callFunc<TRIM_FUNC_IDX>(earliest_version);
     };
 
+    const version_t PersistentRegistry::trimToSafePoint(const version_t& upper_bound) noexcept(false) {
+        return callFuncMin<SAFE_TRIM_FUNC_IDX, int64_t>(upper_bound);
+    };
+
     const int64_t PersistentRegistry::getMinimumLatestPersistedVersion() noexcept(false) {
         return callFuncMin<GET_ML_PERSISTED_VER, int64_t>();
     }
@@ -55,20 +82,60 @@ namespace persistent {
         callFunc<TRUNCATE_FUNC_IDX>(last_version);
     }
 
+    std::size_t PersistentRegistry::getLogTailSize(const version_t& earliest_version) noexcept(false) {
+        std::size_t total_size = 0;
+        for(auto itr = this->_registry.begin(); itr != this->_registry.end(); ++itr) {
+            total_size += std::get<LOG_TAIL_SIZE_FUNC_IDX>(itr->second)(earliest_version);
+        }
+        return total_size;
+    }
+
+    void PersistentRegistry::postLogTails(const std::function<void(char const* const, std::size_t)>& f,
+                                          const FileRangePostFunc& file_f,
+                                          const version_t& earliest_version) noexcept(false) {
+        for(auto itr = this->_registry.begin(); itr != this->_registry.end(); ++itr) {
+            std::get<LOG_TAIL_SERIALIZE_FUNC_IDX>(itr->second)(f, file_f, earliest_version);
+        }
+    }
+
+    std::size_t PersistentRegistry::mergeLogTails(mutils::DeserializationManager* dsm, char const* buf) {
+        std::size_t ofst = 0;
+        for(auto itr = this->_registry.begin(); itr != this->_registry.end(); ++itr) {
+            ofst += std::get<LOG_TAIL_APPLY_FUNC_IDX>(itr->second)(dsm, buf + ofst);
+        }
+        return ofst;
+    }
+
+    const version_t PersistentRegistry::getMaximumEarliestVersion() noexcept(false) {
+        version_t max_earliest = INVALID_VERSION;
+        for(auto itr = this->_registry.begin(); itr != this->_registry.end(); ++itr) {
+            const version_t earliest = std::get<GET_EARLIEST_VER>(itr->second)();
+            if(earliest > max_earliest) {
+                max_earliest = earliest;
+            }
+        }
+        return max_earliest;
+    }
+
     void PersistentRegistry::registerPersist(const char* obj_name,
                          const VersionFunc& vf,
                          const PersistFunc& pf,
                          const TrimFunc& tf,
                          const LatestPersistedGetterFunc& lpgf,
-                         const TruncateFunc& tcf) noexcept(false) {
+                         const TruncateFunc& tcf,
+                         const EarliestVersionGetterFunc& evgf,
+                         const LogTailSizeFunc& ltsf,
+                         const LogTailSerializeFunc& ltserf,
+                         const LogTailApplyFunc& ltaf,
+                         const SafeTrimFunc& stf) noexcept(false) {
         //this->_registry.push_back(std::make_tuple(vf,pf,tf));
-        auto tuple_val = std::make_tuple(vf, pf, tf, lpgf, tcf);
+        auto tuple_val = std::make_tuple(vf, pf, tf, lpgf, tcf, evgf, ltsf, ltserf, ltaf, stf);
         std::size_t key = std::hash<std::string>{}(obj_name);
-        auto res = this->_registry.insert(std::pair<std::size_t, std::tuple<VersionFunc, PersistFunc, TrimFunc, LatestPersistedGetterFunc, TruncateFunc>>(key, tuple_val));
+        auto res = this->_registry.insert(std::make_pair(key, tuple_val));
         if(res.second == false) {
             //override the previous value:
             this->_registry.erase(res.first);
-            this->_registry.insert(std::pair<std::size_t, std::tuple<VersionFunc, PersistFunc, TrimFunc, LatestPersistedGetterFunc, TruncateFunc>>(key, tuple_val));
+            this->_registry.insert(std::make_pair(key, tuple_val));
         }
     };
 
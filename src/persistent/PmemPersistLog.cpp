@@ -0,0 +1,258 @@
+#include <derecho/persistent/detail/PmemPersistLog.hpp>
+#include <derecho/persistent/detail/util.hpp>
+#include <derecho/conf/conf.hpp>
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <string>
+#include <sys/mman.h>
+#include <unistd.h>
+
+// MAP_SYNC guarantees that a store reaching the mapped page is a store to
+// the backing persistent memory, so cache-line writeback makes it durable.
+// Older libc headers may not define it yet.
+#ifndef MAP_SHARED_VALIDATE
+#define MAP_SHARED_VALIDATE 0x03
+#endif
+#ifndef MAP_SYNC
+#define MAP_SYNC 0x80000
+#endif
+
+#define PMETA_FILE_SUFFIX "pmeta"
+#define CACHE_LINE_SIZE (64)
+
+using namespace std;
+
+namespace persistent {
+
+#if defined(__x86_64__)
+// write back every cache line covering [addr, addr+len)
+static inline void flushRange(const void* addr, const size_t len) noexcept(true) {
+    const uint64_t start = ((uint64_t)addr) & ~(uint64_t)(CACHE_LINE_SIZE - 1);
+    const uint64_t end = (uint64_t)addr + len;
+    for(uint64_t p = start; p < end; p += CACHE_LINE_SIZE) {
+#if defined(__CLWB__)
+        // clwb keeps the line cached, so reads right after persist stay warm
+        __builtin_ia32_clwb((void*)p);
+#elif defined(__CLFLUSHOPT__)
+        __builtin_ia32_clflushopt((void*)p);
+#else
+        __builtin_ia32_clflush((const void*)p);
+#endif
+    }
+}
+
+static inline void storeFence() noexcept(true) {
+    __builtin_ia32_sfence();
+}
+
+// remap a doubly-mapped ring buffer in place with MAP_SYNC
+static bool remapRingWithSync(void* addr, const size_t size, int fd) noexcept(true) {
+    if(mmap(addr, size, PROT_READ | PROT_WRITE,
+            MAP_SHARED_VALIDATE | MAP_SYNC | MAP_FIXED, fd, 0)
+       == MAP_FAILED) {
+        // a failed MAP_FIXED mmap leaves the existing mapping in place
+        return false;
+    }
+    if(mmap((void*)((uint64_t)addr + size), size, PROT_READ | PROT_WRITE,
+            MAP_SHARED_VALIDATE | MAP_SYNC | MAP_FIXED, fd, 0)
+       == MAP_FAILED) {
+        return false;
+    }
+    return true;
+}
+#endif  //__x86_64__
+
+PmemPersistLog::PmemPersistLog(const string& name, const string& dataPath) noexcept(false)
+        : FilePersistLog(name, dataPath),
+          m_bDax(false),
+          m_iPmetaFileDesc(-1),
+          m_pPmeta(MAP_FAILED) {
+    setupDax();
+    reconcileMetaHeaders();
+    if(!this->m_bDax) {
+        dbg_default_warn("{0} pmem path {1} does not support MAP_SYNC, falling back to msync persistence.",
+                         this->m_sName, dataPath);
+    }
+}
+
+PmemPersistLog::~PmemPersistLog() noexcept(true) {
+    // bring the regular meta file up to date so FilePersistLog can reload
+    // this log without consulting the pmeta slab
+    if(this->m_bDax) {
+        try {
+            FPL_PERS_LOCK;
+            persistMetaHeaderAtomically(META_HEADER_PERS);
+            FPL_PERS_UNLOCK;
+        } catch(uint64_t e) {
+            dbg_default_error("{0} failed to write the meta file on shutdown, exp:{1}", this->m_sName, e);
+        }
+    }
+    if(this->m_pPmeta != MAP_FAILED) {
+        munmap(this->m_pPmeta, PAGE_SIZE);
+        this->m_pPmeta = MAP_FAILED;
+    }
+    if(this->m_iPmetaFileDesc != -1) {
+        close(this->m_iPmetaFileDesc);
+        this->m_iPmetaFileDesc = -1;
+    }
+}
+
+void PmemPersistLog::setupDax() noexcept(false) {
+    const string pmetaFile = this->m_sDataPath + "/" + this->m_sName + "." + PMETA_FILE_SUFFIX;
+    checkOrCreateFileWithSize(pmetaFile, PAGE_SIZE);
+    this->m_iPmetaFileDesc = open(pmetaFile.c_str(), O_RDWR);
+    if(this->m_iPmetaFileDesc == -1) {
+        throw PERSIST_EXP_OPEN_FILE(errno);
+    }
+#if defined(__x86_64__)
+    this->m_pPmeta = mmap(NULL, PAGE_SIZE, PROT_READ | PROT_WRITE,
+                          MAP_SHARED_VALIDATE | MAP_SYNC, this->m_iPmetaFileDesc, 0);
+    if(this->m_pPmeta != MAP_FAILED) {
+        this->m_bDax = remapRingWithSync(this->m_pLog, MAX_LOG_SIZE, this->m_iLogFileDesc)
+                       && remapRingWithSync(this->m_pData, (size_t)MAX_DATA_SIZE, this->m_iDataFileDesc);
+    }
+#endif  //__x86_64__
+    if(this->m_pPmeta == MAP_FAILED) {
+        // map it normally anyway: reconcileMetaHeaders() still needs to read
+        // and refresh the slab so a later DAX run sees current state
+        this->m_pPmeta = mmap(NULL, PAGE_SIZE, PROT_READ | PROT_WRITE,
+                              MAP_SHARED, this->m_iPmetaFileDesc, 0);
+        if(this->m_pPmeta == MAP_FAILED) {
+            throw PERSIST_EXP_MMAP_FILE(errno);
+        }
+    }
+}
+
+void PmemPersistLog::reconcileMetaHeaders() noexcept(false) {
+    PmetaSlab* slab = (PmetaSlab*)this->m_pPmeta;
+    if(slab->selector != 0) {
+        MetaHeader* slot = &slab->slots[slab->selector & 1];
+        if(slot->fields.ver > META_HEADER_PERS->fields.ver) {
+            // the previous run crashed after a fast meta publish but before
+            // the meta file was rewritten; the entries it covers are already
+            // durable in the DAX-mapped files, so adopt them
+            dbg_default_info("{0} adopting pmeta header (ver {1} > meta file ver {2}).",
+                             this->m_sName, slot->fields.ver, META_HEADER_PERS->fields.ver);
+            FPL_WRLOCK;
+            const int64_t old_tail = META_HEADER->fields.tail;
+            *META_HEADER_PERS = *slot;
+            *META_HEADER = *slot;
+            for(int64_t idx = old_tail; idx < META_HEADER->fields.tail; idx++) {
+                this->hidx.insert(hlc_index_entry{
+                        HLC{LOG_ENTRY_AT(idx)->fields.hlc_r, LOG_ENTRY_AT(idx)->fields.hlc_l}, idx});
+                this->vidx.emplace_back(LOG_ENTRY_AT(idx)->fields.ver, idx);
+            }
+            FPL_UNLOCK;
+            FPL_PERS_LOCK;
+            try {
+                persistMetaHeaderAtomically(META_HEADER_PERS);
+            } catch(uint64_t e) {
+                FPL_PERS_UNLOCK;
+                throw e;
+            }
+            FPL_PERS_UNLOCK;
+            return;
+        }
+    }
+    // the meta file is current (or newer, e.g. the log was last written by
+    // FilePersistLog): refresh the slab to match it
+    const uint64_t next = slab->selector + 1;
+    slab->slots[next & 1] = *META_HEADER_PERS;
+    slab->selector = next;
+#if defined(__x86_64__)
+    if(this->m_bDax) {
+        flushRange(slab, sizeof(PmetaSlab));
+        storeFence();
+        return;
+    }
+#endif  //__x86_64__
+    if(msync(this->m_pPmeta, PAGE_SIZE, MS_SYNC) != 0) {
+        throw PERSIST_EXP_MSYNC(errno);
+    }
+}
+
+void PmemPersistLog::persistMetaHeaderFast(MetaHeader* pShadowHeader) noexcept(false) {
+#if defined(__x86_64__)
+    PmetaSlab* slab = (PmetaSlab*)this->m_pPmeta;
+    const uint64_t next = slab->selector + 1;
+    MetaHeader* slot = &slab->slots[next & 1];
+    *slot = *pShadowHeader;
+    flushRange(slot, sizeof(MetaHeader));
+    storeFence();
+    // the 8-byte selector store is atomic: a crash leaves either the old or
+    // the new header active, never a torn one
+    slab->selector = next;
+    flushRange(&slab->selector, sizeof(slab->selector));
+    storeFence();
+#endif  //__x86_64__
+    *META_HEADER_PERS = *pShadowHeader;
+}
+
+const version_t PmemPersistLog::persist(const bool preLocked) noexcept(false) {
+    if(!this->m_bDax) {
+        return FilePersistLog::persist(preLocked);
+    }
+    version_t ver_ret = INVALID_VERSION;
+    if(!preLocked) {
+        FPL_PERS_LOCK;
+        FPL_RDLOCK;
+    }
+
+    if(*META_HEADER == *META_HEADER_PERS) {
+        if(CURR_LOG_IDX != -1) {
+            ver_ret = META_HEADER->fields.ver;
+        }
+        if(!preLocked) {
+            FPL_UNLOCK;
+            FPL_PERS_UNLOCK;
+        }
+        return ver_ret;
+    }
+
+    dbg_default_trace("{0} flush data,log,and meta via cache-line writeback.", this->m_sName);
+    try {
+        // shadow the current state
+        const void *flush_dstart = nullptr, *flush_lstart = nullptr;
+        size_t flush_dlen = 0, flush_llen = 0;
+        MetaHeader shadow_header = *META_HEADER;
+        if((NUM_USED_SLOTS > 0) && (NEXT_LOG_ENTRY > NEXT_LOG_ENTRY_PERS)) {
+            // stores are durable at cache-line grain, so the exact dirty
+            // ranges suffice - no page alignment as in the msync path
+            flush_dstart = NEXT_DATA_PERS;
+            flush_dlen = (LOG_ENTRY_AT(CURR_LOG_IDX)->fields.ofst + LOG_ENTRY_AT(CURR_LOG_IDX)->fields.dlen - NEXT_LOG_ENTRY_PERS->fields.ofst);
+            flush_lstart = NEXT_LOG_ENTRY_PERS;
+            flush_llen = (size_t)NEXT_LOG_ENTRY - (size_t)NEXT_LOG_ENTRY_PERS;
+        }
+        if(NUM_USED_SLOTS > 0) {
+            ver_ret = META_HEADER->fields.ver;
+        }
+        if(!preLocked) {
+            FPL_UNLOCK;
+        }
+        if(flush_dlen > 0) {
+            flushRange(flush_dstart, flush_dlen);
+        }
+        if(flush_llen > 0) {
+            flushRange(flush_lstart, flush_llen);
+        }
+        if(flush_dlen > 0 || flush_llen > 0) {
+            // entries and data must be durable before the header points at them
+            storeFence();
+        }
+        persistMetaHeaderFast(&shadow_header);
+    } catch(uint64_t e) {
+        if(!preLocked) {
+            FPL_PERS_UNLOCK;
+        }
+        throw e;
+    }
+    dbg_default_trace("{0} flush data,log,and meta via cache-line writeback...done.", this->m_sName);
+
+    if(!preLocked) {
+        FPL_PERS_UNLOCK;
+    }
+    return ver_ret;
+}
+
+}  // namespace persistent
@@ -0,0 +1,135 @@
+#include <derecho/persistent/detail/SharedLogGroup.hpp>
+#include <derecho/persistent/detail/util.hpp>
+#include <derecho/conf/conf.hpp>
+#include <derecho/utils/logger.hpp>
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#if __GNUC__ > 7
+#include <filesystem>
+namespace fs = std::filesystem;
+#else
+#include <experimental/filesystem>
+namespace fs = std::experimental::filesystem;
+#endif
+
+namespace persistent {
+
+SharedLogGroup::SharedLogGroup(const std::string& name, const std::string& dataPath) noexcept(false)
+        : m_sLogFile(dataPath + "/" + name + "." + LOG_FILE_SUFFIX),
+          m_sDataFile(dataPath + "/" + name + "." + DATA_FILE_SUFFIX),
+          m_iLogFileDesc(-1),
+          m_iDataFileDesc(-1),
+          m_iLogBytesAllocated(0),
+          m_iDataBytesAllocated(0) {
+    checkOrCreateDir(dataPath);
+    if(derecho::getConfBoolean(CONF_PERS_RESET)) {
+        if(fs::exists(this->m_sLogFile) && !fs::remove(this->m_sLogFile)) {
+            dbg_default_error("{0} reset failed to remove the file:{1}", name, this->m_sLogFile);
+            throw PERSIST_EXP_REMOVE_FILE(errno);
+        }
+        if(fs::exists(this->m_sDataFile) && !fs::remove(this->m_sDataFile)) {
+            dbg_default_error("{0} reset failed to remove the file:{1}", name, this->m_sDataFile);
+            throw PERSIST_EXP_REMOVE_FILE(errno);
+        }
+    }
+    this->m_iLogFileDesc = open(this->m_sLogFile.c_str(), O_RDWR | O_CREAT,
+                                S_IWUSR | S_IRUSR | S_IRGRP | S_IWGRP | S_IROTH);
+    if(this->m_iLogFileDesc == -1) {
+        throw PERSIST_EXP_OPEN_FILE(errno);
+    }
+    this->m_iDataFileDesc = open(this->m_sDataFile.c_str(), O_RDWR | O_CREAT,
+                                 S_IWUSR | S_IRUSR | S_IRGRP | S_IWGRP | S_IROTH);
+    if(this->m_iDataFileDesc == -1) {
+        close(this->m_iLogFileDesc);
+        throw PERSIST_EXP_OPEN_FILE(errno);
+    }
+    dbg_default_trace("shared log group {0} opened.", name);
+}
+
+SharedLogGroup::~SharedLogGroup() noexcept(true) {
+    if(this->m_iLogFileDesc != -1) {
+        close(this->m_iLogFileDesc);
+    }
+    if(this->m_iDataFileDesc != -1) {
+        close(this->m_iDataFileDesc);
+    }
+}
+
+std::pair<uint64_t, uint64_t> SharedLogGroup::addSection(const uint64_t& logBytes, const uint64_t& dataBytes) noexcept(false) {
+    std::lock_guard<std::mutex> lck(this->m_groupMutex);
+    const uint64_t page_size = (uint64_t)getpagesize();
+    auto align_up = [page_size](const uint64_t& x) {
+        return (x + page_size - 1) / page_size * page_size;
+    };
+    const uint64_t log_ofst = align_up(this->m_iLogBytesAllocated);
+    const uint64_t data_ofst = align_up(this->m_iDataBytesAllocated);
+    this->m_iLogBytesAllocated = log_ofst + logBytes;
+    this->m_iDataBytesAllocated = data_ofst + dataBytes;
+    // grow, never shrink: a file left from a previous run is already sized
+    struct stat sb;
+    if(fstat(this->m_iLogFileDesc, &sb) != 0) {
+        throw PERSIST_EXP_READ_FILE(errno);
+    }
+    if((uint64_t)sb.st_size < this->m_iLogBytesAllocated
+       && ftruncate(this->m_iLogFileDesc, this->m_iLogBytesAllocated) != 0) {
+        throw PERSIST_EXP_TRUNCATE_FILE(errno);
+    }
+    if(fstat(this->m_iDataFileDesc, &sb) != 0) {
+        throw PERSIST_EXP_READ_FILE(errno);
+    }
+    if((uint64_t)sb.st_size < this->m_iDataBytesAllocated
+       && ftruncate(this->m_iDataFileDesc, this->m_iDataBytesAllocated) != 0) {
+        throw PERSIST_EXP_TRUNCATE_FILE(errno);
+    }
+    return std::make_pair(log_ofst, data_ofst);
+}
+
+void SharedLogGroup::stageCommit(FilePersistLog* member, const MetaHeader& shadow_header) noexcept(false) {
+    std::lock_guard<std::mutex> lck(this->m_groupMutex);
+    for(auto& staged : this->m_stagedCommits) {
+        if(staged.first == member) {
+            staged.second = shadow_header;
+            return;
+        }
+    }
+    this->m_stagedCommits.emplace_back(member, shadow_header);
+}
+
+void SharedLogGroup::forgetMember(FilePersistLog* member) noexcept(true) {
+    std::lock_guard<std::mutex> lck(this->m_groupMutex);
+    for(auto itr = this->m_stagedCommits.begin(); itr != this->m_stagedCommits.end(); ++itr) {
+        if(itr->first == member) {
+            this->m_stagedCommits.erase(itr);
+            return;
+        }
+    }
+}
+
+void SharedLogGroup::sync() noexcept(false) {
+    // Take the staged commits out first: commitMetaHeader acquires each
+    // member's persistence lock, which a member staging from trim() already
+    // holds, so committing under m_groupMutex would invert the lock order.
+    std::vector<std::pair<FilePersistLog*, MetaHeader>> staged;
+    {
+        std::lock_guard<std::mutex> lck(this->m_groupMutex);
+        if(this->m_stagedCommits.empty()) {
+            return;
+        }
+        staged.swap(this->m_stagedCommits);
+    }
+    // one barrier covers every member's log and data writes in this batch
+    if(fdatasync(this->m_iLogFileDesc) != 0) {
+        throw PERSIST_EXP_FSYNC(errno);
+    }
+    if(fdatasync(this->m_iDataFileDesc) != 0) {
+        throw PERSIST_EXP_FSYNC(errno);
+    }
+    // with the ring pages durable, the meta headers can commit
+    for(auto& staged_commit : staged) {
+        staged_commit.first->commitMetaHeader(staged_commit.second);
+    }
+}
+}  // namespace persistent
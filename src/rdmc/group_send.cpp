@@ -8,6 +8,8 @@
     #include <derecho/rdmc/detail/lf_helper.hpp>
 #endif
 
+#include <derecho/conf/conf.hpp>
+
 #include <cassert>
 #include <cstring>
 
@@ -26,7 +28,7 @@ group::group(uint16_t _group_number, size_t _block_size,
              vector<uint32_t> _members, uint32_t _member_index,
              incoming_message_callback_t upcall,
              completion_callback_t callback,
-             unique_ptr<schedule> _schedule)
+             std::shared_ptr<const schedule> _schedule)
         : members(_members),
           group_number(_group_number),
           block_size(_block_size),
@@ -71,10 +73,13 @@ polling_group::polling_group(uint16_t _group_number, size_t _block_size,
                              vector<uint32_t> _members, uint32_t _member_index,
                              incoming_message_callback_t upcall,
                              completion_callback_t callback,
-                             unique_ptr<schedule> _schedule)
+                             std::shared_ptr<const schedule> _schedule,
+                             progress_callback_t _progress_callback)
         : group(_group_number, _block_size, _members, _member_index, upcall,
                 callback, std::move(_schedule)),
-          first_block_buffer(nullptr) {
+          first_block_buffer(nullptr),
+          progress_callback(_progress_callback),
+          max_queued_sends(derecho::getConfUInt32(CONF_RDMA_RDMC_SEND_QUEUE_DEPTH)) {
     if(member_index != 0) {
         first_block_buffer = unique_ptr<char[]>(new char[block_size]);
         memset(first_block_buffer.get(), 0, block_size);
@@ -95,6 +100,26 @@ polling_group::polling_group(uint16_t _group_number, size_t _block_size,
         // puts("Issued Ready For Block CCCCCCCCC");
     }
 }
+bool polling_group::migrate(uint16_t new_group_number,
+                            const vector<uint32_t>& new_members, size_t new_block_size,
+                            incoming_message_callback_t upcall,
+                            completion_callback_t callback) {
+    std::unique_lock<std::mutex> lock(monitor);
+    if(new_members != members || new_block_size != block_size) {
+        return false;
+    }
+    // Refuse if a message is in flight or queued behind one; the endpoints
+    // and the posted receive for the next first block carry over unchanged
+    if(mr || sending || !queued_sends.empty()) {
+        return false;
+    }
+    group_number = new_group_number;
+    incoming_message_upcall = std::move(upcall);
+    completion_callback = std::move(callback);
+    LOG_EVENT(group_number, -1, -1, "migrated_group");
+    return true;
+}
+
 void polling_group::receive_block(uint32_t send_imm, size_t received_block_size) {
     unique_lock<mutex> lock(monitor);
 
@@ -123,6 +148,17 @@ void polling_group::receive_block(uint32_t send_imm, size_t received_block_size)
         received_blocks = vector<bool>(num_blocks);
         received_blocks[*first_block_number] = true;
 
+        if(progress_callback) {
+            // Streaming delivery needs the first block in its real position
+            // now, not at complete_message time, so the contiguous prefix is
+            // actually readable from the message buffer.
+            size_t first_block_offset = block_size * (*first_block_number);
+            memcpy(mr->buffer + mr_offset + first_block_offset,
+                   first_block_buffer.get(),
+                   min(block_size, message_size - first_block_offset));
+            update_streaming_prefix();
+        }
+
         LOG_EVENT(group_number, message_number, *first_block_number,
                   "initialized_internal_datastructures");
 
@@ -199,6 +235,10 @@ void polling_group::receive_block(uint32_t send_imm, size_t received_block_size)
 
         received_blocks[block_number] = true;
 
+        if(progress_callback) {
+            update_streaming_prefix();
+        }
+
         LOG_EVENT(group_number, message_number, block_number, "received_block");
 
         // Figure out the next block to receive.
@@ -277,18 +317,31 @@ void polling_group::send_message(shared_ptr<memory_region> message_mr, size_t of
 
     if(length == 0) throw rdmc::invalid_args();
     if(offset + length > message_mr->size) throw rdmc::invalid_args();
+    if((length - 1) / block_size + 1 > std::numeric_limits<uint16_t>::max())
+        throw rdmc::invalid_args();
     if(member_index > 0) throw rdmc::nonroot_sender();
 
-    // Queueing sends is not supported
     if(receive_step > 0) throw rdmc::group_busy();
-    if(send_step > 0) throw rdmc::group_busy();
+    if(send_step > 0 || mr) {
+        // A message is still in flight; queue this one behind it if the
+        // configured pipeline depth allows.
+        if(queued_sends.size() < max_queued_sends) {
+            queued_sends.push_back(queued_message{message_mr, offset, length});
+            LOG_EVENT(group_number, message_number, -1, "queued_send");
+            return;
+        }
+        throw rdmc::group_busy();
+    }
 
+    begin_send(message_mr, offset, length);
+}
+void polling_group::begin_send(shared_ptr<memory_region> message_mr, size_t offset,
+                               size_t length) {
+    // Caller must hold the monitor, and the group must be idle.
     mr = message_mr;
     mr_offset = offset;
     message_size = length;
     num_blocks = (message_size - 1) / block_size + 1;
-    if(num_blocks > std::numeric_limits<uint16_t>::max())
-        throw rdmc::invalid_args();
     // printf("message_size = %lu, block_size = %lu, num_blocks = %lu\n",
     //        message_size, block_size, num_blocks);
     LOG_EVENT(group_number, message_number, -1, "send_message");
@@ -335,6 +388,7 @@ void polling_group::send_next_block() {
     auto it = endpoints.find(target);
     assert(it != endpoints.end());
 #endif
+#ifdef USE_VERBS_API
     if(first_block_number && block_number == *first_block_number) {
         CHECK(it->second.post_send(*first_block_mr, 0, block_size,
                                    form_tag(group_number, target),
@@ -348,10 +402,41 @@ void polling_group::send_next_block() {
                                    form_immediate(num_blocks, block_number),
                                    message_types.data_block));
     }
+#else
+    /** Stripe blocks across the configured rails (NICs). The assignment must
+     * be a pure function of the block number so that post_recv puts the
+     * matching receive on the same rail. */
+    const unsigned int rail = block_number % rdma::impl::lf_num_rails();
+    if(first_block_number && block_number == *first_block_number) {
+        CHECK(it->second.post_send(*first_block_mr, 0, block_size,
+                                   form_tag(group_number, target),
+                                   form_immediate(num_blocks, block_number),
+                                   message_types.data_block, rail));
+    } else {
+        size_t offset = block_number * block_size;
+        size_t nbytes = min(block_size, message_size - offset);
+        CHECK(it->second.post_send(*mr, mr_offset + offset, nbytes,
+                                   form_tag(group_number, target),
+                                   form_immediate(num_blocks, block_number),
+                                   message_types.data_block, rail));
+    }
+#endif
     outgoing_block = block_number;
     LOG_EVENT(group_number, message_number, block_number,
               "started_sending_block");
 }
+void polling_group::update_streaming_prefix() {
+    // Caller must hold the monitor and have progress_callback set.
+    const size_t old_contiguous_blocks = contiguous_blocks;
+    while(contiguous_blocks < num_blocks && received_blocks[contiguous_blocks]) {
+        ++contiguous_blocks;
+    }
+    // The full message is reported through the completion callback instead.
+    if(contiguous_blocks > old_contiguous_blocks && contiguous_blocks < num_blocks) {
+        progress_callback(mr->buffer + mr_offset,
+                          min(contiguous_blocks * block_size, message_size));
+    }
+}
 void polling_group::complete_message() {
     // remap first_block into buffer
     if(member_index > 0 && first_block_number) {
@@ -394,6 +479,7 @@ void polling_group::complete_message() {
 
     if(member_index != 0) {
         num_received_blocks = 0;
+        contiguous_blocks = 0;
         received_blocks.clear();
         auto transfer = transfer_schedule->get_first_block(num_blocks);
         assert(transfer);
@@ -404,6 +490,14 @@ void polling_group::complete_message() {
         // cout << "Issued Ready For Block DDDDDDD (target = " <<
         // transfer->target
         //      << ")" << endl;
+    } else if(!queued_sends.empty()) {
+        // Root with a queued message: start it right away instead of waiting
+        // for the caller to notice the completion and call send again. If the
+        // receivers have not yet re-armed, send_next_block stalls until their
+        // ready-for-block messages arrive.
+        queued_message next = std::move(queued_sends.front());
+        queued_sends.pop_front();
+        begin_send(next.mr, next.offset, next.length);
     }
 }
 void polling_group::post_recv(schedule::block_transfer transfer) {
@@ -418,6 +512,7 @@ void polling_group::post_recv(schedule::block_transfer transfer) {
     //        (int)transfer.block_number, (int)transfer.target);
     // fflush(stdout);
 
+#ifdef USE_VERBS_API
     if(first_block_number && transfer.block_number == *first_block_number) {
         CHECK(it->second.post_recv(*first_block_mr, 0, block_size,
                                    form_tag(group_number, transfer.target),
@@ -432,6 +527,25 @@ void polling_group::post_recv(schedule::block_transfer transfer) {
                                        message_types.data_block));
         }
     }
+#else
+    /** Receive on the rail the sender will stripe this block onto; see
+     * send_next_block. */
+    const unsigned int rail = transfer.block_number % rdma::impl::lf_num_rails();
+    if(first_block_number && transfer.block_number == *first_block_number) {
+        CHECK(it->second.post_recv(*first_block_mr, 0, block_size,
+                                   form_tag(group_number, transfer.target),
+                                   message_types.data_block, rail));
+    } else {
+        size_t offset = block_size * transfer.block_number;
+        size_t length = min(block_size, (size_t)(message_size - offset));
+
+        if(length > 0) {
+            CHECK(it->second.post_recv(*mr, mr_offset + offset, length,
+                                       form_tag(group_number, transfer.target),
+                                       message_types.data_block, rail));
+        }
+    }
+#endif
     LOG_EVENT(group_number, message_number, transfer.block_number,
               "posted_receive_buffer");
 }
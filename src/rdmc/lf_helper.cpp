@@ -5,6 +5,8 @@
 #include <fcntl.h>
 #include <iostream>
 #include <list>
+#include <map>
+#include <memory>
 #include <mutex>
 #include <poll.h>
 #include <rdma/fabric.h>
@@ -21,7 +23,9 @@
 #include <derecho/rdmc/detail/lf_helper.hpp>
 #include <derecho/rdmc/detail/util.hpp>
 #include <derecho/tcp/tcp.hpp>
+#include <derecho/utils/completion_engine.hpp>
 #include <derecho/utils/logger.hpp>
+#include <derecho/utils/pinned_memory_budget.hpp>
 
 /** From sst/verbs.cpp */
 #if __BYTE_ORDER == __LITTLE_ENDIAN
@@ -100,6 +104,16 @@ struct lf_ctxt {
 };
 /** The global context for libfabric */
 struct lf_ctxt g_ctxt;
+/** A second, fully independent fabric/domain/cq stack on the NIC named by
+ * RDMA/second_domain. RDMC block transfers are striped across the two rails
+ * to aggregate the bandwidth of both NICs; all other traffic (ready-for-block
+ * messages, the SST) stays on the primary rail. */
+struct lf_ctxt g_second_rail_ctxt;
+static bool second_rail_active = false;
+
+static inline lf_ctxt& rail_ctxt(unsigned int rail) {
+    return (rail == 0) ? g_ctxt : g_second_rail_ctxt;
+}
 
 #define LF_USE_VADDR ((g_ctxt.fi->domain_attr->mr_mode) & (FI_MR_VIRT_ADDR | FI_MR_BASIC))
 #define LF_CONFIG_FILE "rdma.cfg"
@@ -115,47 +129,59 @@ enum RDMAOps {
 
 namespace impl {
 
-/** 
- * Populate some of the global context with default valus 
+/**
+ * Populate some of the given context with default values, using the given
+ * domain (NIC) name.
  */
-static void default_context() {
-    memset((void*)&g_ctxt, 0, sizeof(struct lf_ctxt));
+static void default_context(lf_ctxt& ctxt, const std::string& domain_name) {
+    memset((void*)&ctxt, 0, sizeof(struct lf_ctxt));
 
     /** Create a new empty fi_info structure */
-    g_ctxt.hints = crash_if_nullptr("Fail to allocate fi hints", fi_allocinfo);
+    ctxt.hints = crash_if_nullptr("Fail to allocate fi hints", fi_allocinfo);
     /** Set the interface capabilities, see fi_getinfo(3) for details */
-    g_ctxt.hints->caps = FI_MSG | FI_RMA | FI_READ | FI_WRITE | FI_REMOTE_READ | FI_REMOTE_WRITE;
+    ctxt.hints->caps = FI_MSG | FI_RMA | FI_READ | FI_WRITE | FI_REMOTE_READ | FI_REMOTE_WRITE;
     /** Use connection-based endpoints */
-    g_ctxt.hints->ep_attr->type = FI_EP_MSG;
+    ctxt.hints->ep_attr->type = FI_EP_MSG;
     /** Enable all modes */
-    g_ctxt.hints->mode = ~0;
+    ctxt.hints->mode = ~0;
     /** Set the completion format to contain additional context */
-    g_ctxt.cq_attr.format = FI_CQ_FORMAT_DATA;
-    /** Use a file descriptor as the wait object (see polling_loop)*/
-    g_ctxt.cq_attr.wait_obj = FI_WAIT_FD;
+    ctxt.cq_attr.format = FI_CQ_FORMAT_DATA;
+    /** Use a file descriptor as the wait object (see drain_rail_cq)*/
+    ctxt.cq_attr.wait_obj = FI_WAIT_FD;
     /** Set the size of the local pep address */
-    g_ctxt.pep_addr_len = max_lf_addr_size;
+    ctxt.pep_addr_len = max_lf_addr_size;
 
     /** Set the provider, can be verbs|psm|sockets|usnic */
-    g_ctxt.hints->fabric_attr->prov_name = crash_if_nullptr("strdup provider name.",
-                                                            strdup, derecho::getConfString(CONF_RDMA_PROVIDER).c_str());
+    ctxt.hints->fabric_attr->prov_name = crash_if_nullptr("strdup provider name.",
+                                                          strdup, derecho::getConfString(CONF_RDMA_PROVIDER).c_str());
     /** Set the domain */
-    g_ctxt.hints->domain_attr->name = crash_if_nullptr("strdup domain name.",
-                                                       strdup, derecho::getConfString(CONF_RDMA_DOMAIN).c_str());
+    ctxt.hints->domain_attr->name = crash_if_nullptr("strdup domain name.",
+                                                     strdup, domain_name.c_str());
     /** Set the memory region mode mode bits, see fi_mr(3) for details */
-    if(strcmp(g_ctxt.hints->fabric_attr->prov_name, "sockets") == 0) {
-        g_ctxt.hints->domain_attr->mr_mode = FI_MR_BASIC;
+    if(strcmp(ctxt.hints->fabric_attr->prov_name, "sockets") == 0) {
+        ctxt.hints->domain_attr->mr_mode = FI_MR_BASIC;
     } else {  // default
         /** Set the sizes of the tx and rx queues */
-        g_ctxt.hints->tx_attr->size = derecho::Conf::get()->getInt32(CONF_RDMA_TX_DEPTH);
-        g_ctxt.hints->rx_attr->size = derecho::Conf::get()->getInt32(CONF_RDMA_RX_DEPTH);
-        if(g_ctxt.hints->tx_attr->size == 0 || g_ctxt.hints->rx_attr->size == 0) {
+        ctxt.hints->tx_attr->size = derecho::Conf::get()->getInt32(CONF_RDMA_TX_DEPTH);
+        ctxt.hints->rx_attr->size = derecho::Conf::get()->getInt32(CONF_RDMA_RX_DEPTH);
+        if(ctxt.hints->tx_attr->size == 0 || ctxt.hints->rx_attr->size == 0) {
             dbg_default_error("Configuration error! RDMA TX and RX depth must be nonzero.");
             std::cerr << "Configuration error! RDMA TX and RX depth must be nonzero." << std::endl;
             dbg_default_flush();
             exit(-1);
         }
-        g_ctxt.hints->domain_attr->mr_mode = FI_MR_LOCAL | FI_MR_ALLOCATED | FI_MR_PROV_KEY | FI_MR_VIRT_ADDR;
+        ctxt.hints->domain_attr->mr_mode = FI_MR_LOCAL | FI_MR_ALLOCATED | FI_MR_PROV_KEY | FI_MR_VIRT_ADDR;
+    }
+    /** Request heterogeneous-memory support so device (GPU) buffers can be
+     * registered for GPUDirect RDMA; opt-in because providers without
+     * FI_HMEM would refuse the capability bit. */
+    if(derecho::getConfBoolean(CONF_RDMA_ENABLE_HMEM)) {
+#ifdef FI_HMEM
+        ctxt.hints->caps |= FI_HMEM;
+        ctxt.hints->domain_attr->mr_mode |= FI_MR_HMEM;
+#else
+        dbg_default_warn("RDMA/enable_hmem is set, but this libfabric build has no FI_HMEM support; device memory registration will be unavailable.");
+#endif
     }
 }
 }  // namespace impl
@@ -167,29 +193,178 @@ using namespace impl;
  * Memory region constructors and member functions
  */
 
+/**
+ * Cache of memory registrations, keyed by buffer address and length. RDMC
+ * sends from pooled buffers construct a memory_region per message, which
+ * normally pays for a full fi_mr_reg/fi_close round trip each time; the cache
+ * lets repeated registrations of the same buffer reuse the existing fid_mr.
+ * The cache holds one reference to each registration and every live
+ * memory_region built from it holds another, so a registration is only closed
+ * when it is evicted while no memory_region still uses it. Eviction is
+ * least-recently-used among unused entries, bounded by RDMA/mr_cache_size
+ * (0 disables the cache and preserves the register-per-construction
+ * behavior). A cached registration keeps its pages pinned after the
+ * memory_region is destroyed, so the cache must only be enabled when send
+ * buffers are long-lived and are not freed, remapped (e.g. by
+ * madvise(MADV_DONTNEED)) or written from a forked child while an entry for
+ * them may still exist; hence it is off by default.
+ */
+struct cached_mr_entry {
+    std::shared_ptr<fid_mr> registration;
+    /** Registration on the second rail's domain; null in single-rail mode */
+    std::shared_ptr<fid_mr> second_registration;
+    uint64_t last_used;
+};
+static std::map<std::pair<uintptr_t, size_t>, cached_mr_entry> mr_cache;
+static std::mutex mr_cache_mutex;
+static uint64_t mr_cache_ticks = 0;
+
+/** Register the buffer on the given domain, crashing on failure. Charges the
+ * rdmc pinned-memory account; the mr's deleter must release the same amount. */
+static fid_mr* register_raw_mr(fid_domain* domain, char* buffer, size_t size,
+                               int mr_access) {
+    derecho::pinned_memory::charge(derecho::pinned_memory::rdmc_account, size);
+    fid_mr* raw_mr;
+    fail_if_nonzero_retry_on_eagain(
+            "Failed to register memory", CRASH_ON_FAILURE,
+            fi_mr_reg, domain, (void*)buffer, size, mr_access, 0, 0, 0, &raw_mr, nullptr);
+    if(!raw_mr) {
+        crash_with_message("Pointer to memory region is null");
+    }
+    return raw_mr;
+}
+
+/** Deleter for registrations made by register_raw_mr/register_raw_device_mr:
+ * closes the mr and returns its bytes to the rdmc pinned-memory account. */
+static std::function<void(fid_mr*)> close_and_release_mr(size_t size) {
+    return [size](fid_mr* mr) {
+        fi_close(&mr->fid);
+        derecho::pinned_memory::release(derecho::pinned_memory::rdmc_account, size);
+    };
+}
+
+/** Register a CUDA device buffer on the given domain through the provider's
+ * FI_HMEM support, crashing on registration failure and throwing
+ * unsupported_feature when libfabric was built without FI_HMEM. */
+static fid_mr* register_raw_device_mr(fid_domain* domain, char* buffer, size_t size,
+                                      int mr_access, const memory_attribute& attr) {
+#ifdef FI_HMEM
+    derecho::pinned_memory::charge(derecho::pinned_memory::rdmc_account, size);
+    fid_mr* raw_mr;
+    struct iovec mr_iov;
+    mr_iov.iov_base = (void*)buffer;
+    mr_iov.iov_len = size;
+    struct fi_mr_attr mr_attr;
+    memset(&mr_attr, 0, sizeof(mr_attr));
+    mr_attr.mr_iov = &mr_iov;
+    mr_attr.iov_count = 1;
+    mr_attr.access = mr_access;
+    mr_attr.iface = FI_HMEM_CUDA;
+    mr_attr.device.cuda = attr.device_id;
+    fail_if_nonzero_retry_on_eagain(
+            "Failed to register device memory", CRASH_ON_FAILURE,
+            fi_mr_regattr, domain, &mr_attr, 0, &raw_mr);
+    if(!raw_mr) {
+        crash_with_message("Pointer to device memory region is null");
+    }
+    return raw_mr;
+#else
+    (void)domain;
+    (void)buffer;
+    (void)size;
+    (void)mr_access;
+    (void)attr;
+    throw unsupported_feature();
+#endif
+}
+
 memory_region::memory_region(size_t s) : memory_region(new char[s], s) {
     allocated_buffer.reset(buffer);
 }
 
-memory_region::memory_region(char* buf, size_t s) : buffer(buf), size(s) {
+memory_region::memory_region(char* buf, size_t s) : memory_region(buf, s, memory_attribute::host()) {
+}
+
+memory_region::memory_region(char* buf, size_t s, const memory_attribute& attr) : buffer(buf), size(s) {
     if(!buffer || size <= 0) throw rdma::invalid_args();
 
     const int mr_access = FI_WRITE | FI_REMOTE_READ | FI_REMOTE_WRITE;
 
-    /** Register the memory, use it to construct a smart pointer */
-    fid_mr* raw_mr;
-    fail_if_nonzero_retry_on_eagain(
-            "Failed to register memory", CRASH_ON_FAILURE,
-            fi_mr_reg, g_ctxt.domain, (void*)buffer, size, mr_access, 0, 0, 0, &raw_mr, nullptr);
-    if(!raw_mr) {
-        crash_with_message("Pointer to memory region is null");
+    if(attr.type == memory_attribute::memory_type::cuda) {
+        /** Device registrations bypass the cache: device buffers of model
+         * size are registered once and kept alive by their owners, and the
+         * cache key would not separate host from device address spaces. */
+        mr = std::unique_ptr<fid_mr, std::function<void(fid_mr*)>>(
+                register_raw_device_mr(g_ctxt.domain, buffer, size, mr_access, attr),
+                close_and_release_mr(size));
+        if(second_rail_active) {
+            second_mr = std::unique_ptr<fid_mr, std::function<void(fid_mr*)>>(
+                    register_raw_device_mr(g_second_rail_ctxt.domain, buffer, size, mr_access, attr),
+                    close_and_release_mr(size));
+        }
+        return;
+    }
+
+    static const uint32_t mr_cache_size = derecho::getConfUInt32(CONF_RDMA_MR_CACHE_SIZE);
+    if(mr_cache_size > 0) {
+        std::lock_guard<std::mutex> lock(mr_cache_mutex);
+        const auto cache_key = std::make_pair(reinterpret_cast<uintptr_t>(buffer), size);
+        auto entry = mr_cache.find(cache_key);
+        if(entry == mr_cache.end()) {
+            fid_mr* raw_mr = register_raw_mr(g_ctxt.domain, buffer, size, mr_access);
+            if(mr_cache.size() >= mr_cache_size) {
+                /** Evict the least-recently-used registration with no live users */
+                auto victim = mr_cache.end();
+                for(auto it = mr_cache.begin(); it != mr_cache.end(); ++it) {
+                    if(it->second.registration.use_count() == 1
+                       && (victim == mr_cache.end()
+                           || it->second.last_used < victim->second.last_used)) {
+                        victim = it;
+                    }
+                }
+                if(victim != mr_cache.end()) {
+                    mr_cache.erase(victim);
+                }
+            }
+            cached_mr_entry new_entry{
+                    std::shared_ptr<fid_mr>(raw_mr, close_and_release_mr(size)),
+                    nullptr, 0};
+            if(second_rail_active) {
+                new_entry.second_registration = std::shared_ptr<fid_mr>(
+                        register_raw_mr(g_second_rail_ctxt.domain, buffer, size, mr_access),
+                        close_and_release_mr(size));
+            }
+            entry = mr_cache.emplace(cache_key, std::move(new_entry)).first;
+        }
+        entry->second.last_used = ++mr_cache_ticks;
+        /** Share the cached registration; the no-op deleter just drops the reference */
+        std::shared_ptr<fid_mr> cached_mr = entry->second.registration;
+        mr = std::unique_ptr<fid_mr, std::function<void(fid_mr*)>>(
+                cached_mr.get(), [cached_mr](fid_mr*) mutable { cached_mr.reset(); });
+        if(entry->second.second_registration) {
+            std::shared_ptr<fid_mr> cached_second_mr = entry->second.second_registration;
+            second_mr = std::unique_ptr<fid_mr, std::function<void(fid_mr*)>>(
+                    cached_second_mr.get(),
+                    [cached_second_mr](fid_mr*) mutable { cached_second_mr.reset(); });
+        }
+        return;
     }
 
+    /** Register the memory, use it to construct a smart pointer */
     mr = std::unique_ptr<fid_mr, std::function<void(fid_mr*)>>(
-            raw_mr, [](fid_mr* mr) { fi_close(&mr->fid); });
+            register_raw_mr(g_ctxt.domain, buffer, size, mr_access),
+            close_and_release_mr(size));
+    if(second_rail_active) {
+        second_mr = std::unique_ptr<fid_mr, std::function<void(fid_mr*)>>(
+                register_raw_mr(g_second_rail_ctxt.domain, buffer, size, mr_access),
+                close_and_release_mr(size));
+    }
 }
 
-uint64_t memory_region::get_key() const { return mr->key; }
+uint64_t memory_region::get_key(unsigned int rail) const {
+    if(rail == 0) return mr->key;
+    return second_mr ? second_mr->key : 0;
+}
 
 /** 
  * Completion queue constructor
@@ -216,18 +391,19 @@ endpoint::endpoint(size_t remote_index, bool is_lf_server,
     connect(remote_index, is_lf_server, post_recvs);
 }
 
-int endpoint::init(struct fi_info* fi) {
+int endpoint::init(struct fi_info* fi, unsigned int rail) {
     int ret;
+    lf_ctxt& ctxt = rail_ctxt(rail);
     /** Open an endpoint */
     fid_ep* raw_ep;
     ret = fail_if_nonzero_retry_on_eagain(
             "Failed to open endpoint", REPORT_ON_FAILURE,
-            fi_endpoint, g_ctxt.domain, fi, &raw_ep, nullptr);
+            fi_endpoint, ctxt.domain, fi, &raw_ep, nullptr);
     if(ret) return ret;
     dbg_default_trace("{}:{} created rdmc endpoint: {}", __FILE__, __func__, (void*)&raw_ep->fid);
     dbg_default_flush();
     /** Construct the smart pointer to manage the endpoint */
-    ep = std::unique_ptr<fid_ep, std::function<void(fid_ep*)>>(
+    ((rail == 0) ? ep : second_ep) = std::unique_ptr<fid_ep, std::function<void(fid_ep*)>>(
             raw_ep,
             [](fid_ep* ep) {
                 fi_close(&ep->fid);
@@ -237,10 +413,10 @@ int endpoint::init(struct fi_info* fi) {
     fid_eq* raw_eq;
     ret = fail_if_nonzero_retry_on_eagain(
             "Failed to open event queue", REPORT_ON_FAILURE,
-            fi_eq_open, g_ctxt.fabric, &g_ctxt.eq_attr, &raw_eq, nullptr);
+            fi_eq_open, ctxt.fabric, &ctxt.eq_attr, &raw_eq, nullptr);
     if(ret) return ret;
     /** Construct the smart pointer to manage the event queue */
-    eq = std::unique_ptr<fid_eq, std::function<void(fid_eq*)>>(
+    ((rail == 0) ? eq : second_eq) = std::unique_ptr<fid_eq, std::function<void(fid_eq*)>>(
             raw_eq, [](fid_eq* eq) { fi_close(&eq->fid); });
 
     /** Bind endpoint to event queue and completion queue */
@@ -251,7 +427,7 @@ int endpoint::init(struct fi_info* fi) {
     const uint64_t ep_flags = FI_RECV | FI_TRANSMIT | FI_SELECTIVE_COMPLETION;
     ret = fail_if_nonzero_retry_on_eagain(
             "Failed to bind endpoint and tx completion queue", REPORT_ON_FAILURE,
-            fi_ep_bind, raw_ep, &(g_ctxt.cq)->fid, ep_flags);
+            fi_ep_bind, raw_ep, &(ctxt.cq)->fid, ep_flags);
     if(ret) return ret;
     ret = fail_if_nonzero_retry_on_eagain(
             "Failed to enable endpoint", REPORT_ON_FAILURE,
@@ -267,79 +443,88 @@ bool sync(uint32_t r_id) {
 
 void endpoint::connect(size_t remote_index, bool is_lf_server,
                        std::function<void(endpoint*)> post_recvs) {
-    struct cm_con_data_t local_cm_data, remote_cm_data;
-    memset(&local_cm_data, 0, sizeof(local_cm_data));
-    memset(&remote_cm_data, 0, sizeof(remote_cm_data));
-
-    /** Populate local cm struct and exchange cm info */
-    local_cm_data.pep_addr_len = (uint32_t)htonl((uint32_t)g_ctxt.pep_addr_len);
-    memcpy((void*)&local_cm_data.pep_addr, &g_ctxt.pep_addr, g_ctxt.pep_addr_len);
-
-    if(!rdmc_connections->exchange(remote_index, local_cm_data, remote_cm_data)) {
-        crash_with_message("RDMC failed to exchange cm info\n");
-    }
+    /** Connect one rail at a time; both sides walk the rails in the same
+     * order, so each rail's CM handshake pairs up with the remote node's
+     * handshake for the same rail. */
+    for(unsigned int rail = 0; rail < lf_num_rails(); rail++) {
+        lf_ctxt& ctxt = rail_ctxt(rail);
+        auto& rail_ep = (rail == 0) ? ep : second_ep;
+
+        struct cm_con_data_t local_cm_data, remote_cm_data;
+        memset(&local_cm_data, 0, sizeof(local_cm_data));
+        memset(&remote_cm_data, 0, sizeof(remote_cm_data));
+
+        /** Populate local cm struct and exchange cm info */
+        local_cm_data.pep_addr_len = (uint32_t)htonl((uint32_t)ctxt.pep_addr_len);
+        memcpy((void*)&local_cm_data.pep_addr, &ctxt.pep_addr, ctxt.pep_addr_len);
+
+        if(!rdmc_connections->exchange(remote_index, local_cm_data, remote_cm_data)) {
+            crash_with_message("RDMC failed to exchange cm info\n");
+        }
 
-    remote_cm_data.pep_addr_len = (uint32_t)ntohl(remote_cm_data.pep_addr_len);
+        remote_cm_data.pep_addr_len = (uint32_t)ntohl(remote_cm_data.pep_addr_len);
 
-    /** Connect to remote node */
-    ssize_t nRead;
-    struct fi_eq_cm_entry entry;
-    uint32_t event;
+        /** Connect to remote node */
+        ssize_t nRead;
+        struct fi_eq_cm_entry entry;
+        uint32_t event;
 
-    if(is_lf_server) {
-        /** Synchronously read from the passive event queue, init the server ep */
-        nRead = fi_eq_sread(g_ctxt.peq, &event, &entry, sizeof(entry), -1, 0);
-        if(nRead != sizeof(entry)) {
-            crash_with_message("Failed to get connection from remote. nRead=%ld\n", nRead);
-        }
-        if(init(entry.info)) {
-            fi_reject(g_ctxt.pep, entry.info->handle, NULL, 0);
-            fi_freeinfo(entry.info);
-            crash_with_message("Failed to initialize server endpoint.\n");
-        }
-        if(fi_accept(ep.get(), NULL, 0)) {
-            fi_reject(g_ctxt.pep, entry.info->handle, NULL, 0);
+        if(is_lf_server) {
+            /** Synchronously read from the passive event queue, init the server ep */
+            nRead = fi_eq_sread(ctxt.peq, &event, &entry, sizeof(entry), -1, 0);
+            if(nRead != sizeof(entry)) {
+                crash_with_message("Failed to get connection from remote. nRead=%ld\n", nRead);
+            }
+            if(init(entry.info, rail)) {
+                fi_reject(ctxt.pep, entry.info->handle, NULL, 0);
+                fi_freeinfo(entry.info);
+                crash_with_message("Failed to initialize server endpoint.\n");
+            }
+            if(fi_accept(rail_ep.get(), NULL, 0)) {
+                fi_reject(ctxt.pep, entry.info->handle, NULL, 0);
+                fi_freeinfo(entry.info);
+                crash_with_message("Failed to accept connection.\n");
+            }
             fi_freeinfo(entry.info);
-            crash_with_message("Failed to accept connection.\n");
-        }
-        fi_freeinfo(entry.info);
-    } else {
-        struct fi_info* client_hints = fi_dupinfo(g_ctxt.hints);
-        struct fi_info* client_info = NULL;
-
-        /** TODO document this */
-        client_hints->dest_addr = crash_if_nullptr("Failed to malloc address space for server pep.",
-                                                   malloc, remote_cm_data.pep_addr_len);
-        memcpy((void*)client_hints->dest_addr,
-               (void*)remote_cm_data.pep_addr,
-               (size_t)remote_cm_data.pep_addr_len);
-        client_hints->dest_addrlen = remote_cm_data.pep_addr_len;
-        fail_if_nonzero_retry_on_eagain(
-                "fi_getinfo() failed.", CRASH_ON_FAILURE,
-                fi_getinfo, LF_VERSION, nullptr, nullptr, 0, client_hints, &client_info);
-
-        /** TODO document this */
-        if(init(client_info)) {
-            fi_freeinfo(client_hints);
-            fi_freeinfo(client_info);
-            crash_with_message("failed to initialize client endpoint.\n");
-        }
-        fail_if_nonzero_retry_on_eagain(
-                "fi_connect() failed", CRASH_ON_FAILURE,
-                fi_connect, ep.get(), remote_cm_data.pep_addr, nullptr, 0);
-
-        /** TODO document this */
-        nRead = fi_eq_sread(this->eq.get(), &event, &entry, sizeof(entry), -1, 0);
-        if(nRead != sizeof(entry)) {
-            crash_with_message("failed to connect remote. nRead=%ld.\n", nRead);
-        }
-        if(event != FI_CONNECTED || entry.fid != &(ep->fid)) {
+        } else {
+            struct fi_info* client_hints = fi_dupinfo(ctxt.hints);
+            struct fi_info* client_info = NULL;
+
+            /** TODO document this */
+            client_hints->dest_addr = crash_if_nullptr("Failed to malloc address space for server pep.",
+                                                       malloc, remote_cm_data.pep_addr_len);
+            memcpy((void*)client_hints->dest_addr,
+                   (void*)remote_cm_data.pep_addr,
+                   (size_t)remote_cm_data.pep_addr_len);
+            client_hints->dest_addrlen = remote_cm_data.pep_addr_len;
+            fail_if_nonzero_retry_on_eagain(
+                    "fi_getinfo() failed.", CRASH_ON_FAILURE,
+                    fi_getinfo, LF_VERSION, nullptr, nullptr, 0, client_hints, &client_info);
+
+            /** TODO document this */
+            if(init(client_info, rail)) {
+                fi_freeinfo(client_hints);
+                fi_freeinfo(client_info);
+                crash_with_message("failed to initialize client endpoint.\n");
+            }
+            fail_if_nonzero_retry_on_eagain(
+                    "fi_connect() failed", CRASH_ON_FAILURE,
+                    fi_connect, rail_ep.get(), remote_cm_data.pep_addr, nullptr, 0);
+
+            /** TODO document this */
+            auto& rail_eq = (rail == 0) ? eq : second_eq;
+            nRead = fi_eq_sread(rail_eq.get(), &event, &entry, sizeof(entry), -1, 0);
+            if(nRead != sizeof(entry)) {
+                crash_with_message("failed to connect remote. nRead=%ld.\n", nRead);
+            }
+            if(event != FI_CONNECTED || entry.fid != &(rail_ep->fid)) {
+                fi_freeinfo(client_hints);
+                fi_freeinfo(client_info);
+                crash_with_message("RDMC Unexpected CM event: %d.\n", event);
+            }
             fi_freeinfo(client_hints);
             fi_freeinfo(client_info);
-            crash_with_message("RDMC Unexpected CM event: %d.\n", event);
         }
-        fi_freeinfo(client_hints);
-        fi_freeinfo(client_info);
     }
 
     post_recvs(this);
@@ -351,7 +536,9 @@ void endpoint::connect(size_t remote_index, bool is_lf_server,
 
 bool endpoint::post_send(const memory_region& mr, size_t offset, size_t size,
                          uint64_t wr_id, uint32_t immediate,
-                         const message_type& type) {
+                         const message_type& type, unsigned int rail) {
+    if(rail > 0 && (!second_ep || !mr.second_mr)) throw invalid_args();
+
     struct iovec msg_iov;
     struct fi_msg msg;
 
@@ -359,7 +546,7 @@ bool endpoint::post_send(const memory_region& mr, size_t offset, size_t size,
     msg_iov.iov_len = size;
 
     msg.msg_iov = &msg_iov;
-    msg.desc = (void**)&mr.mr->key;
+    msg.desc = (rail == 0) ? (void**)&mr.mr->key : (void**)&mr.second_mr->key;
     msg.iov_count = 1;
     msg.addr = 0;
     msg.context = (void*)(wr_id | ((uint64_t)*type.tag << type.shift_bits) | ((uint64_t)RDMA_OP_SEND) << OP_BITS_SHIFT);
@@ -367,12 +554,16 @@ bool endpoint::post_send(const memory_region& mr, size_t offset, size_t size,
 
     fail_if_nonzero_retry_on_eagain(
             "fi_sendmsg() failed", REPORT_ON_FAILURE,
-            fi_sendmsg, ep.get(), &msg, FI_COMPLETION | FI_REMOTE_CQ_DATA);
+            fi_sendmsg, (rail == 0) ? ep.get() : second_ep.get(), &msg,
+            FI_COMPLETION | FI_REMOTE_CQ_DATA);
     return true;
 }
 
 bool endpoint::post_recv(const memory_region& mr, size_t offset, size_t size,
-                         uint64_t wr_id, const message_type& type) {
+                         uint64_t wr_id, const message_type& type,
+                         unsigned int rail) {
+    if(rail > 0 && (!second_ep || !mr.second_mr)) throw invalid_args();
+
     struct iovec msg_iov;
     struct fi_msg msg;
 
@@ -380,14 +571,14 @@ bool endpoint::post_recv(const memory_region& mr, size_t offset, size_t size,
     msg_iov.iov_len = size;
 
     msg.msg_iov = &msg_iov;
-    msg.desc = (void**)&mr.mr->key;
+    msg.desc = (rail == 0) ? (void**)&mr.mr->key : (void**)&mr.second_mr->key;
     msg.iov_count = 1;
     msg.addr = 0;
     msg.context = (void*)(wr_id | ((uint64_t)*type.tag << type.shift_bits) | ((uint64_t)RDMA_OP_RECV) << OP_BITS_SHIFT);
 
     fail_if_nonzero_retry_on_eagain(
             "fi_recvmsg() failed", REPORT_ON_FAILURE,
-            fi_recvmsg, ep.get(), &msg, FI_COMPLETION);
+            fi_recvmsg, (rail == 0) ? ep.get() : second_ep.get(), &msg, FI_COMPLETION);
     return true;
 }
 
@@ -420,8 +611,9 @@ bool endpoint::post_empty_recv(uint64_t wr_id, const message_type& type) {
 bool endpoint::post_write(const memory_region& mr, size_t offset, size_t size,
                           uint64_t wr_id, remote_memory_region remote_mr,
                           size_t remote_offset, const message_type& type,
-                          bool signaled, bool send_inline) {
+                          bool signaled, bool send_inline, unsigned int rail) {
     if(wr_id >> type.shift_bits || !type.tag) throw invalid_args();
+    if(rail > 0 && (!second_ep || !mr.second_mr || remote_mr.second_rkey == 0)) throw invalid_args();
     if(mr.size < offset + size || remote_mr.size < remote_offset + size) {
         std::cout << "mr.size = " << mr.size << " offset = " << offset
                   << " length = " << size << " remote_mr.size = " << remote_mr.size
@@ -438,10 +630,10 @@ bool endpoint::post_write(const memory_region& mr, size_t offset, size_t size,
 
     rma_iov.addr = ((LF_USE_VADDR) ? remote_mr.buffer : 0) + remote_offset;
     rma_iov.len = size;
-    rma_iov.key = remote_mr.rkey;
+    rma_iov.key = (rail == 0) ? remote_mr.rkey : remote_mr.second_rkey;
 
     msg.msg_iov = &msg_iov;
-    msg.desc = (void**)&mr.mr->key;
+    msg.desc = (rail == 0) ? (void**)&mr.mr->key : (void**)&mr.second_mr->key;
     msg.iov_count = 1;
     msg.addr = 0;
     msg.rma_iov = &rma_iov;
@@ -450,7 +642,7 @@ bool endpoint::post_write(const memory_region& mr, size_t offset, size_t size,
 
     fail_if_nonzero_retry_on_eagain(
             "fi_writemsg() failed", REPORT_ON_FAILURE,
-            fi_writemsg, ep.get(), &msg, FI_COMPLETION);
+            fi_writemsg, (rail == 0) ? ep.get() : second_ep.get(), &msg, FI_COMPLETION);
 
     return true;
 }
@@ -528,138 +720,149 @@ bool lf_remove_connection(uint32_t node_id) {
 }
 
 static std::atomic<bool> interrupt_mode;
-static std::atomic<bool> polling_loop_shutdown_flag;
-static void polling_loop() {
-    pthread_setname_np(pthread_self(), "rdmc_poll");
-
-    const int max_cq_entries = 1024;
-    std::unique_ptr<fi_cq_data_entry[]> cq_entries(new fi_cq_data_entry[max_cq_entries]);
-
-    while(true) {
-        int num_completions = 0;
-        while(num_completions == 0 || num_completions == -FI_EAGAIN) {
-            if(polling_loop_shutdown_flag) return;
-            uint64_t poll_end = get_time() + (interrupt_mode ? 0L : 50000000L);
-            do {
-                if(polling_loop_shutdown_flag) return;
-                num_completions = fi_cq_read(g_ctxt.cq, cq_entries.get(), max_cq_entries);
-            } while((num_completions == 0 || num_completions == -FI_EAGAIN) && get_time() < poll_end);
-
-            if(num_completions == 0 || num_completions == -FI_EAGAIN) {
-                /** Need ibv_req_notify_cq equivalent here? */
-
-                num_completions = fi_cq_read(g_ctxt.cq, cq_entries.get(), max_cq_entries);
-
-                if(num_completions == 0 || num_completions == -FI_EAGAIN) {
-                    pollfd file_descriptor;
-                    fi_control(&g_ctxt.cq->fid, FI_GETWAIT, &file_descriptor);
-                    int rc = 0;
-                    while(rc == 0 && !polling_loop_shutdown_flag) {
-                        if(polling_loop_shutdown_flag) return;
-                        file_descriptor.events = POLLIN | POLLERR | POLLHUP;
-                        file_descriptor.revents = 0;
-                        rc = poll(&file_descriptor, 1, 50);
-                    }
+/** Drains one rail's completion queue; registered with the shared
+ * completion engine as one source per rail, so a single polling thread
+ * serves both rails (and the SST). The completion handlers are shared, so
+ * a handler sees a group's completions from both rails (serialized by
+ * completion_handlers_mutex). Returns the number of completions consumed. */
+static int drain_rail_cq(lf_ctxt* ctxt) {
+    constexpr int max_cq_entries = 1024;
+    static fi_cq_data_entry cq_entries[max_cq_entries];  // engine thread only
+
+    int num_completions = fi_cq_read(ctxt->cq, cq_entries, max_cq_entries);
+    if(num_completions == 0 || num_completions == -FI_EAGAIN) {
+        return 0;
+    }
+    if(num_completions < 0) {
+        std::cout << "Failed to read from completion queue, fi_cq_read returned "
+                  << num_completions << std::endl;
+        return 0;
+    }
 
-                    if(rc > 0) {
-                        num_completions = fi_cq_read(g_ctxt.cq, cq_entries.get(), max_cq_entries);
-                    }
-                }
-            }
-        }
+    std::lock_guard<std::mutex> l(completion_handlers_mutex);
+    for(int i = 0; i < num_completions; i++) {
+        fi_cq_data_entry& cq_entry = cq_entries[i];
 
-        if(num_completions < 0) {
-            std::cout << "Failed to read from completion queue, fi_cq_read returned "
-                      << num_completions << std::endl;
-        }
+        message_type::tag_type type = (uint64_t)cq_entry.op_context >> message_type::shift_bits;
+        if(type == std::numeric_limits<message_type::tag_type>::max())
+            continue;
 
-        std::lock_guard<std::mutex> l(completion_handlers_mutex);
-        for(int i = 0; i < num_completions; i++) {
-            fi_cq_data_entry& cq_entry = cq_entries[i];
-
-            message_type::tag_type type = (uint64_t)cq_entry.op_context >> message_type::shift_bits;
-            if(type == std::numeric_limits<message_type::tag_type>::max())
-                continue;
-
-            uint64_t masked_wr_id = (uint64_t)cq_entry.op_context & 0x0000ffffffffffffull;
-            uint32_t opcode = (uint32_t)EXTRACT_RDMA_OP_CODE(cq_entry.op_context);
-            uint32_t immediate = cq_entry.data;
-            if(type >= completion_handlers.size()) {
-                // Unrecognized message type
-            } else if(opcode == RDMA_OP_SEND) {
-                completion_handlers[type].send(masked_wr_id, immediate,
-                                               cq_entry.len);
-            } else if(opcode == RDMA_OP_RECV) {
-                completion_handlers[type].recv(masked_wr_id, immediate,
-                                               cq_entry.len);
-            } else if(opcode == RDMA_OP_WRITE) {
-                completion_handlers[type].write(masked_wr_id, immediate,
-                                                cq_entry.len);
-            } else {
-                puts("Sent unrecognized completion type?!");
-            }
+        uint64_t masked_wr_id = (uint64_t)cq_entry.op_context & 0x0000ffffffffffffull;
+        uint32_t opcode = (uint32_t)EXTRACT_RDMA_OP_CODE(cq_entry.op_context);
+        uint32_t immediate = cq_entry.data;
+        if(type >= completion_handlers.size()) {
+            // Unrecognized message type
+        } else if(opcode == RDMA_OP_SEND) {
+            completion_handlers[type].send(masked_wr_id, immediate,
+                                           cq_entry.len);
+        } else if(opcode == RDMA_OP_RECV) {
+            completion_handlers[type].recv(masked_wr_id, immediate,
+                                           cq_entry.len);
+        } else if(opcode == RDMA_OP_WRITE) {
+            completion_handlers[type].write(masked_wr_id, immediate,
+                                            cq_entry.len);
+        } else {
+            puts("Sent unrecognized completion type?!");
         }
     }
+    return num_completions;
+}
+
+/** Looks up one rail's CQ wait file descriptor, or -1 if the provider
+ * cannot supply one (the engine then sleeps instead of fd-waiting). */
+static int rail_cq_wait_fd(lf_ctxt& ctxt) {
+    int wait_fd = -1;
+    if(fi_control(&ctxt.cq->fid, FI_GETWAIT, &wait_fd) != 0) {
+        wait_fd = -1;
+    }
+    return wait_fd;
 }
 
 /**
- * Initialize the global context 
+ * Bring up one rail's fabric, domain, completion queue and passive endpoint.
+ * The context's hints must already be populated by default_context().
  */
-bool lf_initialize(const std::map<node_id_t, std::pair<ip_addr_t, uint16_t>>& ip_addrs_and_ports,
-                   uint32_t node_rank) {
-    /** Initialize the connection listener on the rdmc tcp port */
-    // connection_listener =
-    // make_unique<tcp::connection_listener>(derecho::rdmc_tcp_port);
-
-    /** Initialize the tcp connections, also connects all the nodes together */
-    rdmc_connections = new tcp::tcp_connections(node_rank, ip_addrs_and_ports);
-
-    /** Set the context to defaults to start with */
-    default_context();
-    // load_configuration();
-
-    dbg_default_debug(fi_tostr(g_ctxt.hints, FI_TYPE_INFO));
+static void init_fabric_stack(lf_ctxt& ctxt) {
+    dbg_default_debug(fi_tostr(ctxt.hints, FI_TYPE_INFO));
     /** Initialize the fabric, domain and completion queue */
     fail_if_nonzero_retry_on_eagain(
             "fi_getinfo() failed", CRASH_ON_FAILURE,
-            fi_getinfo, LF_VERSION, nullptr, nullptr, 0, g_ctxt.hints, &(g_ctxt.fi));
+            fi_getinfo, LF_VERSION, nullptr, nullptr, 0, ctxt.hints, &(ctxt.fi));
     fail_if_nonzero_retry_on_eagain(
             "fi_fabric() failed", CRASH_ON_FAILURE,
-            fi_fabric, g_ctxt.fi->fabric_attr, &(g_ctxt.fabric), nullptr);
+            fi_fabric, ctxt.fi->fabric_attr, &(ctxt.fabric), nullptr);
     fail_if_nonzero_retry_on_eagain(
             "fi_domain() failed", CRASH_ON_FAILURE,
-            fi_domain, g_ctxt.fabric, g_ctxt.fi, &(g_ctxt.domain), nullptr);
+            fi_domain, ctxt.fabric, ctxt.fi, &(ctxt.domain), nullptr);
     fail_if_nonzero_retry_on_eagain(
             "failed to initialize tx completion queue", CRASH_ON_FAILURE,
-            fi_cq_open, g_ctxt.domain, &(g_ctxt.cq_attr), &(g_ctxt.cq), nullptr);
+            fi_cq_open, ctxt.domain, &(ctxt.cq_attr), &(ctxt.cq), nullptr);
 
-    if(!g_ctxt.cq) {
+    if(!ctxt.cq) {
         crash_with_message("Pointer to completion queue is null\n");
     }
 
     /** Initialize the event queue, initialize and configure pep  */
     fail_if_nonzero_retry_on_eagain(
             "failed to open the event queue for passive endpoint", CRASH_ON_FAILURE,
-            fi_eq_open, g_ctxt.fabric, &g_ctxt.eq_attr, &g_ctxt.peq, nullptr);
+            fi_eq_open, ctxt.fabric, &ctxt.eq_attr, &ctxt.peq, nullptr);
     fail_if_nonzero_retry_on_eagain(
             "failed to open a local passive endpoint", CRASH_ON_FAILURE,
-            fi_passive_ep, g_ctxt.fabric, g_ctxt.fi, &g_ctxt.pep, nullptr);
+            fi_passive_ep, ctxt.fabric, ctxt.fi, &ctxt.pep, nullptr);
     fail_if_nonzero_retry_on_eagain(
             "failed to bind event queue to passive endpoint", CRASH_ON_FAILURE,
-            fi_pep_bind, g_ctxt.pep, &g_ctxt.peq->fid, 0);
+            fi_pep_bind, ctxt.pep, &ctxt.peq->fid, 0);
     fail_if_nonzero_retry_on_eagain(
             "failed to prepare passive endpoint for incoming connections", CRASH_ON_FAILURE,
-            fi_listen, g_ctxt.pep);
+            fi_listen, ctxt.pep);
     fail_if_nonzero_retry_on_eagain(
             "failed to get the local PEP address", CRASH_ON_FAILURE,
-            fi_getname, &g_ctxt.pep->fid, g_ctxt.pep_addr, &g_ctxt.pep_addr_len);
-    if(g_ctxt.pep_addr_len > max_lf_addr_size) {
+            fi_getname, &ctxt.pep->fid, ctxt.pep_addr, &ctxt.pep_addr_len);
+    if(ctxt.pep_addr_len > max_lf_addr_size) {
         crash_with_message("local name is too big to fit in local buffer\n");
     }
+}
+
+unsigned int lf_num_rails() {
+    return second_rail_active ? 2 : 1;
+}
+
+/**
+ * Initialize the global context
+ */
+bool lf_initialize(const std::map<node_id_t, std::pair<ip_addr_t, uint16_t>>& ip_addrs_and_ports,
+                   uint32_t node_rank) {
+    /** Initialize the connection listener on the rdmc tcp port */
+    // connection_listener =
+    // make_unique<tcp::connection_listener>(derecho::rdmc_tcp_port);
+
+    /** Initialize the tcp connections, also connects all the nodes together */
+    rdmc_connections = new tcp::tcp_connections(node_rank, ip_addrs_and_ports);
+
+    /** Set the context to defaults to start with */
+    default_context(g_ctxt, derecho::getConfString(CONF_RDMA_DOMAIN));
+    // load_configuration();
+
+    init_fabric_stack(g_ctxt);
+
+    /** Bring up the second rail if one is configured */
+    const std::string second_domain = derecho::getConfString(CONF_RDMA_SECOND_DOMAIN);
+    if(!second_domain.empty()) {
+        default_context(g_second_rail_ctxt, second_domain);
+        init_fabric_stack(g_second_rail_ctxt);
+        second_rail_active = true;
+        dbg_default_info("RDMC multi-rail enabled: striping block transfers across {} and {}",
+                         derecho::getConfString(CONF_RDMA_DOMAIN), second_domain);
+    }
 
-    /** Start a polling thread and run in the background */
-    std::thread polling_thread(polling_loop);
-    polling_thread.detach();
+    /** Register each rail's completion queue with the shared polling engine */
+    derecho::CompletionEngine::get().register_source(
+            "rdmc", [] { return drain_rail_cq(&g_ctxt); }, rail_cq_wait_fd(g_ctxt));
+    if(second_rail_active) {
+        derecho::CompletionEngine::get().register_source(
+                "rdmc2", [] { return drain_rail_cq(&g_second_rail_ctxt); },
+                rail_cq_wait_fd(g_second_rail_ctxt));
+    }
 
     return true;
 }
@@ -681,17 +884,38 @@ std::map<uint32_t, remote_memory_region> lf_exchange_memory_regions(
         uint64_t buffer;
         size_t size;
         uint64_t rkey;
+        uint64_t second_rkey;
 
-        if(!rdmc_connections->exchange(m, (uint64_t)mr.buffer, buffer) || !rdmc_connections->exchange(m, mr.size, size) || !rdmc_connections->exchange(m, mr.get_key(), rkey)) {
+        if(!rdmc_connections->exchange(m, (uint64_t)mr.buffer, buffer) || !rdmc_connections->exchange(m, mr.size, size) || !rdmc_connections->exchange(m, mr.get_key(), rkey) || !rdmc_connections->exchange(m, mr.get_key(1), second_rkey)) {
             fprintf(stderr, "WARNING: lost connection to node %u\n", m);
             throw rdma::connection_broken();
         }
-        remote_mrs.emplace(m, remote_memory_region(buffer, size, rkey));
+        remote_mrs.emplace(m, remote_memory_region(buffer, size, rkey, second_rkey));
     }
     return remote_mrs;
 }
 
+std::map<uint32_t, exchanged_ep_addr> lf_exchange_endpoint_addrs(
+        const std::vector<uint32_t>& members, uint32_t node_rank,
+        const exchanged_ep_addr& local_addr) {
+    std::map<uint32_t, exchanged_ep_addr> remote_addrs;
+    for(uint32_t m : members) {
+        if(m == node_rank) {
+            continue;
+        }
+        exchanged_ep_addr remote_addr;
+        if(!rdmc_connections->exchange(m, local_addr, remote_addr)) {
+            fprintf(stderr, "WARNING: lost connection to node %u\n", m);
+            throw rdma::connection_broken();
+        }
+        remote_addrs.emplace(m, remote_addr);
+    }
+    return remote_addrs;
+}
+
 bool set_interrupt_mode(bool enabled) {
+    // Retained for API compatibility: the shared completion engine's backoff
+    // ladder now decides between spinning and fd waiting on its own.
     interrupt_mode = enabled;
     return true;
 }
@@ -7,6 +7,7 @@
     #include <derecho/rdmc/detail/verbs_helper.hpp>
 #else
     #include <derecho/rdmc/detail/lf_helper.hpp>
+    #include <derecho/rdmc/detail/ud_multicast.hpp>
 #endif
 
 #include <atomic>
@@ -18,6 +19,7 @@
 #include <mutex>
 #include <set>
 #include <string>
+#include <tuple>
 #include <utility>
 #include <vector>
 
@@ -34,6 +36,43 @@ atomic<bool> shutdown_flag;
 map<uint16_t, shared_ptr<group>> groups;
 mutex groups_lock;
 
+/**
+ * Process-wide cache of block-transfer schedules. A schedule is immutable
+ * and fully determined by (algorithm, group size, member rank), and view
+ * changes create many subgroup-shard groups with identical shapes, so
+ * repeated shapes share one schedule object instead of constructing a new
+ * one per group. Entries live for the lifetime of the process; the
+ * distinct-shape count is small (a few per subgroup type).
+ */
+static map<tuple<send_algorithm, uint32_t, uint32_t>, shared_ptr<const schedule>> schedule_cache;
+static mutex schedule_cache_lock;
+
+static shared_ptr<const schedule> get_schedule(send_algorithm algorithm,
+                                               uint32_t num_members,
+                                               uint32_t member_index) {
+    const auto cache_key = make_tuple(algorithm, num_members, member_index);
+    unique_lock<mutex> lock(schedule_cache_lock);
+    auto it = schedule_cache.find(cache_key);
+    if(it != schedule_cache.end()) {
+        return it->second;
+    }
+
+    shared_ptr<const schedule> send_schedule;
+    if(algorithm == BINOMIAL_SEND) {
+        send_schedule = make_shared<binomial_schedule>(num_members, member_index);
+    } else if(algorithm == SEQUENTIAL_SEND) {
+        send_schedule = make_shared<sequential_schedule>(num_members, member_index);
+    } else if(algorithm == CHAIN_SEND) {
+        send_schedule = make_shared<chain_schedule>(num_members, member_index);
+    } else if(algorithm == TREE_SEND) {
+        send_schedule = make_shared<tree_schedule>(num_members, member_index);
+    } else {
+        return nullptr;
+    }
+    schedule_cache.emplace(cache_key, send_schedule);
+    return send_schedule;
+}
+
   bool initialize(const map<uint32_t, std::pair<ip_addr_t, uint16_t>>& ip_addrs_and_ports, uint32_t _node_rank) {
     if(shutdown_flag) return false;
 
@@ -61,20 +100,27 @@ bool create_group(uint16_t group_number, std::vector<uint32_t> members,
                   size_t block_size, send_algorithm algorithm,
                   incoming_message_callback_t incoming_upcall,
                   completion_callback_t callback,
-                  failure_callback_t failure_callback) {
+                  failure_callback_t failure_callback,
+                  progress_callback_t progress_callback) {
     if(shutdown_flag) return false;
 
-    schedule* send_schedule;
     uint32_t member_index = index_of(members, node_rank);
-    if(algorithm == BINOMIAL_SEND) {
-        send_schedule = new binomial_schedule(members.size(), member_index);
-    } else if(algorithm == SEQUENTIAL_SEND) {
-        send_schedule = new sequential_schedule(members.size(), member_index);
-    } else if(algorithm == CHAIN_SEND) {
-        send_schedule = new chain_schedule(members.size(), member_index);
-    } else if(algorithm == TREE_SEND) {
-        send_schedule = new tree_schedule(members.size(), member_index);
-    } else {
+    if(algorithm == UD_MULTICAST_SEND) {
+#ifndef USE_VERBS_API
+        if(ud_multicast_group::supported()) {
+            unique_lock<mutex> lock(groups_lock);
+            auto g = make_shared<ud_multicast_group>(group_number, block_size, members,
+                                                     member_index, incoming_upcall, callback);
+            auto p = groups.emplace(group_number, std::move(g));
+            return p.second;
+        }
+#endif
+        dbg_default_warn("UD multicast unavailable for group {}; falling back to binomial_send",
+                         group_number);
+        algorithm = BINOMIAL_SEND;
+    }
+    shared_ptr<const schedule> send_schedule = get_schedule(algorithm, members.size(), member_index);
+    if(!send_schedule) {
         puts("Unsupported group type?!");
         fflush(stdout);
         return false;
@@ -83,11 +129,38 @@ bool create_group(uint16_t group_number, std::vector<uint32_t> members,
     unique_lock<mutex> lock(groups_lock);
     auto g = make_shared<polling_group>(group_number, block_size, members,
                                         member_index, incoming_upcall, callback,
-                                        unique_ptr<schedule>(send_schedule));
+                                        std::move(send_schedule),
+                                        std::move(progress_callback));
     auto p = groups.emplace(group_number, std::move(g));
     return p.second;
 }
 
+bool migrate_group(uint16_t old_group_number, uint16_t new_group_number,
+                   const std::vector<uint32_t>& members, size_t block_size,
+                   incoming_message_callback_t incoming_upcall,
+                   completion_callback_t callback) {
+    if(shutdown_flag) return false;
+
+    unique_lock<mutex> lock(groups_lock);
+    auto it = groups.find(old_group_number);
+    if(it == groups.end()) {
+        return false;
+    }
+    if(new_group_number != old_group_number && groups.count(new_group_number) > 0) {
+        return false;
+    }
+    if(!it->second->migrate(new_group_number, members, block_size,
+                            std::move(incoming_upcall), std::move(callback))) {
+        return false;
+    }
+    if(new_group_number != old_group_number) {
+        groups.emplace(new_group_number, std::move(it->second));
+        groups.erase(it);
+    }
+    LOG_EVENT(new_group_number, -1, -1, "migrate_group");
+    return true;
+}
+
 void destroy_group(uint16_t group_number) {
     if(shutdown_flag) return;
 
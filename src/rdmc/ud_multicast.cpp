@@ -0,0 +1,442 @@
+#ifndef USE_VERBS_API
+
+#include <derecho/rdmc/detail/ud_multicast.hpp>
+#include <derecho/conf/conf.hpp>
+#include <derecho/utils/logger.hpp>
+
+#include <algorithm>
+#include <arpa/inet.h>
+#include <cstring>
+#include <netinet/in.h>
+
+#include <rdma/fi_cm.h>
+#include <rdma/fi_domain.h>
+#include <rdma/fi_endpoint.h>
+
+using namespace rdma;
+using namespace rdma::impl;
+
+// Receive ring depth; each slot holds one maximum-sized datagram. Datagrams
+// that arrive while every slot is in use are dropped and recovered by the
+// NACK path, like any other loss.
+static constexpr size_t ud_recv_ring_size = 256;
+// Send staging ring depth. A slot is reused only after ud_send_ring_size
+// further sends, by which point (with tx_depth at its default of 256) its
+// datagram has long left the NIC.
+static constexpr size_t ud_send_ring_size = 256;
+// How many past messages the root keeps for NACK-driven retransmission. The
+// upper layer's send window keeps receivers within this distance of the root.
+static constexpr size_t ud_retransmit_window_size = 4;
+// How long an incomplete message may go without progress before the receiver
+// NACKs its missing fragments, and how often the root announces its latest
+// sequence number.
+static constexpr auto ud_nack_timeout = std::chrono::milliseconds(1);
+// frag_index value in a NACK requesting retransmission of every fragment
+// (sent when the receiver has not seen any fragment, so it does not yet know
+// the fragment count).
+static constexpr uint32_t ud_nack_all_frags = 0xffffffffu;
+
+bool ud_multicast_group::supported() {
+    static int cached_result = -1;
+    if(cached_result >= 0) {
+        return cached_result != 0;
+    }
+    if(derecho::getConfString(CONF_RDMA_UD_MCAST_ADDR).empty()) {
+        dbg_default_warn("UD multicast requested but RDMA/ud_mcast_addr is not set");
+        cached_result = 0;
+        return false;
+    }
+    struct fi_info* hints = fi_allocinfo();
+    if(!hints) {
+        cached_result = 0;
+        return false;
+    }
+    hints->caps = FI_MSG | FI_MULTICAST;
+    hints->ep_attr->type = FI_EP_DGRAM;
+    hints->fabric_attr->prov_name = strdup(derecho::getConfString(CONF_RDMA_PROVIDER).c_str());
+    hints->domain_attr->name = strdup(derecho::getConfString(CONF_RDMA_DOMAIN).c_str());
+    struct fi_info* info = nullptr;
+    int ret = fi_getinfo(LF_VERSION, nullptr, nullptr, 0, hints, &info);
+    if(info) {
+        fi_freeinfo(info);
+    }
+    fi_freeinfo(hints);
+    cached_result = (ret == 0) ? 1 : 0;
+    if(!cached_result) {
+        dbg_default_warn("UD multicast requested but provider {} does not support "
+                         "FI_EP_DGRAM with FI_MULTICAST (fi_getinfo returned {})",
+                         derecho::getConfString(CONF_RDMA_PROVIDER), ret);
+    }
+    return cached_result != 0;
+}
+
+ud_multicast_group::ud_multicast_group(uint16_t group_number, size_t block_size,
+                                       std::vector<uint32_t> members, uint32_t member_index,
+                                       rdmc::incoming_message_callback_t upcall,
+                                       rdmc::completion_callback_t callback)
+        : group(group_number, block_size, members, member_index, upcall, callback, nullptr) {
+    /* Datagram fabric objects, separate from the connected-endpoint context */
+    struct fi_info* hints = crash_if_nullptr("Failed to allocate fi hints", fi_allocinfo);
+    hints->caps = FI_MSG | FI_MULTICAST;
+    hints->ep_attr->type = FI_EP_DGRAM;
+    hints->mode = ~0;
+    hints->fabric_attr->prov_name = crash_if_nullptr("strdup provider name",
+                                                     strdup, derecho::getConfString(CONF_RDMA_PROVIDER).c_str());
+    hints->domain_attr->name = crash_if_nullptr("strdup domain name",
+                                                strdup, derecho::getConfString(CONF_RDMA_DOMAIN).c_str());
+    fail_if_nonzero_retry_on_eagain("fi_getinfo() for UD multicast", CRASH_ON_FAILURE,
+                                    fi_getinfo, LF_VERSION, nullptr, nullptr, 0, hints, &dgram_fi);
+    fi_freeinfo(hints);
+    fail_if_nonzero_retry_on_eagain("fi_fabric() for UD multicast", CRASH_ON_FAILURE,
+                                    fi_fabric, dgram_fi->fabric_attr, &fabric, nullptr);
+    fail_if_nonzero_retry_on_eagain("fi_domain() for UD multicast", CRASH_ON_FAILURE,
+                                    fi_domain, fabric, dgram_fi, &domain, nullptr);
+
+    struct fi_av_attr av_attr;
+    memset(&av_attr, 0, sizeof(av_attr));
+    av_attr.type = FI_AV_MAP;
+    fail_if_nonzero_retry_on_eagain("fi_av_open() for UD multicast", CRASH_ON_FAILURE,
+                                    fi_av_open, domain, &av_attr, &av, nullptr);
+    struct fi_cq_attr cq_attr;
+    memset(&cq_attr, 0, sizeof(cq_attr));
+    cq_attr.format = FI_CQ_FORMAT_DATA;
+    cq_attr.size = ud_recv_ring_size + ud_send_ring_size;
+    fail_if_nonzero_retry_on_eagain("fi_cq_open() for UD multicast", CRASH_ON_FAILURE,
+                                    fi_cq_open, domain, &cq_attr, &cq, nullptr);
+    struct fi_eq_attr eq_attr;
+    memset(&eq_attr, 0, sizeof(eq_attr));
+    eq_attr.wait_obj = FI_WAIT_UNSPEC;
+    fail_if_nonzero_retry_on_eagain("fi_eq_open() for UD multicast", CRASH_ON_FAILURE,
+                                    fi_eq_open, fabric, &eq_attr, &eq, nullptr);
+
+    fail_if_nonzero_retry_on_eagain("fi_endpoint() for UD multicast", CRASH_ON_FAILURE,
+                                    fi_endpoint, domain, dgram_fi, &dgram_ep, nullptr);
+    fail_if_nonzero_retry_on_eagain("Bind UD endpoint to address vector", CRASH_ON_FAILURE,
+                                    fi_ep_bind, dgram_ep, &av->fid, 0);
+    fail_if_nonzero_retry_on_eagain("Bind UD endpoint to completion queue", CRASH_ON_FAILURE,
+                                    fi_ep_bind, dgram_ep, &cq->fid, FI_TRANSMIT | FI_RECV);
+    fail_if_nonzero_retry_on_eagain("Bind UD endpoint to event queue", CRASH_ON_FAILURE,
+                                    fi_ep_bind, dgram_ep, &eq->fid, 0);
+    fail_if_nonzero_retry_on_eagain("Enable UD endpoint", CRASH_ON_FAILURE,
+                                    fi_enable, dgram_ep);
+
+    /* Fragment sizing and registered staging/receive rings */
+    const size_t max_datagram = dgram_fi->ep_attr->max_msg_size;
+    if(max_datagram <= sizeof(frag_header)) {
+        dbg_default_error("UD multicast: datagram MTU ({}) too small for fragment header",
+                          max_datagram);
+        throw rdma::configuration_failure();
+    }
+    frag_payload_size = max_datagram - sizeof(frag_header);
+    const size_t slot_size = sizeof(frag_header) + frag_payload_size;
+    num_recv_buffers = ud_recv_ring_size;
+    send_buffer = std::make_unique<char[]>(slot_size * ud_send_ring_size);
+    recv_buffer = std::make_unique<char[]>(slot_size * num_recv_buffers);
+    fail_if_nonzero_retry_on_eagain("Register UD send staging ring", CRASH_ON_FAILURE,
+                                    fi_mr_reg, domain, send_buffer.get(), slot_size * ud_send_ring_size,
+                                    FI_SEND, 0, 0, 0, &send_mr, nullptr);
+    fail_if_nonzero_retry_on_eagain("Register UD receive ring", CRASH_ON_FAILURE,
+                                    fi_mr_reg, domain, recv_buffer.get(), slot_size * num_recv_buffers,
+                                    FI_RECV, 0, 0, 0, &recv_mr, nullptr);
+
+    /* Learn every member's datagram address over the existing TCP channel */
+    exchanged_ep_addr local_addr;
+    memset(&local_addr, 0, sizeof(local_addr));
+    size_t addr_len = sizeof(local_addr.addr);
+    fail_if_nonzero_retry_on_eagain("fi_getname() on UD endpoint", CRASH_ON_FAILURE,
+                                    fi_getname, &dgram_ep->fid, local_addr.addr, &addr_len);
+    local_addr.addr_len = addr_len;
+    auto remote_addrs = lf_exchange_endpoint_addrs(members, members[member_index], local_addr);
+    member_addrs.resize(num_members, FI_ADDR_UNSPEC);
+    for(uint32_t rank = 0; rank < num_members; ++rank) {
+        const exchanged_ep_addr& peer = (rank == member_index)
+                                                ? local_addr
+                                                : remote_addrs.at(members[rank]);
+        if(fi_av_insert(av, peer.addr, 1, &member_addrs[rank], 0, nullptr) != 1) {
+            dbg_default_error("UD multicast: fi_av_insert failed for member rank {}", rank);
+            throw rdma::configuration_failure();
+        }
+    }
+
+    /* Join the switch multicast group: address from config, port per group */
+    struct sockaddr_in mcast_sockaddr;
+    memset(&mcast_sockaddr, 0, sizeof(mcast_sockaddr));
+    mcast_sockaddr.sin_family = AF_INET;
+    mcast_sockaddr.sin_port = htons(derecho::getConfUInt16(CONF_RDMA_UD_MCAST_PORT) + group_number);
+    if(inet_pton(AF_INET, derecho::getConfString(CONF_RDMA_UD_MCAST_ADDR).c_str(),
+                 &mcast_sockaddr.sin_addr)
+       != 1) {
+        dbg_default_error("UD multicast: invalid RDMA/ud_mcast_addr \"{}\"",
+                          derecho::getConfString(CONF_RDMA_UD_MCAST_ADDR));
+        throw rdma::configuration_failure();
+    }
+    fail_if_nonzero_retry_on_eagain("fi_join() multicast group", CRASH_ON_FAILURE,
+                                    fi_join, dgram_ep, &mcast_sockaddr, (uint64_t)0, &mc, nullptr);
+    /* The join completes asynchronously with an event on the endpoint's EQ */
+    struct fi_eq_entry event_entry;
+    uint32_t event_type = 0;
+    while(event_type != FI_JOIN_COMPLETE) {
+        ssize_t num_read = fi_eq_sread(eq, &event_type, &event_entry, sizeof(event_entry), -1, 0);
+        if(num_read < 0 && num_read != -FI_EAGAIN) {
+            dbg_default_error("UD multicast: failed waiting for FI_JOIN_COMPLETE ({})", num_read);
+            throw rdma::configuration_failure();
+        }
+    }
+    mc_addr = fi_mc_addr(mc);
+
+    last_announce_time = last_nack_time = std::chrono::steady_clock::now();
+    post_initial_recvs();
+    poll_thread = std::thread(&ud_multicast_group::poll_loop, this);
+}
+
+ud_multicast_group::~ud_multicast_group() {
+    shutdown_poll_thread = true;
+    if(poll_thread.joinable()) {
+        poll_thread.join();
+    }
+    if(mc) fi_close(&mc->fid);
+    if(dgram_ep) fi_close(&dgram_ep->fid);
+    if(send_mr) fi_close(&send_mr->fid);
+    if(recv_mr) fi_close(&recv_mr->fid);
+    if(eq) fi_close(&eq->fid);
+    if(cq) fi_close(&cq->fid);
+    if(av) fi_close(&av->fid);
+    if(domain) fi_close(&domain->fid);
+    if(fabric) fi_close(&fabric->fid);
+    if(dgram_fi) fi_freeinfo(dgram_fi);
+}
+
+void ud_multicast_group::post_initial_recvs() {
+    const size_t slot_size = sizeof(frag_header) + frag_payload_size;
+    for(size_t index = 0; index < num_recv_buffers; ++index) {
+        fail_if_nonzero_retry_on_eagain("Post UD receive", CRASH_ON_FAILURE,
+                                        fi_recv, dgram_ep, recv_buffer.get() + index * slot_size,
+                                        slot_size, fi_mr_desc(recv_mr), FI_ADDR_UNSPEC,
+                                        (void*)(uintptr_t)index);
+    }
+}
+
+void ud_multicast_group::repost_recv(size_t buffer_index) {
+    const size_t slot_size = sizeof(frag_header) + frag_payload_size;
+    fail_if_nonzero_retry_on_eagain("Repost UD receive", REPORT_ON_FAILURE,
+                                    fi_recv, dgram_ep, recv_buffer.get() + buffer_index * slot_size,
+                                    slot_size, fi_mr_desc(recv_mr), FI_ADDR_UNSPEC,
+                                    (void*)(uintptr_t)buffer_index);
+}
+
+void ud_multicast_group::send_fragment(uint64_t seq, uint32_t frag_index,
+                                       const outgoing_message& msg) {
+    const size_t slot_size = sizeof(frag_header) + frag_payload_size;
+    char* staging = send_buffer.get() + (next_send_slot++ % ud_send_ring_size) * slot_size;
+    frag_header* header = (frag_header*)staging;
+    header->group_number = group_number;
+    header->flags = FRAG_DATA;
+    header->frag_index = frag_index;
+    header->frag_count = (msg.size + frag_payload_size - 1) / frag_payload_size;
+    header->sender_rank = member_index;
+    header->message_seq = seq;
+    header->message_size = msg.size;
+    const size_t payload_offset = (size_t)frag_index * frag_payload_size;
+    const size_t payload_bytes = std::min(frag_payload_size, msg.size - payload_offset);
+    memcpy(staging + sizeof(frag_header), msg.mr->buffer + msg.offset + payload_offset,
+           payload_bytes);
+    fail_if_nonzero_retry_on_eagain("Send UD multicast fragment", REPORT_ON_FAILURE,
+                                    fi_send, dgram_ep, staging, sizeof(frag_header) + payload_bytes,
+                                    fi_mr_desc(send_mr), mc_addr, nullptr);
+}
+
+void ud_multicast_group::send_announce() {
+    const size_t slot_size = sizeof(frag_header) + frag_payload_size;
+    char* staging = send_buffer.get() + (next_send_slot++ % ud_send_ring_size) * slot_size;
+    frag_header* header = (frag_header*)staging;
+    memset(header, 0, sizeof(frag_header));
+    header->group_number = group_number;
+    header->flags = FRAG_ANNOUNCE;
+    header->sender_rank = member_index;
+    header->message_seq = next_send_seq;
+    fail_if_nonzero_retry_on_eagain("Send UD multicast announce", REPORT_ON_FAILURE,
+                                    fi_send, dgram_ep, staging, sizeof(frag_header),
+                                    fi_mr_desc(send_mr), mc_addr, nullptr);
+}
+
+void ud_multicast_group::send_nacks() {
+    const size_t slot_size = sizeof(frag_header) + frag_payload_size;
+    auto send_one_nack = [&](uint32_t frag_index) {
+        char* staging = send_buffer.get() + (next_send_slot++ % ud_send_ring_size) * slot_size;
+        frag_header* header = (frag_header*)staging;
+        memset(header, 0, sizeof(frag_header));
+        header->group_number = group_number;
+        header->flags = FRAG_NACK;
+        header->frag_index = frag_index;
+        header->sender_rank = member_index;
+        header->message_seq = last_completed_seq + 1;
+        // NACKs go unicast to the root (rank 0 in an RDMC group)
+        fail_if_nonzero_retry_on_eagain("Send UD multicast NACK", REPORT_ON_FAILURE,
+                                        fi_send, dgram_ep, staging, sizeof(frag_header),
+                                        fi_mr_desc(send_mr), member_addrs[0], nullptr);
+    };
+    if(!current_incoming) {
+        // never saw any fragment of the expected message; ask for all of it
+        send_one_nack(ud_nack_all_frags);
+        return;
+    }
+    for(uint32_t frag = 0; frag < current_incoming->frag_count; ++frag) {
+        if(!current_incoming->received[frag]) {
+            send_one_nack(frag);
+        }
+    }
+}
+
+void ud_multicast_group::handle_datagram(char* data, size_t len, size_t buffer_index,
+                                         std::vector<std::pair<char*, size_t>>& completed) {
+    if(len < sizeof(frag_header)) {
+        repost_recv(buffer_index);
+        return;
+    }
+    frag_header header;
+    memcpy(&header, data, sizeof(header));
+    if(header.group_number != group_number || header.sender_rank == member_index) {
+        // not ours, or our own multicast looped back
+        repost_recv(buffer_index);
+        return;
+    }
+    if(header.flags == FRAG_ANNOUNCE) {
+        highest_announced_seq = std::max(highest_announced_seq, header.message_seq);
+        repost_recv(buffer_index);
+        return;
+    }
+    if(header.flags == FRAG_NACK) {
+        // retransmission request; only meaningful at the root
+        auto msg_it = retransmit_window.find(header.message_seq);
+        if(msg_it != retransmit_window.end()) {
+            if(header.frag_index == ud_nack_all_frags) {
+                const uint32_t frag_count
+                        = (msg_it->second.size + frag_payload_size - 1) / frag_payload_size;
+                for(uint32_t frag = 0; frag < frag_count; ++frag) {
+                    send_fragment(header.message_seq, frag, msg_it->second);
+                }
+            } else {
+                send_fragment(header.message_seq, header.frag_index, msg_it->second);
+            }
+        }
+        repost_recv(buffer_index);
+        return;
+    }
+    // data fragment: only the next expected message is reassembled; anything
+    // older is a duplicate and anything newer will be NACKed back into reach
+    if(header.message_seq != last_completed_seq + 1) {
+        highest_announced_seq = std::max(highest_announced_seq, header.message_seq);
+        repost_recv(buffer_index);
+        return;
+    }
+    if(!current_incoming) {
+        rdmc::receive_destination dest = incoming_message_upcall(header.message_size);
+        current_incoming = std::make_unique<incoming_message>();
+        current_incoming->dest = dest;
+        current_incoming->seq = header.message_seq;
+        current_incoming->size = header.message_size;
+        current_incoming->frag_count = header.frag_count;
+        current_incoming->frags_received = 0;
+        current_incoming->received.assign(header.frag_count, false);
+        current_incoming->last_progress = std::chrono::steady_clock::now();
+    }
+    if(header.frag_index < current_incoming->frag_count
+       && !current_incoming->received[header.frag_index]) {
+        const size_t payload_offset = (size_t)header.frag_index * frag_payload_size;
+        const size_t payload_bytes
+                = std::min(frag_payload_size, (size_t)(current_incoming->size - payload_offset));
+        memcpy(current_incoming->dest.mr->buffer + current_incoming->dest.offset + payload_offset,
+               data + sizeof(frag_header), payload_bytes);
+        current_incoming->received[header.frag_index] = true;
+        current_incoming->frags_received++;
+        current_incoming->last_progress = std::chrono::steady_clock::now();
+    }
+    repost_recv(buffer_index);
+    if(current_incoming->frags_received == current_incoming->frag_count) {
+        completed.emplace_back(current_incoming->dest.mr->buffer + current_incoming->dest.offset,
+                               current_incoming->size);
+        last_completed_seq = current_incoming->seq;
+        current_incoming.reset();
+    }
+}
+
+void ud_multicast_group::poll_loop() {
+    pthread_setname_np(pthread_self(), "ud_mcast");
+    constexpr size_t max_cq_entries = 32;
+    struct fi_cq_data_entry cq_entries[max_cq_entries];
+    std::vector<std::pair<char*, size_t>> completed;
+    while(!shutdown_poll_thread) {
+        completed.clear();
+        ssize_t num_completions = fi_cq_read(cq, cq_entries, max_cq_entries);
+        {
+            std::unique_lock<std::mutex> lock(monitor);
+            if(num_completions > 0) {
+                for(ssize_t entry = 0; entry < num_completions; ++entry) {
+                    if(!(cq_entries[entry].flags & FI_RECV)) {
+                        continue;  // send completions just recycle staging slots
+                    }
+                    const size_t buffer_index = (uintptr_t)cq_entries[entry].op_context;
+                    const size_t slot_size = sizeof(frag_header) + frag_payload_size;
+                    handle_datagram(recv_buffer.get() + buffer_index * slot_size,
+                                    cq_entries[entry].len, buffer_index, completed);
+                }
+            } else if(num_completions < 0 && num_completions != -FI_EAGAIN) {
+                struct fi_cq_err_entry err_entry;
+                memset(&err_entry, 0, sizeof(err_entry));
+                if(fi_cq_readerr(cq, &err_entry, 0) > 0 && (err_entry.flags & FI_RECV)) {
+                    repost_recv((uintptr_t)err_entry.op_context);
+                }
+            }
+            const auto now = std::chrono::steady_clock::now();
+            if(member_index == 0) {
+                // the root periodically announces its latest sequence number
+                // so receivers can detect fully-lost messages
+                if(!retransmit_window.empty() && now - last_announce_time > ud_nack_timeout) {
+                    send_announce();
+                    last_announce_time = now;
+                }
+            } else if(now - last_nack_time > ud_nack_timeout) {
+                const bool stalled_mid_message
+                        = current_incoming
+                          && now - current_incoming->last_progress > ud_nack_timeout;
+                const bool lost_whole_message
+                        = !current_incoming && highest_announced_seq > last_completed_seq;
+                if(stalled_mid_message || lost_whole_message) {
+                    send_nacks();
+                    last_nack_time = now;
+                }
+            }
+        }
+        // upcall outside the monitor so the callback can take its own locks
+        for(const auto& message : completed) {
+            completion_callback(message.first, message.second);
+        }
+    }
+}
+
+void ud_multicast_group::send_message(std::shared_ptr<rdma::memory_region> message_mr,
+                                      size_t offset, size_t length) {
+    if(length == 0 || offset + length > message_mr->size) {
+        throw rdmc::invalid_args();
+    }
+    {
+        std::unique_lock<std::mutex> lock(monitor);
+        const uint64_t seq = ++next_send_seq;
+        outgoing_message& msg = retransmit_window[seq];
+        msg.mr = message_mr;
+        msg.offset = offset;
+        msg.size = length;
+        while(retransmit_window.size() > ud_retransmit_window_size) {
+            retransmit_window.erase(retransmit_window.begin());
+        }
+        const uint32_t frag_count = (length + frag_payload_size - 1) / frag_payload_size;
+        for(uint32_t frag = 0; frag < frag_count; ++frag) {
+            send_fragment(seq, frag, msg);
+        }
+    }
+    // every fragment is posted; losses are repaired by NACK-driven
+    // retransmission from retransmit_window, so the send is complete
+    completion_callback(message_mr->buffer + offset, length);
+}
+
+#endif /* !USE_VERBS_API */
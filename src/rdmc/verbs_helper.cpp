@@ -529,6 +529,10 @@ memory_region::memory_region(size_t s, bool contiguous) : memory_region(new char
 
 memory_region::memory_region(size_t s) : memory_region(s, contiguous_memory_mode) {}
 memory_region::memory_region(char *buf, size_t s) : mr(create_mr(buf, s)), buffer(buf), size(s) {}
+// With Verbs, GPUDirect RDMA needs no special registration path: ibv_reg_mr
+// accepts a CUDA device VA when the peer-memory kernel module is loaded, and
+// fails (throwing mr_creation_failure) when it is not.
+memory_region::memory_region(char *buf, size_t s, const memory_attribute &) : memory_region(buf, s) {}
 
 uint32_t memory_region::get_rkey() const { return mr->rkey; }
 
@@ -2,6 +2,7 @@
  * @file lf.cpp
  * Implementation of RDMA interface defined in lf.h.
  */
+#include <algorithm>
 #include <arpa/inet.h>
 #include <byteswap.h>
 #include <errno.h>
@@ -15,6 +16,7 @@
 #include <stdlib.h>
 #include <string.h>
 #include <unistd.h>
+#include <vector>
 
 #include <derecho/conf/conf.hpp>
 #include <derecho/core/detail/connection_manager.hpp>
@@ -22,7 +24,9 @@
 #include <derecho/sst/detail/poll_utils.hpp>
 #include <derecho/sst/detail/sst_impl.hpp>
 #include <derecho/tcp/tcp.hpp>
+#include <derecho/utils/completion_engine.hpp>
 #include <derecho/utils/logger.hpp>
+#include <derecho/utils/numa_placement.hpp>
 
 using std::cout;
 using std::endl;
@@ -90,8 +94,9 @@ public:
 };
 #define LF_CONFIG_FILE "rdma.cfg"
 #define LF_USE_VADDR ((g_ctxt.fi->domain_attr->mr_mode) & (FI_MR_VIRT_ADDR | FI_MR_BASIC))
-static bool shutdown = false;
-std::thread polling_thread;
+// registration of our completion queue with the shared polling engine
+static derecho::CompletionEngine::source_id_t engine_source_id;
+static bool engine_registered = false;
 tcp::tcp_connections* sst_connections;
 // singleton: global states
 lf_ctxt g_ctxt;
@@ -122,7 +127,9 @@ static void default_context() {
     if(g_ctxt.cq_attr.format == FI_CQ_FORMAT_UNSPEC) {
         g_ctxt.cq_attr.format = FI_CQ_FORMAT_CONTEXT;
     }
-    g_ctxt.cq_attr.wait_obj = FI_WAIT_UNSPEC;
+    // a file descriptor wait object lets the shared completion engine block
+    // on the CQ when the whole process is idle, like the RDMC rails do
+    g_ctxt.cq_attr.wait_obj = FI_WAIT_FD;
 
     g_ctxt.pep_addr_len = max_lf_addr_size;
 }
@@ -287,11 +294,20 @@ _resources::_resources(
         char* read_addr,
         int size_w,
         int size_r,
-        int is_lf_server) {
+        int is_lf_server,
+        const std::string& memory_account)
+        : memory_account(memory_account),
+          registered_bytes((size_t)size_w + (size_t)size_r) {
     dbg_default_trace("resources constructor: this={}", (void*)this);
 
+    //Charge the budget before pinning; throws if the budget would be exceeded
+    derecho::pinned_memory::charge(memory_account, registered_bytes);
+
     // set remote id
     this->remote_id = r_id;
+    this->unsignaled_sender_ctxt.ce_idx = 0xFFFFFFFFu;
+    this->unsignaled_sender_ctxt.remote_id = 0;
+    this->unsignaled_sender_ctxt.remote_node_id = r_id;
 
     // set write and read buffer
     this->write_buf = write_addr;
@@ -347,6 +363,14 @@ _resources::~_resources() {
     if(this->read_mr)
         fail_if_nonzero_retry_on_eagain("unregister read mr", REPORT_ON_FAILURE,
                                         fi_close, &this->read_mr->fid);
+    derecho::pinned_memory::release(memory_account, registered_bytes);
+}
+
+// How many unsignaled writes may be posted before one requests a flush
+// completion anyway: a quarter of the send queue depth, so slot reclamation
+// always runs well ahead of queue exhaustion.
+static uint32_t signal_interval() {
+    return std::max<uint32_t>(1, g_ctxt.fi->tx_attr->size / 4);
 }
 
 int _resources::post_remote_send(
@@ -354,7 +378,8 @@ int _resources::post_remote_send(
         const long long int offset,
         const long long int size,
         const int op,
-        const bool completion) {
+        const bool completion,
+        const bool nonblocking) {
     // dbg_default_trace("resources::post_remote_send(),this={}",(void*)this);
     // #ifdef !NDEBUG
     // printf(YEL "resources::post_remote_send(),this=%p\n" RESET, this);
@@ -364,6 +389,20 @@ int _resources::post_remote_send(
 
     int ret = 0;
 
+    // an unsignaled post still requests a flush completion every Nth time,
+    // tagged with the sentinel context; see unsignaled_sends
+    bool flush_completion = false;
+    if(!completion
+       && unsignaled_sends.fetch_add(1, std::memory_order_relaxed) + 1 >= signal_interval()) {
+        unsignaled_sends.store(0, std::memory_order_relaxed);
+        flush_completion = true;
+    }
+    // small unsignaled transfers are injected: the provider copies the data
+    // out inline, so source-buffer ownership returns immediately (the
+    // libfabric analog of IBV_SEND_INLINE)
+    const bool inject = !completion && op != 0
+                        && static_cast<size_t>(size) <= g_ctxt.fi->tx_attr->inject_size;
+
     if(op == 2) {  // two sided send
         struct fi_msg msg;
         struct iovec msg_iov;
@@ -375,12 +414,16 @@ int _resources::post_remote_send(
         msg.desc = (void**)&this->mr_lrkey;
         msg.iov_count = 1;
         msg.addr = 0;
-        msg.context = (void*)ctxt;
+        msg.context = ctxt ? (void*)ctxt : (void*)&unsignaled_sender_ctxt;
         msg.data = 0l;  // not used
 
-        ret = fail_if_nonzero_retry_on_eagain("fi_sendmsg failed.", REPORT_ON_FAILURE,
-                                              fi_sendmsg, this->ep, &msg,
-                                              (completion) ? (FI_COMPLETION | FI_REMOTE_CQ_DATA) : (FI_REMOTE_CQ_DATA));
+        const uint64_t flags = ((completion || flush_completion) ? (FI_COMPLETION | FI_REMOTE_CQ_DATA) : (FI_REMOTE_CQ_DATA))
+                               | (inject ? FI_INJECT : 0);
+        ret = nonblocking
+                      ? fail_if_nonzero_return_on_eagain("fi_sendmsg failed.", REPORT_ON_FAILURE,
+                                                         fi_sendmsg, this->ep, &msg, flags)
+                      : fail_if_nonzero_retry_on_eagain("fi_sendmsg failed.", REPORT_ON_FAILURE,
+                                                        fi_sendmsg, this->ep, &msg, flags);
     } else {  // one sided send or receive
         struct iovec msg_iov;
         struct fi_rma_iov rma_iov;
@@ -399,7 +442,7 @@ int _resources::post_remote_send(
         msg.addr = 0;  // not used for a connection endpoint
         msg.rma_iov = &rma_iov;
         msg.rma_iov_count = 1;
-        msg.context = (void*)ctxt;
+        msg.context = ctxt ? (void*)ctxt : (void*)&unsignaled_sender_ctxt;
         msg.data = 0l;  // not used
 
         // dbg_default_trace("{}:{} calling fi_writemsg/fi_readmsg with",__FILE__,__func__);
@@ -408,11 +451,20 @@ int _resources::post_remote_send(
         // dbg_default_flush();
 
         if(op == 1) {  //write
-            ret = fail_if_nonzero_retry_on_eagain("fi_writemsg failed.", REPORT_ON_FAILURE,
-                                                  fi_writemsg, this->ep, &msg, (completion) ? FI_COMPLETION : 0);
+            const uint64_t flags = ((completion || flush_completion) ? FI_COMPLETION : 0)
+                                   | (inject ? FI_INJECT : 0);
+            ret = nonblocking
+                          ? fail_if_nonzero_return_on_eagain("fi_writemsg failed.", REPORT_ON_FAILURE,
+                                                             fi_writemsg, this->ep, &msg, flags)
+                          : fail_if_nonzero_retry_on_eagain("fi_writemsg failed.", REPORT_ON_FAILURE,
+                                                            fi_writemsg, this->ep, &msg, flags);
         } else {  // read op==0
-            ret = fail_if_nonzero_retry_on_eagain("fi_readmsg failed.", REPORT_ON_FAILURE,
-                                                  fi_readmsg, this->ep, &msg, (completion) ? FI_COMPLETION : 0);
+            const uint64_t flags = (completion || flush_completion) ? FI_COMPLETION : 0;
+            ret = nonblocking
+                          ? fail_if_nonzero_return_on_eagain("fi_readmsg failed.", REPORT_ON_FAILURE,
+                                                             fi_readmsg, this->ep, &msg, flags)
+                          : fail_if_nonzero_retry_on_eagain("fi_readmsg failed.", REPORT_ON_FAILURE,
+                                                            fi_readmsg, this->ep, &msg, flags);
         }
     }
     // dbg_default_trace("post_remote_send return with ret={}",ret);
@@ -424,6 +476,74 @@ int _resources::post_remote_send(
     return ret;
 }
 
+int _resources::post_remote_send_gather(
+        struct lf_sender_ctxt* ctxt,
+        const long long int* offsets,
+        const long long int* sizes,
+        const int seg_count,
+        const bool completion) {
+    // If the provider cannot gather this many segments in one operation,
+    // degrade to one write per segment. The completion entry (if requested)
+    // is attached to the last write so the caller still sees a single event.
+    if(static_cast<size_t>(seg_count) > g_ctxt.fi->tx_attr->iov_limit
+       || static_cast<size_t>(seg_count) > g_ctxt.fi->tx_attr->rma_iov_limit) {
+        int ret = 0;
+        for(int seg = 0; seg < seg_count; ++seg) {
+            const bool is_last = (seg == seg_count - 1);
+            ret = post_remote_send(is_last ? ctxt : NULL, offsets[seg], sizes[seg], 1,
+                                   completion && is_last);
+            if(ret != 0) {
+                return ret;
+            }
+        }
+        return ret;
+    }
+
+    // same selective-signaling and inject rules as post_remote_send
+    bool flush_completion = false;
+    if(!completion
+       && unsignaled_sends.fetch_add(1, std::memory_order_relaxed) + 1 >= signal_interval()) {
+        unsignaled_sends.store(0, std::memory_order_relaxed);
+        flush_completion = true;
+    }
+    long long int total_size = 0;
+    for(int seg = 0; seg < seg_count; ++seg) {
+        total_size += sizes[seg];
+    }
+    const bool inject = !completion
+                        && static_cast<size_t>(total_size) <= g_ctxt.fi->tx_attr->inject_size;
+
+    std::vector<struct iovec> msg_iov(seg_count);
+    std::vector<struct fi_rma_iov> rma_iov(seg_count);
+    std::vector<void*> desc(seg_count);
+    struct fi_msg_rma msg;
+
+    for(int seg = 0; seg < seg_count; ++seg) {
+        msg_iov[seg].iov_base = read_buf + offsets[seg];
+        msg_iov[seg].iov_len = sizes[seg];
+
+        rma_iov[seg].addr = ((LF_USE_VADDR) ? remote_fi_addr : 0) + offsets[seg];
+        rma_iov[seg].len = sizes[seg];
+        rma_iov[seg].key = this->mr_rwkey;
+
+        desc[seg] = (void*)this->mr_lrkey;
+    }
+
+    msg.msg_iov = msg_iov.data();
+    msg.desc = desc.data();
+    msg.iov_count = seg_count;
+    msg.addr = 0;  // not used for a connection endpoint
+    msg.rma_iov = rma_iov.data();
+    msg.rma_iov_count = seg_count;
+    msg.context = ctxt ? (void*)ctxt : (void*)&unsignaled_sender_ctxt;
+    msg.data = 0l;  // not used
+
+    return fail_if_nonzero_retry_on_eagain("fi_writemsg (gather) failed.", REPORT_ON_FAILURE,
+                                           fi_writemsg, this->ep, &msg,
+                                           ((completion || flush_completion) ? FI_COMPLETION : 0)
+                                                   | (inject ? FI_INJECT : 0));
+}
+
 void resources::post_remote_read(const long long int size) {
     int return_code = post_remote_send(NULL, 0, size, 0, false);
     if(return_code != 0) {
@@ -440,6 +560,14 @@ void resources::post_remote_read(const long long int offset, const long long int
     }
 }
 
+void resources::post_remote_read_with_completion(struct lf_sender_ctxt* ctxt, const long long int offset, const long long int size) {
+    int return_code = post_remote_send(ctxt, offset, size, 0, true);
+    if(return_code != 0) {
+        dbg_default_error("post_remote_read_with_completion() failed with return code {}", return_code);
+        std::cerr << "post_remote_read_with_completion() failed with return code " << return_code << std::endl;
+    }
+}
+
 void resources::post_remote_write(const long long int size) {
     int return_code = post_remote_send(NULL, 0, size, 1, false);
     if(return_code != 0) {
@@ -456,6 +584,29 @@ void resources::post_remote_write(const long long int offset, long long int size
     }
 }
 
+bool resources::try_post_remote_write(const long long int offset, const long long int size) {
+    int return_code = post_remote_send(NULL, offset, size, 1, false, true);
+    if(return_code == -FI_EAGAIN) {
+        return false;
+    }
+    if(return_code != 0) {
+        // a hard posting failure is reported but not treated as would-block,
+        // so callers retrying on backpressure cannot spin on a broken endpoint
+        dbg_default_error("try_post_remote_write failed with return code {}", return_code);
+        std::cerr << "try_post_remote_write failed with return code " << return_code << std::endl;
+    }
+    return true;
+}
+
+void resources::post_remote_write_gather(const long long int* offsets, const long long int* sizes,
+                                         const int seg_count) {
+    int return_code = post_remote_send_gather(NULL, offsets, sizes, seg_count, false);
+    if(return_code != 0) {
+        dbg_default_error("post_remote_write_gather failed with return code {}", return_code);
+        std::cerr << "post_remote_write_gather failed with return code " << return_code << std::endl;
+    }
+}
+
 void resources::post_remote_write_with_completion(struct lf_sender_ctxt* ctxt, const long long int size) {
     int return_code = post_remote_send(ctxt, 0, size, 1, true);
     if(return_code != 0) {
@@ -555,78 +706,32 @@ bool sync(uint32_t r_id) {
     return sst_connections->exchange(r_id, s, t);
 }
 
-void polling_loop() {
-    pthread_setname_np(pthread_self(), "sst_poll");
-    dbg_default_trace("Polling thread starting.");
-
-    struct timespec last_time, cur_time;
-    clock_gettime(CLOCK_REALTIME, &last_time);
+// Invoked with a node id whenever an error completion or TCP reset provides
+// hard evidence that the node has failed. See set_node_failure_callback().
+static std::function<void(uint32_t)> node_failure_callback;
 
-    while(!shutdown) {
-        auto ce = lf_poll_completion();
-        if(shutdown) {
-            break;
-        }
-        if(ce.first != 0xFFFFFFFF) {
-            util::polling_data.insert_completion_entry(ce.first, ce.second);
-
-            // update last time
-            clock_gettime(CLOCK_REALTIME, &last_time);
-        } else {
-            clock_gettime(CLOCK_REALTIME, &cur_time);
-            // check if the system has been inactive for enough time to induce sleep
-            double time_elapsed_in_ms = (cur_time.tv_sec - last_time.tv_sec) * 1e3
-                                        + (cur_time.tv_nsec - last_time.tv_nsec) / 1e6;
-            if(time_elapsed_in_ms > 1) {
-                using namespace std::chrono_literals;
-                std::this_thread::sleep_for(1ms);
-            }
-        }
-    }
-    dbg_default_trace("Polling thread ending.");
+void set_node_failure_callback(const std::function<void(uint32_t node_id)>& callback) {
+    node_failure_callback = callback;
 }
 
 /**
- * @details
- * This blocks until a single entry in the completion queue has
- * completed
- * It is exclusively used by the polling thread
- * the thread can sleep while in this function, when it calls util::polling_data.wait_for_requests
- * @return pair(remote_id,result) The queue pair number associated with the
- * completed request and the result (1 for successful, -1 for unsuccessful)
+ * Drains any completions currently in the completion queue and hands them
+ * to the poll_utils queues, where the threads that posted the writes wait
+ * for them. Called repeatedly from the shared completion engine, which
+ * supplies the polling thread and the idle backoff; must not block.
+ * @return The number of completion (or error) entries consumed.
  */
-std::pair<uint32_t, std::pair<int32_t, int32_t>> lf_poll_completion() {
-    struct fi_cq_entry entry;
-    int poll_result = 0;
-
-    struct timespec last_time, cur_time;
-    clock_gettime(CLOCK_REALTIME, &last_time);
-
-    while(!shutdown) {
-        clock_gettime(CLOCK_REALTIME, &cur_time);
-        // check if the system has been inactive for enough time to induce sleep
-        double time_elapsed_in_ms = (cur_time.tv_sec - last_time.tv_sec) * 1e3
-                                    + (cur_time.tv_nsec - last_time.tv_nsec) / 1e6;
-        if(time_elapsed_in_ms > 1) {
-            using namespace std::chrono_literals;
-            std::this_thread::sleep_for(1ms);
-        }
+static int drain_sst_cq() {
+    constexpr int batch_size = 64;
+    struct fi_cq_entry entries[batch_size];
 
-        poll_result = 0;
-        for(int i = 0; i < 50; ++i) {
-            poll_result = fi_cq_read(g_ctxt.cq, &entry, 1);
-            if(poll_result && (poll_result != -FI_EAGAIN)) {
-                break;
-            }
-        }
-        if(poll_result && (poll_result != -FI_EAGAIN)) {
-            break;
-        }
-        // util::polling_data.wait_for_requests();
+    int poll_result = fi_cq_read(g_ctxt.cq, entries, batch_size);
+    if(poll_result == 0 || poll_result == -FI_EAGAIN) {
+        return 0;
     }
     // not sure what to do when we cannot read entries off the CQ
     // this means that something is wrong with the local node
-    if((poll_result < 0) && (poll_result != -FI_EAGAIN)) {
+    if(poll_result < 0) {
         struct fi_cq_err_entry eentry;
         fi_cq_readerr(g_ctxt.cq, &eentry, 0);
 
@@ -671,25 +776,39 @@ std::pair<uint32_t, std::pair<int32_t, int32_t>> lf_poll_completion() {
 #endif  //DEBUG_FOR_RELEASE
         if(eentry.op_context != NULL) {
             struct lf_sender_ctxt* sctxt = (struct lf_sender_ctxt*)eentry.op_context;
-            return {sctxt->ce_idx, {sctxt->remote_id, -1}};
+            // An error completion means the provider exhausted its retries
+            // to this peer, which is hard evidence of a failure: report it
+            // immediately instead of waiting for the heartbeat timeout
+            if(node_failure_callback && sctxt->remote_node_id != 0xFFFFFFFFu) {
+                node_failure_callback(sctxt->remote_node_id);
+            }
+            // errors with the invalid ce_idx cannot be attributed to a
+            // posting thread, so nothing in poll_utils is waiting for them
+            if(sctxt->ce_idx != 0xFFFFFFFFu) {
+                util::polling_data.insert_completion_entry(sctxt->ce_idx, {sctxt->remote_id, -1});
+            }
         } else {
             dbg_default_error("\tFailed polling the completion queue");
             fprintf(stderr, "Failed polling the completion queue");
-            return {(uint32_t)0xFFFFFFFF, {0, -1}};  // we don't know who sent the message.
         }
+        return 1;
     }
-    if(!shutdown) {
-        struct lf_sender_ctxt* sctxt = (struct lf_sender_ctxt*)entry.op_context;
+    int num_consumed = 0;
+    for(int i = 0; i < poll_result; ++i) {
+        struct lf_sender_ctxt* sctxt = (struct lf_sender_ctxt*)entries[i].op_context;
         if(sctxt == NULL) {
             dbg_default_debug("WEIRD: we get an entry with op_context = NULL.");
-            return {0xFFFFFFFFu, {0, 0}};  // return a bad entry: weird!!!!
-        } else {
-            //dbg_default_trace("Normal: we get an entry with op_context = {}.",(long long unsigned)sctxt);
-            return {sctxt->ce_idx, {sctxt->remote_id, 1}};
+            continue;
         }
-    } else {  // shutdown return a bad entry
-        return {0, {0, 0}};
+        ++num_consumed;
+        // entries with the invalid ce_idx are periodic flush completions
+        // from selective signaling; they don't belong in the poll_utils queues
+        if(sctxt->ce_idx == 0xFFFFFFFFu) {
+            continue;
+        }
+        util::polling_data.insert_completion_entry(sctxt->ce_idx, {sctxt->remote_id, 1});
     }
+    return num_consumed;
 }
 
 void lf_initialize(const std::map<node_id_t, std::pair<ip_addr_t, uint16_t>>& ip_addrs_and_ports,
@@ -697,6 +816,13 @@ void lf_initialize(const std::map<node_id_t, std::pair<ip_addr_t, uint16_t>>& ip
     // initialize derecho connection manager: This is derived from Sagar's code.
     // May there be a better desgin?
     sst_connections = new tcp::tcp_connections(node_id, ip_addrs_and_ports);
+    // A reset on a member's TCP connection is the same kind of hard failure
+    // evidence as an RDMA error completion
+    sst_connections->set_failure_callback([](node_id_t failed_node) {
+        if(node_failure_callback) {
+            node_failure_callback(failed_node);
+        }
+    });
 
     // initialize global resources:
     // STEP 1: initialize with configuration.
@@ -708,6 +834,11 @@ void lf_initialize(const std::map<node_id_t, std::pair<ip_addr_t, uint16_t>>& ip
     fail_if_nonzero_retry_on_eagain("fi_getinfo()", CRASH_ON_FAILURE,
                                     fi_getinfo, LF_VERSION, nullptr, nullptr, 0, g_ctxt.hints, &(g_ctxt.fi));
     dbg_default_trace("going to use virtual address?{}", LF_USE_VADDR);
+    // the provider may negotiate the queue depths down from the configured
+    // RDMA/tx_depth and rx_depth; the negotiated tx depth drives the
+    // selective-signaling flush interval (see signal_interval)
+    dbg_default_debug("negotiated libfabric queue depths: tx {}, rx {}",
+                      g_ctxt.fi->tx_attr->size, g_ctxt.fi->rx_attr->size);
     fail_if_nonzero_retry_on_eagain("fi_fabric()", CRASH_ON_FAILURE,
                                     fi_fabric, g_ctxt.fi->fabric_attr, &(g_ctxt.fabric), nullptr);
     fail_if_nonzero_retry_on_eagain("fi_domain()", CRASH_ON_FAILURE,
@@ -731,14 +862,20 @@ void lf_initialize(const std::map<node_id_t, std::pair<ip_addr_t, uint16_t>>& ip
         crash_with_message("LibFabric error! local name is too big to fit in local buffer");
     }
 
-    // STEP 4: start polling thread.
-    polling_thread = std::thread(polling_loop);
+    // STEP 4: register our completion queue with the shared polling engine
+    int cq_wait_fd = -1;
+    if(fi_control(&g_ctxt.cq->fid, FI_GETWAIT, &cq_wait_fd) != 0) {
+        // the engine falls back to sleeping instead of fd waiting
+        cq_wait_fd = -1;
+    }
+    engine_source_id = derecho::CompletionEngine::get().register_source("sst", drain_sst_cq, cq_wait_fd);
+    engine_registered = true;
 }
 
 void shutdown_polling_thread() {
-    shutdown = true;
-    if(polling_thread.joinable()) {
-        polling_thread.join();
+    if(engine_registered) {
+        derecho::CompletionEngine::get().deregister_source(engine_source_id);
+        engine_registered = false;
     }
 }
 
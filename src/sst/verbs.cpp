@@ -93,10 +93,15 @@ static bool shutdown = false;
  * @param size_r The size of the read buffer (in bytes).
  */
 _resources::_resources(int r_index, char *write_addr, char *read_addr, int size_w,
-                       int size_r) {
+                       int size_r, const std::string &memory_account) {
     // set the remote index
     remote_index = r_index;
 
+    this->memory_account = memory_account;
+    this->registered_bytes = (size_t)size_w + (size_t)size_r;
+    // charge the budget before pinning; throws if the budget would be exceeded
+    derecho::pinned_memory::charge(memory_account, registered_bytes);
+
     write_buf = write_addr;
     if(!write_buf) {
         cout << "Write address is NULL" << endl;
@@ -170,6 +175,7 @@ _resources::~_resources() {
             cout << "Could not de-register memory region : read_mr, error code is " << rc << endl;
         }
     }
+    derecho::pinned_memory::release(memory_account, registered_bytes);
 }
 
 /**
@@ -354,7 +360,8 @@ int _resources::post_remote_send(const uint32_t id, const long long int offset,
 }
 
 resources::resources(int r_index, char *write_addr, char *read_addr, int size_w,
-                     int size_r) : _resources(r_index, write_addr, read_addr, size_w, size_r) {
+                     int size_r, const std::string &memory_account)
+        : _resources(r_index, write_addr, read_addr, size_w, size_r, memory_account) {
 }
 
 /**
@@ -377,6 +384,13 @@ void resources::post_remote_read(const uint32_t id, const long long int offset,
         cout << "Could not post RDMA read, error code is " << rc << ", remote_index is " << remote_index << endl;
     }
 }
+void resources::post_remote_read_with_completion(const uint32_t id, const long long int offset, const long long int size) {
+    int rc = post_remote_send(id, offset, size, 0, true);
+    if(rc) {
+        cout << "Could not post RDMA read with completion, error code is " << rc << ", remote_index is " << remote_index << endl;
+    }
+}
+
 /**
  * @param size The number of bytes to write from the local buffer to remote
  * memory.
@@ -416,7 +430,8 @@ void resources::post_remote_write_with_completion(const uint32_t id, const long
 }
 
 resources_two_sided::resources_two_sided(int r_index, char *write_addr, char *read_addr, int size_w,
-                                         int size_r) : _resources(r_index, write_addr, read_addr, size_w, size_r) {
+                                         int size_r, const std::string &memory_account)
+        : _resources(r_index, write_addr, read_addr, size_w, size_r, memory_account) {
 }
 
 /**
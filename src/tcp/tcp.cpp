@@ -7,6 +7,7 @@
 #include <iostream>
 #include <netdb.h>
 #include <sys/ioctl.h>
+#include <sys/sendfile.h>
 #include <sys/socket.h>
 #include <sys/epoll.h>
 #include <fcntl.h>
@@ -123,6 +124,10 @@ int socket::try_connect(string servername, int port, int timeout_ms) {
         }
     }
     if(connected) {
+        int optval = 1;
+        if(setsockopt(sock, IPPROTO_TCP, TCP_NODELAY, &optval, sizeof(optval))) {
+            fprintf(stderr, "WARNING: Failed to disable Nagle's algorithm, continue without TCP_NODELAY...\n");
+        }
         //Connection was successful, set the socket back to blocking
         epoll_ctl(epoll_fd, EPOLL_CTL_DEL, sock, NULL);
         sock_flags = fcntl(sock, F_GETFL, 0);
@@ -153,6 +158,52 @@ bool socket::read(char *buffer, size_t size) {
     return true;
 }
 
+namespace {
+/**
+ * Advances an iovec array in place to account for byte_count bytes having
+ * been transferred: fully-consumed buffers are dropped from the front of the
+ * array, and a partially-consumed buffer has its base and length adjusted.
+ */
+void consume_iovecs(struct msghdr &message, size_t byte_count) {
+    while(message.msg_iovlen > 0 && byte_count >= message.msg_iov[0].iov_len) {
+        byte_count -= message.msg_iov[0].iov_len;
+        ++message.msg_iov;
+        --message.msg_iovlen;
+    }
+    if(message.msg_iovlen > 0 && byte_count > 0) {
+        message.msg_iov[0].iov_base = static_cast<char *>(message.msg_iov[0].iov_base) + byte_count;
+        message.msg_iov[0].iov_len -= byte_count;
+    }
+}
+}  // namespace
+
+bool socket::read_scatter(struct iovec *buffers, std::size_t buffer_count) {
+    if(sock < 0) {
+        fprintf(stderr, "WARNING: Attempted to read from closed socket\n");
+        return false;
+    }
+
+    struct msghdr message;
+    memset(&message, 0, sizeof(message));
+    message.msg_iov = buffers;
+    message.msg_iovlen = buffer_count;
+    size_t total_size = 0;
+    for(size_t i = 0; i < buffer_count; ++i) {
+        total_size += buffers[i].iov_len;
+    }
+    size_t total_bytes = 0;
+    while(total_bytes < total_size) {
+        ssize_t new_bytes = recvmsg(sock, &message, 0);
+        if(new_bytes > 0) {
+            total_bytes += new_bytes;
+            consume_iovecs(message, new_bytes);
+        } else if(new_bytes == 0 || (new_bytes == -1 && errno != EINTR)) {
+            return false;
+        }
+    }
+    return true;
+}
+
 ssize_t socket::read_partial(char *buffer, size_t max_size) {
     if(sock < 0) {
         fprintf(stderr, "WARNING: Attempted to read from closed socket\n");
@@ -189,6 +240,61 @@ bool socket::write(const char *buffer, size_t size) {
     return true;
 }
 
+bool socket::write_gather(struct iovec *buffers, std::size_t buffer_count) {
+    if(sock < 0) {
+        fprintf(stderr, "WARNING: Attempted to write to closed socket\n");
+        return false;
+    }
+
+    struct msghdr message;
+    memset(&message, 0, sizeof(message));
+    message.msg_iov = buffers;
+    message.msg_iovlen = buffer_count;
+    size_t total_size = 0;
+    for(size_t i = 0; i < buffer_count; ++i) {
+        total_size += buffers[i].iov_len;
+    }
+    size_t total_bytes = 0;
+    while(total_bytes < total_size) {
+        //MSG_NOSIGNAL makes sendmsg return a proper error code if the socket has
+        //been closed by the remote, rather than crashing the program with a SIGPIPE
+        ssize_t bytes_written = sendmsg(sock, &message, MSG_NOSIGNAL);
+        if(bytes_written >= 0) {
+            total_bytes += bytes_written;
+            consume_iovecs(message, bytes_written);
+        } else if(errno != EINTR) {
+            std::cerr << "socket::write_gather: Error in the socket! Errno " << errno << std::endl;
+            return false;
+        }
+    }
+    return true;
+}
+
+bool socket::write_from_file(int fd, uint64_t offset, size_t size) {
+    if(sock < 0) {
+        fprintf(stderr, "WARNING: Attempted to write to closed socket\n");
+        return false;
+    }
+
+    off_t file_offset = offset;
+    size_t total_bytes = 0;
+    while(total_bytes < size) {
+        //sendfile advances file_offset by the number of bytes it sent
+        ssize_t bytes_written = sendfile(sock, fd, &file_offset, size - total_bytes);
+        if(bytes_written > 0) {
+            total_bytes += bytes_written;
+        } else if(bytes_written == 0) {
+            //end of file before size bytes: the requested range is invalid
+            std::cerr << "socket::write_from_file: Unexpected end of file at offset " << file_offset << std::endl;
+            return false;
+        } else if(errno != EINTR) {
+            std::cerr << "socket::write_from_file: Error in the socket! Errno " << errno << std::endl;
+            return false;
+        }
+    }
+    return true;
+}
+
 std::string socket::get_self_ip() {
     struct sockaddr_storage my_addr_info;
     socklen_t len = sizeof my_addr_info;
@@ -241,6 +347,13 @@ socket connection_listener::accept() {
     int sock = ::accept(*fd, (struct sockaddr *)&client_addr_info, &len);
     if(sock < 0) throw connection_failure();
 
+    //Disable Nagle's algorithm on accepted sockets too, so the small
+    //size-prefixed exchanges in the join protocol are not delayed
+    int optval = 1;
+    if(setsockopt(sock, IPPROTO_TCP, TCP_NODELAY, &optval, sizeof(optval))) {
+        fprintf(stderr, "WARNING: Failed to disable Nagle's algorithm, continue without TCP_NODELAY...\n");
+    }
+
     if(client_addr_info.ss_family == AF_INET) {
         // Client has an IPv4 address
         struct sockaddr_in *s = (struct sockaddr_in *)&client_addr_info;
@@ -282,6 +395,10 @@ std::optional<socket> connection_listener::try_accept(int timeout_ms) {
         client_sock = ::accept(*fd, (struct sockaddr *)&client_addr_info, &len);
         if(client_sock >= 0) {
             success = true;
+            int optval = 1;
+            if(setsockopt(client_sock, IPPROTO_TCP, TCP_NODELAY, &optval, sizeof(optval))) {
+                fprintf(stderr, "WARNING: Failed to disable Nagle's algorithm, continue without TCP_NODELAY...\n");
+            }
         }
     }
     close(epoll_fd);
@@ -0,0 +1,123 @@
+#include <derecho/utils/completion_engine.hpp>
+
+#include <chrono>
+#include <poll.h>
+#include <pthread.h>
+#include <vector>
+
+#include <derecho/conf/conf.hpp>
+#include <derecho/utils/logger.hpp>
+#include <derecho/utils/numa_placement.hpp>
+#include <derecho/utils/time.h>
+
+namespace derecho {
+
+namespace {
+/** Backoff ladder thresholds, measured from the last observed completion:
+ * spin at full speed below SPIN_NS (matching the 1ms inactivity window the
+ * old per-CQ loops used before sleeping), yield between rounds below
+ * YIELD_NS, then block on the wait fds. */
+constexpr uint64_t SPIN_NS = 1000000ull;
+constexpr uint64_t YIELD_NS = 10000000ull;
+/** Upper bound on one fd wait, so shutdown and newly registered sources
+ * are noticed promptly even if no completion ever arrives. */
+constexpr int EVENT_WAIT_TIMEOUT_MS = 50;
+}  // namespace
+
+CompletionEngine& CompletionEngine::get() {
+    static CompletionEngine engine;
+    return engine;
+}
+
+CompletionEngine::~CompletionEngine() {
+    thread_shutdown = true;
+    if(polling_thread.joinable()) {
+        polling_thread.join();
+    }
+}
+
+CompletionEngine::source_id_t CompletionEngine::register_source(
+        const std::string& name, std::function<int()> drain, int wait_fd) {
+    std::lock_guard<std::mutex> lock(sources_mutex);
+    const source_id_t id = next_source_id++;
+    dbg_default_debug("Completion engine: registering source {} ({}), wait fd {}",
+                      id, name, wait_fd);
+    sources.emplace(id, Source{name, std::move(drain), wait_fd});
+    if(!polling_thread.joinable()) {
+        thread_shutdown = false;
+        polling_thread = std::thread(&CompletionEngine::polling_loop, this);
+    }
+    return id;
+}
+
+void CompletionEngine::deregister_source(source_id_t id) {
+    std::thread thread_to_join;
+    {
+        std::lock_guard<std::mutex> lock(sources_mutex);
+        dbg_default_debug("Completion engine: deregistering source {}", id);
+        sources.erase(id);
+        if(sources.empty() && polling_thread.joinable()) {
+            thread_shutdown = true;
+            thread_to_join = std::move(polling_thread);
+        }
+    }
+    if(thread_to_join.joinable()) {
+        thread_to_join.join();
+    }
+}
+
+void CompletionEngine::polling_loop() {
+    pthread_setname_np(pthread_self(), "derecho_poll");
+    int32_t poll_cpu = getConfInt32(CONF_DERECHO_POLL_ENGINE_CPU);
+    if(poll_cpu < 0) {
+        poll_cpu = getConfInt32(CONF_DERECHO_SST_POLL_THREAD_CPU);
+    }
+    pin_to_cpu(poll_cpu);
+    dbg_default_trace("Completion engine thread starting.");
+
+    uint64_t last_completion_time = get_time();
+    while(!thread_shutdown) {
+        int completions = 0;
+        {
+            std::lock_guard<std::mutex> lock(sources_mutex);
+            for(auto& id_and_source : sources) {
+                completions += id_and_source.second.drain();
+            }
+        }
+        if(completions > 0) {
+            last_completion_time = get_time();
+            continue;
+        }
+        const uint64_t idle_ns = get_time() - last_completion_time;
+        if(idle_ns < SPIN_NS) {
+            continue;
+        }
+        if(idle_ns < YIELD_NS) {
+            std::this_thread::yield();
+            continue;
+        }
+        // fully idle: wait for a completion channel to signal, if every
+        // source has one; otherwise fall back to the old 1ms sleep
+        std::vector<pollfd> wait_fds;
+        bool all_waitable = true;
+        {
+            std::lock_guard<std::mutex> lock(sources_mutex);
+            for(const auto& id_and_source : sources) {
+                if(id_and_source.second.wait_fd < 0) {
+                    all_waitable = false;
+                    break;
+                }
+                wait_fds.push_back({id_and_source.second.wait_fd,
+                                    POLLIN | POLLERR | POLLHUP, 0});
+            }
+        }
+        if(all_waitable && !wait_fds.empty()) {
+            poll(wait_fds.data(), wait_fds.size(), EVENT_WAIT_TIMEOUT_MS);
+        } else {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+    }
+    dbg_default_trace("Completion engine thread ending.");
+}
+
+}  // namespace derecho
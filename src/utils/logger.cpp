@@ -1,4 +1,6 @@
+#include <algorithm>
 #include <atomic>
+#include <fstream>
 #include <spdlog/spdlog.h>
 #include <spdlog/async.h>
 #include <spdlog/sinks/rotating_file_sink.h>
@@ -70,3 +72,60 @@ std::shared_ptr<spdlog::logger>& LoggerFactory::getDefaultLogger() {
     _initialize();
     return _default_logger;
 }
+
+std::atomic<bool> Tracer::tracing_enabled{false};
+std::mutex Tracer::registry_mutex;
+std::vector<std::unique_ptr<Tracer::ThreadRing>> Tracer::thread_rings;
+std::vector<std::string> Tracer::event_names;
+thread_local Tracer::ThreadRing* Tracer::my_ring = nullptr;
+
+Tracer::ThreadRing* Tracer::register_thread() {
+    std::lock_guard<std::mutex> lock(registry_mutex);
+    thread_rings.emplace_back(std::make_unique<ThreadRing>());
+    thread_rings.back()->thread_rank = thread_rings.size() - 1;
+    my_ring = thread_rings.back().get();
+    return my_ring;
+}
+
+void Tracer::setEnabled(bool enable) {
+    tracing_enabled.store(enable, std::memory_order_release);
+}
+
+uint16_t Tracer::registerEvent(const std::string& event_name) {
+    std::lock_guard<std::mutex> lock(registry_mutex);
+    for(std::size_t event_id = 0; event_id < event_names.size(); ++event_id) {
+        if(event_names[event_id] == event_name) {
+            return static_cast<uint16_t>(event_id);
+        }
+    }
+    event_names.emplace_back(event_name);
+    return static_cast<uint16_t>(event_names.size() - 1);
+}
+
+void Tracer::dump(const std::string& file_name) {
+    std::lock_guard<std::mutex> lock(registry_mutex);
+    struct DumpRecord {
+        Record record;
+        uint32_t thread_rank;
+    };
+    std::vector<DumpRecord> merged_records;
+    for(const auto& ring : thread_rings) {
+        const uint64_t next_slot = ring->next_slot.load(std::memory_order_acquire);
+        const uint64_t first_slot = next_slot > ring_size ? next_slot - ring_size : 0;
+        for(uint64_t slot = first_slot; slot < next_slot; ++slot) {
+            merged_records.push_back({ring->records[slot % ring_size], ring->thread_rank});
+        }
+    }
+    std::sort(merged_records.begin(), merged_records.end(),
+              [](const DumpRecord& left, const DumpRecord& right) {
+                  return left.record.tsc < right.record.tsc;
+              });
+    std::ofstream dump_file(file_name);
+    for(const DumpRecord& entry : merged_records) {
+        dump_file << entry.record.tsc << " [thread " << entry.thread_rank << "] "
+                  << (entry.record.event_id < event_names.size()
+                              ? event_names[entry.record.event_id]
+                              : std::string("unknown_event"))
+                  << " " << entry.record.arg1 << " " << entry.record.arg2 << "\n";
+    }
+}
@@ -0,0 +1,176 @@
+#include <derecho/utils/perf_events.hpp>
+
+#include <cstring>
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+std::atomic<bool> PerfEventCounters::counting_enabled{false};
+std::array<std::atomic<uint64_t>, PerfEventCounters::NUM_REGIONS * 4> PerfEventCounters::totals{};
+
+namespace {
+
+#ifdef __linux__
+/** The hardware events in the counter group, in read order. */
+constexpr uint64_t event_configs[] = {PERF_COUNT_HW_CPU_CYCLES,
+                                      PERF_COUNT_HW_INSTRUCTIONS,
+                                      PERF_COUNT_HW_CACHE_MISSES};
+constexpr int num_events = 3;
+
+/** PERF_FORMAT_GROUP read layout for a three-event group. */
+struct group_read_format {
+    uint64_t nr;
+    uint64_t values[num_events];
+};
+
+/**
+ * The calling thread's counter group: a leader fd plus two siblings, read
+ * with one read() call. group_fd == -1 means not yet opened; opened == false
+ * after an open failure, so the thread never retries on the hot path.
+ */
+struct ThreadCounters {
+    int group_fd = -1;
+    int fds[num_events] = {-1, -1, -1};
+    bool open_failed = false;
+    bool region_active[PerfEventCounters::NUM_REGIONS] = {};
+    group_read_format region_start[PerfEventCounters::NUM_REGIONS] = {};
+
+    ~ThreadCounters() {
+        for(int i = 0; i < num_events; ++i) {
+            if(fds[i] != -1) {
+                close(fds[i]);
+            }
+        }
+    }
+
+    bool open() {
+        if(group_fd != -1) {
+            return true;
+        }
+        if(open_failed) {
+            return false;
+        }
+        /* Count kernel time too when permitted (persist spends most of its
+         * cycles in write/fsync); retry user-only if the paranoid setting
+         * forbids it. */
+        for(const bool exclude_kernel : {false, true}) {
+            for(int i = 0; i < num_events; ++i) {
+                struct perf_event_attr attr;
+                memset(&attr, 0, sizeof(attr));
+                attr.size = sizeof(attr);
+                attr.type = PERF_TYPE_HARDWARE;
+                attr.config = event_configs[i];
+                attr.read_format = PERF_FORMAT_GROUP;
+                attr.exclude_kernel = exclude_kernel;
+                attr.exclude_hv = 1;
+                fds[i] = syscall(SYS_perf_event_open, &attr, 0 /*this thread*/,
+                                 -1 /*any cpu*/, i == 0 ? -1 : fds[0], 0);
+                if(fds[i] == -1) {
+                    for(int j = 0; j < i; ++j) {
+                        close(fds[j]);
+                        fds[j] = -1;
+                    }
+                    break;
+                }
+            }
+            if(fds[num_events - 1] != -1) {
+                group_fd = fds[0];
+                ioctl(group_fd, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+                return true;
+            }
+        }
+        open_failed = true;
+        return false;
+    }
+
+    bool read_group(group_read_format& out) {
+        return read(group_fd, &out, sizeof(out)) == sizeof(out);
+    }
+};
+
+thread_local ThreadCounters thread_counters;
+#endif//__linux__
+
+}  // namespace
+
+void PerfEventCounters::setEnabled(bool enable) {
+    counting_enabled.store(enable, std::memory_order_release);
+}
+
+bool PerfEventCounters::isAvailable() {
+#ifdef __linux__
+    return !thread_counters.open_failed;
+#else
+    return false;
+#endif
+}
+
+void PerfEventCounters::begin(Region region) {
+    if(!counting_enabled.load(std::memory_order_relaxed)) {
+        return;
+    }
+#ifdef __linux__
+    if(!thread_counters.open()) {
+        return;
+    }
+    thread_counters.region_active[region]
+            = thread_counters.read_group(thread_counters.region_start[region]);
+#endif
+}
+
+void PerfEventCounters::end(Region region) {
+    if(!counting_enabled.load(std::memory_order_relaxed)) {
+        return;
+    }
+    totals[region * 4].fetch_add(1, std::memory_order_relaxed);
+#ifdef __linux__
+    if(thread_counters.group_fd == -1 || !thread_counters.region_active[region]) {
+        return;
+    }
+    thread_counters.region_active[region] = false;
+    group_read_format now;
+    if(!thread_counters.read_group(now)) {
+        return;
+    }
+    const group_read_format& start = thread_counters.region_start[region];
+    for(int i = 0; i < num_events; ++i) {
+        totals[region * 4 + 1 + i].fetch_add(now.values[i] - start.values[i],
+                                             std::memory_order_relaxed);
+    }
+#endif
+}
+
+std::array<PerfEventCounters::RegionCounts, PerfEventCounters::NUM_REGIONS>
+PerfEventCounters::getCounts() {
+    std::array<RegionCounts, NUM_REGIONS> result;
+    for(int region = 0; region < NUM_REGIONS; ++region) {
+        result[region].invocations = totals[region * 4].load(std::memory_order_relaxed);
+        result[region].cycles = totals[region * 4 + 1].load(std::memory_order_relaxed);
+        result[region].instructions = totals[region * 4 + 2].load(std::memory_order_relaxed);
+        result[region].llc_misses = totals[region * 4 + 3].load(std::memory_order_relaxed);
+    }
+    return result;
+}
+
+void PerfEventCounters::clear() {
+    for(auto& total : totals) {
+        total.store(0, std::memory_order_relaxed);
+    }
+}
+
+const char* PerfEventCounters::regionName(Region region) {
+    switch(region) {
+        case PREDICATE_ITERATION:
+            return "predicate_iteration";
+        case DELIVERY:
+            return "delivery";
+        case PERSIST:
+            return "persist";
+        default:
+            return "unknown";
+    }
+}
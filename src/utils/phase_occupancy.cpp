@@ -0,0 +1,102 @@
+#include <derecho/utils/phase_occupancy.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <pthread.h>
+#include <thread>
+
+#include <derecho/conf/conf.hpp>
+#include <derecho/utils/logger.hpp>
+
+std::array<PhaseOccupancy::ThreadSlot, PhaseOccupancy::MAX_THREADS + 1> PhaseOccupancy::slots;
+std::atomic<std::size_t> PhaseOccupancy::num_slots{0};
+std::atomic<bool> PhaseOccupancy::reporter_started{false};
+
+PhaseOccupancy::ThreadSlot& PhaseOccupancy::registerThread(const std::string& name) {
+    maybe_start_reporter();
+    const std::size_t index = num_slots.fetch_add(1, std::memory_order_relaxed);
+    ThreadSlot& slot = slots[std::min(index, MAX_THREADS)];
+    slot.name = index < MAX_THREADS ? name : "overflow";
+    slot.last_tsc = read_tsc();
+    slot.current_phase = IDLE;
+    slot.in_use.store(true, std::memory_order_release);
+    return slot;
+}
+
+std::vector<PhaseOccupancy::ThreadPhases> PhaseOccupancy::snapshot() {
+    std::vector<ThreadPhases> result;
+    const std::size_t count = std::min(num_slots.load(std::memory_order_acquire),
+                                       MAX_THREADS + 1);
+    for(std::size_t index = 0; index < count; ++index) {
+        const ThreadSlot& slot = slots[index];
+        if(!slot.in_use.load(std::memory_order_acquire)) {
+            continue;
+        }
+        ThreadPhases entry;
+        entry.thread_name = slot.name;
+        for(int phase = 0; phase < NUM_PHASES; ++phase) {
+            entry.phase_ticks[phase] = slot.phase_ticks[phase].load(std::memory_order_relaxed);
+        }
+        result.push_back(std::move(entry));
+    }
+    return result;
+}
+
+const char* PhaseOccupancy::phaseName(Phase phase) {
+    switch(phase) {
+        case IDLE:
+            return "idle";
+        case EVALUATING:
+            return "evaluating";
+        case WORKING:
+            return "working";
+        default:
+            return "unknown";
+    }
+}
+
+void PhaseOccupancy::maybe_start_reporter() {
+    if(reporter_started.exchange(true, std::memory_order_acq_rel)) {
+        return;
+    }
+    const uint32_t interval_ms = derecho::getConfUInt32(CONF_DERECHO_PHASE_LOG_INTERVAL_MS);
+    if(interval_ms == 0) {
+        return;
+    }
+    std::thread(reporter_loop, interval_ms).detach();
+}
+
+void PhaseOccupancy::reporter_loop(uint32_t interval_ms) {
+    pthread_setname_np(pthread_self(), "phase_report");
+    // previous reading per slot, so each report covers just the last interval
+    std::array<std::array<uint64_t, NUM_PHASES>, MAX_THREADS + 1> previous{};
+    while(true) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(interval_ms));
+        const std::size_t count = std::min(num_slots.load(std::memory_order_acquire),
+                                           MAX_THREADS + 1);
+        for(std::size_t index = 0; index < count; ++index) {
+            const ThreadSlot& slot = slots[index];
+            if(!slot.in_use.load(std::memory_order_acquire)) {
+                continue;
+            }
+            std::array<uint64_t, NUM_PHASES> deltas;
+            uint64_t total = 0;
+            for(int phase = 0; phase < NUM_PHASES; ++phase) {
+                const uint64_t ticks = slot.phase_ticks[phase].load(std::memory_order_relaxed);
+                deltas[phase] = ticks - previous[index][phase];
+                previous[index][phase] = ticks;
+                total += deltas[phase];
+            }
+            // a thread parked in one phase all interval accumulates nothing
+            // until its next transition; skip it rather than divide by zero
+            if(total == 0) {
+                continue;
+            }
+            dbg_default_info("phase occupancy [{}]: idle {:.1f}% evaluating {:.1f}% working {:.1f}%",
+                             slot.name,
+                             100.0 * deltas[IDLE] / total,
+                             100.0 * deltas[EVALUATING] / total,
+                             100.0 * deltas[WORKING] / total);
+        }
+    }
+}
@@ -0,0 +1,73 @@
+#include <derecho/utils/pinned_memory_budget.hpp>
+
+#include <derecho/conf/conf.hpp>
+#include <derecho/utils/logger.hpp>
+
+#include <mutex>
+#include <sstream>
+
+namespace derecho {
+namespace pinned_memory {
+
+static std::mutex accounts_mutex;
+static std::map<std::string, uint64_t> accounts;
+static uint64_t total_registered_bytes = 0;
+
+uint64_t budget() {
+    //Conf is initialized before any registration path can run
+    static const uint64_t budget_bytes
+            = getConfUInt64(CONF_RDMA_PINNED_MEMORY_BUDGET_MB) << 20;
+    return budget_bytes;
+}
+
+void charge(const std::string& account, size_t bytes) {
+    std::lock_guard<std::mutex> lock(accounts_mutex);
+    const uint64_t budget_bytes = budget();
+    if(budget_bytes > 0 && total_registered_bytes + bytes > budget_bytes) {
+        std::ostringstream message;
+        message << "Pinned-memory budget exceeded: account \"" << account
+                << "\" requested " << bytes << " bytes with "
+                << total_registered_bytes << " of " << budget_bytes
+                << " budgeted bytes already registered. Current usage:";
+        for(const auto& account_usage : accounts) {
+            message << " " << account_usage.first << "=" << account_usage.second;
+        }
+        message << ". Raise " << CONF_RDMA_PINNED_MEMORY_BUDGET_MB
+                << " or shrink the buffers of the account over budget "
+                << "(SST table size scales with group size, RDMC with "
+                << "window_size * max_payload_size, P2P with the p2p window sizes).";
+        dbg_default_error(message.str());
+        throw budget_exceeded(message.str());
+    }
+    accounts[account] += bytes;
+    total_registered_bytes += bytes;
+    dbg_default_trace("Pinned-memory account {} charged {} bytes, total now {}",
+                      account, bytes, total_registered_bytes);
+}
+
+void release(const std::string& account, size_t bytes) {
+    std::lock_guard<std::mutex> lock(accounts_mutex);
+    auto entry = accounts.find(account);
+    if(entry == accounts.end() || entry->second < bytes) {
+        dbg_default_warn("Pinned-memory account {} released {} bytes it was never charged for",
+                         account, bytes);
+        bytes = (entry == accounts.end()) ? 0 : entry->second;
+    }
+    if(entry != accounts.end()) {
+        entry->second -= bytes;
+    }
+    total_registered_bytes -= bytes;
+}
+
+uint64_t total_usage() {
+    std::lock_guard<std::mutex> lock(accounts_mutex);
+    return total_registered_bytes;
+}
+
+std::map<std::string, uint64_t> usage_by_account() {
+    std::lock_guard<std::mutex> lock(accounts_mutex);
+    return accounts;
+}
+
+}  // namespace pinned_memory
+}  // namespace derecho
@@ -0,0 +1,70 @@
+#include <derecho/utils/timeline.hpp>
+
+#include <functional>
+
+std::atomic<bool> MessageTimeline::timing_enabled{false};
+std::mutex MessageTimeline::table_mutex;
+std::array<MessageTimeline::Entry, MessageTimeline::table_size> MessageTimeline::entries;
+std::array<MessageTimeline::StageHistogram, MessageTimeline::NUM_STAGES> MessageTimeline::histograms;
+
+namespace {
+void add_to_histogram(MessageTimeline::StageHistogram& histogram, uint64_t ticks) {
+    const int bucket = ticks == 0 ? 0 : 63 - __builtin_clzll(ticks);
+    histogram.log2_buckets[bucket]++;
+    histogram.count++;
+    histogram.total_ticks += ticks;
+    if(ticks > histogram.max_ticks) {
+        histogram.max_ticks = ticks;
+    }
+}
+}  // namespace
+
+void MessageTimeline::setEnabled(bool enable) {
+    timing_enabled.store(enable, std::memory_order_release);
+}
+
+void MessageTimeline::record(uint32_t subgroup_num, int64_t message_seq, Stage stage) {
+    if(!timing_enabled.load(std::memory_order_relaxed)) {
+        return;
+    }
+    const uint64_t now = read_tsc();
+    std::lock_guard<std::mutex> lock(table_mutex);
+    const std::size_t slot = std::hash<uint64_t>()((static_cast<uint64_t>(subgroup_num) << 32)
+                                                   ^ static_cast<uint64_t>(message_seq))
+                             % table_size;
+    Entry& entry = entries[slot];
+    if(!entry.valid || entry.subgroup_num != subgroup_num || entry.message_seq != message_seq) {
+        //Claim the slot for this message, evicting any previous occupant
+        entry.valid = true;
+        entry.subgroup_num = subgroup_num;
+        entry.message_seq = message_seq;
+        entry.stamps.fill(0);
+    }
+    entry.stamps[stage] = now;
+    //Fold the interval from the most recent earlier stage into this stage's histogram
+    for(int earlier_stage = static_cast<int>(stage) - 1; earlier_stage >= 0; --earlier_stage) {
+        if(entry.stamps[earlier_stage] != 0) {
+            add_to_histogram(histograms[stage], now - entry.stamps[earlier_stage]);
+            break;
+        }
+    }
+    //The message is done after persistence; free its slot
+    if(stage == PERSIST_COMPLETE) {
+        entry.valid = false;
+    }
+}
+
+std::array<MessageTimeline::StageHistogram, MessageTimeline::NUM_STAGES> MessageTimeline::getHistograms() {
+    std::lock_guard<std::mutex> lock(table_mutex);
+    return histograms;
+}
+
+void MessageTimeline::clear() {
+    std::lock_guard<std::mutex> lock(table_mutex);
+    for(Entry& entry : entries) {
+        entry.valid = false;
+    }
+    for(StageHistogram& histogram : histograms) {
+        histogram = StageHistogram{};
+    }
+}